@@ -17,12 +17,14 @@
 #define DEBUG_SUBSYSTEM S_LNET
 #include "tracefile.h"
 
+#include <linux/crypto.h>
 #include <linux/ctype.h>
 #include <linux/fs.h>
 #include <linux/kthread.h>
 #include <linux/pagemap.h>
 #include <linux/poll.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
 #include <libcfs/linux/linux-fs.h>
 #include <libcfs/libcfs.h>
 
@@ -45,6 +47,10 @@ static long daemon_pages_max;
 
 char cfs_tracefile[TRACEFILE_NAME_SIZE];
 long long cfs_tracefile_size = CFS_TRACEFILE_SIZE;
+/* write the daemon file as LZ4 compressed blocks */
+bool cfs_tracefile_compress;
+/* compressed daemon files rotated through, each of cfs_tracefile_size */
+unsigned int cfs_tracefile_count = 1;
 
 struct task_struct *tctl_task;
 
@@ -215,9 +221,10 @@ cfs_trace_get_tage_try(struct cfs_trace_cpu_data *tcd, unsigned long len)
 		tcd->tcd_cur_pages++;
 
 		tsk = tctl_task;
-		if (tcd->tcd_cur_pages > 8 && tsk)
+		if (tcd->tcd_cur_pages > 8 && !(tcd->tcd_cur_pages & 7) && tsk)
 			/*
-			 * wake up tracefiled to process some pages.
+			 * wake up tracefiled to process some pages, only
+			 * every few pages to spare the wakeups to this CPU.
 			 */
 			wake_up_process(tsk);
 
@@ -1044,7 +1051,24 @@ int cfs_trace_daemon_command(char *str)
                 cfs_trace_stop_thread();
 		down_write(&cfs_tracefile_sem);
                 memset(cfs_tracefile, 0, sizeof(cfs_tracefile));
-
+		cfs_tracefile_compress = false;
+		cfs_tracefile_count = 1;
+
+	} else if (strncmp(str, "compress=", 9) == 0) {
+		if (strcmp(str + 9, "lz4") == 0)
+			cfs_tracefile_compress = true;
+		else if (strcmp(str + 9, "none") == 0)
+			cfs_tracefile_compress = false;
+		else
+			rc = -EINVAL;
+	} else if (strncmp(str, "files=", 6) == 0) {
+		unsigned int tmp;
+
+		rc = kstrtouint(str + 6, 10, &tmp);
+		if (!rc && (tmp < 1 || tmp > CFS_TRACEFILE_COUNT_MAX))
+			rc = -ERANGE;
+		if (!rc)
+			cfs_tracefile_count = tmp;
 	} else if (strncmp(str, "size=", 5) == 0) {
 		unsigned long tmp;
 
@@ -1062,8 +1086,13 @@ int cfs_trace_daemon_command(char *str)
         } else {
 		strcpy(cfs_tracefile, str);
 
-		pr_info("Lustre: debug daemon will attempt to start writing to %s (%lukB max)\n",
-			cfs_tracefile, (long)(cfs_tracefile_size >> 10));
+		if (cfs_tracefile_compress)
+			pr_info("Lustre: debug daemon will attempt to start writing compressed to %s (%u files of %lukB max)\n",
+				cfs_tracefile, cfs_tracefile_count,
+				(long)(cfs_tracefile_size >> 10));
+		else
+			pr_info("Lustre: debug daemon will attempt to start writing to %s (%lukB max)\n",
+				cfs_tracefile, (long)(cfs_tracefile_size >> 10));
 
 		cfs_trace_start_thread();
         }
@@ -1142,14 +1171,179 @@ int cfs_trace_get_debug_mb(void)
 		return 0;
 }
 
+/* trace pages compressed together into one block by the debug daemon */
+#define CFS_TRACE_BLK_PAGES	32
+#define CFS_TRACE_BLK_SIZE	(CFS_TRACE_BLK_PAGES * PAGE_SIZE)
+
+/* state of the debug daemon writing compressed blocks */
+struct cfs_trace_zfile {
+	struct crypto_comp	*tz_cc;
+	char			*tz_src;	/* records of the block */
+	char			*tz_dst;	/* block header and data */
+	unsigned int		 tz_index;	/* current file of the set */
+	loff_t			 tz_pos;
+	char			 tz_name[TRACEFILE_NAME_SIZE];
+};
+
+static void cfs_trace_zfile_free(struct cfs_trace_zfile *tz)
+{
+	if (!tz)
+		return;
+
+	if (tz->tz_cc)
+		crypto_free_comp(tz->tz_cc);
+	vfree(tz->tz_src);
+	vfree(tz->tz_dst);
+	kfree(tz);
+}
+
+static struct cfs_trace_zfile *cfs_trace_zfile_alloc(void)
+{
+	struct cfs_trace_zfile *tz;
+
+	BUILD_BUG_ON(CFS_TRACE_BLK_SIZE > CFS_TRACE_BLK_MAX);
+	tz = kzalloc(sizeof(*tz), GFP_KERNEL);
+	if (!tz)
+		return NULL;
+
+	tz->tz_src = vmalloc(CFS_TRACE_BLK_SIZE);
+	tz->tz_dst = vmalloc(sizeof(struct cfs_trace_blk_hdr) +
+			     CFS_TRACE_BLK_SIZE);
+	if (!tz->tz_src || !tz->tz_dst) {
+		cfs_trace_zfile_free(tz);
+		return NULL;
+	}
+
+	tz->tz_cc = crypto_alloc_comp("lz4", 0, 0);
+	if (IS_ERR(tz->tz_cc)) {
+		pr_warn("Lustre: debug daemon cannot use lz4, blocks are not compressed: rc = %ld\n",
+			PTR_ERR(tz->tz_cc));
+		tz->tz_cc = NULL;
+	}
+
+	return tz;
+}
+
+/* open the file of the set to write, moving to the next one once full */
+static struct file *cfs_trace_zfile_open(struct cfs_trace_zfile *tz)
+{
+	int flags = O_CREAT | O_WRONLY | O_LARGEFILE;
+	struct file *filp;
+	char *name;
+
+	if (strcmp(tz->tz_name, cfs_tracefile) != 0) {
+		strscpy(tz->tz_name, cfs_tracefile, sizeof(tz->tz_name));
+		tz->tz_index = 0;
+		tz->tz_pos = 0;
+	} else if (tz->tz_pos >= cfs_tracefile_size) {
+		tz->tz_index = (tz->tz_index + 1) % cfs_tracefile_count;
+		tz->tz_pos = 0;
+	}
+	/* blocks are not overwritten in place, start the file again */
+	if (tz->tz_pos == 0)
+		flags |= O_TRUNC;
+
+	if (cfs_tracefile_count > 1)
+		name = kasprintf(GFP_KERNEL, "%s.%u", tz->tz_name,
+				 tz->tz_index % cfs_tracefile_count);
+	else
+		name = kstrdup(tz->tz_name, GFP_KERNEL);
+	if (!name)
+		return ERR_PTR(-ENOMEM);
+
+	filp = filp_open(name, flags, 0600);
+	kfree(name);
+
+	return filp;
+}
+
+/* compress the records gathered in tz_src and write them as a block */
+static int cfs_trace_zfile_flush(struct cfs_trace_zfile *tz, struct file *filp,
+				 struct cfs_trace_blk_hdr *hdr)
+{
+	char *data = tz->tz_dst + sizeof(*hdr);
+	unsigned int len = CFS_TRACE_BLK_SIZE;
+	int rc;
+
+	hdr->tbh_magic = CFS_TRACE_BLK_MAGIC;
+	if (tz->tz_cc &&
+	    crypto_comp_compress(tz->tz_cc, tz->tz_src, hdr->tbh_raw_len,
+				 data, &len) == 0 && len < hdr->tbh_raw_len) {
+		hdr->tbh_flags = CFS_TRACE_BLK_LZ4;
+	} else {
+		/* incompressible, keep the records as they are */
+		memcpy(data, tz->tz_src, hdr->tbh_raw_len);
+		len = hdr->tbh_raw_len;
+		hdr->tbh_flags = 0;
+	}
+	hdr->tbh_len = len;
+	memcpy(tz->tz_dst, hdr, sizeof(*hdr));
+
+	len += sizeof(*hdr);
+	rc = cfs_kernel_write(filp, tz->tz_dst, len, &tz->tz_pos);
+	if (rc != (int)len) {
+		pr_warn("Lustre: wanted to write %u but wrote %d\n", len, rc);
+		return rc < 0 ? rc : -EIO;
+	}
+
+	return 0;
+}
+
+/* write the records of the pages collected in @pc as compressed blocks */
+static int cfs_trace_zfile_write(struct cfs_trace_zfile *tz, struct file *filp,
+				 struct page_collection *pc)
+{
+	struct cfs_trace_blk_hdr hdr = { 0 };
+	struct cfs_trace_page *tage;
+	int rc;
+
+	list_for_each_entry(tage, &pc->pc_pages, linkage) {
+		char *start;
+		char *p;
+
+		__LASSERT_TAGE_INVARIANT(tage);
+
+		if (hdr.tbh_raw_len + tage->used > CFS_TRACE_BLK_SIZE) {
+			rc = cfs_trace_zfile_flush(tz, filp, &hdr);
+			if (rc)
+				return rc;
+			memset(&hdr, 0, sizeof(hdr));
+		}
+
+		start = tz->tz_src + hdr.tbh_raw_len;
+		memcpy(start, kmap(tage->page), tage->used);
+		kunmap(tage->page);
+		hdr.tbh_raw_len += tage->used;
+
+		/* time range of the block, for readers to skip it */
+		for (p = start; p + sizeof(struct ptldebug_header) <=
+				tz->tz_src + hdr.tbh_raw_len;) {
+			struct ptldebug_header *ph = (void *)p;
+
+			if (ph->ph_len < sizeof(*ph))
+				break;
+			if (!hdr.tbh_count || ph->ph_sec < hdr.tbh_sec_min)
+				hdr.tbh_sec_min = ph->ph_sec;
+			if (ph->ph_sec > hdr.tbh_sec_max)
+				hdr.tbh_sec_max = ph->ph_sec;
+			hdr.tbh_count++;
+			p += ph->ph_len;
+		}
+	}
+
+	return hdr.tbh_raw_len ? cfs_trace_zfile_flush(tz, filp, &hdr) : 0;
+}
+
 static int tracefiled(void *arg)
 {
+	struct cfs_trace_zfile *tz = NULL;
 	struct page_collection pc;
 	struct cfs_trace_page *tage;
 	struct cfs_trace_page *tmp;
 	struct file *filp;
 	char *buf;
 	int last_loop = 0;
+	bool compress;
 	int rc;
 
 	while (!last_loop) {
@@ -1164,10 +1358,18 @@ static int tracefiled(void *arg)
 
 		filp = NULL;
 		down_read(&cfs_tracefile_sem);
+		compress = cfs_tracefile_compress;
 		if (cfs_tracefile[0] != 0) {
-			filp = filp_open(cfs_tracefile,
-					 O_CREAT | O_RDWR | O_LARGEFILE,
-					 0600);
+			if (!compress) {
+				filp = filp_open(cfs_tracefile,
+						 O_CREAT | O_RDWR | O_LARGEFILE,
+						 0600);
+			} else {
+				if (!tz)
+					tz = cfs_trace_zfile_alloc();
+				filp = tz ? cfs_trace_zfile_open(tz) :
+					    ERR_PTR(-ENOMEM);
+			}
 			if (IS_ERR(filp)) {
 				rc = PTR_ERR(filp);
 				filp = NULL;
@@ -1177,10 +1379,17 @@ static int tracefiled(void *arg)
 		}
 		up_read(&cfs_tracefile_sem);
 
+		/* compressing and writing whole batches of pages at once
+		 * keeps up with much higher rates of messages
+		 */
+		if (filp && compress &&
+		    cfs_trace_zfile_write(tz, filp, &pc) != 0)
+			put_pages_back(&pc);
+
 		list_for_each_entry_safe(tage, tmp, &pc.pc_pages, linkage) {
 			__LASSERT_TAGE_INVARIANT(tage);
 
-			if (filp) {
+			if (filp && !compress) {
 				struct dentry *de = file_dentry(filp);
 				static loff_t f_pos;
 
@@ -1246,6 +1455,7 @@ static int tracefiled(void *arg)
 		}
 		__LASSERT(list_empty(&pc.pc_pages));
 	}
+	cfs_trace_zfile_free(tz);
 
 	return 0;
 }
@@ -19,6 +19,8 @@
 #define TRACEFILE_NAME_SIZE 1024
 extern char      cfs_tracefile[TRACEFILE_NAME_SIZE];
 extern long long cfs_tracefile_size;
+extern bool cfs_tracefile_compress;
+extern unsigned int cfs_tracefile_count;
 
 /**
  * The path of debug log dump upcall script.
@@ -48,6 +50,7 @@ extern int  libcfs_panic_in_progress;
 #define TCD_MAX_PAGES (5 << (20 - PAGE_SHIFT))
 #define TCD_STOCK_PAGES (TCD_MAX_PAGES)
 #define CFS_TRACEFILE_SIZE (500 << 20)
+#define CFS_TRACEFILE_COUNT_MAX 100
 
 union cfs_trace_data_union {
 	struct cfs_trace_cpu_data {
@@ -37,6 +37,27 @@ struct ptldebug_header {
 
 #define PH_FLAG_FIRST_RECORD	1
 
+/**
+ * Header of the blocks written by the debug daemon in compressed mode.
+ * Each block holds the records of several trace pages, compressed together
+ * and followed by the next block header, so a reader can skip the blocks
+ * outside of a time range without decompressing them.
+ */
+struct cfs_trace_blk_hdr {
+	__u32 tbh_magic;	/* CFS_TRACE_BLK_MAGIC */
+	__u32 tbh_flags;	/* CFS_TRACE_BLK_* */
+	__u32 tbh_len;		/* bytes following the header */
+	__u32 tbh_raw_len;	/* bytes of records once decompressed */
+	__u32 tbh_count;	/* records in the block */
+	__u32 tbh_sec_min;	/* oldest ph_sec of the records */
+	__u32 tbh_sec_max;	/* newest ph_sec of the records */
+	__u32 tbh_padding;
+};
+
+#define CFS_TRACE_BLK_MAGIC	0x4b4c4244	/* "DBLK" */
+#define CFS_TRACE_BLK_LZ4	0x00000001	/* LZ4 compressed data */
+#define CFS_TRACE_BLK_MAX	(8U << 20)	/* largest tbh_raw_len */
+
 /* Debugging subsystems (32 bits, non-overlapping) */
 enum libcfs_debug_subsys {
 	S_UNDEFINED	= 0x00000001,
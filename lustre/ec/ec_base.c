@@ -31,7 +31,11 @@
 #include <linux/limits.h>
 #include <linux/string.h>	/* for memset */
 #include <libcfs/libcfs.h>
-#include "erasure_code.h"
+#include "ec_internal.h"
+
+static char *ec_impl_name;
+module_param_named(ec_impl, ec_impl_name, charp, 0444);
+MODULE_PARM_DESC(ec_impl, "Erasure code implementation to use (default: fastest available)");
 
 /* Global GF(256) tables */
 static const unsigned char gff_base[] = {
@@ -315,8 +319,8 @@ void gf_vect_mul_init(unsigned char c, unsigned char *tbl)
 #endif /* BITS_PER_LONG == 64 */
 }
 
-void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
-		    unsigned char **src, unsigned char **dest)
+void ec_encode_data_base(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest)
 {
 	int i, j, l;
 	unsigned char s;
@@ -331,10 +335,112 @@ void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
 		}
 	}
 }
+EXPORT_SYMBOL(ec_encode_data_base);
+
+static void ec_encode_data_update_base(int len, int k, int rows, int vec_i,
+				       unsigned char *v, unsigned char *data,
+				       unsigned char **dest)
+{
+	int i, l;
+	unsigned char s;
+
+	for (l = 0; l < rows; l++) {
+		for (i = 0; i < len; i++) {
+			s = dest[l][i];
+			s ^= gf_mul(data[i], v[vec_i * 32 + l * k * 32 + 1]);
+
+			dest[l][i] = s;
+		}
+	}
+}
+
+static bool ec_base_available(void)
+{
+	return true;
+}
+
+const struct ec_impl ec_impl_base = {
+	.ei_name		= "base",
+	.ei_available		= ec_base_available,
+	.ei_encode		= ec_encode_data_base,
+	.ei_encode_update	= ec_encode_data_update_base,
+};
+
+/* fastest first, ec_impl_base must be last */
+static const struct ec_impl *ec_impls[] = {
+#ifdef CONFIG_X86_64
+	&ec_impl_avx512,
+	&ec_impl_avx2,
+	&ec_impl_ssse3,
+#endif
+#ifdef CONFIG_ARM64
+	&ec_impl_neon,
+#endif
+	&ec_impl_base,
+};
+
+static const struct ec_impl *ec_impl_cur = &ec_impl_base;
+
+const struct ec_impl *ec_impl_get(unsigned int idx)
+{
+	if (idx >= ARRAY_SIZE(ec_impls))
+		return NULL;
+
+	return ec_impls[idx];
+}
+EXPORT_SYMBOL(ec_impl_get);
+
+const struct ec_impl *ec_impl_active(void)
+{
+	return ec_impl_cur;
+}
+EXPORT_SYMBOL(ec_impl_active);
+
+void ec_encode_data(int len, int k, int rows, unsigned char *gftbls,
+		    unsigned char **data, unsigned char **coding)
+{
+	ec_impl_cur->ei_encode(len, k, rows, gftbls, data, coding);
+}
 EXPORT_SYMBOL(ec_encode_data);
 
+void ec_encode_data_update(int len, int k, int rows, int vec_i,
+			   unsigned char *gftbls, unsigned char *data,
+			   unsigned char **coding)
+{
+	ec_impl_cur->ei_encode_update(len, k, rows, vec_i, gftbls, data,
+				      coding);
+}
+EXPORT_SYMBOL(ec_encode_data_update);
+
 static int __init ec_init(void)
 {
+	const struct ec_impl *impl;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ec_impls); i++) {
+		impl = ec_impls[i];
+		if (!impl->ei_available())
+			continue;
+
+		if (!ec_impl_name || !ec_impl_name[0]) {
+			ec_impl_cur = impl;
+			break;
+		}
+
+		if (strcmp(ec_impl_name, impl->ei_name) == 0) {
+			ec_impl_cur = impl;
+			break;
+		}
+	}
+
+	if (ec_impl_name && ec_impl_name[0] &&
+	    strcmp(ec_impl_name, ec_impl_cur->ei_name) != 0)
+		CWARN("ec: implementation '%s' is not available, using '%s'\n",
+		      ec_impl_name, ec_impl_cur->ei_name);
+	else
+		CDEBUG(D_INFO, "ec: using '%s' implementation\n",
+		       ec_impl_cur->ei_name);
+
 	return 0;
 }
 
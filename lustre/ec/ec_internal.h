@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Internal definitions shared by the erasure code implementations.
+ */
+
+#ifndef _EC_INTERNAL_H
+#define _EC_INTERNAL_H
+
+#include <linux/kernel.h>
+#include "erasure_code.h"
+
+/*
+ * Bytes processed between kernel_fpu_begin() and kernel_fpu_end() by the
+ * vectorized versions, to bound the time preemption is disabled.
+ */
+#define EC_SIMD_SEGMENT		(16 << 10)
+
+/* 32-byte table generated by gf_vect_mul_init() for each coefficient */
+#define EC_TBL_SIZE		32
+
+/*
+ * GF(2^8) multiply through the nibble tables of gf_vect_mul_init(), used for
+ * the bytes beyond the last full vector in the vectorized versions.
+ */
+static inline unsigned char ec_tbl_mul(const unsigned char *tbl,
+				       unsigned char b)
+{
+	return tbl[b & 0x0f] ^ tbl[16 + (b >> 4)];
+}
+
+static inline void ec_dot_prod_tail(int off, int len, int k,
+				    const unsigned char *tbls,
+				    unsigned char **src, unsigned char *dest)
+{
+	int i, j;
+
+	for (i = off; i < off + len; i++) {
+		unsigned char s = 0;
+
+		for (j = 0; j < k; j++)
+			s ^= ec_tbl_mul(tbls + j * EC_TBL_SIZE, src[j][i]);
+		dest[i] = s;
+	}
+}
+
+static inline void ec_mad_tail(int off, int len, const unsigned char *tbl,
+			       const unsigned char *src, unsigned char *dest)
+{
+	int i;
+
+	for (i = off; i < off + len; i++)
+		dest[i] ^= ec_tbl_mul(tbl, src[i]);
+}
+
+extern const struct ec_impl ec_impl_base;
+#ifdef CONFIG_X86_64
+extern const struct ec_impl ec_impl_ssse3;
+extern const struct ec_impl ec_impl_avx2;
+extern const struct ec_impl ec_impl_avx512;
+#endif
+#ifdef CONFIG_ARM64
+extern const struct ec_impl ec_impl_neon;
+#endif
+
+#endif /* _EC_INTERNAL_H */
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * NEON erasure code encode/update for arm64.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include <libcfs/libcfs.h>
+#include "ec_internal.h"
+#include "ec_neon.h"
+
+static bool ec_neon_available(void)
+{
+	/* Advanced SIMD is mandatory on arm64 */
+	return true;
+}
+
+static void ec_encode_neon(int len, int k, int rows, unsigned char *gftbls,
+			   unsigned char **data, unsigned char **coding)
+{
+	int vlen = len & ~15;
+	int off, seg, l;
+
+	if (!may_use_simd()) {
+		ec_impl_base.ei_encode(len, k, rows, gftbls, data, coding);
+		return;
+	}
+
+	for (off = 0; off < vlen; off += seg) {
+		seg = min(vlen - off, EC_SIMD_SEGMENT);
+		kernel_neon_begin();
+		for (l = 0; l < rows; l++)
+			ec_dot_prod_neon(off, seg, k,
+					 gftbls + l * k * EC_TBL_SIZE,
+					 data, coding[l]);
+		kernel_neon_end();
+	}
+
+	if (vlen < len)
+		for (l = 0; l < rows; l++)
+			ec_dot_prod_tail(vlen, len - vlen, k,
+					 gftbls + l * k * EC_TBL_SIZE,
+					 data, coding[l]);
+}
+
+static void ec_encode_update_neon(int len, int k, int rows, int vec_i,
+				  unsigned char *gftbls, unsigned char *data,
+				  unsigned char **coding)
+{
+	int vlen = len & ~15;
+	int off, seg, l;
+
+	if (!may_use_simd()) {
+		ec_impl_base.ei_encode_update(len, k, rows, vec_i, gftbls,
+					      data, coding);
+		return;
+	}
+
+	for (off = 0; off < vlen; off += seg) {
+		seg = min(vlen - off, EC_SIMD_SEGMENT);
+		kernel_neon_begin();
+		for (l = 0; l < rows; l++)
+			ec_mad_neon(off, seg,
+				    gftbls + (l * k + vec_i) * EC_TBL_SIZE,
+				    data, coding[l]);
+		kernel_neon_end();
+	}
+
+	if (vlen < len)
+		for (l = 0; l < rows; l++)
+			ec_mad_tail(vlen, len - vlen,
+				    gftbls + (l * k + vec_i) * EC_TBL_SIZE,
+				    data, coding[l]);
+}
+
+const struct ec_impl ec_impl_neon = {
+	.ei_name		= "neon",
+	.ei_available		= ec_neon_available,
+	.ei_encode		= ec_encode_neon,
+	.ei_encode_update	= ec_encode_update_neon,
+};
@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * NEON erasure code kernels.  They are built in ec_neon_inner.c with the
+ * compiler NEON intrinsics, which cannot include kernel headers.
+ */
+
+#ifndef _EC_NEON_H
+#define _EC_NEON_H
+
+void ec_dot_prod_neon(int off, int len, int k, const unsigned char *tbls,
+		      unsigned char **src, unsigned char *dest);
+void ec_mad_neon(int off, int len, const unsigned char *tbl,
+		 const unsigned char *src, unsigned char *dest);
+
+#endif /* _EC_NEON_H */
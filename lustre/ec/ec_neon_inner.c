@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * NEON erasure code kernels, 16 bytes per iteration.  Each byte is
+ * multiplied in GF(2^8) by looking up its low and high nibble in the
+ * gf_vect_mul_init() table with tbl and XORing the results.
+ */
+
+#include <arm_neon.h>
+#include "ec_neon.h"
+
+void ec_dot_prod_neon(int off, int len, int k, const unsigned char *tbls,
+		      unsigned char **src, unsigned char *dest)
+{
+	const uint8x16_t mask = vdupq_n_u8(0x0f);
+	int i, j;
+
+	for (i = off; i < off + len; i += 16) {
+		uint8x16_t acc = vdupq_n_u8(0);
+
+		for (j = 0; j < k; j++) {
+			uint8x16_t lo = vld1q_u8(tbls + j * 32);
+			uint8x16_t hi = vld1q_u8(tbls + j * 32 + 16);
+			uint8x16_t x = vld1q_u8(src[j] + i);
+
+			acc = veorq_u8(acc, vqtbl1q_u8(lo, vandq_u8(x, mask)));
+			acc = veorq_u8(acc, vqtbl1q_u8(hi, vshrq_n_u8(x, 4)));
+		}
+		vst1q_u8(dest + i, acc);
+	}
+}
+
+void ec_mad_neon(int off, int len, const unsigned char *tbl,
+		 const unsigned char *src, unsigned char *dest)
+{
+	const uint8x16_t mask = vdupq_n_u8(0x0f);
+	const uint8x16_t lo = vld1q_u8(tbl);
+	const uint8x16_t hi = vld1q_u8(tbl + 16);
+	int i;
+
+	for (i = off; i < off + len; i += 16) {
+		uint8x16_t x = vld1q_u8(src + i);
+		uint8x16_t acc = vld1q_u8(dest + i);
+
+		acc = veorq_u8(acc, vqtbl1q_u8(lo, vandq_u8(x, mask)));
+		acc = veorq_u8(acc, vqtbl1q_u8(hi, vshrq_n_u8(x, 4)));
+		vst1q_u8(dest + i, acc);
+	}
+}
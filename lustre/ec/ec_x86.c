@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * SSSE3, AVX2 and AVX-512 erasure code encode/update.
+ *
+ * Each byte is multiplied in GF(2^8) by looking up its low and high nibble
+ * in the two 16-byte halves of the gf_vect_mul_init() table with
+ * (v)pshufb and XORing the results, 16, 32 or 64 bytes at a time.  This is
+ * the same technique as lib/raid6/recov_ssse3.c, and like that code the
+ * vector registers are carried between asm statements inside a
+ * kernel_fpu_begin()/kernel_fpu_end() section.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <asm/simd.h>
+#include <libcfs/libcfs.h>
+#include "ec_internal.h"
+
+static const u8 ec_x0f[16] __aligned(16) = {
+	0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+	0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+};
+
+typedef void (*ec_dot_prod_t)(int off, int len, int k,
+			      const unsigned char *tbls,
+			      unsigned char **src, unsigned char *dest);
+typedef void (*ec_mad_t)(int off, int len, const unsigned char *tbl,
+			 const unsigned char *src, unsigned char *dest);
+
+/*
+ * Split the buffers into EC_SIMD_SEGMENT chunks so that preemption is not
+ * disabled for too long, run the vector kernel on the part that is a
+ * multiple of the vector \a width and finish the remainder with tables.
+ */
+static void ec_x86_encode(int len, int k, int rows, unsigned char *gftbls,
+			  unsigned char **data, unsigned char **coding,
+			  int width, ec_dot_prod_t dot_prod)
+{
+	int vlen = len & ~(width - 1);
+	int off, seg, l;
+
+	if (!may_use_simd()) {
+		ec_impl_base.ei_encode(len, k, rows, gftbls, data, coding);
+		return;
+	}
+
+	for (off = 0; off < vlen; off += seg) {
+		seg = min(vlen - off, EC_SIMD_SEGMENT);
+		kernel_fpu_begin();
+		for (l = 0; l < rows; l++)
+			dot_prod(off, seg, k, gftbls + l * k * EC_TBL_SIZE,
+				 data, coding[l]);
+		kernel_fpu_end();
+	}
+
+	if (vlen < len)
+		for (l = 0; l < rows; l++)
+			ec_dot_prod_tail(vlen, len - vlen, k,
+					 gftbls + l * k * EC_TBL_SIZE,
+					 data, coding[l]);
+}
+
+static void ec_x86_encode_update(int len, int k, int rows, int vec_i,
+				 unsigned char *gftbls, unsigned char *data,
+				 unsigned char **coding, int width, ec_mad_t mad)
+{
+	int vlen = len & ~(width - 1);
+	int off, seg, l;
+
+	if (!may_use_simd()) {
+		ec_impl_base.ei_encode_update(len, k, rows, vec_i, gftbls,
+					      data, coding);
+		return;
+	}
+
+	for (off = 0; off < vlen; off += seg) {
+		seg = min(vlen - off, EC_SIMD_SEGMENT);
+		kernel_fpu_begin();
+		for (l = 0; l < rows; l++)
+			mad(off, seg, gftbls + (l * k + vec_i) * EC_TBL_SIZE,
+			    data, coding[l]);
+		kernel_fpu_end();
+	}
+
+	if (vlen < len)
+		for (l = 0; l < rows; l++)
+			ec_mad_tail(vlen, len - vlen,
+				    gftbls + (l * k + vec_i) * EC_TBL_SIZE,
+				    data, coding[l]);
+}
+
+/* SSSE3, 16 bytes per iteration */
+static void ec_dot_prod_ssse3(int off, int len, int k,
+			      const unsigned char *tbls,
+			      unsigned char **src, unsigned char *dest)
+{
+	int i, j;
+
+	asm volatile("movdqa %0, %%xmm7" : : "m" (ec_x0f[0]));
+
+	for (i = off; i < off + len; i += 16) {
+		asm volatile("pxor %xmm0, %xmm0");
+		for (j = 0; j < k; j++) {
+			const unsigned char *tbl = tbls + j * EC_TBL_SIZE;
+
+			asm volatile("movdqu %0, %%xmm4\n\t"
+				     "movdqu %1, %%xmm5\n\t"
+				     "movdqu %2, %%xmm1\n\t"
+				     "movdqa %%xmm1, %%xmm2\n\t"
+				     "psraw $4, %%xmm2\n\t"
+				     "pand %%xmm7, %%xmm1\n\t"
+				     "pand %%xmm7, %%xmm2\n\t"
+				     "pshufb %%xmm1, %%xmm4\n\t"
+				     "pshufb %%xmm2, %%xmm5\n\t"
+				     "pxor %%xmm4, %%xmm0\n\t"
+				     "pxor %%xmm5, %%xmm0"
+				     : : "m" (tbl[0]), "m" (tbl[16]),
+				       "m" (src[j][i]));
+		}
+		asm volatile("movdqu %%xmm0, %0" : "=m" (dest[i]) : : "memory");
+	}
+}
+
+static void ec_mad_ssse3(int off, int len, const unsigned char *tbl,
+			 const unsigned char *src, unsigned char *dest)
+{
+	int i;
+
+	asm volatile("movdqa %0, %%xmm7\n\t"
+		     "movdqu %1, %%xmm4\n\t"
+		     "movdqu %2, %%xmm5"
+		     : : "m" (ec_x0f[0]), "m" (tbl[0]), "m" (tbl[16]));
+
+	for (i = off; i < off + len; i += 16)
+		asm volatile("movdqu %1, %%xmm1\n\t"
+			     "movdqu %2, %%xmm0\n\t"
+			     "movdqa %%xmm1, %%xmm2\n\t"
+			     "psraw $4, %%xmm2\n\t"
+			     "pand %%xmm7, %%xmm1\n\t"
+			     "pand %%xmm7, %%xmm2\n\t"
+			     "movdqa %%xmm4, %%xmm3\n\t"
+			     "movdqa %%xmm5, %%xmm6\n\t"
+			     "pshufb %%xmm1, %%xmm3\n\t"
+			     "pshufb %%xmm2, %%xmm6\n\t"
+			     "pxor %%xmm3, %%xmm0\n\t"
+			     "pxor %%xmm6, %%xmm0\n\t"
+			     "movdqu %%xmm0, %0"
+			     : "=m" (dest[i]) : "m" (src[i]), "m" (dest[i])
+			     : "memory");
+}
+
+static bool ec_ssse3_available(void)
+{
+	return boot_cpu_has(X86_FEATURE_SSSE3);
+}
+
+static void ec_encode_ssse3(int len, int k, int rows, unsigned char *gftbls,
+			    unsigned char **data, unsigned char **coding)
+{
+	ec_x86_encode(len, k, rows, gftbls, data, coding, 16,
+		      ec_dot_prod_ssse3);
+}
+
+static void ec_encode_update_ssse3(int len, int k, int rows, int vec_i,
+				   unsigned char *gftbls, unsigned char *data,
+				   unsigned char **coding)
+{
+	ec_x86_encode_update(len, k, rows, vec_i, gftbls, data, coding, 16,
+			     ec_mad_ssse3);
+}
+
+const struct ec_impl ec_impl_ssse3 = {
+	.ei_name		= "ssse3",
+	.ei_available		= ec_ssse3_available,
+	.ei_encode		= ec_encode_ssse3,
+	.ei_encode_update	= ec_encode_update_ssse3,
+};
+
+/*
+ * AVX2, 32 bytes per iteration.  vpshufb works within each 128-bit lane,
+ * so the 16-byte nibble tables are broadcast to both lanes.
+ */
+static void ec_dot_prod_avx2(int off, int len, int k,
+			     const unsigned char *tbls,
+			     unsigned char **src, unsigned char *dest)
+{
+	int i, j;
+
+	asm volatile("vbroadcasti128 %0, %%ymm7" : : "m" (ec_x0f[0]));
+
+	for (i = off; i < off + len; i += 32) {
+		asm volatile("vpxor %ymm0, %ymm0, %ymm0");
+		for (j = 0; j < k; j++) {
+			const unsigned char *tbl = tbls + j * EC_TBL_SIZE;
+
+			asm volatile("vbroadcasti128 %0, %%ymm4\n\t"
+				     "vbroadcasti128 %1, %%ymm5\n\t"
+				     "vmovdqu %2, %%ymm1\n\t"
+				     "vpsraw $4, %%ymm1, %%ymm2\n\t"
+				     "vpand %%ymm7, %%ymm1, %%ymm1\n\t"
+				     "vpand %%ymm7, %%ymm2, %%ymm2\n\t"
+				     "vpshufb %%ymm1, %%ymm4, %%ymm4\n\t"
+				     "vpshufb %%ymm2, %%ymm5, %%ymm5\n\t"
+				     "vpxor %%ymm4, %%ymm0, %%ymm0\n\t"
+				     "vpxor %%ymm5, %%ymm0, %%ymm0"
+				     : : "m" (tbl[0]), "m" (tbl[16]),
+				       "m" (src[j][i]));
+		}
+		asm volatile("vmovdqu %%ymm0, %0" : "=m" (dest[i]) : : "memory");
+	}
+	asm volatile("vzeroupper");
+}
+
+static void ec_mad_avx2(int off, int len, const unsigned char *tbl,
+			const unsigned char *src, unsigned char *dest)
+{
+	int i;
+
+	asm volatile("vbroadcasti128 %0, %%ymm7\n\t"
+		     "vbroadcasti128 %1, %%ymm4\n\t"
+		     "vbroadcasti128 %2, %%ymm5"
+		     : : "m" (ec_x0f[0]), "m" (tbl[0]), "m" (tbl[16]));
+
+	for (i = off; i < off + len; i += 32)
+		asm volatile("vmovdqu %1, %%ymm1\n\t"
+			     "vpsraw $4, %%ymm1, %%ymm2\n\t"
+			     "vpand %%ymm7, %%ymm1, %%ymm1\n\t"
+			     "vpand %%ymm7, %%ymm2, %%ymm2\n\t"
+			     "vpshufb %%ymm1, %%ymm4, %%ymm3\n\t"
+			     "vpshufb %%ymm2, %%ymm5, %%ymm6\n\t"
+			     "vpxor %2, %%ymm3, %%ymm0\n\t"
+			     "vpxor %%ymm6, %%ymm0, %%ymm0\n\t"
+			     "vmovdqu %%ymm0, %0"
+			     : "=m" (dest[i]) : "m" (src[i]), "m" (dest[i])
+			     : "memory");
+	asm volatile("vzeroupper");
+}
+
+static bool ec_avx2_available(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       boot_cpu_has(X86_FEATURE_AVX2);
+}
+
+static void ec_encode_avx2(int len, int k, int rows, unsigned char *gftbls,
+			   unsigned char **data, unsigned char **coding)
+{
+	ec_x86_encode(len, k, rows, gftbls, data, coding, 32,
+		      ec_dot_prod_avx2);
+}
+
+static void ec_encode_update_avx2(int len, int k, int rows, int vec_i,
+				  unsigned char *gftbls, unsigned char *data,
+				  unsigned char **coding)
+{
+	ec_x86_encode_update(len, k, rows, vec_i, gftbls, data, coding, 32,
+			     ec_mad_avx2);
+}
+
+const struct ec_impl ec_impl_avx2 = {
+	.ei_name		= "avx2",
+	.ei_available		= ec_avx2_available,
+	.ei_encode		= ec_encode_avx2,
+	.ei_encode_update	= ec_encode_update_avx2,
+};
+
+/* AVX-512BW, 64 bytes per iteration */
+static void ec_dot_prod_avx512(int off, int len, int k,
+			       const unsigned char *tbls,
+			       unsigned char **src, unsigned char *dest)
+{
+	int i, j;
+
+	asm volatile("vbroadcasti32x4 %0, %%zmm7" : : "m" (ec_x0f[0]));
+
+	for (i = off; i < off + len; i += 64) {
+		asm volatile("vpxorq %zmm0, %zmm0, %zmm0");
+		for (j = 0; j < k; j++) {
+			const unsigned char *tbl = tbls + j * EC_TBL_SIZE;
+
+			asm volatile("vbroadcasti32x4 %0, %%zmm4\n\t"
+				     "vbroadcasti32x4 %1, %%zmm5\n\t"
+				     "vmovdqu64 %2, %%zmm1\n\t"
+				     "vpsraw $4, %%zmm1, %%zmm2\n\t"
+				     "vpandq %%zmm7, %%zmm1, %%zmm1\n\t"
+				     "vpandq %%zmm7, %%zmm2, %%zmm2\n\t"
+				     "vpshufb %%zmm1, %%zmm4, %%zmm4\n\t"
+				     "vpshufb %%zmm2, %%zmm5, %%zmm5\n\t"
+				     "vpxorq %%zmm4, %%zmm0, %%zmm0\n\t"
+				     "vpxorq %%zmm5, %%zmm0, %%zmm0"
+				     : : "m" (tbl[0]), "m" (tbl[16]),
+				       "m" (src[j][i]));
+		}
+		asm volatile("vmovdqu64 %%zmm0, %0" : "=m" (dest[i]) : :
+			     "memory");
+	}
+	asm volatile("vzeroupper");
+}
+
+static void ec_mad_avx512(int off, int len, const unsigned char *tbl,
+			  const unsigned char *src, unsigned char *dest)
+{
+	int i;
+
+	asm volatile("vbroadcasti32x4 %0, %%zmm7\n\t"
+		     "vbroadcasti32x4 %1, %%zmm4\n\t"
+		     "vbroadcasti32x4 %2, %%zmm5"
+		     : : "m" (ec_x0f[0]), "m" (tbl[0]), "m" (tbl[16]));
+
+	for (i = off; i < off + len; i += 64)
+		asm volatile("vmovdqu64 %1, %%zmm1\n\t"
+			     "vpsraw $4, %%zmm1, %%zmm2\n\t"
+			     "vpandq %%zmm7, %%zmm1, %%zmm1\n\t"
+			     "vpandq %%zmm7, %%zmm2, %%zmm2\n\t"
+			     "vpshufb %%zmm1, %%zmm4, %%zmm3\n\t"
+			     "vpshufb %%zmm2, %%zmm5, %%zmm6\n\t"
+			     "vpxorq %2, %%zmm3, %%zmm0\n\t"
+			     "vpxorq %%zmm6, %%zmm0, %%zmm0\n\t"
+			     "vmovdqu64 %%zmm0, %0"
+			     : "=m" (dest[i]) : "m" (src[i]), "m" (dest[i])
+			     : "memory");
+	asm volatile("vzeroupper");
+}
+
+static bool ec_avx512_available(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX512F) &&
+	       boot_cpu_has(X86_FEATURE_AVX512BW);
+}
+
+static void ec_encode_avx512(int len, int k, int rows, unsigned char *gftbls,
+			     unsigned char **data, unsigned char **coding)
+{
+	ec_x86_encode(len, k, rows, gftbls, data, coding, 64,
+		      ec_dot_prod_avx512);
+}
+
+static void ec_encode_update_avx512(int len, int k, int rows, int vec_i,
+				    unsigned char *gftbls, unsigned char *data,
+				    unsigned char **coding)
+{
+	ec_x86_encode_update(len, k, rows, vec_i, gftbls, data, coding, 64,
+			     ec_mad_avx512);
+}
+
+const struct ec_impl ec_impl_avx512 = {
+	.ei_name		= "avx512",
+	.ei_available		= ec_avx512_available,
+	.ei_encode		= ec_encode_avx512,
+	.ei_encode_update	= ec_encode_update_avx512,
+};
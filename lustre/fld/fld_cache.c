@@ -21,6 +21,8 @@
 #include <libcfs/libcfs.h>
 #include <linux/module.h>
 #include <linux/math64.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
 #include <obd_support.h>
 #include <lustre_fld.h>
 #include "fld_internal.h"
@@ -42,40 +44,124 @@ struct fld_cache *fld_cache_init(const char *name, int cache_size,
 	if (cache == NULL)
 		RETURN(ERR_PTR(-ENOMEM));
 
+	cache->fci_stat = alloc_percpu(struct fld_stats);
+	if (cache->fci_stat == NULL) {
+		OBD_FREE_PTR(cache);
+		RETURN(ERR_PTR(-ENOMEM));
+	}
+
 	INIT_LIST_HEAD(&cache->fci_entries_head);
 	INIT_LIST_HEAD(&cache->fci_lru);
 
 	cache->fci_cache_count = 0;
-	rwlock_init(&cache->fci_lock);
+	mutex_init(&cache->fci_mutex);
+	RCU_INIT_POINTER(cache->fci_array, NULL);
 
 	strscpy(cache->fci_name, name, sizeof(cache->fci_name));
 
 	cache->fci_cache_size = cache_size;
 	cache->fci_threshold = cache_threshold;
 
-	/* Init fld cache info. */
-	memset(&cache->fci_stat, 0, sizeof(cache->fci_stat));
-
 	CDEBUG(D_INFO, "%s: FLD cache - Size: %d, Threshold: %d\n",
 	       cache->fci_name, cache_size, cache_threshold);
 
 	RETURN(cache);
 }
+EXPORT_SYMBOL(fld_cache_init);
 
 /**
  * destroy fld cache.
  */
 void fld_cache_fini(struct fld_cache *cache)
 {
+	struct fld_stats stat = { 0 };
+	int cpu;
+
 	LASSERT(cache != NULL);
 	fld_cache_flush(cache);
+	/* the flush published an empty cache, nothing left to look up */
+	LASSERT(rcu_access_pointer(cache->fci_array) == NULL);
+
+	for_each_possible_cpu(cpu) {
+		stat.fst_cache += per_cpu_ptr(cache->fci_stat, cpu)->fst_cache;
+		stat.fst_count += per_cpu_ptr(cache->fci_stat, cpu)->fst_count;
+	}
+	free_percpu(cache->fci_stat);
 
 	CDEBUG(D_INFO, "FLD cache statistics (%s):\n", cache->fci_name);
-	CDEBUG(D_INFO, "  Cache reqs: %llu\n", cache->fci_stat.fst_cache);
-	CDEBUG(D_INFO, "  Total reqs: %llu\n", cache->fci_stat.fst_count);
+	CDEBUG(D_INFO, "  Cache reqs: %llu\n", stat.fst_cache);
+	CDEBUG(D_INFO, "  Total reqs: %llu\n", stat.fst_count);
 
 	OBD_FREE_PTR(cache);
 }
+EXPORT_SYMBOL(fld_cache_fini);
+
+static inline size_t fld_cache_array_size(int count)
+{
+	return offsetof(struct fld_cache_array, fca_ranges[count]);
+}
+
+static void fld_cache_array_free(struct rcu_head *head)
+{
+	struct fld_cache_array *array;
+
+	array = container_of(head, struct fld_cache_array, fca_rcu);
+	OBD_FREE_LARGE(array, fld_cache_array_size(array->fca_count));
+}
+
+/**
+ * Publish the sorted entries as a new array for fld_cache_lookup(), and
+ * free the previous one once the lookups using it are done.
+ */
+static void fld_cache_array_update(struct fld_cache *cache)
+{
+	struct fld_cache_array *array = NULL;
+	struct fld_cache_array *old;
+	struct fld_cache_entry *flde;
+	int i = 0;
+
+	if (cache->fci_cache_count > 0) {
+		OBD_ALLOC_LARGE(array,
+				fld_cache_array_size(cache->fci_cache_count));
+		/*
+		 * If there is no memory for the array, publish an empty
+		 * cache rather than keeping stale ranges. Lookups will miss
+		 * and ask the FLD server until the next update.
+		 */
+		if (array != NULL) {
+			list_for_each_entry(flde, &cache->fci_entries_head,
+					    fce_list)
+				array->fca_ranges[i++] = flde->fce_range;
+			LASSERT(i == cache->fci_cache_count);
+			array->fca_count = i;
+		}
+	}
+
+	old = rcu_dereference_protected(cache->fci_array,
+					lockdep_is_held(&cache->fci_mutex));
+	rcu_assign_pointer(cache->fci_array, array);
+	if (old != NULL)
+		call_rcu(&old->fca_rcu, fld_cache_array_free);
+}
+
+/**
+ * Take the fld cache update lock, for the callers of the *_nolock()
+ * functions.
+ */
+void fld_cache_lock(struct fld_cache *cache)
+{
+	mutex_lock(&cache->fci_mutex);
+}
+
+/**
+ * Publish the changes made to the cache entries since fld_cache_lock(),
+ * and release the update lock.
+ */
+void fld_cache_unlock(struct fld_cache *cache)
+{
+	fld_cache_array_update(cache);
+	mutex_unlock(&cache->fci_mutex);
+}
 
 /**
  * delete given node from list.
@@ -211,10 +297,10 @@ void fld_cache_flush(struct fld_cache *cache)
 {
 	ENTRY;
 
-	write_lock(&cache->fci_lock);
+	fld_cache_lock(cache);
 	cache->fci_cache_size = 0;
 	fld_cache_shrink(cache);
-	write_unlock(&cache->fci_lock);
+	fld_cache_unlock(cache);
 
 	EXIT;
 }
@@ -234,7 +320,7 @@ static void fld_cache_punch_hole(struct fld_cache *cache,
 	struct fld_cache_entry *fldt;
 
 	ENTRY;
-	OBD_ALLOC_GFP(fldt, sizeof(*fldt), GFP_ATOMIC);
+	OBD_ALLOC_PTR(fldt);
 	if (!fldt) {
 		OBD_FREE_PTR(f_new);
 		EXIT;
@@ -407,14 +493,72 @@ int fld_cache_insert(struct fld_cache *cache,
 	if (IS_ERR(flde))
 		RETURN(PTR_ERR(flde));
 
-	write_lock(&cache->fci_lock);
+	fld_cache_lock(cache);
 	rc = fld_cache_insert_nolock(cache, flde);
-	write_unlock(&cache->fci_lock);
+	fld_cache_unlock(cache);
 	if (rc)
 		OBD_FREE_PTR(flde);
 
 	RETURN(rc);
 }
+EXPORT_SYMBOL(fld_cache_insert);
+
+/**
+ * Insert \a count ranges sorted by start in FLD cache, and publish them
+ * once.
+ *
+ * The ranges loaded from the FLDB do not overlap, so each one is merged
+ * into or appended after the last entry, without walking the list. Ranges
+ * that do not fit at the end go through fld_cache_insert_nolock().
+ */
+int fld_cache_insert_sorted(struct fld_cache *cache,
+			    const struct lu_seq_range *ranges, int count)
+{
+	struct list_head *head = &cache->fci_entries_head;
+	struct fld_cache_entry *f_last;
+	struct fld_cache_entry *f_new;
+	int rc = 0;
+	int i;
+
+	ENTRY;
+
+	fld_cache_lock(cache);
+	for (i = 0; i < count; i++) {
+		const struct lu_seq_range *range = &ranges[i];
+
+		LASSERT(i == 0 || ranges[i - 1].lsr_start <= range->lsr_start);
+
+		fld_cache_shrink(cache);
+		f_last = list_empty(head) ? NULL :
+			 list_last_entry(head, struct fld_cache_entry,
+					 fce_list);
+
+		if (f_last != NULL &&
+		    f_last->fce_range.lsr_end == range->lsr_start &&
+		    f_last->fce_range.lsr_index == range->lsr_index &&
+		    f_last->fce_range.lsr_flags == range->lsr_flags) {
+			f_last->fce_range.lsr_end = range->lsr_end;
+			continue;
+		}
+
+		f_new = fld_cache_entry_create(range);
+		if (IS_ERR(f_new))
+			GOTO(out_unlock, rc = PTR_ERR(f_new));
+
+		if (f_last == NULL ||
+		    f_last->fce_range.lsr_end <= range->lsr_start) {
+			list_add_tail(&f_new->fce_list, head);
+			list_add(&f_new->fce_lru, &cache->fci_lru);
+			cache->fci_cache_count++;
+		} else {
+			fld_cache_insert_nolock(cache, f_new);
+		}
+	}
+out_unlock:
+	fld_cache_unlock(cache);
+
+	RETURN(rc);
+}
 
 void fld_cache_delete_nolock(struct fld_cache *cache,
 		      const struct lu_seq_range *range)
@@ -437,36 +581,50 @@ void fld_cache_delete_nolock(struct fld_cache *cache,
 
 /**
  * lookup \a seq sequence for range in fld cache.
+ *
+ * This takes no lock, so it scales with the number of CPUs looking up
+ * FIDs. The cached ranges do not overlap, so the range holding \a seq
+ * can only be the last one starting at or before it.
+ *
+ * \retval 0		found, \a range is the matched range
+ * \retval -ENOENT	not found, \a range is the left-side range if any
  */
 int fld_cache_lookup(struct fld_cache *cache,
 		     const u64 seq, struct lu_seq_range *range)
 {
-	struct fld_cache_entry *flde;
-	struct fld_cache_entry *prev = NULL;
-	struct list_head *head;
+	const struct fld_cache_array *array;
+	int start = 0;
+	int end;
+	int mid;
+	int rc = -ENOENT;
 
 	ENTRY;
 
-	read_lock(&cache->fci_lock);
-	head = &cache->fci_entries_head;
+	this_cpu_inc(cache->fci_stat->fst_count);
 
-	cache->fci_stat.fst_count++;
-	list_for_each_entry(flde, head, fce_list) {
-		if (flde->fce_range.lsr_start > seq) {
-			if (prev != NULL)
-				*range = prev->fce_range;
-			break;
-		}
+	rcu_read_lock();
+	array = rcu_dereference(cache->fci_array);
+	if (array == NULL)
+		GOTO(out_unlock, rc);
 
-		prev = flde;
-		if (lu_seq_range_within(&flde->fce_range, seq)) {
-			*range = flde->fce_range;
+	end = array->fca_count;
+	while (start < end) {
+		mid = start + (end - start) / 2;
+		if (array->fca_ranges[mid].lsr_start <= seq)
+			start = mid + 1;
+		else
+			end = mid;
+	}
 
-			cache->fci_stat.fst_cache++;
-			read_unlock(&cache->fci_lock);
-			RETURN(0);
+	if (start > 0) {
+		*range = array->fca_ranges[start - 1];
+		if (lu_seq_range_within(range, seq)) {
+			this_cpu_inc(cache->fci_stat->fst_cache);
+			rc = 0;
 		}
 	}
-	read_unlock(&cache->fci_lock);
-	RETURN(-ENOENT);
+out_unlock:
+	rcu_read_unlock();
+	RETURN(rc);
 }
+EXPORT_SYMBOL(fld_cache_lookup);
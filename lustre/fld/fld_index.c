@@ -18,6 +18,7 @@
 
 #include <libcfs/libcfs.h>
 #include <linux/module.h>
+#include <linux/sort.h>
 #include <obd_support.h>
 #include <dt_object.h>
 #include <lustre_fid.h>
@@ -184,11 +185,11 @@ int fld_index_create(const struct lu_env *env, struct lu_server_fld *fld,
 	if (IS_ERR(flde))
 		GOTO(out, rc = PTR_ERR(flde));
 
-	write_lock(&fld->lsf_cache->fci_lock);
+	fld_cache_lock(fld->lsf_cache);
 	if (deleted)
 		fld_cache_delete_nolock(fld->lsf_cache, new_range);
 	rc = fld_cache_insert_nolock(fld->lsf_cache, flde);
-	write_unlock(&fld->lsf_cache->fci_lock);
+	fld_cache_unlock(fld->lsf_cache);
 	if (rc)
 		OBD_FREE_PTR(flde);
 out:
@@ -303,6 +304,36 @@ static int fld_insert_special_entries(const struct lu_env *env,
 	RETURN(rc);
 }
 
+static int fld_range_cmp(const void *a, const void *b)
+{
+	const struct lu_seq_range *r1 = a;
+	const struct lu_seq_range *r2 = b;
+
+	if (r1->lsr_start < r2->lsr_start)
+		return -1;
+	return r1->lsr_start > r2->lsr_start;
+}
+
+/* double the size of the array the FLDB ranges are loaded in */
+static int fld_ranges_grow(struct lu_seq_range **ranges, int *size)
+{
+	struct lu_seq_range *tmp;
+	int new_size = *size ? *size * 2 : 64;
+
+	OBD_ALLOC_LARGE(tmp, new_size * sizeof(*tmp));
+	if (tmp == NULL)
+		return -ENOMEM;
+
+	if (*ranges != NULL) {
+		memcpy(tmp, *ranges, *size * sizeof(*tmp));
+		OBD_FREE_LARGE(*ranges, *size * sizeof(*tmp));
+	}
+	*ranges = tmp;
+	*size = new_size;
+
+	return 0;
+}
+
 int fld_index_init(const struct lu_env *env, struct lu_server_fld *fld,
 		   struct dt_device *dt, int type)
 {
@@ -316,6 +347,8 @@ int fld_index_init(const struct lu_env *env, struct lu_server_fld *fld,
 	const struct dt_it_ops *iops;
 	int rc;
 	u32 index;
+	struct lu_seq_range *ranges = NULL;
+	int ranges_size = 0;
 	int range_count = 0;
 
 	ENTRY;
@@ -391,11 +424,12 @@ int fld_index_init(const struct lu_env *env, struct lu_server_fld *fld,
 		 * zeroed-out key and record. Ignore it here.
 		 */
 		if (range->lsr_start < range->lsr_end) {
-			rc = fld_cache_insert(fld->lsf_cache, range);
-			if (rc != 0)
-				GOTO(out_it_put, rc);
-
-			range_count++;
+			if (range_count == ranges_size) {
+				rc = fld_ranges_grow(&ranges, &ranges_size);
+				if (rc != 0)
+					GOTO(out_it_put, rc);
+			}
+			ranges[range_count++] = *range;
 		}
 
 		rc = iops->next(env, it);
@@ -403,8 +437,21 @@ int fld_index_init(const struct lu_env *env, struct lu_server_fld *fld,
 			GOTO(out_it_fini, rc);
 	}
 
-	if (range_count == 0)
+	/*
+	 * Inserting the entries one by one would publish a new lookup array
+	 * each time. Sort them, so the cache is built by appending to it,
+	 * and publish it once.
+	 */
+	if (range_count > 0) {
+		sort(ranges, range_count, sizeof(*ranges), fld_range_cmp,
+		     NULL);
+		rc = fld_cache_insert_sorted(fld->lsf_cache, ranges,
+					     range_count);
+		if (rc != 0)
+			GOTO(out_it_put, rc);
+	} else {
 		fld->lsf_new = 1;
+	}
 
 	rc = fld_name_to_index(fld->lsf_name, &index);
 	if (rc < 0)
@@ -432,6 +479,8 @@ out_it_fini:
 	iops->fini(env, it);
 out:
 	OBD_FREE_PTR(attr);
+	if (ranges != NULL)
+		OBD_FREE_LARGE(ranges, ranges_size * sizeof(*ranges));
 
 	if (rc < 0) {
 		if (dt_obj)
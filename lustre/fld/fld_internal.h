@@ -59,9 +59,20 @@ struct fld_cache_entry {
 	struct lu_seq_range	fce_range;
 };
 
+/*
+ * Copy of the sorted fld cache entries for lookups. It is never modified
+ * once published, each update of the cache publishes a new one and frees
+ * the old one after a RCU grace period.
+ */
+struct fld_cache_array {
+	struct rcu_head		fca_rcu;
+	int			fca_count;
+	struct lu_seq_range	fca_ranges[];
+};
+
 struct fld_cache {
-	/* Cache guard, protects fci_hash as immutable after init is finished */
-	rwlock_t		fci_lock;
+	/* Serialize the updates of the cache entries and lists */
+	struct mutex		fci_mutex;
 
 	/* Cache shrink threshold */
 	int			fci_threshold;
@@ -69,7 +80,7 @@ struct fld_cache {
 	/* Prefered number of cached entries */
 	int			fci_cache_size;
 
-	/* Current number of cached entries. Protected by \a fci_lock */
+	/* Current number of cached entries. Protected by \a fci_mutex */
 	int			fci_cache_count;
 
 	/* LRU list fld entries. */
@@ -78,8 +89,11 @@ struct fld_cache {
 	/* sorted fld entries. */
 	struct list_head	fci_entries_head;
 
-	/* Cache statistics. */
-	struct fld_stats	fci_stat;
+	/* sorted ranges for lockless lookup, NULL if the cache is empty */
+	struct fld_cache_array __rcu *fci_array;
+
+	/* Cache statistics, per CPU not to share a cache line on lookup. */
+	struct fld_stats __percpu *fci_stat;
 
 	/* Cache name used for debug and messages. */
 	char			fci_name[LUSTRE_MDT_MAXNAMELEN];
@@ -157,9 +171,14 @@ void fld_cache_flush(struct fld_cache *cache);
 int fld_cache_insert(struct fld_cache *cache,
 		     const struct lu_seq_range *range);
 
+int fld_cache_insert_sorted(struct fld_cache *cache,
+			    const struct lu_seq_range *ranges, int count);
+
 struct fld_cache_entry
 *fld_cache_entry_create(const struct lu_seq_range *range);
 
+void fld_cache_lock(struct fld_cache *cache);
+void fld_cache_unlock(struct fld_cache *cache);
 int fld_cache_insert_nolock(struct fld_cache *cache,
 			    struct fld_cache_entry *f_new);
 void fld_cache_delete_nolock(struct fld_cache *cache,
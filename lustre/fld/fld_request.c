@@ -519,6 +519,8 @@ static void __exit fld_exit(void)
 #endif /* HAVE_SERVER_SUPPORT */
 
 	debugfs_remove_recursive(fld_debugfs_dir);
+	/* wait for the FLD cache arrays freed by call_rcu() */
+	rcu_barrier();
 }
 
 MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
@@ -281,6 +281,10 @@ struct cl_layout {
 	bool		cl_is_released;
 	/** Whether layout is a readonly one */
 	bool		cl_is_rdonly;
+	/** log2 of the largest compression chunk size, 0 if none */
+	unsigned int	cl_compr_chunk_bits;
+	/** Whether layout has erasure coded components */
+	bool		cl_is_ec;
 };
 
 enum coo_inode_opc {
@@ -1939,7 +1943,12 @@ struct cl_io {
 	 */
 			     ci_invalidate_page_cache:1,
 	/* was this IO switched from BIO to DIO for hybrid IO? */
-			     ci_hybrid_switched:1;
+			     ci_hybrid_switched:1,
+	/**
+	 * Designated IO to an erasure coding parity mirror, whose objects
+	 * can extend past EOF. Set by the LOV.
+	 */
+			     ci_parity:1;
 
 	/**
 	 * How many times the read has retried before this one.
@@ -1950,6 +1959,11 @@ struct cl_io {
 	 * Designated mirror index for this I/O.
 	 */
 	unsigned int	     ci_designated_mirror;
+	/**
+	 * log2 of the largest compression chunk size of the components
+	 * accessed by this IO, 0 if none is compressed. Set by the LOV.
+	 */
+	unsigned int	     ci_compr_chunk_bits;
 	/**
 	 * Number of pages owned by this IO. For invariant checking.
 	 */
@@ -65,6 +65,8 @@ struct dt_device_param {
 	/* T10PI checksum type, zero if not supported */
 	enum cksum_types ddp_t10_cksum_type;
 	bool		 ddp_has_lseek_data_hole;
+	/* object size of compressed chunk writes is taken from the client */
+	bool		 ddp_has_compression;
 };
 
 /*
@@ -107,6 +107,95 @@ void ec_init_tables(int k, int rows, unsigned char *a, unsigned char *gftbls);
 void ec_encode_data(int len, int k, int rows, unsigned char *gftbls,
 		    unsigned char **data, unsigned char **coding);
 
+/**
+ * @brief Apply the contribution of one source block to existing parity.
+ *
+ * Multiply source block number vec_i of k by its coefficients and add the
+ * result into each of the rows coding buffers, so parity can be updated from
+ * a single data block without reading the rest of the stripe.  Passing the
+ * XOR of the old and new contents of a data block as \a data turns parity of
+ * the old data into parity of the new data, since addition in GF(2^8) is XOR.
+ *
+ * This function determines what instruction sets are enabled and
+ * selects the appropriate version at runtime.
+ *
+ * @param len    Length of each block of data (vector) of source or dest data.
+ * @param k      The number of vector sources or rows in the generator matrix
+ *		 for coding.
+ * @param rows   The number of output vectors to concurrently encode/decode.
+ * @param vec_i  The vector index corresponding to the single input source.
+ * @param gftbls Pointer to array of input tables generated from coding
+ *		  coefficients in ec_init_tables(). Must be of size 32*k*rows
+ * @param data   Pointer to single input source used to update output parity.
+ * @param coding Array of pointers to coded output buffers.
+ * @returns none
+ */
+void ec_encode_data_update(int len, int k, int rows, int vec_i,
+			   unsigned char *gftbls, unsigned char *data,
+			   unsigned char **coding);
+
+/**
+ * @brief Generate or decode erasure codes on blocks of data.
+ *
+ * Baseline version of ec_encode_data() using only GF(2^8) log table lookups.
+ * It is the reference against which the vectorized versions are verified.
+ *
+ * @param len    Length of each block of data (vector) of source or dest data.
+ * @param srcs   The number of vector sources or rows in the generator matrix
+ *		 for coding.
+ * @param dests  The number of output vectors to concurrently encode/decode.
+ * @param v      Pointer to array of input tables generated from coding
+ *		 coefficients in ec_init_tables(). Must be of size 32*k*rows
+ * @param src    Array of pointers to source input buffers.
+ * @param dest   Array of pointers to coded output buffers.
+ * @returns none
+ */
+void ec_encode_data_base(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest);
+
+/**
+ * @brief Erasure code implementation for one instruction set.
+ *
+ * The ec module selects the fastest implementation usable on the running
+ * CPU at load time (or the one named by the "ec_impl" module parameter).
+ */
+struct ec_impl {
+	/** short name, e.g. "avx2" */
+	const char	*ei_name;
+	/** whether the running CPU supports this implementation */
+	bool		(*ei_available)(void);
+	/** same semantics as ec_encode_data() */
+	void		(*ei_encode)(int len, int k, int rows,
+				     unsigned char *gftbls,
+				     unsigned char **data,
+				     unsigned char **coding);
+	/**
+	 * Multiply source \a data (source number \a vec_i of \a k) by its
+	 * coefficients and add the result into each of the \a rows \a coding
+	 * buffers.
+	 */
+	void		(*ei_encode_update)(int len, int k, int rows,
+					    int vec_i, unsigned char *gftbls,
+					    unsigned char *data,
+					    unsigned char **coding);
+};
+
+/**
+ * @brief Get an erasure code implementation by index.
+ *
+ * Implementations are ordered fastest first and the last one is always the
+ * baseline version, so callers can iterate until NULL is returned.
+ *
+ * @param idx    Index of the implementation.
+ * @returns      implementation, or NULL if \a idx is out of range
+ */
+const struct ec_impl *ec_impl_get(unsigned int idx);
+
+/**
+ * @brief Get the implementation used by ec_encode_data().
+ */
+const struct ec_impl *ec_impl_active(void);
+
 /**
  * @brief Generate a Cauchy matrix of coefficients to be used for encoding.
  *
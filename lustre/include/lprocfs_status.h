@@ -432,6 +432,7 @@ enum ojb_info_flags {
 typedef void (*cntr_init_callback)(struct lprocfs_stats *stats,
 				   unsigned int offset,
 				   enum lprocfs_counter_config cntr_umask);
+struct job_stat_cache;
 struct obd_job_stats {
 	struct rb_root		ojs_idtree;	/* root sorted on js_jobid */
 	struct rb_root		ojs_postree;	/* unique id (temporal) root */
@@ -447,6 +448,9 @@ struct obd_job_stats {
 	cntr_init_callback	ojs_cntr_init_fn;/* lprocfs_stats initializer */
 	unsigned short		ojs_cntr_num;	/* number of stats in struct */
 	atomic64_t		ojs_jobs;	/* number of jobs */
+	struct job_stat_cache __percpu *ojs_cache; /* recent jobs per CPU */
+	unsigned int		ojs_top_count;	/* jobs shown in job_stats_top */
+	int			ojs_top_cntr;	/* job_stats_top key, -1: all */
 };
 
 #ifdef CONFIG_PROC_FS
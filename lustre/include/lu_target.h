@@ -291,6 +291,8 @@ struct tgt_session_info {
 	/* Sub request index in the batched RPC. */
 	__u32			 tsi_batch_idx;
 	struct tg_reply_data	*tsi_batch_trd;
+	/* Sub request of the batched RPC, with its own transno. */
+	struct req_capsule	*tsi_batch_pill;
 };
 
 static inline struct tgt_session_info *tgt_ses_info(const struct lu_env *env)
@@ -453,6 +455,7 @@ int tgt_sec_ctx_fini(struct tgt_session_info *tsi);
 int tgt_sendpage(struct tgt_session_info *tsi, struct lu_rdpg *rdpg, int nob);
 int tgt_send_buffer(struct tgt_session_info *tsi, struct lu_rdbuf *rdbuf);
 int tgt_validate_obdo(struct tgt_session_info *tsi, struct obdo *oa);
+struct obdo *tgt_obdo_array_unpack(struct tgt_session_info *tsi, int *count);
 int tgt_sync(const struct lu_env *env, struct lu_target *tgt,
 	     struct dt_object *obj, __u64 start, __u64 end);
 
@@ -245,6 +245,8 @@ struct xattr_match_info {
 	char			*xattr_value_buf;      /* [XATTR_SIZE_MAX] */
 };
 
+struct find_thread;
+
 /*
  * new fields should be added to the end of this struct (unless filling a hole
  * such as in a bitfield), to preserve the ABI
@@ -349,7 +351,7 @@ struct find_param {
 				 fp_stop_on_error:1, /* stop iteration on err */
 				 fp_exclude_nlink:1, /* Once used, we must add*/
 				 fp_exclude_attrs:1, /* a separate flag field */
-				 fp_unused_bit7:1;   /* at end of struct.  */
+				 fp_thread_ordered:1; /* at end of struct. */
 
 	enum llapi_layout_verbose fp_verbose;
 	int			 fp_quiet;
@@ -431,6 +433,10 @@ struct find_param {
 	unsigned long int	 fp_skip_percent;
 	unsigned long long	 fp_skip_total;
 	unsigned long long	 fp_skip_count;
+	/* scan directories with this many threads (lfs find only) */
+	unsigned int		 fp_thread_count;
+	/* private to the threads of llapi_find() */
+	struct find_thread	*fp_thread;
 };
 
 int llapi_ostlist(char *path, struct find_param *param);
@@ -539,6 +545,7 @@ int llapi_fd2parent(int fd, unsigned int linkno, struct lu_fid *parent_fid,
 		    char *name, size_t name_size);
 int llapi_rmfid(const char *path, struct fid_array *fa);
 int llapi_rmfid_at(int fd, struct fid_array *fa);
+int llapi_batch_ops(int dirfd, struct lu_batch_ops *ops);
 int llapi_root_path_open(const char *device, int *outfd);
 int llapi_chomp_string(char *buf);
 
@@ -611,12 +618,17 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 			  const char *mdtname, long long startrec);
 int llapi_changelog_fini(void **priv);
 int llapi_changelog_recv(void *priv, struct changelog_rec **rech);
+int llapi_changelog_recv_batch(void *priv, struct changelog_rec **recs,
+			       int count);
 int llapi_changelog_in_buf(void *priv);
 int llapi_changelog_free(struct changelog_rec **rech);
 int llapi_changelog_get_fd(void *priv);
 /* Allow records up to endrec to be destroyed; requires registered id. */
 int llapi_changelog_clear(const char *mdtname, const char *idstr,
 			  long long endrec);
+int llapi_changelog_clear_batch(void *priv, const char *idstr,
+				long long endrec);
+int llapi_changelog_clear_flush(void *priv);
 int llapi_changelog_set_xflags(void *priv,
 			       enum changelog_send_extra_flag extra_flags);
 struct changelog_rec *
@@ -797,6 +809,35 @@ int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
 			     struct llapi_resync_comp *comp_array,
 			     int comp_size,  uint64_t start, uint64_t end);
+int llapi_ec_parity_resync(int fd, uint32_t comp_id);
+
+/* Data mover for migration and mirror resync, see liblustreapi_copy.c */
+#define LLAPI_COPY_STREAMS_DEFAULT	4
+#define LLAPI_COPY_STREAMS_MAX		16
+
+struct llapi_copy_ops {
+	/* read up to \a count bytes at \a pos, short at EOF */
+	ssize_t (*lco_read)(void *priv, void *buf, size_t count, off_t pos);
+	/* write \a count bytes at \a pos, return the bytes written */
+	ssize_t (*lco_write)(void *priv, void *buf, size_t count, off_t pos);
+};
+
+struct llapi_copy_param {
+	const struct llapi_copy_ops	*lcp_ops;
+	void				*lcp_priv;
+	size_t				 lcp_chunk_size; /* page multiple */
+	unsigned int			 lcp_streams; /* 0 for default */
+	unsigned long long		 lcp_bandwidth; /* bytes/sec, 0 = any */
+	long				 lcp_stats_interval; /* seconds */
+	off_t				 lcp_stats_size; /* expected bytes */
+};
+
+/** Opaque data type of the data mover. */
+struct llapi_copy;
+
+struct llapi_copy *llapi_copy_init(const struct llapi_copy_param *param);
+off_t llapi_copy_range(struct llapi_copy *lc, off_t start, off_t end);
+void llapi_copy_fini(struct llapi_copy *lc);
 /*
  * Flags to control how layouts are retrieved.
  */
@@ -1269,6 +1310,31 @@ int llapi_layout_comp_flags_set(struct llapi_layout *layout, uint32_t flags);
  * Clears the flags specified in the flags leaving other flags as-is.
  */
 int llapi_layout_comp_flags_clear(struct llapi_layout *layout, uint32_t flags);
+/**
+ * Gets the erasure code data and parity stripe counts of the current component.
+ */
+int llapi_layout_comp_ec_get(const struct llapi_layout *layout,
+			     uint8_t *dstripes, uint8_t *cstripes);
+/**
+ * Sets the erasure code data and parity stripe counts of the current component.
+ */
+int llapi_layout_comp_ec_set(struct llapi_layout *layout,
+			     uint8_t dstripes, uint8_t cstripes);
+/**
+ * Gets the compression type and chunk size of the current component.
+ */
+int llapi_layout_comp_compress_get(const struct llapi_layout *layout,
+				   uint8_t *type, uint8_t *chunk_log_bits);
+/**
+ * Makes the current component compressed with \a type in chunks of
+ * COMPR_GET_CHUNK_SIZE(\a chunk_log_bits) bytes.
+ */
+int llapi_layout_comp_compress_set(struct llapi_layout *layout,
+				   uint8_t type, uint8_t chunk_log_bits);
+/**
+ * Adds a parity mirror with \a parity stripes per component to the layout.
+ */
+int llapi_layout_ec_parity_add(struct llapi_layout *layout, uint8_t parity);
 /**
  * Fetches the file-unique component ID of the current layout component.
  */
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Compression of file data chunks for LCME_FL_COMPRESS components.
+ *
+ * A chunk is a chunk-size aligned range of an OST object. When it is
+ * stored compressed, the object holds a struct ll_compr_hdr followed by
+ * the compressed data at the chunk start offset, padded to whole pages.
+ * Any chunk without a valid header holds plain data.
+ */
+
+#ifndef _LUSTRE_COMPR_H
+#define _LUSTRE_COMPR_H
+
+#include <linux/crypto.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <uapi/linux/lustre/lustre_user.h>
+#include <lustre_net.h>
+
+/* largest chunk handled, one object of the largest page pool */
+#define COMPR_CHUNK_MAX_BITS	PTLRPC_MAX_BRW_BITS
+
+const char *ll_compr_type_name(enum ll_compr_type type);
+int ll_compr_get(enum ll_compr_type type, struct crypto_comp **cc);
+void ll_compr_put(enum ll_compr_type type, struct crypto_comp *cc);
+void ll_compr_fini(void);
+bool ll_compr_hdr_valid(const struct ll_compr_hdr *llch,
+			unsigned int chunk_size);
+int ll_compress_chunk(struct crypto_comp *cc, const void *src,
+		      unsigned int src_len, void *dst, unsigned int *dst_len,
+		      enum ll_compr_type type, unsigned int chunk_log_bits);
+int ll_decompress_chunk(struct crypto_comp *cc, const void *src,
+			void *dst, unsigned int *dst_len);
+
+/* page backing offset @off of a buffer from obd_pool_get_objects() */
+static inline struct page *ll_compr_buf_page(void *buf, unsigned int off)
+{
+	void *addr = buf + off;
+
+	return is_vmalloc_addr(addr) ? vmalloc_to_page(addr) :
+				       virt_to_page(addr);
+}
+
+#endif /* _LUSTRE_COMPR_H */
@@ -703,7 +703,7 @@ struct ldlm_cb_async_args {
  * Interval tree for extent locks.
  * The interval tree must be accessed under the resource lock.
  * Interval trees are used for granted extent locks to speed up conflicts
- * lookup.
+ * lookup, and for waiting extent locks on the server.
  */
 struct ldlm_interval_tree {
 	/** Tree size. */
@@ -712,6 +712,16 @@ struct ldlm_interval_tree {
 	struct interval_tree_root	lit_root; /* actual interval tree */
 };
 
+/**
+ * Interval trees of waiting extent locks for each requested mode.
+ * Only maintained on the server, a lock remains in lr_waiting as well.
+ */
+struct ldlm_extent_queues {
+	struct ldlm_interval_tree	leq_waiting[LCK_MODE_NUM];
+	/** Last ldlm_lock::l_wait_seq assigned */
+	__u64				leq_seq;
+};
+
 /**
  * Lists of waiting locks for each inodebit type.
  * A lock can be in several liq_waiting lists and it remains in lr_waiting.
@@ -827,6 +837,8 @@ struct ldlm_lock {
 			struct rb_node		l_rb;
 			u64			l_subtree_last;
 			struct list_head	l_same_extent;
+			/* Order of arrival into lr_waiting, server only */
+			__u64			l_wait_seq;
 		};
 		struct { /* LDLM_PLAIN and LDLM_IBITS locks */
 			/**
@@ -1137,8 +1149,14 @@ struct ldlm_resource {
 	struct ldlm_res_id	lr_name;
 
 	union {
-		 /* Interval trees (for extent locks) all modes of resource */
-		struct ldlm_interval_tree *lr_itree;
+		struct {
+			/* Interval trees (for extent locks) all modes of
+			 * resource
+			 */
+			struct ldlm_interval_tree *lr_itree;
+			/* Waiting extent locks, NULL on the client */
+			struct ldlm_extent_queues *lr_extent_queues;
+		};
 		struct ldlm_ibits_queues *lr_ibits_queues;
 		struct ldlm_flock_node lr_flock_node;
 	};
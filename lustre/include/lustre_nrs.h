@@ -686,6 +686,7 @@ struct binheap_node {
 #include <lustre_nrs_tbf.h>
 #include <lustre_nrs_crr.h>
 #include <lustre_nrs_orr.h>
+#include <lustre_nrs_edf.h>
 #endif /* HAVE_SERVER_SUPPORT */
 #include <lustre_nrs_delay.h>
 
@@ -735,6 +736,10 @@ struct ptlrpc_nrs_request {
 		 * TBF request definition
 		 */
 		struct nrs_tbf_req	tbf;
+		/**
+		 * EDF request definition
+		 */
+		struct nrs_edf_req	edf;
 #endif /* HAVE_SERVER_SUPPORT */
 		/**
 		 * Fields for the delay policy
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Network Request Scheduler (NRS) Earliest Deadline First (EDF) policy
+ */
+
+#ifndef _LUSTRE_NRS_EDF_H
+#define _LUSTRE_NRS_EDF_H
+
+/* \name edf
+ *
+ * EDF policy
+ *
+ * Requests are dispatched in the order of their adaptive timeout deadline,
+ * so that the requests closest to timing out on the client are handled first.
+ * @{
+ */
+
+/**
+ * Scheduling statistics of an EDF policy instance
+ */
+struct nrs_edf_stats {
+	/**
+	 * Requests dispatched for handling.
+	 */
+	__u64				es_served;
+	/**
+	 * Requests dispatched ahead of a request that arrived earlier, i.e.
+	 * which FIFO would have handled later.
+	 */
+	__u64				es_expedited;
+	/**
+	 * Requests that had early replies sent while they were queued.
+	 */
+	__u64				es_early_replied;
+	/**
+	 * Requests dispatched after their deadline, which will be dropped.
+	 */
+	__u64				es_expired;
+};
+
+/**
+ * Private data structure for the EDF policy
+ */
+struct nrs_edf_head {
+	/**
+	 * Resource object for policy instance.
+	 */
+	struct ptlrpc_nrs_resource	eh_res;
+	/**
+	 * Queued requests sorted by deadline.
+	 */
+	struct binheap			*eh_binheap;
+	/**
+	 * Queued requests in arrival order, to tell expedited requests.
+	 */
+	struct list_head		eh_list;
+	/**
+	 * Arrival sequence, breaks ties between equal deadlines.
+	 */
+	__u64				eh_sequence;
+	/**
+	 * Scheduling statistics, protected by
+	 * ptlrpc_service_part::scp_req_lock.
+	 */
+	struct nrs_edf_stats		eh_stats;
+};
+
+struct nrs_edf_req {
+	/**
+	 * Linkage into nrs_edf_head::eh_list.
+	 */
+	struct list_head	er_list;
+	/**
+	 * Arrival sequence of the request.
+	 */
+	__u64			er_sequence;
+	/**
+	 * Deadline of the request when it was enqueued.
+	 */
+	time64_t		er_deadline;
+};
+
+#define NRS_CTL_EDF_RD_STATS	PTLRPC_NRS_CTL_POL_SPEC_01
+#define NRS_CTL_EDF_CLR_STATS	PTLRPC_NRS_CTL_POL_SPEC_02
+
+/** @} edf */
+#endif
@@ -127,6 +127,8 @@ enum nrs_rule_flags {
 	NTRS_STOPPING	= 0x00000001,
 	NTRS_DEFAULT	= 0x00000002,
 	NTRS_REALTIME	= 0x00000004,
+	/* may use the unused tokens of the parent rule */
+	NTRS_BORROW	= 0x00000008,
 };
 
 struct nrs_tbf_rule {
@@ -173,6 +175,17 @@ struct nrs_tbf_rule {
 	struct kref			 tr_ref;
 	/** Generation of the rule. */
 	__u64				 tr_generation;
+	/**
+	 * Parent rule whose token bucket is shared by the classes of all its
+	 * child rules and caps their aggregate RPC rate.
+	 */
+	struct nrs_tbf_rule		*tr_parent;
+	/** Number of started child rules. Protected by th_rule_lock. */
+	int				 tr_nchildren;
+	/** Tokens of the shared bucket, when the rule has child rules. */
+	__u64				 tr_ntoken;
+	/** Time check-point of the shared bucket. */
+	__u64				 tr_check_time;
 };
 
 struct nrs_tbf_ops {
@@ -305,6 +318,7 @@ struct nrs_tbf_cmd {
 			__u32			 ts_valid_type;
 			enum nrs_rule_flags	 ts_rule_flags;
 			char			*ts_next_name;
+			char			*ts_parent_name;
 		} tc_start;
 		struct nrs_tbf_cmd_change {
 			__u64			 tc_rpc_rate;
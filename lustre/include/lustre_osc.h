@@ -86,6 +86,15 @@ struct osc_device {
 		ktime_t		os_init;
 		uint64_t	os_lockless_writes;    /* by bytes */
 		uint64_t	os_lockless_reads;     /* by bytes */
+		/* chunks of LCME_FL_COMPRESS components, see osc_compress.c */
+		uint64_t	os_compr_chunks;
+		uint64_t	os_compr_skipped;   /* did not save a page */
+		uint64_t	os_compr_bytes_in;
+		uint64_t	os_compr_bytes_out;
+		uint64_t	os_compr_time;	    /* in ns */
+		uint64_t	os_decompr_chunks;
+		uint64_t	os_decompr_bytes;   /* uncompressed */
+		uint64_t	os_decompr_time;    /* in ns */
 	} osc_stats;
 
 	/* configuration item(s) */
@@ -520,6 +529,8 @@ struct osc_page {
 	struct list_head	ops_lru;
 };
 
+struct osc_compr_args;
+
 struct osc_brw_async_args {
 	struct obdo		*aa_oa;
 	int			 aa_requested_nob;
@@ -531,6 +542,8 @@ struct osc_brw_async_args {
 	struct list_head	 aa_oaps;
 	struct list_head	 aa_exts;
 	struct ptlrpc_request	*aa_request;
+	/* pages of the RPC replaced by compressed chunks, or NULL */
+	struct osc_compr_args	*aa_compr;
 };
 
 extern struct kmem_cache *osc_lock_kmem;
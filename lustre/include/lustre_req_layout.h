@@ -291,6 +291,9 @@ extern struct req_format RQF_LFSCK_QUERY;
 
 /* Batch UpdaTe req_format */
 extern struct req_format RQF_BUT_GETATTR;
+extern struct req_format RQF_BUT_CREATE;
+extern struct req_format RQF_BUT_UNLINK;
+extern struct req_format RQF_BUT_SETATTR;
 extern struct req_format RQF_MDS_BATCH;
 
 extern struct req_msg_field RMF_GENERIC_DATA;
@@ -369,6 +372,7 @@ extern struct req_msg_field RMF_MGS_TARGET_INFO;
 extern struct req_msg_field RMF_MGS_SEND_PARAM;
 
 extern struct req_msg_field RMF_OST_BODY;
+extern struct req_msg_field RMF_OBDO_ARRAY;
 extern struct req_msg_field RMF_OBD_IOOBJ;
 extern struct req_msg_field RMF_OBD_ID;
 extern struct req_msg_field RMF_FID;
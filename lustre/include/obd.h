@@ -45,6 +45,9 @@ struct lov_oinfo {                 /* per-stripe data structure */
 	__u64		loi_kms; /* known minimum size */
 	struct		ost_lvb loi_lvb;
 	struct		osc_async_rc loi_ar;
+	/* compression of a LCME_FL_COMPRESS component, see lustre_compr.h */
+	__u8		loi_compr_type;	/* enum ll_compr_type, 0 if none */
+	__u8		loi_compr_chunk_bits; /* log2 of chunk size in bytes */
 };
 
 void lov_fix_ea_for_replay(void *lovea);
@@ -1030,6 +1033,9 @@ typedef int (*md_op_item_cb_t)(struct md_op_item *item, int rc);
 enum md_item_opcode {
 	MD_OP_NONE	= 0,
 	MD_OP_GETATTR	= 1,
+	MD_OP_CREATE	= 2,
+	MD_OP_UNLINK	= 3,
+	MD_OP_SETATTR	= 4,
 	MD_OP_MAX,
 };
 
@@ -63,6 +63,37 @@ struct lustre_access_log_info_v1 {
 	__u32	_lali_is_closed;
 };
 
+/* Control page at offset 0 of a mmap() of an access log device file,
+ * followed by the log entries at offset lalr_data_offset. The length of
+ * the mapping must be lalr_data_offset plus lali_log_size rounded up to
+ * the page size. Head and tail are byte offsets of entries in the log as
+ * in Documentation/core-api/circular-buffers.rst: the kernel adds
+ * entries at head and the reader consumes entries from tail, then stores
+ * the new tail with release semantics. Each group of fields written by
+ * one side is kept on its own cache line.
+ */
+struct lustre_access_log_ring_v1 {
+	/* constant */
+	__u32	lalr_version; /* LUSTRE_ACCESS_LOG_VERSION_1 */
+	__u32	lalr_data_offset;
+	__u32	lalr_log_size;
+	__u32	lalr_entry_size;
+	/* written by the reader: wake up readers sleeping in poll() or
+	 * read() once this many entries were added, or when the log is
+	 * half full. 0 wakes them up for every entry.
+	 */
+	__u32	lalr_wakeup_count;
+	__u32	lalr_padding1[11];
+	/* written by the kernel */
+	__u32	lalr_head;
+	__u32	lalr_drop_count;
+	__u32	lalr_is_closed;
+	__u32	lalr_padding2[13];
+	/* written by the reader */
+	__u32	lalr_tail;
+	__u32	lalr_padding3[15];
+};
+
 /* /dev/lustre-access-log/control ioctl: return lustre access log */
 enum {
 	/* return lustre access log interface version. */
@@ -848,6 +848,8 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT2_SPARSE            0x1000000000ULL /* sparse LNet read */
 #define OBD_CONNECT2_MIRROR_ID_FIX     0x2000000000ULL /* rr_mirror_id move */
 #define OBD_CONNECT2_UPDATE_LAYOUT     0x4000000000ULL /* update compressibility */
+#define OBD_CONNECT2_BATCH_REINT       0x8000000000ULL /* batched create/unlink/setattr */
+#define OBD_CONNECT2_SYNC_BATCH       0x10000000000ULL /* multi-object destroy/setattr */
 /* XXX README XXX README XXX README XXX README XXX README XXX README XXX
  * Please DO NOT add OBD_CONNECT flags before first ensuring that this value
  * is not in use by some other branch/patch.  Email adilger@whamcloud.com
@@ -919,7 +921,8 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT2_DMV_IMP_INHERIT |\
 				OBD_CONNECT2_UNALIGNED_DIO | \
 				OBD_CONNECT2_PCCRO | \
-				OBD_CONNECT2_MIRROR_ID_FIX)
+				OBD_CONNECT2_MIRROR_ID_FIX | \
+				OBD_CONNECT2_BATCH_REINT)
 
 #define OST_CONNECT_SUPPORTED  (OBD_CONNECT_SRVLOCK | OBD_CONNECT_GRANT | \
 				OBD_CONNECT_REQPORTAL | OBD_CONNECT_VERSION | \
@@ -944,7 +947,9 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT2_ENCRYPT | OBD_CONNECT2_LSEEK |\
 				OBD_CONNECT2_REP_MBITS |\
 				OBD_CONNECT2_REPLAY_CREATE |\
-				OBD_CONNECT2_UNALIGNED_DIO)
+				OBD_CONNECT2_UNALIGNED_DIO |\
+				OBD_CONNECT2_COMPRESS |\
+				OBD_CONNECT2_SYNC_BATCH)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID | OBD_CONNECT_FLAGS2)
 #define ECHO_CONNECT_SUPPORTED2 OBD_CONNECT2_REP_MBITS
@@ -3691,6 +3696,9 @@ struct batch_update_reply {
  */
 enum batch_update_cmd {
 	BUT_GETATTR	= 1,
+	BUT_CREATE	= 2,
+	BUT_UNLINK	= 3,
+	BUT_SETATTR	= 4,
 	BUT_LAST_OPC,
 	BUT_FIRST_OPC	= BUT_GETATTR,
 };
@@ -584,6 +584,19 @@ struct ll_ioc_lease_id {
 	__u32		lil_ids[];
 };
 
+enum ll_mirror_io_flags {
+	LL_MIRROR_IO_WRITE	= 0x00000001, /* write, read if not set */
+};
+
+/* direct I/O to a mirror, leaving the mirror set on the file untouched */
+struct ll_ioc_mirror_io {
+	__u32		lmi_mirror_id;
+	__u32		lmi_flags;	/* enum ll_mirror_io_flags */
+	__u64		lmi_buf;	/* user buffer, aligned on pages */
+	__u64		lmi_count;
+	__u64		lmi_pos;
+};
+
 /*
  * The ioctl naming rules:
  * LL_*     - works on the currently opened filehandle instead of parent dir
@@ -632,6 +645,9 @@ struct ll_ioc_lease_id {
 #define LL_IOC_HSM_ACTION		_IOR('f', 220, \
 						struct hsm_current_action)
 /*	lustre_ioctl.h			221-233 */
+#define LL_IOC_BATCH_OPS		_IOWR('f', 234, struct lu_batch_ops)
+#define LL_IOC_EC_PARITY_RESYNC		_IOW('f', 235, __u32)
+#define LL_IOC_FLR_MIRROR_IO		_IOW('f', 236, struct ll_ioc_mirror_io)
 #define LL_IOC_LMV_SETSTRIPE		_IOWR('f', 240, struct lmv_user_md)
 #define LL_IOC_LMV_GETSTRIPE		_IOWR('f', 241, struct lmv_user_md)
 #define LL_IOC_REMOVE_ENTRY		_IOWR('f', 242, __u64)
@@ -937,7 +953,7 @@ enum lov_comp_md_entry_flags {
 
 #define LCME_KNOWN_FLAGS	(LCME_FL_NEG | LCME_FL_INIT | LCME_FL_STALE | \
 				 LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
-				 LCME_FL_EXTENSION)
+				 LCME_FL_EXTENSION | LCME_FL_PARITY)
 
 /* The component flags can be set by users at creation/modification time. */
 #define LCME_USER_COMP_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
@@ -947,7 +963,8 @@ enum lov_comp_md_entry_flags {
 #define LCME_USER_MIRROR_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOCOMPR)
 
 /* The allowed flags obtained from the client at component creation time. */
-#define LCME_CL_COMP_FLAGS	(LCME_USER_MIRROR_FLAGS | LCME_FL_EXTENSION)
+#define LCME_CL_COMP_FLAGS	(LCME_USER_MIRROR_FLAGS | LCME_FL_EXTENSION | \
+				 LCME_FL_PARITY | LCME_FL_COMPRESS)
 
 /* The mirror flags sent by client */
 #define LCME_MIRROR_FLAGS	(LCME_FL_NOSYNC)
@@ -956,7 +973,8 @@ enum lov_comp_md_entry_flags {
  * from the default/template layout set on a directory.
  */
 #define LCME_TEMPLATE_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
-				 LCME_FL_EXTENSION)
+				 LCME_FL_EXTENSION | LCME_FL_PARITY | \
+				 LCME_FL_COMPRESS)
 
 /* lcme_id can be specified as certain flags, and the first
  * bit of lcme_id is used to indicate that the ID is representing
@@ -1010,6 +1028,40 @@ struct lov_comp_md_entry_v1 {
 				      */
 } __attribute__((packed));
 
+/* lcme_compr_type values */
+enum ll_compr_type {
+	LL_COMPR_TYPE_NONE	= 0,
+	LL_COMPR_TYPE_FAST	= 1,	/* fastest available, lz4 */
+	LL_COMPR_TYPE_BEST	= 2,	/* best ratio available, zstd */
+	LL_COMPR_TYPE_LZ4	= 3,
+	LL_COMPR_TYPE_LZ4HC	= 4,
+	LL_COMPR_TYPE_ZSTD	= 5,
+	LL_COMPR_TYPE_GZIP	= 6,
+	LL_COMPR_TYPE_MAX
+};
+
+#define COMPR_CHUNK_MIN_BITS	16
+#define COMPR_GET_CHUNK_SIZE(log_bits)	\
+	(1UL << ((log_bits) + COMPR_CHUNK_MIN_BITS))
+
+/*
+ * Header stored in front of the data of every compressed chunk. A chunk
+ * without a valid header at its start offset holds uncompressed data.
+ */
+struct ll_compr_hdr {
+	__u32	llch_magic;		/* LLCH_MAGIC */
+	__u8	llch_header_size;	/* sizeof(struct ll_compr_hdr) */
+	__u8	llch_compr_type;	/* enum ll_compr_type */
+	__u8	llch_reserved0;
+	__u8	llch_chunk_log_bits;	/* as lcme_compr_chunk_log_bits */
+	__u32	llch_compr_size;	/* bytes of compressed data */
+	__u32	llch_uncompr_size;	/* bytes of data in the chunk */
+	__u32	llch_reserved1;
+	__u32	llch_hdr_csum;		/* crc32 of all fields above */
+};
+
+#define LLCH_MAGIC		0x4c5a4348	/* "LZCH" */
+
 #define SEQ_ID_MAX		0x0000FFFF
 #define SEQ_ID_MASK		SEQ_ID_MAX
 /* bit 30:16 of lcme_id is used to store mirror id */
@@ -1909,6 +1961,42 @@ enum changelog_send_flag {
 /* 31 usable bytes string + null terminator. */
 #define LUSTRE_JOBID_SIZE	32
 
+/*
+ * Binary format of the job_stats_bin file of the MDTs and OSTs: a header
+ * with the name of each counter, followed by one record per job holding
+ * jsbh_cntr_num counters. Records are jsbh_rec_len bytes long, so that
+ * counters can be added at the end of a record later.
+ */
+#define JOB_STATS_BIN_MAGIC	0x4a534231	/* "JSB1" */
+
+struct job_stats_bin_name {
+	char	jsbn_name[24];
+	char	jsbn_units[8];
+};
+
+struct job_stats_bin_hdr {
+	__u32	jsbh_magic;
+	__u16	jsbh_cntr_num;		/* counters in each job record */
+	__u16	jsbh_rec_len;		/* bytes of each job record */
+	__u64	jsbh_snapshot_ns;	/* time of the dump, since epoch */
+	struct job_stats_bin_name jsbh_names[];
+};
+
+struct job_stats_bin_cntr {
+	__u64	jsbc_count;
+	__u64	jsbc_min;
+	__u64	jsbc_max;
+	__u64	jsbc_sum;
+	__u64	jsbc_sumsq;
+};
+
+struct job_stats_bin_rec {
+	char	jsbr_jobid[LUSTRE_JOBID_SIZE];
+	__u64	jsbr_start_ns;		/* time of the first stat */
+	__u64	jsbr_latest_ns;		/* time of the latest stat */
+	struct job_stats_bin_cntr jsbr_cntrs[];
+};
+
 /* This is the minimal changelog record. It can contain extensions
  * such as rename fields or process jobid. Its exact content is described
  * by the cr_flags and cr_extra_flags.
@@ -2788,6 +2876,8 @@ static inline const char *pcc_type2string(enum lu_pcc_type type)
 #define PCC_YAML_ROID		"roid"
 #define PCC_YAML_FLAGS		"flags"
 #define PCC_YAML_AUTOCACHE	"autocache"
+#define PCC_YAML_PRIO		"prio"
+#define PCC_YAML_STATS		"stats"
 
 enum hsmtool_type {
 	HSMTOOL_UNKNOWN		= 0,
@@ -2903,6 +2993,41 @@ struct fid_array {
 };
 #define OBD_MAX_FIDS_IN_ARRAY	4096
 
+/* Metadata operations batched by LL_IOC_BATCH_OPS in a directory */
+enum lu_batch_opc {
+	LU_BATCH_CREATE		= 1,	/* create a regular file */
+	LU_BATCH_UNLINK		= 2,	/* unlink a non-directory */
+	LU_BATCH_SETATTR	= 3,	/* change the attributes in lbe_valid */
+};
+
+enum lu_batch_valid {
+	LU_BATCH_SET_MODE	= 0x01,
+	LU_BATCH_SET_UID	= 0x02,
+	LU_BATCH_SET_GID	= 0x04,
+	LU_BATCH_SET_ATIME	= 0x08,
+	LU_BATCH_SET_MTIME	= 0x10,
+};
+
+struct lu_batch_entry {
+	__u16	lbe_opc;	/* enum lu_batch_opc */
+	__u16	lbe_namelen;	/* without the trailing NUL */
+	__u32	lbe_valid;	/* LU_BATCH_SET_* for LU_BATCH_SETATTR */
+	__u32	lbe_mode;	/* permission bits */
+	__u32	lbe_uid;
+	__u32	lbe_gid;
+	__s32	lbe_result;	/* returned: 0 or negative errno */
+	__s64	lbe_atime;
+	__s64	lbe_mtime;
+	char	lbe_name[NAME_MAX + 1];
+};
+
+struct lu_batch_ops {
+	__u32			lbo_count;
+	__u32			lbo_padding;
+	struct lu_batch_entry	lbo_entries[];
+};
+#define LU_BATCH_OPS_MAX	1024
+
 /* more types could be defined upon need for more complex
  * format to be used in foreign symlink LOV/LMV EAs, like
  * one to describe a delimiter string and occurence number
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/kunit/compr_test.c
+ *
+ * Verify that chunks compressed by ll_compress_chunk() are decompressed to
+ * the same data for every compression type the kernel provides, and report
+ * the compression ratio and throughput on text-like data. Loading the module
+ * fails with -EINVAL if any chunk is not restored.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/random.h>
+
+#include <libcfs/libcfs.h>
+#include <obd_support.h>
+#include <lustre_compr.h>
+
+static int compr_test_msec = 1000;
+module_param(compr_test_msec, int, 0444);
+MODULE_PARM_DESC(compr_test_msec, "Time to run each throughput test in msec");
+
+#define COMPR_TEST_MAX_BITS	20
+
+struct compr_test_ctx {
+	char	*ctc_src;
+	char	*ctc_dst;
+	char	*ctc_out;
+};
+
+/* words repeated in random order, compressible like text */
+static void compr_test_fill(char *buf, unsigned int len)
+{
+	static const char * const words[] = {
+		"lustre ", "object ", "stripe ", "chunk ", "extent ",
+		"target ", "client ", "server ", "layout ", "\n",
+	};
+	unsigned int off = 0;
+
+	while (off < len) {
+		const char *word = words[get_random_u32() % ARRAY_SIZE(words)];
+		unsigned int n = min_t(unsigned int, strlen(word), len - off);
+
+		memcpy(buf + off, word, n);
+		off += n;
+	}
+}
+
+static int compr_test_verify(struct compr_test_ctx *ctx,
+			     enum ll_compr_type type, struct crypto_comp *cc,
+			     unsigned int chunk_bits, unsigned int len,
+			     bool random)
+{
+	const char *name = ll_compr_type_name(type);
+	unsigned int chunk_size = 1U << chunk_bits;
+	unsigned int dst_len = chunk_size;
+	unsigned int out_len = chunk_size;
+	int rc;
+
+	if (random)
+		get_random_bytes(ctx->ctc_src, len);
+	else
+		compr_test_fill(ctx->ctc_src, len);
+
+	rc = ll_compress_chunk(cc, ctx->ctc_src, len, ctx->ctc_dst, &dst_len,
+			       type, chunk_bits - COMPR_CHUNK_MIN_BITS);
+	if (rc == -E2BIG && random)
+		return 0;
+	if (rc) {
+		pr_err("compr_test: %s: chunk %u len %u: compress failed: rc = %d\n",
+		       name, chunk_size, len, rc);
+		return -EINVAL;
+	}
+
+	if (!ll_compr_hdr_valid((struct ll_compr_hdr *)ctx->ctc_dst,
+				chunk_size)) {
+		pr_err("compr_test: %s: chunk %u len %u: invalid header\n",
+		       name, chunk_size, len);
+		return -EINVAL;
+	}
+
+	rc = ll_decompress_chunk(cc, ctx->ctc_dst, ctx->ctc_out, &out_len);
+	if (rc || out_len != len || memcmp(ctx->ctc_src, ctx->ctc_out, len)) {
+		pr_err("compr_test: %s: chunk %u len %u: data not restored: rc = %d\n",
+		       name, chunk_size, len, rc);
+		return -EINVAL;
+	}
+
+	/* a chunk with a damaged header is plain data */
+	ctx->ctc_dst[offsetof(struct ll_compr_hdr, llch_compr_size)] ^= 1;
+	if (ll_compr_hdr_valid((struct ll_compr_hdr *)ctx->ctc_dst,
+			       chunk_size)) {
+		pr_err("compr_test: %s: chunk %u len %u: damaged header accepted\n",
+		       name, chunk_size, len);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void compr_test_perf(struct compr_test_ctx *ctx,
+			    enum ll_compr_type type, struct crypto_comp *cc,
+			    unsigned int chunk_bits)
+{
+	const char *name = ll_compr_type_name(type);
+	unsigned int chunk_size = 1U << chunk_bits;
+	unsigned int dst_len = chunk_size;
+	u64 bytes = 0;
+	ktime_t start;
+	ktime_t end;
+	u64 nsec;
+	int rc;
+
+	compr_test_fill(ctx->ctc_src, chunk_size);
+	start = ktime_get();
+	end = ktime_add_ms(start, compr_test_msec);
+	do {
+		dst_len = chunk_size;
+		rc = ll_compress_chunk(cc, ctx->ctc_src, chunk_size,
+				       ctx->ctc_dst, &dst_len, type,
+				       chunk_bits - COMPR_CHUNK_MIN_BITS);
+		if (rc)
+			return;
+		bytes += chunk_size;
+	} while (ktime_before(ktime_get(), end));
+	nsec = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	/* ratio of the pages written for the chunk */
+	pr_info("compr_test: %s: chunk %u ratio %u%% compress %llu MB/s\n",
+		name, chunk_size,
+		chunk_size * 100 / (unsigned int)round_up(dst_len, PAGE_SIZE),
+		div64_u64(bytes * 1000, nsec ?: 1));
+
+	bytes = 0;
+	start = ktime_get();
+	end = ktime_add_ms(start, compr_test_msec);
+	do {
+		unsigned int out_len = chunk_size;
+
+		rc = ll_decompress_chunk(cc, ctx->ctc_dst, ctx->ctc_out,
+					 &out_len);
+		if (rc)
+			return;
+		bytes += chunk_size;
+	} while (ktime_before(ktime_get(), end));
+	nsec = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	pr_info("compr_test: %s: chunk %u decompress %llu MB/s\n",
+		name, chunk_size, div64_u64(bytes * 1000, nsec ?: 1));
+}
+
+static int __init compr_test_init(void)
+{
+	static const unsigned int chunk_bits[] = { 16, 17, 20 };
+	struct compr_test_ctx ctx = { NULL };
+	enum ll_compr_type type;
+	int i;
+	int rc = 0;
+
+	OBD_ALLOC_LARGE(ctx.ctc_src, 1 << COMPR_TEST_MAX_BITS);
+	OBD_ALLOC_LARGE(ctx.ctc_dst, 1 << COMPR_TEST_MAX_BITS);
+	OBD_ALLOC_LARGE(ctx.ctc_out, 1 << COMPR_TEST_MAX_BITS);
+	if (!ctx.ctc_src || !ctx.ctc_dst || !ctx.ctc_out)
+		GOTO(out, rc = -ENOMEM);
+
+	for (type = LL_COMPR_TYPE_LZ4; type < LL_COMPR_TYPE_MAX; type++) {
+		struct crypto_comp *cc;
+
+		rc = ll_compr_get(type, &cc);
+		if (rc) {
+			pr_info("compr_test: %s: not available\n",
+				ll_compr_type_name(type));
+			rc = 0;
+			continue;
+		}
+
+		for (i = 0; i < ARRAY_SIZE(chunk_bits) && !rc; i++) {
+			unsigned int size = 1U << chunk_bits[i];
+
+			rc = compr_test_verify(&ctx, type, cc, chunk_bits[i],
+					       size, false);
+			/* partial chunk at the end of a file */
+			if (!rc)
+				rc = compr_test_verify(&ctx, type, cc,
+						       chunk_bits[i],
+						       size / 2 + 17, false);
+			if (!rc)
+				rc = compr_test_verify(&ctx, type, cc,
+						       chunk_bits[i],
+						       size, true);
+		}
+
+		for (i = 0; i < ARRAY_SIZE(chunk_bits) && !rc; i++)
+			compr_test_perf(&ctx, type, cc, chunk_bits[i]);
+
+		ll_compr_put(type, cc);
+		if (rc)
+			break;
+	}
+out:
+	if (ctx.ctc_src)
+		OBD_FREE_LARGE(ctx.ctc_src, 1 << COMPR_TEST_MAX_BITS);
+	if (ctx.ctc_dst)
+		OBD_FREE_LARGE(ctx.ctc_dst, 1 << COMPR_TEST_MAX_BITS);
+	if (ctx.ctc_out)
+		OBD_FREE_LARGE(ctx.ctc_out, 1 << COMPR_TEST_MAX_BITS);
+
+	return rc;
+}
+
+static void __exit compr_test_exit(void)
+{
+}
+
+MODULE_DESCRIPTION("Lustre chunk compression verification and performance test");
+MODULE_LICENSE("GPL");
+
+module_init(compr_test_init);
+module_exit(compr_test_exit);
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/kunit/ec_test.c
+ *
+ * Verify every erasure code implementation usable on this CPU against
+ * ec_encode_data_base() and report its encode and parity update throughput.
+ * Loading the module fails with -EINVAL if any implementation gives a wrong
+ * result.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/random.h>
+
+#include <libcfs/libcfs.h>
+#include <obd_support.h>
+#include <erasure_code.h>
+
+static int ec_test_len = 1 << 20;
+module_param(ec_test_len, int, 0444);
+MODULE_PARM_DESC(ec_test_len, "Size of each data/parity buffer in bytes");
+
+static int ec_test_msec = 1000;
+module_param(ec_test_msec, int, 0444);
+MODULE_PARM_DESC(ec_test_msec, "Time to run each throughput test in msec");
+
+#define EC_TEST_MAX_K	16
+#define EC_TEST_MAX_P	4
+
+struct ec_test_ctx {
+	unsigned char	*etc_data[EC_TEST_MAX_K];
+	unsigned char	*etc_ref[EC_TEST_MAX_P];
+	unsigned char	*etc_out[EC_TEST_MAX_P];
+	unsigned char	*etc_delta;
+	unsigned char	 etc_matrix[(EC_TEST_MAX_K + EC_TEST_MAX_P) *
+				    EC_TEST_MAX_K];
+	unsigned char	 etc_tbls[32 * EC_TEST_MAX_K * EC_TEST_MAX_P];
+};
+
+/* buffer lengths, the odd ones check the tails of the vectorized loops */
+static const int ec_test_lens[] = { 1, 15, 63, 4096, 4096 + 17, 65536 + 31 };
+
+static void ec_test_xor(unsigned char *dst, const unsigned char *src, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		dst[i] ^= src[i];
+}
+
+static int ec_test_verify(struct ec_test_ctx *ctx, const struct ec_impl *impl,
+			  int k, int p, int len)
+{
+	int i;
+
+	gf_gen_cauchy1_matrix(ctx->etc_matrix, k + p, k);
+	ec_init_tables(k, p, &ctx->etc_matrix[k * k], ctx->etc_tbls);
+	ec_encode_data_base(len, k, p, ctx->etc_tbls, ctx->etc_data,
+			    ctx->etc_ref);
+
+	for (i = 0; i < p; i++)
+		memset(ctx->etc_out[i], 0x5a, len);
+	impl->ei_encode(len, k, p, ctx->etc_tbls, ctx->etc_data, ctx->etc_out);
+	for (i = 0; i < p; i++) {
+		if (memcmp(ctx->etc_out[i], ctx->etc_ref[i], len) != 0) {
+			pr_err("ec_test: %s: encode %d+%d len=%d parity %d mismatch\n",
+			       impl->ei_name, k, p, len, i);
+			return -EINVAL;
+		}
+	}
+
+	/* accumulating every source into zeroed parity must match encode */
+	for (i = 0; i < p; i++)
+		memset(ctx->etc_out[i], 0, len);
+	for (i = 0; i < k; i++)
+		impl->ei_encode_update(len, k, p, i, ctx->etc_tbls,
+				       ctx->etc_data[i], ctx->etc_out);
+	for (i = 0; i < p; i++) {
+		if (memcmp(ctx->etc_out[i], ctx->etc_ref[i], len) != 0) {
+			pr_err("ec_test: %s: update %d+%d len=%d parity %d mismatch\n",
+			       impl->ei_name, k, p, len, i);
+			return -EINVAL;
+		}
+	}
+
+	/* adding the delta of a rewritten source must match a full encode */
+	get_random_bytes(ctx->etc_delta, len);
+	ec_test_xor(ctx->etc_data[k - 1], ctx->etc_delta, len);
+	impl->ei_encode_update(len, k, p, k - 1, ctx->etc_tbls,
+			       ctx->etc_delta, ctx->etc_out);
+	ec_encode_data_base(len, k, p, ctx->etc_tbls, ctx->etc_data,
+			    ctx->etc_ref);
+	ec_test_xor(ctx->etc_data[k - 1], ctx->etc_delta, len);
+	for (i = 0; i < p; i++) {
+		if (memcmp(ctx->etc_out[i], ctx->etc_ref[i], len) != 0) {
+			pr_err("ec_test: %s: delta %d+%d len=%d parity %d mismatch\n",
+			       impl->ei_name, k, p, len, i);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void ec_test_perf(struct ec_test_ctx *ctx, const struct ec_impl *impl,
+			 int k, int p)
+{
+	ktime_t start, now;
+	u64 bytes = 0;
+	s64 usec;
+
+	gf_gen_cauchy1_matrix(ctx->etc_matrix, k + p, k);
+	ec_init_tables(k, p, &ctx->etc_matrix[k * k], ctx->etc_tbls);
+
+	start = now = ktime_get();
+	while (ktime_ms_delta(now, start) < ec_test_msec) {
+		impl->ei_encode(ec_test_len, k, p, ctx->etc_tbls,
+				ctx->etc_data, ctx->etc_out);
+		bytes += (u64)k * ec_test_len;
+		cond_resched();
+		now = ktime_get();
+	}
+	usec = max_t(s64, ktime_us_delta(now, start), 1);
+
+	pr_info("ec_test: %s: encode %d+%d len=%d %llu MB/s\n",
+		impl->ei_name, k, p, ec_test_len, div64_u64(bytes, usec));
+
+	/* parity update for a rewrite of one source, counted in source bytes */
+	bytes = 0;
+	start = now = ktime_get();
+	while (ktime_ms_delta(now, start) < ec_test_msec) {
+		impl->ei_encode_update(ec_test_len, k, p, 0, ctx->etc_tbls,
+				       ctx->etc_delta, ctx->etc_out);
+		bytes += ec_test_len;
+		cond_resched();
+		now = ktime_get();
+	}
+	usec = max_t(s64, ktime_us_delta(now, start), 1);
+
+	pr_info("ec_test: %s: update %d+%d len=%d %llu MB/s\n",
+		impl->ei_name, k, p, ec_test_len, div64_u64(bytes, usec));
+}
+
+static void ec_test_free(struct ec_test_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < EC_TEST_MAX_K; i++)
+		if (ctx->etc_data[i])
+			OBD_FREE_LARGE(ctx->etc_data[i], ec_test_len);
+	for (i = 0; i < EC_TEST_MAX_P; i++) {
+		if (ctx->etc_ref[i])
+			OBD_FREE_LARGE(ctx->etc_ref[i], ec_test_len);
+		if (ctx->etc_out[i])
+			OBD_FREE_LARGE(ctx->etc_out[i], ec_test_len);
+	}
+	if (ctx->etc_delta)
+		OBD_FREE_LARGE(ctx->etc_delta, ec_test_len);
+	OBD_FREE_PTR(ctx);
+}
+
+static int __init ec_test_init(void)
+{
+	static const int geometries[][2] = { { 4, 2 }, { 8, 2 }, { 16, 4 } };
+	const struct ec_impl *impl;
+	struct ec_test_ctx *ctx;
+	int i, j, g;
+	int rc = 0;
+
+	if (ec_test_len < ec_test_lens[ARRAY_SIZE(ec_test_lens) - 1])
+		return -EINVAL;
+
+	OBD_ALLOC_PTR(ctx);
+	if (!ctx)
+		return -ENOMEM;
+
+	for (i = 0; i < EC_TEST_MAX_K; i++) {
+		OBD_ALLOC_LARGE(ctx->etc_data[i], ec_test_len);
+		if (!ctx->etc_data[i])
+			GOTO(out, rc = -ENOMEM);
+		get_random_bytes(ctx->etc_data[i], ec_test_len);
+	}
+	for (i = 0; i < EC_TEST_MAX_P; i++) {
+		OBD_ALLOC_LARGE(ctx->etc_ref[i], ec_test_len);
+		OBD_ALLOC_LARGE(ctx->etc_out[i], ec_test_len);
+		if (!ctx->etc_ref[i] || !ctx->etc_out[i])
+			GOTO(out, rc = -ENOMEM);
+	}
+	OBD_ALLOC_LARGE(ctx->etc_delta, ec_test_len);
+	if (!ctx->etc_delta)
+		GOTO(out, rc = -ENOMEM);
+
+	pr_info("ec_test: active implementation %s\n",
+		ec_impl_active()->ei_name);
+
+	for (i = 0; (impl = ec_impl_get(i)) != NULL; i++) {
+		if (!impl->ei_available()) {
+			pr_info("ec_test: %s: not available\n", impl->ei_name);
+			continue;
+		}
+
+		for (g = 0; g < ARRAY_SIZE(geometries); g++) {
+			for (j = 0; j < ARRAY_SIZE(ec_test_lens); j++) {
+				rc = ec_test_verify(ctx, impl,
+						    geometries[g][0],
+						    geometries[g][1],
+						    ec_test_lens[j]);
+				if (rc)
+					GOTO(out, rc);
+			}
+		}
+
+		for (g = 0; g < ARRAY_SIZE(geometries); g++)
+			ec_test_perf(ctx, impl, geometries[g][0],
+				     geometries[g][1]);
+	}
+out:
+	ec_test_free(ctx);
+
+	return rc;
+}
+
+static void __exit ec_test_exit(void)
+{
+}
+
+MODULE_DESCRIPTION("Lustre erasure code verification and performance test");
+MODULE_LICENSE("GPL");
+
+module_init(ec_test_init);
+module_exit(ec_test_exit);
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+
+#include <libcfs/libcfs.h>
+#include <obd_support.h>
+#include <lustre_fid.h>
+#include "../../fld/fld_internal.h"
+
+/*
+ * Tests and lookup performance for the FLD cache
+ */
+
+/* every range is followed by a hole of the same size, so none is merged */
+#define NR_RANGES	4096
+#define RANGE_WIDTH	1024ULL
+
+static void test_range(int i, struct lu_seq_range *range)
+{
+	range->lsr_start = FID_SEQ_NORMAL + i * 2 * RANGE_WIDTH;
+	range->lsr_end = range->lsr_start + RANGE_WIDTH;
+	range->lsr_index = i % 64;
+	range->lsr_flags = LU_SEQ_RANGE_MDT;
+}
+
+static int check_lookup(struct fld_cache *cache, u64 seq, int exp_rc,
+			u32 exp_index)
+{
+	struct lu_seq_range range = { 0 };
+	int rc;
+
+	rc = fld_cache_lookup(cache, seq, &range);
+	if (rc != exp_rc || (rc == 0 && range.lsr_index != exp_index)) {
+		pr_err("fld_test: seq %#llx rc=%d index=%u, expected rc=%d index=%u\n",
+		       seq, rc, range.lsr_index, exp_rc, exp_index);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int check_ranges(struct fld_cache *cache)
+{
+	struct lu_seq_range range;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < NR_RANGES && rc == 0; i++) {
+		test_range(i, &range);
+		rc = check_lookup(cache, range.lsr_start, 0, range.lsr_index);
+		if (rc == 0)
+			rc = check_lookup(cache, range.lsr_end - 1, 0,
+					  range.lsr_index);
+		/* lsr_end is exclusive, the hole after it is not cached */
+		if (rc == 0)
+			rc = check_lookup(cache, range.lsr_end, -ENOENT, 0);
+	}
+
+	return rc;
+}
+
+/* ranges inserted one by one, in reverse order */
+static int test_insert(struct fld_cache *cache)
+{
+	struct lu_seq_range range;
+	int rc;
+	int i;
+
+	rc = check_lookup(cache, FID_SEQ_NORMAL, -ENOENT, 0);
+	for (i = NR_RANGES - 1; i >= 0 && rc == 0; i--) {
+		test_range(i, &range);
+		rc = fld_cache_insert(cache, &range);
+	}
+
+	return rc ?: check_ranges(cache);
+}
+
+/* ranges loaded at once, as from the FLDB */
+static int test_insert_sorted(struct fld_cache *cache)
+{
+	struct lu_seq_range *ranges;
+	int rc;
+	int i;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(ranges, NR_RANGES);
+	if (!ranges)
+		return -ENOMEM;
+
+	for (i = 0; i < NR_RANGES; i++)
+		test_range(i, &ranges[i]);
+	rc = fld_cache_insert_sorted(cache, ranges, NR_RANGES);
+	OBD_FREE_PTR_ARRAY_LARGE(ranges, NR_RANGES);
+
+	return rc ?: check_ranges(cache);
+}
+
+/* a migrated sub-range splits the range holding it in three */
+static int test_split(struct fld_cache *cache)
+{
+	struct lu_seq_range range;
+	u64 seq;
+	int rc;
+
+	test_range(0, &range);
+	seq = range.lsr_start;
+	range.lsr_start = seq + RANGE_WIDTH / 4;
+	range.lsr_end = seq + RANGE_WIDTH / 2;
+	range.lsr_index = 1000;
+
+	rc = fld_cache_insert(cache, &range);
+	if (rc == 0)
+		rc = check_lookup(cache, seq, 0, 0);
+	if (rc == 0)
+		rc = check_lookup(cache, seq + RANGE_WIDTH / 4, 0, 1000);
+	if (rc == 0)
+		rc = check_lookup(cache, seq + RANGE_WIDTH / 2, 0, 0);
+
+	return rc;
+}
+
+/* a range right after a range with the same index merges with it */
+static int test_merge(struct fld_cache *cache)
+{
+	struct lu_seq_range range;
+	u64 seq;
+	int rc;
+
+	test_range(NR_RANGES - 1, &range);
+	seq = range.lsr_start;
+	range.lsr_start = range.lsr_end;
+	range.lsr_end = range.lsr_start + RANGE_WIDTH;
+
+	rc = fld_cache_insert(cache, &range);
+	if (rc == 0)
+		rc = fld_cache_lookup(cache, seq, &range);
+	if (rc == 0 && (range.lsr_start != seq ||
+			range.lsr_end != seq + 2 * RANGE_WIDTH)) {
+		pr_err("fld_test: range "DRANGE" not merged\n",
+		       PRANGE(&range));
+		rc = -EINVAL;
+	}
+
+	return rc;
+}
+
+struct lookup_thread {
+	struct fld_cache	*lt_cache;
+	struct completion	 lt_done;
+	u64			 lt_lookups;
+	int			 lt_misses;
+};
+
+static int lookup_thread_main(void *arg)
+{
+	struct lookup_thread *lt = arg;
+	struct lu_seq_range range;
+	struct rnd_state rstate;
+	ktime_t start = ktime_get();
+	u64 seq;
+	int i;
+
+	prandom_seed_state(&rstate, (unsigned long)lt);
+	do {
+		for (i = 0; i < 1024; i++) {
+			seq = FID_SEQ_NORMAL + RANGE_WIDTH / 2 +
+			      (prandom_u32_state(&rstate) % NR_RANGES) *
+			      2 * RANGE_WIDTH;
+			if (fld_cache_lookup(lt->lt_cache, seq, &range))
+				lt->lt_misses++;
+		}
+		lt->lt_lookups += i;
+		cond_resched();
+	} while (ktime_to_ms(ktime_sub(ktime_get(), start)) < 1000);
+
+	complete(&lt->lt_done);
+	return 0;
+}
+
+/* lookups of \a nr threads sharing the cache for one second */
+static void test_lookup_perf(struct fld_cache *cache, int nr)
+{
+	struct lookup_thread *lt;
+	struct task_struct *task;
+	u64 lookups = 0;
+	int misses = 0;
+	int started;
+	int i;
+
+	OBD_ALLOC_PTR_ARRAY(lt, nr);
+	if (!lt)
+		return;
+
+	for (started = 0; started < nr; started++) {
+		lt[started].lt_cache = cache;
+		init_completion(&lt[started].lt_done);
+		task = kthread_run(lookup_thread_main, &lt[started],
+				   "fld_test_%d", started);
+		if (IS_ERR(task))
+			break;
+	}
+
+	for (i = 0; i < started; i++) {
+		wait_for_completion(&lt[i].lt_done);
+		lookups += lt[i].lt_lookups;
+		misses += lt[i].lt_misses;
+	}
+
+	/* each thread looks up for a second */
+	pr_info("fld_test: threads=%d lookups/s=%llu misses=%d\n",
+		started, lookups, misses);
+
+	OBD_FREE_PTR_ARRAY(lt, nr);
+}
+
+static int fld_test_init(void)
+{
+	struct fld_cache *cache;
+	int rc;
+	int nr;
+
+	/* room for all the ranges, the cache must not shrink */
+	cache = fld_cache_init("fld_test", NR_RANGES * 2, NR_RANGES / 10);
+	if (IS_ERR(cache))
+		return PTR_ERR(cache);
+
+	rc = test_insert(cache);
+	if (rc == 0)
+		rc = test_split(cache);
+	if (rc == 0)
+		rc = test_merge(cache);
+	fld_cache_fini(cache);
+	if (rc)
+		goto out;
+
+	cache = fld_cache_init("fld_test", NR_RANGES * 2, NR_RANGES / 10);
+	if (IS_ERR(cache))
+		return PTR_ERR(cache);
+
+	rc = test_insert_sorted(cache);
+	if (rc == 0) {
+		for (nr = 1; nr < num_online_cpus(); nr *= 2)
+			test_lookup_perf(cache, nr);
+		test_lookup_perf(cache, num_online_cpus());
+	}
+	fld_cache_fini(cache);
+out:
+	pr_info("fld_test: verification %s\n", rc ? "failed" : "passed");
+
+	return rc ? -EINVAL : 0;
+}
+
+static void fld_test_exit(void)
+{
+}
+
+MODULE_DESCRIPTION("Lustre FLD cache test");
+MODULE_LICENSE("GPL");
+
+module_init(fld_test_init);
+module_exit(fld_test_exit);
@@ -80,6 +80,73 @@ static void test_one(struct ldlm_resource *res,
 	}
 }
 
+/*
+ * N-to-1 shared file writes: every rank waits behind a whole file lock for
+ * its own stripe of the file, so each enqueue checks the waiting queue for
+ * conflicts without finding any.
+ */
+static void test_waiting(struct ldlm_namespace *ns, int nr)
+{
+	struct ldlm_res_id res_id = { .name = {5, 6, 7, 8} };
+	struct ldlm_resource *res;
+	struct ldlm_lock **locks;
+	ldlm_processing_policy pol;
+	enum ldlm_error err;
+	ktime_t start;
+	__u64 flags;
+	u64 pos;
+	long nsec;
+	int i;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(locks, nr + 1);
+	if (!locks)
+		return;
+
+	res = ldlm_resource_get(ns, &res_id, LDLM_EXTENT, 1);
+	if (IS_ERR(res))
+		goto out_free;
+	pol = ldlm_get_processing_policy(res);
+
+	start = ktime_get();
+	for (i = 0; i <= nr; i++) {
+		struct ldlm_lock *lock = ldlm_lock_new_testing(res);
+
+		refcount_inc(&res->lr_refcount);
+		lock->l_req_mode = LCK_PW;
+		if (i == 0) {
+			lock->l_policy_data.l_extent.start = 0;
+			lock->l_policy_data.l_extent.end = OBD_OBJECT_EOF;
+		} else {
+			pos = (u64)i * PAGE_SIZE;
+			lock->l_policy_data.l_extent.start = pos;
+			lock->l_policy_data.l_extent.end = pos + PAGE_SIZE - 1;
+		}
+		lock->l_policy_data.l_extent.gid = 0;
+		lock->l_req_extent = lock->l_policy_data.l_extent;
+		locks[i] = lock;
+
+		flags = 0;
+		lock_res(res);
+		pol(lock, &flags, LDLM_PROCESS_ENQUEUE, &err, NULL);
+		if (!ldlm_is_granted(lock))
+			ldlm_resource_add_lock(res, &res->lr_waiting, lock);
+		unlock_res(res);
+		cond_resched();
+	}
+	nsec = ktime_to_ns(ktime_sub(ktime_get(), start)) / nr;
+
+	pr_info("ldlm_extent: test waiting locks=%d ns/enqueue=%lu\n",
+		nr, nsec);
+
+	for (i = 0; i <= nr; i++) {
+		ldlm_lock_cancel(locks[i]);
+		ldlm_lock_put(locks[i]);
+	}
+	ldlm_resource_putref(res);
+out_free:
+	OBD_FREE_PTR_ARRAY_LARGE(locks, nr + 1);
+}
+
 enum tests {
 	TEST_NO_OVERLAP,
 	TEST_WHOLE_FILE,
@@ -96,6 +163,7 @@ static int ldlm_extent_init(void)
 	struct ldlm_resource *res;
 	struct obd_device *obd;
 	struct ldlm_namespace *ns;
+	struct ldlm_namespace *ns_srv;
 	enum tests tnum;
 	struct rnd_state rstate;
 
@@ -215,6 +283,19 @@ static int ldlm_extent_init(void)
 		       tnum, loops, min_iters, sum / loops,
 		       int_sqrt((sumsq - sum*sum/loops) / loops-1));
 	}
+
+	/* the waiting queue is only checked for conflicts on the server */
+	ns_srv = ldlm_namespace_new(obd, "extent-test-srv",
+				    LDLM_NAMESPACE_SERVER,
+				    LDLM_NAMESPACE_MODEST,
+				    LDLM_NS_TYPE_OST);
+	if (!IS_ERR(ns_srv)) {
+		test_waiting(ns_srv, 1000);
+		test_waiting(ns_srv, 10000);
+		test_waiting(ns_srv, 100000);
+		ldlm_namespace_free_post(ns_srv);
+	}
+
 	class_detach(obd, cfg);
 
 	OBD_FREE(name, MAX_OBD_NAME);
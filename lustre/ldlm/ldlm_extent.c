@@ -41,6 +41,17 @@
 INTERVAL_TREE_DEFINE(struct ldlm_lock, l_rb, u64, l_subtree_last,
 		     START, LAST, static inline, extent);
 
+static inline int ldlm_mode_to_index(enum ldlm_mode mode)
+{
+	int index;
+
+	LASSERT(mode != 0);
+	LASSERT(is_power_of_2(mode));
+	index = ilog2(mode);
+	LASSERT(index < LCK_MODE_NUM);
+	return index;
+}
+
 static inline struct ldlm_lock *extent_next_lock(struct ldlm_lock *lock)
 {
 	lock = list_next_entry(lock, l_same_extent);
@@ -457,6 +468,138 @@ static bool ldlm_extent_compat_cb(struct ldlm_lock *lock, void *data)
 	RETURN(false);
 }
 
+struct ldlm_extent_waiting_args {
+	struct list_head *work_list;
+	struct ldlm_lock *lock;
+	__u64 flags;
+	/* only locks queued before this one are considered */
+	__u64 seq;
+	int *locks;
+	int compat;
+};
+
+/* Find the first compatible waiting lock covering the PR request */
+static bool ldlm_extent_waiting_cover_cb(struct ldlm_lock *lock, void *data)
+{
+	struct ldlm_extent_waiting_args *priv = data;
+	struct ldlm_extent *req_ex = &priv->lock->l_policy_data.l_extent;
+
+	if (lock->l_wait_seq < priv->seq && !ldlm_is_ast_sent(lock) &&
+	    lock->l_policy_data.l_extent.start <= req_ex->start &&
+	    lock->l_policy_data.l_extent.end >= req_ex->end)
+		priv->seq = lock->l_wait_seq;
+
+	return false;
+}
+
+static bool ldlm_extent_waiting_compat_cb(struct ldlm_lock *lock, void *data)
+{
+	struct ldlm_extent_waiting_args *priv = data;
+	struct ldlm_lock *req = priv->lock;
+
+	if (lock->l_wait_seq >= priv->seq)
+		return false;
+
+	priv->compat = 0;
+	if (!priv->work_list)
+		return true;
+
+	if (priv->flags & LDLM_FL_SPECULATIVE) {
+		priv->compat = -EAGAIN;
+		return true;
+	}
+
+	/* don't count false contention or conflicting glimpse locks */
+	if (ldlm_extent_overlap(&lock->l_req_extent, &req->l_req_extent) &&
+	    !(lock->l_req_mode == LCK_PR &&
+	      lock->l_policy_data.l_extent.start == 0 &&
+	      lock->l_policy_data.l_extent.end == OBD_OBJECT_EOF))
+		*priv->locks += 1;
+
+	if (lock->l_blocking_ast)
+		ldlm_add_ast_work_item(lock, req, priv->work_list);
+
+	return false;
+}
+
+/* Waiting group locks have to be ordered against the request by walking the
+ * queue, otherwise the interval trees of waiting locks can be used.
+ */
+static bool ldlm_extent_waiting_indexed(struct ldlm_lock *req)
+{
+	struct ldlm_extent_queues *leq = req->l_resource->lr_extent_queues;
+
+	return leq != NULL && req->l_req_mode != LCK_GROUP &&
+	       leq->leq_waiting[ldlm_mode_to_index(LCK_GROUP)].lit_size == 0;
+}
+
+/**
+ * Check \a req against the waiting locks queued before it, using the interval
+ * trees of waiting locks. This gives the same result as walking lr_waiting in
+ * ldlm_extent_compat_queue() for a non-group request.
+ *
+ * \param[out] covered set if a compatible waiting lock covers \a req, in which
+ *		       case the locks queued after that one are not checked
+ *
+ * \retval 0 if the lock is not compatible
+ * \retval 1 if the lock is compatible
+ * \retval -EAGAIN if a conflict is found for a speculative request
+ */
+static int ldlm_extent_compat_waiting(struct ldlm_lock *req, __u64 flags,
+				      struct list_head *work_list,
+				      int *contended_locks, bool *covered)
+{
+	struct ldlm_extent_queues *leq = req->l_resource->lr_extent_queues;
+	enum ldlm_mode req_mode = req->l_req_mode;
+	struct ldlm_extent_waiting_args data = { .work_list = work_list,
+						 .lock = req,
+						 .flags = flags,
+						 .seq = U64_MAX,
+						 .locks = contended_locks,
+						 .compat = 1 };
+	struct ldlm_interval_tree *tree;
+	int idx;
+
+	/* we stop at ourselves if we are already waiting */
+	if (!list_empty(&req->l_res_link))
+		data.seq = req->l_wait_seq;
+
+	/* a PR lock just like us or wider lets us skip the rest of the
+	 * queue, see the comment in ldlm_extent_compat_queue()
+	 */
+	if (req_mode == LCK_PR) {
+		__u64 seq = data.seq;
+
+		for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+			tree = &leq->leq_waiting[idx];
+			if (INTERVAL_TREE_EMPTY(&tree->lit_root) ||
+			    !lockmode_compat(tree->lit_mode, req_mode))
+				continue;
+
+			ldlm_extent_search(&tree->lit_root,
+					   req->l_policy_data.l_extent.start,
+					   req->l_policy_data.l_extent.end,
+					   ldlm_extent_waiting_cover_cb, &data);
+		}
+		*covered = data.seq != seq;
+	}
+
+	for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+		tree = &leq->leq_waiting[idx];
+		if (INTERVAL_TREE_EMPTY(&tree->lit_root) ||
+		    lockmode_compat(tree->lit_mode, req_mode))
+			continue;
+
+		ldlm_extent_search(&tree->lit_root, req->l_req_extent.start,
+				   req->l_req_extent.end,
+				   ldlm_extent_waiting_compat_cb, &data);
+		if (data.compat < 0 || (data.compat == 0 && !work_list))
+			break;
+	}
+
+	return data.compat;
+}
+
 /**
  * Determine if the lock is compatible with all locks on the queue.
  *
@@ -564,6 +707,15 @@ ldlm_extent_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 					compat = 0;
 			}
 		}
+	} else if (ldlm_extent_waiting_indexed(req)) {
+		bool covered = false;
+
+		compat = ldlm_extent_compat_waiting(req, *flags, work_list,
+						    contended_locks, &covered);
+		if (compat < 0)
+			goto destroylock;
+		if (covered || (compat == 0 && !work_list))
+			RETURN(compat);
 	} else { /* for waiting queue */
 		list_for_each_entry(lock, queue, l_res_link) {
 			check_contention = 1;
@@ -734,7 +886,7 @@ ldlm_extent_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 
 	RETURN(compat);
 destroylock:
-	list_del_init(&req->l_res_link);
+	ldlm_resource_unlink_lock(req);
 	if (ldlm_is_local(req))
 		ldlm_lock_decref_internal_nolock(req, req_mode);
 	ldlm_lock_destroy_nolock(req);
@@ -897,8 +1049,9 @@ int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 	}
 
 	if (rc + rc2 == 2) {
-		ldlm_extent_policy(res, lock, flags);
+		/* unlink first, the extent is the key of the waiting tree */
 		ldlm_resource_unlink_lock(lock);
+		ldlm_extent_policy(res, lock, flags);
 		ldlm_grant_lock(lock, grant_work);
 	} else {
 		/* Adding LDLM_FL_NO_TIMEOUT flag to granted lock to
@@ -1007,17 +1160,6 @@ __u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
 }
 EXPORT_SYMBOL(ldlm_extent_shift_kms);
 
-static inline int ldlm_mode_to_index(enum ldlm_mode mode)
-{
-	int index;
-
-	LASSERT(mode != 0);
-	LASSERT(is_power_of_2(mode));
-	index = ilog2(mode);
-	LASSERT(index < LCK_MODE_NUM);
-	return index;
-}
-
 /** Add newly granted lock into interval tree for the resource. */
 void ldlm_extent_add_lock(struct ldlm_resource *res,
 			  struct ldlm_lock *lock)
@@ -1067,7 +1209,41 @@ void ldlm_extent_add_lock(struct ldlm_resource *res,
 	}
 }
 
-/** Remove cancelled lock from resource interval tree. */
+/**
+ * Add a lock queued into lr_waiting on the server into the interval tree of
+ * waiting locks with the same requested mode.
+ *
+ * Non-group locks are only added at the tail of lr_waiting, so l_wait_seq
+ * follows their order in the queue. Group locks can be inserted in the middle
+ * of it, but the trees are not used for conflict checks while any group lock
+ * is waiting, see ldlm_extent_waiting_indexed().
+ */
+void ldlm_extent_add_waiting_lock(struct ldlm_resource *res,
+				  struct list_head *head,
+				  struct ldlm_lock *lock)
+{
+	struct ldlm_extent_queues *leq = res->lr_extent_queues;
+	struct ldlm_interval_tree *tree;
+	struct ldlm_lock *orig;
+	int idx;
+
+	if (leq == NULL || head == &res->lr_granted || !ldlm_is_ns_srv(lock))
+		return;
+
+	LASSERT(!ldlm_is_granted(lock));
+	LASSERT(RB_EMPTY_NODE(&lock->l_rb));
+	LASSERT(list_empty(&lock->l_same_extent));
+
+	idx = ldlm_mode_to_index(lock->l_req_mode);
+	tree = &leq->leq_waiting[idx];
+	lock->l_wait_seq = ++leq->leq_seq;
+	orig = extent_insert_unique(lock, &tree->lit_root);
+	if (orig)
+		list_add_tail(&lock->l_same_extent, &orig->l_same_extent);
+	tree->lit_size++;
+}
+
+/** Remove cancelled or granted lock from resource interval tree. */
 void ldlm_extent_unlink_lock(struct ldlm_lock *lock)
 {
 	struct ldlm_resource *res = lock->l_resource;
@@ -1078,9 +1254,16 @@ void ldlm_extent_unlink_lock(struct ldlm_lock *lock)
 	    list_empty(&lock->l_same_extent)) /* duplicate unlink */
 		return;
 
-	idx = ldlm_mode_to_index(lock->l_granted_mode);
-	LASSERT(lock->l_granted_mode == BIT(idx));
-	tree = &res->lr_itree[idx];
+	if (ldlm_is_granted(lock)) {
+		idx = ldlm_mode_to_index(lock->l_granted_mode);
+		LASSERT(lock->l_granted_mode == BIT(idx));
+		tree = &res->lr_itree[idx];
+	} else {
+		/* only waiting locks on the server are in a tree */
+		LASSERT(res->lr_extent_queues != NULL);
+		idx = ldlm_mode_to_index(lock->l_req_mode);
+		tree = &res->lr_extent_queues->leq_waiting[idx];
+	}
 
 	LASSERT(!INTERVAL_TREE_EMPTY(&tree->lit_root));
 
@@ -492,6 +492,8 @@ struct ldlm_lock *ldlm_lock_new_testing(struct ldlm_resource *resource)
 	if (!lock)
 		return NULL;
 	lock->l_flags |= BIT(63);
+	if (ns_is_server(ldlm_res_to_ns(resource)))
+		ldlm_set_ns_srv(lock);
 	switch (resource->lr_type) {
 	case LDLM_IBITS:
 		rc = ldlm_inodebits_alloc_lock(lock);
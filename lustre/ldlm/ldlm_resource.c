@@ -1408,8 +1408,10 @@ struct ldlm_namespace *ldlm_namespace_first_locked(enum ldlm_side client)
 			    struct ldlm_namespace, ns_list_chain);
 }
 
-static bool ldlm_resource_extent_new(struct ldlm_resource *res)
+static bool ldlm_resource_extent_new(struct ldlm_namespace *ns,
+				     struct ldlm_resource *res)
 {
+	struct ldlm_extent_queues *leq;
 	int idx;
 
 	OBD_SLAB_ALLOC(res->lr_itree, ldlm_interval_tree_slab,
@@ -1422,6 +1424,23 @@ static bool ldlm_resource_extent_new(struct ldlm_resource *res)
 		res->lr_itree[idx].lit_mode = BIT(idx);
 		res->lr_itree[idx].lit_root = INTERVAL_TREE_ROOT;
 	}
+
+	/* only the server checks waiting locks for conflicts */
+	res->lr_extent_queues = NULL;
+	if (!ns_is_server(ns))
+		return true;
+
+	OBD_ALLOC_PTR(leq);
+	if (leq == NULL) {
+		OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
+			      sizeof(*res->lr_itree) * LCK_MODE_NUM);
+		return false;
+	}
+	for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+		leq->leq_waiting[idx].lit_mode = BIT(idx);
+		leq->leq_waiting[idx].lit_root = INTERVAL_TREE_ROOT;
+	}
+	res->lr_extent_queues = leq;
 	return true;
 }
 
@@ -1447,7 +1466,8 @@ static bool ldlm_resource_flock_new(struct ldlm_resource *res)
 }
 
 /** Create and initialize new resource. */
-static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
+static struct ldlm_resource *ldlm_resource_new(struct ldlm_namespace *ns,
+					       enum ldlm_type ldlm_type)
 {
 	struct ldlm_resource *res;
 	bool rc;
@@ -1458,7 +1478,7 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 
 	switch (ldlm_type) {
 	case LDLM_EXTENT:
-		rc = ldlm_resource_extent_new(res);
+		rc = ldlm_resource_extent_new(ns, res);
 		break;
 	case LDLM_IBITS:
 		rc = ldlm_resource_inodebits_new(res);
@@ -1505,6 +1525,7 @@ static void ldlm_resource_free(struct ldlm_resource *res)
 		if (res->lr_itree != NULL)
 			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
 				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
+		OBD_FREE_PTR(res->lr_extent_queues);
 	} else if (res->lr_type == LDLM_IBITS) {
 		OBD_FREE_PTR(res->lr_ibits_queues);
 	}
@@ -1548,7 +1569,7 @@ ldlm_resource_get(struct ldlm_namespace *ns, const struct ldlm_res_id *name,
 
 	LASSERTF(type >= LDLM_TYPE_MIN && type < LDLM_TYPE_END,
 		 "type: %d\n", type);
-	res = ldlm_resource_new(type);
+	res = ldlm_resource_new(ns, type);
 	if (res == NULL)
 		return ERR_PTR(-ENOMEM);
 
@@ -1679,6 +1700,8 @@ static void __ldlm_resource_add_lock(struct ldlm_resource *res,
 
 	if (res->lr_type == LDLM_IBITS)
 		ldlm_inodebits_add_lock(res, head, lock, tail);
+	else if (res->lr_type == LDLM_EXTENT)
+		ldlm_extent_add_waiting_lock(res, head, lock);
 	else if (res->lr_type == LDLM_FLOCK)
 		LASSERT(lock->l_req_mode != LCK_NL || head != &res->lr_waiting);
 
@@ -1693,6 +1716,7 @@ void ldlm_resource_add_lock(struct ldlm_resource *res, struct list_head *head,
 
 	__ldlm_resource_add_lock(res, head, lock, true);
 }
+EXPORT_SYMBOL(ldlm_resource_add_lock);
 
 /* Insert a lock into resource after specified lock. */
 void ldlm_resource_insert_lock_after(struct ldlm_lock *original,
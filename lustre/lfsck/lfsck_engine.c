@@ -1120,16 +1120,102 @@ fini_args:
 	return rc;
 }
 
-static inline bool lfsck_assistant_req_empty(struct lfsck_assistant_data *lad)
+/*
+ * The oldest request of lad_req_list that can be handled now. A serial
+ * request waits for all the requests before it to be done, and the ones
+ * after it wait for it in turn.
+ */
+static struct lfsck_assistant_req *
+lfsck_assistant_req_next(struct lfsck_assistant_data *lad)
 {
-	bool empty = false;
+	struct lfsck_assistant_req *lar;
+
+	assert_spin_locked(&lad->lad_lock);
+	list_for_each_entry(lar, &lad->lad_req_list, lar_list) {
+		if (lar->lar_busy) {
+			if (lar->lar_serial)
+				return NULL;
+			continue;
+		}
+
+		if (lar->lar_serial && lad->lad_in_flight > 0)
+			return NULL;
+
+		return lar;
+	}
+
+	return NULL;
+}
+
+/* Whether some request of lad_req_list can be handled now. */
+static inline bool lfsck_assistant_req_ready(struct lfsck_assistant_data *lad)
+{
+	bool ready;
 
 	spin_lock(&lad->lad_lock);
-	if (list_empty(&lad->lad_req_list))
-		empty = true;
+	ready = lfsck_assistant_req_next(lad) != NULL;
 	spin_unlock(&lad->lad_lock);
 
-	return empty;
+	return ready;
+}
+
+/*
+ * Take the oldest request that can be handled. It stays in lad_req_list
+ * until it is handled, so that la_fill_pos() still finds the oldest
+ * unfinished request.
+ */
+static struct lfsck_assistant_req *
+lfsck_assistant_req_claim(struct lfsck_assistant_data *lad)
+{
+	struct lfsck_assistant_req *lar;
+
+	spin_lock(&lad->lad_lock);
+	lar = lfsck_assistant_req_next(lad);
+	if (lar != NULL) {
+		lar->lar_busy = true;
+		lad->lad_in_flight++;
+	}
+	spin_unlock(&lad->lad_lock);
+
+	return lar;
+}
+
+static void lfsck_assistant_req_done(const struct lu_env *env,
+				     struct lfsck_component *com,
+				     struct lfsck_assistant_req *lar,
+				     bool helper)
+{
+	struct lfsck_instance *lfsck = com->lc_lfsck;
+	struct lfsck_bookmark *bk = &lfsck->li_bookmark_ram;
+	struct lfsck_assistant_data *lad = com->lc_data;
+	bool wakeup = false;
+	bool empty;
+	bool idle;
+
+	spin_lock(&lad->lad_lock);
+	list_del_init(&lar->lar_list);
+	lad->lad_prefetched--;
+	lad->lad_in_flight--;
+	idle = lad->lad_in_flight == 0;
+	if (helper)
+		lad->lad_helper_handled++;
+	/* Wake up the main engine thread only when the list
+	 * is empty or half of the prefetched items have been
+	 * handled to avoid too frequent thread schedule.
+	 */
+	if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
+		wakeup = true;
+	empty = list_empty(&lad->lad_req_list);
+	spin_unlock(&lad->lad_lock);
+	if (wakeup)
+		wake_up(&lfsck->li_thread.t_ctl_waitq);
+	/* the assistant may wait for the helpers to post, and a serial
+	 * request waits for the others in flight
+	 */
+	if ((empty || idle) && lad->lad_helpers > 0)
+		wake_up_all(&lad->lad_thread.t_ctl_waitq);
+
+	lad->lad_ops->la_req_fini(env, lar);
 }
 
 /**
@@ -1559,6 +1645,12 @@ again:
  * LFSCK assistant thread. So under such 1:N multiple asynchronous
  * pipelines mode, the whole LFSCK performance will be much better
  * than check/repair everything by the LFSCK main engine itself.
+ *
+ * If the component allows it (lad_parallel), the assistant thread also
+ * starts lb_assistant_threads - 1 helper threads to handle the phase1
+ * requests together with it, since every check may wait for a remote
+ * server. The requests marked as lar_serial are still handled alone and
+ * in order.
  */
 int lfsck_assistant_engine(void *args)
 {
@@ -1606,51 +1698,45 @@ int lfsck_assistant_engine(void *args)
 	spin_unlock(&lad->lad_lock);
 	wake_up(&mthread->t_ctl_waitq);
 
-	while (1) {
-		while (!list_empty(&lad->lad_req_list)) {
-			bool wakeup = false;
+	rc2 = lfsck_start_assistant_helpers(com);
+	if (rc2 > 0)
+		CDEBUG(D_LFSCK, "%s: %s LFSCK assistant started %d helpers\n",
+		       lfsck_lfsck2name(lfsck), lad->lad_name, rc2);
 
+	while (1) {
+		while (lfsck_assistant_req_ready(lad)) {
 			if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags) ||
 				     !thread_is_running(mthread)))
 				GOTO(cleanup, rc = lad->lad_post_result);
 
-			lar = list_first_entry(&lad->lad_req_list,
-					       struct lfsck_assistant_req,
-					       lar_list);
-			/* Only the lfsck_assistant_engine thread itself can
-			 * remove the "lar" from the head of the list, LFSCK
-			 * engine thread only inserts other new "lar" at the
-			 * end of the list. So it is safe to handle current
-			 * "lar" without the spin_lock.
-			 */
-			rc = lao->la_handler_p1(env, com, lar);
-			spin_lock(&lad->lad_lock);
-			list_del_init(&lar->lar_list);
-			lad->lad_prefetched--;
-			/* Wake up the main engine thread only when the list
-			 * is empty or half of the prefetched items have been
-			 * handled to avoid too frequent thread schedule.
-			 */
-			if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
-				wakeup = true;
-			spin_unlock(&lad->lad_lock);
-			if (wakeup)
-				wake_up(&mthread->t_ctl_waitq);
+			/* The helpers may have taken the last requests. */
+			lar = lfsck_assistant_req_claim(lad);
+			if (lar == NULL)
+				break;
 
-			lao->la_req_fini(env, lar);
+			rc = lao->la_handler_p1(env, com, lar);
+			lfsck_assistant_req_done(env, com, lar, false);
 			if (rc < 0 && bk->lb_param & LPF_FAILOUT)
 				GOTO(cleanup, rc);
 		}
 
+		/* The requests being handled by the helpers have to be done
+		 * before the post or the double scan.
+		 */
 		wait_event_idle(athread->t_ctl_waitq,
-				!lfsck_assistant_req_empty(lad) ||
+				lfsck_assistant_req_ready(lad) ||
+				lad->lad_helper_status < 0 ||
 				test_bit(LAD_EXIT, &lad->lad_flags) ||
-				test_bit(LAD_TO_POST, &lad->lad_flags) ||
-				test_bit(LAD_TO_DOUBLE_SCAN, &lad->lad_flags));
+				(list_empty(&lad->lad_req_list) &&
+				 (test_bit(LAD_TO_POST, &lad->lad_flags) ||
+				  test_bit(LAD_TO_DOUBLE_SCAN, &lad->lad_flags))));
 
 		if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags)))
 			GOTO(cleanup, rc = lad->lad_post_result);
 
+		if (unlikely(lad->lad_helper_status < 0))
+			GOTO(cleanup, rc = lad->lad_helper_status);
+
 		if (!list_empty(&lad->lad_req_list))
 			continue;
 
@@ -1661,6 +1747,8 @@ int lfsck_assistant_engine(void *args)
 			if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags)))
 				GOTO(cleanup, rc = lad->lad_post_result);
 
+			/* No more phase1 request, the helpers are idle. */
+			lfsck_stop_assistant_helpers(com);
 			clear_bit(LAD_TO_POST, &lad->lad_flags);
 			LASSERT(lad->lad_post_result > 0);
 
@@ -1750,6 +1838,9 @@ p2_next:
 	}
 
 cleanup:
+	/* Wait for the requests being handled by the helpers. */
+	lfsck_stop_assistant_helpers(com);
+
 	/* Cleanup the unfinished requests. */
 	spin_lock(&lad->lad_lock);
 	if (rc < 0)
@@ -1858,3 +1949,63 @@ fini:
 
 	return rc;
 }
+
+/**
+ * LFSCK assistant helper thread.
+ *
+ * It handles the phase1 requests of the lfsck_assistant_engine() thread
+ * in parallel with it. The assistant thread stops its helpers before the
+ * post of phase1, and on exit.
+ *
+ * \param[in] args	pointer to the lfsck_thread_args
+ *
+ * \retval		0 for success
+ * \retval		negative error number on failure
+ */
+int lfsck_assistant_helper(void *args)
+{
+	struct lfsck_thread_args *lta = args;
+	struct lu_env *env = &lta->lta_env;
+	struct lfsck_component *com = lta->lta_com;
+	struct lfsck_instance *lfsck = lta->lta_lfsck;
+	struct lfsck_bookmark *bk = &lfsck->li_bookmark_ram;
+	struct lfsck_assistant_data *lad = com->lc_data;
+	struct ptlrpc_thread *athread = &lad->lad_thread;
+	struct lfsck_assistant_req *lar;
+	int rc = 0;
+
+	ENTRY;
+	while (1) {
+		wait_event_idle(athread->t_ctl_waitq,
+				lfsck_assistant_req_ready(lad) ||
+				test_bit(LAD_HELPER_STOP, &lad->lad_flags) ||
+				test_bit(LAD_EXIT, &lad->lad_flags));
+
+		if (test_bit(LAD_HELPER_STOP, &lad->lad_flags) ||
+		    test_bit(LAD_EXIT, &lad->lad_flags))
+			break;
+
+		lar = lfsck_assistant_req_claim(lad);
+		if (lar == NULL)
+			continue;
+
+		rc = lad->lad_ops->la_handler_p1(env, com, lar);
+		lfsck_assistant_req_done(env, com, lar, true);
+		if (rc < 0 && bk->lb_param & LPF_FAILOUT) {
+			spin_lock(&lad->lad_lock);
+			if (lad->lad_helper_status == 0)
+				lad->lad_helper_status = rc;
+			spin_unlock(&lad->lad_lock);
+			break;
+		}
+	}
+
+	spin_lock(&lad->lad_lock);
+	lad->lad_helpers--;
+	spin_unlock(&lad->lad_lock);
+	wake_up_all(&athread->t_ctl_waitq);
+
+	lfsck_thread_args_fini(lta);
+
+	RETURN(rc);
+}
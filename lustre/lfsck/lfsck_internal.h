@@ -27,6 +27,8 @@
 #include <lustre_linkea.h>
 
 #define LFSCK_CHECKPOINT_INTERVAL	60
+#define LFSCK_CHECKPOINT_SKIP		1
+#define LFSCK_ASSISTANT_THREADS_MAX	32
 
 enum lfsck_flags {
 	/* Finish the first cycle scanning. */
@@ -72,8 +74,8 @@ struct lfsck_bookmark {
 	/* The windows size for async requests pipeline. */
 	__u16	lb_async_windows;
 
-	/* For 64-bits aligned. */
-	__u16	lb_padding;
+	/* Phase1 assistant threads per LFSCK component, 0 as 1. */
+	__u16	lb_assistant_threads;
 
 	/* The FID for .lustre/lost+found/MDTxxxx */
 	struct lu_fid	lb_lpf_fid;
@@ -764,6 +766,10 @@ struct lfsck_thread_args {
 struct lfsck_assistant_req {
 	struct list_head		 lar_list;
 	struct lfsck_assistant_object	*lar_parent;
+	/* being handled, but still in lad_req_list for la_fill_pos() */
+	bool				 lar_busy;
+	/* handled alone, after all the earlier requests are done */
+	bool				 lar_serial;
 };
 
 struct lfsck_namespace_req {
@@ -843,10 +849,19 @@ struct lfsck_assistant_data {
 
 	__u32					 lad_touch_gen;
 	int					 lad_prefetched;
+	/* requests of lad_req_list being handled */
+	int					 lad_in_flight;
+	/* helper threads handling phase1 requests in parallel */
+	int					 lad_helpers;
+	int					 lad_helper_status;
+	/* phase1 requests handled by the helpers since the start */
+	__u64					 lad_helper_handled;
 	int					 lad_assistant_status;
 	int					 lad_post_result;
 	unsigned long				 lad_flags;
 	bool					 lad_advance_lock;
+	/* la_handler_p1() can run for several requests at once */
+	bool					 lad_parallel;
 };
 enum {
 	LAD_TO_POST = 0,
@@ -854,6 +869,7 @@ enum {
 	LAD_IN_DOUBLE_SCAN = 2,
 	LAD_EXIT = 3,
 	LAD_INCOMPLETE = 4,
+	LAD_HELPER_STOP = 5,
 };
 
 #define LFSCK_TMPBUF_LEN	64
@@ -943,6 +959,9 @@ void lfsck_pos_dump(struct seq_file *m, struct lfsck_position *pos,
 		    const char *prefix);
 void lfsck_pos_fill(const struct lu_env *env, struct lfsck_instance *lfsck,
 		    struct lfsck_position *pos, bool init);
+void lfsck_progress_dump(const struct lu_env *env, struct seq_file *m,
+			 struct lfsck_instance *lfsck, __u64 pos,
+			 time64_t rtime);
 bool __lfsck_set_speed(struct lfsck_instance *lfsck, __u32 limit);
 void lfsck_control_speed(struct lfsck_instance *lfsck);
 void lfsck_control_speed_by_self(struct lfsck_component *com);
@@ -969,6 +988,8 @@ int lfsck_async_request(const struct lu_env *env, struct obd_export *exp,
 int lfsck_query_all(const struct lu_env *env, struct lfsck_component *com);
 int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 			  struct lfsck_start_param *lsp);
+int lfsck_start_assistant_helpers(struct lfsck_component *com);
+void lfsck_stop_assistant_helpers(struct lfsck_component *com);
 int lfsck_checkpoint_generic(const struct lu_env *env,
 			     struct lfsck_component *com);
 void lfsck_post_generic(const struct lu_env *env,
@@ -997,6 +1018,7 @@ int lfsck_open_dir(const struct lu_env *env,
 		   struct lfsck_instance *lfsck, __u64 cookie);
 int lfsck_master_engine(void *args);
 int lfsck_assistant_engine(void *args);
+int lfsck_assistant_helper(void *args);
 
 /* lfsck_bookmark.c */
 void lfsck_bookmark_cpu_to_le(struct lfsck_bookmark *des,
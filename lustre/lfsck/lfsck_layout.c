@@ -5736,7 +5736,7 @@ static int lfsck_layout_scan_stripes(const struct lu_env *env,
 		}
 
 		list_add_tail(&llr->llr_lar.lar_list, &lad->lad_req_list);
-		if (lad->lad_prefetched == 0)
+		if (lad->lad_prefetched == lad->lad_in_flight)
 			wakeup = true;
 
 		lad->lad_prefetched++;
@@ -6266,6 +6266,14 @@ static void lfsck_layout_dump(const struct lu_env *env,
 		   lo->ll_objs_failed_phase1,
 		   lo->ll_objs_failed_phase2);
 
+	if (lfsck->li_master) {
+		struct lfsck_assistant_data *lad = com->lc_data;
+
+		/* phase1 requests handled by the helpers of the last run */
+		seq_printf(m, "assistant_helper_handled: %llu\n",
+			   lad->lad_helper_handled);
+	}
+
 	if (lo->ll_status == LS_SCANNING_PHASE1) {
 		time64_t duration = ktime_get_seconds() -
 				    lfsck->li_time_last_checkpoint;
@@ -6312,6 +6320,7 @@ static void lfsck_layout_dump(const struct lu_env *env,
 		}
 
 		seq_printf(m, "current_position: %llu\n", pos);
+		lfsck_progress_dump(env, m, lfsck, pos, rtime);
 	} else if (lo->ll_status == LS_SCANNING_PHASE2) {
 		time64_t duration = ktime_get_seconds() -
 				    com->lc_time_last_checkpoint;
@@ -7063,13 +7072,18 @@ int lfsck_layout_setup(const struct lu_env *env, struct lfsck_instance *lfsck)
 	com->lc_lfsck = lfsck;
 	com->lc_type = LFSCK_TYPE_LAYOUT;
 	if (lfsck->li_master) {
+		struct lfsck_assistant_data *lad;
+
 		com->lc_ops = &lfsck_layout_master_ops;
-		com->lc_data = lfsck_assistant_data_init(
-				&lfsck_layout_assistant_ops,
-				LFSCK_LAYOUT);
-		if (com->lc_data == NULL)
+		lad = lfsck_assistant_data_init(&lfsck_layout_assistant_ops,
+						LFSCK_LAYOUT);
+		if (lad == NULL)
 			GOTO(out, rc = -ENOMEM);
 
+		/* every OST-object is checked independently */
+		lad->lad_parallel = true;
+		com->lc_data = lad;
+
 		for (i = 0; i < LFSCK_STF_COUNT; i++)
 			mutex_init(&com->lc_sub_trace_objs[i].lsto_mutex);
 	} else {
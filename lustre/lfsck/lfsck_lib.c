@@ -27,8 +27,6 @@
 
 #include "lfsck_internal.h"
 
-#define LFSCK_CHECKPOINT_SKIP	1
-
 /* define lfsck thread key */
 LU_KEY_INIT(lfsck, struct lfsck_thread_info);
 
@@ -1818,6 +1816,37 @@ void lfsck_pos_dump(struct seq_file *m, struct lfsck_position *pos,
 	}
 }
 
+/*
+ * Estimate the phase1 progress from the OIT position, which is an inode
+ * or dnode number, against the number of inodes of the device.
+ */
+void lfsck_progress_dump(const struct lu_env *env, struct seq_file *m,
+			 struct lfsck_instance *lfsck, __u64 pos,
+			 time64_t rtime)
+{
+	struct obd_statfs sfs = { 0 };
+	__u64 total;
+
+	if (dt_statfs(env, lfsck->li_bottom, &sfs) != 0 ||
+	    sfs.os_files == 0 || pos == 0) {
+		seq_puts(m, "progress_phase1: N/A\n"
+			 "estimated_remaining_phase1: N/A\n");
+		return;
+	}
+
+	total = sfs.os_files;
+	if (pos > total)
+		pos = total;
+
+	seq_printf(m, "progress_phase1: %llu%%\n",
+		   div64_u64(pos * 100, total));
+	if (rtime > 0)
+		seq_printf(m, "estimated_remaining_phase1: %llu seconds\n",
+			   div64_u64((total - pos) * rtime, pos));
+	else
+		seq_puts(m, "estimated_remaining_phase1: N/A\n");
+}
+
 void lfsck_pos_fill(const struct lu_env *env, struct lfsck_instance *lfsck,
 		    struct lfsck_position *pos, bool init)
 {
@@ -2525,6 +2554,7 @@ int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 	lad->lad_post_result = 0;
 	lad->lad_flags = 0;
 	lad->lad_advance_lock = false;
+	lad->lad_helper_handled = 0;
 	thread_set_flags(athread, 0);
 
 	lta = lfsck_thread_args_init(lfsck, com, lsp);
@@ -2554,6 +2584,68 @@ int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 	RETURN(rc);
 }
 
+/**
+ * Start the helper threads of the LFSCK assistant.
+ *
+ * The helpers handle the phase1 requests of lad_req_list together with
+ * the assistant thread, for the components whose la_handler_p1() can run
+ * in parallel. The LFSCK goes on with fewer helpers if some of them cannot
+ * be started.
+ *
+ * \param[in] com	pointer to the lfsck component
+ *
+ * \retval		the number of helpers started
+ */
+int lfsck_start_assistant_helpers(struct lfsck_component *com)
+{
+	struct lfsck_instance *lfsck = com->lc_lfsck;
+	struct lfsck_assistant_data *lad = com->lc_data;
+	struct lfsck_thread_args *lta;
+	struct task_struct *task;
+	int nr = lfsck->li_bookmark_ram.lb_assistant_threads;
+	int i;
+
+	clear_bit(LAD_HELPER_STOP, &lad->lad_flags);
+	lad->lad_helper_status = 0;
+	if (!lad->lad_parallel)
+		return 0;
+
+	for (i = 1; i < nr; i++) {
+		lta = lfsck_thread_args_init(lfsck, com, NULL);
+		if (IS_ERR(lta))
+			break;
+
+		spin_lock(&lad->lad_lock);
+		lad->lad_helpers++;
+		spin_unlock(&lad->lad_lock);
+		task = kthread_run(lfsck_assistant_helper, lta, "%s_%d",
+				   lad->lad_name, i);
+		if (IS_ERR(task)) {
+			CWARN("%s: cannot start LFSCK assistant helper for %s: rc = %ld\n",
+			      lfsck_lfsck2name(lfsck), lad->lad_name,
+			      PTR_ERR(task));
+			spin_lock(&lad->lad_lock);
+			lad->lad_helpers--;
+			spin_unlock(&lad->lad_lock);
+			lfsck_thread_args_fini(lta);
+			break;
+		}
+	}
+
+	return i - 1;
+}
+
+/* Stop the helpers once they have handled their current requests. */
+void lfsck_stop_assistant_helpers(struct lfsck_component *com)
+{
+	struct lfsck_assistant_data *lad = com->lc_data;
+	struct ptlrpc_thread *athread = &lad->lad_thread;
+
+	set_bit(LAD_HELPER_STOP, &lad->lad_flags);
+	wake_up_all(&athread->t_ctl_waitq);
+	wait_event_idle(athread->t_ctl_waitq, lad->lad_helpers == 0);
+}
+
 int lfsck_checkpoint_generic(const struct lu_env *env,
 			     struct lfsck_component *com)
 {
@@ -2859,6 +2951,69 @@ int lfsck_set_windows(struct dt_device *key, unsigned int val)
 }
 EXPORT_SYMBOL(lfsck_set_windows);
 
+int lfsck_get_threads(char *buf, struct dt_device *key)
+{
+	struct lu_env env;
+	struct lfsck_instance *lfsck;
+	int rc;
+
+	ENTRY;
+	rc = lu_env_init(&env, LCT_MD_THREAD | LCT_DT_THREAD);
+	if (rc != 0)
+		RETURN(rc);
+
+	lfsck = lfsck_instance_find(key, true, false);
+	if (likely(lfsck != NULL)) {
+		rc = sprintf(buf, "%u\n",
+			     max_t(__u16, 1,
+				   lfsck->li_bookmark_ram.lb_assistant_threads));
+		lfsck_instance_put(&env, lfsck);
+	} else {
+		rc = -ENXIO;
+	}
+
+	lu_env_fini(&env);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(lfsck_get_threads);
+
+/* The new count is used by the next LFSCK run. */
+int lfsck_set_threads(struct dt_device *key, unsigned int val)
+{
+	struct lu_env env;
+	struct lfsck_instance *lfsck;
+	int rc;
+
+	ENTRY;
+	rc = lu_env_init(&env, LCT_MD_THREAD | LCT_DT_THREAD);
+	if (rc != 0)
+		RETURN(rc);
+
+	lfsck = lfsck_instance_find(key, true, false);
+	if (likely(lfsck != NULL)) {
+		if (val < 1 || val > LFSCK_ASSISTANT_THREADS_MAX) {
+			CWARN("%s: invalid assistant threads count, the valid range is [1 - %u].\n",
+			      lfsck_lfsck2name(lfsck),
+			      LFSCK_ASSISTANT_THREADS_MAX);
+			rc = -EINVAL;
+		} else if (lfsck->li_bookmark_ram.lb_assistant_threads != val) {
+			mutex_lock(&lfsck->li_mutex);
+			lfsck->li_bookmark_ram.lb_assistant_threads = val;
+			rc = lfsck_bookmark_store(&env, lfsck);
+			mutex_unlock(&lfsck->li_mutex);
+		}
+		lfsck_instance_put(&env, lfsck);
+	} else {
+		rc = -ENXIO;
+	}
+
+	lu_env_fini(&env);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(lfsck_set_threads);
+
 int lfsck_dump(struct seq_file *m, struct dt_device *key, enum lfsck_type type)
 {
 	struct lu_env env;
@@ -56,6 +56,8 @@ lfsck_namespace_assistant_req_init(struct lfsck_instance *lfsck,
 	INIT_LIST_HEAD(&lnr->lnr_lar.lar_list);
 	lnr->lnr_lar.lar_parent = lfsck_assistant_object_get(lso);
 	lnr->lnr_lmv = lfsck_lmv_get(lfsck->li_lmv);
+	/* the name entries of a striped directory share lnr_lmv */
+	lnr->lnr_lar.lar_serial = lnr->lnr_lmv != NULL;
 	lnr->lnr_fid = ent->lde_fid;
 	lnr->lnr_dir_cookie = ent->lde_hash;
 	lnr->lnr_attr = ent->lde_attrs;
@@ -249,6 +251,17 @@ static void lfsck_namespace_record_failure(const struct lu_env *env,
 	}
 }
 
+/* The assistant helpers may update ln_flags at the same time. */
+static void lfsck_namespace_set_flags(struct lfsck_component *com,
+				      __u32 flags)
+{
+	struct lfsck_namespace *ns = com->lc_file_ram;
+
+	down_write(&com->lc_sem);
+	ns->ln_flags |= flags;
+	up_write(&com->lc_sem);
+}
+
 /**
  * Load the MDT bitmap from the lfsck_namespace trace file.
  *
@@ -718,11 +731,8 @@ log:
 	       "%s: namespace LFSCK remove invalid linkEA for the object "DFID": rc = %d\n",
 	       lfsck_lfsck2name(lfsck), PFID(lfsck_dto2fid(obj)), rc);
 
-	if (rc == 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc == 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -1091,11 +1101,8 @@ log:
 	       lfsck_lfsck2name(lfsck), PFID(cfid),
 	       cname->ln_name != NULL ? cname->ln_name : "<NULL>", rc);
 
-	if (rc != 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc != 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -1393,9 +1400,11 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
 		if (rc > 0)
 			ns->ln_lost_dirent_repaired++;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1432,7 +1441,6 @@ static int lfsck_namespace_create_orphan_dir(const struct lu_env *env,
 	const struct lu_fid *cfid = lfsck_dto2fid(orphan);
 	struct lu_fid tfid;
 	struct lfsck_instance *lfsck = com->lc_lfsck;
-	struct lfsck_namespace *ns = com->lc_file_ram;
 	struct dt_device *dev = lfsck_obj2dev(orphan);
 	struct dt_object *parent = NULL;
 	struct thandle *th = NULL;
@@ -1661,7 +1669,7 @@ log:
 		lfsck_object_put(env, parent);
 
 	if (rc != 0)
-		ns->ln_flags |= LF_INCONSISTENT;
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -1803,11 +1811,8 @@ log:
 	       PFID(lfsck_dto2fid(obj)), PFID(pfid), cname->ln_namelen,
 	       cname->ln_name);
 
-	if (rc != 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc != 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -2168,11 +2173,8 @@ log:
 	       "%s: namespace LFSCK rebuild linkEA for the object "DFID": rc = %d\n",
 	       lfsck_lfsck2name(lfsck), PFID(lfsck_dto2fid(obj)), rc);
 
-	if (rc != 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc != 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -2330,11 +2332,8 @@ log:
 	       name, type, update ? lfsck_object_type(child) : 0,
 	       update ? "updating" : "removing", name2, rc);
 
-	if (rc != 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc != 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -2438,11 +2437,8 @@ log:
 	       lfsck_lfsck2name(lfsck), PFID(lfsck_dto2fid(obj)),
 	       PFID(pfid), rc);
 
-	if (rc != 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc != 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -3188,7 +3184,7 @@ log:
 	       lfsck_lfsck2name(lfsck), PFID(cfid), old, la->la_nlink, rc);
 
 	if (rc != 0)
-		ns->ln_flags |= LF_INCONSISTENT;
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -4357,7 +4353,9 @@ static void lfsck_namespace_close_dir(const struct lu_env *env,
 
 	OBD_ALLOC(lnr, size);
 	if (lnr == NULL) {
+		down_write(&com->lc_sem);
 		ns->ln_striped_dirs_skipped++;
+		up_write(&com->lc_sem);
 
 		RETURN_EXIT;
 	}
@@ -4366,7 +4364,9 @@ static void lfsck_namespace_close_dir(const struct lu_env *env,
 			la, lfsck->li_pos_current.lp_oit_cookie, true);
 	if (IS_ERR(lso)) {
 		OBD_FREE(lnr, size);
+		down_write(&com->lc_sem);
 		ns->ln_striped_dirs_skipped++;
+		up_write(&com->lc_sem);
 
 		RETURN_EXIT;
 	}
@@ -4377,6 +4377,7 @@ static void lfsck_namespace_close_dir(const struct lu_env *env,
 	INIT_LIST_HEAD(&lnr->lnr_lar.lar_list);
 	lnr->lnr_lar.lar_parent = lso;
 	lnr->lnr_lmv = lfsck_lmv_get(llmv);
+	lnr->lnr_lar.lar_serial = true;
 	lnr->lnr_fid = *lfsck_dto2fid(lfsck->li_obj_dir);
 	lnr->lnr_dir_cookie = MDS_DIR_END_OFF;
 	lnr->lnr_size = size;
@@ -4388,13 +4389,15 @@ static void lfsck_namespace_close_dir(const struct lu_env *env,
 		     !thread_is_running(&lad->lad_thread))) {
 		spin_unlock(&lad->lad_lock);
 		lfsck_namespace_assistant_req_fini(env, &lnr->lnr_lar);
+		down_write(&com->lc_sem);
 		ns->ln_striped_dirs_skipped++;
+		up_write(&com->lc_sem);
 
 		RETURN_EXIT;
 	}
 
 	list_add_tail(&lnr->lnr_lar.lar_list, &lad->lad_req_list);
-	if (lad->lad_prefetched == 0)
+	if (lad->lad_prefetched == lad->lad_in_flight)
 		wakeup = true;
 
 	lad->lad_prefetched++;
@@ -4409,7 +4412,6 @@ static int lfsck_namespace_open_dir(const struct lu_env *env,
 				    struct lfsck_component *com)
 {
 	struct lfsck_instance *lfsck = com->lc_lfsck;
-	struct lfsck_namespace *ns = com->lc_file_ram;
 	struct lfsck_lmv *llmv = lfsck->li_lmv;
 	int rc = 0;
 
@@ -4423,7 +4425,7 @@ static int lfsck_namespace_open_dir(const struct lu_env *env,
 		if (lmv->lmv_master_mdt_index != lfsck_dev_idx(lfsck)) {
 			lmv->lmv_master_mdt_index =
 				lfsck_dev_idx(lfsck);
-			ns->ln_flags |= LF_INCONSISTENT;
+			lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 			llmv->ll_lmv_updated = 1;
 		}
 	} else {
@@ -4439,19 +4441,30 @@ static int lfsck_namespace_checkpoint(const struct lu_env *env,
 {
 	struct lfsck_instance *lfsck = com->lc_lfsck;
 	struct lfsck_namespace *ns = com->lc_file_ram;
+	struct lfsck_assistant_data *lad = com->lc_data;
+	struct lfsck_position pos = lfsck->li_pos_checkpoint;
 	int rc;
 
 	if (!init) {
-		rc = lfsck_checkpoint_generic(env, com);
-		if (rc != 0)
+		/* Do not wait for the assistant threads to drain the
+		 * requests, but checkpoint at the oldest unfinished one.
+		 */
+		if (!thread_is_running(&lfsck->li_thread) ||
+		    thread_is_stopped(&lad->lad_thread)) {
+			rc = LFSCK_CHECKPOINT_SKIP;
 			goto log;
+		}
+
+		spin_lock(&lad->lad_lock);
+		lad->lad_ops->la_fill_pos(env, com, &pos);
+		spin_unlock(&lad->lad_lock);
 	}
 
 	down_write(&com->lc_sem);
 	if (init) {
 		ns->ln_pos_latest_start = lfsck->li_pos_checkpoint;
 	} else {
-		ns->ln_pos_last_checkpoint = lfsck->li_pos_checkpoint;
+		ns->ln_pos_last_checkpoint = pos;
 		ns->ln_run_time_phase1 += ktime_get_seconds() -
 					  lfsck->li_time_last_checkpoint;
 		ns->ln_time_last_checkpoint = ktime_get_real_seconds();
@@ -4740,7 +4753,7 @@ static int lfsck_namespace_exec_dir(const struct lu_env *env,
 	}
 
 	list_add_tail(&lnr->lnr_lar.lar_list, &lad->lad_req_list);
-	if (lad->lad_prefetched == 0)
+	if (lad->lad_prefetched == lad->lad_in_flight)
 		wakeup = true;
 
 	lad->lad_prefetched++;
@@ -4818,6 +4831,7 @@ lfsck_namespace_dump(const struct lu_env *env, struct lfsck_component *com,
 	struct lfsck_instance *lfsck = com->lc_lfsck;
 	struct lfsck_bookmark *bk = &lfsck->li_bookmark_ram;
 	struct lfsck_namespace *ns = com->lc_file_ram;
+	struct lfsck_assistant_data *lad = com->lc_data;
 
 	down_read(&com->lc_sem);
 	seq_printf(m, "name: lfsck_namespace\n"
@@ -4846,6 +4860,10 @@ lfsck_namespace_dump(const struct lu_env *env, struct lfsck_component *com,
 	lfsck_pos_dump(m, &ns->ln_pos_first_inconsistent,
 		       "first_failure_position");
 
+	/* phase1 requests handled by the helpers of the last run */
+	seq_printf(m, "assistant_helper_handled: %llu\n",
+		   lad->lad_helper_handled);
+
 	if (ns->ln_status == LS_SCANNING_PHASE1) {
 		struct lfsck_position pos;
 		time64_t duration = ktime_get_seconds() -
@@ -4905,6 +4923,7 @@ lfsck_namespace_dump(const struct lu_env *env, struct lfsck_component *com,
 		}
 
 		lfsck_pos_dump(m, &pos, "current_position");
+		lfsck_progress_dump(env, m, lfsck, pos.lp_oit_cookie, rtime);
 	} else if (ns->ln_status == LS_SCANNING_PHASE2) {
 		time64_t duration = ktime_get_seconds() -
 				    com->lc_time_last_checkpoint;
@@ -5593,11 +5612,8 @@ log:
 	       create ? "Create the lost MDT-object as required" :
 			"Keep the MDT-object there by default", rc);
 
-	if (rc <= 0) {
-		struct lfsck_namespace *ns = com->lc_file_ram;
-
-		ns->ln_flags |= LF_INCONSISTENT;
-	}
+	if (rc <= 0)
+		lfsck_namespace_set_flags(com, LF_INCONSISTENT);
 
 	return rc;
 }
@@ -5630,6 +5646,8 @@ static int lfsck_namespace_assistant_handler_p1(const struct lu_env *env,
 	bool log = false;
 	bool bad_hash = false;
 	bool bad_linkea = false;
+	bool linkea_repaired = false;
+	__u32 flags = 0;
 	int idx = 0;
 	int count = 0;
 	int rc = 0;
@@ -5640,13 +5658,18 @@ static int lfsck_namespace_assistant_handler_p1(const struct lu_env *env,
 		RETURN(0);
 
 	la->la_nlink = 0;
-	if (lnr->lnr_attr & LUDA_UPGRADE) {
-		ns->ln_flags |= LF_UPGRADE;
-		ns->ln_dirent_repaired++;
-		repaired = true;
-	} else if (lnr->lnr_attr & LUDA_REPAIR) {
-		ns->ln_flags |= LF_INCONSISTENT;
+	/* Other assistant threads may update the statistics at the same
+	 * time, so they are only updated under lc_sem, most of them in one
+	 * go at the end.
+	 */
+	if (lnr->lnr_attr & (LUDA_UPGRADE | LUDA_REPAIR)) {
+		down_write(&com->lc_sem);
+		if (lnr->lnr_attr & LUDA_UPGRADE)
+			ns->ln_flags |= LF_UPGRADE;
+		else
+			ns->ln_flags |= LF_INCONSISTENT;
 		ns->ln_dirent_repaired++;
+		up_write(&com->lc_sem);
 		repaired = true;
 	}
 
@@ -5720,7 +5743,9 @@ static int lfsck_namespace_assistant_handler_p1(const struct lu_env *env,
 			CDEBUG(D_LFSCK,
 			       "%s: cannot talk with MDT %x which did not join the namespace LFSCK\n",
 			       lfsck_lfsck2name(lfsck), idx);
+			down_write(&com->lc_sem);
 			lfsck_lad_set_bitmap(env, com, idx);
+			up_write(&com->lc_sem);
 
 			GOTO(out, rc = -ENODEV);
 		}
@@ -5812,7 +5837,7 @@ again:
 		    (count == 1 || !S_ISDIR(lfsck_object_type(obj)))) {
 			if ((lfsck_object_type(obj) & S_IFMT) !=
 			    lnr->lnr_type) {
-				ns->ln_flags |= LF_INCONSISTENT;
+				flags |= LF_INCONSISTENT;
 				type = LNIT_BAD_TYPE;
 			}
 
@@ -5825,7 +5850,7 @@ again:
 		 */
 		if (!lfsck_is_valid_slave_name_entry(env, lnr->lnr_lmv,
 					lnr->lnr_name, lnr->lnr_namelen)) {
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_INCONSISTENT;
 			type = LNIT_BAD_DIRENT;
 
 			GOTO(stop, rc = 0);
@@ -5837,7 +5862,7 @@ again:
 		 * that the name entry is corrupted.
 		 */
 		if ((lfsck_object_type(obj) & S_IFMT) != lnr->lnr_type) {
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_INCONSISTENT;
 			type = LNIT_BAD_DIRENT;
 
 			GOTO(stop, rc = 0);
@@ -5889,10 +5914,10 @@ nodata:
 
 		if (bk->lb_param & LPF_DRYRUN) {
 			if (rc == -ENODATA)
-				ns->ln_flags |= LF_UPGRADE;
+				flags |= LF_UPGRADE;
 			else
-				ns->ln_flags |= LF_INCONSISTENT;
-			ns->ln_linkea_repaired++;
+				flags |= LF_INCONSISTENT;
+			linkea_repaired = true;
 			repaired = true;
 			log = true;
 			goto stop;
@@ -5923,9 +5948,10 @@ nodata:
 
 		bad_linkea = true;
 		if (!remove && newdata)
-			ns->ln_flags |= LF_UPGRADE;
-		else if (remove || !(ns->ln_flags & LF_UPGRADE))
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_UPGRADE;
+		else if (remove ||
+			 !((READ_ONCE(ns->ln_flags) | flags) & LF_UPGRADE))
+			flags |= LF_INCONSISTENT;
 
 		if (remove) {
 			LASSERT(newdata);
@@ -5951,7 +5977,7 @@ nodata:
 		count = ldata.ld_leh->leh_reccount;
 		if (!S_ISDIR(lfsck_object_type(obj)) ||
 		    !dt_object_remote(obj)) {
-			ns->ln_linkea_repaired++;
+			linkea_repaired = true;
 			repaired = true;
 			log = true;
 		}
@@ -5973,7 +5999,7 @@ out:
 	    !lfsck_is_valid_slave_name_entry(env, lnr->lnr_lmv,
 					     lnr->lnr_name, lnr->lnr_namelen) &&
 	    type != LNIT_BAD_DIRENT) {
-		ns->ln_flags |= LF_INCONSISTENT;
+		flags |= LF_INCONSISTENT;
 
 		log = false;
 		if (dir == NULL) {
@@ -6045,6 +6071,9 @@ out:
 
 trace:
 	down_write(&com->lc_sem);
+	ns->ln_flags |= flags;
+	if (linkea_repaired)
+		ns->ln_linkea_repaired++;
 	if (rc < 0) {
 		CDEBUG(D_LFSCK,
 		       "%s: namespace LFSCK assistant fail to handle the entry: "DFID", parent "DFID", name %.*s: rc = %d\n",
@@ -7138,6 +7167,7 @@ int lfsck_namespace_setup(const struct lu_env *env,
 			  struct lfsck_instance *lfsck)
 {
 	struct lfsck_component *com;
+	struct lfsck_assistant_data *lad;
 	struct lfsck_namespace *ns;
 	struct dt_object *root = NULL;
 	struct dt_object *obj;
@@ -7158,12 +7188,17 @@ int lfsck_namespace_setup(const struct lu_env *env,
 	com->lc_lfsck = lfsck;
 	com->lc_type = LFSCK_TYPE_NAMESPACE;
 	com->lc_ops = &lfsck_namespace_ops;
-	com->lc_data = lfsck_assistant_data_init(
-			&lfsck_namespace_assistant_ops,
-			LFSCK_NAMESPACE);
-	if (com->lc_data == NULL)
+	lad = lfsck_assistant_data_init(&lfsck_namespace_assistant_ops,
+					LFSCK_NAMESPACE);
+	if (lad == NULL)
 		GOTO(out, rc = -ENOMEM);
 
+	/* name entries are checked independently, except the ones of the
+	 * striped directories which are marked as lar_serial
+	 */
+	lad->lad_parallel = true;
+	com->lc_data = lad;
+
 	com->lc_file_size = sizeof(struct lfsck_namespace);
 	OBD_ALLOC(com->lc_file_ram, com->lc_file_size);
 	if (com->lc_file_ram == NULL)
@@ -1904,6 +1904,465 @@ free_lfa:
 	RETURN(rc);
 }
 
+/* names queued since the last flush of a LL_IOC_BATCH_OPS batch, hashed */
+#define LL_BATCH_NAME_HASH	1024
+
+static int ll_batch_ops_cb(struct md_op_item *item, int rc)
+{
+	struct lu_batch_entry *lbe = item->mop_cbdata;
+
+	lbe->lbe_result = rc;
+	return rc;
+}
+
+static void ll_batch_item_fini(struct md_op_item *item)
+{
+	struct md_op_data *op_data = &item->mop_data;
+
+	if (op_data->op_flags & MF_OPNAME_KMALLOCED)
+		kfree(op_data->op_name);
+	ll_unlock_md_op_lsm(op_data);
+	if (item->mop_subpill_allocated)
+		OBD_FREE_PTR(item->mop_pill);
+}
+
+/* look up the FID of @name in the dcache, return -ENOENT if not cached */
+static int ll_batch_cached_fid(struct dentry *parent,
+			       struct lu_batch_entry *lbe, struct lu_fid *fid)
+{
+	struct dentry *dchild;
+	struct qstr qstr;
+	int rc = -ENOENT;
+
+	qstr.hash = ll_full_name_hash(parent, lbe->lbe_name, lbe->lbe_namelen);
+	qstr.name = lbe->lbe_name;
+	qstr.len = lbe->lbe_namelen;
+	dchild = d_lookup(parent, &qstr);
+	if (!dchild)
+		return rc;
+
+	if (dchild->d_inode) {
+		if (S_ISDIR(dchild->d_inode->i_mode))
+			rc = -EISDIR;
+		else
+			rc = 0;
+		*fid = *ll_inode2fid(dchild->d_inode);
+	}
+	dput(dchild);
+
+	return rc;
+}
+
+/*
+ * The batched unlink of a name whose inode is on another MDT returns
+ * -EREMOTE, unlink it with a regular RPC to the MDTs of both.
+ */
+static int ll_batch_unlink_remote(struct inode *dir, struct lu_batch_entry *lbe)
+{
+	struct ptlrpc_request *req = NULL;
+	struct md_op_data *op_data;
+	struct inode *child = NULL;
+	struct lu_fid fid;
+	int rc;
+
+	rc = ll_get_fid_by_name(dir, lbe->lbe_name, lbe->lbe_namelen, &fid,
+				&child);
+	if (rc)
+		return rc;
+	if (S_ISDIR(child->i_mode))
+		GOTO(out_iput, rc = -EISDIR);
+
+	op_data = ll_prep_md_op_data(NULL, dir, NULL, lbe->lbe_name,
+				     lbe->lbe_namelen, 0, LUSTRE_OPC_ANY, NULL);
+	if (IS_ERR(op_data))
+		GOTO(out_iput, rc = PTR_ERR(op_data));
+
+	op_data->op_fid2 = fid;
+	op_data->op_fid3 = fid;
+	rc = md_unlink(ll_i2mdexp(dir), op_data, &req);
+	ll_finish_md_op_data(op_data);
+	ptlrpc_req_put(req);
+out_iput:
+	iput(child);
+	return rc;
+}
+
+static void ll_batch_setattr_prep(struct md_op_data *op_data,
+				  struct lu_batch_entry *lbe)
+{
+	struct iattr *attr = &op_data->op_attr;
+
+	attr->ia_valid = ATTR_CTIME;
+	attr->ia_ctime.tv_sec = ktime_get_real_seconds();
+	attr->ia_ctime.tv_nsec = 0;
+	if (lbe->lbe_valid & LU_BATCH_SET_MODE) {
+		attr->ia_valid |= ATTR_MODE;
+		attr->ia_mode = lbe->lbe_mode & S_IALLUGO;
+	}
+	if (lbe->lbe_valid & LU_BATCH_SET_UID) {
+		attr->ia_valid |= ATTR_UID;
+		attr->ia_uid = make_kuid(&init_user_ns, lbe->lbe_uid);
+	}
+	if (lbe->lbe_valid & LU_BATCH_SET_GID) {
+		attr->ia_valid |= ATTR_GID;
+		attr->ia_gid = make_kgid(&init_user_ns, lbe->lbe_gid);
+	}
+	if (lbe->lbe_valid & LU_BATCH_SET_ATIME) {
+		attr->ia_valid |= ATTR_ATIME | ATTR_ATIME_SET;
+		attr->ia_atime.tv_sec = lbe->lbe_atime;
+		attr->ia_atime.tv_nsec = 0;
+	}
+	if (lbe->lbe_valid & LU_BATCH_SET_MTIME) {
+		attr->ia_valid |= ATTR_MTIME | ATTR_MTIME_SET;
+		attr->ia_mtime.tv_sec = lbe->lbe_mtime;
+		attr->ia_mtime.tv_nsec = 0;
+	}
+}
+
+/*
+ * The MDT sets the owner of the OST objects of a file, but the client sets
+ * their times, as ll_setattr_raw() does. Set them once the batched setattr
+ * of the MDT inode succeeded.
+ */
+static int ll_batch_setattr_ost(struct inode *dir, struct lu_batch_entry *lbe,
+				struct iattr *attr)
+{
+	struct inode *child = NULL;
+	struct ll_inode_info *lli;
+	struct iattr ost_attr = { 0 };
+	__u32 gen;
+	int rc;
+
+	rc = ll_get_fid_by_name(dir, lbe->lbe_name, lbe->lbe_namelen, NULL,
+				&child);
+	if (rc)
+		return rc;
+	if (!S_ISREG(child->i_mode))
+		GOTO(out_iput, rc = 0);
+
+	/* the batched setattr did not fetch the layout */
+	rc = ll_layout_refresh(child, &gen);
+	if (rc)
+		GOTO(out_iput, rc);
+
+	lli = ll_i2info(child);
+	if (lli->lli_clob == NULL)
+		GOTO(out_iput, rc = 0);
+
+	ost_attr.ia_valid = attr->ia_valid & (ATTR_ATIME | ATTR_ATIME_SET |
+					      ATTR_MTIME | ATTR_MTIME_SET |
+					      ATTR_CTIME);
+	ost_attr.ia_atime = attr->ia_atime;
+	ost_attr.ia_mtime = attr->ia_mtime;
+	ost_attr.ia_ctime = attr->ia_ctime;
+	rc = cl_setattr_ost(lli->lli_clob, &ost_attr, 0, 0);
+out_iput:
+	iput(child);
+	return rc;
+}
+
+/*
+ * Set the times on the OST objects of the files whose setattr was queued in
+ * the batches sent so far, @times is indexed by entry.
+ */
+static void ll_batch_setattr_osts(struct inode *dir, struct lu_batch_ops *lbo,
+				  struct md_op_item *items,
+				  unsigned long *times)
+{
+	int i;
+
+	for_each_set_bit(i, times, lbo->lbo_count) {
+		struct lu_batch_entry *lbe = &lbo->lbo_entries[i];
+
+		if (lbe->lbe_result == 0)
+			lbe->lbe_result = ll_batch_setattr_ost(dir, lbe,
+						&items[i].mop_data.op_attr);
+	}
+	bitmap_zero(times, LU_BATCH_OPS_MAX);
+}
+
+/*
+ * Resolve the FID of the file changed by a LU_BATCH_SETATTR entry: a file
+ * created earlier in the same call, the dcache, or a lookup RPC.
+ */
+static int ll_batch_setattr_fid(struct file *file, struct lu_batch_ops *lbo,
+				struct md_op_item *items, int idx,
+				unsigned long *created, struct lu_fid *fid)
+{
+	struct lu_batch_entry *lbe = &lbo->lbo_entries[idx];
+	struct dentry *parent = file_dentry(file);
+	unsigned int bit;
+	int rc;
+	int i;
+
+	bit = ll_full_name_hash(parent, lbe->lbe_name, lbe->lbe_namelen) %
+	      LL_BATCH_NAME_HASH;
+	for (i = idx - 1; test_bit(bit, created) && i >= 0; i--) {
+		struct lu_batch_entry *prev = &lbo->lbo_entries[i];
+
+		if (prev->lbe_opc != LU_BATCH_CREATE ||
+		    prev->lbe_namelen != lbe->lbe_namelen ||
+		    memcmp(prev->lbe_name, lbe->lbe_name, lbe->lbe_namelen))
+			continue;
+		/* the create failed when queued, or was not queued */
+		if (!fid_is_sane(&items[i].mop_data.op_fid2))
+			return -ENOENT;
+		*fid = items[i].mop_data.op_fid2;
+		return 0;
+	}
+
+	rc = ll_batch_cached_fid(parent, lbe, fid);
+	if (rc == -ENOENT)
+		rc = ll_get_fid_by_name(file_inode(file), lbe->lbe_name,
+					lbe->lbe_namelen, fid, NULL);
+	if (rc == -EISDIR)
+		rc = 0;
+
+	return rc;
+}
+
+/* number of LL_IOC_BATCH_OPS entries not processed yet */
+static int ll_batch_ops_pending(struct lu_batch_ops *lbo)
+{
+	int pending = 0;
+	int i;
+
+	for (i = 0; i < lbo->lbo_count; i++)
+		if (lbo->lbo_entries[i].lbe_result == -ECANCELED)
+			pending++;
+
+	return pending;
+}
+
+/*
+ * Send the LL_IOC_BATCH_OPS entries not processed yet in batched RPCs.
+ * Entries on the same name are sent in order, the batch is flushed before
+ * an entry whose name is already queued. The times of the OST objects are
+ * set after the batch with their MDT setattr is sent.
+ */
+static int ll_batch_ops_send(struct file *file, struct lu_batch_ops *lbo,
+			     struct md_op_item *items, unsigned long *created)
+{
+	struct inode *dir = file_inode(file);
+	struct dentry *parent = file_dentry(file);
+	struct obd_export *exp = ll_i2mdexp(dir);
+	DECLARE_BITMAP(queued, LL_BATCH_NAME_HASH);
+	DECLARE_BITMAP(times, LU_BATCH_OPS_MAX);
+	struct lu_batch *bh;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	bh = md_batch_create(exp, BATCH_FL_RQSET, 0);
+	if (IS_ERR(bh))
+		RETURN(PTR_ERR(bh));
+
+	bitmap_zero(queued, LL_BATCH_NAME_HASH);
+	bitmap_zero(times, LU_BATCH_OPS_MAX);
+	for (i = 0; i < lbo->lbo_count; i++) {
+		struct lu_batch_entry *lbe = &lbo->lbo_entries[i];
+		struct md_op_item *item = &items[i];
+		struct md_op_data *op_data;
+		struct lu_fid fid = { 0 };
+		unsigned int bit;
+
+		if (lbe->lbe_result != -ECANCELED)
+			continue;
+
+		/* queued in a batch that stopped before it */
+		if (item->mop_opc != MD_OP_NONE) {
+			ll_batch_item_fini(item);
+			memset(item, 0, sizeof(*item));
+		}
+
+		bit = ll_full_name_hash(parent, lbe->lbe_name,
+					lbe->lbe_namelen) % LL_BATCH_NAME_HASH;
+		/* an entry depends on the queued ones with the same name */
+		if (test_bit(bit, queued)) {
+			md_batch_flush(exp, bh, true);
+			bitmap_zero(queued, LL_BATCH_NAME_HASH);
+			ll_batch_setattr_osts(dir, lbo, items, times);
+		}
+
+		switch (lbe->lbe_opc) {
+		case LU_BATCH_CREATE:
+			op_data = ll_prep_md_op_data(&item->mop_data, dir, NULL,
+					lbe->lbe_name, lbe->lbe_namelen,
+					S_IFREG | (lbe->lbe_mode & S_IALLUGO),
+					LUSTRE_OPC_CREATE, NULL);
+			item->mop_opc = MD_OP_CREATE;
+			break;
+		case LU_BATCH_UNLINK:
+			rc = ll_batch_cached_fid(parent, lbe, &fid);
+			if (rc == -EISDIR) {
+				lbe->lbe_result = rc;
+				continue;
+			}
+			op_data = ll_prep_md_op_data(&item->mop_data, dir, NULL,
+					lbe->lbe_name, lbe->lbe_namelen, 0,
+					LUSTRE_OPC_ANY, NULL);
+			if (!IS_ERR(op_data) && rc == 0)
+				op_data->op_fid2 = fid;
+			item->mop_opc = MD_OP_UNLINK;
+			break;
+		case LU_BATCH_SETATTR:
+			rc = ll_batch_setattr_fid(file, lbo, items, i, created,
+						  &fid);
+			if (rc) {
+				lbe->lbe_result = rc;
+				continue;
+			}
+			op_data = ll_prep_md_op_data(&item->mop_data, dir, NULL,
+						     NULL, 0, 0, LUSTRE_OPC_ANY,
+						     NULL);
+			if (!IS_ERR(op_data)) {
+				op_data->op_fid1 = fid;
+				ll_batch_setattr_prep(op_data, lbe);
+			}
+			item->mop_opc = MD_OP_SETATTR;
+			break;
+		default:
+			continue;
+		}
+		/* a failed prep may still hold the stripes of @dir */
+		if (IS_ERR(op_data)) {
+			lbe->lbe_result = PTR_ERR(op_data);
+			continue;
+		}
+
+		item->mop_cb = ll_batch_ops_cb;
+		item->mop_cbdata = lbe;
+		rc = md_batch_add(exp, bh, item);
+		if (rc) {
+			lbe->lbe_result = rc;
+			fid_zero(&op_data->op_fid2);
+			continue;
+		}
+
+		set_bit(bit, queued);
+		if (lbe->lbe_opc == LU_BATCH_CREATE)
+			set_bit(bit, created);
+		if (lbe->lbe_opc == LU_BATCH_SETATTR &&
+		    lbe->lbe_valid & (LU_BATCH_SET_ATIME | LU_BATCH_SET_MTIME))
+			set_bit(i, times);
+	}
+
+	/* the entries report their own errors */
+	md_batch_stop(exp, bh);
+	ll_batch_setattr_osts(dir, lbo, items, times);
+
+	RETURN(0);
+}
+
+/*
+ * Create, unlink, or change the attributes of many names in a directory
+ * with batched RPCs. The result of each entry is returned in lbe_result,
+ * the ioctl itself fails only if the entries could not be processed at all.
+ */
+static int ll_batch_ops(struct file *file, void __user *uarg)
+{
+	struct lu_batch_ops __user *ulbo = uarg;
+	struct inode *dir = file_inode(file);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct obd_export *exp = ll_i2mdexp(dir);
+	DECLARE_BITMAP(created, LL_BATCH_NAME_HASH);
+	struct md_op_item *items = NULL;
+	struct lu_batch_ops *lbo;
+	const char *secctx_name;
+	bool creates = false;
+	size_t size;
+	__u32 count;
+	int pending;
+	int todo;
+	int sent;
+	int rc;
+	int i;
+
+	ENTRY;
+	if (get_user(count, &ulbo->lbo_count))
+		RETURN(-EFAULT);
+	if (count == 0)
+		RETURN(-EINVAL);
+	/* DoS protection */
+	if (count > LU_BATCH_OPS_MAX)
+		RETURN(-E2BIG);
+
+	if (!exp_connect_batch_reint(exp) || IS_ENCRYPTED(dir))
+		RETURN(-EOPNOTSUPP);
+	if (sb_rdonly(dir->i_sb))
+		RETURN(-EROFS);
+
+	size = offsetof(struct lu_batch_ops, lbo_entries[count]);
+	OBD_ALLOC_LARGE(lbo, size);
+	if (!lbo)
+		RETURN(-ENOMEM);
+	if (copy_from_user(lbo, ulbo, size))
+		GOTO(out_lbo, rc = -EFAULT);
+	lbo->lbo_count = count;
+
+	for (i = 0; i < count; i++) {
+		struct lu_batch_entry *lbe = &lbo->lbo_entries[i];
+
+		lbe->lbe_result = -ECANCELED;
+		if (lbe->lbe_opc == LU_BATCH_CREATE)
+			creates = true;
+		else if (lbe->lbe_opc != LU_BATCH_UNLINK &&
+			 lbe->lbe_opc != LU_BATCH_SETATTR)
+			lbe->lbe_result = -EINVAL;
+
+		if (lbe->lbe_namelen == 0 || lbe->lbe_namelen > NAME_MAX ||
+		    lbe->lbe_name[lbe->lbe_namelen] != '\0' ||
+		    !lu_name_is_valid_2(lbe->lbe_name, lbe->lbe_namelen))
+			lbe->lbe_result = -EINVAL;
+	}
+
+	/* files labelled by a security module are created one by one */
+	if (creates && ll_secctx_name_get(sbi, &secctx_name) > 0)
+		GOTO(out_lbo, rc = -EOPNOTSUPP);
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(items, count);
+	if (!items)
+		GOTO(out_lbo, rc = -ENOMEM);
+
+	/*
+	 * The MDT stops a batch at the first modification that fails, so
+	 * that a resent batch can be reconstructed, and the entries after it
+	 * are left -ECANCELED. Send them again while batches make progress.
+	 */
+	bitmap_zero(created, LL_BATCH_NAME_HASH);
+	todo = ll_batch_ops_pending(lbo);
+	pending = todo;
+	do {
+		sent = pending;
+		rc = ll_batch_ops_send(file, lbo, items, created);
+		if (rc)
+			break;
+		pending = ll_batch_ops_pending(lbo);
+	} while (pending > 0 && pending < sent);
+	/* the entries already processed report their results */
+	if (pending < todo)
+		rc = 0;
+
+	for (i = 0; i < count; i++) {
+		struct lu_batch_entry *lbe = &lbo->lbo_entries[i];
+
+		if (lbe->lbe_opc == LU_BATCH_UNLINK &&
+		    lbe->lbe_result == -EREMOTE)
+			lbe->lbe_result = ll_batch_unlink_remote(dir, lbe);
+		if (items[i].mop_opc != MD_OP_NONE)
+			ll_batch_item_fini(&items[i]);
+	}
+
+	if (rc == 0)
+		rc = copy_to_user(ulbo, lbo, size) ? -EFAULT : 0;
+
+	OBD_FREE_PTR_ARRAY_LARGE(items, count);
+out_lbo:
+	OBD_FREE_LARGE(lbo, size);
+	RETURN(rc);
+}
+
 /* This function tries to get a single name component, to send to the server.
  * No actual path traversal involved, so we limit to NAME_MAX
  */
@@ -2259,6 +2718,8 @@ out_rmdir:
 	}
 	case LL_IOC_RMFID:
 		RETURN(ll_rmfid(file, uarg));
+	case LL_IOC_BATCH_OPS:
+		RETURN(ll_batch_ops(file, uarg));
 	case LL_IOC_LOV_SWAP_LAYOUTS:
 		RETURN(-EPERM);
 	case LL_IOC_LOV_GETSTRIPE:
@@ -0,0 +1,823 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Erasure coded files
+ *
+ * An erasure coded file is a FLR file with a data mirror, whose components
+ * have k stripes, and a parity mirror made of LCME_FL_PARITY components with
+ * p stripes covering the same extents.  Stripe row r of a data component is
+ * the k chunks [start + r * k * S, start + (r + 1) * k * S) and its p parity
+ * chunks are stored contiguously at [start + r * p * S, start +
+ * (r + 1) * p * S) of the parity component, so parity chunk j of every row
+ * lands on parity stripe j.
+ *
+ * The parity is a Cauchy Reed-Solomon code over GF(2^8) computed by the
+ * erasure code library (lustre/ec).  The chunks of a stripe row are coded one
+ * slice at a time, and are read and written with direct I/O to the data or
+ * parity mirror, as mirror resync does.
+ */
+
+#define DEBUG_SUBSYSTEM S_LLITE
+
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
+#include <erasure_code.h>
+
+#include "llite_internal.h"
+
+/* the slices of the chunks of a stripe row coded at once take this much */
+#define LL_EC_BUF_SIZE	(16 << 20)
+
+/* the erasure coded component covering a file offset */
+struct ll_ec_comp {
+	u64	lec_start;
+	u64	lec_end;
+	u64	lec_stripe_size;
+	u32	lec_data_mirror;
+	u32	lec_parity_mirror;
+	u32	lec_parity_id;
+	bool	lec_parity_stale;
+	/* both components have objects */
+	bool	lec_init;
+	int	lec_k;
+	int	lec_p;
+};
+
+/* slice buffers and coding tables for the components of one geometry */
+struct ll_ec_io {
+	struct file		*lei_file;
+	struct ll_ec_comp	 lei_comp;
+	/* size of a slice, a multiple of PAGE_SIZE */
+	size_t			 lei_unit;
+	/* number of slices, the k data chunks first, then the p parity */
+	int			 lei_count;
+	unsigned char		*lei_buf;
+	struct bio_vec		*lei_bvec;
+	/* the lei_count slices, then k decode sources */
+	unsigned char		**lei_ptrs;
+	/* bytes of each slice holding data, and slices which are lost */
+	size_t			*lei_valid;
+	bool			*lei_miss;
+	/* (k + p) x k Cauchy matrix whose first k rows are the identity */
+	unsigned char		*lei_matrix;
+	/* k x k decode matrix and its inverse */
+	unsigned char		*lei_dec;
+	/* tables to encode the p parity, then to decode one chunk */
+	unsigned char		*lei_tbls;
+	unsigned char		*lei_dec_tbls;
+	size_t			 lei_matrix_size;
+};
+
+/* get the layout of @inode, -ENODATA if it is not erasure coded */
+static int ll_ec_layout_get(struct inode *inode, struct lov_comp_md_v1 **lcmp,
+			    size_t *sizep)
+{
+	struct cl_object *obj = ll_i2info(inode)->lli_clob;
+	struct cl_layout cl = { .cl_buf.lb_buf = NULL };
+	struct lov_comp_md_v1 *lcm;
+	struct lu_env *env;
+	size_t size;
+	__u16 refcheck;
+	int rc;
+
+	if (!obj)
+		return -ENODATA;
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		return PTR_ERR(env);
+
+	rc = cl_object_layout_get(env, obj, &cl);
+	if (rc < 0)
+		GOTO(out, rc);
+	if (!cl.cl_is_ec)
+		GOTO(out, rc = -ENODATA);
+
+	size = cl.cl_size;
+	OBD_ALLOC_LARGE(lcm, size);
+	if (!lcm)
+		GOTO(out, rc = -ENOMEM);
+
+	cl.cl_buf.lb_buf = lcm;
+	cl.cl_buf.lb_len = size;
+	rc = cl_object_layout_get(env, obj, &cl);
+	if (rc >= 0 && (!cl.cl_is_ec ||
+			le32_to_cpu(lcm->lcm_magic) != LOV_MAGIC_COMP_V1))
+		rc = -ENODATA;
+	if (rc < 0) {
+		OBD_FREE_LARGE(lcm, size);
+		GOTO(out, rc);
+	}
+
+	*lcmp = lcm;
+	*sizep = size;
+	rc = 0;
+out:
+	cl_env_put(env, &refcheck);
+
+	return rc;
+}
+
+/* find the data component covering @pos and its parity component */
+static int ll_ec_comp_find(const struct lov_comp_md_v1 *lcm, u64 pos,
+			   struct ll_ec_comp *lec)
+{
+	bool data_found = false;
+	bool parity_found = false;
+	bool init = true;
+	int i;
+
+	memset(lec, 0, sizeof(*lec));
+	for (i = 0; i < le16_to_cpu(lcm->lcm_entry_count); i++) {
+		const struct lov_comp_md_entry_v1 *lcme = &lcm->lcm_entries[i];
+		u32 flags = le32_to_cpu(lcme->lcme_flags);
+		u32 id = le32_to_cpu(lcme->lcme_id);
+		const struct lov_mds_md *lmm;
+
+		if (lcme->lcme_cstripe_count == 0 ||
+		    pos < le64_to_cpu(lcme->lcme_extent.e_start) ||
+		    pos >= le64_to_cpu(lcme->lcme_extent.e_end))
+			continue;
+
+		if (flags & LCME_FL_PARITY) {
+			if (parity_found)
+				continue;
+			if (!(flags & LCME_FL_INIT))
+				init = false;
+			parity_found = true;
+			lec->lec_parity_mirror = mirror_id_of(id);
+			lec->lec_parity_id = id;
+			lec->lec_parity_stale = flags & LCME_FL_STALE;
+		} else {
+			if (data_found)
+				continue;
+			if (!(flags & LCME_FL_INIT))
+				init = false;
+			data_found = true;
+			lmm = (void *)lcm + le32_to_cpu(lcme->lcme_offset);
+			lec->lec_data_mirror = mirror_id_of(id);
+			lec->lec_start = le64_to_cpu(lcme->lcme_extent.e_start);
+			lec->lec_end = le64_to_cpu(lcme->lcme_extent.e_end);
+			lec->lec_stripe_size = le32_to_cpu(lmm->lmm_stripe_size);
+			lec->lec_k = lcme->lcme_dstripe_count;
+			lec->lec_p = lcme->lcme_cstripe_count;
+		}
+	}
+
+	if (!data_found)
+		return -ENOENT;
+	lec->lec_init = init;
+	if (!parity_found || lec->lec_k == 0 || lec->lec_stripe_size == 0 ||
+	    lec->lec_stripe_size & ~PAGE_MASK)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* true if any component of the layout is stale */
+static bool ll_ec_layout_stale(const struct lov_comp_md_v1 *lcm)
+{
+	int i;
+
+	for (i = 0; i < le16_to_cpu(lcm->lcm_entry_count); i++)
+		if (le32_to_cpu(lcm->lcm_entries[i].lcme_flags) &
+		    LCME_FL_STALE)
+			return true;
+
+	return false;
+}
+
+/* offset of parity chunk @j of stripe row @row in the file */
+static inline u64 ll_ec_parity_pos(const struct ll_ec_comp *lec, u64 row,
+				   int j)
+{
+	return lec->lec_start + (row * lec->lec_p + j) * lec->lec_stripe_size;
+}
+
+static void ll_ec_io_fini(struct ll_ec_io *lei)
+{
+	size_t size = lei->lei_count * lei->lei_unit;
+
+	if (lei->lei_buf)
+		OBD_FREE_LARGE(lei->lei_buf, size);
+	if (lei->lei_bvec)
+		OBD_FREE_PTR_ARRAY_LARGE(lei->lei_bvec, size >> PAGE_SHIFT);
+	if (lei->lei_ptrs)
+		OBD_FREE_PTR_ARRAY(lei->lei_ptrs,
+				   lei->lei_count + lei->lei_comp.lec_k);
+	if (lei->lei_valid)
+		OBD_FREE_PTR_ARRAY(lei->lei_valid, lei->lei_count);
+	if (lei->lei_miss)
+		OBD_FREE_PTR_ARRAY(lei->lei_miss, lei->lei_count);
+	if (lei->lei_matrix)
+		OBD_FREE_LARGE(lei->lei_matrix, lei->lei_matrix_size);
+	lei->lei_buf = NULL;
+	lei->lei_bvec = NULL;
+	lei->lei_ptrs = NULL;
+	lei->lei_valid = NULL;
+	lei->lei_miss = NULL;
+	lei->lei_matrix = NULL;
+}
+
+/* set @lei up for the component @lec, with @count slices */
+static int ll_ec_io_setup(struct ll_ec_io *lei, const struct ll_ec_comp *lec,
+			  int count)
+{
+	int k = lec->lec_k;
+	int p = lec->lec_p;
+	size_t unit;
+	int i;
+
+	if (lei->lei_buf && lei->lei_count == count &&
+	    lei->lei_comp.lec_k == k && lei->lei_comp.lec_p == p &&
+	    lei->lei_comp.lec_stripe_size == lec->lec_stripe_size) {
+		lei->lei_comp = *lec;
+		return 0;
+	}
+
+	ll_ec_io_fini(lei);
+	unit = round_down(LL_EC_BUF_SIZE / count, PAGE_SIZE);
+	unit = clamp_t(u64, unit, PAGE_SIZE, lec->lec_stripe_size);
+	lei->lei_comp = *lec;
+	lei->lei_unit = unit;
+	lei->lei_count = count;
+	lei->lei_matrix_size = (k + p) * k + 2 * k * k + 32 * k * p + 32 * k;
+
+	OBD_VMALLOC(lei->lei_buf, count * unit);
+	OBD_ALLOC_PTR_ARRAY_LARGE(lei->lei_bvec, count * unit >> PAGE_SHIFT);
+	OBD_ALLOC_PTR_ARRAY(lei->lei_ptrs, count + k);
+	OBD_ALLOC_PTR_ARRAY(lei->lei_valid, count);
+	OBD_ALLOC_PTR_ARRAY(lei->lei_miss, count);
+	OBD_ALLOC_LARGE(lei->lei_matrix, lei->lei_matrix_size);
+	if (!lei->lei_buf || !lei->lei_bvec || !lei->lei_ptrs ||
+	    !lei->lei_valid || !lei->lei_miss || !lei->lei_matrix) {
+		ll_ec_io_fini(lei);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count * unit >> PAGE_SHIFT; i++) {
+		lei->lei_bvec[i].bv_page =
+			vmalloc_to_page(lei->lei_buf + (i << PAGE_SHIFT));
+		lei->lei_bvec[i].bv_len = PAGE_SIZE;
+		lei->lei_bvec[i].bv_offset = 0;
+	}
+	for (i = 0; i < count; i++)
+		lei->lei_ptrs[i] = lei->lei_buf + i * unit;
+
+	lei->lei_dec = lei->lei_matrix + (k + p) * k;
+	lei->lei_tbls = lei->lei_dec + 2 * k * k;
+	lei->lei_dec_tbls = lei->lei_tbls + 32 * k * p;
+	gf_gen_cauchy1_matrix(lei->lei_matrix, k + p, k);
+	ec_init_tables(k, p, &lei->lei_matrix[k * k], lei->lei_tbls);
+
+	return 0;
+}
+
+/* direct I/O of @len bytes of slice @i at @pos of mirror @mirror_id */
+static ssize_t ll_ec_slice_io(struct ll_ec_io *lei, enum cl_io_type iot,
+			      u32 mirror_id, int i, size_t len, loff_t pos)
+{
+	struct iov_iter iter;
+
+	iov_iter_bvec(&iter, iot == CIT_READ ? READ : WRITE,
+		      &lei->lei_bvec[i * lei->lei_unit >> PAGE_SHIFT],
+		      len >> PAGE_SHIFT, len);
+
+	return ll_file_mirror_io(lei->lei_file, iot, mirror_id, &iter, pos);
+}
+
+/* read slice @i, the part beyond EOF is zeroed, return the bytes read */
+static ssize_t ll_ec_slice_read(struct ll_ec_io *lei, u32 mirror_id, int i,
+				size_t len, loff_t pos)
+{
+	ssize_t rc;
+
+	rc = ll_ec_slice_io(lei, CIT_READ, mirror_id, i, len, pos);
+	if (rc >= 0 && rc < len)
+		memset(lei->lei_ptrs[i] + rc, 0, len - rc);
+
+	return rc;
+}
+
+static int ll_ec_slice_write(struct ll_ec_io *lei, u32 mirror_id, int i,
+			     size_t len, loff_t pos)
+{
+	ssize_t rc;
+
+	rc = ll_ec_slice_io(lei, CIT_WRITE, mirror_id, i, len, pos);
+	if (rc >= 0 && rc != len)
+		rc = -EIO;
+
+	return rc < 0 ? rc : 0;
+}
+
+/*
+ * Encode the parity of bytes [@off, @off + @len) of the chunks of stripe row
+ * @row from its data, reading all the data chunks but @skip, which is in its
+ * slice already.
+ */
+static int ll_ec_row_encode(struct ll_ec_io *lei, u64 row, size_t off,
+			    size_t len, int skip)
+{
+	const struct ll_ec_comp *lec = &lei->lei_comp;
+	u64 row_start = lec->lec_start + row * lec->lec_k * lec->lec_stripe_size;
+	ssize_t rc;
+	int i;
+
+	for (i = 0; i < lec->lec_k; i++) {
+		if (i == skip)
+			continue;
+
+		rc = ll_ec_slice_read(lei, lec->lec_data_mirror, i, len,
+				      row_start + i * lec->lec_stripe_size +
+				      off);
+		if (rc < 0)
+			return rc;
+	}
+
+	ec_encode_data(len, lec->lec_k, lec->lec_p, lei->lei_tbls,
+		       lei->lei_ptrs, &lei->lei_ptrs[lec->lec_k]);
+
+	return 0;
+}
+
+/*
+ * Update the parity of bytes [@off, @off + @len) of stripe row @row for the
+ * new data of chunk @i, which is in its slice.  The old data and parity are
+ * read and the difference between old and new data is added to the parity,
+ * so the other data chunks of the row are not read.  Parity beyond EOF @size
+ * cannot be read through the file, then the whole row is encoded again.
+ */
+static int ll_ec_row_update(struct ll_ec_io *lei, u64 row, size_t off,
+			    size_t len, int i, loff_t size)
+{
+	const struct ll_ec_comp *lec = &lei->lei_comp;
+	int k = lec->lec_k;
+	int p = lec->lec_p;
+	unsigned long *delta = (unsigned long *)lei->lei_ptrs[k + p];
+	unsigned long *data = (unsigned long *)lei->lei_ptrs[i];
+	ssize_t rc;
+	size_t w;
+	int j;
+
+	if (ll_ec_parity_pos(lec, row, p - 1) + off + len > size)
+		return ll_ec_row_encode(lei, row, off, len, i);
+
+	rc = ll_ec_slice_read(lei, lec->lec_data_mirror, k + p, len,
+			      lec->lec_start +
+			      (row * k + i) * lec->lec_stripe_size + off);
+	for (j = 0; j < p && rc >= 0; j++)
+		rc = ll_ec_slice_read(lei, lec->lec_parity_mirror, k + j, len,
+				      ll_ec_parity_pos(lec, row, j) + off);
+	if (rc < 0)
+		return rc;
+
+	/* slices are whole pages */
+	for (w = 0; w < len / sizeof(*delta); w++)
+		delta[w] ^= data[w];
+	ec_encode_data_update(len, k, p, i, lei->lei_tbls,
+			      (unsigned char *)delta, &lei->lei_ptrs[k]);
+
+	return 0;
+}
+
+/* write the parity slices of bytes [@off, @off + @len) of stripe row @row */
+static int ll_ec_parity_write(struct ll_ec_io *lei, u64 row, size_t off,
+			      size_t len)
+{
+	const struct ll_ec_comp *lec = &lei->lei_comp;
+	int rc = 0;
+	int j;
+
+	for (j = 0; j < lec->lec_p && !rc; j++)
+		rc = ll_ec_slice_write(lei, lec->lec_parity_mirror,
+				       lec->lec_k + j, len,
+				       ll_ec_parity_pos(lec, row, j) + off);
+
+	return rc;
+}
+
+/**
+ * ll_ec_parity_resync() - Encode the parity of an erasure coded component
+ * @file: file holding the resync lease
+ * @comp_id: id of the LCME_FL_PARITY component
+ *
+ * The data component sharing the extent of the parity component is read
+ * from the data mirror one slice of a stripe row at a time, and the parity
+ * of the slice is written to the parity mirror.  This is LL_IOC_EC_PARITY_RESYNC,
+ * called by mirror resync once the data mirror is in sync.  Parity written
+ * past EOF does not change the size of the file.
+ *
+ * Return:
+ * * %0 on success
+ * * negative errno on failure
+ */
+int ll_ec_parity_resync(struct file *file, __u32 comp_id)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_file_data *lfd = file->private_data;
+	struct ll_ec_io lei = { .lei_file = file };
+	struct lov_comp_md_v1 *lcm;
+	struct ll_ec_comp lec;
+	u64 row_size, nrows, row, end;
+	size_t lcm_size, off, len;
+	int rc, i;
+
+	ENTRY;
+	if (lfd->fd_lease_och == NULL)
+		RETURN(-ENOLCK);
+
+	rc = ll_ec_layout_get(inode, &lcm, &lcm_size);
+	if (rc)
+		RETURN(rc);
+
+	rc = -ENOENT;
+	for (i = 0; i < le16_to_cpu(lcm->lcm_entry_count); i++) {
+		struct lov_comp_md_entry_v1 *lcme = &lcm->lcm_entries[i];
+
+		if (le32_to_cpu(lcme->lcme_id) != comp_id)
+			continue;
+		if (!(le32_to_cpu(lcme->lcme_flags) & LCME_FL_PARITY))
+			break;
+
+		rc = ll_ec_comp_find(lcm,
+				     le64_to_cpu(lcme->lcme_extent.e_start),
+				     &lec);
+		if (!rc && lec.lec_parity_id != comp_id)
+			rc = -EINVAL;
+		break;
+	}
+	OBD_FREE_LARGE(lcm, lcm_size);
+	if (rc)
+		RETURN(rc);
+
+	rc = ll_glimpse_size(inode);
+	if (rc)
+		RETURN(rc);
+
+	row_size = lec.lec_k * lec.lec_stripe_size;
+	end = min_t(u64, lec.lec_end, i_size_read(inode));
+	if (end <= lec.lec_start)
+		RETURN(0);
+	nrows = div64_u64(end - lec.lec_start + row_size - 1, row_size);
+
+	rc = ll_ec_io_setup(&lei, &lec, lec.lec_k + lec.lec_p);
+	if (rc)
+		RETURN(rc);
+
+	for (row = 0; row < nrows && !rc; row++) {
+		for (off = 0; off < lec.lec_stripe_size && !rc; off += len) {
+			len = min_t(u64, lei.lei_unit,
+				    lec.lec_stripe_size - off);
+			rc = ll_ec_row_encode(&lei, row, off, len, -1);
+			if (!rc)
+				rc = ll_ec_parity_write(&lei, row, off, len);
+		}
+	}
+	ll_ec_io_fini(&lei);
+
+	RETURN(rc);
+}
+
+/*
+ * Rebuild the first @len bytes of slice @lost from the other slices of its
+ * stripe row.  lei_valid[i] is the number of bytes of slice i holding data
+ * and lei_miss[i] tells which slices could not be read, they are zeroed.
+ *
+ * Data beyond EOF is known to be zero and parity beyond EOF cannot be read
+ * through the file, so the slice is decoded in byte ranges: in each range
+ * the unknowns are the missing data chunks which still hold file data there,
+ * and only the parity chunks readable over the whole range may be used.
+ */
+static int ll_ec_rebuild(struct ll_ec_io *lei, size_t len, int lost)
+{
+	const struct ll_ec_comp *lec = &lei->lei_comp;
+	unsigned char **srcs = lei->lei_ptrs + lei->lei_count;
+	const size_t *valid = lei->lei_valid;
+	const bool *miss = lei->lei_miss;
+	int k = lec->lec_k;
+	int n = k + lec->lec_p;
+	unsigned char *inv = lei->lei_dec + k * k;
+	unsigned char *dest;
+	size_t lo = 0;
+	int i;
+
+	while (lo < valid[lost]) {
+		size_t hi = len;
+		int nsurv = 0;
+
+		/* the next point where the set of known chunks changes */
+		for (i = 0; i < n; i++)
+			if ((i >= k || miss[i]) && valid[i] > lo &&
+			    valid[i] < hi)
+				hi = valid[i];
+
+		for (i = 0; i < n && nsurv < k; i++) {
+			if (i < k ? miss[i] && valid[i] > lo :
+				    miss[i] || valid[i] < hi)
+				continue;
+
+			memcpy(&lei->lei_dec[nsurv * k],
+			       &lei->lei_matrix[i * k], k);
+			srcs[nsurv++] = lei->lei_ptrs[i] + lo;
+		}
+		if (nsurv < k)
+			return -EIO;
+
+		if (gf_invert_matrix(lei->lei_dec, inv, k))
+			return -EIO;
+
+		ec_init_tables(k, 1, &inv[lost * k], lei->lei_dec_tbls);
+		dest = lei->lei_ptrs[lost] + lo;
+		ec_encode_data(hi - lo, k, 1, lei->lei_dec_tbls, srcs, &dest);
+		lo = hi;
+	}
+
+	return 0;
+}
+
+/**
+ * ll_ec_file_read() - Read an erasure coded file from its parity
+ * @iocb: read whose data mirror could not be read
+ * @to: destination of the data
+ *
+ * Each chunk which cannot be read from the data mirror is rebuilt from the
+ * other data chunks of its stripe row and their parity.  Parity which is
+ * stale is never used.
+ *
+ * Return:
+ * * number of bytes read, short only at EOF
+ * * -EIO if the file is not erasure coded or a chunk cannot be rebuilt
+ * * other negative errno on failure
+ */
+ssize_t ll_ec_file_read(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file_inode(file);
+	struct ll_file_data *lfd = file->private_data;
+	struct ll_ec_io lei = { .lei_file = file };
+	struct lov_comp_md_v1 *lcm;
+	loff_t pos = iocb->ki_pos;
+	ssize_t result = 0;
+	size_t lcm_size;
+	loff_t size;
+	ssize_t rc;
+
+	ENTRY;
+	rc = ll_ec_layout_get(inode, &lcm, &lcm_size);
+	if (rc)
+		RETURN(rc == -ENODATA ? -EIO : rc);
+
+	rc = ll_glimpse_size(inode);
+	if (rc)
+		GOTO(out, rc);
+	size = i_size_read(inode);
+
+	while (iov_iter_count(to) > 0 && pos < size) {
+		struct ll_ec_comp lec;
+		u64 off, row, row_start, S;
+		size_t chunk_off, slice_off, skip, len, bytes;
+		int i, k, n, lost;
+
+		rc = ll_ec_comp_find(lcm, pos, &lec);
+		if (rc)
+			GOTO(out, rc = -EIO);
+		/* designated read of another mirror */
+		if (lfd->fd_designated_mirror > 0 &&
+		    lfd->fd_designated_mirror != lec.lec_data_mirror)
+			GOTO(out, rc = -EIO);
+
+		k = lec.lec_k;
+		n = k + lec.lec_p;
+		rc = ll_ec_io_setup(&lei, &lec, n);
+		if (rc)
+			GOTO(out, rc);
+
+		S = lec.lec_stripe_size;
+		off = pos - lec.lec_start;
+		row = div64_u64(off, k * S);
+		row_start = lec.lec_start + row * k * S;
+		lost = div64_u64(off - row * k * S, S);
+		chunk_off = off - row * k * S - lost * S;
+		slice_off = round_down(chunk_off, PAGE_SIZE);
+		len = min_t(u64, lei.lei_unit, S - slice_off);
+		skip = chunk_off - slice_off;
+		bytes = min_t(u64, min(len - skip, iov_iter_count(to)),
+			      size - pos);
+
+		rc = ll_ec_slice_read(&lei, lec.lec_data_mirror, lost, len,
+				      row_start + lost * S + slice_off);
+		if (rc >= 0) {
+			if (rc < skip + bytes)
+				bytes = rc > skip ? rc - skip : 0;
+			if (bytes == 0)
+				break;
+			goto copy;
+		}
+
+		for (i = 0; i < n; i++) {
+			loff_t cpos;
+
+			if (i < k) {
+				cpos = row_start + i * S + slice_off;
+				/* bytes of file data held by the slice */
+				lei.lei_valid[i] = cpos < size ?
+					min_t(u64, len, size - cpos) : 0;
+			} else {
+				cpos = ll_ec_parity_pos(&lec, row, i - k) +
+				       slice_off;
+				lei.lei_valid[i] = 0;
+			}
+
+			lei.lei_miss[i] = i == lost ||
+					  (i >= k && lec.lec_parity_stale);
+			if (!lei.lei_miss[i]) {
+				rc = ll_ec_slice_read(&lei, i < k ?
+						      lec.lec_data_mirror :
+						      lec.lec_parity_mirror,
+						      i, len, cpos);
+				if (rc < 0)
+					lei.lei_miss[i] = true;
+				else if (i >= k)
+					lei.lei_valid[i] = rc;
+			}
+			if (lei.lei_miss[i])
+				memset(lei.lei_ptrs[i], 0, len);
+		}
+
+		rc = ll_ec_rebuild(&lei, len, lost);
+		if (rc) {
+			CDEBUG(D_VFSTRACE, DFID": cannot rebuild chunk %d of row %llu: rc = %zd\n",
+			       PFID(ll_inode2fid(inode)), lost, row, rc);
+			GOTO(out, rc);
+		}
+copy:
+		if (copy_to_iter(lei.lei_ptrs[lost] + skip, bytes, to) != bytes)
+			GOTO(out, rc = -EFAULT);
+		pos += bytes;
+		result += bytes;
+	}
+	rc = 0;
+out:
+	iocb->ki_pos = pos;
+	ll_ec_io_fini(&lei);
+	OBD_FREE_LARGE(lcm, lcm_size);
+
+	RETURN(result > 0 ? result : rc);
+}
+
+/**
+ * ll_ec_file_write() - Write an erasure coded file and its parity
+ * @iocb: direct write, not appending
+ * @from: source of the data
+ * @handled: set if the write was done here
+ *
+ * A page aligned direct write to erasure coded components whose mirrors are
+ * in sync is written to the data mirror one slice at a time, each followed by
+ * the parity of its stripe row updated by read-modify-write, under a resync
+ * lease so the parity mirror is not made stale.  Other writes are left to the normal write path, and make
+ * the parity stale until it is resynced.  If writing the parity fails, a write
+ * intent makes it stale.
+ *
+ * Return:
+ * * number of bytes written, short if the write leaves the erasure coded
+ *   components, when @handled
+ * * negative errno on failure, when @handled
+ */
+ssize_t ll_ec_file_write(struct kiocb *iocb, struct iov_iter *from,
+			 bool *handled)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file_inode(file);
+	struct ll_file_data *lfd = file->private_data;
+	struct ll_ec_io lei = { .lei_file = file };
+	struct lov_comp_md_v1 *lcm;
+	struct ll_ec_comp lec;
+	loff_t pos = iocb->ki_pos;
+	size_t count = iov_iter_count(from);
+	size_t lcm_size, len = 0;
+	ssize_t done = 0;
+	loff_t size;
+	bool broken;
+	ssize_t rc;
+
+	ENTRY;
+	*handled = false;
+	if ((pos | count) & ~PAGE_MASK || lfd->fd_designated_mirror > 0 ||
+	    lfd->fd_lease_och != NULL)
+		RETURN(0);
+
+	rc = ll_ec_layout_get(inode, &lcm, &lcm_size);
+	if (rc)
+		RETURN(0);
+	rc = ll_ec_comp_find(lcm, pos, &lec);
+	if (!rc && (!lec.lec_init || ll_ec_layout_stale(lcm)))
+		rc = -EAGAIN;
+	OBD_FREE_LARGE(lcm, lcm_size);
+	if (rc)
+		RETURN(0);
+
+	rc = ll_file_resync_begin(file, lec.lec_data_mirror);
+	if (rc) {
+		CDEBUG(D_VFSTRACE, DFID": cannot take resync lease: rc = %zd\n",
+		       PFID(ll_inode2fid(inode)), rc);
+		RETURN(0);
+	}
+
+	/* the layout may have changed before the lease was granted */
+	rc = ll_ec_layout_get(inode, &lcm, &lcm_size);
+	if (rc)
+		GOTO(out_unhandled, rc);
+	if (ll_ec_layout_stale(lcm)) {
+		OBD_FREE_LARGE(lcm, lcm_size);
+		GOTO(out_unhandled, rc = -EAGAIN);
+	}
+
+	rc = ll_glimpse_size(inode);
+	if (rc) {
+		OBD_FREE_LARGE(lcm, lcm_size);
+		GOTO(out_unhandled, rc);
+	}
+	size = i_size_read(inode);
+
+	while (iov_iter_count(from) > 0) {
+		u64 S, off, row, chunk_off;
+		int i, k;
+
+		rc = ll_ec_comp_find(lcm, pos, &lec);
+		if (rc || !lec.lec_init) {
+			/* the rest is written by the caller again */
+			rc = 0;
+			break;
+		}
+
+		k = lec.lec_k;
+		/* the slices of the row, then the old data of the chunk */
+		rc = ll_ec_io_setup(&lei, &lec, k + lec.lec_p + 1);
+		if (rc)
+			break;
+
+		S = lec.lec_stripe_size;
+		off = pos - lec.lec_start;
+		row = div64_u64(off, k * S);
+		i = div64_u64(off - row * k * S, S);
+		chunk_off = off - row * k * S - i * S;
+		len = min_t(u64, min_t(u64, lei.lei_unit, S - chunk_off),
+			    iov_iter_count(from));
+
+		rc = copy_from_iter(lei.lei_ptrs[i], len, from);
+		if (rc != len) {
+			iov_iter_revert(from, rc);
+			rc = -EFAULT;
+			break;
+		}
+
+		rc = ll_ec_row_update(&lei, row, chunk_off, len, i, size);
+		if (!rc)
+			rc = ll_ec_slice_write(&lei, lec.lec_data_mirror, i,
+					       len, pos);
+		if (!rc)
+			rc = ll_ec_parity_write(&lei, row, chunk_off, len);
+		if (rc) {
+			iov_iter_revert(from, len);
+			break;
+		}
+
+		pos += len;
+		done += len;
+		size = max(size, pos);
+	}
+	OBD_FREE_LARGE(lcm, lcm_size);
+	ll_ec_io_fini(&lei);
+
+	if (rc < 0) {
+		struct lu_extent ext = {
+			.e_start = pos,
+			.e_end = pos + len,
+		};
+		int rc2;
+
+		ll_file_resync_end(file, false, NULL);
+		/* the parity of the slice may not match its data */
+		rc2 = ll_layout_write_intent(inode, LAYOUT_INTENT_WRITE, &ext);
+		if (rc2)
+			CERROR("%s: cannot stale parity of "DFID" "DEXT": rc = %d\n",
+			       ll_i2sbi(inode)->ll_fsname,
+			       PFID(ll_inode2fid(inode)), PEXT(&ext), rc2);
+	} else {
+		/* a broken lease leaves the file to the opener breaking it */
+		ll_file_resync_end(file, true, &broken);
+	}
+
+	iocb->ki_pos = pos;
+	*handled = done > 0 || rc < 0;
+
+	RETURN(done > 0 ? done : rc);
+
+out_unhandled:
+	ll_file_resync_end(file, false, NULL);
+
+	RETURN(0);
+}
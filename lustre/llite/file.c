@@ -1437,11 +1437,10 @@ static int ll_lease_close(struct obd_client_handle *och, struct inode *inode,
 
 /* After lease is taken, send the RPC MDS_REINT_RESYNC to the MDT */
 static int ll_lease_file_resync(struct obd_client_handle *och,
-				struct inode *inode, void __user *uarg)
+				struct inode *inode, __u16 mirror_id)
 {
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
 	struct md_op_data *op_data;
-	struct ll_ioc_lease_id ioc;
 	__u64 data_version_unused;
 	int rc;
 
@@ -1451,9 +1450,6 @@ static int ll_lease_file_resync(struct obd_client_handle *och,
 	if (IS_ERR(op_data))
 		RETURN(PTR_ERR(op_data));
 
-	if (copy_from_user(&ioc, uarg, sizeof(ioc)))
-		RETURN(-EFAULT);
-
 	/* before starting file resync, it's necessary to clean up page cache
 	 * in client memory, otherwise once the layout version is increased,
 	 * writing back cached data will be denied the OSTs.
@@ -1463,7 +1459,7 @@ static int ll_lease_file_resync(struct obd_client_handle *och,
 		GOTO(out, rc);
 
 	op_data->op_lease_handle = och->och_lease_handle;
-	op_data->op_mirror_id = ioc.lil_mirror_id;
+	op_data->op_mirror_id = mirror_id;
 	rc = md_file_resync(sbi->ll_md_exp, op_data);
 	if (rc)
 		GOTO(out, rc);
@@ -1474,6 +1470,98 @@ out:
 	return rc;
 }
 
+/**
+ * ll_file_resync_begin() - Take a resync lease from the kernel
+ * @file: file to resync
+ * @mirror_id: mirror written, 0 for all the stale mirrors
+ *
+ * This is LL_IOC_SET_LEASE with LL_LEASE_RESYNC, for the erasure coding
+ * done in the kernel.  The layout version to write with is saved in
+ * fd_layout_version.
+ *
+ * Return:
+ * * %0 on success
+ * * negative errno on failure
+ */
+int ll_file_resync_begin(struct file *file, __u16 mirror_id)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_file_data *lfd = file->private_data;
+	struct obd_client_handle *och;
+	__u32 gen;
+	int rc;
+
+	ENTRY;
+	och = ll_lease_open(inode, file, FMODE_WRITE, MDS_OPEN_RESYNC);
+	if (IS_ERR(och))
+		RETURN(PTR_ERR(och));
+
+	rc = ll_lease_file_resync(och, inode, mirror_id);
+	if (!rc)
+		rc = ll_layout_refresh(inode, &gen);
+	if (!rc) {
+		mutex_lock(&lli->lli_och_mutex);
+		if (lfd->fd_lease_och == NULL) {
+			lfd->fd_lease_och = och;
+			lfd->fd_layout_version = gen;
+		} else {
+			rc = -EBUSY;
+		}
+		mutex_unlock(&lli->lli_och_mutex);
+	}
+	if (rc) {
+		ll_lease_close(och, inode, NULL);
+		ll_lease_och_release(inode, file);
+	}
+
+	RETURN(rc);
+}
+
+/**
+ * ll_file_resync_end() - Release the lease of ll_file_resync_begin()
+ * @file: file resynced
+ * @done: mark the file in sync again, as LL_LEASE_RESYNC_DONE
+ * @broken: set if the lease was broken, may be NULL
+ *
+ * No component is marked stale by @done.  A broken lease leaves the file
+ * state as the opener which broke it made it.
+ *
+ * Return:
+ * * %0 on success
+ * * negative errno on failure
+ */
+int ll_file_resync_end(struct file *file, bool done, bool *broken)
+{
+	struct ll_ioc_lease ioc = {
+		.lil_mode = LL_LEASE_UNLCK,
+		.lil_flags = LL_LEASE_RESYNC_DONE,
+		.lil_count = 0,
+	};
+	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_file_data *lfd = file->private_data;
+	struct obd_client_handle *och;
+	int rc, rc2;
+
+	ENTRY;
+	mutex_lock(&lli->lli_och_mutex);
+	och = lfd->fd_lease_och;
+	lfd->fd_lease_och = NULL;
+	mutex_unlock(&lli->lli_och_mutex);
+
+	if (och == NULL)
+		RETURN(-ENOLCK);
+
+	rc = ll_lease_close_intent(och, inode, broken,
+				   done ? MDS_CLOSE_RESYNC_DONE : 0,
+				   done ? &ioc : NULL);
+	rc2 = ll_lease_och_release(inode, file);
+	ll_layout_refresh(inode, &lfd->fd_layout_version);
+
+	RETURN(rc ? rc : rc2);
+}
+
 static int ll_merge_attr_nolock(const struct lu_env *env, struct inode *inode)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
@@ -1715,6 +1803,13 @@ void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot,
 		io->ci_hybrid_switched = args->via_hybrid_switched;
 
 	ll_io_set_mirror(io, file);
+
+	/* erasure coding I/O in the kernel, see ll_file_mirror_io() */
+	if (args && args->via_mirror_id > 0) {
+		io->ci_ndelay = 0;
+		io->ci_designated_mirror = args->via_mirror_id;
+		io->ci_layout_version = lfd->fd_layout_version;
+	}
 }
 
 static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
@@ -2062,6 +2157,53 @@ out:
 	RETURN(result > 0 ? result : rc);
 }
 
+/**
+ * ll_file_mirror_io() - Direct I/O to a designated mirror from the kernel
+ * @file: file to read or write
+ * @iot: CIT_READ or CIT_WRITE
+ * @mirror_id: mirror to read or write
+ * @iter: pages to read into or write from, aligned on pages
+ * @pos: file offset, aligned on pages
+ *
+ * This is the I/O done through LL_IOC_FLR_SET_MIRROR, without changing the
+ * mirror set on @file, for LL_IOC_FLR_MIRROR_IO and erasure coding in the
+ * kernel.  Writes carry the layout version of the resync lease held on @file.
+ *
+ * Return:
+ * * number of bytes read or written
+ * * negative errno on failure
+ */
+ssize_t ll_file_mirror_io(struct file *file, enum cl_io_type iot,
+			  __u32 mirror_id, struct iov_iter *iter, loff_t pos)
+{
+	struct vvp_io_args *args;
+	struct kiocb kiocb;
+	struct lu_env *env;
+	__u16 refcheck;
+	ssize_t rc;
+
+	ENTRY;
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		RETURN(PTR_ERR(env));
+
+	init_sync_kiocb(&kiocb, file);
+	kiocb.ki_pos = pos;
+	kiocb.ki_flags = (kiocb.ki_flags | IOCB_DIRECT) & ~IOCB_APPEND;
+
+	args = ll_env_args(env);
+	args->u.normal.via_iter = iter;
+	args->u.normal.via_iocb = &kiocb;
+	args->via_hybrid_switched = 0;
+	args->via_mirror_id = mirror_id;
+	rc = ll_file_io_generic(env, args, file, iot, &kiocb.ki_pos,
+				iov_iter_count(iter));
+	args->via_mirror_id = 0;
+	cl_env_put(env, &refcheck);
+
+	RETURN(rc);
+}
+
 /*
  * The purpose of fast read is to overcome per I/O overhead and improve IOPS
  * especially for small I/O.
@@ -2355,6 +2497,9 @@ static ssize_t do_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 
 	rc2 = ll_file_io_generic(env, args, file, CIT_READ,
 				 &iocb->ki_pos, iov_iter_count(to));
+	/* rebuild the data of an erasure coded file from its parity */
+	if (rc2 == -EIO)
+		rc2 = ll_ec_file_read(iocb, to);
 	if (rc2 > 0)
 		result += rc2;
 	else if (result == 0)
@@ -2470,6 +2615,7 @@ static ssize_t do_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	ssize_t rc_normal;
 	__u16 refcheck;
 	bool cached;
+	bool handled;
 	int result;
 
 	ENTRY;
@@ -2506,12 +2652,24 @@ static ssize_t do_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 #endif
 	}
 
+	/* direct writes to erasure coded files update the parity in place */
+	if ((iocb_ki_flags_get(file, iocb) &
+	     (ki_flag(DIRECT) | ki_flag(APPEND))) == ki_flag(DIRECT)) {
+		rc_normal = ll_ec_file_write(iocb, from, &handled);
+		if (handled)
+			GOTO(out, rc_normal);
+	}
+
 	/* NB: we can't do direct IO for tiny writes because they use the page
 	 * cache, we can't do sync writes because tiny writes can't flush
 	 * pages, and we can't do append writes because we can't guarantee the
-	 * required DLM locks are held to protect file size.
+	 * required DLM locks are held to protect file size. Writes to
+	 * compressed components rewrite whole chunks, which tiny writes
+	 * cannot do.
 	 */
 	if (ll_sbi_has_tiny_write(ll_i2sbi(file_inode(file))) &&
+	    !test_bit(LLIF_COMPRESSED,
+		      &ll_i2info(file_inode(file))->lli_flags) &&
 	    !(flags &
 	      (ki_flag(DIRECT) | ki_flag(DSYNC) | ki_flag(SYNC) |
 	       ki_flag(APPEND))))
@@ -4391,6 +4549,45 @@ out:
 	RETURN(rc);
 }
 
+/*
+ * LL_IOC_FLR_MIRROR_IO: direct I/O to the mirror given with the I/O, so the
+ * threads of a resync sharing one open file do not race on
+ * LL_IOC_FLR_SET_MIRROR.
+ */
+static long ll_ioc_mirror_io(struct file *file, void __user *uarg)
+{
+	struct ll_ioc_mirror_io lmi;
+	struct iov_iter iter;
+	struct iovec iov;
+	int rw;
+
+	if (copy_from_user(&lmi, uarg, sizeof(lmi)))
+		return -EFAULT;
+
+	if (lmi.lmi_mirror_id == 0 || lmi.lmi_flags & ~LL_MIRROR_IO_WRITE)
+		return -EINVAL;
+
+	/* as for LL_IOC_FLR_SET_MIRROR */
+	if (!(file->f_flags & O_DIRECT))
+		return -EINVAL;
+
+	rw = lmi.lmi_flags & LL_MIRROR_IO_WRITE ? WRITE : READ;
+	if (!(file->f_mode & (rw == WRITE ? FMODE_WRITE : FMODE_READ)))
+		return -EBADF;
+
+	iov.iov_base = u64_to_user_ptr(lmi.lmi_buf);
+	iov.iov_len = min_t(u64, lmi.lmi_count, MAX_RW_COUNT);
+	if (iov.iov_len == 0)
+		return 0;
+	if (!ll_access_ok(iov.iov_base, iov.iov_len))
+		return -EFAULT;
+
+	ll_iov_iter_init(&iter, rw, &iov, 1, iov.iov_len);
+
+	return ll_file_mirror_io(file, rw == WRITE ? CIT_WRITE : CIT_READ,
+				 lmi.lmi_mirror_id, &iter, lmi.lmi_pos);
+}
+
 static long ll_file_set_lease(struct file *file, struct ll_ioc_lease *ioc,
 			      void __user *uarg)
 {
@@ -4399,6 +4596,7 @@ static long ll_file_set_lease(struct file *file, struct ll_ioc_lease *ioc,
 	struct ll_file_data *lfd = file->private_data;
 	struct obd_client_handle *och = NULL;
 	enum mds_open_flags open_flags = MDS_FMODE_CLOSED;
+	struct ll_ioc_lease_id ioc_id;
 	bool lease_broken;
 	fmode_t fmode; /* kernel permissions */
 	long rc;
@@ -4424,14 +4622,17 @@ static long ll_file_set_lease(struct file *file, struct ll_ioc_lease *ioc,
 	CDEBUG(D_INODE, "Set lease with mode %u\n", fmode);
 
 	/* apply for lease */
-	if (ioc->lil_flags & LL_LEASE_RESYNC)
+	if (ioc->lil_flags & LL_LEASE_RESYNC) {
+		if (copy_from_user(&ioc_id, uarg, sizeof(ioc_id)))
+			RETURN(-EFAULT);
 		open_flags = MDS_OPEN_RESYNC;
+	}
 	och = ll_lease_open(inode, file, fmode, open_flags);
 	if (IS_ERR(och))
 		RETURN(PTR_ERR(och));
 
 	if (ioc->lil_flags & LL_LEASE_RESYNC) {
-		rc = ll_lease_file_resync(och, inode, uarg);
+		rc = ll_lease_file_resync(och, inode, ioc_id.lil_mirror_id);
 		if (rc) {
 			ll_lease_close(och, inode, NULL);
 			RETURN(rc);
@@ -4880,6 +5081,16 @@ out_ladvise:
 		lfd->fd_designated_mirror = arg;
 		RETURN(0);
 	}
+	case LL_IOC_EC_PARITY_RESYNC: {
+		__u32 comp_id;
+
+		if (copy_from_user(&comp_id, uarg, sizeof(comp_id)))
+			RETURN(-EFAULT);
+
+		RETURN(ll_ec_parity_resync(file, comp_id));
+	}
+	case LL_IOC_FLR_MIRROR_IO:
+		RETURN(ll_ioc_mirror_io(file, uarg));
 	case LL_IOC_HEAT_GET: {
 		struct lu_heat uheat;
 		struct lu_heat *heat;
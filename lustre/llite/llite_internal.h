@@ -528,6 +528,8 @@ enum ll_inode_flags {
 	/* 6 is not used for now */
 	/* Xattr cache is filled */
 	LLIF_XATTR_CACHE_FILLED	= 7,
+	/* File has compressed components, writes rewrite whole chunks */
+	LLIF_COMPRESSED		= 8,
 
 /* New flags added to this enum potentially need to be handled in
  * ll_inode2ext_flags/ll_set_inode_flags
@@ -1364,6 +1366,9 @@ struct ll_cl_context *ll_cl_find(struct inode *inode);
 
 extern const struct address_space_operations ll_aops;
 
+/* llite/rw26.c */
+int ll_write_fill_range(struct file *file, loff_t start, loff_t end);
+
 /* llite/file.c */
 extern const struct inode_operations ll_file_inode_operations;
 const struct file_operations *ll_select_file_operations(struct ll_sb_info *sbi);
@@ -1474,6 +1479,16 @@ int ll_data_version(struct inode *inode, __u64 *data_version, int flags);
 int ll_hsm_release(struct inode *inode);
 int ll_hsm_state_set(struct inode *inode, struct hsm_state_set *hss);
 void ll_io_set_mirror(struct cl_io *io, const struct file *file);
+ssize_t ll_file_mirror_io(struct file *file, enum cl_io_type iot,
+			  __u32 mirror_id, struct iov_iter *iter, loff_t pos);
+int ll_file_resync_begin(struct file *file, __u16 mirror_id);
+int ll_file_resync_end(struct file *file, bool done, bool *broken);
+
+/* llite/ec.c */
+int ll_ec_parity_resync(struct file *file, __u32 comp_id);
+ssize_t ll_ec_file_read(struct kiocb *iocb, struct iov_iter *to);
+ssize_t ll_ec_file_write(struct kiocb *iocb, struct iov_iter *from,
+			 bool *handled);
 
 /* llite/dcache.c */
 
@@ -1596,6 +1611,8 @@ struct vvp_io_args {
 	} u;
 	/* did we switch this IO from BIO to DIO using hybrid IO? */
 	int	via_hybrid_switched:1;
+	/* mirror of an erasure coding I/O from the kernel, 0 if none */
+	__u32	via_mirror_id;
 };
 
 static inline unsigned int iocb_ki_flags_get(const struct file *file,
@@ -366,7 +366,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 				   OBD_CONNECT2_DMV_IMP_INHERIT |
 				   OBD_CONNECT2_UNALIGNED_DIO |
 				   OBD_CONNECT2_PCCRO |
-				   OBD_CONNECT2_MIRROR_ID_FIX;
+				   OBD_CONNECT2_MIRROR_ID_FIX |
+				   OBD_CONNECT2_BATCH_REINT;
 
 #ifdef HAVE_LRU_RESIZE_SUPPORT
 	if (test_bit(LL_SBI_LRU_RESIZE, sbi->ll_flags))
@@ -590,7 +591,8 @@ retry_connect:
 	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD |
 				   OBD_CONNECT2_INC_XID | OBD_CONNECT2_LSEEK |
 				   OBD_CONNECT2_REP_MBITS |
-				   OBD_CONNECT2_UNALIGNED_DIO;
+				   OBD_CONNECT2_UNALIGNED_DIO |
+				   OBD_CONNECT2_COMPRESS;
 
 	if (!CFS_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -2210,6 +2212,144 @@ putenv:
 	RETURN(rc);
 }
 
+/*
+ * Compressed chunks are stored from the start of the chunk, so a truncate in
+ * the middle of a chunk would cut its compressed data on the OST. The data of
+ * the chunk before the new @size is written again first, which stores it
+ * plain as the chunk is not written whole.
+ */
+static int ll_io_compr_rewrite_chunk(struct inode *inode, loff_t size)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct cl_object *clob = lli->lli_clob;
+	struct cl_layout cl = {
+		.cl_is_composite = false,
+	};
+	__u16 refcheck;
+	struct lu_env *env;
+	struct cl_io *io;
+	struct cl_lock *lock;
+	struct cl_lock_descr *descr;
+	struct cl_2queue *queue;
+	struct cl_page *clpage;
+	bool holdinglock = false;
+	loff_t start;
+	pgoff_t index;
+	pgoff_t last;
+	int rc;
+
+	ENTRY;
+
+	if (!clob || size == 0 || size >= i_size_read(inode))
+		RETURN(0);
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		RETURN(PTR_ERR(env));
+
+	rc = cl_object_layout_get(env, clob, &cl);
+	if (rc < 0)
+		GOTO(putenv, rc);
+	rc = 0;
+	if (!cl.cl_compr_chunk_bits ||
+	    !(size & ((1ULL << cl.cl_compr_chunk_bits) - 1)))
+		GOTO(putenv, rc);
+
+	start = round_down(size, 1ULL << cl.cl_compr_chunk_bits);
+	last = (size - 1) >> PAGE_SHIFT;
+
+	/* cached changes of the chunk are written first */
+	rc = filemap_write_and_wait_range(inode->i_mapping, start, size - 1);
+	if (rc)
+		GOTO(putenv, rc);
+
+	io = vvp_env_new_io(env);
+	io->ci_obj = clob;
+	rc = cl_io_rw_init(env, io, CIT_WRITE, start, size - start);
+	if (rc)
+		GOTO(putenv, rc);
+
+	lock = vvp_env_new_lock(env);
+	descr = &lock->cll_descr;
+	descr->cld_obj   = io->ci_obj;
+	descr->cld_start = start >> PAGE_SHIFT;
+	descr->cld_end   = last;
+	descr->cld_mode  = CLM_WRITE;
+	descr->cld_enq_flags = CEF_MUST | CEF_NONBLOCK;
+
+	rc = cl_lock_request(env, io, lock);
+	if (rc == -ECANCELED || rc == -EEXIST)
+		rc = 0;
+	else if (rc < 0)
+		GOTO(iofini, rc);
+	else
+		holdinglock = true;
+
+	queue = &io->ci_queue;
+	cl_2queue_init(queue);
+	for (index = start >> PAGE_SHIFT; index <= last; index++) {
+		struct page *vmpage;
+
+		vmpage = grab_cache_page(inode->i_mapping, index);
+		if (!vmpage)
+			GOTO(queuefini, rc = -ENOMEM);
+
+		wait_on_page_writeback(vmpage);
+		/* dirtied again since the flush above */
+		if (PageDirty(vmpage)) {
+			unlock_page(vmpage);
+			put_page(vmpage);
+			GOTO(queuefini, rc = -EAGAIN);
+		}
+
+		clpage = cl_page_find(env, clob, index, vmpage, CPT_CACHEABLE);
+		if (IS_ERR(clpage)) {
+			unlock_page(vmpage);
+			put_page(vmpage);
+			GOTO(queuefini, rc = PTR_ERR(clpage));
+		}
+		/* the cl_page holds a reference on the vmpage */
+		put_page(vmpage);
+
+		cl_page_assume(env, io, clpage);
+		if (!PageUptodate(vmpage)) {
+			/* keep the vmpage locked, see ll_io_zero_page() */
+			SetPagePrivate2(vmpage);
+			rc = ll_io_read_page(env, io, clpage, NULL);
+			ClearPagePrivate2(vmpage);
+			if (!rc && !PageUptodate(vmpage))
+				rc = -EIO;
+			if (rc) {
+				cl_page_disown(env, io, clpage);
+				cl_page_put(env, clpage);
+				GOTO(queuefini, rc);
+			}
+		}
+
+		if (index == last && size & ~PAGE_MASK)
+			zero_user(vmpage, size & ~PAGE_MASK,
+				  PAGE_SIZE - (size & ~PAGE_MASK));
+
+		cl_page_list_add(&queue->c2_qin, clpage, true);
+		cl_page_put(env, clpage);
+	}
+
+	rc = cl_io_submit_sync(env, io, CRT_WRITE, queue, 0);
+
+queuefini:
+	cl_2queue_discard(env, io, queue);
+	cl_2queue_disown(env, queue);
+	cl_2queue_fini(env, queue);
+	if (holdinglock)
+		cl_lock_release(env, lock);
+iofini:
+	cl_io_fini(env, io);
+putenv:
+	cl_env_put(env, &refcheck);
+
+	RETURN(rc);
+}
+
 /* Get reference file from volatile file name.
  * Volatile file name may look like:
  * <parent>/LUSTRE_VOLATILE_HDR:<mdt_index>:<random>:fd=<fd>
@@ -2467,6 +2607,12 @@ int ll_setattr_raw(struct dentry *dentry, struct iattr *attr,
 					attr->ia_valid |= ATTR_SIZE;
 					attr->ia_size = ref_attr.cat_size;
 				}
+			} else if (S_ISREG(inode->i_mode) &&
+				   attr->ia_valid & ATTR_SIZE) {
+				rc = ll_io_compr_rewrite_chunk(inode,
+							       attr->ia_size);
+				if (rc)
+					GOTO(out, rc);
 			}
 			rc = cl_setattr_ost(lli->lli_clob, attr, xvalid, flags);
 		}
@@ -740,6 +740,42 @@ static ssize_t pcc_async_affinity_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(pcc_async_affinity);
 
+static ssize_t pcc_async_workers_show(struct kobject *kobj,
+				      struct attribute *attr, char *buffer)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	struct pcc_super *super = &sbi->ll_pcc_super;
+
+	return scnprintf(buffer, PAGE_SIZE, "%u\n", super->pccs_async_workers);
+}
+
+static ssize_t pcc_async_workers_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	struct pcc_super *super = &sbi->ll_pcc_super;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0 || val > PCC_ASYNC_WORKERS_MAX)
+		return -ERANGE;
+
+	/* Threads above the new limit exit once the queue is drained. */
+	spin_lock(&super->pccs_attach_lock);
+	super->pccs_async_workers = val;
+	spin_unlock(&super->pccs_attach_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(pcc_async_workers);
+
 static ssize_t pcc_mode_show(struct kobject *kobj, struct attribute *attr,
 			      char *buffer)
 {
@@ -2470,6 +2506,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_pcc_async_threshold.attr,
 	&lustre_attr_pcc_mode.attr,
 	&lustre_attr_pcc_async_affinity.attr,
+	&lustre_attr_pcc_async_workers.attr,
 	NULL,
 };
 
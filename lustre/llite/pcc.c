@@ -101,6 +101,7 @@ struct kmem_cache *pcc_inode_slab;
 int pcc_super_init(struct pcc_super *super)
 {
 	struct cred *cred;
+	int i;
 
 	super->pccs_cred = cred = prepare_creds();
 	if (!cred)
@@ -113,6 +114,12 @@ int pcc_super_init(struct pcc_super *super)
 	super->pccs_generation = 1;
 	super->pccs_async_threshold = PCC_DEFAULT_ASYNC_THRESHOLD;
 	super->pccs_mode = S_IRUSR;
+	super->pccs_async_workers = PCC_DEFAULT_ASYNC_WORKERS;
+	super->pccs_attach_running = 0;
+	spin_lock_init(&super->pccs_attach_lock);
+	for (i = 0; i < PCC_DATASET_PRIO_NR; i++)
+		INIT_LIST_HEAD(&super->pccs_attach_queue[i]);
+	init_waitqueue_head(&super->pccs_attach_waitq);
 
 	return 0;
 }
@@ -609,6 +616,13 @@ pcc_parse_value_pair(struct pcc_cmd *cmd, char *buffer)
 		if (id <= 0)
 			return -EINVAL;
 		cmd->u.pccc_add.pccc_roid = id;
+	} else if (strcmp(key, "prio") == 0) {
+		rc = kstrtoul(val, 10, &id);
+		if (rc)
+			return rc;
+		if (id > PCC_DATASET_PRIO_MAX)
+			return -EINVAL;
+		cmd->u.pccc_add.pccc_prio = id;
 	} else if (strcmp(key, "auto_attach") == 0) {
 		rc = kstrtobool(val, &enable);
 		if (rc)
@@ -1019,6 +1033,7 @@ pcc_dataset_add(struct pcc_super *super, struct pcc_cmd *cmd)
 	strncpy(dataset->pccd_pathname, pathname, PATH_MAX);
 	dataset->pccd_rwid = cmd->u.pccc_add.pccc_rwid;
 	dataset->pccd_roid = cmd->u.pccc_add.pccc_roid;
+	dataset->pccd_prio = cmd->u.pccc_add.pccc_prio;
 	dataset->pccd_flags = cmd->u.pccc_add.pccc_flags;
 	dataset->pccd_hsmtool_type = cmd->u.pccc_add.pccc_hsmtool_type;
 	kref_init(&dataset->pccd_refcount);
@@ -1122,6 +1137,25 @@ pcc_dataset_del(struct pcc_super *super, char *pathname)
 	return rc;
 }
 
+static void
+pcc_dataset_stats_dump(struct pcc_dataset_stats *stats, struct seq_file *m)
+{
+	__u64 bytes = atomic64_read(&stats->pcds_bytes);
+	__u64 time_us = atomic64_read(&stats->pcds_time_us);
+
+	seq_puts(m, "    " PCC_YAML_STATS ":\n");
+	seq_printf(m, "      files: %lld\n",
+		   (s64)atomic64_read(&stats->pcds_files));
+	seq_printf(m, "      bytes: %llu\n", bytes);
+	seq_printf(m, "      time_us: %llu\n", time_us);
+	/* bytes per microsecond is MB/s */
+	seq_printf(m, "      mb_per_sec: %llu\n",
+		   time_us ? div64_u64(bytes, time_us) : 0);
+	seq_printf(m, "      errors: %lld\n",
+		   (s64)atomic64_read(&stats->pcds_errors));
+	seq_printf(m, "      queued: %d\n", atomic_read(&stats->pcds_queued));
+}
+
 static void
 pcc_dataset_dump(struct pcc_dataset *dataset, struct seq_file *m)
 {
@@ -1135,6 +1169,8 @@ pcc_dataset_dump(struct pcc_dataset *dataset, struct seq_file *m)
 	seq_printf(m, "    " PCC_YAML_FLAGS ": %x\n", dataset->pccd_flags);
 	seq_printf(m, "    " PCC_YAML_AUTOCACHE ": %s\n",
 		   dataset->pccd_rule.pmr_conds_str);
+	seq_printf(m, "    " PCC_YAML_PRIO ": %u\n", dataset->pccd_prio);
+	pcc_dataset_stats_dump(&dataset->pccd_stats, m);
 }
 
 int
@@ -1166,8 +1202,25 @@ static void pcc_remove_datasets(struct pcc_super *super)
 	up_write(&super->pccs_rw_sem);
 }
 
+static bool pcc_attach_idle(struct pcc_super *super)
+{
+	bool idle;
+
+	spin_lock(&super->pccs_attach_lock);
+	idle = super->pccs_attach_running == 0;
+	spin_unlock(&super->pccs_attach_lock);
+
+	return idle;
+}
+
 void pcc_super_fini(struct pcc_super *super)
 {
+	/*
+	 * The queued attach requests hold references on the Lustre files,
+	 * so the queue is empty by now, but the attach threads may still be
+	 * on their way out.
+	 */
+	wait_event(super->pccs_attach_waitq, pcc_attach_idle(super));
 	pcc_remove_datasets(super);
 	put_cred(super->pccs_cred);
 }
@@ -1762,7 +1815,8 @@ static int pcc_try_datasets_attach(struct inode *inode, enum pcc_io_type iot,
 }
 
 static struct pcc_attach_context *
-pcc_attach_context_alloc(struct file *file, struct inode *inode, __u32 id)
+pcc_attach_context_alloc(struct file *file, struct inode *inode,
+			 struct pcc_dataset *dataset)
 {
 	struct pcc_attach_context *pccx;
 
@@ -1772,7 +1826,10 @@ pcc_attach_context_alloc(struct file *file, struct inode *inode, __u32 id)
 
 	pccx->pccx_file = get_file(file);
 	pccx->pccx_inode = inode;
-	pccx->pccx_attach_id = id;
+	pccx->pccx_attach_id = dataset->pccd_roid;
+	kref_get(&dataset->pccd_refcount);
+	pccx->pccx_dataset = dataset;
+	INIT_LIST_HEAD(&pccx->pccx_linkage);
 
 	return pccx;
 }
@@ -1780,6 +1837,8 @@ pcc_attach_context_alloc(struct file *file, struct inode *inode, __u32 id)
 static inline void pcc_attach_context_free(struct pcc_attach_context *pccx)
 {
 	LASSERT(pccx->pccx_file != NULL);
+	LASSERT(list_empty(&pccx->pccx_linkage));
+	pcc_dataset_put(pccx->pccx_dataset);
 	fput(pccx->pccx_file);
 	OBD_FREE_PTR(pccx);
 }
@@ -1816,9 +1875,8 @@ static inline void pcc_readonly_attach_fini(struct inode *inode)
 static int pcc_readonly_attach(struct file *file, struct inode *inode,
 			       __u32 roid);
 
-static int pcc_readonly_attach_thread(void *arg)
+static void pcc_readonly_attach_one(struct pcc_attach_context *pccx)
 {
-	struct pcc_attach_context *pccx = (struct pcc_attach_context *)arg;
 	struct file *file = pccx->pccx_file;
 	int rc;
 
@@ -1846,46 +1904,149 @@ out:
 	       file_dentry(pccx->pccx_file),
 	       PFID(ll_inode2fid(pccx->pccx_inode)), rc);
 	pcc_attach_context_free(pccx);
-	RETURN(rc);
+	EXIT;
 }
 
-static int pcc_readonly_attach_async(struct file *file,
-				     struct inode *inode, __u32 roid)
+/*
+ * Take the oldest request of the highest priority from the attach queue.
+ * If the queue is empty, the calling thread is accounted as gone, and it
+ * must not touch @super anymore as pcc_super_fini() may free it.
+ */
+static struct pcc_attach_context *pcc_attach_dequeue(struct pcc_super *super)
 {
 	struct pcc_attach_context *pccx = NULL;
+	int prio;
+
+	spin_lock(&super->pccs_attach_lock);
+	for (prio = PCC_DATASET_PRIO_MAX; prio >= 0; prio--) {
+		pccx = list_first_entry_or_null(&super->pccs_attach_queue[prio],
+						struct pcc_attach_context,
+						pccx_linkage);
+		if (pccx) {
+			list_del_init(&pccx->pccx_linkage);
+			break;
+		}
+	}
+	if (!pccx && --super->pccs_attach_running == 0)
+		wake_up(&super->pccs_attach_waitq);
+	spin_unlock(&super->pccs_attach_lock);
+
+	return pccx;
+}
+
+static int pcc_attach_thread(void *arg)
+{
+	struct pcc_super *super = arg;
+	struct pcc_attach_context *pccx;
+
+	while ((pccx = pcc_attach_dequeue(super)) != NULL) {
+		atomic_dec(&pccx->pccx_dataset->pccd_stats.pcds_queued);
+		pcc_readonly_attach_one(pccx);
+		cond_resched();
+	}
+
+	return 0;
+}
+
+/*
+ * Queue an asynchronous attach request, and start a new attach thread if
+ * less than pccs_async_workers are running. The threads exit once the
+ * queue is drained, so an idle client has none of them.
+ */
+static int pcc_attach_enqueue(struct pcc_super *super,
+			      struct pcc_attach_context *pccx)
+{
+	struct pcc_dataset *dataset = pccx->pccx_dataset;
+	struct pcc_attach_context *tmp, *next;
 	struct task_struct *task;
-	int rc;
+	LIST_HEAD(stale);
+	bool spawn = false;
+	int prio;
+	int rc = 0;
 
 	ENTRY;
 
-	rc = pcc_attach_check_set(inode);
-	if (rc)
-		RETURN(rc);
+	prio = min_t(__u32, dataset->pccd_prio, PCC_DATASET_PRIO_MAX);
+	spin_lock(&super->pccs_attach_lock);
+	list_add_tail(&pccx->pccx_linkage, &super->pccs_attach_queue[prio]);
+	atomic_inc(&dataset->pccd_stats.pcds_queued);
+	if (super->pccs_attach_running < super->pccs_async_workers) {
+		super->pccs_attach_running++;
+		spawn = true;
+	}
+	spin_unlock(&super->pccs_attach_lock);
 
-	pccx = pcc_attach_context_alloc(file, inode, roid);
-	if (!pccx)
-		GOTO(out, rc = -ENOMEM);
+	if (!spawn)
+		RETURN(0);
 
-	if (ll_i2pccs(inode)->pccs_async_affinity) {
+	if (super->pccs_async_affinity) {
 		/* Create a attach kthread on the current node. */
-		task = kthread_create(pcc_readonly_attach_thread, pccx,
+		task = kthread_create(pcc_attach_thread, super,
 				      "ll_pcc_%u", current->pid);
 	} else {
 		int node = cfs_cpt_spread_node(cfs_cpt_tab, CFS_CPT_ANY);
 
-		task = kthread_create_on_node(pcc_readonly_attach_thread, pccx,
+		task = kthread_create_on_node(pcc_attach_thread, super,
 					      node, "ll_pcc_%u", current->pid);
 	}
 
-	if (IS_ERR(task)) {
-		rc = PTR_ERR(task);
-		CERROR("%s: cannot start ll_pcc thread for "DFID": rc = %d\n",
-		       ll_i2sbi(inode)->ll_fsname, PFID(ll_inode2fid(inode)),
-		       rc);
-		GOTO(out, rc);
+	if (!IS_ERR(task)) {
+		wake_up_process(task);
+		RETURN(0);
+	}
+
+	rc = PTR_ERR(task);
+	CERROR("%s: cannot start ll_pcc thread for "DFID": rc = %d\n",
+	       ll_i2sbi(pccx->pccx_inode)->ll_fsname,
+	       PFID(ll_inode2fid(pccx->pccx_inode)), rc);
+
+	spin_lock(&super->pccs_attach_lock);
+	/* A running thread may have taken the request already. */
+	if (!list_empty(&pccx->pccx_linkage)) {
+		list_del_init(&pccx->pccx_linkage);
+		atomic_dec(&dataset->pccd_stats.pcds_queued);
+	} else {
+		rc = 0;
+	}
+	/* Nobody is left to serve the requests queued meanwhile. */
+	if (--super->pccs_attach_running == 0) {
+		for (prio = 0; prio < PCC_DATASET_PRIO_NR; prio++)
+			list_splice_init(&super->pccs_attach_queue[prio],
+					 &stale);
+		wake_up(&super->pccs_attach_waitq);
+	}
+	spin_unlock(&super->pccs_attach_lock);
+
+	list_for_each_entry_safe(tmp, next, &stale, pccx_linkage) {
+		list_del_init(&tmp->pccx_linkage);
+		atomic_dec(&tmp->pccx_dataset->pccd_stats.pcds_queued);
+		pcc_readonly_attach_fini(tmp->pccx_inode);
+		pcc_attach_context_free(tmp);
 	}
 
-	wake_up_process(task);
+	RETURN(rc);
+}
+
+static int pcc_readonly_attach_async(struct file *file, struct inode *inode,
+				     struct pcc_dataset *dataset)
+{
+	struct pcc_attach_context *pccx = NULL;
+	int rc;
+
+	ENTRY;
+
+	rc = pcc_attach_check_set(inode);
+	if (rc)
+		RETURN(rc);
+
+	pccx = pcc_attach_context_alloc(file, inode, dataset);
+	if (!pccx)
+		GOTO(out, rc = -ENOMEM);
+
+	rc = pcc_attach_enqueue(ll_i2pccs(inode), pccx);
+	if (rc)
+		GOTO(out, rc);
+
 	RETURN(0);
 out:
 	if (pccx)
@@ -1899,18 +2060,19 @@ static int pcc_readonly_attach_sync(struct file *file,
 				    struct inode *inode, __u32 roid);
 
 static inline int pcc_do_readonly_attach(struct file *file,
-					 struct inode *inode, __u32 roid)
+					 struct inode *inode,
+					 struct pcc_dataset *dataset)
 {
 	int rc;
 
 	if (max_t(__u64, ll_i2info(inode)->lli_lazysize, i_size_read(inode)) >=
 	    ll_i2pccs(inode)->pccs_async_threshold) {
-		rc = pcc_readonly_attach_async(file, inode, roid);
+		rc = pcc_readonly_attach_async(file, inode, dataset);
 		if (!rc || rc == -EINPROGRESS)
 			return rc;
 	}
 
-	rc = pcc_readonly_attach_sync(file, inode, roid);
+	rc = pcc_readonly_attach_sync(file, inode, dataset->pccd_roid);
 
 	return rc;
 }
@@ -1946,7 +2108,7 @@ static int pcc_try_readonly_open_attach(struct inode *inode, struct file *file,
 
 	if ((dataset->pccd_flags & PCC_DATASET_PCC_ALL) == PCC_DATASET_PCCRO) {
 		pcc_inode_unlock(inode);
-		rc = pcc_do_readonly_attach(file, inode, dataset->pccd_roid);
+		rc = pcc_do_readonly_attach(file, inode, dataset);
 		pcc_inode_lock(inode);
 		pcci = ll_i2pcci(inode);
 		if (pcci && pcc_inode_has_layout(pcci))
@@ -3745,13 +3907,27 @@ static int pcc_filp_write(struct file *filp, const void *buf, ssize_t count,
 	return 0;
 }
 
+/*
+ * Read the Lustre file in chunks as large as its readahead window, so the
+ * read RPCs of all the stripes in a chunk are in flight together and the
+ * llite readahead of the next chunk overlaps with writing this one into
+ * the PCC copy.
+ */
+static size_t pcc_copy_chunk_size(struct inode *inode)
+{
+	size_t len = ll_i2sbi(inode)->ll_ra_info.ra_max_pages_per_file;
+
+	return clamp_t(size_t, len << PAGE_SHIFT,
+		       PCC_COPY_CHUNK_MIN, PCC_COPY_CHUNK_MAX);
+}
+
 static ssize_t pcc_copy_data(struct file *src, struct file *dst)
 {
 	ssize_t rc = 0;
 	ssize_t rc2;
 	loff_t pos, offset = 0;
-	size_t buf_len = 1048576;
 	struct inode *inode = file_inode(src);
+	size_t buf_len = pcc_copy_chunk_size(inode);
 	void *buf;
 
 	ENTRY;
@@ -3808,6 +3984,7 @@ static int pcc_attach_data_archive(struct file *file, struct inode *inode,
 	struct file *pcc_filp;
 	bool direct = false;
 	struct path path;
+	ktime_t kstart;
 	ssize_t ret;
 	int flags = O_WRONLY | O_LARGEFILE;
 	int rc;
@@ -3858,11 +4035,19 @@ static int pcc_attach_data_archive(struct file *file, struct inode *inode,
 		direct = true;
 	}
 
+	kstart = ktime_get();
 	ret = pcc_copy_data(file, pcc_filp);
 	if (direct)
 		file->f_flags |= O_DIRECT;
-	if (ret < 0)
+	if (ret < 0) {
+		atomic64_inc(&dataset->pccd_stats.pcds_errors);
 		GOTO(out_fput, rc = ret);
+	}
+
+	atomic64_inc(&dataset->pccd_stats.pcds_files);
+	atomic64_add(ret, &dataset->pccd_stats.pcds_bytes);
+	atomic64_add(ktime_us_delta(ktime_get(), kstart),
+		     &dataset->pccd_stats.pcds_time_us);
 
 	/*
 	 * It must to truncate the PCC copy to the same size of the Lustre
@@ -123,9 +123,28 @@ enum pcc_dataset_flags {
 	PCC_DATASET_PROJ_QUOTA	= 0x80,
 };
 
+/* Priorities of the asynchronous attach requests, highest first */
+#define PCC_DATASET_PRIO_MAX	7
+#define PCC_DATASET_PRIO_NR	(PCC_DATASET_PRIO_MAX + 1)
+
+/* Data copy statistics of a PCC backend */
+struct pcc_dataset_stats {
+	/* Number of files copied into the PCC backend */
+	atomic64_t		pcds_files;
+	/* Number of bytes copied into the PCC backend */
+	atomic64_t		pcds_bytes;
+	/* Time spent copying data, in microseconds */
+	atomic64_t		pcds_time_us;
+	/* Number of failed data copies */
+	atomic64_t		pcds_errors;
+	/* Number of asynchronous attach requests waiting for a worker */
+	atomic_t		pcds_queued;
+};
+
 struct pcc_dataset {
 	__u32			pccd_rwid;	 /* Archive ID */
 	__u32			pccd_roid;	 /* Readonly ID */
+	__u32			pccd_prio;	 /* Async attach priority */
 	struct pcc_match_rule	pccd_rule;	 /* Match rule */
 	enum pcc_dataset_flags	pccd_flags;	 /* Flags of PCC backend */
 	char			pccd_pathname[PATH_MAX]; /* full path */
@@ -133,9 +152,16 @@ struct pcc_dataset {
 	struct list_head	pccd_linkage;  /* Linked to pccs_datasets */
 	struct kref		pccd_refcount; /* Reference count */
 	enum hsmtool_type	pccd_hsmtool_type; /* HSM copytool type */
+	struct pcc_dataset_stats pccd_stats;	 /* Data copy statistics */
 };
 
 #define PCC_DEFAULT_ASYNC_THRESHOLD	(256 << 20)
+#define PCC_DEFAULT_ASYNC_WORKERS	4
+#define PCC_ASYNC_WORKERS_MAX		64
+
+/* Bounds of the data chunks copied from Lustre into the PCC backend */
+#define PCC_COPY_CHUNK_MIN		(1 << 20)
+#define PCC_COPY_CHUNK_MAX		(16 << 20)
 
 struct pcc_super {
 	/* Protect pccs_datasets */
@@ -154,6 +180,16 @@ struct pcc_super {
 	__u64			 pccs_async_threshold;
 	bool			 pccs_async_affinity;
 	umode_t			 pccs_mode;
+	/* Max number of threads doing asynchronous PCC-RO attach */
+	unsigned int		 pccs_async_workers;
+	/* Number of running asynchronous attach threads */
+	unsigned int		 pccs_attach_running;
+	/* Protect pccs_attach_queue and pccs_attach_running */
+	spinlock_t		 pccs_attach_lock;
+	/* Pending asynchronous attach requests, one list per priority */
+	struct list_head	 pccs_attach_queue[PCC_DATASET_PRIO_NR];
+	/* Wait for all the attach threads to exit */
+	wait_queue_head_t	 pccs_attach_waitq;
 };
 
 struct pcc_inode {
@@ -201,6 +237,10 @@ struct pcc_attach_context {
 	struct file		*pccx_file;
 	struct inode		*pccx_inode;
 	__u32			 pccx_attach_id;
+	/* Dataset matched the file, gives the priority of the request */
+	struct pcc_dataset	*pccx_dataset;
+	/* Linked to pccs_attach_queue */
+	struct list_head	 pccx_linkage;
 };
 
 enum pcc_io_type {
@@ -237,6 +277,7 @@ struct pcc_cmd {
 		struct pcc_cmd_add {
 			__u32			 pccc_rwid;
 			__u32			 pccc_roid;
+			__u32			 pccc_prio;
 			struct list_head	 pccc_conds;
 			char			*pccc_conds_str;
 			enum pcc_dataset_flags	 pccc_flags;
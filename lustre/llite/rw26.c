@@ -550,6 +550,13 @@ ll_direct_IO_impl(struct kiocb *iocb, struct iov_iter *iter, int rw)
 	if (unaligned && !cl_io_top(io)->ci_allow_unaligned_dio)
 		RETURN(0);
 
+	/* compressed chunks are written whole, buffered I/O rewrites the
+	 * rest of the chunks partially written
+	 */
+	if (rw == WRITE && io->ci_compr_chunk_bits &&
+	    (file_offset | count) & ((1ULL << io->ci_compr_chunk_bits) - 1))
+		RETURN(0);
+
 	/* We cannot do parallel submission of sub-I/Os - for AIO or regular
 	 * DIO - unless lockless because it causes us to release the lock
 	 * early.
@@ -777,12 +784,13 @@ static int ll_tiny_write_begin(struct page *vmpage, struct address_space *mappin
 	return 0;
 }
 
-static int ll_write_begin(struct file *file, struct address_space *mapping,
-			  loff_t pos, unsigned int len,
-#ifdef HAVE_GRAB_CACHE_PAGE_WRITE_BEGIN_WITH_FLAGS
-			  unsigned int flags,
-#endif
-			  struct page **pagep, void **fsdata)
+/*
+ * With @fill set, a page which is fully overwritten is still read, because
+ * its current data is written back, see ll_write_fill_range().
+ */
+static int __ll_write_begin(struct file *file, struct address_space *mapping,
+			    loff_t pos, unsigned int len, unsigned int flags,
+			    struct page **pagep, void **fsdata, bool fill)
 {
 	struct ll_cl_context *lcc = NULL;
 	const struct lu_env  *env = NULL;
@@ -890,7 +898,7 @@ again:
 		 * We're completely overwriting an existing page,
 		 * so _don't_ set it up to date until commit_write
 		 */
-		if (from == 0 && to == PAGE_SIZE) {
+		if (from == 0 && to == PAGE_SIZE && !fill) {
 			CL_PAGE_HEADER(D_PAGE, env, page, "full page write\n");
 			POISON_PAGE(vmpage, 0x11);
 		} else {
@@ -929,6 +937,21 @@ out:
 	RETURN(result);
 }
 
+static int ll_write_begin(struct file *file, struct address_space *mapping,
+			  loff_t pos, unsigned int len,
+#ifdef HAVE_GRAB_CACHE_PAGE_WRITE_BEGIN_WITH_FLAGS
+			  unsigned int flags,
+#endif
+			  struct page **pagep, void **fsdata)
+{
+#ifndef HAVE_GRAB_CACHE_PAGE_WRITE_BEGIN_WITH_FLAGS
+	unsigned int flags = 0;
+#endif
+
+	return __ll_write_begin(file, mapping, pos, len, flags, pagep, fsdata,
+				false);
+}
+
 static int ll_tiny_write_end(struct file *file, struct address_space *mapping,
 			     loff_t pos, unsigned int len, unsigned int copied,
 			     struct page *vmpage)
@@ -1044,6 +1067,39 @@ out:
 	RETURN(result >= 0 ? copied : result);
 }
 
+/**
+ * Queue the pages of [\a start, \a end) for write with their current data,
+ * reading them first if they are not cached.
+ *
+ * Used to write whole chunks of compressed components. \a start is page
+ * aligned, \a end is at most the file size, so the last page is only
+ * written up to it. The pages are committed by the caller.
+ */
+int ll_write_fill_range(struct file *file, loff_t start, loff_t end)
+{
+	struct address_space *mapping = file->f_mapping;
+	loff_t pos;
+	int rc = 0;
+
+	for (pos = start; pos < end; pos += PAGE_SIZE) {
+		unsigned int len = min_t(loff_t, PAGE_SIZE, end - pos);
+		struct page *vmpage;
+		void *fsdata;
+
+		rc = __ll_write_begin(file, mapping, pos, len, 0,
+				      &vmpage, &fsdata, true);
+		if (rc)
+			break;
+
+		rc = ll_write_end(file, mapping, pos, len, len, vmpage, fsdata);
+		if (rc < 0)
+			break;
+		rc = 0;
+	}
+
+	return rc;
+}
+
 #ifdef CONFIG_MIGRATION
 static int ll_migrate_folio(struct address_space *mapping,
 			    struct folio_migr *newpage, struct folio_migr *page,
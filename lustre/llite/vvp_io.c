@@ -605,6 +605,13 @@ static int vvp_io_write_lock(const struct lu_env *env,
 	} else {
 		start = io->u.ci_wr.wr.crw_pos;
 		end   = start + io->u.ci_wr.wr.crw_bytes - 1;
+		/* chunks of compressed components are rewritten whole */
+		if (io->ci_compr_chunk_bits) {
+			loff_t chunk_size = 1ULL << io->ci_compr_chunk_bits;
+
+			start = round_down(start, chunk_size);
+			end = round_up(end + 1, chunk_size) - 1;
+		}
 	}
 
 	RETURN(vvp_io_rw_lock(env, io, CLM_WRITE, start, end));
@@ -1264,6 +1271,35 @@ int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io)
 	RETURN(rc);
 }
 
+/*
+ * Chunks of compressed components are only compressed when written whole, and
+ * a partial write must not leave the rest of a compressed chunk behind. So the
+ * data of the chunk around the range written, up to EOF, is written again.
+ */
+static int vvp_io_compr_fill(const struct lu_env *env, struct cl_io *io,
+			     struct file *file, loff_t start, loff_t end)
+{
+	struct vvp_io *vio = vvp_env_io(env);
+	long written = vio->u.readwrite.vui_written;
+	int rc;
+	int rc2;
+
+	if (start >= end)
+		return 0;
+
+	CDEBUG(D_VFSTRACE, "%s: rewrite [%llu, %llu) of compressed chunk\n",
+	       file_dentry(file)->d_name.name, start, end);
+
+	rc = ll_write_fill_range(file, start, end);
+	rc2 = vvp_io_write_commit(env, io);
+	if (!rc && rc2 < 0)
+		rc = rc2;
+	/* only the data of the caller is accounted as written */
+	vio->u.readwrite.vui_written = written;
+
+	return rc;
+}
+
 static int vvp_io_write_start(const struct lu_env *env,
 			      const struct cl_io_slice *ios)
 {
@@ -1278,6 +1314,7 @@ static int vvp_io_write_start(const struct lu_env *env,
 	size_t crw_bytes = io->u.ci_wr.wr.crw_bytes;
 	bool lock_inode = !IS_NOSEC(inode);
 	size_t ci_bytes = io->ci_bytes;
+	loff_t chunk_size = 1ULL << io->ci_compr_chunk_bits;
 	struct iov_iter iter;
 	size_t written = 0;
 	int flags;
@@ -1350,6 +1387,20 @@ static int vvp_io_write_start(const struct lu_env *env,
 		lock_inode = !IS_NOSEC(inode);
 		iter = *vio->vui_iter;
 
+		if (io->ci_compr_chunk_bits) {
+			loff_t end = min_t(loff_t, round_down(pos, PAGE_SIZE),
+					   i_size_read(inode));
+
+			set_bit(LLIF_COMPRESSED, &lli->lli_flags);
+			result = vvp_io_compr_fill(env, io, file,
+						   round_down(pos, chunk_size),
+						   end);
+			if (result)
+				RETURN(result);
+		} else {
+			clear_bit(LLIF_COMPRESSED, &lli->lli_flags);
+		}
+
 		if (unlikely(lock_inode))
 			ll_inode_lock(inode);
 		result = __generic_file_write_iter(vio->vui_iocb, &iter);
@@ -1380,6 +1431,16 @@ static int vvp_io_write_start(const struct lu_env *env,
 			if (vio->u.readwrite.vui_written > 0)
 				io->ci_need_restart = 1;
 		}
+		/* the tail of the last chunk, if all data was written */
+		if (io->ci_compr_chunk_bits && result == 0 &&
+		    vio->u.readwrite.vui_written == crw_bytes) {
+			loff_t end = pos + crw_bytes;
+
+			result = vvp_io_compr_fill(env, io, file,
+					round_up(end, PAGE_SIZE),
+					min_t(loff_t, round_up(end, chunk_size),
+					      i_size_read(inode)));
+		}
 		if (vio->u.readwrite.vui_written > 0) {
 			result = vio->u.readwrite.vui_written;
 			CDEBUG(D_VFSTRACE, "%s: write bytes %zd, result: %zd\n",
@@ -1437,8 +1498,14 @@ static void vvp_io_write_end(const struct lu_env *env,
 
 	vvp_io_rw_end(env, ios);
 
+	/*
+	 * The write path raised i_size over the parity written past EOF,
+	 * take the size from the data objects again.
+	 */
+	if (io->ci_parity)
+		ll_merge_attr(env, inode);
 	/* Update size and blocks for LSOM (best effort) */
-	if (!io->ci_ignore_layout && cl_io_is_sync_write(io))
+	else if (!io->ci_ignore_layout && cl_io_is_sync_write(io))
 		ll_merge_attr_try(env, inode);
 }
 
@@ -1516,6 +1583,10 @@ static int vvp_io_fault_start(const struct lu_env *env,
 	if (result != 0)
 		RETURN(result);
 
+	/* a page written through a mapping cannot rewrite its chunk */
+	if (fio->ft_mkwrite && io->ci_compr_chunk_bits)
+		RETURN(-EOPNOTSUPP);
+
 	CFS_FAIL_TIMEOUT(OBD_FAIL_LLITE_FAULT_PAUSE, cfs_fail_val);
 
 	/* must return locked page */
@@ -4352,10 +4352,13 @@ static int lmv_batch_flush(struct obd_export *exp, struct lu_batch *bh,
 }
 
 static inline struct lmv_tgt_desc *
-lmv_batch_locate_tgt(struct lmv_obd *lmv, struct md_op_item *item)
+lmv_batch_locate_tgt(struct obd_export *exp, struct md_op_item *item)
 {
+	struct obd_device *obd = exp->exp_obd;
+	struct lmv_obd *lmv = &obd->u.lmv;
 	struct md_op_data *op_data = &item->mop_data;
 	struct lmv_tgt_desc *tgt;
+	int rc;
 
 	switch (item->mop_opc) {
 	case MD_OP_GETATTR: {
@@ -4395,6 +4398,35 @@ lmv_batch_locate_tgt(struct lmv_obd *lmv, struct md_op_item *item)
 
 		break;
 	}
+	case MD_OP_CREATE:
+		if (lmv_dir_bad_hash(op_data->op_lso1))
+			RETURN(ERR_PTR(-EBADF));
+
+		/* the name must be looked up in both layouts, see lmv_create */
+		if (lmv_dir_layout_changing(op_data->op_lso1))
+			RETURN(ERR_PTR(-EBUSY));
+
+		tgt = lmv_locate_tgt_create(obd, lmv, op_data);
+		if (IS_ERR(tgt))
+			RETURN(tgt);
+
+		rc = lmv_fid_alloc(NULL, exp, &op_data->op_fid2, op_data);
+		if (rc)
+			RETURN(ERR_PTR(rc));
+		break;
+	case MD_OP_UNLINK:
+		/*
+		 * A remote child is unlinked on its own MDT if its FID is
+		 * known, otherwise the parent MDT replies -EREMOTE.
+		 */
+		if (!fid_is_zero(&op_data->op_fid2))
+			tgt = lmv_fid2tgt(lmv, &op_data->op_fid2);
+		else
+			tgt = lmv_locate_tgt(lmv, op_data);
+		break;
+	case MD_OP_SETATTR:
+		tgt = lmv_fid2tgt(lmv, &op_data->op_fid1);
+		break;
 	default:
 		tgt = ERR_PTR(-ENOTSUPP);
 	}
@@ -4452,8 +4484,6 @@ static struct lu_batch *lmv_batch_get_sub(struct lmv_batch *lbh,
 static int lmv_batch_add(struct obd_export *exp, struct lu_batch *bh,
 			 struct md_op_item *item)
 {
-	struct obd_device *obd = exp->exp_obd;
-	struct lmv_obd *lmv = &obd->u.lmv;
 	struct lmv_tgt_desc *tgt;
 	struct lmv_batch *lbh;
 	struct lu_batch *child_bh;
@@ -4461,7 +4491,7 @@ static int lmv_batch_add(struct obd_export *exp, struct lu_batch *bh,
 
 	ENTRY;
 
-	tgt = lmv_batch_locate_tgt(lmv, item);
+	tgt = lmv_batch_locate_tgt(exp, item);
 	if (IS_ERR(tgt))
 		RETURN(PTR_ERR(tgt));
 
@@ -161,6 +161,11 @@ struct lod_layout_component {
 	__u32			  llc_flags;
 	__u32			  llc_magic;
 	__u64			  llc_timestamp; /* snapshot time */
+	__u8			  llc_dstripe_count; /* EC: k data stripes */
+	__u8			  llc_cstripe_count; /* EC: p parity stripes */
+	__u8			  llc_compr_type; /* enum ll_compr_type */
+	__u8			  llc_compr_lvl;
+	__u8			  llc_compr_chunk_log_bits;
 	union {
 		struct { /* plain layout V1/V3. */
 			__u32			  llc_pattern;
@@ -217,7 +222,8 @@ enum layout_verify_flags {
 struct lod_mirror_entry {
 	__u16	lme_stale:1,
 		lme_prefer:1,
-		lme_hsm:1;
+		lme_hsm:1,
+		lme_parity:1;
 	/* mirror id */
 	__u16	lme_id;
 	/* preference */
@@ -315,6 +321,12 @@ static inline bool lod_is_hsm(const struct lod_layout_component *lod_comp)
 	       lov_hsm_type_supported(lod_comp->llc_type);
 }
 
+/* data or parity component of an erasure coded file */
+static inline bool lod_comp_is_ec(const struct lod_layout_component *lod_comp)
+{
+	return lod_comp->llc_cstripe_count != 0;
+}
+
 static inline bool lod_is_splitting(const struct lod_object *lo)
 {
 	return lmv_hash_is_splitting(lo->ldo_dir_hash_type);
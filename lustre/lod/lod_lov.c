@@ -177,7 +177,8 @@ int lod_add_device(const struct lu_env *env, struct lod_device *lod,
 					   OBD_CONNECT_PINGLESS |
 					   OBD_CONNECT_LFSCK |
 					   OBD_CONNECT_BULK_MBITS;
-		data->ocd_connect_flags2 = OBD_CONNECT2_REPLAY_CREATE;
+		data->ocd_connect_flags2 = OBD_CONNECT2_REPLAY_CREATE |
+					   OBD_CONNECT2_SYNC_BATCH;
 
 		data->ocd_group = tgt_index;
 		ltd = &lod->lod_ost_descs;
@@ -595,7 +596,9 @@ int lod_fill_mirrors(struct lod_object *lo)
 
 	for (i = 0; i < lo->ldo_comp_cnt; i++, lod_comp++) {
 		bool stale = lod_comp->llc_flags & LCME_FL_STALE;
-		bool preferred = lod_comp->llc_flags & LCME_FL_PREF_WR;
+		bool parity = lod_comp->llc_flags & LCME_FL_PARITY;
+		bool preferred = !parity &&
+				 (lod_comp->llc_flags & LCME_FL_PREF_WR);
 		bool mirror_hsm = lod_is_hsm(lod_comp);
 		bool init = (lod_comp->llc_stripe != NULL) &&
 			    !(lod_comp->llc_pattern & LOV_PATTERN_F_RELEASED) &&
@@ -636,6 +639,7 @@ int lod_fill_mirrors(struct lod_object *lo)
 			if (lo->ldo_mirrors[mirror_idx].lme_hsm)
 				RETURN(-EINVAL);
 			lo->ldo_mirrors[mirror_idx].lme_stale |= stale;
+			lo->ldo_mirrors[mirror_idx].lme_parity |= parity;
 			lo->ldo_mirrors[mirror_idx].lme_prefer |= preferred;
 			lo->ldo_mirrors[mirror_idx].lme_preference += pref;
 			lo->ldo_mirrors[mirror_idx].lme_end = i;
@@ -661,6 +665,7 @@ int lod_fill_mirrors(struct lod_object *lo)
 		lo->ldo_mirrors[mirror_idx].lme_stale = stale;
 		lo->ldo_mirrors[mirror_idx].lme_prefer = preferred;
 		lo->ldo_mirrors[mirror_idx].lme_hsm = mirror_hsm;
+		lo->ldo_mirrors[mirror_idx].lme_parity = parity;
 		lo->ldo_mirrors[mirror_idx].lme_preference = pref;
 		lo->ldo_mirrors[mirror_idx].lme_start = i;
 		lo->ldo_mirrors[mirror_idx].lme_end = i;
@@ -679,14 +684,18 @@ int lod_fill_mirrors(struct lod_object *lo)
 		for (i = 0; i <= mirror_idx; i++) {
 			if (lo->ldo_mirrors[i].lme_stale)
 				continue;
+			/* parity is never read or written directly */
+			if (lo->ldo_mirrors[i].lme_parity)
+				continue;
 			if (lo->ldo_mirrors[i].lme_preference > pref) {
 				pref = lo->ldo_mirrors[i].lme_preference;
 				best = i;
 			}
 		}
 
-		LASSERT(best >= 0);
-		lo->ldo_mirrors[best].lme_prefer = 1;
+		/* only parity mirrors are in sync, nothing to prefer */
+		if (best >= 0)
+			lo->ldo_mirrors[best].lme_prefer = 1;
 	}
 
 	RETURN(0);
@@ -976,6 +985,12 @@ int lod_generate_lovea(const struct lu_env *env, struct lod_object *lo,
 		if (lod_comp->llc_flags & LCME_FL_NOSYNC)
 			lcme->lcme_timestamp =
 				cpu_to_le64(lod_comp->llc_timestamp);
+		lcme->lcme_dstripe_count = lod_comp->llc_dstripe_count;
+		lcme->lcme_cstripe_count = lod_comp->llc_cstripe_count;
+		lcme->lcme_compr_type = lod_comp->llc_compr_type;
+		lcme->lcme_compr_lvl = lod_comp->llc_compr_lvl;
+		lcme->lcme_compr_chunk_log_bits =
+			lod_comp->llc_compr_chunk_log_bits;
 		if (lod_comp->llc_flags & LCME_FL_EXTENSION && !is_dir)
 			lcm->lcm_magic = cpu_to_le32(LOV_MAGIC_SEL);
 
@@ -1381,6 +1396,16 @@ int lod_parse_striping(const struct lu_env *env, struct lod_object *lo,
 			if (lod_comp->llc_flags & LCME_FL_NOSYNC)
 				lod_comp->llc_timestamp = le64_to_cpu(
 					comp_v1->lcm_entries[i].lcme_timestamp);
+			lod_comp->llc_dstripe_count =
+				comp_v1->lcm_entries[i].lcme_dstripe_count;
+			lod_comp->llc_cstripe_count =
+				comp_v1->lcm_entries[i].lcme_cstripe_count;
+			lod_comp->llc_compr_type =
+				comp_v1->lcm_entries[i].lcme_compr_type;
+			lod_comp->llc_compr_lvl =
+				comp_v1->lcm_entries[i].lcme_compr_lvl;
+			lod_comp->llc_compr_chunk_log_bits =
+				comp_v1->lcm_entries[i].lcme_compr_chunk_log_bits;
 			lod_comp->llc_id =
 				le32_to_cpu(comp_v1->lcm_entries[i].lcme_id);
 			if (lod_comp->llc_id == LCME_ID_INVAL)
@@ -2054,6 +2079,71 @@ static int lod_dom_stripesize_choose(const struct lu_env *env,
 	return rc;
 }
 
+/**
+ * Verify an erasure coded component.
+ *
+ * A data component of an EC file has k = lcme_dstripe_count stripes and names
+ * p = lcme_cstripe_count parity stripes; the parity is kept in an
+ * LCME_FL_PARITY component of another mirror covering the same extent with
+ * p stripes.  Every row of k data chunks has p parity chunks stored in the
+ * leading part of the parity component, so a bounded component has to hold
+ * whole rows for them to fit.
+ *
+ * \param[in] comp_v1	composite layout the component belongs to
+ * \param[in] ent	component entry
+ * \param[in] lum	component striping
+ *
+ * \retval		0 if the component is valid
+ * \retval		-EINVAL if it is invalid
+ */
+static int lod_verify_ec_comp(struct lov_comp_md_v1 *comp_v1,
+			      struct lov_comp_md_entry_v1 *ent,
+			      struct lov_user_md_v1 *lum)
+{
+	__u32 flags = le32_to_cpu(ent->lcme_flags);
+	__u32 pattern = le32_to_cpu(lum->lmm_pattern);
+	__u32 stripe_size = le32_to_cpu(lum->lmm_stripe_size);
+	__u16 stripe_count = le16_to_cpu(lum->lmm_stripe_count);
+	__u64 start = le64_to_cpu(ent->lcme_extent.e_start);
+	__u64 end = le64_to_cpu(ent->lcme_extent.e_end);
+	__u8 k = ent->lcme_dstripe_count;
+	__u8 p = ent->lcme_cstripe_count;
+
+	if (le16_to_cpu(comp_v1->lcm_mirror_count) == 0) {
+		CDEBUG(D_LAYOUT, "EC component without parity mirror\n");
+		return -EINVAL;
+	}
+
+	if (k == 0 || p == 0 || p > k) {
+		CDEBUG(D_LAYOUT, "invalid EC geometry %u+%u\n", k, p);
+		return -EINVAL;
+	}
+
+	/* every chunk of a row has to be on a different OST */
+	if (pattern != LOV_PATTERN_DEFAULT &&
+	    pattern & (LOV_PATTERN_MDT | LOV_PATTERN_OVERSTRIPING)) {
+		CDEBUG(D_LAYOUT, "invalid EC pattern %#x\n", pattern);
+		return -EINVAL;
+	}
+
+	if (stripe_count != (flags & LCME_FL_PARITY ? p : k)) {
+		CDEBUG(D_LAYOUT, "EC %s component with %u stripes, %u+%u\n",
+		       flags & LCME_FL_PARITY ? "parity" : "data",
+		       stripe_count, k, p);
+		return -EINVAL;
+	}
+
+	if (end != LUSTRE_EOF && stripe_size &&
+	    (end - start) % ((__u64)k * stripe_size)) {
+		CDEBUG(D_LAYOUT,
+		       "EC extent "DEXT" not aligned to %u x %u rows\n",
+		       start, end, k, stripe_size);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 /**
  * Verify LOV striping.
  *
@@ -2341,6 +2431,20 @@ recheck:
 			}
 		}
 
+		if (ent->lcme_dstripe_count || ent->lcme_cstripe_count ||
+		    le32_to_cpu(ent->lcme_flags) & LCME_FL_PARITY) {
+			rc = lod_verify_ec_comp(comp_v1, ent, lum);
+			if (rc)
+				RETURN(rc);
+		}
+
+		if (le32_to_cpu(ent->lcme_flags) & LCME_FL_COMPRESS &&
+		    ent->lcme_compr_type >= LL_COMPR_TYPE_MAX) {
+			CDEBUG(D_LAYOUT, "invalid compression type %u\n",
+			       ent->lcme_compr_type);
+			RETURN(-EINVAL);
+		}
+
 		prev_end = le64_to_cpu(ext->e_end);
 
 		rc = lod_verify_v1v3(d, &tmp, is_from_disk);
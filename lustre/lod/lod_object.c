@@ -2849,6 +2849,16 @@ static int lod_declare_layout_add(const struct lu_env *env,
 		lod_comp->llc_extent.e_end = ext->e_end;
 		lod_comp->llc_stripe_offset = v1->lmm_stripe_offset;
 		lod_comp->llc_flags = comp_v1->lcm_entries[i].lcme_flags;
+		lod_comp->llc_dstripe_count =
+			comp_v1->lcm_entries[i].lcme_dstripe_count;
+		lod_comp->llc_cstripe_count =
+			comp_v1->lcm_entries[i].lcme_cstripe_count;
+		lod_comp->llc_compr_type =
+			comp_v1->lcm_entries[i].lcme_compr_type;
+		lod_comp->llc_compr_lvl =
+			comp_v1->lcm_entries[i].lcme_compr_lvl;
+		lod_comp->llc_compr_chunk_log_bits =
+			comp_v1->lcm_entries[i].lcme_compr_chunk_log_bits;
 
 		lod_comp->llc_stripe_size = v1->lmm_stripe_size;
 		lod_comp->llc_stripe_count = v1->lmm_stripe_count;
@@ -3032,7 +3042,8 @@ static int lod_declare_layout_set(const struct lu_env *env,
 		__u16 mirror_id = mirror_id_of(id);
 		bool neg = flags & LCME_FL_NEG;
 
-		if (flags & LCME_FL_INIT) {
+		/* parity components are only made by an EC layout change */
+		if (flags & (LCME_FL_INIT | LCME_FL_PARITY)) {
 			if (changed)
 				lod_striping_free_nolock(env, lo);
 			mutex_unlock(&lo->ldo_layout_mutex);
@@ -5424,6 +5435,16 @@ static int lod_get_default_lov_striping(const struct lu_env *env,
 				/* We only inherit certain flags from the layout */
 				llc->llc_flags = lcm->lcm_entries[i].lcme_flags &
 					LCME_TEMPLATE_FLAGS;
+				llc->llc_dstripe_count =
+					lcm->lcm_entries[i].lcme_dstripe_count;
+				llc->llc_cstripe_count =
+					lcm->lcm_entries[i].lcme_cstripe_count;
+				llc->llc_compr_type =
+					lcm->lcm_entries[i].lcme_compr_type;
+				llc->llc_compr_lvl =
+					lcm->lcm_entries[i].lcme_compr_lvl;
+				llc->llc_compr_chunk_log_bits =
+				    lcm->lcm_entries[i].lcme_compr_chunk_log_bits;
 			}
 		}
 
@@ -7815,6 +7836,10 @@ static int lod_primary_pick(const struct lu_env *env, struct lod_object *lo,
 			continue;
 		}
 
+		/* EC parity is regenerated from the data, never written */
+		if (lo->ldo_mirrors[index].lme_parity)
+			continue;
+
 		/* 2nd pick is for the primary mirror containing unavail OST */
 		if (lo->ldo_mirrors[index].lme_prefer && second_pick < 0)
 			second_pick = index;
@@ -8372,6 +8397,8 @@ static int lod_declare_update_write_pending(const struct lu_env *env,
 			continue;
 		if (lo->ldo_mirrors[i].lme_hsm)
 			continue;
+		if (lo->ldo_mirrors[i].lme_parity)
+			continue;
 
 		primary = i;
 		break;
@@ -8381,6 +8408,8 @@ static int lod_declare_update_write_pending(const struct lu_env *env,
 		for (i = 0; i < lo->ldo_mirror_count; i++) {
 			if (lo->ldo_mirrors[i].lme_stale)
 				continue;
+			if (lo->ldo_mirrors[i].lme_parity)
+				continue;
 			primary = i;
 			break;
 		}
@@ -2247,6 +2247,16 @@ int lod_use_defined_striping(const struct lu_env *env,
 			if (lod_comp->llc_flags & LCME_FL_NOSYNC)
 				lod_comp->llc_timestamp = le64_to_cpu(
 					comp_v1->lcm_entries[i].lcme_timestamp);
+			lod_comp->llc_dstripe_count =
+				comp_v1->lcm_entries[i].lcme_dstripe_count;
+			lod_comp->llc_cstripe_count =
+				comp_v1->lcm_entries[i].lcme_cstripe_count;
+			lod_comp->llc_compr_type =
+				comp_v1->lcm_entries[i].lcme_compr_type;
+			lod_comp->llc_compr_lvl =
+				comp_v1->lcm_entries[i].lcme_compr_lvl;
+			lod_comp->llc_compr_chunk_log_bits =
+				comp_v1->lcm_entries[i].lcme_compr_chunk_log_bits;
 			lod_comp->llc_id =
 				le32_to_cpu(comp_v1->lcm_entries[i].lcme_id);
 			if (lod_comp->llc_id == LCME_ID_INVAL)
@@ -2530,6 +2540,16 @@ int lod_qos_parse_config(const struct lu_env *env, struct lod_object *lo,
 			lod_comp->llc_flags =
 				comp_v1->lcm_entries[i].lcme_flags &
 					LCME_CL_COMP_FLAGS;
+			lod_comp->llc_dstripe_count =
+				comp_v1->lcm_entries[i].lcme_dstripe_count;
+			lod_comp->llc_cstripe_count =
+				comp_v1->lcm_entries[i].lcme_cstripe_count;
+			lod_comp->llc_compr_type =
+				comp_v1->lcm_entries[i].lcme_compr_type;
+			lod_comp->llc_compr_lvl =
+				comp_v1->lcm_entries[i].lcme_compr_lvl;
+			lod_comp->llc_compr_chunk_log_bits =
+				comp_v1->lcm_entries[i].lcme_compr_chunk_log_bits;
 		}
 
 		pool_name = NULL;
@@ -2823,6 +2843,12 @@ int lod_qos_prep_create(const struct lu_env *env, struct lod_object *lo,
 
 		if (stripe_len == 0)
 			GOTO(out, rc = -ERANGE);
+		/* the EC geometry is fixed, don't settle for fewer stripes */
+		if (lod_comp_is_ec(lod_comp)) {
+			if (stripe_len != lod_comp->llc_stripe_count)
+				GOTO(out, rc = -ERANGE);
+			flags = LOD_USES_ASSIGNED_STRIPE;
+		}
 		lod_comp->llc_stripe_count = stripe_len;
 		OBD_ALLOC_PTR_ARRAY(stripe, stripe_len);
 		if (stripe == NULL)
@@ -20,6 +20,7 @@
 #include <libcfs/libcfs.h>
 
 #include <obd_class.h>
+#include <lustre_compr.h>
 #include "lov_internal.h"
 
 static inline void
@@ -544,6 +545,49 @@ lsme_unpack_comp(struct lov_obd *lov, struct lov_mds_md *lmm,
 	}
 }
 
+/*
+ * Pass the compression parameters of a LCME_FL_COMPRESS component down to
+ * its stripe objects. Chunks are aligned in object offsets, so they must
+ * not cross a stripe boundary to also be aligned in the file.
+ */
+static void lsme_compr_setup(struct lov_obd *lov,
+			     struct lov_stripe_md_entry *lsme)
+{
+	unsigned int chunk_bits = lsme->lsme_compr_chunk_log_bits +
+				  COMPR_CHUNK_MIN_BITS;
+	u8 type = lsme->lsme_compr_type;
+	int i;
+
+	if (!(lsme->lsme_flags & LCME_FL_COMPRESS) ||
+	    lsme->lsme_flags & LCME_FL_NOCOMPR || !lsme_inited(lsme) ||
+	    lsme_is_foreign(lsme) || lsme_is_dom(lsme) ||
+	    lsme->lsme_pattern & LOV_PATTERN_F_RELEASED ||
+	    !lov_pattern_supported(lov_pattern(lsme->lsme_pattern)))
+		return;
+
+	if (type == LL_COMPR_TYPE_NONE)
+		type = LL_COMPR_TYPE_FAST;
+
+	if (!ll_compr_type_name(type) || chunk_bits > COMPR_CHUNK_MAX_BITS ||
+	    lsme->lsme_stripe_size & ((1U << chunk_bits) - 1)) {
+		CDEBUG(D_LAYOUT,
+		       "%s: component %#x: unsupported compression type %u chunk %u stripe size %u\n",
+		       lov->desc.ld_uuid.uuid, lsme->lsme_id, type,
+		       chunk_bits, lsme->lsme_stripe_size);
+		return;
+	}
+
+	for (i = 0; i < lsme->lsme_stripe_count; i++) {
+		struct lov_oinfo *loi = lsme->lsme_oinfo[i];
+
+		if (!loi || lov_oinfo_is_dummy(loi))
+			continue;
+
+		loi->loi_compr_type = type;
+		loi->loi_compr_chunk_bits = chunk_bits;
+	}
+}
+
 static struct lov_stripe_md *
 lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 {
@@ -627,7 +671,14 @@ lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 		if (lsme->lsme_flags & LCME_FL_NOSYNC)
 			lsme->lsme_timestamp =
 				le64_to_cpu(lcme->lcme_timestamp);
+		lsme->lsme_dstripe_count = lcme->lcme_dstripe_count;
+		lsme->lsme_cstripe_count = lcme->lcme_cstripe_count;
+		lsme->lsme_compr_type = lcme->lcme_compr_type;
+		lsme->lsme_compr_lvl = lcme->lcme_compr_lvl;
+		lsme->lsme_compr_chunk_log_bits =
+			lcme->lcme_compr_chunk_log_bits;
 		lu_extent_le_to_cpu(&lsme->lsme_extent, &lcme->lcme_extent);
+		lsme_compr_setup(lov, lsme);
 
 		if (i == entry_count - 1) {
 			lsm->lsm_maxbytes = (loff_t)lsme->lsme_extent.e_start +
@@ -31,6 +31,11 @@ struct lov_stripe_md_entry {
 	u32			lsme_flags;
 	u32			lsme_pattern;
 	u64			lsme_timestamp;
+	u8			lsme_dstripe_count;	/* EC: k */
+	u8			lsme_cstripe_count;	/* EC: p */
+	u8			lsme_compr_type;
+	u8			lsme_compr_lvl;
+	u8			lsme_compr_chunk_log_bits;
 	union {
 		struct { /* For stripe objects */
 			u32	lsme_stripe_size;
@@ -110,6 +115,11 @@ static inline bool lsm_entry_is_foreign(const struct lov_stripe_md *lsm,
 	return lsme_is_foreign(lsm->lsm_entries[index]);
 }
 
+static inline bool lsme_is_parity(const struct lov_stripe_md_entry *lsme)
+{
+	return lsme->lsme_flags & LCME_FL_PARITY;
+}
+
 static inline bool lsme_inited(const struct lov_stripe_md_entry *lsme)
 {
 	return lsme->lsme_flags & LCME_FL_INIT;
@@ -120,6 +130,23 @@ static inline bool lsm_entry_inited(const struct lov_stripe_md *lsm, int index)
 	return lsme_inited(lsm->lsm_entries[index]);
 }
 
+/* log2 of the compression chunk size of an entry, 0 if not compressed */
+static inline unsigned int
+lsme_compr_chunk_bits(const struct lov_stripe_md_entry *lsme)
+{
+	int i;
+
+	/* set by lsme_compr_setup() if the compression is supported */
+	for (i = 0; i < lsme->lsme_stripe_count; i++) {
+		struct lov_oinfo *loi = lsme->lsme_oinfo[i];
+
+		if (loi && loi->loi_compr_type != LL_COMPR_TYPE_NONE)
+			return loi->loi_compr_chunk_bits;
+	}
+
+	return 0;
+}
+
 static inline bool lsm_is_composite(__u32 magic)
 {
 	return magic == LOV_MAGIC_COMP_V1;
@@ -359,6 +359,7 @@ static int lov_io_mirror_init(struct lov_io *lio, struct lov_object *obj,
 			if (entry->lre_mirror_id ==
 			    io->ci_designated_mirror) {
 				lio->lis_mirror_index = index;
+				io->ci_parity = entry->lre_parity;
 				break;
 			}
 
@@ -419,6 +420,9 @@ static int lov_io_mirror_init(struct lov_io *lio, struct lov_object *obj,
 		if (lre->lre_foreign)
 			continue;
 
+		if (lre->lre_parity)
+			continue;
+
 		lov_foreach_mirror_layout_entry(obj, lle, lre) {
 			if (!lle->lle_valid)
 				continue;
@@ -826,6 +830,7 @@ static int lov_io_iter_init(const struct lu_env *env,
 
 	ext.e_start = lio->lis_pos;
 	ext.e_end = lio->lis_endpos;
+	ios->cis_io->ci_compr_chunk_bits = 0;
 
 	if (is_trunc) {
 		OBD_ALLOC_PTR_ARRAY(lio->lis_trunc_stripe_index,
@@ -858,6 +863,10 @@ static int lov_io_iter_init(const struct lu_env *env,
 		if (lsm_entry_is_foreign(lsm, index))
 			continue;
 
+		ios->cis_io->ci_compr_chunk_bits =
+			max(ios->cis_io->ci_compr_chunk_bits,
+			    lsme_compr_chunk_bits(lsm->lsm_entries[index]));
+
 		if (!le->lle_valid && !ios->cis_io->ci_designated_mirror) {
 			CERROR("I/O to invalid component: %d, mirror: %d\n",
 			       index, lio->lis_mirror_index);
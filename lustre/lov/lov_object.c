@@ -693,6 +693,7 @@ static int lov_init_composite(const struct lu_env *env, struct lov_device *dev,
 				lre->lre_stale |= !lle->lle_valid;
 				lre->lre_foreign |=
 					lsme_is_foreign(lle->lle_lsme);
+				lre->lre_parity |= lsme_is_parity(lle->lle_lsme);
 				lre->lre_end = i;
 				continue;
 			}
@@ -715,6 +716,7 @@ static int lov_init_composite(const struct lu_env *env, struct lov_device *dev,
 		lre->lre_valid = lle->lle_valid;
 		lre->lre_stale = !lle->lle_valid;
 		lre->lre_foreign = lsme_is_foreign(lle->lle_lsme);
+		lre->lre_parity = lsme_is_parity(lle->lle_lsme);
 	}
 
 	/* sanity check for FLR */
@@ -773,6 +775,10 @@ static int lov_init_composite(const struct lu_env *env, struct lov_device *dev,
 		if (lre->lre_foreign)
 			continue;
 
+		/* EC parity can only be accessed through designated IO */
+		if (lre->lre_parity)
+			continue;
+
 		if (!lre->lre_valid)
 			continue;
 
@@ -1074,9 +1080,12 @@ static int lov_attr_get_composite(const struct lu_env *env,
 		       lov_attr->cat_ctime, lov_attr->cat_blocks);
 
 		/* merge results */
+		attr->cat_blocks += lov_attr->cat_blocks;
+		/* EC parity objects can extend past EOF of the file */
+		if (lsme_is_parity(entry->lle_lsme))
+			continue;
 		if (lov_attr->cat_kms_valid)
 			attr->cat_kms_valid = 1;
-		attr->cat_blocks += lov_attr->cat_blocks;
 		if (attr->cat_size < lov_attr->cat_size)
 			attr->cat_size = lov_attr->cat_size;
 		if (attr->cat_kms < lov_attr->cat_kms)
@@ -2261,6 +2270,7 @@ static int lov_object_layout_get(const struct lu_env *env,
 	struct lov_stripe_md *lsm = lov_lsm_addref(lov);
 	struct lu_buf *buf = &cl->cl_buf;
 	ssize_t rc;
+	int i;
 	ENTRY;
 
 	if (lsm == NULL) {
@@ -2275,6 +2285,15 @@ static int lov_object_layout_get(const struct lu_env *env,
 	cl->cl_is_rdonly = lsm->lsm_is_rdonly;
 	cl->cl_is_released = lsm->lsm_is_released;
 	cl->cl_is_composite = lsm_is_composite(lsm->lsm_magic);
+	cl->cl_compr_chunk_bits = 0;
+	cl->cl_is_ec = false;
+	for (i = 0; i < lsm->lsm_entry_count; i++) {
+		cl->cl_compr_chunk_bits =
+			max(cl->cl_compr_chunk_bits,
+			    lsme_compr_chunk_bits(lsm->lsm_entries[i]));
+		if (lsme_is_parity(lsm->lsm_entries[i]))
+			cl->cl_is_ec = true;
+	}
 
 	rc = lov_lsm_pack(lsm, buf->lb_buf, buf->lb_len);
 	lov_lsm_put(lsm);
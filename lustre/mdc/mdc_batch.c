@@ -150,8 +150,132 @@ static int mdc_batch_getattr_pack(struct batch_update_head *head,
 	RETURN(rc);
 }
 
+/*
+ * The batched modifications carry no early lock cancels nor SELinux policy:
+ * the batch RPC itself is checked against the policy. Their ptlrpc_body
+ * only carries the transno and versions to replay them with.
+ */
+static int mdc_batch_reint_pack_begin(struct req_capsule *pill,
+				      size_t *max_pack_size)
+{
+	__u32 size;
+
+	req_capsule_set_size(pill, &RMF_DLM_REQ, RCL_CLIENT, 0);
+	if (req_capsule_has_field(pill, &RMF_SELINUX_POL, RCL_CLIENT))
+		req_capsule_set_size(pill, &RMF_SELINUX_POL, RCL_CLIENT, 0);
+	req_capsule_set_size(pill, &RMF_MDT_MD, RCL_SERVER, 0);
+
+	size = req_capsule_msg_size(pill, RCL_CLIENT);
+	if (unlikely(size >= *max_pack_size)) {
+		*max_pack_size = size;
+		return -E2BIG;
+	}
+
+	req_capsule_client_pack(pill);
+	*max_pack_size = size;
+	return 0;
+}
+
+static int mdc_batch_create_pack(struct batch_update_head *head,
+				 struct lustre_msg *reqmsg,
+				 size_t *max_pack_size,
+				 struct md_op_item *item)
+{
+	struct md_op_data *op_data = &item->mop_data;
+	struct req_capsule pill;
+	int rc;
+
+	ENTRY;
+
+	/* security and encryption contexts are not batched */
+	if (op_data->op_file_secctx_name != NULL ||
+	    op_data->op_file_encctx != NULL)
+		RETURN(-EOPNOTSUPP);
+
+	req_capsule_subreq_init(&pill, &RQF_BUT_CREATE, NULL,
+				reqmsg, NULL, RCL_CLIENT);
+	req_capsule_set_size(&pill, &RMF_NAME, RCL_CLIENT,
+			     op_data->op_namelen + 1);
+	req_capsule_set_size(&pill, &RMF_EADATA, RCL_CLIENT, 0);
+	req_capsule_set_size(&pill, &RMF_FILE_SECCTX_NAME, RCL_CLIENT, 0);
+	req_capsule_set_size(&pill, &RMF_FILE_SECCTX, RCL_CLIENT, 0);
+	req_capsule_set_size(&pill, &RMF_FILE_ENCCTX, RCL_CLIENT, 0);
+
+	rc = mdc_batch_reint_pack_begin(&pill, max_pack_size);
+	if (rc)
+		RETURN(rc);
+
+	mdc_create_pack(&pill, op_data, NULL, 0, op_data->op_mode,
+			op_data->op_fsuid, op_data->op_fsgid, op_data->op_cap,
+			0, NULL);
+
+	req_capsule_set_replen(&pill);
+	reqmsg->lm_opc = BUT_CREATE;
+	RETURN(0);
+}
+
+static int mdc_batch_unlink_pack(struct batch_update_head *head,
+				 struct lustre_msg *reqmsg,
+				 size_t *max_pack_size,
+				 struct md_op_item *item)
+{
+	struct md_op_data *op_data = &item->mop_data;
+	struct req_capsule pill;
+	int rc;
+
+	ENTRY;
+
+	req_capsule_subreq_init(&pill, &RQF_BUT_UNLINK, NULL,
+				reqmsg, NULL, RCL_CLIENT);
+	req_capsule_set_size(&pill, &RMF_NAME, RCL_CLIENT,
+			     op_data->op_namelen + 1);
+
+	rc = mdc_batch_reint_pack_begin(&pill, max_pack_size);
+	if (rc)
+		RETURN(rc);
+
+	mdc_unlink_pack(&pill, op_data, NULL);
+
+	req_capsule_set_size(&pill, &RMF_LOGCOOKIES, RCL_SERVER, 0);
+	req_capsule_set_replen(&pill);
+	reqmsg->lm_opc = BUT_UNLINK;
+	RETURN(0);
+}
+
+static int mdc_batch_setattr_pack(struct batch_update_head *head,
+				  struct lustre_msg *reqmsg,
+				  size_t *max_pack_size,
+				  struct md_op_item *item)
+{
+	struct md_op_data *op_data = &item->mop_data;
+	struct req_capsule pill;
+	int rc;
+
+	ENTRY;
+
+	req_capsule_subreq_init(&pill, &RQF_BUT_SETATTR, NULL,
+				reqmsg, NULL, RCL_CLIENT);
+	req_capsule_set_size(&pill, &RMF_MDT_EPOCH, RCL_CLIENT, 0);
+	req_capsule_set_size(&pill, &RMF_EADATA, RCL_CLIENT, 0);
+	req_capsule_set_size(&pill, &RMF_LOGCOOKIES, RCL_CLIENT, 0);
+
+	rc = mdc_batch_reint_pack_begin(&pill, max_pack_size);
+	if (rc)
+		RETURN(rc);
+
+	mdc_setattr_pack(&pill, op_data, NULL, 0);
+
+	req_capsule_set_size(&pill, &RMF_ACL, RCL_SERVER, 0);
+	req_capsule_set_replen(&pill);
+	reqmsg->lm_opc = BUT_SETATTR;
+	RETURN(0);
+}
+
 static md_update_pack_t mdc_update_packers[MD_OP_MAX] = {
 	[MD_OP_GETATTR]	= mdc_batch_getattr_pack,
+	[MD_OP_CREATE]	= mdc_batch_create_pack,
+	[MD_OP_UNLINK]	= mdc_batch_unlink_pack,
+	[MD_OP_SETATTR]	= mdc_batch_setattr_pack,
 };
 
 static int mdc_batch_getattr_interpret(struct ptlrpc_request *req,
@@ -186,8 +310,34 @@ out:
 	return item->mop_cb(item, rc);
 }
 
+static int mdc_batch_reint_interpret(struct ptlrpc_request *req,
+				     struct lustre_msg *repmsg,
+				     struct object_update_callback *ouc,
+				     int rc)
+{
+	static const struct req_format *fmts[MD_OP_MAX] = {
+		[MD_OP_CREATE]	= &RQF_BUT_CREATE,
+		[MD_OP_UNLINK]	= &RQF_BUT_UNLINK,
+		[MD_OP_SETATTR]	= &RQF_BUT_SETATTR,
+	};
+	struct md_op_item *item = (struct md_op_item *)ouc->ouc_data;
+	struct req_capsule *pill = item->mop_pill;
+
+	if (rc == 0 && repmsg != NULL) {
+		req_capsule_subreq_init(pill, fmts[item->mop_opc], req,
+					NULL, repmsg, RCL_CLIENT);
+		if (req_capsule_server_get(pill, &RMF_MDT_BODY) == NULL)
+			rc = -EPROTO;
+	}
+
+	return item->mop_cb(item, rc);
+}
+
 object_update_interpret_t mdc_update_interpreters[MD_OP_MAX] = {
 	[MD_OP_GETATTR]	= mdc_batch_getattr_interpret,
+	[MD_OP_CREATE]	= mdc_batch_reint_interpret,
+	[MD_OP_UNLINK]	= mdc_batch_reint_interpret,
+	[MD_OP_SETATTR]	= mdc_batch_reint_interpret,
 };
 
 int mdc_batch_add(struct obd_export *exp, struct lu_batch *bh,
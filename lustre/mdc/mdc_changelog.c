@@ -75,27 +75,39 @@ struct chlg_reader_state {
 	wait_queue_head_t	    crs_waitq_cons;
 	/* Mutex protecting crs_rec_count and crs_rec_queue */
 	struct mutex		    crs_lock;
-	/* Number of item in the list */
+	/* Number of records in the queue */
 	__u64			    crs_rec_count;
-	/* List of prefetched enqueued_record::enq_linkage_items */
+	/* List of chlg_rec_block::crb_linkage items with prefetched records */
 	struct list_head	    crs_rec_queue;
 	unsigned int		    crs_last_catidx;
 	unsigned int		    crs_last_idx;
 	unsigned int		    crs_flags;
 };
 
-struct chlg_rec_entry {
+/*
+ * Prefetched records are packed back to back in blocks, as they are
+ * delivered to userland, so that a read copies them with a single
+ * copy_to_user() per block instead of allocating, queuing and copying
+ * every record separately. The records are not aligned in a block.
+ */
+struct chlg_rec_block {
 	/* Link within the chlg_reader_state::crs_rec_queue list */
-	struct list_head	enq_linkage;
-	/* Data (enq_record) field length */
-	__u64			enq_length;
-	/* Copy of a changelog record (see struct llog_changelog_rec) */
-	struct changelog_rec	enq_record[];
+	struct list_head	crb_linkage;
+	/* Size of crb_data */
+	size_t			crb_size;
+	/* Bytes of records stored in crb_data */
+	size_t			crb_used;
+	/* Bytes of records already delivered to userland */
+	size_t			crb_read;
+	/* Copies of changelog records (see struct llog_changelog_rec) */
+	char			crb_data[];
 };
 
 enum {
 	/* Number of records to prefetch locally. */
-	CDEV_CHLG_MAX_PREFETCH = 1024,
+	CDEV_CHLG_MAX_PREFETCH = 4096,
+	/* Size of the blocks holding prefetched records. */
+	CDEV_CHLG_BLOCK_SIZE = 32 * 1024,
 };
 
 DEFINE_IDR(mdc_changelog_minor_idr);
@@ -173,6 +185,71 @@ static inline void chlg_obd_put(struct chlg_registered_dev *dev,
 	class_decref(obd, "changelog", dev);
 }
 
+/**
+ * Length and index of the changelog record at @data, which may not be
+ * aligned.
+ */
+static size_t chlg_rec_len(const char *data, __u64 *index)
+{
+	enum changelog_rec_extra_flags cref = CLFE_INVALID;
+	struct changelog_rec cr;
+
+	memcpy(&cr, data, sizeof(cr));
+	if (cr.cr_flags & CLF_EXTRA_FLAGS) {
+		struct changelog_ext_extra_flags ef;
+		size_t off = (char *)changelog_rec_extra_flags(&cr) -
+			     (char *)&cr;
+
+		memcpy(&ef, data + off, sizeof(ef));
+		cref = ef.cr_extra_flags;
+	}
+
+	if (index)
+		*index = cr.cr_index;
+
+	return changelog_rec_offset(cr.cr_flags, cref) + cr.cr_namelen;
+}
+
+static struct chlg_rec_block *chlg_rec_block_alloc(size_t len)
+{
+	struct chlg_rec_block *crb;
+	size_t size = max_t(size_t, len, CDEV_CHLG_BLOCK_SIZE);
+
+	OBD_ALLOC_LARGE(crb, sizeof(*crb) + size);
+	if (crb == NULL)
+		return NULL;
+
+	INIT_LIST_HEAD(&crb->crb_linkage);
+	crb->crb_size = size;
+
+	return crb;
+}
+
+static void chlg_rec_block_free(struct chlg_rec_block *crb)
+{
+	list_del(&crb->crb_linkage);
+	OBD_FREE_LARGE(crb, sizeof(*crb) + crb->crb_size);
+}
+
+/**
+ * Release a block whose records were all delivered or skipped. The last
+ * block is reused for the next records instead, so the producer never
+ * appends to a block that goes away under it.
+ */
+static void chlg_rec_block_done(struct chlg_reader_state *crs,
+				struct chlg_rec_block *crb,
+				struct list_head *consumed)
+{
+	LASSERT(mutex_is_locked(&crs->crs_lock));
+
+	if (list_is_last(&crb->crb_linkage, &crs->crs_rec_queue)) {
+		crb->crb_used = 0;
+		crb->crb_read = 0;
+	} else {
+		list_move_tail(&crb->crb_linkage, consumed);
+	}
+}
+
 /**
  * ChangeLog catalog processing callback invoked on each record.
  * If the current record is eligible to userland delivery, push
@@ -191,7 +268,7 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 {
 	struct llog_changelog_rec *rec;
 	struct chlg_reader_state *crs = data;
-	struct chlg_rec_entry *enq;
+	struct chlg_rec_block *crb = NULL;
 	size_t len;
 	int rc;
 	ENTRY;
@@ -228,24 +305,37 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	       PFID(&rec->cr.cr_tfid), PFID(&rec->cr.cr_pfid),
 	       rec->cr.cr_namelen, changelog_rec_name(&rec->cr));
 
-	wait_event_interruptible(crs->crs_waitq_prod,
-				 crs->crs_rec_count < CDEV_CHLG_MAX_PREFETCH ||
-				 kthread_should_stop());
+	/* Once the queue is full, let the reader drain half of it rather
+	 * than waking up for every record it consumes.
+	 */
+	if (crs->crs_rec_count >= CDEV_CHLG_MAX_PREFETCH)
+		wait_event_interruptible(crs->crs_waitq_prod,
+				crs->crs_rec_count <= CDEV_CHLG_MAX_PREFETCH / 2 ||
+				kthread_should_stop());
 
 	if (kthread_should_stop())
 		RETURN(LLOG_PROC_BREAK);
 
 	len = changelog_rec_size(&rec->cr) + rec->cr.cr_namelen;
-	OBD_ALLOC(enq, sizeof(*enq) + len);
-	if (enq == NULL)
-		RETURN(-ENOMEM);
-
-	INIT_LIST_HEAD(&enq->enq_linkage);
-	enq->enq_length = len;
-	memcpy(enq->enq_record, &rec->cr, len);
 
 	mutex_lock(&crs->crs_lock);
-	list_add_tail(&enq->enq_linkage, &crs->crs_rec_queue);
+	if (!list_empty(&crs->crs_rec_queue))
+		crb = list_last_entry(&crs->crs_rec_queue,
+				      struct chlg_rec_block, crb_linkage);
+
+	/* only this thread adds blocks, so the last one cannot change */
+	if (crb == NULL || crb->crb_size - crb->crb_used < len) {
+		mutex_unlock(&crs->crs_lock);
+		crb = chlg_rec_block_alloc(len);
+		if (crb == NULL)
+			RETURN(-ENOMEM);
+
+		mutex_lock(&crs->crs_lock);
+		list_add_tail(&crb->crb_linkage, &crs->crs_rec_queue);
+	}
+
+	memcpy(crb->crb_data + crb->crb_used, &rec->cr, len);
+	crb->crb_used += len;
 	crs->crs_rec_count++;
 	mutex_unlock(&crs->crs_lock);
 
@@ -254,15 +344,6 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	RETURN(0);
 }
 
-/**
- * Remove record from the list it is attached to and free it.
- */
-static void enq_record_delete(struct chlg_rec_entry *rec)
-{
-	list_del(&rec->enq_linkage);
-	OBD_FREE(rec, sizeof(*rec) + rec->enq_length);
-}
-
 /**
  * Record prefetch thread entry point. Opens the changelog catalog and starts
  * reading records.
@@ -399,8 +480,8 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
 			 loff_t *ppos)
 {
 	struct chlg_reader_state *crs = file->private_data;
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_block *crb;
+	struct chlg_rec_block *tmp;
 	size_t written_total = 0;
 	ssize_t rc;
 	LIST_HEAD(consumed);
@@ -423,34 +504,59 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
 			crs->crs_rec_count > 0 || crs->crs_eof || crs->crs_err);
 
 	mutex_lock(&crs->crs_lock);
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage) {
-		if (written_total + rec->enq_length > count)
-			break;
-
-		if (copy_to_user(buff, rec->enq_record, rec->enq_length)) {
-			rc = -EFAULT;
-			break;
+	list_for_each_entry_safe(crb, tmp, &crs->crs_rec_queue, crb_linkage) {
+		size_t start = crb->crb_read;
+		size_t end = start;
+		__u64 index = 0;
+		__u64 nr = 0;
+
+		/* copy whole records only, this can be a short read */
+		while (end < crb->crb_used) {
+			__u64 rec_index;
+			size_t len = chlg_rec_len(crb->crb_data + end,
+						  &rec_index);
+
+			if (written_total + end - start + len > count)
+				break;
+
+			/* the last record copied */
+			index = rec_index;
+			end += len;
+			nr++;
 		}
 
-		buff += rec->enq_length;
-		written_total += rec->enq_length;
+		if (end > start) {
+			if (copy_to_user(buff, crb->crb_data + start,
+					 end - start)) {
+				rc = -EFAULT;
+				break;
+			}
+
+			buff += end - start;
+			written_total += end - start;
 
-		crs->crs_rec_count--;
-		list_move_tail(&rec->enq_linkage, &consumed);
+			crb->crb_read = end;
+			crs->crs_rec_count -= nr;
+			crs->crs_start_offset = index + 1;
+		}
 
-		crs->crs_start_offset = rec->enq_record->cr_index + 1;
+		if (crb->crb_read < crb->crb_used)
+			break;
+
+		chlg_rec_block_done(crs, crb, &consumed);
 	}
 	mutex_unlock(&crs->crs_lock);
 
 	if (written_total > 0) {
 		rc = written_total;
-		wake_up(&crs->crs_waitq_prod);
+		if (crs->crs_rec_count <= CDEV_CHLG_MAX_PREFETCH / 2)
+			wake_up(&crs->crs_waitq_prod);
 	} else if (rc == 0) {
 		rc = crs->crs_err;
 	}
 
-	list_for_each_entry_safe(rec, tmp, &consumed, enq_linkage)
-		enq_record_delete(rec);
+	list_for_each_entry_safe(crb, tmp, &consumed, crb_linkage)
+		chlg_rec_block_free(crb);
 
 	*ppos = crs->crs_start_offset;
 
@@ -466,8 +572,9 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
  */
 static int chlg_set_start_offset(struct chlg_reader_state *crs, __u64 offset)
 {
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_block *crb;
+	struct chlg_rec_block *tmp;
+	LIST_HEAD(consumed);
 
 	mutex_lock(&crs->crs_lock);
 	if (offset < crs->crs_start_offset) {
@@ -476,17 +583,31 @@ static int chlg_set_start_offset(struct chlg_reader_state *crs, __u64 offset)
 	}
 
 	crs->crs_start_offset = offset;
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage) {
-		struct changelog_rec *cr = rec->enq_record;
+	list_for_each_entry_safe(crb, tmp, &crs->crs_rec_queue, crb_linkage) {
+		while (crb->crb_read < crb->crb_used) {
+			__u64 index;
+			size_t len;
+
+			len = chlg_rec_len(crb->crb_data + crb->crb_read,
+					   &index);
+			if (index >= crs->crs_start_offset)
+				break;
+
+			crb->crb_read += len;
+			crs->crs_rec_count--;
+		}
 
-		if (cr->cr_index >= crs->crs_start_offset)
+		if (crb->crb_read < crb->crb_used)
 			break;
 
-		crs->crs_rec_count--;
-		enq_record_delete(rec);
+		chlg_rec_block_done(crs, crb, &consumed);
 	}
 
 	mutex_unlock(&crs->crs_lock);
+
+	list_for_each_entry_safe(crb, tmp, &consumed, crb_linkage)
+		chlg_rec_block_free(crb);
+
 	wake_up(&crs->crs_waitq_prod);
 	return 0;
 }
@@ -648,15 +769,15 @@ static int chlg_open(struct inode *inode, struct file *file)
 static int chlg_release(struct inode *inode, struct file *file)
 {
 	struct chlg_reader_state *crs = file->private_data;
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_block *crb;
+	struct chlg_rec_block *tmp;
 	int rc = 0;
 
 	if (crs->crs_prod_task)
 		rc = kthread_stop(crs->crs_prod_task);
 
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage)
-		enq_record_delete(rec);
+	list_for_each_entry_safe(crb, tmp, &crs->crs_rec_queue, crb_linkage)
+		chlg_rec_block_free(crb);
 
 	kref_put(&crs->crs_ced->ced_refs, chlg_dev_clear);
 	OBD_FREE_PTR(crs);
@@ -204,9 +204,7 @@ static int changelog_init_cb(const struct lu_env *env, struct llog_handle *llh,
 	       DFID"\n", hdr->lrh_index, rec->cr_hdr.lrh_index,
 	       rec->cr.cr_index, rec->cr.cr_type, rec->cr.cr_namelen,
 	       changelog_rec_name(&rec->cr), PLOGID(&llh->lgh_id));
-	spin_lock(&mdd->mdd_cl.mc_lock);
-	mdd->mdd_cl.mc_index = rec->cr.cr_index;
-	spin_unlock(&mdd->mdd_cl.mc_lock);
+	atomic64_set(&mdd->mdd_cl.mc_index, rec->cr.cr_index);
 	return LLOG_PROC_BREAK;
 }
 
@@ -264,10 +262,8 @@ static int changelog_user_init_cb(const struct lu_env *env,
 	mdd->mdd_cl.mc_mintime = min(mdd->mdd_cl.mc_mintime, rec->cur_time);
 	mdd->mdd_cl.mc_minrec = min(mdd->mdd_cl.mc_minrec, rec->cur_endrec);
 	spin_unlock(&mdd->mdd_cl.mc_user_lock);
-	spin_lock(&mdd->mdd_cl.mc_lock);
-	if (rec->cur_endrec > mdd->mdd_cl.mc_index)
-		mdd->mdd_cl.mc_index = rec->cur_endrec;
-	spin_unlock(&mdd->mdd_cl.mc_lock);
+	if (rec->cur_endrec > atomic64_read(&mdd->mdd_cl.mc_index))
+		atomic64_set(&mdd->mdd_cl.mc_index, rec->cur_endrec);
 
 	return LLOG_PROC_BREAK;
 }
@@ -544,8 +540,8 @@ static int mdd_changelog_llog_init(const struct lu_env *env,
 		GOTO(out_close, rc);
 	}
 
-	CDEBUG(D_IOCTL, "changelog starting index=%llu\n",
-	       mdd->mdd_cl.mc_index);
+	CDEBUG(D_IOCTL, "changelog starting index=%lld\n",
+	       (long long)atomic64_read(&mdd->mdd_cl.mc_index));
 
 	/* setup user changelog */
 	rc = llog_setup(env, obd, &obd->obd_olg, LLOG_CHANGELOG_USER_ORIG_CTXT,
@@ -648,7 +644,7 @@ static int mdd_changelog_init(const struct lu_env *env, struct mdd_device *mdd)
 	struct obd_device	*obd = mdd2obd_dev(mdd);
 	int			 rc;
 
-	mdd->mdd_cl.mc_index = 0;
+	atomic64_set(&mdd->mdd_cl.mc_index, 0);
 	spin_lock_init(&mdd->mdd_cl.mc_lock);
 	mdd->mdd_cl.mc_starttime = ktime_get();
 	spin_lock_init(&mdd->mdd_cl.mc_user_lock);
@@ -742,9 +738,7 @@ mdd_changelog_llog_cancel(const struct lu_env *env, struct mdd_device *mdd,
 	if (!ctxt)
 		return -ENXIO;
 
-	spin_lock(&mdd->mdd_cl.mc_lock);
-	cur = (long long)mdd->mdd_cl.mc_index;
-	spin_unlock(&mdd->mdd_cl.mc_lock);
+	cur = atomic64_read(&mdd->mdd_cl.mc_index);
 
 	/*
 	 * If purging all records, write a header entry so we don't have an
@@ -1774,9 +1768,7 @@ static int mdd_changelog_user_register(const struct lu_env *env,
 		spin_unlock(&mdd->mdd_cl.mc_user_lock);
 	}
 
-	spin_lock(&mdd->mdd_cl.mc_lock);
-	rec->cur_endrec = mdd->mdd_cl.mc_index;
-	spin_unlock(&mdd->mdd_cl.mc_lock);
+	rec->cur_endrec = atomic64_read(&mdd->mdd_cl.mc_index);
 
 	if (mask) {
 		u64 newmask = CHANGELOG_DEFMASK;
@@ -2120,9 +2112,7 @@ static int mdd_changelog_clear(const struct lu_env *env,
 	CDEBUG(D_IOCTL, "%s: Purge request: id=%u, endrec=%llu\n",
 	       mdd2obd_dev(mdd)->obd_name, id, endrec);
 	/* start_rec is the newest (largest value) entry in the changelogs*/
-	spin_lock(&mdd->mdd_cl.mc_lock);
-	start_rec = mdd->mdd_cl.mc_index;
-	spin_unlock(&mdd->mdd_cl.mc_lock);
+	start_rec = atomic64_read(&mdd->mdd_cl.mc_index);
 
 	if (start_rec < endrec) {
 		CDEBUG(D_IOCTL,
@@ -790,9 +790,10 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 		mdd = lu2mdd_dev(loghandle->lgh_ctxt->loc_obd->obd_lu_dev);
 		rec = container_of(r, struct llog_changelog_rec, cr_hdr);
 
-		spin_lock(&mdd->mdd_cl.mc_lock);
-		rec->cr.cr_index = mdd->mdd_cl.mc_index + 1;
-		spin_unlock(&mdd->mdd_cl.mc_lock);
+		/* writers are serialized by loghandle->lgh_lock, so the
+		 * index needs no lock and stays monotonic
+		 */
+		rec->cr.cr_index = atomic64_read(&mdd->mdd_cl.mc_index) + 1;
 
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
 						cookie, idx, th);
@@ -803,11 +804,8 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 		 * avoid increasing index so that userspace apps
 		 * should not see a gap in the changelog sequence
 		 */
-		if (!(rc == -ENOSPC && llog_is_full(loghandle))) {
-			spin_lock(&mdd->mdd_cl.mc_lock);
-			++mdd->mdd_cl.mc_index;
-			spin_unlock(&mdd->mdd_cl.mc_lock);
-		}
+		if (!(rc == -ENOSPC && llog_is_full(loghandle)))
+			atomic64_inc(&mdd->mdd_cl.mc_index);
 	} else {
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
 						cookie, idx, th);
@@ -976,9 +974,7 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 		goto out_put;
 
 	if (CFS_FAIL_PRECHECK(OBD_FAIL_MDS_CHANGELOG_IDX_PUMP)) {
-		spin_lock(&mdd->mdd_cl.mc_lock);
-		mdd->mdd_cl.mc_index += cfs_fail_val;
-		spin_unlock(&mdd->mdd_cl.mc_lock);
+		atomic64_add(cfs_fail_val, &mdd->mdd_cl.mc_index);
 	}
 
 	need_gc = mdd_changelog_need_gc(env, mdd, ctxt->loc_handle);
@@ -73,13 +73,12 @@
 /** else the started task_struct address when running **/
 
 struct mdd_changelog {
-	spinlock_t		mc_lock;	/* for index */
+	spinlock_t		mc_lock;	/* for flags and GC task */
 	int			mc_flags;
 	__u32			mc_proc_mask; /* per-server mask set via parameters */
 	__u32			mc_current_mask; /* combined global+users */
 	__u32			mc_mintime; /* the oldest changelog user time */
 	__u64			mc_minrec; /* last known minimal used index */
-	__u64			mc_index;
 	ktime_t			mc_starttime;
 	spinlock_t		mc_user_lock;
 	int			mc_lastuser;
@@ -92,6 +91,11 @@ struct mdd_changelog {
 	unsigned char		mc_enable_shard_pfid; /* master or shard pFID
 						       * for striped dirs
 						       */
+	/* index of the last record, only changed by writers of the current
+	 * plain llog which are serialized by its lgh_lock. Kept away from
+	 * the fields read by every metadata update.
+	 */
+	atomic64_t		mc_index ____cacheline_aligned_in_smp;
 };
 
 static inline __u64 cl_time(void)
@@ -874,7 +878,7 @@ static inline bool mdd_changelog_enabled(const struct lu_env *env,
 static inline bool mdd_changelog_is_too_idle(struct mdd_device *mdd,
 					     __u64 cl_rec, __u32 cl_time)
 {
-	__u64 idle_indexes = mdd->mdd_cl.mc_index - cl_rec;
+	__u64 idle_indexes = atomic64_read(&mdd->mdd_cl.mc_index) - cl_rec;
 	__u32 idle_time = (__u32)ktime_get_real_seconds() - cl_time;
 
 	return (idle_indexes > mdd->mdd_changelog_max_idle_indexes ||
@@ -132,7 +132,7 @@ static int mdd_chlg_garbage_collect(void *data)
 		__u32 time_now = (__u32)ktime_get_real_seconds();
 		struct mdd_changelog_gc mcgc = {
 			.mcgc_mdd = mdd,
-			.mcgc_minrec = mdd->mdd_cl.mc_index,
+			.mcgc_minrec = atomic64_read(&mdd->mdd_cl.mc_index),
 			.mcgc_name = { 0 },
 		};
 
@@ -147,7 +147,7 @@ static int mdd_chlg_garbage_collect(void *data)
 		CWARN("%s: force deregister of changelog user %s idle for %us with %llu unprocessed records\n",
 		      mdd2obd_dev(mdd)->obd_name, mcgc.mcgc_name,
 		      time_now - mcgc.mcgc_mintime,
-		      mdd->mdd_cl.mc_index - mcgc.mcgc_minrec);
+		      atomic64_read(&mdd->mdd_cl.mc_index) - mcgc.mcgc_minrec);
 
 		mdd_changelog_user_purge(env, mdd, mcgc.mcgc_id);
 
@@ -25,8 +25,24 @@ static struct ldlm_callback_suite mdt_dlm_cbs = {
 	.lcs_glimpse	= ldlm_server_glimpse_ast
 };
 
+/* reint opcode of a batched modification sub request */
+static __u32 mdt_batch_reint_opc(__u32 opc)
+{
+	switch (opc) {
+	case BUT_CREATE:
+		return REINT_CREATE;
+	case BUT_UNLINK:
+		return REINT_UNLINK;
+	case BUT_SETATTR:
+		return REINT_SETATTR;
+	default:
+		return REINT_MAX;
+	}
+}
+
 static int mdt_batch_unpack(struct mdt_thread_info *info, __u32 opc)
 {
+	struct mdt_rec_reint *rec;
 	int rc = 0;
 
 	switch (opc) {
@@ -36,6 +52,20 @@ static int mdt_batch_unpack(struct mdt_thread_info *info, __u32 opc)
 		if (info->mti_dlm_req == NULL)
 			RETURN(-EFAULT);
 		break;
+	case BUT_CREATE:
+	case BUT_UNLINK:
+	case BUT_SETATTR:
+		/* the record is fully unpacked by mdt_reint_internal() */
+		rec = req_capsule_client_get(info->mti_pill, &RMF_REC_REINT);
+		if (rec == NULL)
+			RETURN(-EFAULT);
+		if (rec->rr_opcode != mdt_batch_reint_opc(opc))
+			RETURN(-EPROTO);
+		/* carries the transno and versions of the sub request */
+		if (req_capsule_client_get(info->mti_pill,
+					   &RMF_PTLRPC_BODY) == NULL)
+			RETURN(-EPROTO);
+		break;
 	default:
 		rc = -EOPNOTSUPP;
 		CERROR("%s: Unexpected opcode %d: rc = %d\n",
@@ -51,9 +81,21 @@ static int mdt_batch_pack_repmsg(struct mdt_thread_info *info)
 	return 0;
 }
 
+static int mdt_batch_reconstruct_reint(struct tgt_session_info *tsi)
+{
+	struct mdt_thread_info *info = mdt_th_info(tsi->tsi_env);
+	__u32 opc = info->mti_pill->rc_reqmsg->lm_opc;
+
+	return mdt_reconstruct_batch_reint(info, mdt_batch_reint_opc(opc));
+}
+
 typedef int (*mdt_batch_reconstructor)(struct tgt_session_info *tsi);
 
-static mdt_batch_reconstructor reconstructors[BUT_LAST_OPC];
+static mdt_batch_reconstructor reconstructors[BUT_LAST_OPC] = {
+	[BUT_CREATE]	= mdt_batch_reconstruct_reint,
+	[BUT_UNLINK]	= mdt_batch_reconstruct_reint,
+	[BUT_SETATTR]	= mdt_batch_reconstruct_reint,
+};
 
 static int mdt_batch_reconstruct(struct tgt_session_info *tsi, long opc)
 {
@@ -85,6 +127,25 @@ static int mdt_batch_getattr(struct tgt_session_info *tsi)
 	RETURN(rc);
 }
 
+/*
+ * Each batched create, unlink or setattr runs in its own transaction, like
+ * the single MDS_REINT RPC it replaces. Its transno and the versions of its
+ * objects are returned in its sub reply for replay, and the reply data slot
+ * shared by the whole batch records the largest transno.
+ */
+static int mdt_batch_reint(struct tgt_session_info *tsi)
+{
+	struct mdt_thread_info *info = mdt_th_info(tsi->tsi_env);
+	__u32 opc = info->mti_pill->rc_reqmsg->lm_opc;
+	int rc;
+
+	ENTRY;
+
+	rc = mdt_reint_internal(info, NULL, mdt_batch_reint_opc(opc));
+
+	RETURN(rc);
+}
+
 /* Batch UpdaTe Request with a format known in advance */
 #define TGT_BUT_HDL(flags, opc, fn)			\
 [opc - BUT_FIRST_OPC] = {				\
@@ -100,6 +161,9 @@ static int mdt_batch_getattr(struct tgt_session_info *tsi)
 
 static struct tgt_handler mdt_batch_handlers[] = {
 TGT_BUT_HDL(HAS_KEY | HAS_REPLY,	BUT_GETATTR,	mdt_batch_getattr),
+TGT_BUT_HDL(IS_MUTABLE | HAS_REPLY,	BUT_CREATE,	mdt_batch_reint),
+TGT_BUT_HDL(IS_MUTABLE | HAS_REPLY,	BUT_UNLINK,	mdt_batch_reint),
+TGT_BUT_HDL(IS_MUTABLE | HAS_REPLY,	BUT_SETATTR,	mdt_batch_reint),
 };
 
 static struct tgt_handler *mdt_batch_handler_find(__u32 opc)
@@ -122,6 +186,7 @@ int mdt_batch(struct tgt_session_info *tsi)
 	struct mdt_thread_info *info = tsi2mdt_info(tsi);
 	struct req_capsule *pill = &info->mti_sub_pill;
 	struct ptlrpc_request *req = tgt_ses_req(tsi);
+	struct obd_device *obd = tsi->tsi_exp->exp_obd;
 	struct but_update_header *buh;
 	struct but_update_buffer *bub = NULL;
 	struct batch_update_reply *reply = NULL;
@@ -235,6 +300,16 @@ int mdt_batch(struct tgt_session_info *tsi)
 		GOTO(out, rc = -ENOMEM);
 
 	need_reconstruct = tgt_check_resent(req, trd);
+	/*
+	 * The reconstructed sub requests of a resent batch have no transno
+	 * of their own to be replayed with, commit them first.
+	 */
+	if (need_reconstruct &&
+	    trd->trd_reply.lrd_transno > obd->obd_last_committed) {
+		rc = mdt_device_sync(tsi->tsi_env, info->mti_mdt);
+		if (rc)
+			GOTO(out, rc);
+	}
 	/* Walk through sub requests in the batch request to execute them. */
 	for (i = 0; i < update_buf_count; i++) {
 		struct batch_update_request *bur;
@@ -297,8 +372,27 @@ int mdt_batch(struct tgt_session_info *tsi)
 				GOTO(next, rc);
 			}
 
+			/*
+			 * A replayed batch executes again only the sub
+			 * requests that are not committed yet, each one at
+			 * its own transno and checking the versions of its
+			 * objects. A failed one has no transno and is not
+			 * executed again either.
+			 */
+			if ((h->th_flags & IS_MUTABLE) && req_is_replay(req) &&
+			    lustre_msg_get_transno(reqmsg) <=
+			    obd->obd_last_committed) {
+				rc = mdt_batch_reconstruct(tsi, reqmsg->lm_opc);
+				if (rc)
+					GOTO(out, rc);
+				GOTO(next, rc);
+			}
+
 			tsi->tsi_batch_idx = handled_update_count;
+			if (h->th_flags & IS_MUTABLE)
+				tsi->tsi_batch_pill = pill;
 			rc = h->th_act(tsi);
+			tsi->tsi_batch_pill = NULL;
 next:
 			/*
 			 * As @repmsg may be changed if the reply buffer is
@@ -309,7 +403,13 @@ next:
 				grown = true;
 			}
 
-			if (rc)
+			/*
+			 * A modification failing on its own, e.g. with
+			 * -EEXIST, only fails that sub request: its reply
+			 * is already packed.
+			 */
+			if (rc && !((h->th_flags & IS_MUTABLE) &&
+				    !is_serious(rc)))
 				GOTO(out, rc);
 
 			repmsg->lm_result = rc;
@@ -318,9 +418,22 @@ next:
 			replen = lustre_packed_msg_size(repmsg);
 			packed_replen += replen;
 			handled_update_count++;
+
+			/*
+			 * A failed modification has no reply data, so stop
+			 * the batch there: the sub requests up to the last
+			 * one with reply data then all succeeded, and can be
+			 * reconstructed if the batch is resent. The client
+			 * sends the next ones again, and only replays the
+			 * handled ones.
+			 */
+			if (rc && !req_is_replay(req))
+				GOTO(stop, rc = 0);
+			rc = 0;
 		}
 	}
 
+stop:
 	CDEBUG(D_INFO, "reply size %u packed replen %u\n",
 	       buh->buh_reply_size, packed_replen);
 	if (buh->buh_reply_size > packed_replen)
@@ -3047,9 +3047,8 @@ static void mdt_preset_secctx_size(struct mdt_thread_info *info)
 	}
 }
 
-static int mdt_reint_internal(struct mdt_thread_info *info,
-			      struct mdt_lock_handle *lhc,
-			      __u32 op)
+int mdt_reint_internal(struct mdt_thread_info *info,
+		       struct mdt_lock_handle *lhc, __u32 op)
 {
 	struct req_capsule	*pill = info->mti_pill;
 	struct mdt_body		*repbody;
@@ -3118,7 +3117,9 @@ static int mdt_reint_internal(struct mdt_thread_info *info,
 	if (rc != 0)
 		GOTO(out_ucred, rc = err_serious(rc));
 
-	rc = mdt_check_resent(info, mdt_reconstruct, lhc);
+	/* sub requests of a resent batch are reconstructed by mdt_batch() */
+	rc = info->mti_batch_env ? 0 :
+	     mdt_check_resent(info, mdt_reconstruct, lhc);
 	if (rc < 0) {
 		GOTO(out_ucred, rc);
 	} else if (rc == 1) {
@@ -879,6 +879,8 @@ int mdt_close_unpack(struct mdt_thread_info *info);
 int mdt_reint_unpack(struct mdt_thread_info *info, __u32 op);
 void mdt_fix_lov_magic(struct mdt_thread_info *info, void *eadata);
 int mdt_reint_rec(struct mdt_thread_info *info, struct mdt_lock_handle *lh);
+int mdt_reint_internal(struct mdt_thread_info *info,
+		       struct mdt_lock_handle *lhc, __u32 op);
 #ifdef CONFIG_LUSTRE_FS_POSIX_ACL
 int mdt_pack_acl2body(struct mdt_thread_info *info, struct mdt_body *repbody,
 		      struct mdt_object *o, struct lu_nodemap *nodemap);
@@ -1042,6 +1044,7 @@ __u32 mdt_identity_get_perm(struct md_identity *identity, struct lnet_nid *nid);
 
 /* mdt/mdt_recovery.c */
 __u64 mdt_req_from_lrd(struct ptlrpc_request *req, struct tg_reply_data *trd);
+int mdt_reconstruct_batch_reint(struct mdt_thread_info *mti, __u32 op);
 
 /* mdt/mdt_batch.c */
 int mdt_batch(struct tgt_session_info *tsi);
@@ -257,6 +257,75 @@ static void mdt_reconstruct_setattr(struct mdt_thread_info *mti,
 	mdt_object_put(mti->mti_env, obj);
 }
 
+/**
+ * Reconstruct the reply of a committed create, unlink or setattr sub request
+ * of a resent batch RPC.
+ *
+ * All the sub requests of a batch share one reply data slot that only keeps
+ * the index of the last one that succeeded with a transaction. The batch
+ * stops at the first failed modification, so all the sub requests up to it
+ * succeeded, and their replies are rebuilt from the current object
+ * attributes.
+ *
+ * \param[in] mti	thread info with the sub request capsule
+ * \param[in] op	reint opcode of the sub request
+ *
+ * \retval		0 if the reply was reconstructed
+ * \retval		negative errno otherwise
+ */
+int mdt_reconstruct_batch_reint(struct mdt_thread_info *mti, __u32 op)
+{
+	struct req_capsule *pill = mti->mti_pill;
+	struct md_attr *ma = &mti->mti_attr;
+	const struct lu_fid *fid = NULL;
+	struct mdt_object *obj;
+	struct mdt_body *body;
+	int rc;
+
+	ENTRY;
+
+	rc = mdt_reint_unpack(mti, op);
+	if (rc)
+		RETURN(err_serious(rc));
+
+	if (req_capsule_has_field(pill, &RMF_MDT_MD, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_MDT_MD, RCL_SERVER, 0);
+	if (req_capsule_has_field(pill, &RMF_LOGCOOKIES, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_LOGCOOKIES, RCL_SERVER, 0);
+	if (req_capsule_has_field(pill, &RMF_ACL, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_ACL, RCL_SERVER, 0);
+
+	rc = req_capsule_server_pack(pill);
+	if (rc)
+		RETURN(err_serious(rc));
+
+	if (op == REINT_CREATE)
+		fid = mti->mti_rr.rr_fid2;
+	else if (op == REINT_SETATTR)
+		fid = mti->mti_rr.rr_fid1;
+	if (fid == NULL)
+		RETURN(0);
+
+	obj = mdt_object_find(mti->mti_env, mti->mti_mdt, fid);
+	if (IS_ERR(obj))
+		RETURN(PTR_ERR(obj));
+
+	body = req_capsule_server_get(pill, &RMF_MDT_BODY);
+	ma->ma_need = MA_INODE;
+	ma->ma_valid = 0;
+	rc = mdt_attr_get_complex(mti, obj, ma);
+	if (rc == -ENOENT)
+		mdt_fake_ma(ma);
+	else if (rc)
+		GOTO(out_put, rc);
+	mdt_pack_attr2body(mti, body, &ma->ma_attr, mdt_object_fid(obj));
+	rc = 0;
+out_put:
+	mdt_object_put(mti->mti_env, obj);
+
+	RETURN(rc);
+}
+
 typedef void (*mdt_reconstructor)(struct mdt_thread_info *mti,
 				  struct mdt_lock_handle *lhc);
 
@@ -57,15 +57,21 @@ static void mdt_obj_version_get(struct mdt_thread_info *info,
  *
  * Should be called only during replay.
  */
-static int mdt_version_check(struct ptlrpc_request *req,
+static int mdt_version_check(struct mdt_thread_info *info,
 			     __u64 version, int idx)
 {
-	__u64 *pre_ver = lustre_msg_get_versions(req->rq_reqmsg);
+	struct ptlrpc_request *req = mdt_info_req(info);
+	__u64 *pre_ver;
 
 	ENTRY;
 	if (!exp_connect_vbr(req->rq_export))
 		RETURN(0);
 
+	/* a batched sub request carries its own versions */
+	pre_ver = lustre_msg_get_versions(info->mti_batch_env ?
+					  info->mti_pill->rc_reqmsg :
+					  req->rq_reqmsg);
+
 	LASSERT(req_is_replay(req));
 	/** VBR: version is checked always because costs nothing */
 	LASSERT(idx < PTLRPC_NUM_VERSIONS);
@@ -90,9 +96,10 @@ static int mdt_version_check(struct ptlrpc_request *req,
 /**
  * Save pre-versions in reply.
  */
-static void mdt_version_save(struct ptlrpc_request *req, __u64 version,
+static void mdt_version_save(struct mdt_thread_info *info, __u64 version,
 			     int idx)
 {
+	struct ptlrpc_request *req = mdt_info_req(info);
 	__u64 *reply_ver;
 
 	if (!exp_connect_vbr(req->rq_export))
@@ -100,7 +107,9 @@ static void mdt_version_save(struct ptlrpc_request *req, __u64 version,
 
 	LASSERT(!req_is_replay(req));
 	LASSERT(req->rq_repmsg != NULL);
-	reply_ver = lustre_msg_get_versions(req->rq_repmsg);
+	reply_ver = lustre_msg_get_versions(info->mti_batch_env ?
+					    info->mti_pill->rc_repmsg :
+					    req->rq_repmsg);
 	if (reply_ver)
 		reply_ver[idx] = version;
 }
@@ -114,7 +123,7 @@ static void mdt_enoent_version_save(struct mdt_thread_info *info, int idx)
 	/* save version of file name for replay, it must be ENOENT here */
 	if (!req_is_replay(mdt_info_req(info))) {
 		info->mti_ver[idx] = ENOENT_VERSION;
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	}
 }
 
@@ -129,7 +138,7 @@ void mdt_version_get_save(struct mdt_thread_info *info,
 	/* don't save versions during replay */
 	if (!req_is_replay(mdt_info_req(info))) {
 		mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	}
 }
 
@@ -144,7 +153,7 @@ int mdt_version_get_check(struct mdt_thread_info *info,
 		return 0;
 
 	mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
-	return mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
+	return mdt_version_check(info, info->mti_ver[idx], idx);
 }
 
 /**
@@ -157,10 +166,9 @@ int mdt_version_get_check_save(struct mdt_thread_info *info,
 
 	mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
 	if (req_is_replay(mdt_info_req(info)))
-		rc = mdt_version_check(mdt_info_req(info), info->mti_ver[idx],
-				       idx);
+		rc = mdt_version_check(info, info->mti_ver[idx], idx);
 	else
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	return rc;
 }
 
@@ -193,7 +201,7 @@ int mdt_lookup_version_check(struct mdt_thread_info *info,
 			mdt_object_put(info->mti_env, child);
 		}
 	}
-	vbrc = mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
+	vbrc = mdt_version_check(info, info->mti_ver[idx], idx);
 	return vbrc ? vbrc : rc;
 
 }
@@ -593,8 +601,8 @@ static int mdt_create(struct mdt_thread_info *info, struct mdt_lock_handle *lhc)
 				LASSERT(info->mti_spec.sp_replay);
 				mdt_obj_version_get(info, child,
 						    &info->mti_ver[1]);
-				rc = mdt_version_check(mdt_info_req(info),
-						       info->mti_ver[1], 1);
+				rc = mdt_version_check(info, info->mti_ver[1],
+						       1);
 			}
 			GOTO(put_parent, rc);
 		} else if (restripe) {
@@ -618,7 +626,7 @@ static int mdt_create(struct mdt_thread_info *info, struct mdt_lock_handle *lhc)
 
 	if (unlikely(info->mti_spec.sp_replay)) {
 		/* check version only during replay */
-		rc = mdt_version_check(mdt_info_req(info), ENOENT_VERSION, 1);
+		rc = mdt_version_check(info, ENOENT_VERSION, 1);
 		if (rc)
 			GOTO(put_parent, rc);
 	} else {
@@ -1320,6 +1328,11 @@ static int mdt_reint_unlink(struct mdt_thread_info *info,
 		repbody->mbo_valid |= (OBD_MD_FLID | OBD_MD_MDS);
 		GOTO(unlock_child, rc = -EREMOTE);
 	}
+
+	/* a batched unlink never removes a directory, as unlink(2) */
+	if (info->mti_batch_env && S_ISDIR(lu_object_attr(&mc->mot_obj)))
+		GOTO(put_child, rc = -EISDIR);
+
 	/* We used to acquire MDS_INODELOCK_FULL here but we can't do
 	 * this now because a running HSM restore on the child (unlink
 	 * victim) will hold the layout lock. See LU-4002.
@@ -1505,7 +1518,7 @@ static int mdt_reint_link(struct mdt_thread_info *info,
 			GOTO(unlock_source, rc = -EEXIST);
 		}
 		info->mti_ver[2] = ENOENT_VERSION;
-		mdt_version_save(mdt_info_req(info), info->mti_ver[2], 2);
+		mdt_version_save(info, info->mti_ver[2], 2);
 	}
 
 	rc = mdo_link(info->mti_env, mdt_object_child(mp),
@@ -26,6 +26,7 @@
 #include <lustre_kernelcomm.h>
 #include <lprocfs_status.h>
 #include <cl_object.h>
+#include <lustre_compr.h>
 #ifdef HAVE_SERVER_SUPPORT
 # include <dt_object.h>
 # include <md_object.h>
@@ -879,6 +880,7 @@ cleanup_dt_global:
 
 cleanup_obd_pool:
 #endif /* HAVE_SERVER_SUPPORT */
+	ll_compr_fini();
 	obd_pool_fini();
 
 cleanup_llog_info:
@@ -952,6 +954,7 @@ static void __exit obdclass_exit(void)
 	lu_ucred_global_fini();
 	dt_global_fini();
 #endif /* HAVE_SERVER_SUPPORT */
+	ll_compr_fini();
 	obd_pool_fini();
 	llog_info_fini();
 	cl_global_fini();
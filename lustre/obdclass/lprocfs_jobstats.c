@@ -13,12 +13,37 @@
 
 #define DEBUG_SUBSYSTEM S_CLASS
 
+#include <linux/jhash.h>
 #include <obd_class.h>
 #include <lprocfs_status.h>
 
 #ifdef CONFIG_PROC_FS
 
 #define JOB_CLEANUP_BATCH 1024
+
+/*
+ * Jobs recently updated on each CPU, indexed by hash of the jobid. The RPC
+ * handlers find their job there without taking ojs_rwsem nor a reference
+ * on the job, which is only freed after a RCU grace period.
+ */
+#define JOB_CACHE_BITS		6
+#define JOB_CACHE_SIZE		(1 << JOB_CACHE_BITS)
+
+struct job_stat_cache {
+	struct job_stat		*jsc_jobs[JOB_CACHE_SIZE];
+};
+
+/*
+ * js_time_latest is updated at most every JOB_TIME_RES, and a job is moved
+ * to the tail of ojs_lru at most every JOB_LRU_RES, so the RPCs of a busy
+ * job do not keep writing the same cache line and taking ojs_lock.
+ */
+#define JOB_TIME_RES		(NSEC_PER_SEC / 100)
+#define JOB_LRU_RES		NSEC_PER_SEC
+
+/* Default number of jobs in job_stats_top */
+#define JOB_TOP_COUNT_DEFAULT	10
+#define JOB_TOP_COUNT_MAX	1000
 /*
  * JobID formats & JobID environment variable names for supported
  * job schedulers:
@@ -53,8 +78,10 @@ struct job_stat {
 	u64			js_pos_id;	/* pos for job stats seq file */
 	struct kref		js_refcount;	/* num users of this struct */
 	char			js_jobid[LUSTRE_JOBID_SIZE]; /* job name + NUL*/
+	u32			js_hash;	/* hash of js_jobid */
 	ktime_t			js_time_init;	/* time of initial stat*/
 	ktime_t			js_time_latest;	/* time of most recent stat*/
+	ktime_t			js_time_lru;	/* time of move to LRU tail */
 	struct lprocfs_stats	*js_stats;	/* per-job statistics */
 	struct obd_job_stats	*js_jobstats;	/* for accessing ojs_lock */
 	struct rcu_head		js_rcu;		/* RCU head for job_reclaim_rcu*/
@@ -72,6 +99,19 @@ static void job_reclaim_rcu(struct rcu_head *head)
 		clear_bit(OJS_ACTIVE_JOBS, &stats->ojs_flags);
 }
 
+static void job_cache_del(struct obd_job_stats *stats, struct job_stat *job)
+{
+	unsigned int idx = job->js_hash & (JOB_CACHE_SIZE - 1);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct job_stat_cache *cache;
+
+		cache = per_cpu_ptr(stats->ojs_cache, cpu);
+		cmpxchg(&cache->jsc_jobs[idx], job, NULL);
+	}
+}
+
 static void job_purge_locked(struct obd_job_stats *stats, unsigned int sched)
 {
 	struct job_stat *job, *n;
@@ -86,6 +126,8 @@ static void job_purge_locked(struct obd_job_stats *stats, unsigned int sched)
 	llist_for_each_entry_safe(job, n, entry, js_deleted) {
 		rb_erase(&job->js_posnode, &stats->ojs_postree);
 		rb_erase(&job->js_idnode, &stats->ojs_idtree);
+		/* lockless lookups may still see the job until a grace period */
+		job_cache_del(stats, job);
 		call_rcu(&job->js_rcu, job_reclaim_rcu);
 
 		if (++count == sched) {
@@ -178,8 +220,11 @@ static void lprocfs_job_cleanup(struct obd_job_stats *stats, bool clear)
 	/* remove all jobs older oldest */
 	rcu_read_lock();
 	list_for_each_entry_rcu(job, &stats->ojs_lru, js_lru) {
-		if (!ktime_before(job->js_time_latest, oldest))
+		if (!ktime_before(job->js_time_lru, oldest))
 			break;
+		/* updated since it was last moved to the LRU tail */
+		if (!ktime_before(READ_ONCE(job->js_time_latest), oldest))
+			continue;
 		job_putref(job); /* drop ref to initiate removal */
 	}
 	rcu_read_unlock();
@@ -192,7 +237,8 @@ static void lprocfs_job_cleanup(struct obd_job_stats *stats, bool clear)
 	clear_bit(OJS_CLEANING, &stats->ojs_flags);
 }
 
-static struct job_stat *job_alloc(char *jobid, struct obd_job_stats *jobs)
+static struct job_stat *job_alloc(char *jobid, u32 hash,
+				  struct obd_job_stats *jobs)
 {
 	struct job_stat *job;
 
@@ -209,7 +255,9 @@ static struct job_stat *job_alloc(char *jobid, struct obd_job_stats *jobs)
 	jobs->ojs_cntr_init_fn(job->js_stats, 0, 0);
 
 	memcpy(job->js_jobid, jobid, sizeof(job->js_jobid));
+	job->js_hash = hash;
 	job->js_time_latest = job->js_stats->ls_init;
+	job->js_time_lru = job->js_stats->ls_init;
 	job->js_jobstats = jobs;
 	RB_CLEAR_NODE(&job->js_idnode);
 	INIT_LIST_HEAD(&job->js_lru);
@@ -365,12 +413,75 @@ static void job_insert_pos(struct obd_job_stats *stats, struct job_stat *job)
 	} while (node);
 }
 
+/* find a job recently updated on this CPU, called under rcu_read_lock() */
+static struct job_stat *job_cache_find(struct obd_job_stats *stats,
+				       const char *jobid, u32 hash)
+{
+	struct job_stat_cache *cache;
+	struct job_stat *job;
+
+	cache = get_cpu_ptr(stats->ojs_cache);
+	job = READ_ONCE(cache->jsc_jobs[hash & (JOB_CACHE_SIZE - 1)]);
+	put_cpu_ptr(stats->ojs_cache);
+
+	if (job && job->js_hash == hash &&
+	    kref_read(&job->js_refcount) > 0 &&
+	    strcmp(job->js_jobid, jobid) == 0)
+		return job;
+
+	return NULL;
+}
+
+/*
+ * Remember a job on this CPU. The caller holds a reference on the job, so
+ * it cannot be purged, and removed from the caches, before this is done.
+ */
+static void job_cache_add(struct obd_job_stats *stats, struct job_stat *job)
+{
+	struct job_stat_cache *cache;
+
+	cache = get_cpu_ptr(stats->ojs_cache);
+	WRITE_ONCE(cache->jsc_jobs[job->js_hash & (JOB_CACHE_SIZE - 1)], job);
+	put_cpu_ptr(stats->ojs_cache);
+}
+
+/*
+ * Account an event to a job. The caller holds either a reference on the
+ * job, or rcu_read_lock() for a job found in the per-CPU caches.
+ */
+static void job_stat_update(struct obd_job_stats *stats, struct job_stat *job,
+			    int event, long amount, bool mru_last)
+{
+	ktime_t now = ktime_get_real();
+
+	if (ktime_to_ns(ktime_sub(now, READ_ONCE(job->js_time_latest))) >=
+	    JOB_TIME_RES)
+		WRITE_ONCE(job->js_time_latest, now);
+
+	if (mru_last) {
+		job->js_time_lru = now;
+	} else if (ktime_to_ns(ktime_sub(now, READ_ONCE(job->js_time_lru))) >=
+		   JOB_LRU_RES) {
+		spin_lock(&stats->ojs_lock);
+		/* job_free() removes the job from the LRU list under ojs_lock */
+		if (kref_read(&job->js_refcount) > 0) {
+			job->js_time_lru = now;
+			list_del_rcu(&job->js_lru);
+			list_add_tail_rcu(&job->js_lru, &stats->ojs_lru);
+		}
+		spin_unlock(&stats->ojs_lock);
+	}
+	lprocfs_counter_add(job->js_stats, event, amount);
+}
+
 int lprocfs_job_stats_log(struct obd_device *obd, char *jobid,
 			  int event, long amount)
 {
 	struct obd_job_stats *stats = &obd2obt(obd)->obt_jobstats;
 	struct job_stat *job, *existing_job;
 	bool mru_last = false;
+	size_t len;
+	u32 hash;
 	ENTRY;
 
 	LASSERT(stats);
@@ -382,16 +493,30 @@ int lprocfs_job_stats_log(struct obd_device *obd, char *jobid,
 	if (event >= stats->ojs_cntr_num)
 		RETURN(-EINVAL);
 
-	if (jobid == NULL || strlen(jobid) == 0)
+	if (jobid == NULL)
+		RETURN(0);
+
+	len = strnlen(jobid, LUSTRE_JOBID_SIZE);
+	if (len == 0)
 		RETURN(0);
 
 	/* unterminated jobid should be handled in lustre_msg_get_jobid() */
-	if (strlen(jobid) >= LUSTRE_JOBID_SIZE) {
+	if (len >= LUSTRE_JOBID_SIZE) {
 		CERROR("%s: invalid jobid size %lu, expect %d\n", obd->obd_name,
 		       (unsigned long)strlen(jobid) + 1, LUSTRE_JOBID_SIZE);
 		RETURN(-EINVAL);
 	}
 
+	hash = jhash(jobid, len, 0);
+	rcu_read_lock();
+	job = job_cache_find(stats, jobid, hash);
+	if (job) {
+		job_stat_update(stats, job, event, amount, false);
+		rcu_read_unlock();
+		RETURN(0);
+	}
+	rcu_read_unlock();
+
 	down_read(&stats->ojs_rwsem);
 	job = job_find(stats, jobid);
 	up_read(&stats->ojs_rwsem);
@@ -400,7 +525,7 @@ int lprocfs_job_stats_log(struct obd_device *obd, char *jobid,
 
 	lprocfs_job_cleanup(stats, false);
 
-	job = job_alloc(jobid, stats);
+	job = job_alloc(jobid, hash, stats);
 	if (!job)
 		RETURN(-ENOMEM);
 
@@ -429,14 +554,8 @@ try_insert:
 
 found:
 	LASSERT(stats == job->js_jobstats);
-	job->js_time_latest = ktime_get_real();
-	if (!mru_last) {
-		spin_lock(&stats->ojs_lock);
-		list_del_rcu(&job->js_lru);
-		list_add_tail_rcu(&job->js_lru, &stats->ojs_lru);
-		spin_unlock(&stats->ojs_lock);
-	}
-	lprocfs_counter_add(job->js_stats, event, amount);
+	job_cache_add(stats, job);
+	job_stat_update(stats, job, event, amount, mru_last);
 
 	/* drop the extra ref from find | insert */
 	job_putref(job);
@@ -490,6 +609,8 @@ void lprocfs_job_stats_fini(struct obd_device *obd)
 	LASSERT(RB_EMPTY_ROOT(&stats->ojs_idtree));
 	LASSERT(list_empty(&stats->ojs_lru));
 	LASSERT(llist_empty(&stats->ojs_deleted));
+	free_percpu(stats->ojs_cache);
+	stats->ojs_cache = NULL;
 }
 EXPORT_SYMBOL(lprocfs_job_stats_fini);
 
@@ -573,10 +694,8 @@ static inline int width(const char *str, int len)
 	return len - min((int)strlen(str), 15);
 }
 
-static int lprocfs_jobstats_seq_show(struct seq_file *p, void *v)
+static void job_stat_show(struct seq_file *p, struct job_stat *job)
 {
-	struct obd_job_stats *stats = p->private;
-	struct job_stat *job = v;
 	struct lprocfs_stats *s;
 	struct lprocfs_counter ret;
 	struct lprocfs_counter_header *cntr_header;
@@ -584,12 +703,6 @@ static int lprocfs_jobstats_seq_show(struct seq_file *p, void *v)
 	char *quote = "", *c, *end;
 	int i, joblen = 0;
 
-	if (v == SEQ_START_TOKEN)
-		return 0;
-
-	if (test_and_clear_bit(OJS_HEADER, &stats->ojs_flags))
-		seq_puts(p, "job_stats:\n");
-
 	/* Quote and escape jobid characters to escape hex codes "\xHH" if
 	 * it contains any non-standard characters (space, newline, etc),
 	 * so it will be confined to single line and not break parsing.
@@ -676,6 +789,20 @@ static int lprocfs_jobstats_seq_show(struct seq_file *p, void *v)
 		}
 		seq_puts(p, " }\n");
 	}
+}
+
+static int lprocfs_jobstats_seq_show(struct seq_file *p, void *v)
+{
+	struct obd_job_stats *stats = p->private;
+	struct job_stat *job = v;
+
+	if (v == SEQ_START_TOKEN)
+		return 0;
+
+	if (test_and_clear_bit(OJS_HEADER, &stats->ojs_flags))
+		seq_puts(p, "job_stats:\n");
+
+	job_stat_show(p, job);
 	job_putref(job);
 
 	return 0;
@@ -804,6 +931,360 @@ static const struct proc_ops lprocfs_jobstats_seq_fops = {
 	.proc_release	= lprocfs_jobstats_seq_release,
 };
 
+/* counter names and units for a device, without any job to get them from */
+static struct lprocfs_stats *job_stats_names_alloc(struct obd_job_stats *stats)
+{
+	struct lprocfs_stats *names;
+
+	names = lprocfs_stats_alloc(stats->ojs_cntr_num,
+				    LPROCFS_STATS_FLAG_NOPERCPU);
+	if (names)
+		stats->ojs_cntr_init_fn(names, 0, 0);
+
+	return names;
+}
+
+/*
+ * job_stats_top shows the ojs_top_count jobs with the most samples of the
+ * counter ojs_top_cntr (or the largest sum of a counter with min/max/sum),
+ * or with the most samples of all counters if ojs_top_cntr is -1, in the
+ * same format as job_stats.
+ */
+struct job_stat_top {
+	u64			 jst_key;
+	struct job_stat		*jst_job;
+};
+
+static u64 job_stat_key(struct job_stat *job, int cntr)
+{
+	struct lprocfs_stats *s = job->js_stats;
+	struct lprocfs_counter ret;
+	u64 key = 0;
+	int i;
+
+	if (cntr >= 0) {
+		lprocfs_stats_collect(s, cntr, &ret);
+		if (s->ls_cnt_header[cntr].lc_config & LPROCFS_CNTR_AVGMINMAX)
+			return ret.lc_sum;
+		return ret.lc_count;
+	}
+
+	for (i = 0; i < s->ls_num; i++) {
+		lprocfs_stats_collect(s, i, &ret);
+		key += ret.lc_count;
+	}
+
+	return key;
+}
+
+static void job_top_sift_down(struct job_stat_top *top, int nr, int i)
+{
+	while (2 * i + 1 < nr) {
+		int child = 2 * i + 1;
+
+		if (child + 1 < nr && top[child + 1].jst_key < top[child].jst_key)
+			child++;
+		if (top[i].jst_key <= top[child].jst_key)
+			break;
+		swap(top[i], top[child]);
+		i = child;
+	}
+}
+
+static void job_top_sift_up(struct job_stat_top *top, int i)
+{
+	while (i > 0 && top[(i - 1) / 2].jst_key > top[i].jst_key) {
+		swap(top[i], top[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+}
+
+static int lprocfs_jobstats_top_seq_show(struct seq_file *p, void *v)
+{
+	struct obd_job_stats *stats = p->private;
+	unsigned int count = READ_ONCE(stats->ojs_top_count);
+	int cntr = READ_ONCE(stats->ojs_top_cntr);
+	struct job_stat_top *top;
+	struct rb_node *node;
+	int nr = 0;
+	int i;
+
+	if (cntr >= stats->ojs_cntr_num)
+		cntr = -1;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(top, count);
+	if (!top)
+		return -ENOMEM;
+
+	/* jobs are only erased from the tree with ojs_rwsem held for write */
+	down_read(&stats->ojs_rwsem);
+	for (node = rb_first(&stats->ojs_postree); node; node = rb_next(node)) {
+		struct job_stat *job;
+		u64 key;
+
+		job = container_of(node, struct job_stat, js_posnode);
+		if (kref_read(&job->js_refcount) == 0)
+			continue;
+
+		key = job_stat_key(job, cntr);
+		/* min-heap of the largest keys seen so far */
+		if (nr < count) {
+			top[nr].jst_key = key;
+			top[nr].jst_job = job;
+			job_top_sift_up(top, nr++);
+		} else if (key > top[0].jst_key) {
+			top[0].jst_key = key;
+			top[0].jst_job = job;
+			job_top_sift_down(top, nr, 0);
+		}
+	}
+
+	/* pop the smallest key to the end, for a decreasing order */
+	for (i = nr - 1; i > 0; i--) {
+		swap(top[0], top[i]);
+		job_top_sift_down(top, i, 0);
+	}
+
+	seq_puts(p, "job_stats:\n");
+	for (i = 0; i < nr; i++)
+		job_stat_show(p, top[i].jst_job);
+	up_read(&stats->ojs_rwsem);
+
+	OBD_FREE_PTR_ARRAY_LARGE(top, count);
+
+	return 0;
+}
+
+static int lprocfs_jobstats_top_seq_open(struct inode *inode,
+					 struct file *file)
+{
+	return single_open(file, lprocfs_jobstats_top_seq_show,
+			   pde_data(inode));
+}
+
+/*
+ * Set the number of jobs shown by job_stats_top, and optionally the name
+ * of the counter to sort them by, or "all" for the samples of all counters:
+ * lctl set_param obdfilter.*.job_stats_top="20 write_bytes"
+ */
+static ssize_t lprocfs_jobstats_top_seq_write(struct file *file,
+					      const char __user *buf,
+					      size_t len, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_job_stats *stats = seq->private;
+	struct lprocfs_stats *names;
+	char kernbuf[64];
+	char *name = kernbuf;
+	char *num;
+	unsigned int count;
+	int cntr = -1;
+	int rc;
+
+	if (len == 0 || len >= sizeof(kernbuf))
+		return -EINVAL;
+
+	if (copy_from_user(kernbuf, buf, len))
+		return -EFAULT;
+	kernbuf[len] = '\0';
+
+	num = strsep(&name, " \t\n");
+	rc = kstrtouint(num, 10, &count);
+	if (rc)
+		return rc;
+	if (count == 0 || count > JOB_TOP_COUNT_MAX)
+		return -ERANGE;
+
+	if (name)
+		name = strim(name);
+	if (name && name[0] != '\0' && strcmp(name, "all") != 0) {
+		names = job_stats_names_alloc(stats);
+		if (!names)
+			return -ENOMEM;
+
+		for (cntr = 0; cntr < names->ls_num; cntr++)
+			if (strcmp(names->ls_cnt_header[cntr].lc_name,
+				   name) == 0)
+				break;
+		if (cntr == names->ls_num)
+			cntr = -EINVAL;
+		lprocfs_stats_free(&names);
+		if (cntr < 0)
+			return cntr;
+	}
+
+	stats->ojs_top_count = count;
+	stats->ojs_top_cntr = cntr;
+
+	return len;
+}
+
+static const struct proc_ops lprocfs_jobstats_top_fops = {
+	PROC_OWNER(THIS_MODULE)
+	.proc_open	= lprocfs_jobstats_top_seq_open,
+	.proc_read	= seq_read,
+	.proc_write	= lprocfs_jobstats_top_seq_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
+/*
+ * job_stats_bin dumps the job stats in the binary format of
+ * struct job_stats_bin_hdr and struct job_stats_bin_rec, which monitoring
+ * tools can read without formatting and parsing the YAML of job_stats.
+ */
+static void *lprocfs_jobstats_bin_seq_start(struct seq_file *p, loff_t *pos)
+{
+	struct obd_job_stats *stats = p->private;
+	struct job_stat *start;
+
+	down_read(&stats->ojs_rwsem);
+	if (*pos == 0)
+		return SEQ_START_TOKEN;
+
+	start = job_find_first_pos(stats, *pos);
+	if (start)
+		*pos = start->js_pos_id;
+
+	return start;
+}
+
+static void *lprocfs_jobstats_bin_seq_next(struct seq_file *p, void *v,
+					   loff_t *pos)
+{
+	struct obd_job_stats *stats = p->private;
+	struct job_stat *next;
+
+	if (v == SEQ_START_TOKEN) {
+		next = job_find_first_pos(stats, 1);
+		*pos = next ? next->js_pos_id : 1;
+		return next;
+	}
+
+	return lprocfs_jobstats_seq_next(p, v, pos);
+}
+
+static size_t job_stats_bin_rec_len(struct obd_job_stats *stats)
+{
+	return offsetof(struct job_stats_bin_rec,
+			jsbr_cntrs[stats->ojs_cntr_num]);
+}
+
+static int job_stats_bin_hdr_show(struct seq_file *p)
+{
+	struct obd_job_stats *stats = p->private;
+	struct job_stats_bin_hdr *hdr;
+	struct lprocfs_stats *names;
+	size_t len;
+	int i;
+
+	names = job_stats_names_alloc(stats);
+	if (!names)
+		return -ENOMEM;
+
+	len = offsetof(struct job_stats_bin_hdr,
+		       jsbh_names[stats->ojs_cntr_num]);
+	OBD_ALLOC(hdr, len);
+	if (!hdr) {
+		lprocfs_stats_free(&names);
+		return -ENOMEM;
+	}
+
+	hdr->jsbh_magic = JOB_STATS_BIN_MAGIC;
+	hdr->jsbh_cntr_num = stats->ojs_cntr_num;
+	hdr->jsbh_rec_len = job_stats_bin_rec_len(stats);
+	hdr->jsbh_snapshot_ns = ktime_get_real_ns();
+	for (i = 0; i < stats->ojs_cntr_num; i++) {
+		struct lprocfs_counter_header *header;
+
+		header = &names->ls_cnt_header[i];
+		strscpy(hdr->jsbh_names[i].jsbn_name, header->lc_name,
+			sizeof(hdr->jsbh_names[i].jsbn_name));
+		if (header->lc_units)
+			strscpy(hdr->jsbh_names[i].jsbn_units,
+				header->lc_units,
+				sizeof(hdr->jsbh_names[i].jsbn_units));
+	}
+	seq_write(p, hdr, len);
+
+	OBD_FREE(hdr, len);
+	lprocfs_stats_free(&names);
+
+	return 0;
+}
+
+static int lprocfs_jobstats_bin_seq_show(struct seq_file *p, void *v)
+{
+	struct obd_job_stats *stats = p->private;
+	struct job_stat *job = v;
+	struct job_stats_bin_rec *rec;
+	struct lprocfs_counter ret;
+	size_t len;
+	int i;
+
+	if (v == SEQ_START_TOKEN)
+		return job_stats_bin_hdr_show(p);
+
+	len = job_stats_bin_rec_len(stats);
+	OBD_ALLOC(rec, len);
+	if (!rec) {
+		job_putref(job);
+		return -ENOMEM;
+	}
+
+	memcpy(rec->jsbr_jobid, job->js_jobid, sizeof(rec->jsbr_jobid));
+	rec->jsbr_start_ns = ktime_to_ns(job->js_stats->ls_init);
+	rec->jsbr_latest_ns = ktime_to_ns(job->js_time_latest);
+	for (i = 0; i < job->js_stats->ls_num; i++) {
+		struct job_stats_bin_cntr *cntr = &rec->jsbr_cntrs[i];
+
+		lprocfs_stats_collect(job->js_stats, i, &ret);
+		cntr->jsbc_count = ret.lc_count;
+		if (ret.lc_count == 0)
+			continue;
+		cntr->jsbc_min = ret.lc_min;
+		cntr->jsbc_max = ret.lc_max;
+		cntr->jsbc_sum = ret.lc_sum;
+		cntr->jsbc_sumsq = ret.lc_sumsquare;
+	}
+	seq_write(p, rec, len);
+	OBD_FREE(rec, len);
+	job_putref(job);
+
+	return 0;
+}
+
+static const struct seq_operations lprocfs_jobstats_bin_seq_sops = {
+	.start	= lprocfs_jobstats_bin_seq_start,
+	.stop	= lprocfs_jobstats_seq_stop,
+	.next	= lprocfs_jobstats_bin_seq_next,
+	.show	= lprocfs_jobstats_bin_seq_show,
+};
+
+static int lprocfs_jobstats_bin_seq_open(struct inode *inode,
+					 struct file *file)
+{
+	struct seq_file *seq;
+	int rc;
+
+	rc = seq_open(file, &lprocfs_jobstats_bin_seq_sops);
+	if (rc)
+		return rc;
+
+	seq = file->private_data;
+	seq->private = pde_data(inode);
+
+	return 0;
+}
+
+static const struct proc_ops lprocfs_jobstats_bin_fops = {
+	PROC_OWNER(THIS_MODULE)
+	.proc_open	= lprocfs_jobstats_bin_seq_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= lprocfs_seq_release,
+};
+
 int lprocfs_job_stats_init(struct obd_device *obd, int cntr_num,
 			   cntr_init_callback init_fn)
 {
@@ -845,6 +1326,11 @@ int lprocfs_job_stats_init(struct obd_device *obd, int cntr_num,
 	stats->ojs_cntr_num = cntr_num;
 	stats->ojs_cntr_init_fn = init_fn;
 	atomic64_set(&stats->ojs_jobs, 0);
+	stats->ojs_top_count = JOB_TOP_COUNT_DEFAULT;
+	stats->ojs_top_cntr = -1;
+	stats->ojs_cache = alloc_percpu(struct job_stat_cache);
+	if (!stats->ojs_cache)
+		RETURN(-ENOMEM);
 
 	entry = lprocfs_add_simple(obd->obd_proc_entry, "job_stats", stats,
 				   &lprocfs_jobstats_seq_fops);
@@ -852,6 +1338,20 @@ int lprocfs_job_stats_init(struct obd_device *obd, int cntr_num,
 		lprocfs_job_stats_fini(obd);
 		RETURN(-ENOMEM);
 	}
+
+	entry = lprocfs_add_simple(obd->obd_proc_entry, "job_stats_top", stats,
+				   &lprocfs_jobstats_top_fops);
+	if (IS_ERR(entry)) {
+		lprocfs_job_stats_fini(obd);
+		RETURN(-ENOMEM);
+	}
+
+	entry = lprocfs_add_simple(obd->obd_proc_entry, "job_stats_bin", stats,
+				   &lprocfs_jobstats_bin_fops);
+	if (IS_ERR(entry)) {
+		lprocfs_job_stats_fini(obd);
+		RETURN(-ENOMEM);
+	}
 	RETURN(0);
 }
 EXPORT_SYMBOL(lprocfs_job_stats_init);
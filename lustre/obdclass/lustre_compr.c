@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Compression of file data chunks with the kernel crypto compression API.
+ */
+
+#define DEBUG_SUBSYSTEM S_SEC
+
+#include <linux/crc32.h>
+#include <linux/sched/mm.h>
+
+#include <obd_support.h>
+#include <lustre_compr.h>
+
+static const char * const ll_compr_names[LL_COMPR_TYPE_MAX] = {
+	[LL_COMPR_TYPE_NONE]	= NULL,
+	[LL_COMPR_TYPE_FAST]	= "lz4",
+	[LL_COMPR_TYPE_BEST]	= "zstd",
+	[LL_COMPR_TYPE_LZ4]	= "lz4",
+	[LL_COMPR_TYPE_LZ4HC]	= "lz4hc",
+	[LL_COMPR_TYPE_ZSTD]	= "zstd",
+	[LL_COMPR_TYPE_GZIP]	= "deflate",
+};
+
+/**
+ * Name of the crypto compression algorithm implementing @type.
+ *
+ * \retval	algorithm name, or NULL if @type is not a compression type
+ */
+const char *ll_compr_type_name(enum ll_compr_type type)
+{
+	if (type >= LL_COMPR_TYPE_MAX)
+		return NULL;
+
+	return ll_compr_names[type];
+}
+EXPORT_SYMBOL(ll_compr_type_name);
+
+/*
+ * Idle transforms kept for reuse. Setting up a transform allocates the
+ * working memory of the algorithm, which is large for zstd, so it is not
+ * done again for every RPC.
+ */
+#define LL_COMPR_CACHE_MAX	16
+
+static DEFINE_SPINLOCK(ll_compr_cache_lock);
+static struct crypto_comp *ll_compr_cache[LL_COMPR_TYPE_MAX]
+					 [LL_COMPR_CACHE_MAX];
+static int ll_compr_cache_count[LL_COMPR_TYPE_MAX];
+
+/**
+ * Get a compression transform for @type.
+ *
+ * A transform keeps its working memory, so it must not be used by several
+ * threads at the same time. It is returned with ll_compr_put().
+ *
+ * \param[in] type	compression type
+ * \param[out] cc	transform
+ *
+ * \retval 0		on success
+ * \retval -EINVAL	@type is not a compression type
+ * \retval negative	errno if the algorithm is not available
+ */
+int ll_compr_get(enum ll_compr_type type, struct crypto_comp **cc)
+{
+	const char *name = ll_compr_type_name(type);
+	struct crypto_comp *tfm = NULL;
+	unsigned int nofs;
+
+	if (!name)
+		return -EINVAL;
+
+	spin_lock(&ll_compr_cache_lock);
+	if (ll_compr_cache_count[type] > 0)
+		tfm = ll_compr_cache[type][--ll_compr_cache_count[type]];
+	spin_unlock(&ll_compr_cache_lock);
+	if (tfm) {
+		*cc = tfm;
+		return 0;
+	}
+
+	/* called in the writeback path, do not recurse into the fs */
+	nofs = memalloc_nofs_save();
+	tfm = crypto_alloc_comp(name, 0, 0);
+	memalloc_nofs_restore(nofs);
+	if (IS_ERR(tfm)) {
+		CDEBUG(D_SEC, "cannot allocate %s compressor: rc = %ld\n",
+		       name, PTR_ERR(tfm));
+		return PTR_ERR(tfm);
+	}
+
+	*cc = tfm;
+	return 0;
+}
+EXPORT_SYMBOL(ll_compr_get);
+
+void ll_compr_put(enum ll_compr_type type, struct crypto_comp *cc)
+{
+	if (!cc)
+		return;
+
+	spin_lock(&ll_compr_cache_lock);
+	if (ll_compr_cache_count[type] < LL_COMPR_CACHE_MAX) {
+		ll_compr_cache[type][ll_compr_cache_count[type]++] = cc;
+		cc = NULL;
+	}
+	spin_unlock(&ll_compr_cache_lock);
+
+	if (cc)
+		crypto_free_comp(cc);
+}
+EXPORT_SYMBOL(ll_compr_put);
+
+/* free the idle transforms, on module unload */
+void ll_compr_fini(void)
+{
+	int type;
+
+	for (type = 0; type < LL_COMPR_TYPE_MAX; type++) {
+		while (ll_compr_cache_count[type] > 0)
+			crypto_free_comp(ll_compr_cache[type]
+					 [--ll_compr_cache_count[type]]);
+	}
+}
+
+static __u32 ll_compr_hdr_csum(const struct ll_compr_hdr *llch)
+{
+	return crc32_le(~0U, (const unsigned char *)llch,
+			offsetof(struct ll_compr_hdr, llch_hdr_csum));
+}
+
+/**
+ * Check whether @llch, read from the start of a chunk of @chunk_size
+ * bytes, describes a compressed chunk.
+ */
+bool ll_compr_hdr_valid(const struct ll_compr_hdr *llch,
+			unsigned int chunk_size)
+{
+	unsigned int compr_size = le32_to_cpu(llch->llch_compr_size);
+	unsigned int uncompr_size = le32_to_cpu(llch->llch_uncompr_size);
+
+	if (le32_to_cpu(llch->llch_magic) != LLCH_MAGIC ||
+	    llch->llch_header_size != sizeof(*llch) ||
+	    !ll_compr_type_name(llch->llch_compr_type))
+		return false;
+
+	if (le32_to_cpu(llch->llch_hdr_csum) != ll_compr_hdr_csum(llch))
+		return false;
+
+	return uncompr_size <= chunk_size &&
+	       sizeof(*llch) + compr_size <=
+	       round_up(uncompr_size, PAGE_SIZE) - PAGE_SIZE;
+}
+EXPORT_SYMBOL(ll_compr_hdr_valid);
+
+/**
+ * Compress one chunk.
+ *
+ * The result is only useful if it takes at least one page less than the
+ * data, so compression fails with -E2BIG if it does not fit in that space.
+ *
+ * \param[in] cc		transform allocated for @type
+ * \param[in] src		chunk data
+ * \param[in] src_len		bytes of chunk data
+ * \param[in] dst		output buffer, header followed by data
+ * \param[in,out] dst_len	size of @dst, bytes of output on return
+ * \param[in] type		compression type, stored in the header
+ * \param[in] chunk_log_bits	chunk size, stored in the header
+ *
+ * \retval 0			on success
+ * \retval negative		errno if the chunk has to be stored plain
+ */
+int ll_compress_chunk(struct crypto_comp *cc, const void *src,
+		      unsigned int src_len, void *dst, unsigned int *dst_len,
+		      enum ll_compr_type type, unsigned int chunk_log_bits)
+{
+	struct ll_compr_hdr *llch = dst;
+	unsigned int limit = round_up(src_len, PAGE_SIZE);
+	unsigned int clen;
+	int rc;
+
+	if (limit <= PAGE_SIZE)
+		return -E2BIG;
+
+	limit -= PAGE_SIZE;
+	if (limit > *dst_len)
+		limit = *dst_len;
+	clen = limit - sizeof(*llch);
+
+	rc = crypto_comp_compress(cc, src, src_len, dst + sizeof(*llch),
+				  &clen);
+	if (rc)
+		return rc == -ENOMEM ? rc : -E2BIG;
+
+	llch->llch_magic = cpu_to_le32(LLCH_MAGIC);
+	llch->llch_header_size = sizeof(*llch);
+	llch->llch_compr_type = type;
+	llch->llch_reserved0 = 0;
+	llch->llch_chunk_log_bits = chunk_log_bits;
+	llch->llch_compr_size = cpu_to_le32(clen);
+	llch->llch_uncompr_size = cpu_to_le32(src_len);
+	llch->llch_reserved1 = 0;
+	llch->llch_hdr_csum = cpu_to_le32(ll_compr_hdr_csum(llch));
+
+	*dst_len = sizeof(*llch) + clen;
+
+	return 0;
+}
+EXPORT_SYMBOL(ll_compress_chunk);
+
+/**
+ * Decompress one chunk stored by ll_compress_chunk().
+ *
+ * \param[in] cc		transform for the type in the chunk header
+ * \param[in] src		chunk header followed by compressed data,
+ *				validated by ll_compr_hdr_valid()
+ * \param[in] dst		output buffer
+ * \param[in,out] dst_len	size of @dst, bytes of chunk data on return
+ *
+ * \retval 0			on success
+ * \retval negative		errno on corrupted data
+ */
+int ll_decompress_chunk(struct crypto_comp *cc, const void *src,
+			void *dst, unsigned int *dst_len)
+{
+	const struct ll_compr_hdr *llch = src;
+	unsigned int uncompr_size = le32_to_cpu(llch->llch_uncompr_size);
+	unsigned int len = *dst_len;
+	int rc;
+
+	rc = crypto_comp_decompress(cc, src + sizeof(*llch),
+				    le32_to_cpu(llch->llch_compr_size),
+				    dst, &len);
+	if (rc)
+		return rc;
+	if (len != uncompr_size)
+		return -EUCLEAN;
+
+	*dst_len = len;
+
+	return 0;
+}
+EXPORT_SYMBOL(ll_decompress_chunk);
@@ -10,6 +10,13 @@
  * (blocking and nonblocking) and poll(), along with an ioctl that
  * returns diagnostic information on an oal device.
  *
+ * Each open file has its own log, which may also be mapped with mmap()
+ * so that entries are consumed in place without a syscall per batch (see
+ * struct lustre_access_log_ring_v1). The log and its control page are
+ * one vmalloc_user() area so both paths share the same head and tail.
+ * Readers are woken up after lalr_wakeup_count entries rather than for
+ * every entry.
+ *
  * A control device (/dev/lustre-access-log/control) supports an ioctl()
  * plus poll() method to for oal discovery. See uses of
  * oal_control_event_count and oal_control_wait_queue for details.
@@ -32,11 +39,13 @@
 #include <linux/idr.h>
 #include <linux/kernel.h>
 #include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
 #include <uapi/linux/lustre/lustre_idl.h>
 #include <uapi/linux/lustre/lustre_access_log.h>
 #include "ofd_internal.h"
@@ -64,7 +73,13 @@ struct oal_circ_buf {
 	__u32 ocb_filter;
 	wait_queue_head_t ocb_read_wait_queue;
 	unsigned int ocb_drop_count;
-	struct circ_buf ocb_circ;
+	unsigned int ocb_wakeup_pending;
+	/* only written under ocb_write_lock, copied to ocb_ring */
+	unsigned int ocb_head;
+	/* control page followed by the entries, shared with mmap() */
+	struct lustre_access_log_ring_v1 *ocb_ring;
+	char *ocb_buf;
+	unsigned long ocb_map_size;
 };
 
 static atomic_t oal_control_event_count = ATOMIC_INIT(0);
@@ -119,12 +134,22 @@ static void oal_log_minor_free(int minor)
 	spin_unlock(&oal_log_minor_lock);
 }
 
+/* The tail may be written by a reader through the mapping, so keep it
+ * inside the log and aligned to an entry whatever it holds.
+ */
+static unsigned int oal_tail(struct oal_circ_buf *ocb)
+{
+	struct ofd_access_log *oal = ocb->ocb_access_log;
+
+	return smp_load_acquire(&ocb->ocb_ring->lalr_tail) &
+	       (oal->oal_log_size - 1) & ~(oal->oal_entry_size - 1);
+}
+
 static bool oal_is_empty(struct oal_circ_buf *ocb)
 {
 	struct ofd_access_log *oal = ocb->ocb_access_log;
 
-	return CIRC_CNT(ocb->ocb_circ.head,
-			ocb->ocb_circ.tail,
+	return CIRC_CNT(READ_ONCE(ocb->ocb_head), oal_tail(ocb),
 			oal->oal_log_size) < oal->oal_entry_size;
 }
 
@@ -132,7 +157,8 @@ static ssize_t oal_write_entry(struct oal_circ_buf *ocb,
 			const void *entry, size_t entry_size)
 {
 	struct ofd_access_log *oal = ocb->ocb_access_log;
-	struct circ_buf *circ = &ocb->ocb_circ;
+	struct lustre_access_log_ring_v1 *ring = ocb->ocb_ring;
+	unsigned int space;
 	unsigned int head;
 	unsigned int tail;
 	ssize_t rc;
@@ -141,26 +167,37 @@ static ssize_t oal_write_entry(struct oal_circ_buf *ocb,
 		return -EINVAL;
 
 	spin_lock(&ocb->ocb_write_lock);
-	head = circ->head;
-	tail = READ_ONCE(circ->tail);
+	head = ocb->ocb_head;
+	tail = oal_tail(ocb);
 
 	/* CIRC_SPACE() return space available, 0..oal_log_size -
 	 * 1. It always leaves one free char, since a completely full
 	 * buffer would have head == tail, which is the same as empty. */
-	if (CIRC_SPACE(head, tail, oal->oal_log_size) < oal->oal_entry_size) {
+	space = CIRC_SPACE(head, tail, oal->oal_log_size);
+	if (space < oal->oal_entry_size) {
 		ocb->ocb_drop_count++;
+		WRITE_ONCE(ring->lalr_drop_count, ocb->ocb_drop_count);
 		rc = -EAGAIN;
 		goto out_write_lock;
 	}
 
-	memcpy(&circ->buf[head], entry, entry_size);
+	memcpy(&ocb->ocb_buf[head], entry, entry_size);
 	rc = entry_size;
 
+	head = (head + oal->oal_entry_size) & (oal->oal_log_size - 1);
 	/* Ensure the entry is stored before we update the head. */
-	smp_store_release(&circ->head,
-			(head + oal->oal_entry_size) & (oal->oal_log_size - 1));
-
-	wake_up(&ocb->ocb_read_wait_queue);
+	smp_store_release(&ocb->ocb_head, head);
+	smp_store_release(&ring->lalr_head, head);
+
+	/* Batch wakeups as asked by the reader, but do not let the log
+	 * fill up while it sleeps. */
+	space -= oal->oal_entry_size;
+	if (++ocb->ocb_wakeup_pending >= READ_ONCE(ring->lalr_wakeup_count) ||
+	    space < oal->oal_log_size / 2) {
+		ocb->ocb_wakeup_pending = 0;
+		if (wq_has_sleeper(&ocb->ocb_read_wait_queue))
+			wake_up(&ocb->ocb_read_wait_queue);
+	}
 out_write_lock:
 	spin_unlock(&ocb->ocb_write_lock);
 
@@ -175,7 +212,6 @@ static ssize_t oal_read_entry(struct oal_circ_buf *ocb,
 			void *entry_buf, size_t entry_buf_size)
 {
 	struct ofd_access_log *oal = ocb->ocb_access_log;
-	struct circ_buf *circ = &ocb->ocb_circ;
 	unsigned int head;
 	unsigned int tail;
 	ssize_t rc;
@@ -186,8 +222,8 @@ static ssize_t oal_read_entry(struct oal_circ_buf *ocb,
 	spin_lock(&ocb->ocb_read_lock);
 
 	/* Memory barrier usage follows circular-buffers.txt. */
-	head = smp_load_acquire(&circ->head);
-	tail = circ->tail;
+	head = smp_load_acquire(&ocb->ocb_head);
+	tail = oal_tail(ocb);
 
 	if (!CIRC_CNT(head, tail, oal->oal_log_size)) {
 		rc = oal->oal_is_closed ? 0 : -EAGAIN;
@@ -198,10 +234,10 @@ static ssize_t oal_read_entry(struct oal_circ_buf *ocb,
 
 	/* Extract one entry from the buffer. */
 	rc = min_t(size_t, oal->oal_entry_size, entry_buf_size);
-	memcpy(entry_buf, &circ->buf[tail], rc);
+	memcpy(entry_buf, &ocb->ocb_buf[tail], rc);
 
 	/* Memory barrier usage follows circular-buffers.txt. */
-	smp_store_release(&circ->tail,
+	smp_store_release(&ocb->ocb_ring->lalr_tail,
 			(tail + oal->oal_entry_size) & (oal->oal_log_size - 1));
 
 out_read_lock:
@@ -220,12 +256,22 @@ static int oal_file_open(struct inode *inode, struct file *filp)
 	ocb = kzalloc(sizeof(*ocb), GFP_KERNEL);
 	if (!ocb)
 		return -ENOMEM;
-	ocb->ocb_circ.buf = vmalloc(oal->oal_log_size);
-	if (!ocb->ocb_circ.buf) {
+
+	ocb->ocb_map_size = PAGE_SIZE + PAGE_ALIGN(oal->oal_log_size);
+	ocb->ocb_ring = vmalloc_user(ocb->ocb_map_size);
+	if (!ocb->ocb_ring) {
 		kfree(ocb);
 		return -ENOMEM;
 	}
 
+	BUILD_BUG_ON(sizeof(*ocb->ocb_ring) > PAGE_SIZE);
+	ocb->ocb_buf = (char *)ocb->ocb_ring + PAGE_SIZE;
+	ocb->ocb_ring->lalr_version = LUSTRE_ACCESS_LOG_VERSION_1;
+	ocb->ocb_ring->lalr_data_offset = PAGE_SIZE;
+	ocb->ocb_ring->lalr_log_size = oal->oal_log_size;
+	ocb->ocb_ring->lalr_entry_size = oal->oal_entry_size;
+	ocb->ocb_ring->lalr_is_closed = oal->oal_is_closed;
+
 	spin_lock_init(&ocb->ocb_write_lock);
 	spin_lock_init(&ocb->ocb_read_lock);
 	ocb->ocb_access_log = oal;
@@ -347,15 +393,26 @@ static unsigned int oal_file_poll(struct file *filp,
 	return mask;
 }
 
+static int oal_file_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct oal_circ_buf *ocb = filp->private_data;
+
+	if (vma->vm_pgoff != 0 ||
+	    vma->vm_end - vma->vm_start != ocb->ocb_map_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ocb->ocb_ring, 0);
+}
+
 static long oal_ioctl_info(struct oal_circ_buf *ocb, void __user *uarg)
 {
 	struct ofd_access_log *oal = ocb->ocb_access_log;
 	struct lustre_access_log_info_v1 __user *lali;
-	u32 entry_count = CIRC_CNT(ocb->ocb_circ.head,
-				ocb->ocb_circ.tail,
+	u32 head = READ_ONCE(ocb->ocb_head);
+	u32 tail = oal_tail(ocb);
+	u32 entry_count = CIRC_CNT(head, tail,
 				oal->oal_log_size) / oal->oal_entry_size;
-	u32 entry_space = CIRC_SPACE(ocb->ocb_circ.head,
-				ocb->ocb_circ.tail,
+	u32 entry_space = CIRC_SPACE(head, tail,
 				oal->oal_log_size) / oal->oal_entry_size;
 
 	lali = uarg;
@@ -376,10 +433,10 @@ static long oal_ioctl_info(struct oal_circ_buf *ocb, void __user *uarg)
 	if (put_user(oal->oal_entry_size, &lali->lali_entry_size))
 		return -EFAULT;
 
-	if (put_user(ocb->ocb_circ.head, &lali->_lali_head))
+	if (put_user(head, &lali->_lali_head))
 		return -EFAULT;
 
-	if (put_user(ocb->ocb_circ.tail, &lali->_lali_tail))
+	if (put_user(tail, &lali->_lali_tail))
 		return -EFAULT;
 
 	if (put_user(entry_space, &lali->_lali_entry_space))
@@ -424,7 +481,7 @@ static int oal_file_release(struct inode *inode, struct file *filp)
 	list_del(&ocb->ocb_list);
 	up_write(&oal->oal_buf_list_sem);
 
-	vfree(ocb->ocb_circ.buf);
+	vfree(ocb->ocb_ring);
 	kfree(ocb);
 
 	return 0;
@@ -438,6 +495,7 @@ static const struct file_operations oal_fops = {
 	.read = &oal_file_read,
 	.write = &oal_file_write,
 	.poll = &oal_file_poll,
+	.mmap = &oal_file_mmap,
 #ifdef HAVE_NO_LLSEEK
 	.llseek = &no_llseek,
 #endif
@@ -579,8 +637,10 @@ void ofd_access_log_delete(struct ofd_access_log *oal)
 
 	oal->oal_is_closed = 1;
 	down_read(&oal->oal_buf_list_sem);
-	list_for_each_entry(ocb, &oal->oal_circ_buf_list, ocb_list)
+	list_for_each_entry(ocb, &oal->oal_circ_buf_list, ocb_list) {
+		smp_store_release(&ocb->ocb_ring->lalr_is_closed, 1);
 		wake_up(&ocb->ocb_read_wait_queue);
+	}
 	up_read(&oal->oal_buf_list_sem);
 	cdev_device_del(&oal->oal_cdev, &oal->oal_device);
 	put_device(&oal->oal_device);
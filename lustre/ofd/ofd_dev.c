@@ -1230,6 +1230,74 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Set the attributes of the objects of a multi-object OST_SETATTR RPC.
+ *
+ * The objects are changed one after the other, and the result of each one
+ * is returned in the RMF_RCS reply buffer. Only the ownership and layout
+ * version changes from the OSP sync thread are accepted.
+ *
+ * \param[in] tsi	target session environment for this request
+ * \param[in] oa	objects and their new attributes
+ * \param[in] count	number of objects in \a oa
+ *
+ * \retval		0 if the results are packed in the reply
+ * \retval		negative value on error
+ */
+static int ofd_setattr_batch(struct tgt_session_info *tsi, struct obdo *oa,
+			     int count)
+{
+	struct ofd_thread_info	*fti = tsi2ofd_info(tsi);
+	struct ofd_device	*ofd = ofd_exp(tsi->tsi_exp);
+	struct ldlm_resource	*res;
+	struct ofd_object	*fo;
+	__u32			*rcs;
+	int			 rc;
+	int			 i;
+
+	ENTRY;
+
+	rcs = req_capsule_server_get(tsi->tsi_pill, &RMF_RCS);
+	if (rcs == NULL)
+		RETURN(-EPROTO);
+
+	for (i = 0; i < count; i++) {
+		if (oa[i].o_valid & ~(OBD_MD_FLID | OBD_MD_FLGROUP |
+				      OBD_MD_FLUID | OBD_MD_FLGID |
+				      OBD_MD_FLPROJID |
+				      OBD_MD_LAYOUT_VERSION)) {
+			rcs[i] = -EPROTO;
+			continue;
+		}
+
+		fo = ofd_object_find_exists(tsi->tsi_env, ofd,
+					    &oa[i].o_oi.oi_fid);
+		if (IS_ERR(fo)) {
+			rcs[i] = PTR_ERR(fo);
+			continue;
+		}
+
+		la_from_obdo(&fti->fti_attr, &oa[i], oa[i].o_valid);
+		fti->fti_attr.la_valid &= ~LA_TYPE;
+		rc = ofd_attr_set(tsi->tsi_env, fo, &fti->fti_attr, &oa[i]);
+		ofd_object_put(tsi->tsi_env, fo);
+		rcs[i] = rc;
+		if (rc != 0)
+			continue;
+
+		/* see ofd_setattr_hdl() for the LVB update after the put */
+		ost_fid_build_resid(&oa[i].o_oi.oi_fid, &fti->fti_resid);
+		res = ldlm_resource_get(ofd->ofd_namespace, &fti->fti_resid,
+					LDLM_EXTENT, 0);
+		if (!IS_ERR(res)) {
+			ldlm_res_lvbo_update(res, NULL, 0);
+			ldlm_resource_putref(res);
+		}
+	}
+
+	RETURN(0);
+}
+
 /**
  * OFD request handler for OST_SETATTR RPC.
  *
@@ -1249,7 +1317,9 @@ static int ofd_setattr_hdl(struct tgt_session_info *tsi)
 	struct ost_body		*repbody;
 	struct ldlm_resource	*res;
 	struct ofd_object	*fo;
+	struct obdo		*oa;
 	ktime_t			 kstart = ktime_get();
+	int			 count;
 	int			 rc = 0;
 
 	ENTRY;
@@ -1263,6 +1333,17 @@ static int ofd_setattr_hdl(struct tgt_session_info *tsi)
 	repbody->oa.o_oi = body->oa.o_oi;
 	repbody->oa.o_valid = OBD_MD_FLID | OBD_MD_FLGROUP;
 
+	oa = tgt_obdo_array_unpack(tsi, &count);
+	if (IS_ERR(oa))
+		RETURN(PTR_ERR(oa));
+	if (oa != NULL) {
+		rc = ofd_setattr_batch(tsi, oa, count);
+		ofd_counter_incr(tsi->tsi_exp, LPROC_OFD_STATS_SETATTR,
+				 tsi->tsi_jobid,
+				 ktime_us_delta(ktime_get(), kstart));
+		RETURN(rc);
+	}
+
 	/* This would be very bad - accidentally truncating a file when
 	 * changing the time or similar - bug 12203. */
 	if (body->oa.o_valid & OBD_MD_FLSIZE &&
@@ -1712,8 +1793,10 @@ static int ofd_destroy_hdl(struct tgt_session_info *tsi)
 	struct ofd_thread_info	*fti = tsi2ofd_info(tsi);
 	struct lu_fid		*fid = &fti->fti_fid;
 	ktime_t			 kstart = ktime_get();
+	struct obdo		*oa;
 	u64			 oid;
 	u32			 count;
+	int			 nr;
 	int			 rc = 0;
 
 	ENTRY;
@@ -1721,6 +1804,10 @@ static int ofd_destroy_hdl(struct tgt_session_info *tsi)
 	if (CFS_FAIL_CHECK(OBD_FAIL_OST_EROFS))
 		RETURN(-EROFS);
 
+	oa = tgt_obdo_array_unpack(tsi, &nr);
+	if (IS_ERR(oa))
+		RETURN(PTR_ERR(oa));
+
 	/* This is old case for clients before Lustre 2.4 */
 	/* If there's a DLM request, cancel the locks mentioned in it */
 	if (req_capsule_field_present(tsi->tsi_pill, &RMF_DLM_REQ,
@@ -1739,6 +1826,22 @@ static int ofd_destroy_hdl(struct tgt_session_info *tsi)
 
 	repbody = req_capsule_server_get(tsi->tsi_pill, &RMF_OST_BODY);
 
+	/* several objects from the OSP sync thread, one result for each */
+	if (oa != NULL) {
+		__u32 *rcs = req_capsule_server_get(tsi->tsi_pill, &RMF_RCS);
+
+		if (rcs == NULL)
+			RETURN(-EPROTO);
+
+		CDEBUG(D_HA, "%s: Destroy %d objects from "DOSTID"\n",
+		       ofd_name(ofd), nr, POSTID(&oa[0].o_oi));
+		ofd_destroy_by_fids(tsi->tsi_env, ofd, oa, nr, rcs);
+		ofd_counter_incr(tsi->tsi_exp, LPROC_OFD_STATS_DESTROY,
+				 tsi->tsi_jobid,
+				 ktime_us_delta(ktime_get(), kstart));
+		GOTO(out, rc = 0);
+	}
+
 	/* check that o_misc makes sense */
 	if (body->oa.o_valid & OBD_MD_FLOBJCOUNT)
 		count = body->oa.o_misc;
@@ -28,6 +28,10 @@
 #define OFD_PRECREATE_SMALL_FS		(1024ULL * 1024 * 1024)
 #define OFD_PRECREATE_BATCH_SMALL	8
 
+/* objects destroyed in one transaction by a multi-object OST_DESTROY,
+ * kept low enough for the credits to fit in a small journal */
+#define OFD_DESTROY_BATCH		16
+
 /* Limit the returned fields marked valid to those that we actually might set */
 #define OFD_VALID_FLAGS (LA_TYPE | LA_MODE | LA_SIZE | LA_BLOCKS | \
 			 LA_BLKSIZE | LA_ATIME | LA_MTIME | LA_CTIME)
@@ -302,6 +306,8 @@ int ofd_fiemap_get(const struct lu_env *env, struct ofd_device *ofd,
 extern const struct obd_ops ofd_obd_ops;
 int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 		       const struct lu_fid *fid, int orphan);
+void ofd_destroy_by_fids(const struct lu_env *env, struct ofd_device *ofd,
+			 const struct obdo *oa, int count, __u32 *rcs);
 int ofd_statfs(const struct lu_env *env,  struct obd_export *exp,
 	       struct obd_statfs *osfs, time64_t max_age, __u32 flags);
 int ofd_obd_disconnect(struct obd_export *exp);
@@ -389,6 +395,8 @@ int ofd_object_fallocate(const struct lu_env *env, struct ofd_object *fo,
 			 __u64 start, __u64 end, int mode, struct lu_attr *la,
 			 struct obdo *oa);
 int ofd_destroy(const struct lu_env *, struct ofd_object *, int);
+int ofd_destroy_batch(const struct lu_env *env, struct ofd_device *ofd,
+		      struct ofd_object **fos, int count, __u32 *rcs);
 int ofd_attr_get(const struct lu_env *env, struct ofd_object *fo,
 		 struct lu_attr *la);
 int ofd_attr_handle_id(const struct lu_env *env, struct ofd_object *fo,
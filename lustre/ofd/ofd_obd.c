@@ -255,6 +255,9 @@ static int ofd_parse_connect_data(const struct lu_env *env,
 	if (!ofd->ofd_lut.lut_dt_conf.ddp_has_lseek_data_hole)
 		data->ocd_connect_flags2 &= ~OBD_CONNECT2_LSEEK;
 
+	if (!ofd->ofd_lut.lut_dt_conf.ddp_has_compression)
+		data->ocd_connect_flags2 &= ~OBD_CONNECT2_COMPRESS;
+
 	RETURN(0);
 }
 
@@ -878,40 +881,29 @@ out:
 }
 
 /**
- * Destroy OFD object by its FID.
+ * Discard the cached data of an object to be destroyed.
  *
- * Supplemental function to destroy object by FID, it is used by request
- * handler and by ofd_echo_destroy() below to find object by FID, lock it
- * and call ofd_destroy() finally.
+ * Tell the clients that the object is gone now and that they should
+ * throw away any cached pages.
  *
  * \param[in] env	execution environment
  * \param[in] ofd	OFD device
  * \param[in] fid	FID of object
- * \param[in] orphan	set if object being destroyed is an orphan
  *
  * \retval		0 if successful
- * \retval		negative value on error
+ * \retval		-EIO if the object is still locked
+ * \retval		negative value on other error
  */
-int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
-		       const struct lu_fid *fid, int orphan)
+static int ofd_destroy_discard(const struct lu_env *env,
+			       struct ofd_device *ofd,
+			       const struct lu_fid *fid)
 {
 	struct ofd_thread_info *info = ofd_info(env);
 	struct lustre_handle lockh;
 	union ldlm_policy_data policy = { .l_extent = { 0, OBD_OBJECT_EOF } };
-	struct ofd_object *fo;
 	__u64 flags = LDLM_FL_AST_DISCARD_DATA | LDLM_FL_BLOCK_NOWAIT;
-	__u64 rc = 0;
-
-	ENTRY;
-
-	fo = ofd_object_find_exists(env, ofd, fid);
-	if (IS_ERR(fo))
-		RETURN(PTR_ERR(fo));
+	int rc;
 
-	/*
-	 * Tell the clients that the object is gone now and that they should
-	 * throw away any cached pages.
-	 */
 	ost_fid_build_resid(fid, &info->fti_resid);
 	rc = ldlm_cli_enqueue_local(env, ofd->ofd_namespace, &info->fti_resid,
 				    LDLM_EXTENT, &policy, LCK_PW, &flags,
@@ -921,20 +913,104 @@ int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 	/* We only care about the side-effects, just drop the lock. */
 	if (rc == ELDLM_OK) {
 		ldlm_lock_decref(&lockh, LCK_PW);
-
-		LASSERT(fo != NULL);
-
-		rc = ofd_destroy(env, fo, orphan);
-		EXIT;
 	} else if (rc == -EAGAIN) {
 		CDEBUG(D_HA, "%s: Object "DFID" is locked, skiping destroy\n",
 		       ofd->ofd_osd_exp->exp_obd->obd_name, PFID(fid));
 		rc = -EIO;
 	}
+
+	return rc;
+}
+
+/**
+ * Destroy OFD object by its FID.
+ *
+ * Supplemental function to destroy object by FID, it is used by request
+ * handler and by ofd_echo_destroy() below to find object by FID, lock it
+ * and call ofd_destroy() finally.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fid	FID of object
+ * \param[in] orphan	set if object being destroyed is an orphan
+ *
+ * \retval		0 if successful
+ * \retval		negative value on error
+ */
+int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
+		       const struct lu_fid *fid, int orphan)
+{
+	struct ofd_object *fo;
+	int rc;
+
+	ENTRY;
+
+	fo = ofd_object_find_exists(env, ofd, fid);
+	if (IS_ERR(fo))
+		RETURN(PTR_ERR(fo));
+
+	rc = ofd_destroy_discard(env, ofd, fid);
+	if (rc == 0)
+		rc = ofd_destroy(env, fo, orphan);
+
 	ofd_object_put(env, fo);
 	RETURN(rc);
 }
 
+/**
+ * Destroy the objects of a multi-object OST_DESTROY RPC.
+ *
+ * The objects are found and their cached data discarded like in
+ * ofd_destroy_by_fid(), then they are destroyed OFD_DESTROY_BATCH at a
+ * time by ofd_destroy_batch().
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] oa	objects to destroy
+ * \param[in] count	number of objects in \a oa
+ * \param[out] rcs	result of each object
+ */
+void ofd_destroy_by_fids(const struct lu_env *env, struct ofd_device *ofd,
+			 const struct obdo *oa, int count, __u32 *rcs)
+{
+	struct ofd_object *fos[OFD_DESTROY_BATCH];
+	int nr;
+	int i;
+	int j;
+
+	ENTRY;
+
+	for (i = 0; i < count; i += nr) {
+		nr = min(count - i, OFD_DESTROY_BATCH);
+
+		for (j = 0; j < nr; j++) {
+			const struct lu_fid *fid = &oa[i + j].o_oi.oi_fid;
+
+			fos[j] = ofd_object_find_exists(env, ofd, fid);
+			if (IS_ERR(fos[j])) {
+				rcs[i + j] = PTR_ERR(fos[j]);
+				fos[j] = NULL;
+				continue;
+			}
+			rcs[i + j] = ofd_destroy_discard(env, ofd, fid);
+		}
+
+		ofd_destroy_batch(env, ofd, fos, nr, rcs + i);
+
+		for (j = 0; j < nr; j++) {
+			if (fos[j] != NULL)
+				ofd_object_put(env, fos[j]);
+			if (rcs[i + j] != 0 && (int)rcs[i + j] != -ENOENT)
+				CERROR("%s: error destroying object "DFID": rc = %d\n",
+				       ofd_name(ofd),
+				       PFID(&oa[i + j].o_oi.oi_fid),
+				       (int)rcs[i + j]);
+		}
+	}
+
+	EXIT;
+}
+
 /**
  * Implementation of obd_ops::o_destroy.
  *
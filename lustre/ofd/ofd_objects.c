@@ -1072,6 +1072,97 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Destroy several OFD objects in one transaction.
+ *
+ * This is ofd_destroy() for the objects of a multi-object OST_DESTROY RPC,
+ * so that the journal and last_rcvd are updated once for all of them. The
+ * objects with a non-zero \a rcs are skipped, those destroyed meanwhile get
+ * -ENOENT.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fos	OFD objects
+ * \param[in] count	number of objects in \a fos
+ * \param[in,out] rcs	result of each object
+ *
+ * \retval		0 if successful
+ * \retval		negative value if the transaction failed, set in
+ *			\a rcs for the objects not destroyed yet
+ */
+int ofd_destroy_batch(const struct lu_env *env, struct ofd_device *ofd,
+		      struct ofd_object **fos, int count, __u32 *rcs)
+{
+	struct thandle *th;
+	int rc = 0;
+	int rc2;
+	int i;
+
+	ENTRY;
+
+	for (i = 0; i < count; i++) {
+		if (rcs[i] == 0 && !ofd_object_exists(fos[i]))
+			rcs[i] = -ENOENT;
+		if (rcs[i] == 0)
+			break;
+	}
+	if (i == count)
+		RETURN(0);
+
+	th = ofd_trans_create(env, ofd);
+	if (IS_ERR(th))
+		GOTO(out, rc = PTR_ERR(th));
+
+	for (; i < count; i++) {
+		if (rcs[i] != 0)
+			continue;
+
+		rc = dt_declare_ref_del(env, ofd_object_child(fos[i]), th);
+		if (rc < 0)
+			GOTO(stop, rc);
+
+		rc = dt_declare_destroy(env, ofd_object_child(fos[i]), th);
+		if (rc < 0)
+			GOTO(stop, rc);
+	}
+
+	rc = ofd_trans_start(env, ofd, NULL, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	for (i = 0; i < count; i++) {
+		struct ofd_object *fo = fos[i];
+
+		if (rcs[i] != 0)
+			continue;
+
+		ofd_write_lock(env, fo);
+		if (ofd_object_exists(fo)) {
+			tgt_fmd_drop(ofd_info(env)->fti_exp,
+				     &fo->ofo_header.loh_fid);
+			dt_ref_del(env, ofd_object_child(fo), th);
+			dt_destroy(env, ofd_object_child(fo), th);
+		} else {
+			rcs[i] = -ENOENT;
+		}
+		ofd_write_unlock(env, fo);
+	}
+stop:
+	rc2 = ofd_trans_stop(env, ofd, th, rc);
+	if (rc2)
+		CERROR("%s failed to stop transaction: %d\n",
+		       ofd_name(ofd), rc2);
+	if (!rc)
+		rc = rc2;
+out:
+	if (rc) {
+		for (i = 0; i < count; i++)
+			if (rcs[i] == 0)
+				rcs[i] = rc;
+	}
+	RETURN(rc);
+}
+
 /**
  * Get OFD object attributes.
  *
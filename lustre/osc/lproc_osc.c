@@ -806,6 +806,29 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_writes);
 	seq_printf(seq, "lockless_read_bytes\t\t%llu\n",
 		   stats->os_lockless_reads);
+	seq_printf(seq, "compress_chunks\t\t\t%llu\n",
+		   stats->os_compr_chunks);
+	seq_printf(seq, "compress_skipped_chunks\t\t%llu\n",
+		   stats->os_compr_skipped);
+	seq_printf(seq, "compress_bytes_in\t\t%llu\n",
+		   stats->os_compr_bytes_in);
+	seq_printf(seq, "compress_bytes_out\t\t%llu\n",
+		   stats->os_compr_bytes_out);
+	if (stats->os_compr_bytes_out) {
+		u64 ratio = div64_u64(stats->os_compr_bytes_in * 100,
+				      stats->os_compr_bytes_out);
+
+		seq_printf(seq, "compress_ratio\t\t\t%llu.%02llu\n",
+			   ratio / 100, ratio % 100);
+	}
+	seq_printf(seq, "compress_time_us\t\t%llu\n",
+		   stats->os_compr_time / NSEC_PER_USEC);
+	seq_printf(seq, "decompress_chunks\t\t%llu\n",
+		   stats->os_decompr_chunks);
+	seq_printf(seq, "decompress_bytes\t\t%llu\n",
+		   stats->os_decompr_bytes);
+	seq_printf(seq, "decompress_time_us\t\t%llu\n",
+		   stats->os_decompr_time / NSEC_PER_USEC);
 	return 0;
 }
 
@@ -2037,6 +2037,12 @@ static unsigned int get_read_extents(struct osc_object *obj,
 		.erd_max_extents = UINT_MAX,
 	};
 
+	/* chunks of compressed objects are read whole, which is only
+	 * limited for the pages of one extent by osc_io_submit()
+	 */
+	if (osc_compr_chunk_bits(obj))
+		data.erd_max_extents = 1;
+
 	assert_osc_object_is_locked(obj);
 	while ((ext = list_first_entry_or_null(&obj->oo_hp_read_exts,
 					       struct osc_extent,
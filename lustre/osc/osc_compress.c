@@ -0,0 +1,512 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Compression of BRW RPCs to objects of LCME_FL_COMPRESS components.
+ *
+ * On write, each run of pages holding a whole chunk is compressed and sent
+ * as the fewer pages holding the compressed chunk. On read, every chunk
+ * touched by the RPC is read whole, so that compressed chunks can be
+ * decompressed into the pages asked for.
+ *
+ * This runs in osc_brw_prep_request() and brw_interpret(), so the RPCs
+ * of a file are compressed in parallel by the ptlrpcd threads.
+ */
+
+#define DEBUG_SUBSYSTEM S_OSC
+
+#include <obd_class.h>
+#include <lustre_osc.h>
+#include <lustre_compr.h>
+
+#include "osc_internal.h"
+
+struct osc_compr_args {
+	/* pages from osc_build_rpc(), given back when the RPC is done */
+	struct brw_page		**oca_ppga;
+	u32			  oca_page_count;
+	/* pages sent on the wire instead */
+	struct brw_page		**oca_wire_ppga;
+	u32			  oca_wire_count;
+	u32			  oca_wire_max;
+	/* wire pages which are not pages of osc_build_rpc() */
+	struct brw_page		 *oca_wire_pages;
+	/* READ: pool pages the chunks are read into */
+	struct page		**oca_pool_pages;
+	u32			  oca_nr_pool_pages;
+	/* WRITE: pool buffers holding the compressed chunks */
+	void			**oca_bufs;
+	u32			  oca_nr_bufs;
+	struct osc_object	 *oca_obj;
+	unsigned int		  oca_chunk_bits;
+};
+
+static struct osc_stats *osc_compr_stats(struct client_obd *cli)
+{
+	return &obd2osc_dev(cli->cl_import->imp_obd)->osc_stats;
+}
+
+void osc_compr_free(struct osc_compr_args *oca)
+{
+	u32 i;
+
+	if (!oca)
+		return;
+
+	for (i = 0; i < oca->oca_nr_bufs; i++)
+		obd_pool_put_objects(oca->oca_bufs[i],
+				     oca->oca_chunk_bits - PAGE_SHIFT);
+	if (oca->oca_bufs)
+		OBD_FREE_PTR_ARRAY_LARGE(oca->oca_bufs, oca->oca_page_count);
+	if (oca->oca_nr_pool_pages)
+		obd_pool_put_pages_array(oca->oca_pool_pages,
+					 oca->oca_nr_pool_pages);
+	if (oca->oca_pool_pages)
+		OBD_FREE_PTR_ARRAY_LARGE(oca->oca_pool_pages,
+					 oca->oca_wire_max);
+	if (oca->oca_wire_pages)
+		OBD_FREE_PTR_ARRAY_LARGE(oca->oca_wire_pages,
+					 oca->oca_wire_max);
+	if (oca->oca_wire_ppga)
+		OBD_FREE_PTR_ARRAY_LARGE(oca->oca_wire_ppga,
+					 oca->oca_wire_max);
+	OBD_FREE_PTR(oca);
+}
+
+static int osc_compr_wire_alloc(struct osc_compr_args *oca, u32 count)
+{
+	oca->oca_wire_max = count;
+	OBD_ALLOC_PTR_ARRAY_LARGE(oca->oca_wire_ppga, count);
+	OBD_ALLOC_PTR_ARRAY_LARGE(oca->oca_wire_pages, count);
+	if (!oca->oca_wire_ppga || !oca->oca_wire_pages)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/*
+ * Number of pages from @i which hold one whole chunk, 0 if these pages cannot
+ * be compressed. Partial chunks are stored plain, so that the data of a chunk
+ * never has to be merged with its compressed data on the OST.
+ */
+static u32 osc_compr_run(struct brw_page **pga, u32 i, u32 count,
+			 unsigned int chunk_bits)
+{
+	u32 ppc = 1U << (chunk_bits - PAGE_SHIFT);
+	u64 start = pga[i]->bp_off;
+	u32 n = 1;
+
+	if (start & ((1ULL << chunk_bits) - 1))
+		return 0;
+
+	while (n < ppc && i + n < count &&
+	       pga[i + n - 1]->bp_count == PAGE_SIZE &&
+	       pga[i + n]->bp_off == start + ((u64)n << PAGE_SHIFT) &&
+	       pga[i + n]->bp_flag == pga[i]->bp_flag)
+		n++;
+
+	if (n < ppc || pga[i + n - 1]->bp_count != PAGE_SIZE)
+		return 0;
+
+	return n;
+}
+
+static int osc_compr_prep_write(struct client_obd *cli,
+				struct osc_compr_args *oca, struct obdo *oa)
+{
+	struct osc_stats *stats = osc_compr_stats(cli);
+	struct lov_oinfo *loi = oca->oca_obj->oo_oinfo;
+	unsigned int chunk_bits = oca->oca_chunk_bits;
+	unsigned int order = chunk_bits - PAGE_SHIFT;
+	struct brw_page **pga = oca->oca_ppga;
+	struct osc_async_page *oap;
+	struct crypto_comp *cc = NULL;
+	u32 nr_pages = 0;
+	void *src = NULL;
+	u32 i = 0;
+	int rc;
+
+	rc = osc_compr_wire_alloc(oca, oca->oca_page_count);
+	if (rc)
+		return rc;
+	OBD_ALLOC_PTR_ARRAY_LARGE(oca->oca_bufs, oca->oca_page_count);
+	if (!oca->oca_bufs)
+		return -ENOMEM;
+
+	while (i < oca->oca_page_count) {
+		u32 n = osc_compr_run(pga, i, oca->oca_page_count,
+				      chunk_bits);
+		unsigned int src_len = 0;
+		unsigned int dst_len;
+		ktime_t kstart;
+		void *dst;
+		u32 j;
+
+		if (n == 0) {
+			oca->oca_wire_ppga[oca->oca_wire_count++] = pga[i++];
+			continue;
+		}
+
+		if (!cc) {
+			rc = ll_compr_get(loi->loi_compr_type, &cc);
+			if (rc)
+				break;
+		}
+		if (!src) {
+			rc = obd_pool_get_objects(&src, order);
+			if (rc)
+				break;
+		}
+		rc = obd_pool_get_objects(&dst, order);
+		if (rc)
+			break;
+
+		for (j = i; j < i + n; j++) {
+			void *kaddr = kmap_atomic(pga[j]->bp_page);
+
+			memcpy(src + src_len, kaddr, pga[j]->bp_count);
+			kunmap_atomic(kaddr);
+			src_len += pga[j]->bp_count;
+		}
+
+		kstart = ktime_get();
+		dst_len = 1U << chunk_bits;
+		rc = ll_compress_chunk(cc, src, src_len, dst, &dst_len,
+				       loi->loi_compr_type,
+				       chunk_bits - COMPR_CHUNK_MIN_BITS);
+		stats->os_compr_time += ktime_to_ns(ktime_sub(ktime_get(),
+							      kstart));
+		if (rc) {
+			obd_pool_put_objects(dst, order);
+			if (rc != -E2BIG)
+				break;
+
+			/* incompressible, store the chunk as it is */
+			stats->os_compr_skipped++;
+			for (j = i; j < i + n; j++)
+				oca->oca_wire_ppga[oca->oca_wire_count++] =
+					pga[j];
+			i += n;
+			rc = 0;
+			continue;
+		}
+
+		oca->oca_bufs[oca->oca_nr_bufs++] = dst;
+		memset(dst + dst_len, 0,
+		       round_up(dst_len, PAGE_SIZE) - dst_len);
+		for (j = 0; j * PAGE_SIZE < dst_len; j++) {
+			struct brw_page *bp = &oca->oca_wire_pages[nr_pages++];
+
+			bp->bp_off = pga[i]->bp_off + ((u64)j << PAGE_SHIFT);
+			bp->bp_page = ll_compr_buf_page(dst, j << PAGE_SHIFT);
+			bp->bp_count = PAGE_SIZE;
+			bp->bp_flag = pga[i]->bp_flag | OBD_BRW_COMPRESSED;
+			oca->oca_wire_ppga[oca->oca_wire_count++] = bp;
+		}
+
+		stats->os_compr_chunks++;
+		stats->os_compr_bytes_in += src_len;
+		stats->os_compr_bytes_out += j << PAGE_SHIFT;
+		i += n;
+	}
+
+	if (src)
+		obd_pool_put_objects(src, order);
+	ll_compr_put(loi->loi_compr_type, cc);
+
+	if (rc)
+		return rc;
+	if (!oca->oca_nr_bufs)
+		return -ENODATA;
+
+	/* the last compressed chunk may end before the data it holds, so
+	 * tell the OST the object size for this write
+	 */
+	oap = brw_page2oap(pga[oca->oca_page_count - 1]);
+	oa->o_size = oap->oap_count + oap->oap_obj_off + oap->oap_page_off;
+
+	return 0;
+}
+
+static int osc_compr_prep_read(struct client_obd *cli,
+			       struct osc_compr_args *oca)
+{
+	unsigned int chunk_bits = oca->oca_chunk_bits;
+	u32 ppc = 1U << (chunk_bits - PAGE_SHIFT);
+	struct brw_page **pga = oca->oca_ppga;
+	u64 chunk = U64_MAX;
+	u32 nr_chunks = 0;
+	u32 i, j;
+	int rc;
+
+	for (i = 0; i < oca->oca_page_count; i++) {
+		if (pga[i]->bp_off >> chunk_bits != chunk) {
+			chunk = pga[i]->bp_off >> chunk_bits;
+			nr_chunks++;
+		}
+	}
+
+	/* osc_io_submit() limits the chunks of one read RPC */
+	if (nr_chunks * ppc > cli->cl_max_pages_per_rpc) {
+		CERROR("%s: object "DOSTID": %u chunks of %u pages over max_pages_per_rpc=%u: rc = %d\n",
+		       cli_name(cli), POSTID(&oca->oca_obj->oo_oinfo->loi_oi),
+		       nr_chunks, ppc, cli->cl_max_pages_per_rpc, -EFBIG);
+		return -EFBIG;
+	}
+
+	rc = osc_compr_wire_alloc(oca, nr_chunks * ppc);
+	if (rc)
+		return rc;
+	OBD_ALLOC_PTR_ARRAY_LARGE(oca->oca_pool_pages, oca->oca_wire_max);
+	if (!oca->oca_pool_pages)
+		return -ENOMEM;
+	rc = obd_pool_get_pages_array(oca->oca_pool_pages, oca->oca_wire_max);
+	if (rc)
+		return rc;
+	oca->oca_nr_pool_pages = oca->oca_wire_max;
+
+	chunk = U64_MAX;
+	for (i = 0; i < oca->oca_page_count; i++) {
+		if (pga[i]->bp_off >> chunk_bits == chunk)
+			continue;
+
+		chunk = pga[i]->bp_off >> chunk_bits;
+		for (j = 0; j < ppc; j++) {
+			u32 k = oca->oca_wire_count++;
+			struct brw_page *bp = &oca->oca_wire_pages[k];
+
+			bp->bp_off = (chunk << chunk_bits) +
+				     ((u64)j << PAGE_SHIFT);
+			bp->bp_page = oca->oca_pool_pages[k];
+			bp->bp_count = PAGE_SIZE;
+			bp->bp_flag = pga[i]->bp_flag;
+			oca->oca_wire_ppga[k] = bp;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Replace the pages of a BRW RPC by the pages to send for compression.
+ *
+ * \param[in] cli		client obd of the RPC
+ * \param[in] opc		OST_READ or OST_WRITE
+ * \param[in] oa		obdo of the RPC
+ * \param[in,out] page_count	number of pages of the RPC
+ * \param[in,out] pga		pages of the RPC, sorted by offset
+ * \param[out] compr		state for osc_compr_fini(), NULL if unchanged
+ *
+ * \retval 0			on success, a write is sent uncompressed if
+ *				it cannot be compressed
+ * \retval negative		errno if a read cannot be done
+ */
+int osc_compr_prep(struct client_obd *cli, int opc, struct obdo *oa,
+		   u32 *page_count, struct brw_page ***pga,
+		   struct osc_compr_args **compr)
+{
+	struct osc_object *obj = brw_page2oap((*pga)[0])->oap_obj;
+	unsigned int chunk_bits = osc_compr_chunk_bits(obj);
+	struct osc_compr_args *oca;
+	int rc;
+
+	*compr = NULL;
+	if (!chunk_bits)
+		return 0;
+
+	OBD_ALLOC_PTR(oca);
+	if (!oca)
+		return opc == OST_WRITE ? 0 : -ENOMEM;
+
+	oca->oca_obj = obj;
+	oca->oca_chunk_bits = chunk_bits;
+	oca->oca_ppga = *pga;
+	oca->oca_page_count = *page_count;
+
+	if (opc == OST_WRITE)
+		rc = osc_compr_prep_write(cli, oca, oa);
+	else
+		rc = osc_compr_prep_read(cli, oca);
+	if (rc) {
+		if (rc != -ENODATA)
+			CDEBUG(D_CACHE, "%s: object "DOSTID": no compression for %s of %u pages: rc = %d\n",
+			       cli_name(cli), POSTID(&obj->oo_oinfo->loi_oi),
+			       opc == OST_WRITE ? "write" : "read",
+			       *page_count, rc);
+		osc_compr_free(oca);
+		return opc == OST_WRITE ? 0 : rc;
+	}
+
+	*pga = oca->oca_wire_ppga;
+	*page_count = oca->oca_wire_count;
+	*compr = oca;
+
+	return 0;
+}
+
+/* decompress the chunk read into @pages, returns uncompressed bytes */
+static int osc_compr_decompress(struct client_obd *cli,
+				struct osc_compr_args *oca,
+				struct page **pages, void *src, void *dst,
+				struct crypto_comp **cc,
+				enum ll_compr_type *cc_type)
+{
+	struct osc_stats *stats = osc_compr_stats(cli);
+	unsigned int chunk_size = 1U << oca->oca_chunk_bits;
+	struct ll_compr_hdr *llch;
+	unsigned int len;
+	ktime_t kstart;
+	u32 i;
+	int rc;
+
+	llch = kmap_atomic(pages[0]);
+	len = sizeof(*llch) + le32_to_cpu(llch->llch_compr_size);
+	if (*cc_type != llch->llch_compr_type) {
+		ll_compr_put(*cc_type, *cc);
+		*cc = NULL;
+		*cc_type = llch->llch_compr_type;
+	}
+	kunmap_atomic(llch);
+
+	if (!*cc) {
+		rc = ll_compr_get(*cc_type, cc);
+		if (rc)
+			return rc;
+	}
+
+	for (i = 0; i * PAGE_SIZE < len; i++) {
+		void *kaddr = kmap_atomic(pages[i]);
+
+		memcpy(src + i * PAGE_SIZE, kaddr, PAGE_SIZE);
+		kunmap_atomic(kaddr);
+	}
+
+	kstart = ktime_get();
+	len = chunk_size;
+	rc = ll_decompress_chunk(*cc, src, dst, &len);
+	stats->os_decompr_time += ktime_to_ns(ktime_sub(ktime_get(), kstart));
+	if (rc)
+		return rc;
+
+	stats->os_decompr_chunks++;
+	stats->os_decompr_bytes += len;
+
+	return len;
+}
+
+static int osc_compr_fini_read(struct client_obd *cli,
+			       struct osc_compr_args *oca)
+{
+	unsigned int chunk_bits = oca->oca_chunk_bits;
+	unsigned int order = chunk_bits - PAGE_SHIFT;
+	enum ll_compr_type cc_type = LL_COMPR_TYPE_NONE;
+	u32 ppc = 1U << order;
+	struct brw_page **pga = oca->oca_ppga;
+	struct crypto_comp *cc = NULL;
+	void *src = NULL;
+	void *dst = NULL;
+	u32 i = 0;
+	u32 c;
+	int rc = 0;
+
+	for (c = 0; c < oca->oca_wire_count; c += ppc) {
+		struct page **pages = &oca->oca_pool_pages[c];
+		u64 chunk_start = oca->oca_wire_ppga[c]->bp_off;
+		struct ll_compr_hdr *llch;
+		bool compressed;
+		int len = 0;
+
+		llch = kmap_atomic(pages[0]);
+		compressed = ll_compr_hdr_valid(llch, 1U << chunk_bits);
+		kunmap_atomic(llch);
+
+		if (compressed) {
+			if (!src) {
+				rc = obd_pool_get_objects(&src, order);
+				if (rc)
+					break;
+			}
+			if (!dst) {
+				rc = obd_pool_get_objects(&dst, order);
+				if (rc)
+					break;
+			}
+			len = osc_compr_decompress(cli, oca, pages, src, dst,
+						   &cc, &cc_type);
+			if (len < 0) {
+				rc = -EIO;
+				CERROR("%s: object "DOSTID": cannot decompress chunk at %llu: rc = %d\n",
+				       cli_name(cli),
+				       POSTID(&oca->oca_obj->oo_oinfo->loi_oi),
+				       chunk_start, len);
+				break;
+			}
+		}
+
+		/* copy the data of this chunk to the pages asked for */
+		for (; i < oca->oca_page_count &&
+		     pga[i]->bp_off >> chunk_bits == chunk_start >> chunk_bits;
+		     i++) {
+			struct brw_page *pg = pga[i];
+			unsigned int off = pg->bp_off - chunk_start;
+			char *kaddr = kmap_atomic(pg->bp_page);
+			char *to = kaddr + (pg->bp_off & ~PAGE_MASK);
+
+			if (compressed) {
+				unsigned int count = 0;
+
+				/* zeroes after the end of the data */
+				if (off < len)
+					count = min_t(unsigned int, len - off,
+						      pg->bp_count);
+				memcpy(to, dst + off, count);
+				memset(to + count, 0, pg->bp_count - count);
+			} else {
+				char *from = kmap_atomic(pages[off >>
+							       PAGE_SHIFT]);
+
+				memcpy(to, from + (off & ~PAGE_MASK),
+				       pg->bp_count);
+				kunmap_atomic(from);
+			}
+			kunmap_atomic(kaddr);
+		}
+	}
+
+	if (src)
+		obd_pool_put_objects(src, order);
+	if (dst)
+		obd_pool_put_objects(dst, order);
+	ll_compr_put(cc_type, cc);
+
+	return rc;
+}
+
+/**
+ * Give the pages of osc_build_rpc() back to the async args of a BRW RPC
+ * prepared by osc_compr_prep(), after decompressing the data read.
+ *
+ * \retval	@rc, or negative errno if the data read cannot be decompressed
+ */
+int osc_compr_fini(struct osc_brw_async_args *aa, int opc, int rc)
+{
+	struct osc_compr_args *oca = aa->aa_compr;
+
+	if (!oca)
+		return rc;
+
+	if (rc >= 0 && opc == OST_READ) {
+		int rc2 = osc_compr_fini_read(aa->aa_cli, oca);
+
+		if (rc2)
+			rc = rc2;
+	}
+
+	aa->aa_ppga = oca->oca_ppga;
+	aa->aa_page_count = oca->oca_page_count;
+	aa->aa_compr = NULL;
+	osc_compr_free(oca);
+
+	return rc;
+}
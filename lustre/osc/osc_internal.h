@@ -141,6 +141,25 @@ int osc_quota_setdq(struct client_obd *cli, __u64 xid, const unsigned int qid[],
 int osc_quota_chkdq(struct client_obd *cli, const unsigned int qid[]);
 int osc_quotactl(struct obd_device *unused, struct obd_export *exp,
                  struct obd_quotactl *oqctl);
+
+int osc_compr_prep(struct client_obd *cli, int opc, struct obdo *oa,
+		   u32 *page_count, struct brw_page ***pga,
+		   struct osc_compr_args **compr);
+int osc_compr_fini(struct osc_brw_async_args *aa, int opc, int rc);
+void osc_compr_free(struct osc_compr_args *oca);
+
+/* log2 of the compression chunk size of @obj, 0 if it is not compressed */
+static inline unsigned int osc_compr_chunk_bits(struct osc_object *obj)
+{
+	struct lov_oinfo *loi = obj->oo_oinfo;
+
+	if (loi->loi_compr_type == LL_COMPR_TYPE_NONE ||
+	    !imp_connect_compress(osc_cli(obj)->cl_import))
+		return 0;
+
+	return loi->loi_compr_chunk_bits;
+}
+
 void osc_inc_unstable_pages(struct ptlrpc_request *req);
 void osc_dec_unstable_pages(struct ptlrpc_request *req);
 bool osc_over_unstable_soft_limit(struct client_obd *cli);
@@ -122,6 +122,9 @@ int osc_io_submit(const struct lu_env *env, struct cl_io *io,
 	unsigned int max_pages;
 	unsigned int ppc_bits; /* pages per chunk bits */
 	unsigned int ppc;
+	unsigned int compr_bits = 0; /* pages per compressed chunk bits */
+	pgoff_t compr_first = 0;
+	pgoff_t compr_last = 0;
 	bool sync_queue = false;
 	bool dio = false;
 
@@ -134,6 +137,9 @@ int osc_io_submit(const struct lu_env *env, struct cl_io *io,
 	max_pages = cli->cl_max_pages_per_rpc;
 	ppc_bits = cli->cl_chunkbits - PAGE_SHIFT;
 	ppc = 1 << ppc_bits;
+	/* reads of compressed objects are expanded to whole chunks */
+	if (crt == CRT_READ && osc_compr_chunk_bits(osc))
+		compr_bits = osc_compr_chunk_bits(osc) - PAGE_SHIFT;
 
 	brw_flags = osc_io_srvlock(cl2osc_io(env, ios)) ? OBD_BRW_SRVLOCK : 0;
 	brw_flags |= crt == CRT_WRITE ? OBD_BRW_WRITE : OBD_BRW_READ;
@@ -196,8 +202,22 @@ int osc_io_submit(const struct lu_env *env, struct cl_io *io,
 			cl_page_list_del(env, qin, page, true);
 
 		queued++;
+		if (compr_bits) {
+			pgoff_t chunk = osc_index(opg) >> compr_bits;
+
+			if (queued == 1 || chunk < compr_first)
+				compr_first = chunk;
+			if (queued == 1 || chunk > compr_last)
+				compr_last = chunk;
+		}
+
 		if (queued == max_pages) {
 			sync_queue = true;
+		} else if (compr_bits) {
+			/* chunks read if the next page is in another chunk */
+			if ((compr_last - compr_first + 2) << compr_bits >
+			    max_pages)
+				sync_queue = true;
 		} else if (crt == CRT_WRITE) {
 			unsigned int chunks;
 			unsigned int next_chunks;
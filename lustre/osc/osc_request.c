@@ -1154,7 +1154,7 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
 		unsigned int mask = ~(OBD_BRW_FROM_GRANT | OBD_BRW_NOCACHE |
 				  OBD_BRW_SYNC | OBD_BRW_ASYNC   |
 				  OBD_BRW_NOQUOTA | OBD_BRW_SOFT_SYNC |
-				  OBD_BRW_SYS_RESOURCE);
+				  OBD_BRW_SYS_RESOURCE | OBD_BRW_COMPRESSED);
 
 		/* warn if combine flags that we don't know to be safe */
 		if (unlikely((p1->bp_flag & mask) != (p2->bp_flag & mask))) {
@@ -1545,6 +1545,8 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 	bool gpu = 0;
 	bool enable_checksum = true;
 	struct cl_page *clpage;
+	struct osc_compr_args *compr = NULL;
+	bool rdma_only;
 	u64 foffset = 0;
 
 	ENTRY;
@@ -1560,6 +1562,8 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 				foffset = pga[0]->bp_off;
 		}
 	}
+	/* checked before pga is replaced by the pages of compressed chunks */
+	rdma_only = brw_page2oap(pga[0])->oap_brw_flags & OBD_BRW_RDMA_ONLY;
 	if (CFS_FAIL_CHECK(OBD_FAIL_OSC_BRW_PREP_REQ))
 		RETURN(-ENOMEM); /* Recoverable */
 	if (CFS_FAIL_CHECK(OBD_FAIL_OSC_BRW_PREP_REQ2))
@@ -1721,6 +1725,21 @@ retry_encrypt:
 		}
 	}
 
+	/* chunks of encrypted files are not compressed */
+	if (pga[0]->bp_page && !(inode && IS_ENCRYPTED(inode)) &&
+	    osc_compr_chunk_bits(brw_page2oap(pga[0])->oap_obj)) {
+		rc = 0;
+		if (opc == OST_READ && rdma_only)
+			rc = -EOPNOTSUPP;
+		else if (opc == OST_READ || (!directio && !rdma_only))
+			rc = osc_compr_prep(cli, opc, oa, &page_count, &pga,
+					    &compr);
+		if (rc) {
+			ptlrpc_request_free(req);
+			RETURN(rc);
+		}
+	}
+
 	for (niocount = i = 1; i < page_count; i++) {
 		if (!can_merge_pages(pga[i - 1], pga[i]))
 			niocount++;
@@ -1740,7 +1759,7 @@ retry_encrypt:
 		}
 	}
 
-	if (brw_page2oap(pga[0])->oap_brw_flags & OBD_BRW_RDMA_ONLY) {
+	if (rdma_only) {
 		enable_checksum = false;
 		short_io_size = 0;
 		gpu = 1;
@@ -1765,6 +1784,7 @@ retry_encrypt:
 
 	rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, opc);
 	if (rc) {
+		osc_compr_free(compr);
 		ptlrpc_request_free(req);
 		RETURN(rc);
 	}
@@ -1996,6 +2016,7 @@ no_bulk:
 	aa->aa_resends = 0;
 	aa->aa_ppga = pga;
 	aa->aa_cli = cli;
+	aa->aa_compr = compr;
 	INIT_LIST_HEAD(&aa->aa_oaps);
 
 	*reqp = req;
@@ -2006,6 +2027,7 @@ no_bulk:
 	RETURN(0);
 
 out:
+	osc_compr_free(compr);
 	ptlrpc_req_finished(req);
 	RETURN(rc);
 }
@@ -2356,6 +2378,10 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 		rc = 0;
 	}
 
+	/* data of compressed chunks is copied by osc_compr_fini() */
+	if (aa->aa_compr)
+		GOTO(out, rc);
+
 	/* get the inode from the first cl_page */
 	clpage = oap2cl_page(brw_page2oap(aa->aa_ppga[0]));
 	inode = clpage->cp_inode;
@@ -2442,6 +2468,7 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 {
 	struct ptlrpc_request *new_req;
 	struct osc_brw_async_args *new_aa;
+	struct osc_brw_async_args compr_aa;
 
 	ENTRY;
 	/* The below message is checked in replay-ost-single.sh test_8ae */
@@ -2463,6 +2490,9 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	 * Note that copying a list_head doesn't work, need to move it...
 	 */
 	aa->aa_resends++;
+	new_aa = ptlrpc_req_async_args(new_aa, new_req);
+	/* pages of compressed chunks were set up for the new request */
+	compr_aa = *new_aa;
 	new_req->rq_interpret_reply = request->rq_interpret_reply;
 	new_req->rq_async_args = request->rq_async_args;
 	new_req->rq_commit_cb = request->rq_commit_cb;
@@ -2477,7 +2507,13 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	new_req->rq_generation_set = 1;
 	new_req->rq_import_generation = request->rq_import_generation;
 
-	new_aa = ptlrpc_req_async_args(new_aa, new_req);
+	new_aa->aa_compr = compr_aa.aa_compr;
+	if (new_aa->aa_compr) {
+		new_aa->aa_ppga = compr_aa.aa_ppga;
+		new_aa->aa_page_count = compr_aa.aa_page_count;
+		new_aa->aa_requested_nob = compr_aa.aa_requested_nob;
+		new_aa->aa_nio_count = compr_aa.aa_nio_count;
+	}
 
 	INIT_LIST_HEAD(&new_aa->aa_oaps);
 	list_splice_init(&aa->aa_oaps, &new_aa->aa_oaps);
@@ -2581,6 +2617,9 @@ static int brw_interpret(const struct lu_env *env,
 	rc = osc_brw_fini_request(req, rc);
 	CDEBUG(D_INODE, "request %p aa %p rc %d\n", req, aa, rc);
 
+	/* restore the pages of compressed chunks, before any resend */
+	rc = osc_compr_fini(aa, lustre_msg_get_opc(req->rq_reqmsg), rc);
+
 	/* restore clear text pages */
 	osc_release_bounce_pages(aa->aa_ppga, aa->aa_page_count);
 
@@ -2635,6 +2635,7 @@ static void osd_conf_get(const struct lu_env *env,
 
 out:
 	param->ddp_has_lseek_data_hole = true;
+	param->ddp_has_compression = true;
 }
 
 static struct vfsmount *osd_mnt_get(const struct dt_device *d)
@@ -8501,6 +8502,10 @@ static int osd_device_init0(const struct lu_env *env,
 
 	o->od_full_scrub_ratio = OFSR_DEFAULT;
 	o->od_full_scrub_threshold_rate = FULL_SCRUB_THRESHOLD_RATE_DEFAULT;
+	o->od_scrub_threads = clamp_t(__u32, osd_scrub_threads, 1,
+				      OSD_SCRUB_THREADS_MAX);
+	o->od_scrub_ra_groups = min_t(__u32, osd_scrub_ra_groups,
+				      OSD_SCRUB_RA_GROUPS_MAX);
 	rc = osd_mount(env, o, cfg);
 	if (rc != 0)
 		GOTO(out, rc);
@@ -324,6 +324,12 @@ struct osd_device {
 	 * exceeds the osd_device::od_full_scrub_threshold_rate,
 	 * then trigger OI scrub to scan the whole device. */
 	__u64			 od_full_scrub_threshold_rate;
+	/* How many threads scan the inode tables when the OI scrub
+	 * runs at full speed. */
+	__u32			 od_scrub_threads;
+	/* How many block groups ahead of the scanning have their inode
+	 * table read ahead by the OI scrub, 0 to disable. */
+	__u32			 od_scrub_ra_groups;
 
 	/* a list of orphaned agent inodes, protected with od_osfs_lock */
 	struct list_head	 od_orphan_list;
@@ -574,7 +580,8 @@ struct osd_iobuf {
 	unsigned int       dr_init_at:16, /* the line iobuf was initialized */
 			   dr_elapsed_valid:1, /* we really did count time */
 			   dr_rw:1,
-			   dr_integrity:1;
+			   dr_integrity:1,
+			   dr_compressed:1; /* has client compressed chunks */
 	struct niobuf_local	**dr_lnbs;
 	struct lu_buf	   dr_bl_buf;
 	struct lu_buf	   dr_lnb_buf;
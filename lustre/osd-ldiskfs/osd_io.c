@@ -113,6 +113,7 @@ static int __osd_init_iobuf(struct osd_device *d, struct osd_iobuf *iobuf,
 	iobuf->dr_elapsed = ktime_set(0, 0);
 	/* must be counted before, so assert */
 	iobuf->dr_rw = rw;
+	iobuf->dr_compressed = 0;
 	iobuf->dr_init_at = line;
 	iobuf->dr_inode = inode;
 
@@ -357,6 +358,78 @@ static void osd_mark_page_io_done(struct osd_iobuf *iobuf,
 #define BIO_MAX_VECS	BIO_MAX_PAGES
 #endif
 
+/*
+ * With one block per page, submit one bio for each run of pages mapped to
+ * contiguous blocks. The bio is sized for the run and filled in a single
+ * pass, instead of checking each page against the current bio, and of
+ * allocating every new bio for all the remaining pages of the IO. A bio is
+ * not made larger than the queue accepts, so that the block layer does not
+ * have to split and clone it again.
+ */
+static int osd_do_bio_extents(struct osd_device *osd, struct osd_iobuf *iobuf,
+			      struct block_device *bdev, int sector_bits,
+			      int page_idx, int page_idx_end)
+{
+	struct niobuf_local **lnbs = iobuf->dr_lnbs;
+	sector_t *blocks = iobuf->dr_blocks;
+	unsigned int max_pages;
+	struct bio *bio;
+	int run, i;
+	int rc;
+
+	max_pages = queue_max_sectors(bdev_get_queue(bdev)) >>
+		    (PAGE_SHIFT - SECTOR_SHIFT);
+	max_pages = clamp_t(unsigned int, max_pages, 1, BIO_MAX_VECS);
+
+	while (page_idx < page_idx_end) {
+		struct page *page = lnbs[page_idx]->lnb_page;
+
+		if (blocks[page_idx] == 0) {  /* hole */
+			LASSERTF(iobuf->dr_rw == 0, "page_idx %u, npages: %d\n",
+				 page_idx, iobuf->dr_npages);
+			memset(kmap(page), 0, PAGE_SIZE);
+			kunmap(page);
+			page_idx++;
+			continue;
+		}
+
+		/* pages of the run, up to the bio size limit */
+		for (run = 1; run < max_pages &&
+		     page_idx + run < page_idx_end &&
+		     blocks[page_idx + run] == blocks[page_idx] + run; run++)
+			;
+
+		bio = cfs_bio_alloc(bdev, run, iobuf->dr_rw ? REQ_OP_WRITE :
+							      REQ_OP_READ,
+				    GFP_NOIO);
+		if (!bio) {
+			CERROR("Can't allocate bio %u pages\n", run);
+			return -ENOMEM;
+		}
+		bio_set_sector(bio, (sector_t)blocks[page_idx] << sector_bits);
+		rc = osd_bio_init(bio, iobuf, page_idx);
+		if (rc) {
+			bio_put(bio);
+			return rc;
+		}
+
+		for (i = 0; i < run; i++)
+			if (bio_add_page(bio, lnbs[page_idx + i]->lnb_page,
+					 PAGE_SIZE, 0) != PAGE_SIZE)
+				break;
+		LASSERT(i > 0);
+
+		rc = osd_submit_bio(osd, iobuf, bio);
+		if (rc) {
+			osd_bio_fini(bio);
+			return rc;
+		}
+		page_idx += i;
+	}
+
+	return 0;
+}
+
 static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 		      struct osd_iobuf *iobuf, sector_t start_blocks,
 		      sector_t count)
@@ -393,8 +466,15 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 		count = npages * blocks_per_page;
 	block_idx_end = start_blocks + count;
 
+	/* all the bios of the IO are plugged until they are all built */
 	blk_start_plug(&plug);
 
+	if (blocks_per_page == 1) {
+		rc = osd_do_bio_extents(osd, iobuf, bdev, sector_bits,
+					start_blocks, block_idx_end);
+		goto out;
+	}
+
 	page_idx_start = start_blocks / blocks_per_page;
 	for (page_idx = page_idx_start, block_idx = start_blocks;
 	     block_idx < block_idx_end; page_idx++,
@@ -837,8 +917,11 @@ static int osd_ldiskfs_map_write(struct inode *inode, struct osd_iobuf *iobuf,
 				 sector_t count, loff_t *disk_size,
 				 __u64 user_size)
 {
-	/* if file has grown, take user_size into account */
-	if (user_size && *disk_size > user_size)
+	/* if file has grown, take user_size into account. A compressed
+	 * chunk ends before the data it holds, so the client size is also
+	 * used to grow the file up to the end of the uncompressed data.
+	 */
+	if (user_size && (*disk_size > user_size || iobuf->dr_compressed))
 		*disk_size = user_size;
 
 	spin_lock(&inode->i_lock);
@@ -1478,6 +1561,9 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 
 		SetPageUptodate(lnb[i].lnb_page);
 
+		if (lnb[i].lnb_flags & OBD_BRW_COMPRESSED)
+			iobuf->dr_compressed = 1;
+
 		osd_iobuf_add_page(iobuf, &lnb[i]);
 	}
 
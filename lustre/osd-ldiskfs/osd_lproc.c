@@ -512,6 +512,87 @@ static ssize_t full_scrub_threshold_rate_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(full_scrub_threshold_rate);
 
+static ssize_t scrub_threads_show(struct kobject *kobj, struct attribute *attr,
+				  char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", dev->od_scrub_threads);
+}
+
+static ssize_t scrub_threads_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > OSD_SCRUB_THREADS_MAX)
+		return -ERANGE;
+
+	/* used by the next run of the OI scrub */
+	dev->od_scrub_threads = val;
+	return count;
+}
+LUSTRE_RW_ATTR(scrub_threads);
+
+static ssize_t scrub_ra_groups_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", dev->od_scrub_ra_groups);
+}
+
+static ssize_t scrub_ra_groups_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > OSD_SCRUB_RA_GROUPS_MAX)
+		return -ERANGE;
+
+	dev->od_scrub_ra_groups = val;
+	return count;
+}
+LUSTRE_RW_ATTR(scrub_ra_groups);
+
 static ssize_t extent_bytes_allocation_show(struct kobject *kobj,
 					    struct attribute *attr, char *buf)
 {
@@ -849,6 +930,8 @@ static struct attribute *ldiskfs_attrs[] = {
 	&lustre_attr_pdo.attr,
 	&lustre_attr_full_scrub_ratio.attr,
 	&lustre_attr_full_scrub_threshold_rate.attr,
+	&lustre_attr_scrub_threads.attr,
+	&lustre_attr_scrub_ra_groups.attr,
 	&lustre_attr_extent_bytes_allocation.attr,
 #ifdef LDISKFS_GET_BLOCKS_VERY_DENSE
 	&lustre_attr_extents_dense.attr,
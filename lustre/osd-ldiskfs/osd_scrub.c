@@ -33,6 +33,14 @@
 
 #define OSD_OTABLE_MAX_HASH		0x00000000ffffffffULL
 
+unsigned int osd_scrub_threads = 1;
+module_param(osd_scrub_threads, uint, 0644);
+MODULE_PARM_DESC(osd_scrub_threads, "Default number of threads scanning the inode tables for OI scrub at full speed");
+
+unsigned int osd_scrub_ra_groups = 4;
+module_param(osd_scrub_ra_groups, uint, 0644);
+MODULE_PARM_DESC(osd_scrub_ra_groups, "Default number of block groups whose inode table is read ahead by OI scrub");
+
 /* high priority inconsistent items list APIs */
 #define SCRUB_BAD_OIMAP_DECAY_INTERVAL	60
 
@@ -267,7 +275,7 @@ int osd_scrub_refresh_mapping(struct osd_thread_info *info,
 
 static int
 osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
-		       struct osd_idmap_cache *oic, int val)
+		       struct osd_idmap_cache *oic, int val, bool prior)
 {
 	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
 	struct scrub_file *sf = &scrub->os_file;
@@ -279,11 +287,15 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 	int ops = DTO_INDEX_UPDATE;
 	bool exist = false;
 	bool bad_inode = false;
+	bool checked = false;
+	bool igif = false;
+	bool updated = false;
+	__u32 sflags = 0;
+	int oi_idx = -1;
 	int flags = 0;
 	int rc;
 
 	ENTRY;
-	down_write(&scrub->os_rwsem);
 	/* remove IDIF support to simplify logic */
 	if (val == SCRUB_NEXT_OSTOBJ_OLD)
 		GOTO(out, rc = -EOPNOTSUPP);
@@ -291,11 +303,11 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 	if (val == SCRUB_NEXT_OSTOBJ)
 		flags = OI_KNOWN_ON_OST;
 
-	scrub->os_new_checked++;
+	checked = true;
 	if (val < 0)
 		GOTO(out, rc = val);
 
-	if (scrub->os_in_prior) {
+	if (prior) {
 		oii = list_entry(oic, struct osd_inconsistent_item,
 				 oii_cache);
 		if (CFS_FAIL_CHECK(OBD_FAIL_OSD_SCRUB_STALE))
@@ -308,7 +320,7 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 		GOTO(out, rc = -ENOENT);
 
 	if (fid_is_igif(fid))
-		sf->sf_items_igif++;
+		igif = true;
 
 	/* verify inode */
 	inode = osd_iget(info, dev, lid, 0);
@@ -325,7 +337,7 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 			GOTO(out, rc = 0);
 
 		/* set LMA if missing */
-		sf->sf_flags |= SF_UPGRADE;
+		sflags |= SF_UPGRADE;
 		if (!(sf->sf_param & SP_DRYRUN)) {
 			rc = osd_ea_fid_set(info, inode, fid, 0, 0);
 			if (rc)
@@ -346,7 +358,7 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 			GOTO(skip, rc = 0);
 
 		if (val == SCRUB_NEXT_OSTOBJ)
-			sf->sf_flags |= SF_INCONSISTENT;
+			sflags |= SF_INCONSISTENT;
 	} else if (osd_id_eq(lid, lid2)) {
 		/* mapping matches */
 		if (bad_inode) {
@@ -369,7 +381,7 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 			scrub->os_full_speed = 1;
 			spin_unlock(&scrub->os_lock);
 		}
-		sf->sf_flags |= SF_INCONSISTENT;
+		sflags |= SF_INCONSISTENT;
 
 		/* if new inode is bad, keep existing mapping */
 		if (bad_inode)
@@ -422,28 +434,15 @@ delete:
 	rc = osd_scrub_refresh_mapping(info, dev, fid, lid, ops, false, flags,
 				       &exist);
 	if (rc == 0) {
-		if (scrub->os_in_prior)
-			sf->sf_items_updated_prior++;
-		else
-			sf->sf_items_updated++;
-
+		updated = true;
 		if (ops == DTO_INDEX_INSERT && val == 0 && !exist) {
-			int idx = osd_oi_fid2idx(dev, fid);
-
-			sf->sf_flags |= SF_RECREATED;
-			if (unlikely(!ldiskfs_test_bit(idx, sf->sf_oi_bitmap)))
-				ldiskfs_set_bit(idx, sf->sf_oi_bitmap);
+			sflags |= SF_RECREATED;
+			oi_idx = osd_oi_fid2idx(dev, fid);
 		}
 	}
 	GOTO(out, rc);
 out:
-	if (rc < 0) {
-		sf->sf_items_failed++;
-		if (lid->oii_ino >= LDISKFS_FIRST_INO(osd_sb(dev)) &&
-		    (sf->sf_pos_first_inconsistent == 0 ||
-		    sf->sf_pos_first_inconsistent > lid->oii_ino))
-			sf->sf_pos_first_inconsistent = lid->oii_ino;
-	} else {
+	if (rc >= 0) {
 		if (!oii && !CFS_FAIL_CHECK(OBD_FAIL_OSD_SCRUB_STALE)) {
 			if (osd_scrub_oi_resurrect(scrub, fid))
 				CDEBUG(D_LFSCK,
@@ -474,6 +473,33 @@ skip:
 		       osd_dev2name(dev), PFID(fid), lid->oii_ino,
 		       lid->oii_gen, rc);
 	}
+
+	/* The inode is checked and fixed without os_rwsem, so that several
+	 * OI scrub threads can do it in parallel. It only protects the
+	 * statistics.
+	 */
+	down_write(&scrub->os_rwsem);
+	if (checked)
+		scrub->os_new_checked++;
+	if (igif)
+		sf->sf_items_igif++;
+	sf->sf_flags |= sflags;
+	if (updated) {
+		if (prior)
+			sf->sf_items_updated_prior++;
+		else
+			sf->sf_items_updated++;
+	}
+	if (oi_idx >= 0 &&
+	    unlikely(!ldiskfs_test_bit(oi_idx, sf->sf_oi_bitmap)))
+		ldiskfs_set_bit(oi_idx, sf->sf_oi_bitmap);
+	if (rc < 0) {
+		sf->sf_items_failed++;
+		if (lid->oii_ino >= LDISKFS_FIRST_INO(osd_sb(dev)) &&
+		    (sf->sf_pos_first_inconsistent == 0 ||
+		    sf->sf_pos_first_inconsistent > lid->oii_ino))
+			sf->sf_pos_first_inconsistent = lid->oii_ino;
+	}
 	up_write(&scrub->os_rwsem);
 
 	if (!IS_ERR_OR_NULL(inode))
@@ -672,8 +698,12 @@ static int osd_iit_iget(struct osd_thread_info *info, struct osd_device *dev,
 		RETURN(rc);
 	}
 
-	if (dev->od_is_ost && S_ISREG(inode->i_mode) && inode->i_nlink > 1)
-		dev->od_scrub.os_scrub.os_has_ml_file = 1;
+	if (dev->od_is_ost && S_ISREG(inode->i_mode) && inode->i_nlink > 1 &&
+	    !scrub->os_has_ml_file) {
+		spin_lock(&scrub->os_lock);
+		scrub->os_has_ml_file = 1;
+		spin_unlock(&scrub->os_lock);
+	}
 
 	if (is_scrub &&
 	    ldiskfs_test_inode_state(inode, LDISKFS_STATE_LUSTRE_NOSCRUB)) {
@@ -684,7 +714,8 @@ static int osd_iit_iget(struct osd_thread_info *info, struct osd_device *dev,
 
 	rc = osd_scrub_get_fid(info, dev, inode, fid, is_scrub);
 	if (rc >= 0 && scrub->os_ls_count > 0 && fid_is_local_storage(fid)) {
-		index = 0;
+		/* several threads may scan the inode tables */
+		spin_lock(&scrub->os_lock);
 		for (index = 0; index < scrub->os_ls_count; index++)
 			if (scrub->os_ls_fids[index].f_seq == fid->f_seq)
 				break;
@@ -692,6 +723,7 @@ static int osd_iit_iget(struct osd_thread_info *info, struct osd_device *dev,
 		if (index < scrub->os_ls_count &&
 		    scrub->os_ls_fids[index].f_oid < fid->f_oid)
 			scrub->os_ls_fids[index].f_oid = fid->f_oid;
+		spin_unlock(&scrub->os_lock);
 	}
 	GOTO(put, rc);
 
@@ -820,7 +852,7 @@ static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 		goto wait;
 	}
 
-	rc = osd_scrub_check_update(info, dev, oic, rc);
+	rc = osd_scrub_check_update(info, dev, oic, rc, scrub->os_in_prior);
 	if (rc != 0) {
 		spin_lock(&scrub->os_lock);
 		scrub->os_in_prior = 0;
@@ -955,6 +987,429 @@ static void osd_scrub_join(const struct lu_env *env, struct osd_device *dev,
 	EXIT;
 }
 
+/**
+ * Read ahead the inode table blocks in use of the block groups
+ * [\a start, \a end), so that the inodes of these groups are already
+ * cached when the scanning reaches them instead of being read one by one.
+ */
+static void osd_scrub_itable_readahead(struct super_block *sb,
+				       ldiskfs_group_t start,
+				       ldiskfs_group_t end)
+{
+	struct blk_plug plug;
+	ldiskfs_group_t bg;
+
+	blk_start_plug(&plug);
+	for (bg = start; bg < end; bg++) {
+		struct ldiskfs_group_desc *desc;
+		ldiskfs_fsblk_t block;
+		__u32 used;
+		__u32 count;
+		__u32 i;
+
+		desc = ldiskfs_get_group_desc(sb, bg, NULL);
+		if (!desc ||
+		    desc->bg_flags & cpu_to_le16(LDISKFS_BG_INODE_UNINIT))
+			continue;
+
+		used = LDISKFS_INODES_PER_GROUP(sb) -
+		       ldiskfs_itable_unused_count(sb, desc);
+		count = DIV_ROUND_UP(used * LDISKFS_INODE_SIZE(sb),
+				     sb->s_blocksize);
+		block = le32_to_cpu(desc->bg_inode_table_lo);
+		if (LDISKFS_DESC_SIZE(sb) >= LDISKFS_MIN_DESC_SIZE_64BIT)
+			block |= (ldiskfs_fsblk_t)
+				 le32_to_cpu(desc->bg_inode_table_hi) << 32;
+		for (i = 0; i < count; i++)
+			sb_breadahead(sb, block + i);
+	}
+	blk_finish_plug(&plug);
+}
+
+/* Keep the inode tables of \a groups groups after \a bg read ahead,
+ * \a ra_bg is the first group which is not read ahead yet.
+ */
+static void osd_scrub_readahead(struct super_block *sb, ldiskfs_group_t bg,
+				__u32 groups, ldiskfs_group_t *ra_bg)
+{
+	ldiskfs_group_t end;
+
+	if (groups == 0)
+		return;
+
+	end = min_t(ldiskfs_group_t, bg + groups + 1,
+		    LDISKFS_SB(sb)->s_groups_count);
+	if (*ra_bg < bg)
+		*ra_bg = bg;
+	if (*ra_bg < end) {
+		osd_scrub_itable_readahead(sb, *ra_bg, end);
+		*ra_bg = end;
+	}
+}
+
+/* parallel inode table scanning, all members are protected by os_lock */
+struct osd_scrub_par {
+	struct osd_device	*osp_dev;
+	/* the first inode to be checked */
+	__u64			 osp_start;
+	/* the inode being checked by each thread, ~0ULL once all the
+	 * groups have been claimed */
+	__u64			 osp_pos[OSD_SCRUB_THREADS_MAX];
+	/* the next block group to be claimed */
+	ldiskfs_group_t		 osp_bg;
+	int			 osp_started;
+	int			 osp_helpers;
+	int			 osp_rc;
+	bool			 osp_exit;
+	/* stopped by OBD_FAIL_OSD_SCRUB_CRASH */
+	bool			 osp_crash;
+};
+
+/* The last inode before which all the inodes have been checked. */
+static __u64 osd_scrub_par_pos(struct osd_scrub_par *par,
+			       struct super_block *sb)
+{
+	__u64 pos = 1 + (__u64)par->osp_bg * LDISKFS_INODES_PER_GROUP(sb);
+	int i;
+
+	for (i = 0; i <= par->osp_started; i++)
+		pos = min(pos, par->osp_pos[i]);
+
+	return max(pos, par->osp_start) - 1;
+}
+
+/*
+ * The work of the OI scrub thread itself between two inodes: it stops
+ * the scanning if asked to, fixes the inconsistent OI mappings found by
+ * the RPC services in priority, and makes the checkpoint.
+ */
+static int osd_scrub_par_main(struct osd_thread_info *info,
+			      struct osd_scrub_par *par)
+{
+	struct osd_device *dev = par->osp_dev;
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct osd_otable_it *it = dev->od_otable_it;
+	struct osd_inconsistent_item *oii;
+	int rc;
+
+	if (CFS_FAIL_CHECK(OBD_FAIL_OSD_SCRUB_CRASH)) {
+		spin_lock(&scrub->os_lock);
+		scrub->os_running = 0;
+		par->osp_crash = true;
+		par->osp_exit = true;
+		spin_unlock(&scrub->os_lock);
+		wake_up_var(scrub);
+		return SCRUB_NEXT_CRASH;
+	}
+
+	if (CFS_FAIL_CHECK(OBD_FAIL_OSD_SCRUB_FATAL)) {
+		spin_lock(&scrub->os_lock);
+		if (!par->osp_rc)
+			par->osp_rc = -EINVAL;
+		spin_unlock(&scrub->os_lock);
+		return SCRUB_NEXT_FATAL;
+	}
+
+	if (kthread_should_stop()) {
+		spin_lock(&scrub->os_lock);
+		par->osp_exit = true;
+		spin_unlock(&scrub->os_lock);
+		/* the helpers may be delayed by OBD_FAIL_OSD_SCRUB_DELAY */
+		wake_up_var(scrub);
+		return SCRUB_NEXT_EXIT;
+	}
+
+	while (!list_empty(&scrub->os_inconsistent_items)) {
+		spin_lock(&scrub->os_lock);
+		if (unlikely(list_empty(&scrub->os_inconsistent_items))) {
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+
+		oii = list_first_entry(&scrub->os_inconsistent_items,
+				       struct osd_inconsistent_item, oii_list);
+		scrub->os_in_prior = 1;
+		spin_unlock(&scrub->os_lock);
+
+		/* the item is always removed from the list */
+		rc = osd_scrub_check_update(info, dev, &oii->oii_cache, 0,
+					    true);
+		spin_lock(&scrub->os_lock);
+		scrub->os_in_prior = 0;
+		spin_unlock(&scrub->os_lock);
+		if (rc)
+			return rc;
+	}
+
+	spin_lock(&scrub->os_lock);
+	scrub->os_pos_current = osd_scrub_par_pos(par, osd_sb(dev));
+	spin_unlock(&scrub->os_lock);
+
+	rc = scrub_checkpoint(info->oti_env, scrub);
+	if (rc)
+		CDEBUG(D_LFSCK, "%s: fail to checkpoint, pos = %llu: rc = %d\n",
+		       osd_scrub2name(scrub), scrub->os_pos_current, rc);
+
+	if (it != NULL && it->ooi_waiting &&
+	    it->ooi_cache.ooc_pos_preload < scrub->os_pos_current) {
+		spin_lock(&scrub->os_lock);
+		it->ooi_waiting = 0;
+		wake_up_var(scrub);
+		spin_unlock(&scrub->os_lock);
+	}
+
+	return 0;
+}
+
+static int osd_scrub_par_check(struct osd_thread_info *info,
+			       struct osd_scrub_par *par, int idx,
+			       struct osd_idmap_cache *oic, __u32 pos)
+{
+	struct osd_device *dev = par->osp_dev;
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct scrub_file *sf = &scrub->os_file;
+	int rc;
+
+	spin_lock(&scrub->os_lock);
+	par->osp_pos[idx] = pos;
+	spin_unlock(&scrub->os_lock);
+
+	/* every thread is slowed down, as the serial OI scrub is */
+	if (CFS_FAIL_CHECK(OBD_FAIL_OSD_SCRUB_DELAY) && cfs_fail_val > 0)
+		wait_var_event_timeout(
+			scrub,
+			!list_empty(&scrub->os_inconsistent_items) ||
+			READ_ONCE(par->osp_exit) || kthread_should_stop(),
+			cfs_time_seconds(cfs_fail_val));
+
+	if (idx == 0) {
+		rc = osd_scrub_par_main(info, par);
+		if (rc)
+			return rc;
+	} else if (READ_ONCE(par->osp_exit) || READ_ONCE(par->osp_rc)) {
+		return SCRUB_NEXT_EXIT;
+	}
+
+	rc = osd_iit_iget(info, dev, &oic->oic_fid, &oic->oic_lid, pos,
+			  osd_sb(dev), true);
+	switch (rc) {
+	case SCRUB_NEXT_NOSCRUB:
+		down_write(&scrub->os_rwsem);
+		scrub->os_new_checked++;
+		sf->sf_items_noscrub++;
+		up_write(&scrub->os_rwsem);
+		fallthrough;
+	case SCRUB_NEXT_CONTINUE:
+		return 0;
+	}
+
+	return osd_scrub_check_update(info, dev, oic, rc, false);
+}
+
+/*
+ * Check the inodes of the block groups claimed one by one from \a par,
+ * until all the groups have been claimed or the scanning is stopped.
+ * The thread \a idx 0 is the OI scrub thread itself.
+ */
+static int osd_scrub_par_scan(struct osd_thread_info *info,
+			      struct osd_scrub_par *par, int idx)
+{
+	struct osd_device *dev = par->osp_dev;
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct super_block *sb = osd_sb(dev);
+	struct osd_idmap_cache oic = { .oic_dev = dev };
+	__u32 ipg = LDISKFS_INODES_PER_GROUP(sb);
+	ldiskfs_group_t ra_bg = 0;
+	int rc = 0;
+
+	while (!rc) {
+		struct ldiskfs_group_desc *desc;
+		struct buffer_head *bitmap;
+		ldiskfs_group_t bg;
+		__u32 offset = 0;
+		__u32 unused;
+		__u32 gbase;
+
+		spin_lock(&scrub->os_lock);
+		if (par->osp_exit || par->osp_rc) {
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+
+		if (par->osp_bg >= LDISKFS_SB(sb)->s_groups_count) {
+			par->osp_pos[idx] = ~0ULL;
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+
+		bg = par->osp_bg++;
+		gbase = 1 + bg * ipg;
+		if (par->osp_start > gbase)
+			offset = par->osp_start - gbase;
+		par->osp_pos[idx] = gbase + offset;
+		spin_unlock(&scrub->os_lock);
+
+		desc = ldiskfs_get_group_desc(sb, bg, NULL);
+		if (!desc) {
+			rc = -EIO;
+			break;
+		}
+
+		if (desc->bg_flags & cpu_to_le16(LDISKFS_BG_INODE_UNINIT))
+			continue;
+
+		osd_scrub_readahead(sb, bg, dev->od_scrub_ra_groups, &ra_bg);
+		bitmap = ldiskfs_read_inode_bitmap(sb, bg);
+		if (IS_ERR_OR_NULL(bitmap)) {
+			rc = bitmap ? PTR_ERR(bitmap) : -EIO;
+			CERROR("%s: fail to read bitmap for %u, scrub will stop, urgent mode: rc = %d\n",
+			       osd_scrub2name(scrub), (__u32)bg, rc);
+			break;
+		}
+
+		unused = ldiskfs_itable_unused_count(sb, desc);
+		while (!rc && offset + unused < ipg) {
+			offset = ldiskfs_find_next_bit(bitmap->b_data, ipg,
+						       offset);
+			if (offset >= ipg)
+				break;
+
+			rc = osd_scrub_par_check(info, par, idx, &oic,
+						 gbase + offset++);
+		}
+		brelse(bitmap);
+	}
+
+	if (rc < 0) {
+		spin_lock(&scrub->os_lock);
+		if (!par->osp_rc)
+			par->osp_rc = rc;
+		spin_unlock(&scrub->os_lock);
+	}
+
+	return rc < 0 ? rc : 0;
+}
+
+static int osd_scrub_par_helper(void *args)
+{
+	struct osd_scrub_par *par = args;
+	struct lustre_scrub *scrub = &par->osp_dev->od_scrub.os_scrub;
+	struct lu_env env;
+	int idx;
+	int rc;
+
+	spin_lock(&scrub->os_lock);
+	idx = ++par->osp_started;
+	spin_unlock(&scrub->os_lock);
+
+	/* the other threads check the groups this one does not claim */
+	rc = lu_env_init(&env, LCT_LOCAL | LCT_DT_THREAD);
+	if (rc == 0) {
+		rc = osd_scrub_par_scan(osd_oti_get(&env), par, idx);
+		lu_env_fini(&env);
+	} else {
+		CDEBUG(D_LFSCK, "%s: OI scrub helper fail to init env: rc = %d\n",
+		       osd_scrub2name(scrub), rc);
+	}
+
+	spin_lock(&scrub->os_lock);
+	par->osp_helpers--;
+	spin_unlock(&scrub->os_lock);
+	wake_up_var(par);
+
+	return rc;
+}
+
+/**
+ * Scan the inode tables with osd_device::od_scrub_threads threads for the
+ * OI scrub at full speed, every thread checks the block groups it claims.
+ * The current position of the OI scrub, which is the checkpoint, is the
+ * last inode before which all the inodes have been checked.
+ *
+ * \retval	SCRUB_IT_ALL if all the inodes have been checked
+ * \retval	SCRUB_IT_CRASH if OBD_FAIL_OSD_SCRUB_CRASH stops the OI scrub
+ * \retval	0 if the OI scrub is stopped
+ * \retval	negative error number on failure
+ */
+static int osd_scrub_par_iteration(struct osd_thread_info *info,
+				   struct osd_device *dev)
+{
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct super_block *sb = osd_sb(dev);
+	struct osd_scrub_par *par;
+	struct task_struct *task;
+	bool stopped;
+	bool crashed;
+	int rc;
+	int i;
+
+	ENTRY;
+	OBD_ALLOC_PTR(par);
+	if (!par)
+		RETURN(-ENOMEM);
+
+	par->osp_dev = dev;
+	par->osp_start = scrub->os_pos_current;
+	par->osp_bg = (par->osp_start - 1) / LDISKFS_INODES_PER_GROUP(sb);
+	for (i = 0; i < OSD_SCRUB_THREADS_MAX; i++)
+		par->osp_pos[i] = ~0ULL;
+
+	for (i = 1; i < dev->od_scrub_threads; i++) {
+		spin_lock(&scrub->os_lock);
+		par->osp_helpers++;
+		spin_unlock(&scrub->os_lock);
+
+		task = kthread_run(osd_scrub_par_helper, par, "OI_scrub_%d", i);
+		if (IS_ERR(task)) {
+			CDEBUG(D_LFSCK, "%s: cannot start OI scrub helper: rc = %ld\n",
+			       osd_scrub2name(scrub), PTR_ERR(task));
+			spin_lock(&scrub->os_lock);
+			par->osp_helpers--;
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+	}
+
+	CDEBUG(D_LFSCK, "%s: OI scrub with %d threads from pos %llu\n",
+	       osd_scrub2name(scrub), i, par->osp_start);
+
+	osd_scrub_par_scan(info, par, 0);
+	/* keep on the OI scrub thread work until the helpers finish */
+	while (READ_ONCE(par->osp_helpers) > 0) {
+		wait_var_event_timeout(par,
+				       READ_ONCE(par->osp_helpers) == 0 ||
+				       kthread_should_stop(),
+				       cfs_time_seconds(1));
+		rc = osd_scrub_par_main(info, par);
+		if (rc < 0) {
+			spin_lock(&scrub->os_lock);
+			if (!par->osp_rc)
+				par->osp_rc = rc;
+			spin_unlock(&scrub->os_lock);
+		}
+	}
+
+	spin_lock(&scrub->os_lock);
+	rc = par->osp_rc;
+	stopped = par->osp_exit;
+	crashed = par->osp_crash;
+	if (!rc && !stopped)
+		scrub->os_pos_current = 1 + (__u64)LDISKFS_INODES_PER_GROUP(sb) *
+					LDISKFS_SB(sb)->s_groups_count;
+	else
+		scrub->os_pos_current = osd_scrub_par_pos(par, sb);
+	spin_unlock(&scrub->os_lock);
+	OBD_FREE_PTR(par);
+
+	if (crashed)
+		RETURN(SCRUB_IT_CRASH);
+
+	if (stopped)
+		RETURN(0);
+
+	RETURN(rc < 0 ? rc : SCRUB_IT_ALL);
+}
+
 static int osd_inode_iteration(struct osd_thread_info *info,
 			       struct osd_device *dev, __u32 max, bool preload)
 {
@@ -1060,6 +1515,9 @@ full:
 
 		if (kthread_should_stop())
 			RETURN(0);
+
+		if (scrub->os_full_speed && dev->od_scrub_threads > 1)
+			RETURN(osd_scrub_par_iteration(info, dev));
 	}
 
 	noslot = false;
@@ -1099,6 +1557,8 @@ full:
 			goto next_group;
 		}
 
+		osd_scrub_readahead(param->sb, param->bg,
+				    dev->od_scrub_ra_groups, &param->ra_bg);
 		param->bitmap = ldiskfs_read_inode_bitmap(param->sb, param->bg);
 		if (IS_ERR_OR_NULL(param->bitmap)) {
 			if (param->bitmap) {
@@ -31,8 +31,18 @@ struct osd_iit_param {
 	__u32 gbase;
 	__u32 offset;
 	__u32 start;
+	/* the first group whose inode table is not read ahead yet */
+	ldiskfs_group_t ra_bg;
 };
 
+/* Max number of threads scanning the inode tables in parallel. */
+#define OSD_SCRUB_THREADS_MAX		32
+/* Max number of block groups whose inode table is read ahead. */
+#define OSD_SCRUB_RA_GROUPS_MAX		256
+
+extern unsigned int osd_scrub_threads;
+extern unsigned int osd_scrub_ra_groups;
+
 struct osd_scrub {
 	struct lustre_scrub	os_scrub;
 	struct lvfs_run_ctxt    os_ctxt;
@@ -206,6 +206,44 @@ static ssize_t max_sync_changes_store(struct kobject *kobj,
 
 LUSTRE_RW_ATTR(max_sync_changes);
 
+/**
+ * Show maximum number of changes synced to OST in one RPC
+ */
+static ssize_t max_sync_batch_show(struct kobject *kobj,
+				   struct attribute *attr,
+				   char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+
+	return sprintf(buf, "%d\n", osp->opd_sync_max_batch);
+}
+
+/**
+ * Change maximum number of changes synced to OST in one RPC, 1 to send
+ * one RPC per change
+ */
+static ssize_t max_sync_batch_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+	int val;
+	int rc;
+
+	rc = kstrtoint(buffer, 0, &val);
+	if (rc)
+		return rc;
+	if (val <= 0 || val > OSP_SYNC_MAX_BATCH)
+		return -ERANGE;
+	osp->opd_sync_max_batch = val;
+	return count;
+}
+LUSTRE_RW_ATTR(max_sync_batch);
+
 /**
  * Show maximum number of RPCs in flight allowed
  *
@@ -1147,6 +1185,68 @@ static int osp_sync_error_list_seq_show(struct seq_file *m, void *data)
 }
 LDEBUGFS_SEQ_FOPS_RO(osp_sync_error_list);
 
+/**
+ * Show the create rate forecast and the time spent waiting for precreated
+ * objects by osp_precreate_reserve(). Writing to the file clears the
+ * histogram.
+ */
+static int osp_precreate_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device *dev = m->private;
+	struct osp_device *osp = lu2osp_dev(dev->obd_lu_dev);
+	struct obd_histogram *hist;
+	unsigned long tot;
+	unsigned long cum = 0;
+	int i;
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return -EINVAL;
+
+	hist = &osp->opd_pre_stall_hist;
+	lprocfs_stats_header(m, ktime_get_real(), osp->opd_pre_stats_init, 25,
+			     ":", true, "");
+	seq_printf(m, "%-25s %d\n", "create_count:",
+		   osp->opd_pre_create_count);
+	seq_printf(m, "%-25s %llu\n", "create_rate:",
+		   osp->opd_pre_rate >> OSP_PRE_RATE_SHIFT);
+	seq_printf(m, "%-25s %llu\n", "precreate_rpc_usec:",
+		   osp->opd_pre_rpc_usec);
+	seq_printf(m, "%-25s %d\n", "forecast:",
+		   osp_precreate_forecast(osp));
+
+	seq_puts(m, "\nreserve wait usec     waits   % cum %\n");
+	spin_lock(&hist->oh_lock);
+	tot = lprocfs_oh_sum(hist);
+	for (i = 0; i < OBD_HIST_MAX && cum < tot; i++) {
+		unsigned long w = hist->oh_buckets[i];
+
+		cum += w;
+		seq_printf(m, "%lu:\t\t%10lu %3u %3u\n", 1UL << i, w,
+			   pct(w, tot), pct(cum, tot));
+	}
+	spin_unlock(&hist->oh_lock);
+
+	return 0;
+}
+
+static ssize_t osp_precreate_stats_seq_write(struct file *file,
+					     const char __user *buf,
+					     size_t len, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct obd_device *dev = m->private;
+	struct osp_device *osp = lu2osp_dev(dev->obd_lu_dev);
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return -EINVAL;
+
+	lprocfs_oh_clear(&osp->opd_pre_stall_hist);
+	osp->opd_pre_stats_init = ktime_get_real();
+
+	return len;
+}
+LDEBUGFS_SEQ_FOPS(osp_precreate_stats);
+
 static struct ldebugfs_vars ldebugfs_osp_obd_vars[] = {
 	{ .name =	"connect_flags",
 	  .fops =	&osp_connect_flags_fops		},
@@ -1160,6 +1260,8 @@ static struct ldebugfs_vars ldebugfs_osp_obd_vars[] = {
 	  .fops =	&osp_state_fops			},
 	{ .name =	"error_list",
 	  .fops =	&osp_sync_error_list_fops	},
+	{ .name =	"precreate_stats",
+	  .fops =	&osp_precreate_stats_fops	},
 	{ NULL }
 };
 
@@ -1200,6 +1302,7 @@ static struct attribute *osp_obd_attrs[] = {
 	&lustre_attr_sync_in_progress.attr,
 	&lustre_attr_sync_changes.attr,
 	&lustre_attr_max_sync_changes.attr,
+	&lustre_attr_max_sync_batch.attr,
 	&lustre_attr_force_sync.attr,
 	&lustre_attr_old_sync_processed.attr,
 	&lustre_attr_create_count.attr,
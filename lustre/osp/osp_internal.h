@@ -42,6 +42,13 @@ struct osp_id_tracker {
 	atomic_t		 otr_refcount;
 };
 
+/* fixed point shift of osp_precreate::osp_pre_rate */
+#define OSP_PRE_RATE_SHIFT	8
+
+/* most changes in one OST_DESTROY or OST_SETATTR RPC, so that the obdo
+ * array still fits in OST_MAXREQSIZE */
+#define OSP_SYNC_MAX_BATCH	64
+
 struct osp_precreate {
 	/*
 	 * Precreation pool
@@ -68,6 +75,16 @@ struct osp_precreate {
 					 osp_pre_recovering:1,
 	/* force new seq rollover */
 					 osp_pre_force_new_seq:1;
+	/* objects used since osp_pre_used_time, for osp_pre_rate */
+	unsigned int			 osp_pre_used_now;
+	time64_t			 osp_pre_used_time;
+	/* EWMA of the objects used per second, << OSP_PRE_RATE_SHIFT */
+	__u64				 osp_pre_rate;
+	/* EWMA of the precreate RPC time, in usec */
+	__u64				 osp_pre_rpc_usec;
+	/* time osp_precreate_reserve() waited for objects, in usec */
+	struct obd_histogram		 osp_pre_stall_hist;
+	ktime_t				 osp_pre_stats_init;
 };
 
 struct osp_update_request_sub {
@@ -211,6 +228,10 @@ struct osp_device {
 	/* number of RPC in processing (including non-committed by OST) */
 	atomic_t			 opd_sync_rpcs_in_progress;
 	int				 opd_sync_max_rpcs_in_progress;
+	/* multi-object OST_DESTROY or OST_SETATTR RPC being filled */
+	struct ptlrpc_request		*opd_sync_batch;
+	/* max changes in one RPC, 1 to send one RPC per change */
+	int				 opd_sync_max_batch;
 	/* osd api's commit cb control structure */
 	struct dt_txn_callback		 opd_sync_txn_cb;
 	/* last used change number -- semantically similar to transno */
@@ -278,6 +299,12 @@ struct osp_device {
 #define opd_pre_create_slow		opd_pre->osp_pre_create_slow
 #define opd_pre_recovering		opd_pre->osp_pre_recovering
 #define opd_pre_force_new_seq		opd_pre->osp_pre_force_new_seq
+#define opd_pre_used_now		opd_pre->osp_pre_used_now
+#define opd_pre_used_time		opd_pre->osp_pre_used_time
+#define opd_pre_rate			opd_pre->osp_pre_rate
+#define opd_pre_rpc_usec		opd_pre->osp_pre_rpc_usec
+#define opd_pre_stall_hist		opd_pre->osp_pre_stall_hist
+#define opd_pre_stats_init		opd_pre->osp_pre_stats_init
 
 extern struct kmem_cache *osp_object_kmem;
 
@@ -807,6 +834,7 @@ __u64 osp_precreate_get_id(struct osp_device *d);
 int osp_precreate_get_fid(const struct lu_env *env, struct osp_device *d,
 			  struct lu_fid *fid);
 void osp_precreate_fini(struct osp_device *d);
+int osp_precreate_forecast(struct osp_device *d);
 int osp_object_truncate(const struct lu_env *env, struct dt_object *dt, __u64);
 void osp_pre_update_status(struct osp_device *d, int rc);
 void osp_statfs_need_now(struct osp_device *d);
@@ -282,6 +282,83 @@ void osp_statfs_need_now(struct osp_device *d)
 	}
 }
 
+/* a new sample weighs 1/4 in the EWMA of the rate and of the RPC time */
+#define OSP_PRE_EWMA_SHIFT	2
+/* objects are precreated for the next second at least */
+#define OSP_PRE_HORIZON_USEC	USEC_PER_SEC
+
+static inline __u64 osp_ewma(__u64 avg, __u64 sample)
+{
+	return avg - (avg >> OSP_PRE_EWMA_SHIFT) +
+	       (sample >> OSP_PRE_EWMA_SHIFT);
+}
+
+/**
+ * Account objects used from the precreate pool.
+ *
+ * The objects used during each second are a sample of the EWMA of the
+ * create rate, the seconds without any object used are samples of 0.
+ * Notice this function relies on external locking by opd_pre_lock.
+ *
+ * \param[in] d		OSP device
+ * \param[in] used	number of objects used
+ */
+static void osp_precreate_used_nolock(struct osp_device *d, unsigned int used)
+{
+	time64_t now = ktime_get_seconds();
+	time64_t idle = now - d->opd_pre_used_time - 1;
+	__u64 rate = d->opd_pre_rate;
+
+	if (idle >= 0) {
+		rate = osp_ewma(rate, (__u64)d->opd_pre_used_now <<
+					OSP_PRE_RATE_SHIFT);
+		if (idle > 16 << OSP_PRE_EWMA_SHIFT)
+			rate = 0;
+		for (; idle > 0 && rate; idle--)
+			rate = osp_ewma(rate, 0);
+		d->opd_pre_rate = rate;
+		d->opd_pre_used_now = 0;
+		d->opd_pre_used_time = now;
+	}
+	d->opd_pre_used_now += used;
+}
+
+/**
+ * Forecast the objects used until a new precreate RPC completes.
+ *
+ * This is the create rate, or the rate of the current second if it is a
+ * burst, over twice the precreate RPC time, but not less than
+ * OSP_PRE_HORIZON_USEC, to precreate ahead of the demand. It is limited
+ * by the maximum precreate count.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval		number of objects
+ */
+static int osp_precreate_forecast_nolock(struct osp_device *d)
+{
+	__u64 rate = max_t(__u64, d->opd_pre_rate,
+			   (__u64)d->opd_pre_used_now << OSP_PRE_RATE_SHIFT);
+	__u64 usec = max_t(__u64, d->opd_pre_rpc_usec * 2,
+			   OSP_PRE_HORIZON_USEC);
+	__u64 forecast;
+
+	forecast = div_u64(rate * usec, USEC_PER_SEC) >> OSP_PRE_RATE_SHIFT;
+
+	return min_t(__u64, forecast, d->opd_pre_max_create_count / 2);
+}
+
+int osp_precreate_forecast(struct osp_device *d)
+{
+	int forecast;
+
+	spin_lock(&d->opd_pre_lock);
+	forecast = osp_precreate_forecast_nolock(d);
+	spin_unlock(&d->opd_pre_lock);
+
+	return forecast;
+}
+
 /**
  * Check pool of precreated objects is getting low.
  *
@@ -289,7 +366,8 @@ void osp_statfs_need_now(struct osp_device *d)
  * because then there will be a long period of OSP being unavailable for the
  * new creations due to lengthy precreate RPC. Instead we ask for another
  * precreation ahead and hopefully have it ready before the current pool is
- * empty. Notice this function relies on external locking by opd_pre_lock.
+ * empty, or before the forecast demand exhausts it. Notice this function
+ * relies on external locking by opd_pre_lock.
  *
  * \param[in] d		OSP device
  *
@@ -306,6 +384,7 @@ static inline int osp_precreate_is_low_nolock(struct osp_device *d)
 
 	/* no new precreation until OST is healthy and has free space */
 	return ((d->opd_pre_create_count - available > precreate_needed ||
+		 available < osp_precreate_forecast_nolock(d) ||
 		 d->opd_force_creation) && (d->opd_pre_status == 0));
 }
 
@@ -578,8 +657,10 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 	struct ptlrpc_request	*req;
 	struct obd_import	*imp;
 	struct ost_body		*body;
-	int			 rc, grow, diff;
+	int			 rc, grow, diff, forecast;
 	struct lu_fid		*fid = &oti->osi_fid;
+	ktime_t			 start;
+	__u64			 usec = 0;
 	ENTRY;
 
 	/* don't precreate new objects till OST healthy and has free space */
@@ -619,6 +700,11 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 	}
 
 	spin_lock(&d->opd_pre_lock);
+	/* precreate the forecast demand at once, unless the OST is slow */
+	forecast = osp_precreate_forecast_nolock(d);
+	if (forecast > d->opd_pre_create_count && !d->opd_pre_create_slow)
+		d->opd_pre_create_count = forecast > 256 ?
+			round_up(forecast, 256) : roundup_pow_of_two(forecast);
 	if (d->opd_pre_create_count > d->opd_pre_max_create_count / 2)
 		d->opd_pre_create_count = d->opd_pre_max_create_count / 2;
 	grow = d->opd_pre_create_count;
@@ -648,6 +734,7 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 	if (CFS_FAIL_CHECK(OBD_FAIL_OSP_FAKE_PRECREATE))
 		GOTO(ready, rc = 0);
 
+	start = ktime_get();
 	rc = ptlrpc_queue_wait(req);
 	if (rc) {
 		CERROR("%s: can't precreate: rc = %d\n", d->opd_obd->obd_name,
@@ -663,9 +750,13 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 		GOTO(out_req, rc = -EPROTO);
 
 	ostid_to_fid(fid, &body->oa.o_oi, d->opd_index);
+	usec = ktime_us_delta(ktime_get(), start);
 
 ready:
 	spin_lock(&d->opd_pre_lock);
+	if (usec)
+		d->opd_pre_rpc_usec = d->opd_pre_rpc_usec ?
+			osp_ewma(d->opd_pre_rpc_usec, usec) : usec;
 
 	if (osp_fid_diff(fid, &d->opd_pre_used_fid) <= 0) {
 		CERROR("%s: precreate fid "DFID" <= local used fid "DFID
@@ -1441,6 +1532,7 @@ int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d,
 			  bool can_block)
 {
 	time64_t expire = ktime_get_seconds() + obd_timeout;
+	ktime_t stall = 0;
 	int precreated, rc, synced = 0;
 
 	ENTRY;
@@ -1544,6 +1636,8 @@ int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d,
 
 		CDEBUG(D_INFO, "%s: Sleeping on objects\n",
 		       d->opd_obd->obd_name);
+		if (!stall)
+			stall = ktime_get();
 		if (wait_event_idle_timeout(
 			    d->opd_pre_user_waitq,
 			    osp_precreate_ready_condition(env, d),
@@ -1564,6 +1658,12 @@ int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d,
 		}
 	}
 
+	if (stall)
+		lprocfs_oh_tally_log2(&d->opd_pre_stall_hist,
+				      min_t(s64, ktime_us_delta(ktime_get(),
+								stall),
+					    UINT_MAX));
+
 	RETURN(rc);
 }
 
@@ -1620,6 +1720,7 @@ int osp_precreate_get_fid(const struct lu_env *env, struct osp_device *d,
 
 	memcpy(fid, pre_used_fid, sizeof(*fid));
 	d->opd_pre_reserved--;
+	osp_precreate_used_nolock(d, 1);
 	/*
 	 * last_used_id must be changed along with getting new id otherwise
 	 * we might miscalculate gap causing object loss or leak
@@ -1774,6 +1875,9 @@ int osp_init_precreate(struct osp_device *d)
 	d->opd_pre_create_count = OST_MIN_PRECREATE;
 	d->opd_pre_min_create_count = OST_MIN_PRECREATE;
 	d->opd_pre_max_create_count = OST_MAX_PRECREATE;
+	d->opd_pre_used_time = ktime_get_seconds();
+	spin_lock_init(&d->opd_pre_stall_hist.oh_lock);
+	d->opd_pre_stats_init = ktime_get_real();
 	d->opd_reserved_mb_high = 0;
 	d->opd_reserved_mb_low = 0;
 	d->opd_cleanup_orphans_done = false;
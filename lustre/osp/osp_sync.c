@@ -53,6 +53,12 @@
  * syncing RPC is consider to be in progress until its LLOG record got
  * canceled. As we can see, an in-flight RPC is obviously still in progress.
  * The total number of in-progress RPCs is limited by OSP_MAX_RPCS_IN_PROGRESS.
+ *
+ * If the OST supports it (OBD_CONNECT2_SYNC_BATCH), consecutive destroy or
+ * setattr records are packed into one OST_DESTROY or OST_SETATTR RPC with an
+ * obdo per record, up to opd_sync_max_batch. The batch is sent when it is
+ * full, when a record of another kind comes, or before the thread waits. A
+ * batch counts as one RPC in flight, and as one RPC in progress per record.
  */
 
 #define OSP_MAX_RPCS_IN_FLIGHT		8
@@ -61,6 +67,23 @@
 
 #define OSP_JOB_MAGIC		0x26112005
 
+/* llog records of a multi-object RPC */
+struct osp_sync_batch {
+	/* records in the RPC */
+	int				osb_count;
+	/* room in osb_cookies */
+	int				osb_max;
+	/* replied and interpreted, protected by opd_sync_lock */
+	unsigned int			osb_replied:1,
+	/* committed before osb_replied was set */
+					osb_committed:1;
+	/* lgc_index is reset for the records retried by a single RPC */
+	struct llog_cookie		osb_cookies[];
+};
+
+#define OSP_SYNC_BATCH_SIZE(max) \
+	offsetof(struct osp_sync_batch, osb_cookies[(max)])
+
 struct osp_job_req_args {
 	/** bytes reserved for ptlrpc_replay_req() */
 	struct ptlrpc_replay_async_args	jra_raa;
@@ -68,6 +91,8 @@ struct osp_job_req_args {
 	struct list_head		jra_in_flight_link;
 	struct llog_cookie		jra_lcookie;
 	__u32				jra_magic;
+	/* NULL for a single record in jra_lcookie */
+	struct osp_sync_batch		*jra_batch;
 };
 
 static int osp_sync_add_commit_cb(const struct lu_env *env,
@@ -133,6 +158,23 @@ static inline int osp_sync_in_flight_conflict(struct osp_device *d,
 
 		req = container_of((void *)jra, struct ptlrpc_request,
 				   rq_async_args);
+		if (jra->jra_batch != NULL) {
+			struct obdo *oa;
+			int i;
+
+			oa = req_capsule_client_get(&req->rq_pill,
+						    &RMF_OBDO_ARRAY);
+			LASSERT(oa);
+			for (i = 0; i < jra->jra_batch->osb_count; i++) {
+				if (memcmp(&ostid, &oa[i].o_oi,
+					   sizeof(ostid)) == 0) {
+					spin_unlock(&d->opd_sync_lock);
+					return 1;
+				}
+			}
+			continue;
+		}
+
 		body = req_capsule_client_get(&req->rq_pill,
 					      &RMF_OST_BODY);
 		LASSERT(body);
@@ -243,6 +285,61 @@ static inline bool osp_sync_can_send_delayed(struct osp_device *d)
 	RETURN(false);
 }
 
+/**
+ * Get the RPC a record can be batched in.
+ *
+ * \param[in] d		OSP device
+ * \param[in] rec	llog record
+ *
+ * \retval OST_DESTROY or OST_SETATTR	if the record can be batched
+ * \retval 0				if the record needs its own RPC
+ */
+static inline int osp_sync_batch_op(struct osp_device *d,
+				    struct llog_rec_hdr *rec)
+{
+	if (d->opd_sync_max_batch <= 1 ||
+	    !imp_connect_sync_batch(d->opd_obd->u.cli.cl_import))
+		return 0;
+
+	switch (rec->lrh_type) {
+	case MDS_UNLINK64_REC:
+		/* a range of objects is destroyed by its own RPC */
+		if (((struct llog_unlink64_rec *)rec)->lur_count > 1)
+			return 0;
+		return OST_DESTROY;
+	case MDS_SETATTR64_REC:
+		return OST_SETATTR;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Check whether a record can be added to the batch being filled.
+ *
+ * Such a record does not need a new RPC in flight.
+ *
+ * \param[in] d		OSP device
+ * \param[in] rec	next llog record to process, NULL if not read yet
+ *
+ * \retval true		the record can be added to the batch
+ * \retval false	there is no batch or the record needs another RPC
+ */
+static inline bool osp_sync_batch_has_room(struct osp_device *d,
+					   struct llog_rec_hdr *rec)
+{
+	struct ptlrpc_request *req = d->opd_sync_batch;
+
+	/* a full batch is sent right away */
+	if (req == NULL)
+		return false;
+	if (rec == NULL || rec->lrh_type == LLOG_GEN_REC)
+		return true;
+
+	return osp_sync_batch_op(d, rec) ==
+	       lustre_msg_get_opc(req->rq_reqmsg);
+}
+
 /**
  * Check and return ready-for-new status.
  *
@@ -268,7 +365,7 @@ static inline int osp_sync_can_process_new(struct osp_device *d,
 		return 0;
 	if (!osp_sync_rpcs_in_progress_low(d))
 		return 0;
-	if (!osp_sync_rpcs_in_flight_low(d))
+	if (!osp_sync_rpcs_in_flight_low(d) && !osp_sync_batch_has_room(d, rec))
 		return 0;
 	if (!d->opd_imp_connected)
 		return 0;
@@ -520,13 +617,141 @@ static void osp_sync_request_commit_cb(struct ptlrpc_request *req)
 	ptlrpc_request_addref(req);
 
 	spin_lock(&d->opd_sync_lock);
-	list_add(&jra->jra_committed_link, &d->opd_sync_committed_there);
+	/* the failed records of a batch are known once it is interpreted,
+	 * osp_sync_batch_interpret() queues it then */
+	if (jra->jra_batch != NULL && !jra->jra_batch->osb_replied)
+		jra->jra_batch->osb_committed = 1;
+	else
+		list_add(&jra->jra_committed_link,
+			 &d->opd_sync_committed_there);
 	spin_unlock(&d->opd_sync_lock);
 
 	/* XXX: some batching wouldn't hurt */
 	wake_up(&d->opd_sync_waitq);
 }
 
+/**
+ * Queue a failed change to be repeated by a single RPC.
+ *
+ * \param[in] d		OSP device
+ * \param[in] oa	object and attributes of the change
+ * \param[in] cookie	llog record of the change
+ * \param[in] op	OST_DESTROY or OST_SETATTR
+ */
+static void osp_sync_error_add(struct osp_device *d, const struct obdo *oa,
+			       const struct llog_cookie *cookie, int op)
+{
+	struct osp_job_args *ja = NULL;
+
+	/* limit error list by 1K objects */
+	if (atomic_read(&d->opd_sync_error_count) < 1000)
+		OBD_ALLOC_PTR(ja);
+	if (unlikely(!ja))
+		return;
+
+	memcpy(&ja->ja_body.oa, oa, sizeof(ja->ja_body.oa));
+	ja->ja_lcookie = *cookie;
+	ja->ja_op = op;
+	INIT_LIST_HEAD(&ja->ja_error_link);
+	/* repeat an operation after OBD_TIMEOUT / 10 */
+	ja->ja_time = ktime_add_ms(ktime_get(),
+				   obd_timeout / 10 * MSEC_PER_SEC);
+	spin_lock(&d->opd_sync_lock);
+	list_add_tail(&ja->ja_error_link, &d->opd_sync_error_list);
+	spin_unlock(&d->opd_sync_lock);
+	atomic_inc(&d->opd_sync_error_count);
+	CDEBUG(D_INFO, "Added %px object "DOSTID"\n", ja,
+	       POSTID(&ja->ja_body.oa.o_oi));
+}
+
+/**
+ * Interpret the reply of a multi-object RPC.
+ *
+ * The records of the objects which failed are queued to be repeated by a
+ * single RPC, and their cookies are reset not to be cancelled with the rest
+ * of the batch. The request is queued to cancel the records once it is
+ * committed, or right away if the target had nothing to commit.
+ *
+ * \param[in] d		OSP device
+ * \param[in] req	request replied
+ * \param[in] jra	callback data
+ * \param[in] rc	result of RPC
+ *
+ * \retval true		the batch is not used anymore and can be freed
+ * \retval false	the batch is freed by osp_sync_process_committed()
+ */
+static bool osp_sync_batch_interpret(struct osp_device *d,
+				     struct ptlrpc_request *req,
+				     struct osp_job_req_args *jra, int rc)
+{
+	struct osp_sync_batch *osb = jra->jra_batch;
+	int op = lustre_msg_get_opc(req->rq_reqmsg);
+	bool done = rc == 0 || rc == -ENOENT;
+	bool queue = false;
+	__u32 *rcs = NULL;
+	struct obdo *oa;
+	int i;
+
+	oa = req_capsule_client_get(&req->rq_pill, &RMF_OBDO_ARRAY);
+	LASSERT(oa);
+	if (rc == 0) {
+		rcs = req_capsule_server_sized_get(&req->rq_pill, &RMF_RCS,
+					osb->osb_count * sizeof(*rcs));
+		if (rcs == NULL) {
+			DEBUG_REQ(D_ERROR, req, "no result for %d objects",
+				  osb->osb_count);
+			rc = -EPROTO;
+		}
+	}
+
+	for (i = 0; i < osb->osb_count; i++) {
+		int orc = rcs ? (int)rcs[i] : rc;
+
+		if (orc == 0 || orc == -ENOENT)
+			continue;
+
+		CDEBUG(D_HA, "%s: object "DOSTID" of %d: rc = %d\n",
+		       d->opd_obd->obd_name, POSTID(&oa[i].o_oi), op, orc);
+		osp_sync_error_add(d, &oa[i], &osb->osb_cookies[i], op);
+		osb->osb_cookies[i].lgc_index = 0;
+	}
+
+	spin_lock(&d->opd_sync_lock);
+	/* osp_sync_process_committed() frees the batch once it is queued,
+	 * osp_sync_in_flight_conflict() must not see it anymore */
+	list_del_init(&jra->jra_in_flight_link);
+	osb->osb_replied = 1;
+	if (osb->osb_committed) {
+		/* the reference was taken by osp_sync_request_commit_cb() */
+		queue = true;
+	} else if (req->rq_transno == 0 && done) {
+		/* nothing was changed, no commit callback is coming */
+		ptlrpc_request_addref(req);
+		queue = true;
+	}
+	if (queue)
+		list_add(&jra->jra_committed_link,
+			 &d->opd_sync_committed_there);
+	spin_unlock(&d->opd_sync_lock);
+
+	if (queue || !list_empty(&d->opd_sync_error_list))
+		wake_up(&d->opd_sync_waitq);
+
+	if (req->rq_transno == 0 && !done) {
+		/* this is the last time we see the request */
+		LASSERT(atomic_read(&d->opd_sync_rpcs_in_progress) >=
+			osb->osb_count);
+		atomic_sub(osb->osb_count, &d->opd_sync_rpcs_in_progress);
+		return true;
+	}
+
+	if (rc == 0 && d->opd_pre != NULL &&
+	    unlikely(d->opd_pre_status == -ENOSPC))
+		osp_statfs_need_now(d);
+
+	return false;
+}
+
 /**
  * RPC interpretation callback.
  *
@@ -549,6 +774,7 @@ static int osp_sync_interpret(const struct lu_env *env,
 {
 	struct osp_job_req_args *jra = args;
 	struct osp_device *d = req->rq_cb_data;
+	bool free_batch = false;
 
 	if (jra->jra_magic != OSP_JOB_MAGIC) {
 		DEBUG_REQ(D_ERROR, req, "bad magic %u", jra->jra_magic);
@@ -559,7 +785,9 @@ static int osp_sync_interpret(const struct lu_env *env,
 	CDEBUG(D_HA, "reply req %p/%d, rc %d, transno %llu\n", req,
 	       atomic_read(&req->rq_refcount), rc, req->rq_transno);
 
-	if (rc == -ENOENT) {
+	if (jra->jra_batch != NULL) {
+		free_batch = osp_sync_batch_interpret(d, req, jra, rc);
+	} else if (rc == -ENOENT) {
 		/*
 		 * we tried to destroy object or update attributes,
 		 * but object doesn't exist anymore - cancell llog record
@@ -577,7 +805,7 @@ static int osp_sync_interpret(const struct lu_env *env,
 		wake_up(&d->opd_sync_waitq);
 	} else if (rc) {
 		struct obd_import *imp = req->rq_import;
-		struct osp_job_args *ja = NULL;
+		struct ost_body *body;
 		/*
 		 * error happened, we'll try to repeat on next boot ?
 		 */
@@ -593,30 +821,9 @@ static int osp_sync_interpret(const struct lu_env *env,
 			LASSERT(atomic_read(&d->opd_sync_rpcs_in_progress) > 0);
 			atomic_dec(&d->opd_sync_rpcs_in_progress);
 		}
-		/* limit error list by 1K objects */
-		if (atomic_read(&d->opd_sync_error_count) < 1000)
-			OBD_ALLOC_PTR(ja);
-		if (likely(ja)) {
-			struct ost_body *body;
-
-			body = req_capsule_client_get(&req->rq_pill,
-						      &RMF_OST_BODY);
-			memcpy(&ja->ja_body, &body->oa, sizeof(ja->ja_body));
-
-			ja->ja_lcookie = jra->jra_lcookie;
-			ja->ja_op = lustre_msg_get_opc(req->rq_reqmsg);
-			INIT_LIST_HEAD(&ja->ja_error_link);
-			/* repeat an operation after OBD_TIMEOUT / 10 */
-			ja->ja_time = ktime_add_ms(ktime_get(),
-					obd_timeout / 10 * MSEC_PER_SEC);
-			spin_lock(&d->opd_sync_lock);
-			list_add_tail(&ja->ja_error_link,
-				      &d->opd_sync_error_list);
-			spin_unlock(&d->opd_sync_lock);
-			atomic_inc(&d->opd_sync_error_count);
-			CDEBUG(D_INFO, "Added %px object "DOSTID"\n", ja,
-			       POSTID(&ja->ja_body.oa.o_oi));
-		}
+		body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+		osp_sync_error_add(d, &body->oa, &jra->jra_lcookie,
+				   lustre_msg_get_opc(req->rq_reqmsg));
 		wake_up(&d->opd_sync_waitq);
 	} else if (d->opd_pre != NULL &&
 		   unlikely(d->opd_pre_status == -ENOSPC)) {
@@ -631,6 +838,11 @@ static int osp_sync_interpret(const struct lu_env *env,
 	spin_lock(&d->opd_sync_lock);
 	list_del_init(&jra->jra_in_flight_link);
 	spin_unlock(&d->opd_sync_lock);
+	if (free_batch) {
+		OBD_FREE(jra->jra_batch,
+			 OSP_SYNC_BATCH_SIZE(jra->jra_batch->osb_max));
+		jra->jra_batch = NULL;
+	}
 	LASSERT(atomic_read(&d->opd_sync_rpcs_in_flight) > 0);
 	atomic_dec(&d->opd_sync_rpcs_in_flight);
 	if (unlikely(atomic_read(&d->opd_sync_barrier) > 0))
@@ -669,6 +881,7 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
 	jra->jra_lcookie.lgc_lgl = llh->lgh_id;
 	jra->jra_lcookie.lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
 	jra->jra_lcookie.lgc_index = h->lrh_index;
+	jra->jra_batch = NULL;
 	INIT_LIST_HEAD(&jra->jra_committed_link);
 	spin_lock(&d->opd_sync_lock);
 	list_add_tail(&jra->jra_in_flight_link, &d->opd_sync_in_flight_list);
@@ -688,13 +901,13 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
  *
  * \param[in] d		OSP device
  * \param[in] op	type of the change
- * \param[in] format	request format to be used
+ * \param[in] count	room for objects in RMF_OBDO_ARRAY, 0 for a single one
  *
  * \retval pointer		new request on success
  * \retval ERR_PTR(errno)	on error
  */
 static struct ptlrpc_request *osp_sync_new_job(struct osp_device *d,
-					       enum ost_cmd op)
+					       enum ost_cmd op, int count)
 {
 	struct ptlrpc_request *req;
 	struct obd_import *imp;
@@ -725,6 +938,13 @@ static struct ptlrpc_request *osp_sync_new_job(struct osp_device *d,
 	if (req == NULL)
 		RETURN(ERR_PTR(-ENOMEM));
 
+	if (count > 0) {
+		req_capsule_set_size(&req->rq_pill, &RMF_OBDO_ARRAY,
+				     RCL_CLIENT, count * sizeof(struct obdo));
+		req_capsule_set_size(&req->rq_pill, &RMF_RCS, RCL_SERVER,
+				     count * sizeof(__u32));
+	}
+
 	rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, op);
 	if (rc) {
 		ptlrpc_req_put(req);
@@ -741,32 +961,23 @@ static struct ptlrpc_request *osp_sync_new_job(struct osp_device *d,
 }
 
 /**
- * Generate a request for setattr change.
- *
- * The function prepares a new RPC, initializes it with setattr specific
- * bits and send the RPC.
+ * Check a setattr record.
  *
  * \param[in] d		OSP device
- * \param[in] llh	llog handle where the record is stored
  * \param[in] h		llog record
  *
- * \retval 0		on success
+ * \retval 0		if the record is valid
  * \retval 1		on invalid record
- * \retval negative	negated errno on error
  */
-static int osp_sync_new_setattr_job(struct osp_device *d,
-				    struct llog_handle *llh,
-				    struct llog_rec_hdr *h)
+static int osp_sync_setattr_check(struct osp_device *d,
+				  struct llog_rec_hdr *h)
 {
-	struct llog_setattr64_rec	*rec = (struct llog_setattr64_rec *)h;
-	struct ptlrpc_request		*req;
-	struct ost_body			*body;
+	struct llog_setattr64_rec *rec = (struct llog_setattr64_rec *)h;
 
-	ENTRY;
 	LASSERT(h->lrh_type == MDS_SETATTR64_REC);
 
 	if (CFS_FAIL_CHECK(OBD_FAIL_OSP_CHECK_INVALID_REC))
-		RETURN(1);
+		return 1;
 
 	/* lsr_valid can only be 0 or HAVE OBD_MD_{FLUID, FLGID, FLPROJID} set,
 	 * so no bits other than these should be set. */
@@ -775,31 +986,238 @@ static int osp_sync_new_setattr_job(struct osp_device *d,
 		CERROR("%s: invalid setattr record, lsr_valid:%llu\n",
 			d->opd_obd->obd_name, rec->lsr_valid);
 		/* return 1 on invalid record */
-		RETURN(1);
+		return 1;
 	}
 
-	req = osp_sync_new_job(d, OST_SETATTR);
-	if (IS_ERR(req))
-		RETURN(PTR_ERR(req));
+	return 0;
+}
 
-	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
-	LASSERT(body);
-	body->oa.o_oi = rec->lsr_oi;
-	body->oa.o_uid = rec->lsr_uid;
-	body->oa.o_gid = rec->lsr_gid;
-	body->oa.o_valid = OBD_MD_FLGROUP | OBD_MD_FLID;
+/**
+ * Fill the object and attributes of a setattr change.
+ *
+ * \param[in] h		llog record, checked by osp_sync_setattr_check()
+ * \param[out] oa	object and attributes to set
+ */
+static void osp_sync_setattr_fill(struct llog_rec_hdr *h, struct obdo *oa)
+{
+	struct llog_setattr64_rec *rec = (struct llog_setattr64_rec *)h;
+
+	oa->o_oi = rec->lsr_oi;
+	oa->o_uid = rec->lsr_uid;
+	oa->o_gid = rec->lsr_gid;
+	oa->o_valid = OBD_MD_FLGROUP | OBD_MD_FLID;
 	if (h->lrh_len > sizeof(struct llog_setattr64_rec)) {
 		struct llog_setattr64_rec_v2 *rec_v2 = (typeof(rec_v2))rec;
-		body->oa.o_projid = rec_v2->lsr_projid;
-		body->oa.o_layout_version = rec_v2->lsr_layout_version;
+		oa->o_projid = rec_v2->lsr_projid;
+		oa->o_layout_version = rec_v2->lsr_layout_version;
 	}
 
 	/* old setattr record (prior 2.6.0) doesn't have 'valid' stored,
 	 * we assume that both UID and GID are valid in that case. */
 	if (rec->lsr_valid == 0)
-		body->oa.o_valid |= (OBD_MD_FLUID | OBD_MD_FLGID);
+		oa->o_valid |= (OBD_MD_FLUID | OBD_MD_FLGID);
 	else
-		body->oa.o_valid |= rec->lsr_valid;
+		oa->o_valid |= rec->lsr_valid;
+}
+
+/**
+ * Fill the object of an unlink64 change.
+ *
+ * \param[in] h		llog record
+ * \param[out] oa	object to destroy
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_unlink64_fill(struct llog_rec_hdr *h, struct obdo *oa)
+{
+	struct llog_unlink64_rec *rec = (struct llog_unlink64_rec *)h;
+	int rc;
+
+	LASSERT(h->lrh_type == MDS_UNLINK64_REC);
+
+	rc = fid_to_ostid(&rec->lur_fid, &oa->o_oi);
+	if (rc < 0)
+		return rc;
+	oa->o_misc = rec->lur_count;
+	oa->o_valid = OBD_MD_FLGROUP | OBD_MD_FLID | OBD_MD_FLOBJCOUNT;
+
+	return 0;
+}
+
+/**
+ * Send the batch being filled.
+ *
+ * The buffers are shrunk to the records added to the batch. An empty batch
+ * is dropped.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_batch_send(struct osp_device *d)
+{
+	struct ptlrpc_request *req = d->opd_sync_batch;
+	struct osp_job_req_args *jra;
+	struct osp_sync_batch *osb;
+
+	if (req == NULL)
+		return;
+
+	d->opd_sync_batch = NULL;
+	jra = ptlrpc_req_async_args(jra, req);
+	osb = jra->jra_batch;
+
+	if (unlikely(osb->osb_count == 0)) {
+		spin_lock(&d->opd_sync_lock);
+		list_del_init(&jra->jra_in_flight_link);
+		spin_unlock(&d->opd_sync_lock);
+		OBD_FREE(osb, OSP_SYNC_BATCH_SIZE(osb->osb_max));
+		ptlrpc_req_put(req);
+		atomic_dec(&d->opd_sync_rpcs_in_flight);
+		return;
+	}
+
+	req_capsule_shrink(&req->rq_pill, &RMF_OBDO_ARRAY,
+			   osb->osb_count * sizeof(struct obdo), RCL_CLIENT);
+	req_capsule_set_size(&req->rq_pill, &RMF_RCS, RCL_SERVER,
+			     osb->osb_count * sizeof(__u32));
+	ptlrpc_request_set_replen(req);
+
+	CDEBUG(D_HA, "%s: send %d objects of %d\n", d->opd_obd->obd_name,
+	       osb->osb_count, lustre_msg_get_opc(req->rq_reqmsg));
+	ptlrpcd_add_req(req);
+}
+
+/**
+ * Add a destroy or setattr change to the batch being filled.
+ *
+ * A new batch RPC is allocated if there is none, or once the batch being
+ * filled is sent if it is for another operation. The batch is sent as soon
+ * as it is full.
+ *
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ * \param[in] op	OST_DESTROY or OST_SETATTR, see osp_sync_batch_op()
+ *
+ * \retval 0		on success
+ * \retval 1		on invalid record
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_batch_add(struct osp_device *d, struct llog_handle *llh,
+			      struct llog_rec_hdr *h, int op)
+{
+	struct ptlrpc_request *req = d->opd_sync_batch;
+	struct osp_job_req_args *jra;
+	struct osp_sync_batch *osb;
+	struct llog_cookie *cookie;
+	struct ost_body *body;
+	struct obdo *oa;
+	int rc;
+
+	ENTRY;
+
+	if (op == OST_SETATTR && osp_sync_setattr_check(d, h))
+		RETURN(1);
+
+	if (req != NULL && lustre_msg_get_opc(req->rq_reqmsg) != op) {
+		osp_sync_batch_send(d);
+		req = NULL;
+	}
+
+	if (req == NULL) {
+		/* the whole batch is a single RPC in flight */
+		atomic_inc(&d->opd_sync_rpcs_in_flight);
+		OBD_ALLOC(osb, OSP_SYNC_BATCH_SIZE(d->opd_sync_max_batch));
+		if (osb == NULL)
+			GOTO(out_dec, rc = -ENOMEM);
+		osb->osb_max = d->opd_sync_max_batch;
+
+		req = osp_sync_new_job(d, op, osb->osb_max);
+		if (IS_ERR(req)) {
+			OBD_FREE(osb, OSP_SYNC_BATCH_SIZE(osb->osb_max));
+			GOTO(out_dec, rc = PTR_ERR(req));
+		}
+
+		jra = ptlrpc_req_async_args(jra, req);
+		jra->jra_magic = OSP_JOB_MAGIC;
+		jra->jra_batch = osb;
+		INIT_LIST_HEAD(&jra->jra_committed_link);
+		spin_lock(&d->opd_sync_lock);
+		list_add_tail(&jra->jra_in_flight_link,
+			      &d->opd_sync_in_flight_list);
+		spin_unlock(&d->opd_sync_lock);
+		d->opd_sync_batch = req;
+	} else {
+		jra = ptlrpc_req_async_args(jra, req);
+		osb = jra->jra_batch;
+	}
+
+	oa = req_capsule_client_get(&req->rq_pill, &RMF_OBDO_ARRAY);
+	LASSERT(oa);
+	oa += osb->osb_count;
+	if (op == OST_SETATTR) {
+		osp_sync_setattr_fill(h, oa);
+	} else {
+		rc = osp_sync_unlink64_fill(h, oa);
+		if (rc < 0)
+			RETURN(rc);
+	}
+
+	cookie = &osb->osb_cookies[osb->osb_count];
+	cookie->lgc_lgl = llh->lgh_id;
+	cookie->lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
+	cookie->lgc_index = h->lrh_index;
+
+	/* the OST body names the first object, as for a single RPC */
+	if (osb->osb_count++ == 0) {
+		body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+		LASSERT(body);
+		body->oa = *oa;
+	}
+
+	if (osb->osb_count >= osb->osb_max)
+		osp_sync_batch_send(d);
+
+	RETURN(0);
+
+out_dec:
+	atomic_dec(&d->opd_sync_rpcs_in_flight);
+	RETURN(rc);
+}
+
+/**
+ * Generate a request for setattr change.
+ *
+ * The function prepares a new RPC, initializes it with setattr specific
+ * bits and send the RPC.
+ *
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ *
+ * \retval 0		on success
+ * \retval 1		on invalid record
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_new_setattr_job(struct osp_device *d,
+				    struct llog_handle *llh,
+				    struct llog_rec_hdr *h)
+{
+	struct ptlrpc_request		*req;
+	struct ost_body			*body;
+
+	ENTRY;
+
+	if (osp_sync_setattr_check(d, h))
+		RETURN(1);
+
+	req = osp_sync_new_job(d, OST_SETATTR, 0);
+	if (IS_ERR(req))
+		RETURN(PTR_ERR(req));
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+	LASSERT(body);
+	osp_sync_setattr_fill(h, &body->oa);
 
 	osp_sync_send_new_rpc(d, llh, h, req);
 	RETURN(0);
@@ -832,7 +1250,7 @@ static int osp_sync_new_unlink_job(struct osp_device *d,
 	ENTRY;
 	LASSERT(h->lrh_type == MDS_UNLINK_REC);
 
-	req = osp_sync_new_job(d, OST_DESTROY);
+	req = osp_sync_new_job(d, OST_DESTROY, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
@@ -873,26 +1291,21 @@ static int osp_sync_new_unlink64_job(struct osp_device *d,
 				     struct llog_handle *llh,
 				     struct llog_rec_hdr *h)
 {
-	struct llog_unlink64_rec	*rec = (struct llog_unlink64_rec *)h;
 	struct ptlrpc_request		*req = NULL;
 	struct ost_body			*body;
 	int				 rc;
 
 	ENTRY;
-	LASSERT(h->lrh_type == MDS_UNLINK64_REC);
-	req = osp_sync_new_job(d, OST_DESTROY);
+	req = osp_sync_new_job(d, OST_DESTROY, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
 	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
 	if (body == NULL)
 		RETURN(-EFAULT);
-	rc = fid_to_ostid(&rec->lur_fid, &body->oa.o_oi);
+	rc = osp_sync_unlink64_fill(h, &body->oa);
 	if (rc < 0)
 		RETURN(rc);
-	body->oa.o_misc = rec->lur_count;
-	body->oa.o_valid = OBD_MD_FLGROUP | OBD_MD_FLID |
-			   OBD_MD_FLOBJCOUNT;
 	osp_sync_send_new_rpc(d, llh, h, req);
 	RETURN(0);
 }
@@ -906,7 +1319,7 @@ static int osp_sync_new_err_job(struct osp_device *d,
 
 	ENTRY;
 
-	req = osp_sync_new_job(d, ja->ja_op);
+	req = osp_sync_new_job(d, ja->ja_op, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
@@ -923,6 +1336,7 @@ static int osp_sync_new_err_job(struct osp_device *d,
 	jra = ptlrpc_req_async_args(jra, req);
 	jra->jra_magic = OSP_JOB_MAGIC;
 	memcpy(&jra->jra_lcookie, &ja->ja_lcookie, sizeof(jra->jra_lcookie));
+	jra->jra_batch = NULL;
 	INIT_LIST_HEAD(&jra->jra_committed_link);
 	spin_lock(&d->opd_sync_lock);
 	list_add_tail(&jra->jra_in_flight_link, &d->opd_sync_in_flight_list);
@@ -961,6 +1375,7 @@ static void osp_sync_process_record(const struct lu_env *env,
 {
 	struct llog_handle	*cathandle = llh->u.phd.phd_cat_handle;
 	struct llog_cookie	 cookie;
+	int			 op;
 	int			 rc = 0;
 
 	ENTRY;
@@ -997,9 +1412,16 @@ static void osp_sync_process_record(const struct lu_env *env,
 
 	/* notice we increment counters before sending RPC, to be consistent
 	 * in RPC interpret callback which may happen very quickly */
-	atomic_inc(&d->opd_sync_rpcs_in_flight);
 	atomic_inc(&d->opd_sync_rpcs_in_progress);
 
+	op = osp_sync_batch_op(d, rec);
+	if (op) {
+		/* the batch accounts the RPC in flight */
+		rc = osp_sync_batch_add(d, llh, rec, op);
+		goto done;
+	}
+
+	atomic_inc(&d->opd_sync_rpcs_in_flight);
 	switch (rec->lrh_type) {
 	/* case MDS_UNLINK_REC is kept for compatibility */
 	case MDS_UNLINK_REC:
@@ -1018,7 +1440,10 @@ static void osp_sync_process_record(const struct lu_env *env,
 		rc = 1;
 		break;
 	}
+	if (rc != 0)
+		atomic_dec(&d->opd_sync_rpcs_in_flight);
 
+done:
 	/* For all kinds of records, not matter successful or not,
 	 * we should decrease changes and bump last_processed_id.
 	 */
@@ -1028,10 +1453,8 @@ static void osp_sync_process_record(const struct lu_env *env,
 		wake_up(&d->opd_sync_barrier_waitq);
 	}
 	atomic64_inc(&d->opd_sync_processed_recs);
-	if (rc != 0) {
-		atomic_dec(&d->opd_sync_rpcs_in_flight);
+	if (rc != 0)
 		atomic_dec(&d->opd_sync_rpcs_in_progress);
-	}
 
 	CDEBUG(D_OTHER, "%s: %d in flight, %d in progress\n",
 	       d->opd_obd->obd_name, atomic_read(&d->opd_sync_rpcs_in_flight),
@@ -1069,13 +1492,12 @@ static void osp_sync_process_committed(const struct lu_env *env,
 {
 	struct obd_device	*obd = d->opd_obd;
 	struct obd_import	*imp = obd->u.cli.cl_import;
-	struct ost_body		*body;
+	struct osp_job_req_args	*jra;
 	struct ptlrpc_request	*req;
 	struct llog_ctxt	*ctxt;
 	struct llog_handle	*llh;
 	int			*arr, arr_size;
 	LIST_HEAD(list);
-	struct list_head	 *le;
 	struct llog_logid	 lgid;
 	int			 rc, i, count = 0, done = 0;
 
@@ -1111,8 +1533,8 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	INIT_LIST_HEAD(&d->opd_sync_committed_there);
 	spin_unlock(&d->opd_sync_lock);
 
-	list_for_each(le, &list)
-		count++;
+	list_for_each_entry(jra, &list, jra_committed_link)
+		count += jra->jra_batch ? jra->jra_batch->osb_count : 1;
 	if (count > 2) {
 		arr_size = sizeof(int) * count;
 		/* limit cookie array to order 2 */
@@ -1125,7 +1547,9 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	}
 	i = 0;
 	while (!list_empty(&list)) {
-		struct osp_job_req_args	*jra;
+		struct osp_sync_batch	*osb;
+		struct llog_cookie	*cookies;
+		int			 nr, j;
 
 		jra = list_first_entry(&list, struct osp_job_req_args,
 				       jra_committed_link);
@@ -1134,42 +1558,71 @@ static void osp_sync_process_committed(const struct lu_env *env,
 
 		req = container_of((void *)jra, struct ptlrpc_request,
 				   rq_async_args);
-		body = req_capsule_client_get(&req->rq_pill,
-					      &RMF_OST_BODY);
-		LASSERT(body);
+		osb = jra->jra_batch;
+		if (osb != NULL) {
+			cookies = osb->osb_cookies;
+			nr = osb->osb_count;
+		} else {
+			cookies = &jra->jra_lcookie;
+			nr = 1;
+		}
+
 		/* import can be closing, thus all commit cb's are
 		 * called we can check committness directly */
-		if (req->rq_import_generation == imp->imp_generation) {
-			if (arr && (!i ||
-				    !memcmp(&jra->jra_lcookie.lgc_lgl, &lgid,
-					   sizeof(lgid)))) {
+		if (req->rq_import_generation != imp->imp_generation) {
+			DEBUG_REQ(D_OTHER, req, "imp_committed = %llu",
+				  imp->imp_peer_committed_transno);
+			nr = 0;
+		}
+		for (j = 0; j < nr; j++) {
+			/* repeated by a single RPC, see osp_sync_interpret() */
+			if (osb != NULL && cookies[j].lgc_index == 0)
+				continue;
+
+			if (arr && i > 0 &&
+			    memcmp(&cookies[j].lgc_lgl, &lgid, sizeof(lgid))) {
+				rc = llog_cat_cancel_arr_rec(env, llh, &lgid,
+							     i, arr);
+				CDEBUG(D_OTHER,
+				       "%s: cancel %d records in "DFID": rc = %d\n",
+				       obd->obd_name, i, PLOGID(&lgid), rc);
+				i = 0;
+			}
+			if (arr) {
 				if (unlikely(!i))
-					lgid = jra->jra_lcookie.lgc_lgl;
+					lgid = cookies[j].lgc_lgl;
 
-				arr[i++] = jra->jra_lcookie.lgc_index;
+				arr[i++] = cookies[j].lgc_index;
 			} else {
 				rc = llog_cat_cancel_records(env, llh, 1,
-							     &jra->jra_lcookie);
+							     &cookies[j]);
 				if (rc)
 					CERROR("%s: can't cancel record: rc = %d\n",
 					       obd->obd_name, rc);
 			}
+			if (arr && (i * sizeof(int)) == arr_size) {
+				rc = llog_cat_cancel_arr_rec(env, llh, &lgid,
+							     i, arr);
+				CDEBUG(D_OTHER,
+				       "%s: cancel %d records in "DFID": rc = %d\n",
+				       obd->obd_name, i, PLOGID(&lgid), rc);
+				i = 0;
+			}
+		}
+
+		if (osb != NULL) {
+			done += osb->osb_count;
+			jra->jra_batch = NULL;
+			OBD_FREE(osb, OSP_SYNC_BATCH_SIZE(osb->osb_max));
 		} else {
-			DEBUG_REQ(D_OTHER, req, "imp_committed = %llu",
-				  imp->imp_peer_committed_transno);
+			done++;
 		}
 		ptlrpc_req_put(req);
-		done++;
-		if (arr &&
-		    ((i * sizeof(int)) == arr_size ||
-		     (list_empty(&list) && i > 0))) {
-			rc = llog_cat_cancel_arr_rec(env, llh, &lgid, i, arr);
-			CDEBUG(D_OTHER,
-			       "%s: cancel %d records in "DFID": rc = %d\n",
-			       obd->obd_name, i, PLOGID(&lgid), rc);
-			i = 0;
-		}
-
+	}
+	if (arr && i > 0) {
+		rc = llog_cat_cancel_arr_rec(env, llh, &lgid, i, arr);
+		CDEBUG(D_OTHER, "%s: cancel %d records in "DFID": rc = %d\n",
+		       obd->obd_name, i, PLOGID(&lgid), rc);
 	}
 
 	if (arr)
@@ -1206,6 +1659,9 @@ static bool osp_sync_process_error_list(const struct lu_env *env,
 
 	if (likely(list_empty(&d->opd_sync_error_list)))
 		return false;
+	/* there may be room in the batch only */
+	if (!osp_sync_rpcs_in_flight_low(d))
+		return false;
 
 	spin_lock(&d->opd_sync_lock);
 	ja = list_first_entry(&d->opd_sync_error_list, typeof(*ja),
@@ -1260,6 +1716,7 @@ static int osp_sync_process_queues(const struct lu_env *env,
 	do {
 		if (!d->opd_sync_task) {
 			CDEBUG(D_HA, "stop llog processing\n");
+			osp_sync_batch_send(d);
 			return LLOG_PROC_BREAK;
 		}
 
@@ -1286,6 +1743,9 @@ static int osp_sync_process_queues(const struct lu_env *env,
 			    cfs_fail_val != 1)
 			msleep(1 * MSEC_PER_SEC);
 
+		/* nothing is added to the batch while waiting */
+		osp_sync_batch_send(d);
+
 		if (list_empty(&d->opd_sync_error_list)) {
 			wait_event_idle(d->opd_sync_waitq,
 				!d->opd_sync_task ||
@@ -1398,6 +1858,7 @@ next:
 		 */
 	} while (rc == 0 && (wrapped ||
 			     d->opd_sync_last_catalog_idx == 1));
+	osp_sync_batch_send(d);
 
 	if (rc < 0) {
 		if (rc == -EINPROGRESS) {
@@ -1657,6 +2118,8 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 	d->opd_sync_max_rpcs_in_flight = OSP_MAX_RPCS_IN_FLIGHT;
 	d->opd_sync_max_rpcs_in_progress = OSP_MAX_RPCS_IN_PROGRESS;
 	d->opd_sync_max_changes = OSP_MAX_SYNC_CHANGES;
+	d->opd_sync_max_batch = OSP_SYNC_MAX_BATCH;
+	d->opd_sync_batch = NULL;
 	spin_lock_init(&d->opd_sync_lock);
 	init_waitqueue_head(&d->opd_sync_waitq);
 	init_waitqueue_head(&d->opd_sync_barrier_waitq);
@@ -394,6 +394,56 @@ static int batch_update_request_fini(struct batch_update_head *head,
 	RETURN(rc);
 }
 
+/*
+ * Save in each batched modification the transno and versions returned for
+ * it, so that it is replayed on its own. The MDT stops a batch at the first
+ * modification that fails, the next ones are sent again in another batch:
+ * only replay the ones up to the last that got a transno.
+ */
+static void batch_update_replay_prep(struct ptlrpc_request *req,
+				     struct batch_update_reply *reply)
+{
+	struct batch_update_request *bur;
+	struct but_update_header *buh;
+	struct lustre_msg *reqmsg = NULL;
+	struct lustre_msg *repmsg = NULL;
+	__u32 count = 0;
+	__u32 i;
+
+	if (reply == NULL || req->rq_transno == 0)
+		return;
+
+	buh = req_capsule_client_get(&req->rq_pill, &RMF_BUT_HEADER);
+	/* a batch of modifications is always packed inline */
+	if (buh == NULL || buh->buh_inline_length == 0)
+		return;
+
+	bur = (struct batch_update_request *)buh->buh_inline_data;
+	for (i = 0; i < reply->burp_count && i < bur->burq_count; i++) {
+		__u64 *versions;
+		__u64 transno;
+
+		reqmsg = batch_update_reqmsg_next(bur, reqmsg);
+		repmsg = batch_update_repmsg_next(reply, repmsg);
+		if (reqmsg == NULL || repmsg == NULL)
+			break;
+		if (reqmsg->lm_opc == BUT_GETATTR)
+			continue;
+
+		transno = lustre_msg_get_transno(repmsg);
+		versions = lustre_msg_get_versions(repmsg);
+		if (transno == 0 || versions == NULL)
+			continue;
+
+		lustre_msg_set_transno(reqmsg, transno);
+		lustre_msg_set_versions(reqmsg, versions);
+		count = i + 1;
+	}
+
+	bur->burq_count = count;
+	buh->buh_update_count = count;
+}
+
 static int batch_update_interpret(const struct lu_env *env,
 				  struct ptlrpc_request *req,
 				  void *args, int rc)
@@ -415,9 +465,13 @@ static int batch_update_interpret(const struct lu_env *env,
 		if ((reply == NULL ||
 		     reply->burp_magic != BUT_REPLY_MAGIC) && rc == 0)
 			rc = -EPROTO;
+		if (rc == 0)
+			batch_update_replay_prep(req, reply);
 	}
 
 	rc = batch_update_request_fini(aa->ba_head, req, reply, rc);
+	/* the request may be kept for replay, the head is freed */
+	aa->ba_head = NULL;
 
 	RETURN(rc);
 }
@@ -497,10 +551,44 @@ static int batch_update_request_add(struct batch_update_head **headp,
 		buf = current_batch_update_buffer(head);
 		LASSERT(buf != NULL);
 		max_len = buf->bub_size - buf->bub_end;
+		/*
+		 * A batch of modifications is kept for replay, but only its
+		 * request message is, not the bulk update buffers, so keep
+		 * such batch small enough to be packed inline.
+		 */
+		if (!(bh->lbt_flags & BATCH_FL_RDONLY)) {
+			if (head->buh_buf_count > 1 ||
+			    buf->bub_end + sizeof(struct but_update_header) >=
+			    OUT_UPDATE_MAX_INLINE_SIZE)
+				max_len = 0;
+			else
+				max_len = min_t(size_t, max_len,
+						OUT_UPDATE_MAX_INLINE_SIZE -
+						sizeof(struct but_update_header) -
+						buf->bub_end);
+		}
 		reqmsg = (struct lustre_msg *)((char *)buf->bub_req +
 						buf->bub_end);
 		rc = packer(head, reqmsg, &max_len, item);
-		if (rc == -E2BIG) {
+		if (rc == -E2BIG && !(bh->lbt_flags & BATCH_FL_RDONLY) &&
+		    head->buh_update_count > 0) {
+			struct obd_export *exp = head->buh_exp;
+
+			/* Send the full batch and start a new one */
+			rc = batch_send_update_req(NULL, head);
+			*headp = NULL;
+			head = NULL;
+			if (rc)
+				break;
+
+			head = batch_update_request_create(exp, bh);
+			if (IS_ERR(head)) {
+				rc = PTR_ERR(head);
+				head = NULL;
+				break;
+			}
+			*headp = head;
+		} else if (rc == -E2BIG) {
 			int rc2;
 
 			/* Create new batch object update buffer */
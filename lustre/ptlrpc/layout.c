@@ -644,7 +644,22 @@ static const struct req_msg_field *ost_destroy_client[] = {
 	&RMF_PTLRPC_BODY,
 	&RMF_OST_BODY,
 	&RMF_DLM_REQ,
-	&RMF_CAPA1
+	&RMF_CAPA1,
+	&RMF_OBDO_ARRAY
+};
+
+static const struct req_msg_field *ost_setattr_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_BODY,
+	&RMF_CAPA1,
+	&RMF_OBDO_ARRAY
+};
+
+/* the result of each object of RMF_OBDO_ARRAY, if any */
+static const struct req_msg_field *ost_body_rcs[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_BODY,
+	&RMF_RCS
 };
 
 
@@ -894,6 +909,9 @@ static struct req_format *req_formats[] = {
 	&RQF_LFSCK_NOTIFY,
 	&RQF_LFSCK_QUERY,
 	&RQF_BUT_GETATTR,
+	&RQF_BUT_CREATE,
+	&RQF_BUT_UNLINK,
+	&RQF_BUT_SETATTR,
 	&RQF_MDS_BATCH,
 };
 
@@ -1218,6 +1236,11 @@ struct req_msg_field RMF_OST_BODY =
 		    dump_ost_body);
 EXPORT_SYMBOL(RMF_OST_BODY);
 
+/* swabbed by the handler, the size is set only for multi-object RPCs */
+struct req_msg_field RMF_OBDO_ARRAY =
+	DEFINE_MSGF("obdo_array", 0, -1, NULL, NULL);
+EXPORT_SYMBOL(RMF_OBDO_ARRAY);
+
 struct req_msg_field RMF_OBD_IOOBJ =
 	DEFINE_MSGF("obd_ioobj", RMF_F_STRUCT_ARRAY,
 		    sizeof(struct obd_ioobj), lustre_swab_obd_ioobj, dump_ioo);
@@ -1758,7 +1781,7 @@ struct req_format RQF_OST_GETATTR =
 EXPORT_SYMBOL(RQF_OST_GETATTR);
 
 struct req_format RQF_OST_SETATTR =
-	DEFINE_REQ_FMT0("OST_SETATTR", ost_body_capa, ost_body_only);
+	DEFINE_REQ_FMT0("OST_SETATTR", ost_setattr_client, ost_body_rcs);
 EXPORT_SYMBOL(RQF_OST_SETATTR);
 
 struct req_format RQF_OST_CREATE =
@@ -1782,7 +1805,7 @@ struct req_format RQF_OST_SYNC =
 EXPORT_SYMBOL(RQF_OST_SYNC);
 
 struct req_format RQF_OST_DESTROY =
-	DEFINE_REQ_FMT0("OST_DESTROY", ost_destroy_client, ost_body_only);
+	DEFINE_REQ_FMT0("OST_DESTROY", ost_destroy_client, ost_body_rcs);
 EXPORT_SYMBOL(RQF_OST_DESTROY);
 
 struct req_format RQF_OST_BRW_READ =
@@ -1844,6 +1867,26 @@ struct req_format RQF_BUT_GETATTR =
 			mds_batch_getattr_server);
 EXPORT_SYMBOL(RQF_BUT_GETATTR);
 
+/*
+ * Batched modifications reuse the MDS_REINT fields, so that the reint
+ * unpackers can extend them; RMF_PTLRPC_BODY of a sub request only carries
+ * its transno and versions.
+ */
+struct req_format RQF_BUT_CREATE =
+	DEFINE_REQ_FMT0("MDS_BATCH_CREATE", mds_reint_create_acl_client,
+			mds_reint_create_acl_server);
+EXPORT_SYMBOL(RQF_BUT_CREATE);
+
+struct req_format RQF_BUT_UNLINK =
+	DEFINE_REQ_FMT0("MDS_BATCH_UNLINK", mds_reint_unlink_client,
+			mds_last_unlink_server);
+EXPORT_SYMBOL(RQF_BUT_UNLINK);
+
+struct req_format RQF_BUT_SETATTR =
+	DEFINE_REQ_FMT0("MDS_BATCH_SETATTR", mds_reint_setattr_client,
+			mds_setattr_server);
+EXPORT_SYMBOL(RQF_BUT_SETATTR);
+
 /* Convenience macro */
 #define FMT_FIELD(fmt, i, j) (fmt)->rf_fields[(i)].d[(j)]
 
@@ -2007,6 +2050,24 @@ size_t req_capsule_filled_sizes(struct req_capsule *pill,
 }
 EXPORT_SYMBOL(req_capsule_filled_sizes);
 
+/*
+ * The ptlrpc_body of a batched modification only carries its transno and
+ * the versions of its objects, it starts zeroed.
+ */
+static void req_capsule_subreq_body_init(struct req_capsule *pill,
+					 enum req_location loc)
+{
+	struct lustre_msg *msg = __req_msg(pill, loc);
+	__u32 len;
+
+	if (!req_capsule_has_field(pill, &RMF_PTLRPC_BODY, loc))
+		return;
+
+	len = lustre_msg_buflen(msg, MSG_PTLRPC_BODY_OFF);
+	if (len > 0)
+		memset(lustre_msg_buf(msg, MSG_PTLRPC_BODY_OFF, len), 0, len);
+}
+
 /**
  * Capsule equivalent of lustre_pack_request() and lustre_pack_reply().
  *
@@ -2095,6 +2156,7 @@ int req_capsule_server_pack(struct req_capsule *pill)
 		rc = 0;
 		lustre_init_msg_v2(pill->rc_repmsg, count,
 				   pill->rc_area[RCL_SERVER], NULL);
+		req_capsule_subreq_body_init(pill, RCL_SERVER);
 	}
 
 	return rc;
@@ -2122,6 +2184,7 @@ int req_capsule_client_pack(struct req_capsule *pill)
 		/* Sub request in a batch PTLRPC request */
 		lustre_init_msg_v2(pill->rc_reqmsg, count,
 				   pill->rc_area[RCL_CLIENT], NULL);
+		req_capsule_subreq_body_init(pill, RCL_CLIENT);
 	}
 	return rc;
 }
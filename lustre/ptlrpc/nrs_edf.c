@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Network Request Scheduler (NRS) Earliest Deadline First (EDF) policy
+ *
+ * Dispatches RPCs in the order of the deadline assigned to them by adaptive
+ * timeouts, rather than in their arrival order. Under overload this serves
+ * the requests closest to timing out on the client first, so fewer of them
+ * need early replies or expire in the queue and cause a reconnect.
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+
+#include <obd_support.h>
+#include <obd_class.h>
+#include "ptlrpc_internal.h"
+
+/**
+ * \name edf
+ *
+ * The EDF policy keeps the queued requests in a binary heap sorted by
+ * ptlrpc_request::rq_deadline, as it was when the request was enqueued.
+ * Requests with the same deadline are handled in their arrival order.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_EDF	"edf"
+
+/**
+ * Binary heap predicate.
+ *
+ * Elements are sorted by the deadline of the request, then by their arrival
+ * sequence.
+ *
+ * \param[in] e1 the first binheap node to compare
+ * \param[in] e2 the second binheap node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 <= e2
+ */
+static int edf_req_compare(struct binheap_node *e1, struct binheap_node *e2)
+{
+	struct ptlrpc_nrs_request *nrq1;
+	struct ptlrpc_nrs_request *nrq2;
+
+	nrq1 = container_of(e1, struct ptlrpc_nrs_request, nr_node);
+	nrq2 = container_of(e2, struct ptlrpc_nrs_request, nr_node);
+
+	if (nrq1->nr_u.edf.er_deadline < nrq2->nr_u.edf.er_deadline)
+		return 1;
+	if (nrq1->nr_u.edf.er_deadline > nrq2->nr_u.edf.er_deadline)
+		return 0;
+
+	return nrq1->nr_u.edf.er_sequence <= nrq2->nr_u.edf.er_sequence;
+}
+
+static struct binheap_ops nrs_edf_heap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= edf_req_compare,
+};
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STARTED; allocates and initializes
+ * the EDF-specific private data structure.
+ *
+ * \param[in] policy The policy to start
+ * \param[in] arg    Generic char buffer; unused in this policy
+ *
+ * \retval -ENOMEM OOM error
+ * \retval  0	   success
+ *
+ * \see nrs_policy_register()
+ * \see nrs_policy_ctl()
+ */
+static int nrs_edf_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_edf_head *head;
+
+	ENTRY;
+
+	OBD_CPT_ALLOC_PTR(head, nrs_pol2cptab(policy), nrs_pol2cptid(policy));
+	if (head == NULL)
+		RETURN(-ENOMEM);
+
+	head->eh_binheap = binheap_create(&nrs_edf_heap_ops,
+					  CBH_FLAG_ATOMIC_GROW, 4096, NULL,
+					  nrs_pol2cptab(policy),
+					  nrs_pol2cptid(policy));
+	if (head->eh_binheap == NULL) {
+		OBD_FREE_PTR(head);
+		RETURN(-ENOMEM);
+	}
+
+	INIT_LIST_HEAD(&head->eh_list);
+	policy->pol_private = head;
+
+	RETURN(0);
+}
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED; deallocates the EDF-specific
+ * private data structure.
+ *
+ * \param[in] policy The policy to stop
+ *
+ * \see nrs_policy_stop0()
+ */
+static void nrs_edf_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_edf_head *head = policy->pol_private;
+
+	LASSERT(head != NULL);
+	LASSERT(head->eh_binheap != NULL);
+	LASSERT(binheap_is_empty(head->eh_binheap));
+	LASSERT(list_empty(&head->eh_list));
+
+	binheap_destroy(head->eh_binheap);
+
+	OBD_FREE_PTR(head);
+}
+
+/**
+ * Is called for obtaining an EDF policy resource.
+ *
+ * \param[in]  policy	  The policy on which the request is being asked for
+ * \param[in]  nrq	  The request for which resources are being taken
+ * \param[in]  parent	  Parent resource, unused in this policy
+ * \param[out] resp	  Resources references are placed in this array
+ * \param[in]  moving_req Signifies limited caller context; unused in this
+ *			  policy
+ *
+ * \retval 1 The EDF policy only has a one-level resource hierarchy
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_edf_res_get(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq,
+			   const struct ptlrpc_nrs_resource *parent,
+			   struct ptlrpc_nrs_resource **resp, bool moving_req)
+{
+	*resp = &((struct nrs_edf_head *)policy->pol_private)->eh_res;
+	return 1;
+}
+
+/**
+ * Called when getting a request from the EDF policy for handling, or just
+ * peeking; removes the request from the policy when it is to be handled.
+ *
+ * \param[in] policy The policy
+ * \param[in] peek   When set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  Force the policy to return a request; unused in this
+ *		     policy
+ *
+ * \retval The request to be handled; this is the queued request with the
+ *	   earliest deadline
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_edf_req_get(struct ptlrpc_nrs_policy *policy,
+					   bool peek, bool force)
+{
+	struct nrs_edf_head *head = policy->pol_private;
+	struct binheap_node *node;
+	struct ptlrpc_nrs_request *nrq;
+	struct ptlrpc_request *req;
+
+	node = binheap_root(head->eh_binheap);
+	if (unlikely(node == NULL))
+		return NULL;
+
+	nrq = container_of(node, struct ptlrpc_nrs_request, nr_node);
+	if (unlikely(peek))
+		return nrq;
+
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	head->eh_stats.es_served++;
+	if (head->eh_list.next != &nrq->nr_u.edf.er_list)
+		head->eh_stats.es_expedited++;
+	if (req->rq_early_count > 0)
+		head->eh_stats.es_early_replied++;
+	if (ktime_get_real_seconds() > req->rq_deadline)
+		head->eh_stats.es_expired++;
+
+	binheap_remove(head->eh_binheap, &nrq->nr_node);
+	list_del_init(&nrq->nr_u.edf.er_list);
+
+	CDEBUG(D_RPCTRACE, "NRS: starting to handle %s request from %s, seq: %llu, deadline: %lld\n",
+	       policy->pol_desc->pd_name, libcfs_idstr(&req->rq_peer),
+	       nrq->nr_u.edf.er_sequence, nrq->nr_u.edf.er_deadline);
+
+	return nrq;
+}
+
+/**
+ * Adds request \a nrq to an EDF \a policy instance's set of queued requests
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to add
+ *
+ * \retval 0 success
+ * \retval != 0 error
+ */
+static int nrs_edf_req_add(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_edf_head *head = policy->pol_private;
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+	int rc;
+
+	nrq->nr_u.edf.er_deadline = req->rq_deadline;
+	nrq->nr_u.edf.er_sequence = head->eh_sequence++;
+
+	rc = binheap_insert(head->eh_binheap, &nrq->nr_node);
+	if (rc == 0)
+		list_add_tail(&nrq->nr_u.edf.er_list, &head->eh_list);
+
+	return rc;
+}
+
+/**
+ * Removes request \a nrq from \a policy's list of queued requests.
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to remove
+ */
+static void nrs_edf_req_del(struct ptlrpc_nrs_policy *policy,
+			    struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_edf_head *head = policy->pol_private;
+
+	binheap_remove(head->eh_binheap, &nrq->nr_node);
+	list_del_init(&nrq->nr_u.edf.er_list);
+}
+
+/**
+ * Prints a debug statement right before the request \a nrq stops being
+ * handled.
+ *
+ * \param[in] policy The policy handling the request
+ * \param[in] nrq    The request being handled
+ *
+ * \see ptlrpc_server_finish_request()
+ * \see ptlrpc_nrs_req_stop_nolock()
+ */
+static void nrs_edf_req_stop(struct ptlrpc_nrs_policy *policy,
+			     struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	CDEBUG(D_RPCTRACE, "NRS: finished handling %s request from %s, seq: %llu, deadline: %lld\n",
+	       policy->pol_desc->pd_name, libcfs_idstr(&req->rq_peer),
+	       nrq->nr_u.edf.er_sequence, nrq->nr_u.edf.er_deadline);
+}
+
+/**
+ * Performs ctl functions specific to EDF policy instances; similar to ioctl
+ *
+ * \param[in]     policy the policy instance
+ * \param[in]     opc    the opcode
+ * \param[in,out] arg    used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_edf_ctl(struct ptlrpc_nrs_policy *policy,
+		       enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	struct nrs_edf_head *head = policy->pol_private;
+	struct ptlrpc_service_part *svcpt = policy->pol_nrs->nrs_svcpt;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch (opc) {
+	default:
+		RETURN(-EINVAL);
+
+	/* sum up the statistics of all the service partitions */
+	case NRS_CTL_EDF_RD_STATS: {
+		struct nrs_edf_stats *stats = arg;
+
+		spin_lock(&svcpt->scp_req_lock);
+		stats->es_served += head->eh_stats.es_served;
+		stats->es_expedited += head->eh_stats.es_expedited;
+		stats->es_early_replied += head->eh_stats.es_early_replied;
+		stats->es_expired += head->eh_stats.es_expired;
+		spin_unlock(&svcpt->scp_req_lock);
+		break;
+	}
+
+	case NRS_CTL_EDF_CLR_STATS:
+		spin_lock(&svcpt->scp_req_lock);
+		memset(&head->eh_stats, 0, sizeof(head->eh_stats));
+		spin_unlock(&svcpt->scp_req_lock);
+		break;
+	}
+	RETURN(0);
+}
+
+/**
+ * debugfs interface
+ */
+
+static int nrs_edf_stats_show(struct seq_file *m, struct ptlrpc_service *svc,
+			      enum ptlrpc_nrs_queue_type queue,
+			      const char *name)
+{
+	struct nrs_edf_stats stats = { 0 };
+	int rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, queue, NRS_POL_NAME_EDF,
+				       NRS_CTL_EDF_RD_STATS, false, &stats);
+	/**
+	 * Ignore -ENODEV as the NRS head's policy may be in the
+	 * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+	 */
+	if (rc == -ENODEV)
+		return 0;
+	if (rc)
+		return rc;
+
+	seq_printf(m, "%s:\n", name);
+	seq_printf(m, "  served: %llu\n", stats.es_served);
+	seq_printf(m, "  expedited: %llu\n", stats.es_expedited);
+	seq_printf(m, "  early_replied: %llu\n", stats.es_early_replied);
+	seq_printf(m, "  expired: %llu\n", stats.es_expired);
+
+	return 0;
+}
+
+/**
+ * Shows the scheduling statistics of EDF policy instances on both the regular
+ * and high-priority NRS head of a service, as long as a policy instance is not
+ * in the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+ *
+ * "expedited" counts the requests dispatched ahead of an earlier arrival,
+ * "early_replied" those which needed early replies while queued, and
+ * "expired" those dispatched after their deadline. Compared with the same
+ * load under the fifo policy, the last two show the early replies and
+ * timeouts avoided by deadline ordering.
+ */
+static int
+ptlrpc_lprocfs_nrs_edf_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	int rc;
+
+	rc = nrs_edf_stats_show(m, svc, PTLRPC_NRS_QUEUE_REG,
+				"regular_requests");
+	if (rc || !nrs_svc_has_hp(svc))
+		return rc;
+
+	return nrs_edf_stats_show(m, svc, PTLRPC_NRS_QUEUE_HP,
+				  "high_priority_requests");
+}
+
+/**
+ * Clears the scheduling statistics of EDF policy instances on both the regular
+ * and high-priority NRS head of a service, e.g.
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_edf_stats=clear
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_edf_stats_seq_write(struct file *file,
+				       const char __user *buffer, size_t count,
+				       loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_service *svc = m->private;
+	enum ptlrpc_nrs_queue_type queue = PTLRPC_NRS_QUEUE_REG;
+	int rc;
+
+	if (nrs_svc_has_hp(svc))
+		queue = PTLRPC_NRS_QUEUE_BOTH;
+
+	rc = ptlrpc_nrs_policy_control(svc, queue, NRS_POL_NAME_EDF,
+				       NRS_CTL_EDF_CLR_STATS, false, NULL);
+
+	return rc ? rc : count;
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_edf_stats);
+
+static int nrs_edf_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct ldebugfs_vars nrs_edf_lprocfs_vars[] = {
+		{ .name		= "nrs_edf_stats",
+		  .fops		= &ptlrpc_lprocfs_nrs_edf_stats_fops,
+		  .data		= svc },
+		{ NULL }
+	};
+
+	if (!svc->srv_debugfs_entry)
+		return 0;
+
+	ldebugfs_add_vars(svc->srv_debugfs_entry, nrs_edf_lprocfs_vars, NULL);
+
+	return 0;
+}
+
+/**
+ * EDF policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_edf_ops = {
+	.op_policy_start	= nrs_edf_start,
+	.op_policy_stop		= nrs_edf_stop,
+	.op_policy_ctl		= nrs_edf_ctl,
+	.op_res_get		= nrs_edf_res_get,
+	.op_req_get		= nrs_edf_req_get,
+	.op_req_enqueue		= nrs_edf_req_add,
+	.op_req_dequeue		= nrs_edf_req_del,
+	.op_req_stop		= nrs_edf_req_stop,
+	.op_lprocfs_init	= nrs_edf_lprocfs_init,
+};
+
+/**
+ * EDF policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_edf = {
+	.nc_name		= NRS_POL_NAME_EDF,
+	.nc_ops			= &nrs_edf_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} edf */
+
+/** @} nrs */
@@ -68,6 +68,8 @@ static void nrs_tbf_rule_fini(struct kref *kref)
 	LASSERT(list_empty(&rule->tr_linkage));
 
 	rule->tr_head->th_ops->o_rule_fini(rule);
+	if (rule->tr_parent)
+		kref_put(&rule->tr_parent->tr_ref, nrs_tbf_rule_fini);
 	OBD_FREE_PTR(rule);
 }
 
@@ -128,7 +130,18 @@ nrs_tbf_cli_reset(struct nrs_tbf_head *head,
 static int
 nrs_tbf_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	return rule->tr_head->th_ops->o_rule_dump(rule, m);
+	int rc;
+
+	rc = rule->tr_head->th_ops->o_rule_dump(rule, m);
+	if (rc)
+		return rc;
+
+	if (rule->tr_parent)
+		seq_printf(m, ", parent %s%s", rule->tr_parent->tr_name,
+			   rule->tr_flags & NTRS_BORROW ? ", borrow" : "");
+	seq_putc(m, '\n');
+
+	return 0;
 }
 
 static int
@@ -256,7 +269,9 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 	struct nrs_tbf_rule	*rule;
 	struct nrs_tbf_rule	*tmp_rule;
 	struct nrs_tbf_rule	*next_rule;
+	struct nrs_tbf_rule	*parent;
 	char			*next_name = start->u.tc_start.ts_next_name;
+	char			*parent_name = start->u.tc_start.ts_parent_name;
 	int			 rc;
 
 	rule = nrs_tbf_rule_find(head, start->tc_name);
@@ -274,6 +289,8 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 	rule->tr_flags = start->u.tc_start.ts_rule_flags;
 	rule->tr_nsecs_per_rpc = NSEC_PER_SEC / rule->tr_rpc_rate;
 	rule->tr_depth = tbf_depth;
+	rule->tr_ntoken = rule->tr_depth;
+	rule->tr_check_time = ktime_to_ns(ktime_get());
 	kref_init(&rule->tr_ref);
 	INIT_LIST_HEAD(&rule->tr_cli_list);
 	INIT_LIST_HEAD(&rule->tr_nids);
@@ -297,6 +314,20 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		return -EEXIST;
 	}
 
+	if (parent_name) {
+		/* only two levels, a child rule cannot be a parent */
+		parent = nrs_tbf_rule_find_nolock(head, parent_name);
+		if (!parent || parent->tr_parent) {
+			spin_unlock(&head->th_rule_lock);
+			if (parent)
+				kref_put(&parent->tr_ref, nrs_tbf_rule_fini);
+			kref_put(&rule->tr_ref, nrs_tbf_rule_fini);
+			return parent ? -EINVAL : -ENOENT;
+		}
+		/* reference is dropped by nrs_tbf_rule_fini() */
+		rule->tr_parent = parent;
+	}
+
 	if (next_name) {
 		next_rule = nrs_tbf_rule_find_nolock(head, next_name);
 		if (!next_rule) {
@@ -311,6 +342,8 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		/* Add on the top of the rule list */
 		list_add(&rule->tr_linkage, &head->th_list);
 	}
+	if (rule->tr_parent)
+		rule->tr_parent->tr_nchildren++;
 	spin_unlock(&head->th_rule_lock);
 	atomic_inc(&head->th_rule_sequence);
 	if (start->u.tc_start.ts_rule_flags & NTRS_DEFAULT) {
@@ -319,8 +352,9 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		head->th_rule = rule;
 	}
 
-	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu\n",
-	       rule, rule->tr_rpc_rate, rule->tr_generation);
+	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu parent %s\n",
+	       rule, rule->tr_rpc_rate, rule->tr_generation,
+	       parent_name ? parent_name : "none");
 
 	return 0;
 }
@@ -436,7 +470,17 @@ nrs_tbf_rule_stop(struct ptlrpc_nrs_policy *policy,
 	if (rule == NULL)
 		return -ENOENT;
 
+	spin_lock(&head->th_rule_lock);
+	/* child rules have to be stopped first */
+	if (rule->tr_nchildren > 0) {
+		spin_unlock(&head->th_rule_lock);
+		kref_put(&rule->tr_ref, nrs_tbf_rule_fini);
+		return -EBUSY;
+	}
+	if (rule->tr_parent)
+		rule->tr_parent->tr_nchildren--;
 	list_del_init(&rule->tr_linkage);
+	spin_unlock(&head->th_rule_lock);
 	rule->tr_flags |= NTRS_STOPPING;
 	kref_put(&rule->tr_ref, nrs_tbf_rule_fini);
 	kref_put(&rule->tr_ref, nrs_tbf_rule_fini);
@@ -969,7 +1013,7 @@ static int nrs_tbf_jobid_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_jobid_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 		   rule->tr_jobids_str, rule->tr_rpc_rate,
 		   kref_read(&rule->tr_ref) - 1);
 	return 0;
@@ -1179,7 +1223,7 @@ static int nrs_tbf_nid_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_nid_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 		   rule->tr_nids_str, rule->tr_rpc_rate,
 		   kref_read(&rule->tr_ref) - 1);
 	return 0;
@@ -2008,7 +2052,7 @@ nrs_tbf_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_generic_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	seq_printf(m, "%s %s %llu, ref %d\n", rule->tr_name,
+	seq_printf(m, "%s %s %llu, ref %d", rule->tr_name,
 		   rule->tr_conds_str, rule->tr_rpc_rate,
 		   kref_read(&rule->tr_ref) - 1);
 	return 0;
@@ -2296,7 +2340,7 @@ static int nrs_tbf_opcode_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_opcode_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 		   rule->tr_opcodes_str, rule->tr_rpc_rate,
 		   kref_read(&rule->tr_ref) - 1);
 	return 0;
@@ -2613,7 +2657,7 @@ nrs_tbf_id_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_id_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 		   rule->tr_ids_str, rule->tr_rpc_rate,
 		   kref_read(&rule->tr_ref) - 1);
 	return 0;
@@ -2975,6 +3019,48 @@ static void nrs_tbf_res_put(struct ptlrpc_nrs_policy *policy,
 	head->th_ops->o_cli_put(head, cli);
 }
 
+/**
+ * Get the rule whose token bucket is shared by the class of \a rule.
+ *
+ * A parent rule caps the aggregate RPC rate of the classes of its child rules
+ * and of its own classes, the other rules only limit each class separately.
+ */
+static inline struct nrs_tbf_rule *
+nrs_tbf_rule_bucket(struct nrs_tbf_rule *rule)
+{
+	if (rule->tr_parent)
+		return rule->tr_parent;
+	if (READ_ONCE(rule->tr_nchildren) > 0)
+		return rule;
+	return NULL;
+}
+
+/**
+ * Add the tokens earned by the shared bucket of \a rule since its last
+ * check-point, keeping the remainder of the elapsed time for the next one.
+ */
+static void nrs_tbf_rule_refill(struct nrs_tbf_rule *rule, __u64 now)
+{
+	__u64 passed;
+	__u64 ntoken;
+
+	if (now <= rule->tr_check_time)
+		return;
+
+	passed = now - rule->tr_check_time;
+	if (passed >= rule->tr_depth * rule->tr_nsecs_per_rpc) {
+		rule->tr_ntoken = rule->tr_depth;
+		rule->tr_check_time = now;
+		return;
+	}
+
+	ntoken = div64_u64(passed, rule->tr_nsecs_per_rpc);
+	rule->tr_check_time += ntoken * rule->tr_nsecs_per_rpc;
+	rule->tr_ntoken = min(rule->tr_ntoken + ntoken, rule->tr_depth);
+	if (rule->tr_ntoken == rule->tr_depth)
+		rule->tr_check_time = now;
+}
+
 /**
  * Called when getting a request from the TBF policy for handling, or just
  * peeking; removes the request from the policy when it is to be handled.
@@ -2999,6 +3085,7 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 	struct ptlrpc_nrs_request *nrq = NULL;
 	struct nrs_tbf_client     *cli;
 	struct binheap_node	  *node;
+	int			   i;
 
 	assert_spin_locked(&policy->pol_nrs->nrs_svcpt->scp_req_lock);
 
@@ -3009,19 +3096,36 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 	if (unlikely(node == NULL))
 		return NULL;
 
-	cli = container_of(node, struct nrs_tbf_client, tc_node);
-	LASSERT(cli->tc_in_heap);
 	if (unlikely(peek)) {
-		nrq = list_first_entry(&cli->tc_list,
-				       struct ptlrpc_nrs_request,
-				       nr_u.tbf.tr_list);
-	} else {
-		struct nrs_tbf_rule *rule = cli->tc_rule;
+		cli = container_of(node, struct nrs_tbf_client, tc_node);
+		LASSERT(cli->tc_in_heap);
+		return list_first_entry(&cli->tc_list,
+					struct ptlrpc_nrs_request,
+					nr_u.tbf.tr_list);
+	}
+
+	/*
+	 * A class held back by its parent rule moves down the heap, so the
+	 * classes of other rules that have tokens left get a chance.  Look at
+	 * no more roots than there are classes in the heap.
+	 */
+	for (i = binheap_size(head->th_binheap); i > 0; i--) {
+		struct nrs_tbf_rule *rule;
+		struct nrs_tbf_rule *bucket;
 		__u64 now = ktime_to_ns(ktime_get());
 		__u64 passed;
 		__u64 ntoken;
 		__u64 deadline;
 		__u64 old_resid = 0;
+		bool capped = false;
+		bool borrow = false;
+		ktime_t time;
+
+		node = binheap_root(head->th_binheap);
+		cli = container_of(node, struct nrs_tbf_client, tc_node);
+		LASSERT(cli->tc_in_heap);
+		rule = cli->tc_rule;
+		bucket = nrs_tbf_rule_bucket(rule);
 
 		deadline = cli->tc_check_time +
 			  cli->tc_nsecs;
@@ -3046,11 +3150,27 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 		if (unlikely(force) && ntoken == 0)
 			ntoken = 1;
 
-		if (ntoken > 0) {
+		if (bucket) {
+			nrs_tbf_rule_refill(bucket, now);
+			if (bucket->tr_ntoken == 0 && likely(!force)) {
+				/* the parent rule caps all its classes */
+				capped = true;
+				deadline = max(deadline, bucket->tr_check_time +
+					       bucket->tr_nsecs_per_rpc);
+			} else if (ntoken == 0 && rule->tr_flags & NTRS_BORROW) {
+				/* tokens left unused by the sibling classes */
+				borrow = true;
+			}
+		}
+
+		if ((ntoken > 0 || borrow) && !capped) {
 			nrq = list_first_entry(&cli->tc_list,
 					 struct ptlrpc_nrs_request,
 					 nr_u.tbf.tr_list);
-			ntoken--;
+			if (ntoken > 0)
+				ntoken--;
+			if (bucket && bucket->tr_ntoken > 0)
+				bucket->tr_ntoken--;
 			cli->tc_ntoken = ntoken;
 			cli->tc_check_time = now;
 			list_del_init(&nrq->nr_u.tbf.tr_list);
@@ -3059,35 +3179,47 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 					       &cli->tc_node);
 				cli->tc_in_heap = false;
 			} else {
+				__u64 nsecs = cli->tc_nsecs;
+
+				if (bucket && rule->tr_flags & NTRS_BORROW)
+					nsecs = min(nsecs,
+						    bucket->tr_nsecs_per_rpc);
 				if (!(rule->tr_flags & NTRS_REALTIME))
-					cli->tc_deadline = now + cli->tc_nsecs;
+					cli->tc_deadline = now + nsecs;
 				binheap_relocate(head->th_binheap,
 						 &cli->tc_node);
 			}
 			CDEBUG(D_RPCTRACE,
-			       "TBF dequeues: class@%p rate %llu gen %llu token %llu, rule@%p rate %llu gen %llu\n",
+			       "TBF dequeues: class@%p rate %llu gen %llu token %llu%s, rule@%p rate %llu gen %llu\n",
 			       cli, cli->tc_rpc_rate,
 			       cli->tc_rule_generation, cli->tc_ntoken,
+			       borrow ? " borrowed" : "",
 			       cli->tc_rule, cli->tc_rule->tr_rpc_rate,
 			       cli->tc_rule->tr_generation);
-		} else {
-			ktime_t time;
+			break;
+		}
 
-			if (rule->tr_flags & NTRS_REALTIME) {
-				cli->tc_deadline = deadline;
+		if (capped || rule->tr_flags & NTRS_REALTIME) {
+			cli->tc_deadline = deadline;
+			if (rule->tr_flags & NTRS_REALTIME)
 				cli->tc_nsecs_resid = old_resid;
-				binheap_relocate(head->th_binheap,
-						 &cli->tc_node);
-				if (node != binheap_root(head->th_binheap))
-					return nrs_tbf_req_get(policy,
-							       peek, force);
+			binheap_relocate(head->th_binheap, &cli->tc_node);
+			if (node != binheap_root(head->th_binheap)) {
+				if (i > 1)
+					continue;
+				/* wake up for the class now at the root */
+				cli = container_of(binheap_root(head->th_binheap),
+						   struct nrs_tbf_client,
+						   tc_node);
+				deadline = min(deadline, cli->tc_deadline);
 			}
-			policy->pol_nrs->nrs_throttling = 1;
-			head->th_deadline = deadline;
-			time = ktime_set(0, 0);
-			time = ktime_add_ns(time, deadline);
-			hrtimer_start(&head->th_timer, time, HRTIMER_MODE_ABS);
 		}
+		policy->pol_nrs->nrs_throttling = 1;
+		head->th_deadline = deadline;
+		time = ktime_set(0, 0);
+		time = ktime_add_ns(time, deadline);
+		hrtimer_start(&head->th_timer, time, HRTIMER_MODE_ABS);
+		break;
 	}
 
 	return nrq;
@@ -3397,6 +3529,27 @@ nrs_tbf_parse_value_pair(struct nrs_tbf_cmd *cmd, char *buffer)
 
 		if (realtime > 0)
 			cmd->u.tc_start.ts_rule_flags |= NTRS_REALTIME;
+	} else if (strcmp(key, "parent") == 0) {
+		if (cmd->tc_cmd != NRS_CTL_TBF_START_RULE)
+			return -EINVAL;
+
+		rc = check_rule_name(val);
+		if (rc)
+			return rc;
+
+		cmd->u.tc_start.ts_parent_name = val;
+	} else if (strcmp(key, "borrow") == 0) {
+		unsigned long borrow;
+
+		if (cmd->tc_cmd != NRS_CTL_TBF_START_RULE)
+			return -EINVAL;
+
+		rc = kstrtoul(val, 10, &borrow);
+		if (rc)
+			return rc;
+
+		if (borrow > 0)
+			cmd->u.tc_start.ts_rule_flags |= NTRS_BORROW;
 	} else {
 		return -EINVAL;
 	}
@@ -3422,6 +3575,10 @@ nrs_tbf_parse_value_pairs(struct nrs_tbf_cmd *cmd, char *buffer)
 	case NRS_CTL_TBF_START_RULE:
 		if (cmd->u.tc_start.ts_rpc_rate == 0)
 			cmd->u.tc_start.ts_rpc_rate = tbf_rate;
+		/* only a child rule can borrow from its parent */
+		if (cmd->u.tc_start.ts_rule_flags & NTRS_BORROW &&
+		    cmd->u.tc_start.ts_parent_name == NULL)
+			return -EINVAL;
 		break;
 	case NRS_CTL_TBF_CHANGE_RULE:
 		if (cmd->u.tc_change.tc_rpc_rate == 0 &&
@@ -1455,6 +1455,10 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_MIRROR_ID_FIX);
 	LASSERTF(OBD_CONNECT2_UPDATE_LAYOUT == 0x4000000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_UPDATE_LAYOUT);
+	LASSERTF(OBD_CONNECT2_BATCH_REINT == 0x8000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_REINT);
+	LASSERTF(OBD_CONNECT2_SYNC_BATCH == 0x10000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_SYNC_BATCH);
 
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
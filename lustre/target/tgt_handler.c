@@ -24,6 +24,7 @@
 #include <lustre_lfsck.h>
 #include <lustre_nodemap.h>
 #include <lustre_acl.h>
+#include <lustre_swab.h>
 
 #include "tgt_internal.h"
 
@@ -161,6 +162,76 @@ out:
 }
 EXPORT_SYMBOL(tgt_validate_obdo);
 
+static void tgt_obdo_map_ids(struct lu_nodemap *nodemap, struct obdo *oa)
+{
+	oa->o_uid = nodemap_map_id(nodemap, NODEMAP_UID,
+				   NODEMAP_CLIENT_TO_FS, oa->o_uid);
+	oa->o_gid = nodemap_map_id(nodemap, NODEMAP_GID,
+				   NODEMAP_CLIENT_TO_FS, oa->o_gid);
+	oa->o_projid = nodemap_map_id(nodemap, NODEMAP_PROJID,
+				      NODEMAP_CLIENT_TO_FS, oa->o_projid);
+}
+
+/**
+ * Unpack the objects of a multi-object OST_DESTROY or OST_SETATTR RPC.
+ *
+ * Each object is checked and its IDs are mapped the same way as the one
+ * of the OST body by tgt_ost_body_unpack().
+ *
+ * \param[in] tsi	target session environment for this request
+ * \param[out] count	number of objects in the request
+ *
+ * \retval		array of \a count objects, NULL if there are none
+ * \retval		ERR_PTR(negative errno) on error
+ */
+struct obdo *tgt_obdo_array_unpack(struct tgt_session_info *tsi, int *count)
+{
+	struct req_capsule *pill = tsi->tsi_pill;
+	struct lu_nodemap *nodemap;
+	struct obdo *oa;
+	__u32 size;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	*count = 0;
+	if (!req_capsule_has_field(pill, &RMF_OBDO_ARRAY, RCL_CLIENT) ||
+	    !req_capsule_field_present(pill, &RMF_OBDO_ARRAY, RCL_CLIENT))
+		RETURN(NULL);
+
+	size = req_capsule_get_size(pill, &RMF_OBDO_ARRAY, RCL_CLIENT);
+	if (size == 0)
+		RETURN(NULL);
+	if (size % sizeof(*oa) != 0)
+		RETURN(ERR_PTR(-EPROTO));
+
+	oa = req_capsule_client_get(pill, &RMF_OBDO_ARRAY);
+	if (oa == NULL)
+		RETURN(ERR_PTR(-EFAULT));
+
+	nodemap = nodemap_get_from_exp(tsi->tsi_exp);
+	if (IS_ERR(nodemap))
+		RETURN(ERR_CAST(nodemap));
+
+	for (i = 0; i < size / sizeof(*oa); i++) {
+		if (req_capsule_req_need_swab(pill))
+			lustre_swab_obdo(&oa[i]);
+
+		rc = tgt_validate_obdo(tsi, &oa[i]);
+		if (rc) {
+			nodemap_putref(nodemap);
+			RETURN(ERR_PTR(rc));
+		}
+		tgt_obdo_map_ids(nodemap, &oa[i]);
+	}
+	nodemap_putref(nodemap);
+	*count = i;
+
+	RETURN(oa);
+}
+EXPORT_SYMBOL(tgt_obdo_array_unpack);
+
 static int tgt_io_data_unpack(struct tgt_session_info *tsi, struct ost_id *oi)
 {
 	unsigned		 max_brw;
@@ -235,15 +306,7 @@ static int tgt_ost_body_unpack(struct tgt_session_info *tsi, __u32 flags)
 	if (IS_ERR(nodemap))
 		RETURN(PTR_ERR(nodemap));
 
-	body->oa.o_uid = nodemap_map_id(nodemap, NODEMAP_UID,
-					NODEMAP_CLIENT_TO_FS,
-					body->oa.o_uid);
-	body->oa.o_gid = nodemap_map_id(nodemap, NODEMAP_GID,
-					NODEMAP_CLIENT_TO_FS,
-					body->oa.o_gid);
-	body->oa.o_projid = nodemap_map_id(nodemap, NODEMAP_PROJID,
-					   NODEMAP_CLIENT_TO_FS,
-					   body->oa.o_projid);
+	tgt_obdo_map_ids(nodemap, &body->oa);
 	nodemap_putref(nodemap);
 
 	tsi->tsi_ost_body = body;
@@ -445,6 +508,17 @@ static int tgt_handle_request0(struct tgt_session_info *tsi,
 					    &RMF_OBD_QUOTA_ITER, RCL_SERVER, 0);
 		}
 
+		/* one result per object of a multi-object RPC */
+		if (req_capsule_has_field(tsi->tsi_pill, &RMF_OBDO_ARRAY,
+					  RCL_CLIENT))
+			req_capsule_set_size(tsi->tsi_pill, &RMF_RCS,
+					     RCL_SERVER,
+					     req_capsule_get_size(tsi->tsi_pill,
+							&RMF_OBDO_ARRAY,
+							RCL_CLIENT) /
+					     sizeof(struct obdo) *
+					     sizeof(__u32));
+
 		rc = req_capsule_server_pack(tsi->tsi_pill);
 	}
 
@@ -1327,7 +1327,7 @@ add_reply_data:
 
 		if (!(lustre_msg_get_flags(req->rq_reqmsg) & exclude) &&
 		    !(tsi && tsi->tsi_batch_env &&
-		      trd->trd_reply.lrd_batch_idx > 0))
+		      !list_empty(&trd->trd_list)))
 			tgt_clean_by_tag(req->rq_export, req->rq_xid,
 					 trd->trd_tag);
 	}
@@ -1390,9 +1390,13 @@ int tgt_mk_reply_data(const struct lu_env *env,
 
 	/* fill reply data information */
 	lrd = &trd->trd_reply;
-	lrd->lrd_transno = transno;
 	if (tsi && tsi->tsi_batch_env) {
-		if (tsi->tsi_batch_idx == 0) {
+		/*
+		 * The first sub request with a transaction is not always
+		 * the first one of the batch, and a failed sub request must
+		 * not lower the transno saved by the previous ones.
+		 */
+		if (tsi->tsi_batch_trd == NULL) {
 			LASSERT(req != NULL);
 			tsi->tsi_batch_trd = trd;
 			trd->trd_index = -1;
@@ -1400,8 +1404,11 @@ int tgt_mk_reply_data(const struct lu_env *env,
 			trd->trd_tag = lustre_msg_get_tag(req->rq_reqmsg);
 			lrd->lrd_client_gen = ted->ted_lcd->lcd_generation;
 		}
+		if (transno > lrd->lrd_transno)
+			lrd->lrd_transno = transno;
 		lrd->lrd_batch_idx = tsi->tsi_batch_idx;
 	} else if (req != NULL) {
+		lrd->lrd_transno = transno;
 		lrd->lrd_xid = req->rq_xid;
 		trd->trd_tag = lustre_msg_get_tag(req->rq_reqmsg);
 		lrd->lrd_client_gen = ted->ted_lcd->lcd_generation;
@@ -1413,6 +1420,7 @@ int tgt_mk_reply_data(const struct lu_env *env,
 		LASSERT(env != NULL);
 		LASSERT(tsi->tsi_xid != 0);
 
+		lrd->lrd_transno = transno;
 		lrd->lrd_xid = tsi->tsi_xid;
 		lrd->lrd_result = tsi->tsi_result;
 		lrd->lrd_client_gen = tsi->tsi_client_gen;
@@ -1432,7 +1440,12 @@ int tgt_mk_reply_data(const struct lu_env *env,
 	rc = tgt_add_reply_data(env, tgt, ted, trd, req,
 				th, write_update);
 	if (rc < 0) {
-		OBD_FREE_PTR(trd);
+		/* batch reply data already linked for earlier sub requests */
+		if (list_empty(&trd->trd_list)) {
+			if (tsi && tsi->tsi_batch_trd == trd)
+				tsi->tsi_batch_trd = NULL;
+			OBD_FREE_PTR(trd);
+		}
 		if (rc == -EBADR)
 			rc = 0;
 	}
@@ -1472,7 +1485,11 @@ static int tgt_last_rcvd_update(const struct lu_env *env, struct lu_target *tgt,
 	if (ted->ted_lr_idx < 0)
 		nolcd = true;
 
-	if (req != NULL)
+	/* a replayed batched sub request carries its own transno */
+	if (req != NULL && tsi->tsi_batch_pill != NULL)
+		tti->tti_transno =
+			lustre_msg_get_transno(tsi->tsi_batch_pill->rc_reqmsg);
+	else if (req != NULL)
 		tti->tti_transno = lustre_msg_get_transno(req->rq_reqmsg);
 	else
 		/* From update replay, tti_transno should be set already */
@@ -1506,7 +1523,15 @@ static int tgt_last_rcvd_update(const struct lu_env *env, struct lu_target *tgt,
 	CDEBUG(D_INODE, "transno = %llu, last_committed = %llu\n",
 	       tti->tti_transno, tgt->lut_obd->obd_last_committed);
 
-	if (req != NULL) {
+	/*
+	 * Each sub request of a batch returns its transno to be replayed
+	 * with it, the batch RPC is kept until the largest one commits.
+	 */
+	if (req != NULL && tsi->tsi_batch_pill != NULL)
+		lustre_msg_set_transno(tsi->tsi_batch_pill->rc_repmsg,
+				       tti->tti_transno);
+	if (req != NULL &&
+	    !(tsi->tsi_batch_env && tti->tti_transno < req->rq_transno)) {
 		req->rq_transno = tti->tti_transno;
 		lustre_msg_set_transno(req->rq_repmsg, tti->tti_transno);
 	}
@@ -1534,6 +1559,13 @@ static int tgt_last_rcvd_update(const struct lu_env *env, struct lu_target *tgt,
 		RETURN(-EINVAL);
 	}
 
+	/*
+	 * A failed sub request of a batch is not reconstructed, it is
+	 * executed again if the batch is resent, see mdt_batch().
+	 */
+	if (tsi->tsi_batch_env && th->th_result != 0)
+		RETURN(rc);
+
 	/* Target that supports multiple reply data */
 	if (tgt_is_multimodrpcs_client(exp)) {
 		return tgt_mk_reply_data(env, tgt, ted, req, opdata, th,
@@ -785,6 +785,7 @@ static void tgt_ses_key_exit(const struct lu_context *ctx,
 	tsi->tsi_batch_trd = NULL;
 	tsi->tsi_batch_env = false;
 	tsi->tsi_batch_idx = 0;
+	tsi->tsi_batch_pill = NULL;
 }
 
 /* context key: tgt_session_key */
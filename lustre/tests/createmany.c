@@ -32,7 +32,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -51,7 +53,7 @@
 static void usage(const char *prog)
 {
 	printf(
-	       "usage: %s {-o [-k] [-x <size>]|-m|-d|-l<tgt>} [-u[<unlinkfmt>]] [-i mdt_index] [-t seconds] filenamefmt [[start] count]\n",
+	       "usage: %s {-o [-k] [-x <size>]|-m|-d|-l<tgt>} [-u[<unlinkfmt>]] [-B] [-i mdt_index] [-t seconds] filenamefmt [[start] count]\n",
 	       prog);
 	printf("\t-i\tMDT to create the directories on\n"
 	       "\t-l\tlink files to existing <tgt> file\n"
@@ -59,7 +61,8 @@ static void usage(const char *prog)
 	       "\t-o\topen+create files with path and printf format\n"
 	       "\t-k\t    keep files open until all files are opened\n"
 	       "\t-x\t    set an xattr with <size> length on the files\n"
-	       "\t-u\tunlink file/dir (with optional <unlinkfmt>)\n");
+	       "\t-u\tunlink file/dir (with optional <unlinkfmt>)\n"
+	       "\t-B\tbatch the -m, -U, -G and -u operations in few RPCs\n");
 	printf("\t-d\tuse directories instead of regular files\n"
 	       "\t-t\tstop creating files after <seconds> have elapsed\n");
 	printf("\t-S\tthe file size\n"
@@ -84,6 +87,83 @@ static char *get_file_name(const char *fmt, long n, int has_fmt_spec)
 	return filename;
 }
 
+static const char *const batch_opnames[] = {
+	[LU_BATCH_CREATE]	= "create",
+	[LU_BATCH_UNLINK]	= "unlink",
+	[LU_BATCH_SETATTR]	= "setattr",
+};
+
+/* send the queued operations on the names of @dir, stop at the first error */
+static int batch_flush(struct lu_batch_ops *ops, const char *dir)
+{
+	int fd, rc, i;
+
+	if (ops->lbo_count == 0)
+		return 0;
+
+	fd = open(dir, O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
+		printf("open(%s) error: %s\n", dir, strerror(errno));
+		return errno;
+	}
+	rc = llapi_batch_ops(fd, ops);
+	close(fd);
+	if (rc) {
+		printf("llapi_batch_ops(%s) error: %s\n", dir, strerror(-rc));
+		return -rc;
+	}
+
+	for (i = 0; i < ops->lbo_count; i++) {
+		struct lu_batch_entry *lbe = &ops->lbo_entries[i];
+
+		if (lbe->lbe_result) {
+			printf("%s(%s/%s) error: %s\n",
+			       batch_opnames[lbe->lbe_opc], dir, lbe->lbe_name,
+			       strerror(-lbe->lbe_result));
+			return -lbe->lbe_result;
+		}
+	}
+	ops->lbo_count = 0;
+
+	return 0;
+}
+
+/* queue an operation, flush first if @filename is in another directory */
+static struct lu_batch_entry *batch_add(struct lu_batch_ops *ops, char *dir,
+					const char *filename, int opc, int *rc)
+{
+	struct lu_batch_entry *lbe;
+	const char *slash = strrchr(filename, '/');
+	const char *name = slash ? slash + 1 : filename;
+	char path[PATH_MAX] = ".";
+
+	if (strlen(name) > NAME_MAX) {
+		printf("file name too long\n");
+		*rc = ENAMETOOLONG;
+		return NULL;
+	}
+	if (slash)
+		snprintf(path, sizeof(path), "%.*s",
+			 slash == filename ? 1 : (int)(slash - filename),
+			 filename);
+
+	if (strcmp(path, dir) != 0 || ops->lbo_count == LU_BATCH_OPS_MAX) {
+		*rc = batch_flush(ops, dir);
+		if (*rc)
+			return NULL;
+		strcpy(dir, path);
+	}
+
+	lbe = &ops->lbo_entries[ops->lbo_count++];
+	memset(lbe, 0, sizeof(*lbe));
+	lbe->lbe_opc = opc;
+	lbe->lbe_namelen = strlen(name);
+	strcpy(lbe->lbe_name, name);
+	*rc = 0;
+
+	return lbe;
+}
+
 static double now(void)
 {
 	struct timeval tv;
@@ -100,6 +180,10 @@ int main(int argc, char **argv)
 	bool do_chprj = false;
 	bool do_rmdir = false;
 	bool do_xattr = false;
+	bool do_batch = false;
+	struct lu_batch_ops *batch_ops = NULL;
+	struct lu_batch_entry *lbe;
+	char batch_dir[PATH_MAX] = ".";
 	int stripe_pattern = LMV_HASH_TYPE_FNV_1A_64;
 	int stripe_offset = -1, stripe_count = 1;
 	size_t xattr_size = 0;
@@ -132,8 +216,11 @@ int main(int argc, char **argv)
 	else
 		progname = argv[0];
 
-	while ((c = getopt(argc, argv, "i:dG:l:kmor::S:t:u::U:x:")) != -1) {
+	while ((c = getopt(argc, argv, "Bi:dG:l:kmor::S:t:u::U:x:")) != -1) {
 		switch (c) {
+		case 'B':
+			do_batch = true;
+			break;
 		case 'd':
 			do_mkdir = true;
 			break;
@@ -199,7 +286,14 @@ int main(int argc, char **argv)
 		}
 	}
 
-	if (!do_open && (do_setsize || do_chuid || do_chgid || do_chprj)) {
+	if (do_batch && (do_open || do_mkdir || do_link || do_setsize ||
+			 do_chprj)) {
+		fprintf(stderr, "error: -B works only with -m, -u, -U, -G\n");
+		usage(progname);
+	}
+
+	if (!do_open && !(do_batch && do_mknod) &&
+	    (do_setsize || do_chuid || do_chgid || do_chprj)) {
 		fprintf(stderr, "error: -S, -U, -G, -P works only with -o\n");
 		usage(progname);
 	}
@@ -241,12 +335,51 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (do_batch) {
+		batch_ops = malloc(offsetof(struct lu_batch_ops,
+					    lbo_entries[LU_BATCH_OPS_MAX]));
+		if (!batch_ops) {
+			printf("malloc batch error: %s\n", strerror(errno));
+			return errno;
+		}
+		batch_ops->lbo_count = 0;
+	}
+
 	for (i = 0, start = last_t = now(), end += start;
 	     i < count && now() < end; i++, begin++) {
 		double tmp;
 
 		filename = get_file_name(fmt, begin, has_fmt_spec);
-		if (do_open) {
+		if (do_batch) {
+			if (do_mknod) {
+				lbe = batch_add(batch_ops, batch_dir, filename,
+						LU_BATCH_CREATE, &rc);
+				if (!lbe)
+					break;
+				lbe->lbe_mode = 0444;
+			}
+			if (do_chuid || do_chgid) {
+				lbe = batch_add(batch_ops, batch_dir, filename,
+						LU_BATCH_SETATTR, &rc);
+				if (!lbe)
+					break;
+				if (do_chuid)
+					lbe->lbe_valid |= LU_BATCH_SET_UID;
+				if (do_chgid)
+					lbe->lbe_valid |= LU_BATCH_SET_GID;
+				lbe->lbe_uid = uid + i;
+				lbe->lbe_gid = gid + i;
+			}
+			if (do_unlink) {
+				if (fmt_unlink != NULL)
+					filename = get_file_name(fmt_unlink,
+						begin, unlink_has_fmt_spec);
+				lbe = batch_add(batch_ops, batch_dir, filename,
+						LU_BATCH_UNLINK, &rc);
+				if (!lbe)
+					break;
+			}
+		} else if (do_open) {
 			int fd;
 
 			fd = open(filename, O_CREAT|O_RDWR, 0644);
@@ -360,7 +493,7 @@ int main(int argc, char **argv)
 				break;
 			}
 		}
-		if (do_unlink) {
+		if (do_unlink && !do_batch) {
 			if (fmt_unlink != NULL)
 				filename = get_file_name(fmt_unlink, begin,
 							 unlink_has_fmt_spec);
@@ -393,6 +526,11 @@ int main(int argc, char **argv)
 			last_i = i;
 		}
 	}
+	if (do_batch) {
+		if (!rc)
+			rc = batch_flush(batch_ops, batch_dir);
+		free(batch_ops);
+	}
 	last_t = now();
 	total = i;
 	printf("total: %ld %s%s in %.2f seconds: %.2f ops/second\n", total,
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * The purpose of this test is to check the changelog batch API: records
+ * received with llapi_changelog_recv_batch() must be contiguous even when
+ * they span several reads of the changelog device, and acknowledgements
+ * given to llapi_changelog_clear_batch() must all be cleared once
+ * llapi_changelog_fini() returns.
+ *
+ * The index of the last record received is printed on stdout.
+ *
+ * The program will exit as soon as a non zero error code is returned.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#include <lustre/lustreapi.h>
+
+#define ERROR(fmt, ...)							\
+	fprintf(stderr, "%s: %s:%d: %s: " fmt "\n",			\
+		program_invocation_short_name, __FILE__, __LINE__,	\
+		__func__, ## __VA_ARGS__)
+
+#define DIE(fmt, ...)							\
+	do {								\
+		ERROR(fmt, ## __VA_ARGS__);				\
+		exit(EXIT_FAILURE);					\
+	} while (0)
+
+#define ASSERTF(cond, fmt, ...)						\
+	do {								\
+		if (!(cond))						\
+			DIE("assertion '%s' failed: "fmt,		\
+			    #cond, ## __VA_ARGS__);			\
+	} while (0)
+
+#define RECS_PER_BATCH	64
+
+static void usage(char *prog)
+{
+	printf("Usage: %s <mdtname> <changelog user>\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	struct changelog_rec *recs[RECS_PER_BATCH];
+	long long last = -1;
+	long long nr = 0;
+	void *priv;
+	int rc;
+	int n;
+	int i;
+
+	if (argc != 3)
+		usage(argv[0]);
+
+	rc = llapi_changelog_start(&priv, CHANGELOG_FLAG_JOBID |
+				   CHANGELOG_FLAG_EXTRA_FLAGS, argv[1], 0);
+	ASSERTF(rc == 0, "cannot start changelog on '%s': %s",
+		argv[1], strerror(-rc));
+
+	rc = llapi_changelog_set_xflags(priv, CHANGELOG_EXTRA_FLAG_UIDGID |
+					CHANGELOG_EXTRA_FLAG_NID |
+					CHANGELOG_EXTRA_FLAG_OMODE |
+					CHANGELOG_EXTRA_FLAG_XATTR);
+	ASSERTF(rc == 0, "cannot set extra flags: %s", strerror(-rc));
+
+	while ((n = llapi_changelog_recv_batch(priv, recs,
+					       RECS_PER_BATCH)) > 0) {
+		for (i = 0; i < n; i++) {
+			long long index = recs[i]->cr_index;
+
+			/* a record cut by a short read would leave a hole */
+			ASSERTF(last < 0 || index == last + 1,
+				"record %lld received after %lld", index, last);
+			last = index;
+			nr++;
+
+			rc = llapi_changelog_clear_batch(priv, argv[2], index);
+			ASSERTF(rc == 0, "cannot clear record %lld: %s",
+				index, strerror(-rc));
+		}
+	}
+	ASSERTF(n == 0, "cannot receive records: %s", strerror(-n));
+
+	/* flushes the acknowledgements not cleared yet */
+	rc = llapi_changelog_fini(&priv);
+	ASSERTF(rc == 0, "cannot stop changelog: %s", strerror(-rc));
+
+	fprintf(stderr, "%lld records received\n", nr);
+	printf("%lld\n", last);
+
+	return EXIT_SUCCESS;
+}
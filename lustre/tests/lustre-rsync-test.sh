@@ -679,6 +679,46 @@ test_9() {
 }
 run_test 9 "Replicate recursive directory removal"
 
+# Test 10 - Replicate file data with parallel copy workers
+test_10() {
+	local LRSYNC_LOG=$(generate_logname "lrsync_log")
+	local i
+
+	init_src
+	init_changelog
+
+	for i in {1..16}; do
+		dd if=/dev/urandom of=$DIR/$tdir/file$i bs=64k count=$i \
+			status=none || error "write file$i failed"
+	done
+	dd if=/dev/urandom of=$DIR/$tdir/large bs=1M count=24 status=none ||
+		error "write large failed"
+
+	$LRSYNC -s $DIR -t $TGT -t $TGT2 -m $MDT0 -u $CL_USER -l $LREPL_LOG \
+		-D $LRSYNC_LOG -w 4 || error "replication #1 failed"
+	check_diff $DIR/$tdir $TGT/$tdir
+	check_diff $DIR/$tdir $TGT2/$tdir
+
+	# rewrite part of the large file, which only updates changed blocks
+	dd if=/dev/urandom of=$DIR/$tdir/large bs=4k count=3 seek=1000 \
+		conv=notrunc status=none || error "rewrite large failed"
+	$TRUNCATE $DIR/$tdir/large $((20 << 20)) || error "truncate failed"
+	for i in {1..16}; do
+		echo "append $i" >> $DIR/$tdir/file$i
+	done
+	mv $DIR/$tdir/file1 $DIR/$tdir/file1.new
+
+	$LRSYNC -l $LREPL_LOG -D $LRSYNC_LOG -w 4 ||
+		error "replication #2 failed"
+	check_diff $DIR/$tdir $TGT/$tdir
+	check_diff $DIR/$tdir $TGT2/$tdir
+
+	fini_changelog
+	cleanup_src_tgt
+	return 0
+}
+run_test 10 "Replicate file data with parallel copy workers"
+
 cd $ORIG_PWD
 complete_test $SECONDS
 check_and_cleanup_lustre
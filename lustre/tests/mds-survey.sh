@@ -92,12 +92,14 @@ get_targets() {
 mds_survey_run() {
 	local layer=${1:-mdd}
 	local stripe_count=${2:-0}
+	local changelog=${3:-no}
 	local rc=0
 
 	rm -f ${TMP}/mds_survey*
 
 	local cmd="file_count=$file_count thrlo=$thrlo thrhi=$thrhi"
 	cmd+=" dir_count=$dir_count layer=$layer stripe_count=$stripe_count"
+	cmd+=" changelog=$changelog"
 	cmd+=" rslt_loc=${TMP} targets=\"$(get_targets)\" $MDSSURVEY"
 
 	trap cleanup_echo_devs EXIT ERR
@@ -122,6 +124,11 @@ test_2() {
 }
 run_test 2 "Metadata survey with stripe_count = 1"
 
+test_3() {
+	mds_survey_run "mdd" "0" "both"
+}
+run_test 3 "Metadata survey without and with changelogs"
+
 # remount the clients
 restore_mount $MOUNT
 
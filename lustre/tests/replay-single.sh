@@ -5180,6 +5180,35 @@ test_137c() {
 }
 run_test 137c "DNE: create under striped dir, fail MDT1/MDT2"
 
+test_138() {
+	local count=100
+	local before=$TMP/$tfile.before
+	local after=$TMP/$tfile.after
+
+	$LCTL get_param -n mdc.*.connect_flags | grep -q batch_reint ||
+		skip "MDS does not support batched create/unlink/setattr"
+	[[ $(getenforce) == "Disabled" ]] ||
+		skip "files labelled by SELinux are not created in batches"
+
+	mkdir_on_mdt0 $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	# stops the first batch, the next files are sent in another one
+	touch $DIR/$tdir/f5 || error "touch $DIR/$tdir/f5 failed"
+	stack_trap "rm -f $before $after"
+
+	replay_barrier $SINGLEMDS
+	createmany -B -m $DIR/$tdir/f $count &&
+		error "batched create of existing $DIR/$tdir/f5 succeeded"
+	$LFS path2fid $DIR/$tdir/* > $before
+	fail $SINGLEMDS
+
+	# each file is replayed once, by the batch that created it
+	$LFS path2fid $DIR/$tdir/* > $after
+	diff $before $after || error "files changed by the replay"
+	(( $(ls $DIR/$tdir | wc -l) == count )) ||
+		error "$(ls $DIR/$tdir | wc -l) files replayed, expect $count"
+}
+run_test 138 "replay batches stopped by a failed create"
+
 test_200() {
 	[[ -z $RCLIENTS ]] && skip "Need remote client"
 
@@ -5381,6 +5410,33 @@ test_202() {
 }
 run_test 202 "pfl replay should recovery layout generation"
 
+test_203() {
+	local count=200
+
+	$LCTL get_param -n mdc.*.connect_flags | grep -q batch_reint ||
+		skip "MDS does not support batched create/unlink/setattr"
+	[[ $(getenforce) == "Disabled" ]] ||
+		skip "files labelled by SELinux are not created in batches"
+
+	mkdir_on_mdt0 $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	createmany -B -m $DIR/$tdir/f $count || error "batched create failed"
+	sync
+
+	# each batched sub request is replayed at its own transno
+	replay_barrier $SINGLEMDS
+	createmany -B -u $DIR/$tdir/f $((count / 2)) ||
+		error "batched unlink failed"
+	createmany -B -m $DIR/$tdir/g $count || error "batched create failed"
+	fail $SINGLEMDS
+
+	(( $(ls $DIR/$tdir | grep -c "^f") == count / 2 )) ||
+		error "$(ls $DIR/$tdir | grep -c "^f") f files after replay"
+	(( $(ls $DIR/$tdir | grep -c "^g") == count )) ||
+		error "$(ls $DIR/$tdir | grep -c "^g") g files after replay"
+	createmany -B -u $DIR/$tdir/g $count || error "batched unlink failed"
+}
+run_test 203 "replay of batched create and unlink"
+
 
 complete_test $SECONDS
 check_and_cleanup_lustre
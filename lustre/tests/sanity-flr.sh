@@ -4587,6 +4587,88 @@ test_211() {
 }
 run_test 211 "mirror delete should not cause bad size"
 
+test_212() {
+	(( OSTCOUNT >= 3 )) || skip "needs >= 3 OSTs"
+
+	local tf=$DIR/$tfile
+	local tmp=$TMP/$tfile
+
+	stack_trap "rm -f $tf $tmp $tmp.rebuilt"
+	$LFS setstripe -c 2 -S 1M --parity-count 1 $tf ||
+		error "cannot create erasure coded '$tf'"
+	$LFS getstripe -v $tf
+	(( $($LFS getstripe -N $tf) == 2 )) || error "no parity mirror"
+	$LFS getstripe -v $tf | grep -q "lcme_cstripe_count: *1" ||
+		error "no erasure code geometry on '$tf'"
+
+	dd if=/dev/urandom of=$tmp bs=1M count=5 || error "dd $tmp failed"
+	cp $tmp $tf || error "cp to '$tf' failed"
+	$LFS getstripe $tf | grep -q stale || error "parity is not stale"
+
+	$LFS mirror resync $tf || error "cannot resync '$tf'"
+	$LFS getstripe $tf | grep -q stale && error "parity is still stale"
+	(( $(stat -c %s $tf) == $(stat -c %s $tmp) )) ||
+		error "size of '$tf' changed by the parity resync"
+	cmp $tmp $tf || error "data of '$tf' changed by the parity resync"
+
+	# lose the OST of the second data stripe, rebuild it from the parity
+	local ost=$($LFS getstripe --mirror-id=1 -v $tf |
+		    awk '/l_ost_idx/ { print $5 }' | sed -n -e 's/,//' -e 2p)
+	local osc=$(printf "osc.$FSNAME-OST%04x-osc-[^M]*" $ost)
+
+	cancel_lru_locks osc
+	$LCTL set_param $osc.active=0
+	stack_trap "$LCTL set_param $osc.active=1"
+	$LFS mirror read -N 1 -o $tmp.rebuilt $tf ||
+		error "cannot read mirror 1 of '$tf' without OST $ost"
+	cmp $tmp $tmp.rebuilt || error "rebuilt data of '$tf' is wrong"
+	cmp $tmp $tf || error "data of '$tf' is wrong without OST $ost"
+}
+run_test 212 "erasure coded file parity resync and rebuild"
+
+test_213() {
+	(( OSTCOUNT >= 3 )) || skip "needs >= 3 OSTs"
+
+	local tf=$DIR/$tfile
+	local tmp=$TMP/$tfile
+
+	stack_trap "rm -f $tf $tmp $tmp.new $tmp.rebuilt"
+	$LFS setstripe -c 2 -S 1M --parity-count 1 $tf ||
+		error "cannot create erasure coded '$tf'"
+	dd if=/dev/urandom of=$tmp bs=1M count=5 || error "dd $tmp failed"
+	cp $tmp $tf || error "cp to '$tf' failed"
+	$LFS mirror resync $tf || error "cannot resync '$tf'"
+
+	# partial stripe overwrite, and an append past the last stripe row
+	dd if=/dev/urandom of=$tmp.new bs=64K count=24 ||
+		error "dd $tmp.new failed"
+	dd if=$tmp.new of=$tmp bs=64K seek=20 conv=notrunc ||
+		error "dd to $tmp failed"
+	dd if=$tmp.new of=$tf bs=64K seek=20 oflag=direct conv=notrunc ||
+		error "direct write to '$tf' failed"
+	dd if=$tmp.new of=$tf bs=64K seek=80 oflag=direct conv=notrunc ||
+		error "direct append to '$tf' failed"
+	cat $tmp.new >> $tmp
+
+	$LFS getstripe $tf | grep -q stale && error "parity is stale"
+	(( $(stat -c %s $tf) == $(stat -c %s $tmp) )) ||
+		error "size of '$tf' is wrong after direct write"
+	cmp $tmp $tf || error "data of '$tf' is wrong after direct write"
+
+	# the updated parity must rebuild the second data stripe
+	local ost=$($LFS getstripe --mirror-id=1 -v $tf |
+		    awk '/l_ost_idx/ { print $5 }' | sed -n -e 's/,//' -e 2p)
+	local osc=$(printf "osc.$FSNAME-OST%04x-osc-[^M]*" $ost)
+
+	cancel_lru_locks osc
+	$LCTL set_param $osc.active=0
+	stack_trap "$LCTL set_param $osc.active=1"
+	$LFS mirror read -N 1 -o $tmp.rebuilt $tf ||
+		error "cannot read mirror 1 of '$tf' without OST $ost"
+	cmp $tmp $tmp.rebuilt || error "rebuilt data of '$tf' is wrong"
+}
+run_test 213 "erasure coded file parity update on direct write"
+
 complete_test $SECONDS
 check_and_cleanup_lustre
 exit_status
@@ -1560,6 +1560,36 @@ test_13() {
 }
 run_test 13 "Recursively import and restore a directory"
 
+test_13b() {
+	local -i i j l k=0
+	for i in {1..4}; do
+		for j in {1..4}; do
+			local archive_dir="$(hsm_root)"/subdir/dir.$i/dir.$j
+
+			do_facet $SINGLEAGT mkdir -p "$archive_dir"
+			for l in {1..4}; do
+				do_facet $SINGLEAGT \
+					"echo $k > \"$archive_dir\"/file.$l"
+				k+=1
+			done
+		done
+	done
+
+	# import to Lustre with several threads scanning the archive
+	copytool import --threads=4 "subdir" "$DIR/$tdir"
+
+	local count=$(find "$DIR/$tdir"/subdir -type f | wc -l)
+	(( count == 64 )) || error "imported $count files, expected 64"
+
+	copytool setup
+	find "$DIR/$tdir"/subdir -type f -exec $LFS hsm_restore {} \;
+
+	do_facet $SINGLEAGT \
+		diff -r "$(hsm_root)"/subdir "$DIR/$tdir"/subdir ||
+		error "imported files differ from archived data"
+}
+run_test 13b "Recursively import a directory with parallel scanning"
+
 test_14() {
 	# test needs a running copytool
 	copytool setup
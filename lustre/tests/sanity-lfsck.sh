@@ -6346,6 +6346,114 @@ test_44() {
 }
 run_test 44 "umount while lfsck is stopping"
 
+test_45() {
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "MDS older than 2.16.51"
+
+	local threads
+	local repaired
+	local handled
+	local i
+
+	check_mount_and_prep
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	for ((i = 0; i < 50; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/f$i bs=4k count=1 2>/dev/null ||
+			error "(0) Fail to write $DIR/$tdir/f$i"
+	done
+	cancel_lru_locks osc
+
+	threads=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		  mdd.${MDT_DEV}.lfsck_assistant_threads)
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param \
+		mdd.${MDT_DEV}.lfsck_assistant_threads=$threads"
+	do_facet $SINGLEMDS $LCTL set_param \
+		mdd.${MDT_DEV}.lfsck_assistant_threads=4 ||
+		error "(1) Fail to set lfsck_assistant_threads"
+
+	echo "Inject failure stub to skip OST-object owner changing"
+	#define OBD_FAIL_LFSCK_BAD_OWNER	0x1613
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x1613
+	chown 1.1 $DIR/$tdir/f*
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+
+	echo "Trigger layout LFSCK with 4 assistant threads"
+	$START_LAYOUT -r || error "(2) Fail to start LFSCK for layout!"
+
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_layout |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_LAYOUT
+		error "(3) unexpected status"
+	}
+
+	repaired=$($SHOW_LAYOUT |
+		   awk '/^repaired_inconsistent_owner/ { print $2 }')
+	(( repaired == 50 )) ||
+		error "(4) Fail to repair inconsistent owner: $repaired"
+
+	handled=$($SHOW_LAYOUT |
+		  awk '/^assistant_helper_handled/ { print $2 }')
+	(( handled > 0 )) ||
+		error "(5) No request handled by the helpers: $handled"
+}
+run_test 45 "layout LFSCK with several assistant threads"
+
+test_46() {
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "MDS older than 2.16.51"
+
+	local threads
+	local repaired
+	local handled
+	local i
+
+	check_mount_and_prep
+
+	threads=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		  mdd.${MDT_DEV}.lfsck_assistant_threads)
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param \
+		mdd.${MDT_DEV}.lfsck_assistant_threads=$threads"
+	do_facet $SINGLEMDS $LCTL set_param \
+		mdd.${MDT_DEV}.lfsck_assistant_threads=4 ||
+		error "(1) Fail to set lfsck_assistant_threads"
+
+	echo "Inject failure stub to make the linkEA crashed"
+	#define OBD_FAIL_LFSCK_LINKEA_CRASH	0x1603
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x1603
+	for ((i = 0; i < 50; i++)); do
+		touch $DIR/$tdir/f$i ||
+			error "(2) Fail to touch $DIR/$tdir/f$i"
+	done
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+
+	echo "Trigger namespace LFSCK with 4 assistant threads"
+	$START_NAMESPACE -r || error "(3) Fail to start LFSCK for namespace!"
+
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_namespace |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_NAMESPACE
+		error "(4) unexpected status"
+	}
+
+	repaired=$($SHOW_NAMESPACE |
+		   awk '/^linkea_repaired/ { print $2 }')
+	(( repaired == 50 )) ||
+		error "(5) Fail to repair crashed linkEA: $repaired"
+
+	handled=$($SHOW_NAMESPACE |
+		  awk '/^assistant_helper_handled/ { print $2 }')
+	(( handled > 0 )) ||
+		error "(6) No request handled by the helpers: $handled"
+
+	for ((i = 0; i < 50; i++)); do
+		stat $DIR/$tdir/f$i | grep -q "Links: 1" ||
+			error "(7) Fail to stat $DIR/$tdir/f$i"
+	done
+}
+run_test 46 "namespace LFSCK with several assistant threads"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
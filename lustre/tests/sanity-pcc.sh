@@ -3825,6 +3825,64 @@ test_48() {
 }
 run_test 48 "PCC state should check whether the file in local PCC cache"
 
+test_49() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local file=$DIR/$tdir/$tfile
+	local count=8
+	local i
+
+	$LCTL get_param -n mdc.*.connect_flags | grep -q pcc_ro ||
+		skip "Server does not support PCC-RO"
+
+	setup_loopdev client $loopfile $mntpt 120
+	mkdir $hsm_root || error "mkdir $hsm_root failed"
+	setup_pcc_mapping client \
+		"projid={0}\ roid=$HSM_ARCHIVE_NUMBER\ ropcc=1\ prio=3"
+	$LCTL pcc list $MOUNT
+	$LCTL pcc list $MOUNT | grep -q "prio: 3" ||
+		error "dataset priority is not 3"
+
+	local thresh=$($LCTL get_param -n llite.*.pcc_async_threshold |
+		       head -n 1)
+	local workers=$($LCTL get_param -n llite.*.pcc_async_workers |
+			head -n 1)
+
+	stack_trap "$LCTL set_param llite.*.pcc_async_threshold=$thresh"
+	stack_trap "$LCTL set_param llite.*.pcc_async_workers=$workers"
+	$LCTL set_param llite.*.pcc_async_threshold=0
+	$LCTL set_param llite.*.pcc_async_workers=2
+	$LCTL set_param llite.*.pcc_async_workers=0 &&
+		error "pcc_async_workers=0 should fail"
+
+	mkdir $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	for ((i = 0; i < count; i++)); do
+		dd if=/dev/zero of=$file.$i bs=1M count=4 ||
+			error "Write $file.$i failed"
+	done
+
+	# Open with O_RDONLY flag queues the attach of all files at once
+	for ((i = 0; i < count; i++)); do
+		$MULTIOP $file.$i oc || error "failed to readonly open $file.$i"
+	done
+	for ((i = 0; i < count; i++)); do
+		wait_readonly_attach_fini $file.$i client
+	done
+
+	local stats=$($LCTL pcc list $MOUNT | grep -A6 "stats:")
+	local files=$(awk '/files:/ { print $2 }' <<< "$stats")
+	local bytes=$(awk '/bytes:/ { print $2 }' <<< "$stats")
+	local queued=$(awk '/queued:/ { print $2 }' <<< "$stats")
+
+	echo "$stats"
+	(( files >= count )) || error "attached $files files < $count"
+	(( bytes >= count * 4 * 1048576 )) ||
+		error "attached $bytes bytes < $((count * 4))MB"
+	(( queued == 0 )) || error "$queued attach requests still queued"
+}
+run_test 49 "Asynchronous attach with a pool of workers and dataset stats"
+
 test_96() {
 	local loopfile="$TMP/$tfile"
 	local mntpt="/mnt/pcc.$tdir"
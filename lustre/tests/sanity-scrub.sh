@@ -1550,6 +1550,82 @@ test_22() {
 }
 run_test 22 "LFSCK can recreate or fix the LASTID on MDT/OST"
 
+test_23() {
+	[ "$mds1_FSTYPE" != "ldiskfs" ] &&
+		skip "ldiskfs special test"
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "MDS older than 2.16.51"
+
+	scrub_prep 1000 1
+	echo "start MDTs with OI scrub disabled"
+	scrub_start_mds 2 "$MOUNT_OPTS_NOSCRUB"
+	scrub_check_flags 3 recreated,inconsistent
+
+	local threads=$(do_facet mds1 $LCTL get_param -n \
+			osd-ldiskfs.$(facet_svc mds1).scrub_threads)
+	local ra_groups=$(do_facet mds1 $LCTL get_param -n \
+			  osd-ldiskfs.$(facet_svc mds1).scrub_ra_groups)
+
+	stack_trap "do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param -n \
+		osd-ldiskfs.*.scrub_threads=$threads \
+		osd-ldiskfs.*.scrub_ra_groups=$ra_groups"
+	do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param -n \
+		osd-ldiskfs.*.scrub_threads=4 osd-ldiskfs.*.scrub_ra_groups=8 ||
+		error "(4) Fail to set scrub_threads"
+
+	scrub_start 5
+	scrub_check_status 6 completed
+	scrub_check_flags 7 ""
+	scrub_check_repaired 8 1000 0
+
+	mount_client $MOUNT || error "(9) Fail to start client!"
+	scrub_check_data 10
+}
+run_test 23 "OI scrub with several threads for backup/restore case"
+
+test_24() {
+	[ "$mds1_FSTYPE" != "ldiskfs" ] &&
+		skip "ldiskfs special test"
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "MDS older than 2.16.51"
+
+	scrub_prep 1000 1
+	echo "start MDTs with OI scrub disabled"
+	scrub_start_mds 2 "$MOUNT_OPTS_NOSCRUB"
+	scrub_check_flags 3 recreated,inconsistent
+
+	local threads=$(do_facet mds1 $LCTL get_param -n \
+			osd-ldiskfs.$(facet_svc mds1).scrub_threads)
+
+	stack_trap "do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param -n \
+		osd-ldiskfs.*.scrub_threads=$threads"
+	do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param -n \
+		osd-ldiskfs.*.scrub_threads=4 ||
+		error "(4) Fail to set scrub_threads"
+
+	#define OBD_FAIL_OSD_SCRUB_DELAY	 0x190
+	do_nodes $(comma_list $(mdts_nodes)) \
+		$LCTL set_param fail_val=3 fail_loc=0x190
+
+	scrub_start 5
+	scrub_check_status 6 scanning
+
+	#define OBD_FAIL_OSD_SCRUB_FATAL	 0x192
+	do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param fail_loc=0x192
+	scrub_check_status 7 failed
+
+	do_nodes $(comma_list $(mdts_nodes)) \
+		$LCTL set_param fail_loc=0 fail_val=0
+
+	scrub_start 8
+	scrub_check_status 9 completed
+	scrub_check_flags 10 ""
+
+	mount_client $MOUNT || error "(11) Fail to start client!"
+	scrub_check_data 12
+}
+run_test 24 "OI scrub with several threads honours the fail points"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
@@ -3628,6 +3628,96 @@ test_27W() {
 }
 run_test 27W "test enable_setstripe_gid"
 
+test_27X() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "Need MDS version at least 2.16.51"
+
+	local param="osp.$FSNAME-OST0000-osc-MDT0000.precreate_stats"
+	local stats
+	local rate
+
+	do_facet mds1 $LCTL set_param $param=clear ||
+		error "cannot clear $param"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	$LFS setstripe -i 0 -c 1 $DIR/$tdir || error "setstripe failed"
+	createmany -o $DIR/$tdir/$tfile- 1000 || error "createmany failed"
+	# the rate of a second is accounted once the next second starts
+	sleep 2
+	touch $DIR/$tdir/$tfile || error "touch failed"
+
+	stats=$(do_facet mds1 $LCTL get_param -n $param)
+	echo "$stats"
+	rate=$(awk '/^create_rate:/ { print $2 }' <<< "$stats")
+	(( rate > 0 )) || error "create_rate '$rate' is not accounted"
+	grep -q "^forecast:" <<< "$stats" || error "no forecast in $param"
+}
+run_test 27X "OSP create rate forecast and precreate stats"
+
+test_27Y() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	(( $MDS1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "Need MDS version at least 2.16.51"
+
+	local osp="osp.$FSNAME-OST0000-osc-MDT0000"
+	local stats="obdfilter.$FSNAME-OST0000.stats"
+	local saved
+	local nr=200
+	local before
+	local batch
+	local rpcs
+
+	do_facet mds1 $LCTL get_param -n $osp.connect_flags |
+		grep -q sync_batch || skip "OST0000 without sync_batch"
+
+	saved=$(do_facet mds1 $LCTL get_param -n $osp.max_sync_batch)
+	stack_trap "do_facet mds1 $LCTL set_param $osp.max_sync_batch=$saved"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	$LFS setstripe -i 0 -c 1 $DIR/$tdir || error "setstripe failed"
+
+	# one OST_SETATTR and OST_DESTROY RPC per record without batching
+	for batch in $saved 1; do
+		do_facet mds1 $LCTL set_param $osp.max_sync_batch=$batch
+		createmany -o $DIR/$tdir/$tfile- $nr ||
+			error "createmany failed"
+		sync
+		wait_delete_completed
+
+		before=$(do_facet ost1 $LCTL get_param -n $stats |
+			 awk '/^setattr/ { print $2 }')
+		chown $RUNAS_ID $DIR/$tdir/$tfile-* || error "chown failed"
+		sync
+		wait_delete_completed
+		rpcs=$(do_facet ost1 $LCTL get_param -n $stats |
+		       awk '/^setattr/ { print $2 }')
+		rpcs=$((rpcs - ${before:-0}))
+		echo "max_sync_batch=$batch: $rpcs setattr RPCs for $nr objects"
+		if (( batch == 1 )); then
+			(( rpcs >= nr )) || error "$rpcs setattr, expect $nr"
+		else
+			(( rpcs < nr / 2 )) || error "$rpcs setattr not batched"
+		fi
+
+		before=$(do_facet ost1 $LCTL get_param -n $stats |
+			 awk '/^destroy/ { print $2 }')
+		unlinkmany $DIR/$tdir/$tfile- $nr || error "unlinkmany failed"
+		wait_delete_completed
+		rpcs=$(do_facet ost1 $LCTL get_param -n $stats |
+		       awk '/^destroy/ { print $2 }')
+		rpcs=$((rpcs - ${before:-0}))
+		echo "max_sync_batch=$batch: $rpcs destroy RPCs for $nr objects"
+		if (( batch == 1 )); then
+			(( rpcs >= nr )) || error "$rpcs destroy, expect $nr"
+		else
+			(( rpcs < nr / 2 )) || error "$rpcs destroy not batched"
+		fi
+	done
+}
+run_test 27Y "OSP sync sends multi-object destroy and setattr RPCs"
+
 # createtest also checks that device nodes are created and
 # then visible correctly (#2091)
 test_28() { # bug 2091
@@ -8919,6 +9009,48 @@ test_56xl() {
 }
 run_test 56xl "lfs mirror resync stats support"
 
+test_56xm() {
+	(( $OSTCOUNT >= 2 )) || skip "needs >= 2 OSTs"
+
+	local stripes=$((OSTCOUNT < 4 ? OSTCOUNT : 4))
+	local file1=$DIR/$tfile
+	local file2=$DIR/$tfile.sparse
+	local tmp1=$TMP/$tfile.tmp
+
+	stack_trap "rm -f $file1 $file2 $tmp1"
+	dd if=/dev/urandom of=$tmp1 bs=1M count=70 status=none ||
+		error "error creating $tmp1"
+	# unaligned tail to check the short read at EOF
+	echo "tail" >> $tmp1
+
+	# one copy stream per source stripe
+	$LFS setstripe -c $stripes -S 1M $file1 || error "setstripe failed"
+	cp $tmp1 $file1 || error "cp to $file1 failed"
+	$LFS migrate -c 1 $file1 || error "migrate $file1 failed"
+	cmp $file1 $tmp1 || error "$file1 differs after migrate"
+
+	$LFS setstripe -c $stripes -S 1M $file2 || error "setstripe failed"
+	dd if=$tmp1 of=$file2 bs=1M count=3 status=none ||
+		error "write $file2 failed"
+	dd if=$tmp1 of=$file2 bs=1M count=5 seek=40 skip=40 conv=notrunc \
+		status=none || error "write $file2 failed"
+	$TRUNCATE $file2 $((80 << 20)) || error "truncate $file2 failed"
+	cp --sparse=always $file2 $tmp1 || error "cp $file2 failed"
+	$LFS migrate -c $stripes $file2 || error "migrate $file2 failed"
+	cmp $file2 $tmp1 || error "$file2 differs after migrate"
+
+	# the resync copies the same chunks to the stale mirror
+	$LFS mirror extend -N -c $stripes $file1 || error "can't mirror"
+	dd if=/dev/urandom of=$file1 bs=1M count=9 seek=1 conv=notrunc \
+		status=none || error "can't dd"
+	cp $file1 $tmp1 || error "cp $file1 failed"
+	$LFS mirror resync $file1 || error "resync failed"
+	$LFS getstripe $file1 | grep stale && error "mirror is still stale"
+	$LFS mirror verify $file1 || error "mirrors differ after resync"
+	cmp $file1 $tmp1 || error "$file1 differs after resync"
+}
+run_test 56xm "lfs migrate and mirror resync with multiple copy streams"
+
 test_56y() {
 	[ $MDS1_VERSION -lt $(version_code 2.4.53) ] &&
 		skip "No HSM $(lustre_build_version $SINGLEMDS) MDS < 2.4.53"
@@ -9803,6 +9935,40 @@ test_56ej() {
 }
 run_test 56ej "lfs migration --non-block copy"
 
+test_56ek() {
+	local dir=$DIR/$tdir
+	local i
+
+	test_mkdir $dir
+	for i in $(seq $MDSCOUNT); do
+		$LFS mkdir -c $MDSCOUNT $dir/striped$i ||
+			error "mkdir $dir/striped$i failed"
+		mkdir -p $dir/striped$i/sub{1..4}/subsub{1..3} ||
+			error "mkdir under $dir/striped$i failed"
+		createmany -o $dir/striped$i/sub1/f 50 ||
+			error "create files under $dir/striped$i failed"
+		touch $dir/striped$i/sub{1..4}/subsub{1..3}/file
+	done
+
+	local serial=$($LFS find $dir)
+
+	[[ "$($LFS find --threads 8 --ordered $dir)" == "$serial" ]] ||
+		error "--threads --ordered output differs from serial"
+	[[ "$($LFS find --threads 8 $dir | sort)" == \
+	   "$(echo "$serial" | sort)" ]] ||
+		error "--threads output differs from serial"
+	(( $($LFS find --threads 4 --maxdepth 2 --type d $dir | wc -l) ==
+	   $($LFS find --maxdepth 2 --type d $dir | wc -l) )) ||
+		error "--threads --maxdepth found a different count"
+	(( $($LFS find --threads 4 --name 'f*' $dir | wc -l) ==
+	   50 * MDSCOUNT )) || error "--threads --name found a wrong count"
+
+	$LFS find --threads 0 $dir && error "--threads 0 should fail"
+	$LFS find --threads 257 $dir && error "--threads 257 should fail"
+	return 0
+}
+run_test 56ek "lfs find --threads and --ordered"
+
 test_57a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	# note test will not do anything if MDS is not local
@@ -20231,6 +20397,29 @@ test_160u() { # LU-17400
 }
 run_test 160u "changelog rename record type name and sname strings are correct"
 
+test_160v() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	which llapi_changelog_test || skip_env "no llapi_changelog_test"
+
+	changelog_register || error "changelog_register failed"
+	local cl_user="${CL_USERS[mds1]%% *}"
+
+	# long names so that records span the changelog device reads
+	local name=$(str_repeat f 200)
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	createmany -o $DIR/$tdir/$name 5000 ||
+		error "create $DIR/$tdir/$name failed"
+
+	local last=$(llapi_changelog_test $(facet_svc mds1) $cl_user) ||
+		error "llapi_changelog_test failed"
+	local rec=$(changelog_user_rec mds1 $cl_user)
+
+	echo "last record read $last, $cl_user cleared to $rec"
+	(( rec == last )) || error "$cl_user cleared to $rec, not $last"
+}
+run_test 160v "changelog batch read and clear"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -20940,6 +21129,49 @@ test_165g() {
 }
 run_test 165g "ofd_access_log_reader --keepalive works"
 
+test_165h() {
+	local trace="/tmp/${tfile}.trace"
+	local file="${DIR}/${tfile}"
+	local rc
+
+	do_facet ost1 ofd_access_log_reader --help | grep -q mmap ||
+		skip "ofd_access_log_reader --mmap unsupported"
+
+	setup_165
+	do_facet ost1 ofd_access_log_reader --mmap --wakeup-count=4 \
+		--debug=- --trace=- > "${trace}" &
+	sleep 5
+
+	lfs setstripe -c 1 -i 0 "${file}"
+	$MULTIOP "${file}" oO_CREAT:O_DIRECT:O_WRONLY:w1048576c ||
+		error "cannot create '${file}'"
+	$MULTIOP "${file}" oO_CREAT:O_DIRECT:O_RDONLY:r524288c ||
+		error "cannot read '${file}'"
+
+	# fewer entries than the wakeup count, consumed by the periodic flush
+	sleep 5
+	do_facet ost1 killall -TERM ofd_access_log_reader
+	wait
+	rc=$?
+
+	if ((rc != 0)); then
+		error "ofd_access_log_reader exited with rc = '${rc}'"
+	fi
+
+	oalr_expect_event_count alr_log_entry "${trace}" 2
+}
+run_test 165h "ofd_access_log_reader --mmap consumes entries in place"
+
+test_165i() {
+	do_facet ost1 ofd_access_log_reader --help | grep -q bench ||
+		skip "ofd_access_log_reader --bench unsupported"
+
+	setup_165
+	do_facet ost1 ofd_access_log_reader --bench=100000 ||
+		error "ofd_access_log_reader --bench failed"
+}
+run_test 165i "compare ofd access log read() and mmap() consumers"
+
 test_169() {
 	# do directio so as not to populate the page cache
 	log "creating a 10 Mb file"
@@ -21014,6 +21246,36 @@ test_170() {
 }
 run_test 170 "test lctl df to handle corrupted log ====================="
 
+test_170b() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	local log=$TMP/${tfile}_log
+	local start=$(date +%s)
+
+	$LCTL clear
+	$LCTL debug_daemon start $log 10 --compress --files 2 ||
+		skip "compressed debug daemon not supported"
+	stack_trap "$LCTL debug_daemon stop; rm -f $log*"
+	touch $DIR/$tfile
+	$LCTL mark "$tfile compressed"
+	# the daemon writes every second
+	sleep 3
+	$LCTL debug_daemon stop
+
+	[[ -s $log.0 ]] || error "no compressed log $log.0"
+	$LCTL df $log.0 > $log.out 2>&1 || error "lctl df $log.0 failed"
+	grep -q "Debug blocks:" $log.out || error "$log.0 is not compressed"
+	grep -q "$tfile compressed" $log.out ||
+		error "marker not found in $log.0"
+
+	# blocks outside of the time range are skipped, not decompressed
+	$LCTL df --start $((start + 3600)) $log.0 > $log.out 2>&1 ||
+		error "lctl df --start $log.0 failed"
+	grep -q "Debug blocks: 0 read" $log.out ||
+		error "blocks out of the time range were read"
+}
+run_test 170b "compressed debug daemon log and time range reader"
+
 test_171() { # bug20592
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -22344,6 +22606,54 @@ test_205l() {
 }
 run_test 205l "Verify job stats can scale"
 
+test_205m() {
+	[[ $PARALLEL != "yes" ]] || skip "skip parallel run"
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	[[ "$($LCTL get_param -n mdc.*.connect_flags)" =~ jobstats ]] ||
+		skip "Server doesn't support jobstats"
+	[[ "$JOBID_VAR" != "disable" ]] || skip_env "jobstats is disabled"
+	do_facet ost1 $LCTL get_param -n obdfilter.*.job_stats_top &>/dev/null ||
+		skip "Server doesn't support job_stats_top"
+
+	local jobid_save=$($LCTL get_param jobid_var jobid_name)
+	local ost=$(facet_svc ost1)
+	local top
+	local magic
+
+	stack_trap "$LCTL set_param $jobid_save"
+	stack_trap "do_facet ost1 $LCTL set_param obdfilter.$ost.job_stats_top=10"
+
+	$LFS setstripe -i 0 -c 1 $DIR/$tfile || error "setstripe failed"
+	do_facet ost1 $LCTL set_param obdfilter.$ost.job_stats=clear
+	$LCTL set_param jobid_var=nodelocal
+	for ((i = 1; i <= 4; i++)); do
+		$LCTL set_param jobid_name=$tdir.$i
+		dd if=/dev/zero of=$DIR/$tfile bs=64k count=$((i * 4)) \
+			conv=notrunc oflag=sync || error "dd job $i failed"
+	done
+
+	# the job writing the most bytes comes first
+	do_facet ost1 $LCTL set_param \
+		obdfilter.$ost.job_stats_top="2 write_bytes" ||
+		error "set job_stats_top failed"
+	top=($(do_facet ost1 $LCTL get_param -n obdfilter.$ost.job_stats_top |
+	       awk '/job_id:/ { print $3 }'))
+	echo "top jobs: ${top[*]}"
+	(( ${#top[*]} == 2 )) || error "expected 2 jobs, got ${#top[*]}"
+	[[ "${top[0]}" == "$tdir.4" && "${top[1]}" == "$tdir.3" ]] ||
+		error "expected $tdir.4 $tdir.3, got ${top[*]}"
+	do_facet ost1 $LCTL set_param \
+		obdfilter.$ost.job_stats_top="2 no_such_counter" &&
+		error "unknown counter should be rejected"
+
+	magic=$(do_facet ost1 "od -An -tx4 -N4 \
+		/proc/fs/lustre/obdfilter/$ost/job_stats_bin" | tr -d ' ')
+	[[ "$magic" == "4a534231" ]] ||
+		error "bad job_stats_bin magic '$magic'"
+	do_facet ost1 $LCTL set_param obdfilter.$ost.job_stats=clear
+}
+run_test 205m "Verify job_stats_top and job_stats_bin"
+
 # LU-1480, LU-1773 and LU-1657
 test_206() {
 	mkdir -p $DIR/$tdir
@@ -32285,6 +32595,77 @@ test_434() {
 }
 run_test 434 "Client should not send RPCs for security.selinux with SElinux disabled"
 
+test_435() {
+	local count=1000
+	local batches
+	local uid
+
+	$LCTL get_param -n mdc.*.connect_flags | grep -q batch_reint ||
+		skip "MDS does not support batched create/unlink/setattr"
+	[[ $(getenforce) == "Disabled" ]] ||
+		skip "files labelled by SELinux are not created in batches"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+
+	$LCTL set_param -n mdc.*.stats=clear
+	createmany -B -m $DIR/$tdir/f $count || error "batched create failed"
+	batches=$($LCTL get_param -n mdc.*.stats |
+		  awk '/^mds_batch/ { sum += $2 } END { print sum + 0 }')
+	echo "$count creates in $batches batch RPCs"
+	(( batches > 0 && batches < count / 4 )) ||
+		error "$count creates sent $batches batch RPCs"
+	(( $(ls $DIR/$tdir | wc -l) == count )) ||
+		error "$(ls $DIR/$tdir | wc -l) files created, expect $count"
+	[[ $(stat -c %a $DIR/$tdir/f1) == 444 ]] ||
+		error "bad mode $(stat -c %a $DIR/$tdir/f1)"
+
+	# the setattr of a file depends on its create in the same batch
+	createmany -B -m -U 500 -G 600 $DIR/$tdir/own 10 ||
+		error "batched create and setattr failed"
+	uid=$(stat -c %u:%g $DIR/$tdir/own7)
+	[[ $uid == "507:607" ]] || error "own7 owned by $uid, expect 507:607"
+
+	createmany -B -u $DIR/$tdir/f $count || error "batched unlink failed"
+	createmany -B -u $DIR/$tdir/own 10 || error "batched unlink failed"
+	[[ -z "$(ls $DIR/$tdir)" ]] || error "$(ls $DIR/$tdir) not unlinked"
+
+	# a batched unlink leaves the directories alone
+	mkdir $DIR/$tdir/d0 || error "mkdir $DIR/$tdir/d0 failed"
+	createmany -B -u $DIR/$tdir/d 1 &&
+		error "batched unlink of a directory succeeded"
+	[[ -d $DIR/$tdir/d0 ]] || error "directory $DIR/$tdir/d0 unlinked"
+}
+run_test 435 "batched create, setattr and unlink of many files"
+
+test_435b() {
+	local count=100
+	local out=$TMP/$tfile.out
+
+	$LCTL get_param -n mdc.*.connect_flags | grep -q batch_reint ||
+		skip "MDS does not support batched create/unlink/setattr"
+	[[ $(getenforce) == "Disabled" ]] ||
+		skip "files labelled by SELinux are not created in batches"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	# fails in the first batch, whose reply is lost
+	touch $DIR/$tdir/f5 || error "touch $DIR/$tdir/f5 failed"
+	stack_trap "rm -f $out"
+
+	#define OBD_FAIL_BUT_UPDATE_NET_REP	0x170a
+	do_facet mds1 $LCTL set_param fail_loc=0x8000170a
+	createmany -B -m $DIR/$tdir/f $count > $out 2>&1 &&
+		error "batched create of existing $DIR/$tdir/f5 succeeded"
+	do_facet mds1 $LCTL set_param fail_loc=0
+	cat $out
+
+	# the resent batch reports the sub request that failed
+	grep -q "f5) error: File exists" $out ||
+		error "failed create of f5 not reported"
+	(( $(ls $DIR/$tdir | wc -l) == count )) ||
+		error "$(ls $DIR/$tdir | wc -l) files created, expect $count"
+}
+run_test 435b "resent batch reports the failed sub requests"
+
 test_440() {
 	if [[ -f $LUSTRE/scripts/bash-completion/lustre ]]; then
 		source $LUSTRE/scripts/bash-completion/lustre
@@ -33975,6 +34356,82 @@ test_842() {
 }
 run_test 842 "Measure ldlm_extent performance"
 
+test_843() {
+	load_module ec/ec || error "load_module ec failed"
+
+	# Results of the verification and benchmark are left in dmesg
+	now=$(date +%s)
+	log "STAMP $now" > /dev/kmsg
+	load_module kunit/ec_test ec_test_msec=500 ||
+		error "ec_test verification failed, check dmesg"
+
+	dmesg | sed -n -e "1,/STAMP $now/d" -e '/ec_test:/p'
+	rmmod -v ec_test ||
+		error "rmmod failed (may trigger a failure in a later test)"
+}
+run_test 843 "Verify and measure erasure code implementations"
+
+test_844() {
+	# Results of the verification and benchmark are left in dmesg
+	now=$(date +%s)
+	log "STAMP $now" > /dev/kmsg
+	load_module kunit/compr_test compr_test_msec=500 ||
+		error "compr_test verification failed, check dmesg"
+
+	dmesg | sed -n -e "1,/STAMP $now/d" -e '/compr_test:/p'
+	rmmod -v compr_test ||
+		error "rmmod failed (may trigger a failure in a later test)"
+}
+run_test 844 "Verify and measure chunk compression"
+
+test_844b() {
+	$LCTL get_param -n osc.*.import | grep -q compressed_file ||
+		skip "OSTs cannot store compressed chunks"
+
+	local file=$DIR/$tfile
+	local tmp=$TMP/$tfile
+	local size=$((3 * 1048576 + 1000))
+	local chunks
+
+	stack_trap "rm -f $file $tmp"
+	$LFS setstripe -c 1 -S 1M --compress fast:128K $file ||
+		error "setstripe --compress failed"
+	$LFS getstripe -v $file | grep "lcme_flags:.*compress" ||
+		error "$file is not compressed"
+
+	# compressible data, the tail is not page aligned
+	yes compressible | head -c $size > $tmp
+	clear_stats osc.*.osc_stats
+	cp $tmp $file || error "cp to $file failed"
+	sync
+	chunks=$($LCTL get_param -n osc.*.osc_stats |
+		 awk '/^compress_chunks/ { n += $2 } END { print n + 0 }')
+	(( chunks > 0 )) || error "no chunk was compressed"
+
+	# the rest of the last chunk is written again, up to EOF only
+	dd if=/dev/urandom of=$tmp bs=1 seek=$((size - 500)) count=100 \
+		conv=notrunc
+	dd if=$tmp of=$file bs=1 skip=$((size - 500)) seek=$((size - 500)) \
+		count=100 conv=notrunc || error "overwrite of $file failed"
+	(( $(stat -c %s $file) == size )) ||
+		error "size $(stat -c %s $file) != $size"
+	cancel_lru_locks osc
+	cmp $tmp $file || error "$file differs after overwrite"
+}
+run_test 844b "Write and read back a compressed component"
+
+test_845() {
+	# Try to insert the module.  This will leave results in dmesg
+	now=$(date +%s)
+	log "STAMP $now" > /dev/kmsg
+	load_module kunit/fld_test || error "load_module fld_test failed"
+
+	dmesg | sed -n -e "1,/STAMP $now/d" -e '/fld_test:/p'
+	rmmod -v fld_test ||
+		error "rmmod failed (may trigger a failure in a later test)"
+}
+run_test 845 "Measure FLD cache lookup performance"
+
 test_850() {
 	local dir=$DIR/$tdir
 	local file=$dir/$tfile
@@ -33990,6 +34447,24 @@ test_850() {
 	$LCTL get_param *.*.job_stats > $statsfile
 	lljobstat --statsfile=$statsfile ||
 		error "failed to run lljobstat on file $statsfile"
+
+	# the jobs of a file given twice are added up
+	local ops=$(lljobstat --statsfile=$statsfile -c 1 |
+		    awk '/^- / { print $4 }')
+	local ops2=$(lljobstat --statsfile=$statsfile --statsfile=$statsfile \
+		     -c 1 | awk '/^- / { print $4 }')
+	echo "top job ops: $ops, twice: $ops2"
+	[[ -z "$ops" ]] || (( ${ops2%,} == 2 * ${ops%,} )) ||
+		error "expected twice $ops ops, got $ops2"
+
+	local prom=$TMP/$tfile.prom
+
+	stack_trap "rm -f $prom"
+	lljobstat -n 1 -i 1 -r --prometheus=$prom ||
+		error "failed to run lljobstat with rates"
+	cat $prom
+	grep -q "^# TYPE lustre_job_ops_rate gauge" $prom ||
+		error "missing metric type in $prom"
 }
 run_test 850 "lljobstat can parse living and aggregated job_stats"
 
@@ -5166,6 +5166,75 @@ test_77r() { #LU-14976
 }
 run_test 77r "Change type of tbf policy at run time"
 
+test_77s() {
+	local nodes=$(comma_list $(osts_nodes))
+
+	(( $OST1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "need OST >= 2.16.51 for hierarchical TBF rules"
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies="tbf" ||
+		error "failed to set TBF policy"
+	stack_trap "do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies=fifo"
+
+	# the parent caps the job, the write class is capped by the parent
+	do_nodes $nodes lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job\ jobid={dd.$RUNAS_ID}\ rate=20" \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job_w\ jobid={dd.$RUNAS_ID}\&opcode={ost_write}\ rate=100\ parent=job" \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job_r\ jobid={dd.$RUNAS_ID}\&opcode={ost_read}\ rate=5\ parent=job" ||
+		error "failed to start hierarchical TBF rules"
+	stack_trap "do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_tbf_rule='stop job_r' ost.OSS.ost_io.nrs_tbf_rule='stop job_w' ost.OSS.ost_io.nrs_tbf_rule='stop job'"
+
+	do_facet ost1 lctl get_param ost.OSS.ost_io.nrs_tbf_rule |
+		grep "^job_r .* parent job$" ||
+		error "child rule should show its parent"
+
+	do_facet ost1 lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="stop\ job" &&
+		error "parent rule stopped while child rules exist"
+	do_facet ost1 lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job_x\ jobid={x}\ rate=5\ parent=job_r" &&
+		error "a child rule should not be a parent"
+	do_facet ost1 lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job_x\ jobid={x}\ rate=5\ borrow=1" &&
+		error "borrow should need a parent rule"
+
+	nrs_write_read "$RUNAS"
+	tbf_verify 20 5 "$RUNAS"
+
+	# reads may now use the tokens left by writes, up to the job cap
+	do_nodes $nodes lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="stop\ job_r" \
+		ost.OSS.ost_io.nrs_tbf_rule="start\ job_r\ jobid={dd.$RUNAS_ID}\&opcode={ost_read}\ rate=5\ parent=job\ borrow=1" ||
+		error "failed to restart rule job_r with borrowing"
+
+	nrs_write_read "$RUNAS"
+	tbf_verify 20 20 "$RUNAS"
+}
+run_test 77s "check hierarchical TBF rules with token borrowing"
+
+test_77t() {
+	local nodes=$(comma_list $(osts_nodes))
+	local served
+
+	(( $OST1_VERSION >= $(version_code 2.16.51) )) ||
+		skip "need OST >= 2.16.51 for EDF NRS policy"
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies="edf" ||
+		error "failed to set EDF policy"
+	stack_trap "do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies=fifo"
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_edf_stats=clear ||
+		error "failed to clear EDF stats"
+
+	nrs_write_read
+
+	do_facet ost1 lctl get_param ost.OSS.ost_io.nrs_edf_stats
+	served=$(do_facet ost1 lctl get_param -n ost.OSS.ost_io.nrs_edf_stats |
+		 awk '/served:/ { sum += $2 } END { print sum + 0 }')
+	(( served > 0 )) || error "EDF policy served no requests"
+}
+run_test 77t "check EDF NRS policy"
+
 test_78() { #LU-6673
 	local rc
 
@@ -1127,6 +1127,7 @@ load_modules_local() {
 		load_module osp/osp
 	fi
 
+	load_module ec/ec
 	load_module llite/lustre
 	[ -d /r ] && OGDB=${OGDB:-"/r/tmp"}
 	OGDB=${OGDB:-$TMP}
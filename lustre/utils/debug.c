@@ -40,6 +40,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -349,10 +350,239 @@ static void dump_hdr(unsigned long long offset, struct ptldebug_header *hdr)
 	fprintf(stderr, "  line number = %u\n", hdr->ph_line_num);
 }
 
+/* input of parse_buffer(), a raw debug log or compressed daemon blocks */
+struct dbg_input {
+	int		 di_fd;
+	bool		 di_blocks;	/* struct cfs_trace_blk_hdr blocks */
+	char		*di_buf;	/* records of the current block */
+	size_t		 di_buf_size;
+	size_t		 di_len;
+	size_t		 di_pos;
+	char		*di_zbuf;	/* compressed data of the block */
+	size_t		 di_zbuf_size;
+	unsigned int	 di_start;	/* range of ph_sec of the records */
+	unsigned int	 di_end;
+	unsigned long	 di_read;	/* blocks decompressed */
+	unsigned long	 di_skipped;	/* blocks outside of the time range */
+};
+
+/*
+ * Decompress an LZ4 block as written by the kernel lz4 compressor, see
+ * the LZ4 block format description. Return the decompressed length, or
+ * -EINVAL if the block is corrupted.
+ */
+static int dbg_lz4_decompress(const unsigned char *src, size_t src_len,
+			      unsigned char *dst, size_t dst_len)
+{
+	const unsigned char *ip = src;
+	const unsigned char *iend = src + src_len;
+	unsigned char *op = dst;
+	unsigned char *oend = dst + dst_len;
+
+	while (ip < iend) {
+		unsigned int token = *ip++;
+		const unsigned char *match;
+		size_t offset;
+		size_t len;
+
+		/* literals */
+		len = token >> 4;
+		if (len == 15) {
+			unsigned int b;
+
+			do {
+				if (ip >= iend)
+					return -EINVAL;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+			return -EINVAL;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* the last sequence only has literals */
+		if (ip == iend)
+			break;
+
+		/* match, possibly overlapping the output */
+		if (iend - ip < 2)
+			return -EINVAL;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst))
+			return -EINVAL;
+
+		len = token & 15;
+		if (len == 15) {
+			unsigned int b;
+
+			do {
+				if (ip >= iend)
+					return -EINVAL;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += 4;
+		if (len > (size_t)(oend - op))
+			return -EINVAL;
+
+		match = op - offset;
+		while (len-- > 0)
+			*op++ = *match++;
+	}
+
+	return op - dst;
+}
+
+static void dbg_input_init(struct dbg_input *di, int fd, unsigned int start,
+			   unsigned int end)
+{
+	__u32 magic;
+
+	memset(di, 0, sizeof(*di));
+	di->di_fd = fd;
+	di->di_start = start;
+	di->di_end = end;
+	di->di_blocks = pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) &&
+			magic == CFS_TRACE_BLK_MAGIC;
+}
+
+static void dbg_input_fini(struct dbg_input *di)
+{
+	if (di->di_blocks)
+		printf("Debug blocks: %lu read, %lu skipped.\n",
+		       di->di_read, di->di_skipped);
+	free(di->di_buf);
+	free(di->di_zbuf);
+}
+
+static int dbg_read_full(int fd, void *buf, size_t count)
+{
+	size_t done = 0;
+
+	while (done < count) {
+		ssize_t rc = read(fd, (char *)buf + done, count - done);
+
+		if (rc <= 0)
+			return rc < 0 ? -errno : 0;
+		done += rc;
+	}
+
+	return 1;
+}
+
+static int dbg_grow(char **buf, size_t *size, size_t len)
+{
+	char *tmp;
+
+	if (len <= *size)
+		return 0;
+
+	tmp = realloc(*buf, len);
+	if (!tmp)
+		return -ENOMEM;
+	*buf = tmp;
+	*size = len;
+
+	return 0;
+}
+
+/*
+ * Load the next block holding records in the time range, skipping the
+ * others without decompressing them. Return 0 at the end of the file.
+ */
+static int dbg_next_block(struct dbg_input *di)
+{
+	struct cfs_trace_blk_hdr hdr;
+	int rc;
+
+	while ((rc = dbg_read_full(di->di_fd, &hdr, sizeof(hdr))) > 0) {
+		if (hdr.tbh_magic != CFS_TRACE_BLK_MAGIC ||
+		    hdr.tbh_len > CFS_TRACE_BLK_MAX ||
+		    hdr.tbh_raw_len > CFS_TRACE_BLK_MAX ||
+		    (!(hdr.tbh_flags & CFS_TRACE_BLK_LZ4) &&
+		     hdr.tbh_len != hdr.tbh_raw_len)) {
+			fprintf(stderr, "bad debug block at offset %llu\n",
+				(unsigned long long)lseek(di->di_fd, 0,
+							  SEEK_CUR) -
+				sizeof(hdr));
+			return -EINVAL;
+		}
+
+		if (hdr.tbh_sec_max < di->di_start ||
+		    hdr.tbh_sec_min > di->di_end) {
+			di->di_skipped++;
+			if (lseek(di->di_fd, hdr.tbh_len, SEEK_CUR) < 0)
+				return -errno;
+			continue;
+		}
+
+		if (dbg_grow(&di->di_buf, &di->di_buf_size, hdr.tbh_raw_len) ||
+		    dbg_grow(&di->di_zbuf, &di->di_zbuf_size, hdr.tbh_len))
+			return -ENOMEM;
+
+		rc = dbg_read_full(di->di_fd, di->di_zbuf, hdr.tbh_len);
+		if (rc <= 0)
+			return rc;
+
+		if (hdr.tbh_flags & CFS_TRACE_BLK_LZ4) {
+			rc = dbg_lz4_decompress((unsigned char *)di->di_zbuf,
+						hdr.tbh_len,
+						(unsigned char *)di->di_buf,
+						hdr.tbh_raw_len);
+			if (rc != hdr.tbh_raw_len) {
+				fprintf(stderr,
+					"corrupted debug block at offset %llu\n",
+					(unsigned long long)lseek(di->di_fd, 0,
+								  SEEK_CUR) -
+					hdr.tbh_len - sizeof(hdr));
+				return -EINVAL;
+			}
+		} else {
+			memcpy(di->di_buf, di->di_zbuf, hdr.tbh_raw_len);
+		}
+		di->di_len = hdr.tbh_raw_len;
+		di->di_pos = 0;
+		di->di_read++;
+
+		return 1;
+	}
+
+	return rc;
+}
+
+/* read() the records of a raw debug log or of the blocks of a daemon file */
+static ssize_t dbg_read(struct dbg_input *di, void *buf, size_t count)
+{
+	int rc;
+
+	if (!di->di_blocks)
+		return read(di->di_fd, buf, count);
+
+	if (di->di_pos == di->di_len) {
+		rc = dbg_next_block(di);
+		if (rc <= 0)
+			return rc;
+	}
+
+	if (count > di->di_len - di->di_pos)
+		count = di->di_len - di->di_pos;
+	memcpy(buf, di->di_buf + di->di_pos, count);
+	di->di_pos += count;
+
+	return count;
+}
+
 #define HDR_SIZE sizeof(*hdr)
 
-static int parse_buffer(int fdin, int fdout)
+static int parse_buffer(int fdin, int fdout, unsigned int start,
+			unsigned int end)
 {
+	struct dbg_input	 di;
 	struct dbg_line		*line;
 	struct ptldebug_header	*hdr;
 	char			 buf[4097];
@@ -365,6 +595,7 @@ static int parse_buffer(int fdin, int fdout)
 	int			 rc;
 
 	hdr = (void *)buf;
+	dbg_input_init(&di, fdin, start, end);
 
 	while (1) {
 		int first_bad = 1;
@@ -373,7 +604,7 @@ static int parse_buffer(int fdin, int fdout)
 		count = HDR_SIZE;
 		ptr = buf;
 readhdr:
-		rc = read(fdin, ptr, count);
+		rc = dbg_read(&di, ptr, count);
 		if (rc <= 0)
 			goto print;
 
@@ -414,7 +645,7 @@ readhdr:
 
 		count = hdr->ph_len - HDR_SIZE;
 readmore:
-		rc = read(fdin, ptr, count);
+		rc = dbg_read(&di, ptr, count);
 		if (rc <= 0)
 			break;
 
@@ -426,7 +657,8 @@ readmore:
 		first_bad = 1;
 
 		if ((hdr->ph_subsys && !(subsystem_mask & hdr->ph_subsys)) ||
-		    (hdr->ph_mask && !(debug_mask & hdr->ph_mask))) {
+		    (hdr->ph_mask && !(debug_mask & hdr->ph_mask)) ||
+		    hdr->ph_sec < start || hdr->ph_sec > end) {
 			dropped++;
 			continue;
 		}
@@ -494,6 +726,7 @@ print:
 	if (linev)
 		print_rec(&linev, kept, fdout);
 
+	dbg_input_fini(&di);
 	printf("Debug log: %lu lines, %lu kept, %lu dropped, %lu bad.\n",
 		dropped + kept + bad, kept, dropped, bad);
 
@@ -584,7 +817,7 @@ int jt_dbg_debug_kernel(int argc, char **argv)
 		fdout = fileno(stdout);
 	}
 
-	rc = parse_buffer(fdin, fdout);
+	rc = parse_buffer(fdin, fdout, 0, UINT_MAX);
 	close(fdin);
 	if (argc > 1)
 		close(fdout);
@@ -602,29 +835,67 @@ int jt_dbg_debug_kernel(int argc, char **argv)
 	return rc;
 }
 
+static const char debug_file_usage[] =
+	"usage: %s [--start SEC] [--end SEC] <input> [output]\n";
+
 int jt_dbg_debug_file(int argc, char **argv)
 {
+	struct option long_opts[] = {
+	{ .val = 'e',	.name = "end",		.has_arg = required_argument },
+	{ .val = 's',	.name = "start",	.has_arg = required_argument },
+	{ .name = NULL } };
+	unsigned int start = 0;
+	unsigned int end = UINT_MAX;
+	const char *infile;
+	const char *outfile;
+	unsigned long val;
+	char *tail;
 	int fdin;
 	int fdout;
 	int rc;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "e:s:", long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'e':
+		case 's':
+			errno = 0;
+			val = strtoul(optarg, &tail, 0);
+			if (errno || *tail != '\0' || val > UINT_MAX) {
+				fprintf(stderr, "%s: invalid time '%s'\n",
+					argv[0], optarg);
+				return 1;
+			}
+			if (c == 's')
+				start = val;
+			else
+				end = val;
+			break;
+		default:
+			fprintf(stderr, debug_file_usage, argv[0]);
+			return 0;
+		}
+	}
 
-	if (argc > 3 || argc < 2) {
-		fprintf(stderr, "usage: %s <input> [output]\n", argv[0]);
+	if (argc - optind > 2 || argc - optind < 1) {
+		fprintf(stderr, debug_file_usage, argv[0]);
 		return 0;
 	}
+	infile = argv[optind];
+	outfile = argc - optind > 1 ? argv[optind + 1] : NULL;
 
-	fdin = open(argv[1], O_RDONLY | O_LARGEFILE);
+	fdin = open(infile, O_RDONLY | O_LARGEFILE);
 	if (fdin < 0) {
-		fprintf(stderr, "open(%s) failed: %s\n", argv[1],
+		fprintf(stderr, "open(%s) failed: %s\n", infile,
 			strerror(errno));
 		return 1;
 	}
-	if (argc > 2) {
-		fdout = open(argv[2],
+	if (outfile) {
+		fdout = open(outfile,
 			     O_CREAT | O_TRUNC | O_WRONLY | O_LARGEFILE,
 			     0600);
 		if (fdout < 0) {
-			fprintf(stderr, "open(%s) failed: %s\n", argv[2],
+			fprintf(stderr, "open(%s) failed: %s\n", outfile,
 				strerror(errno));
 			close(fdin);
 			return 1;
@@ -633,7 +904,8 @@ int jt_dbg_debug_file(int argc, char **argv)
 		fdout = fileno(stdout);
 	}
 
-	rc = parse_buffer(fdin, fdout);
+	/* blocks of compressed files outside of the range are not read */
+	rc = parse_buffer(fdin, fdout, start, end);
 
 	close(fdin);
 	if (fdout != fileno(stdout))
@@ -642,7 +914,8 @@ int jt_dbg_debug_file(int argc, char **argv)
 	return rc;
 }
 
-const char debug_daemon_usage[] = "usage: %s {start file [MB]|stop}\n";
+const char debug_daemon_usage[] =
+	"usage: %s {start file [MB] [--compress [--files N]]|stop}\n";
 
 int jt_dbg_debug_daemon(int argc, char **argv)
 {
@@ -661,24 +934,51 @@ int jt_dbg_debug_daemon(int argc, char **argv)
 
 	rc = -1;
 	if (strcasecmp(argv[1], "start") == 0) {
-		if (argc < 3 || argc > 4 ||
-		    (argc == 4 && strlen(argv[3]) > 5)) {
+		const char	*file = NULL;
+		const char	*mb = NULL;
+		bool		 compress = false;
+		long		 files = 0;
+		char		 buf[16];
+		char		*end;
+		int		 i;
+
+		for (i = 2; i < argc; i++) {
+			if (strcmp(argv[i], "--compress") == 0 ||
+			    strcmp(argv[i], "-z") == 0) {
+				compress = true;
+			} else if (strcmp(argv[i], "--files") == 0 &&
+				   i + 1 < argc) {
+				files = strtol(argv[++i], &end, 0);
+				if (files < 1 || files > 100 || *end != 0) {
+					fprintf(stderr, "files %s invalid, "
+						"must be in the range 1-100\n",
+						argv[i]);
+					goto out;
+				}
+			} else if (!file) {
+				file = argv[i];
+			} else if (!mb) {
+				mb = argv[i];
+			} else {
+				file = NULL;
+				break;
+			}
+		}
+		if (!file || (mb && strlen(mb) > 5) || (files && !compress)) {
 			fprintf(stderr, debug_daemon_usage, argv[0]);
 			goto out;
 		}
-		if (argc == 4) {
-			char		 buf[12];
+		if (mb) {
 			const long	 min_size = 10;
 			const long	 max_size = 20480;
 			long		 size;
-			char		*end;
 
-			size = strtoul(argv[3], &end, 0);
+			size = strtoul(mb, &end, 0);
 			if (size < min_size ||
 			    size > max_size ||
 			    *end != 0) {
 				fprintf(stderr, "size %s invalid, must be in "
-					"the range %ld-%ld MB\n", argv[3],
+					"the range %ld-%ld MB\n", mb,
 					min_size, max_size);
 				goto out;
 			}
@@ -691,19 +991,33 @@ int jt_dbg_debug_daemon(int argc, char **argv)
 				goto out;
 			}
 		}
+		/* LZ4 blocks, rotated through a set of files */
+		if (compress) {
+			snprintf(buf, sizeof(buf), "compress=lz4");
+			rc = dbg_write_cmd(fd, buf, strlen(buf));
+			if (rc == 0 && files) {
+				snprintf(buf, sizeof(buf), "files=%ld", files);
+				rc = dbg_write_cmd(fd, buf, strlen(buf));
+			}
+			if (rc != 0) {
+				fprintf(stderr, "set %s failed: %s\n",
+					buf, strerror(errno));
+				goto out;
+			}
+		}
 
-		rc = cfs_abs_path(argv[2], &resolved_path);
+		rc = cfs_abs_path(file, &resolved_path);
 		if (rc != 0) {
 			fprintf(stderr,
 				"%s debug_daemon: cannot resolve path '%s': %s\n",
-				program_invocation_short_name, argv[2],
+				program_invocation_short_name, file,
 				strerror(-rc));
 			goto out;
 		}
 		rc = dbg_write_cmd(fd, resolved_path, strlen(resolved_path));
 		if (rc != 0) {
 			fprintf(stderr, "start debug_daemon on %s failed: %s\n",
-				argv[2], strerror(errno));
+				file, strerror(errno));
 			goto out;
 		}
 		rc = 0;
@@ -842,6 +1156,7 @@ static struct mod_paths {
 	{ .name = "llog_test",	.path = "lustre/kunit" },
 	{ .name = "obd_test",	.path = "lustre/kunit" },
 	{ .name = "kinode",	.path = "lustre/kunit" },
+	{ .name = "ec_test",	.path = "lustre/kunit" },
 	{ .name = "ptlrpc_gss",	.path = "lustre/ptlrpc/gss" },
 	{ .name = "ptlrpc",	.path = "lustre/ptlrpc" },
 	{ .name = "gks",	.path = "lustre/sec/gks" },
@@ -397,7 +397,7 @@ command_t cmdlist[] = {
 	{"==== debugging control ====", NULL, 0, "debug"},
 	{"debug_daemon", jt_dbg_debug_daemon, 0,
 	 "debug daemon control and dump to a file\n"
-	 "usage: debug_daemon {start file [#MB]|stop}"},
+	 "usage: debug_daemon {start file [#MB] [--compress [--files N]]|stop}"},
 	{"debug_kernel", jt_dbg_debug_kernel, 0,
 	 "get debug buffer and dump to a file, same as 'dk'\n"
 	 "usage: debug_kernel [file] [raw]"},
@@ -406,10 +406,10 @@ command_t cmdlist[] = {
 	 "usage: dk [file] [raw]"},
 	{"debug_file", jt_dbg_debug_file, 0,
 	 "convert a binary debug file dumped by the kernel to ASCII text\n"
-	 "usage: debug_file <input> [output]"},
+	 "usage: debug_file [--start SEC] [--end SEC] <input> [output]"},
 	{"df", jt_dbg_debug_file, 0,
 	 "read debug log from input convert to ASCII, same as 'debug_file'\n"
-	 "usage: df <input> [output]"},
+	 "usage: df [--start SEC] [--end SEC] <input> [output]"},
 	{"clear", jt_dbg_clear_debug_buf, 0, "clear kernel debug buffer\n"
 	 "usage: clear"},
 	{"mark", jt_dbg_mark_debug_buf, 0,
@@ -81,9 +81,6 @@
 #include <uapi/linux/lustre/lustre_idl.h>
 #include "callvpe.h"
 
-#ifndef NSEC_PER_SEC
-# define NSEC_PER_SEC 1000000000UL
-#endif
 #define ONE_MB 0x100000
 
 /* all functions */
@@ -214,6 +211,7 @@ static inline int lfs_mirror_delete(int argc, char **argv)
 	"[--component-add|--component-del|--delete|-d]\n"	\
 	"\t\t[--comp-set --comp-id|-I COMP_ID|--comp-flags=COMP_FLAGS]\n"     \
 	"\t\t[--component-end|-E END_OFFSET]\n"			\
+	"\t\t[--compress COMPR_TYPE[:CHUNK_SIZE]]\n"		\
 	"\t\t[--copy=SOURCE_LAYOUT_FILE]|--yaml|-y YAML_TEMPLATE_FILE]\n"     \
 	"\t\t[--extension-size|--ext-size|-z EXT_SIZE]\n"	\
 	"\t\t[--help|-h]\n"					\
@@ -222,6 +220,7 @@ static inline int lfs_mirror_delete(int argc, char **argv)
 	"\t\t[--mirror-count|-N[MIRROR_COUNT]]\n"		\
 	"\t\t[--ost|-o OST_INDEX[,OST_INDEX,...]]\n"		\
 	"\t\t[--overstripe-count|-C STRIPE_COUNT]\n"		\
+	"\t\t[--parity-count PARITY_COUNT]\n"			\
 	"\t\t[--pool|-p POOL_NAME]\n"				\
 	"\t\t[--stripe-count|-c STRIPE_COUNT]\n"		\
 	"\t\t[--stripe-index|-i START_OST_IDX]\n"		\
@@ -489,7 +488,7 @@ command_t cmdlist[] = {
 	 "     [[!] --foreign[=<foreign_type>]]\n"
 	 "     [[!] --gid|-g|--group|-G <gid>|<gname>] [--help|-h]\n"
 	 "     [[!] --layout|-L released,raid0,mdt] [--lazy|-l] [[!] --links [+-]n]\n"
-	 "     [--maxdepth|-D N] [--mindepth|-d N]\n"
+	 "     [--maxdepth|-D N] [--mindepth|-d N] [--ordered]\n"
 	 "     [[!] --mdt-count|-T [+-]<stripes>]\n"
 	 "     [[!] --mdt-hash|-H <[^][blm],[^]fnv_1a_64,all_char,crush,...>\n"
 	 "     [[!] --mdt-index|--mdt|-m <uuid|index,...>]\n"
@@ -501,8 +500,8 @@ command_t cmdlist[] = {
 	 "     [[!] --projid <projid>] [[!] --size|-s [+-]N[bkMGTPE]]\n"
 	 "     [--skip|-k PERCENT] [[!] --stripe-count|-c [+-]<stripes>]\n"
 	 "     [[!] --stripe-index|-i <index,...>]\n"
-	 "     [[!] --stripe-size|-S [+-]N[kMGT]] [[!] --type|-t <filetype>]\n"
-	 "     [[!] --uid|-u|--user|-U <uid>|<uname>]\n"
+	 "     [[!] --stripe-size|-S [+-]N[kMGT]] [--threads <n>]\n"
+	 "     [[!] --type|-t <filetype>] [[!] --uid|-u|--user|-U <uid>|<uname>]\n"
 	 "\t !: used before an option indicates 'NOT' requested attribute\n"
 	 "\t -: used before a value indicates less than requested value\n"
 	 "\t +: used before a value indicates more than requested value\n"
@@ -866,62 +865,94 @@ out:
 	return rc;
 }
 
-static struct timespec timespec_sub(struct timespec *before,
-				    struct timespec *after)
+/* bytes read from the source by each stream at a time */
+#define MIGRATE_CHUNK_SIZE	(16 * ONE_MB)
+
+struct migrate_copy {
+	int	  mc_fd_src;
+	int	  mc_fd_dst;
+	int	(*mc_check_file)(int);
+};
+
+static ssize_t migrate_copy_read(void *priv, void *buf, size_t count,
+				 off_t pos)
 {
-	struct timespec ret;
+	struct migrate_copy *mc = priv;
+	ssize_t rsize;
+	int rc;
 
-	ret.tv_sec = after->tv_sec - before->tv_sec;
-	if (after->tv_nsec < before->tv_nsec) {
-		ret.tv_sec--;
-		ret.tv_nsec = NSEC_PER_SEC + after->tv_nsec - before->tv_nsec;
-	} else {
-		ret.tv_nsec = after->tv_nsec - before->tv_nsec;
+	if (mc->mc_check_file) {
+		rc = mc->mc_check_file(mc->mc_fd_src);
+		if (rc < 0) {
+			llapi_error(LLAPI_MSG_ERROR, rc,
+				    "error checking src file");
+			return rc;
+		}
 	}
 
-	return ret;
+	rsize = pread(mc->mc_fd_src, buf, count, pos);
+	if (rsize < 0)
+		return -errno;
+
+	return rsize;
 }
 
-static void stats_log(struct timespec *now, struct timespec *start_time,
-		      ssize_t read_bytes, size_t write_bytes,
-		      off_t file_size_bytes)
+static ssize_t migrate_copy_write(void *priv, void *buf, size_t count,
+				  off_t pos)
 {
-	struct timespec diff = timespec_sub(start_time, now);
-
-	if (file_size_bytes == 0)
-		return;
+	struct migrate_copy *mc = priv;
+	size_t to_write = count;
+	ssize_t written;
 
-	if (diff.tv_sec == 0 && diff.tv_nsec == 0)
-		return;
+	while (to_write > 0) {
+		written = pwrite(mc->mc_fd_dst, buf, to_write, pos);
+		if (written < 0)
+			return -errno;
+		pos += written;
+		buf += written;
+		to_write -= written;
+	}
 
-	printf("- { seconds: %li, rmbps: %5.2g, wmbps: %5.2g, copied: %lu, size: %lu, pct: %lu%% }\n",
-		diff.tv_sec,
-		(double) read_bytes/((ONE_MB * diff.tv_sec) +
-			((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
-		(double) write_bytes/((ONE_MB * diff.tv_sec) +
-			((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
-		write_bytes/ONE_MB, file_size_bytes/ONE_MB,
-		((write_bytes*100)/file_size_bytes));
+	return count;
 }
 
+static const struct llapi_copy_ops migrate_copy_ops = {
+	.lco_read	= migrate_copy_read,
+	.lco_write	= migrate_copy_write,
+};
+
+/*
+ * Copy the data of fd_src to fd_dst in stripe-aligned chunks, with one
+ * stream per source stripe (at least two, so that reads and writes overlap)
+ * up to LLAPI_COPY_STREAMS_MAX.
+ */
 static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 			     unsigned long long bandwidth_bytes_sec,
 			     long stats_interval_sec, off_t file_size_bytes)
 {
+	struct migrate_copy mc = {
+		.mc_fd_src	= fd_src,
+		.mc_fd_dst	= fd_dst,
+		.mc_check_file	= check_file,
+	};
+	struct llapi_copy_param param = {
+		.lcp_ops		= &migrate_copy_ops,
+		.lcp_priv		= &mc,
+		.lcp_bandwidth		= bandwidth_bytes_sec,
+		.lcp_stats_interval	= stats_interval_sec,
+		.lcp_stats_size		= file_size_bytes,
+	};
 	struct llapi_layout *layout;
-	size_t buf_size = 64 * ONE_MB;
+	struct llapi_copy *lc;
+	size_t buf_size = MIGRATE_CHUNK_SIZE;
 	uint64_t stripe_size = ONE_MB;
-	void *buf = NULL;
+	uint64_t stripe_count = 1;
 	off_t pos = 0;
 	off_t data_end = 0;
+	off_t copied;
 	ssize_t page_size;
 	bool sparse;
 	int rc;
-	size_t write_bytes = 0;
-	ssize_t read_bytes = 0;
-	struct timespec start_time;
-	struct timespec now;
-	struct timespec last_bw_print;
 
 	layout = llapi_layout_get_by_fd(fd_src, 0);
 	if (layout) {
@@ -934,14 +965,19 @@ static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 				/* Trim to stripe_size multiple */
 				buf_size -= buf_size % stripe_size;
 		}
+		if (llapi_layout_stripe_count_get(layout, &stripe_count) ||
+		    stripe_count > LLAPI_COPY_STREAMS_MAX)
+			stripe_count = LLAPI_COPY_STREAMS_MAX;
 
 		llapi_layout_free(layout);
 	}
+	param.lcp_streams = MAX(stripe_count, 2);
 
-	/* limit transfer size to what can be sent in one second */
-	if (bandwidth_bytes_sec && bandwidth_bytes_sec < buf_size)
-		buf_size = (bandwidth_bytes_sec + stripe_size - 1) &
-			~(stripe_size - 1);
+	/* limit the data in flight to what can be sent in one second */
+	if (bandwidth_bytes_sec &&
+	    bandwidth_bytes_sec < buf_size * param.lcp_streams)
+		buf_size = (bandwidth_bytes_sec / param.lcp_streams +
+			    stripe_size - 1) & ~(stripe_size - 1);
 
 	page_size = sysconf(_SC_PAGESIZE);
 	if (page_size < 0) {
@@ -949,10 +985,10 @@ static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 		return rc;
 	}
 
-	/* Use a page-aligned buffer for direct I/O */
-	rc = posix_memalign(&buf, page_size, buf_size);
-	if (rc != 0)
-		return -rc;
+	param.lcp_chunk_size = buf_size;
+	lc = llapi_copy_init(&param);
+	if (!lc)
+		return -errno;
 
 	sparse = llapi_file_is_sparse(fd_src);
 	if (sparse) {
@@ -961,18 +997,14 @@ static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 			rc = -errno;
 			llapi_error(LLAPI_MSG_ERROR, rc,
 				    "fail to ftruncate dst file to %ld", pos);
-			free(buf);
+			llapi_copy_fini(lc);
 			return rc;
 		}
 	}
 
-	clock_gettime(CLOCK_MONOTONIC, &start_time);
-	now = last_bw_print = start_time;
-
 	while (1) {
 		off_t data_off;
-		size_t to_read, to_write;
-		ssize_t rsize;
+		off_t to_read;
 
 		if (sparse && pos >= data_end) {
 			size_t data_size;
@@ -996,106 +1028,23 @@ static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 			pos = data_off & ~(page_size - 1);
 			data_end = data_off + data_size;
 			to_read = ((data_end - pos - 1) | (page_size - 1)) + 1;
-			to_read = MIN(to_read, buf_size);
 		} else {
-			to_read = buf_size;
+			/* copy everything up to EOF */
+			to_read = LLONG_MAX / 2 - pos;
 		}
 
-		if (check_file) {
-			rc = check_file(fd_src);
-			if (rc < 0) {
-				llapi_error(LLAPI_MSG_ERROR, rc,
-					    "error checking src file");
-				goto out;
-			}
-		}
+		if (to_read <= 0)
+			break;
 
-		rsize = pread(fd_src, buf, to_read, pos);
-		read_bytes += rsize;
-		if (rsize < 0) {
-			rc = -errno;
-			llapi_error(LLAPI_MSG_ERROR, rc,
-				    "error reading src bytes %ld-%ld",
-				    pos, to_read);
+		copied = llapi_copy_range(lc, pos, pos + to_read);
+		if (copied < 0) {
+			rc = copied;
 			goto out;
 		}
 		/* EOF */
-		if (rsize == 0)
-			break;
-
-		to_write = rsize;
-		while (to_write > 0) {
-			unsigned long long write_target;
-			ssize_t written;
-			struct timespec diff;
-
-			written = pwrite(fd_dst, buf, to_write, pos);
-			if (written < 0) {
-				rc = -errno;
-				llapi_error(LLAPI_MSG_ERROR, rc,
-					    "error writing dst bytes %ld-%ld",
-					    pos, to_write);
-				goto out;
-			}
-			pos += written;
-			to_write -= written;
-			write_bytes += written;
-
-			if (bandwidth_bytes_sec == 0)
-				continue;
-
-			clock_gettime(CLOCK_MONOTONIC, &now);
-			diff = timespec_sub(&start_time, &now);
-			write_target = ((bandwidth_bytes_sec * diff.tv_sec) +
-				((bandwidth_bytes_sec *
-				diff.tv_nsec)/NSEC_PER_SEC));
-
-			if (write_target < write_bytes) {
-				unsigned long long excess;
-				struct timespec delay = { 0, 0 };
-
-				excess = write_bytes - write_target;
-
-				if (excess == 0)
-					continue;
-
-				delay.tv_sec = excess / bandwidth_bytes_sec;
-				delay.tv_nsec = (excess % bandwidth_bytes_sec) *
-					NSEC_PER_SEC / bandwidth_bytes_sec;
-
-				do {
-					rc = clock_nanosleep(CLOCK_MONOTONIC, 0,
-							     &delay, &delay);
-				} while (rc < 0 && errno == EINTR);
-
-				if (rc < 0) {
-					if (stats_interval_sec)
-						llapi_error(LLAPI_MSG_WARN, rc,
-							    "delay for bandwidth control failed");
-					rc = 0;
-				}
-			}
-		}
-
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		if (stats_interval_sec && (write_bytes != file_size_bytes) &&
-			(now.tv_sec >= last_bw_print.tv_sec +
-			stats_interval_sec)) {
-			stats_log(&now, &start_time,
-				  read_bytes, write_bytes,
-				  file_size_bytes);
-			last_bw_print = now;
-		}
-
-		if (rc || rsize < to_read)
+		if (copied < pos + to_read)
 			break;
-	}
-
-	/* Output at least one log, regardless of stats_interval */
-	if (stats_interval_sec) {
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		stats_log(&now, &start_time, read_bytes, write_bytes,
-			  file_size_bytes);
+		pos = copied;
 	}
 
 	rc = fsync(fd_dst);
@@ -1105,11 +1054,12 @@ static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int),
 			    "failed to fsync dst file");
 	}
 out:
+	llapi_copy_fini(lc);
+
 	/* Try to avoid page cache pollution after migration. */
 	(void)posix_fadvise(fd_src, 0, 0, POSIX_FADV_DONTNEED);
 	(void)posix_fadvise(fd_dst, 0, 0, POSIX_FADV_DONTNEED);
 
-	free(buf);
 	return rc;
 }
 
@@ -2876,6 +2826,10 @@ struct lfs_setstripe_args {
 	unsigned long long	 lsa_pattern;
 	unsigned int		 lsa_mirror_count;
 	int			 lsa_nr_tgts;
+	__u8			 lsa_dstripe_count;
+	__u8			 lsa_cstripe_count;
+	__u8			 lsa_compr_type;
+	__u8			 lsa_compr_chunk_log_bits;
 	bool			 lsa_first_comp;
 	bool			 lsa_extension_comp;
 	__u32			*lsa_tgts;
@@ -2937,6 +2891,53 @@ static inline bool setstripe_args_specified(struct lfs_setstripe_args *lsa)
 		lsa->lsa_comp_end != 0);
 }
 
+static const struct {
+	const char	*name;
+	__u8		 type;
+} compr_type_names[] = {
+	{ "fast",	LL_COMPR_TYPE_FAST },
+	{ "best",	LL_COMPR_TYPE_BEST },
+	{ "lz4",	LL_COMPR_TYPE_LZ4 },
+	{ "lz4hc",	LL_COMPR_TYPE_LZ4HC },
+	{ "zstd",	LL_COMPR_TYPE_ZSTD },
+	{ "gzip",	LL_COMPR_TYPE_GZIP },
+};
+
+/* parse TYPE[:CHUNK_SIZE] of --compress, chunks are 64KiB by default */
+static int lfs_compress_parse(char *arg, struct lfs_setstripe_args *lsa)
+{
+	unsigned long long chunk_size = COMPR_GET_CHUNK_SIZE(0);
+	unsigned long long size_units = 1;
+	char *chunk;
+	int bits;
+	int i;
+
+	chunk = strchr(arg, ':');
+	if (chunk) {
+		*chunk++ = '\0';
+		if (llapi_parse_size(chunk, &chunk_size, &size_units, 0))
+			return -EINVAL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(compr_type_names); i++)
+		if (strcmp(arg, compr_type_names[i].name) == 0)
+			break;
+	if (i == ARRAY_SIZE(compr_type_names))
+		return -EINVAL;
+
+	/* a power of two, lcme_compr_chunk_log_bits is a 4 bit field */
+	bits = ffsll(chunk_size) - 1;
+	if (bits < 0 || chunk_size != 1ULL << bits ||
+	    chunk_size < COMPR_GET_CHUNK_SIZE(0) ||
+	    chunk_size > COMPR_GET_CHUNK_SIZE(15))
+		return -EINVAL;
+
+	lsa->lsa_compr_type = compr_type_names[i].type;
+	lsa->lsa_compr_chunk_log_bits = bits - COMPR_CHUNK_MIN_BITS;
+
+	return 0;
+}
+
 static int lsa_args_stripe_count_check(struct lfs_setstripe_args *lsa)
 {
 	if (lsa->lsa_nr_tgts) {
@@ -3159,6 +3160,27 @@ new_comp:
 		}
 	}
 
+	if (lsa->lsa_cstripe_count) {
+		rc = llapi_layout_comp_ec_set(layout, lsa->lsa_dstripe_count,
+					      lsa->lsa_cstripe_count);
+		if (rc) {
+			fprintf(stderr, "Set EC stripes %u+%u failed: %s\n",
+				lsa->lsa_dstripe_count, lsa->lsa_cstripe_count,
+				strerror(errno));
+			return rc;
+		}
+	}
+
+	if (lsa->lsa_compr_type != LL_COMPR_TYPE_NONE) {
+		rc = llapi_layout_comp_compress_set(layout, lsa->lsa_compr_type,
+					lsa->lsa_compr_chunk_log_bits);
+		if (rc) {
+			fprintf(stderr, "Set compression %u failed: %s\n",
+				lsa->lsa_compr_type, strerror(errno));
+			return rc;
+		}
+	}
+
 	rc = lsa_args_stripe_count_check(lsa);
 	if (rc)
 		return rc;
@@ -3348,6 +3370,14 @@ static int build_layout_from_yaml_node(struct cYAML *node,
 				} else if (!strcmp(string, "extension_size")) {
 					lsa->lsa_extension_size = node->cy_valueint;
 					lsa->lsa_extension_comp = true;
+				} else if (!strcmp(string,
+						   "lcme_dstripe_count")) {
+					lsa->lsa_dstripe_count =
+						node->cy_valueint;
+				} else if (!strcmp(string,
+						   "lcme_cstripe_count")) {
+					lsa->lsa_cstripe_count =
+						node->cy_valueint;
 				} else if (!strcmp(string, "stripe_offset")) {
 					lsa->lsa_stripe_off = node->cy_valueint;
 				} else if (!strcmp(string, "l_ost_idx")) {
@@ -3704,6 +3734,10 @@ enum {
 	LFS_ATTRS_OPT,
 	LFS_XATTRS_MATCH_OPT,
 	LFS_MIGRATE_NOFIX,
+	LFS_PARITY_COUNT_OPT,
+	LFS_THREADS_OPT,
+	LFS_ORDERED_OPT,
+	LFS_COMPRESS_OPT,
 };
 
 #ifndef LCME_USER_MIRROR_FLAGS
@@ -3763,6 +3797,7 @@ static int lfs_setstripe_internal(int argc, char **argv,
 	unsigned long long bandwidth_bytes_sec = 0;
 	unsigned long long bandwidth_unit = ONE_MB;
 	long stats_interval_sec = 0;
+	unsigned long parity_count = 0;
 
 	struct option long_opts[] = {
 /* find { .val = '0',	.name = "null",		.has_arg = no_argument }, */
@@ -3800,6 +3835,10 @@ static int lfs_setstripe_internal(int argc, char **argv,
 			.name = "mode",		.has_arg = required_argument},
 	{ .val = LFS_LAYOUT_COPY,
 			.name = "copy",		.has_arg = required_argument},
+	{ .val = LFS_PARITY_COUNT_OPT,
+			.name = "parity-count",	.has_arg = required_argument},
+	{ .val = LFS_COMPRESS_OPT,
+			.name = "compress",	.has_arg = required_argument},
 	{ .val = LFS_STATS_OPT,
 			.name = "stats",	.has_arg = no_argument},
 	{ .val = LFS_STATS_INTERVAL_OPT,
@@ -4028,6 +4067,26 @@ static int lfs_setstripe_internal(int argc, char **argv,
 				goto usage_error;
 			}
 			break;
+		case LFS_COMPRESS_OPT:
+			result = lfs_compress_parse(optarg, &lsa);
+			if (result) {
+				fprintf(stderr,
+					"%s %s: invalid compression '%s'\n",
+					progname, argv[0], optarg);
+				goto usage_error;
+			}
+			break;
+		case LFS_PARITY_COUNT_OPT:
+			errno = 0;
+			parity_count = strtoul(optarg, &end, 0);
+			if (errno != 0 || *end != '\0' || parity_count == 0 ||
+			    parity_count > UINT8_MAX) {
+				fprintf(stderr,
+					"%s %s: invalid parity count '%s'\n",
+					progname, argv[0], optarg);
+				goto usage_error;
+			}
+			break;
 		case LFS_MIGRATE_NOFIX:
 			if (!migrate_mode) {
 				fprintf(stderr,
@@ -4494,6 +4553,10 @@ create_mirror:
 			lsa.lsa_comp_end = LUSTRE_EOF;
 	}
 
+	/* a plain striping becomes the data mirror of the EC layout */
+	if (parity_count && !layout && lsa.lsa_comp_end == 0)
+		lsa.lsa_comp_end = LUSTRE_EOF;
+
 	if (lsa.lsa_comp_end != 0) {
 		result = comp_args_to_layout(lpp, &lsa, true);
 		if (result) {
@@ -4504,6 +4567,25 @@ create_mirror:
 		}
 	}
 
+	if (parity_count) {
+		if (!setstripe_mode || comp_add || comp_del || comp_set ||
+		    delete || from_yaml || from_copy || foreign_mode) {
+			fprintf(stderr,
+				"%s %s: --parity-count is only valid when creating a new layout\n",
+				progname, argv[0]);
+			goto usage_error;
+		}
+		result = llapi_layout_ec_parity_add(layout, parity_count);
+		if (result) {
+			fprintf(stderr,
+				"%s %s: cannot add %lu parity stripes to layout: %s\n",
+				progname, argv[0], parity_count,
+				strerror(errno));
+			result = -errno;
+			goto error;
+		}
+	}
+
 	if (mirror_flags & MF_NO_VERIFY) {
 		if (opc != SO_MIRROR_EXTEND) {
 			fprintf(stderr,
@@ -5572,6 +5654,9 @@ static int str2mode_t(const char *input, mode_t *outmode)
 	return ret;
 }
 
+/* upper limit of lfs find --threads */
+#define LFS_FIND_THREADS_MAX	256
+
 static int lfs_find(int argc, char **argv)
 {
 	int c, rc;
@@ -5692,6 +5777,8 @@ static int lfs_find(int argc, char **argv)
 	{ .val = 'n',	.name = "name",		.has_arg = required_argument },
 	{ .val = 'N',	.name = "mirror-count",	.has_arg = required_argument },
 /* find	{ .val = 'o'	.name = "or", .has_arg = no_argument }, like find(1) */
+	{ .val = LFS_ORDERED_OPT,
+			.name = "ordered",	.has_arg = no_argument },
 	{ .val = 'O',	.name = "obd",		.has_arg = required_argument },
 	{ .val = 'O',	.name = "ost",		.has_arg = required_argument },
 	{ .val = LFS_FIND_PERM,
@@ -5713,6 +5800,8 @@ static int lfs_find(int argc, char **argv)
 	{ .val = 'S',	.name = "stripe_size",	.has_arg = required_argument },
 	{ .val = 't',	.name = "type",		.has_arg = required_argument },
 	{ .val = 'T',	.name = "mdt-count",	.has_arg = required_argument },
+	{ .val = LFS_THREADS_OPT,
+			.name = "threads",	.has_arg = required_argument },
 	{ .val = 'u',	.name = "uid",		.has_arg = required_argument },
 	{ .val = 'U',	.name = "user",		.has_arg = required_argument },
 /* getstripe { .val = 'v', .name = "verbose",	.has_arg = no_argument }, */
@@ -6234,6 +6323,19 @@ static int lfs_find(int argc, char **argv)
 			}
 			param.fp_exclude_nlink = !!neg_opt;
 			break;
+		case LFS_THREADS_OPT:
+			errno = 0;
+			param.fp_thread_count = strtoul(optarg, &endptr, 0);
+			if (errno != 0 || *endptr != '\0' ||
+			    param.fp_thread_count < 1 ||
+			    param.fp_thread_count > LFS_FIND_THREADS_MAX) {
+				fprintf(stderr,
+					"error: bad thread count '%s', must be 1-%u\n",
+					optarg, LFS_FIND_THREADS_MAX);
+				ret = -1;
+				goto err;
+			}
+			break;
 		case 'u':
 		case 'U':
 			rc = name2uid(&param.fp_uid, optarg);
@@ -6392,6 +6494,9 @@ static int lfs_find(int argc, char **argv)
 		case '0':
 			param.fp_zero_end = 1;
 			break;
+		case LFS_ORDERED_OPT:
+			param.fp_thread_ordered = 1;
+			break;
 		case 'P': /* we always print, this option is a no-op */
 			break;
 		case LFS_PRINTF_OPT:
@@ -10318,10 +10423,113 @@ reap:
 	return rc;
 }
 
+static void lfs_changelog_print(struct changelog_rec *rec)
+{
+	time_t secs;
+	struct tm ts;
+
+	secs = rec->cr_time >> 30;
+	gmtime_r(&secs, &ts);
+	printf("%ju %02d%-5s %02d:%02d:%02d.%09d %04d.%02d.%02d "
+	       "0x%x t="DFID, (uintmax_t)rec->cr_index, rec->cr_type,
+	       changelog_type2str(rec->cr_type),
+	       ts.tm_hour, ts.tm_min, ts.tm_sec,
+	       (int)(rec->cr_time & ((1 << 30) - 1)),
+	       ts.tm_year + 1900, ts.tm_mon + 1, ts.tm_mday,
+	       rec->cr_flags & CLF_FLAGMASK, PFID(&rec->cr_tfid));
+
+	if (rec->cr_flags & CLF_JOBID) {
+		struct changelog_ext_jobid *jid =
+			changelog_rec_jobid(rec);
+
+		if (jid->cr_jobid[0] != '\0')
+			printf(" j=%s", jid->cr_jobid);
+	}
+
+	if (rec->cr_flags & CLF_EXTRA_FLAGS) {
+		struct changelog_ext_extra_flags *ef =
+			changelog_rec_extra_flags(rec);
+
+		printf(" ef=0x%llx",
+		       (unsigned long long)ef->cr_extra_flags);
+
+		if (ef->cr_extra_flags & CLFE_UIDGID) {
+			struct changelog_ext_uidgid *uidgid =
+				changelog_rec_uidgid(rec);
+
+			printf(" u=%llu:%llu",
+			       (unsigned long long)uidgid->cr_uid,
+			       (unsigned long long)uidgid->cr_gid);
+		}
+		if (ef->cr_extra_flags & CLFE_NID) {
+			if (ef->cr_extra_flags & CLFE_NID_BE) {
+				struct lnet_nid *nid =
+					(void *)changelog_rec_nid(rec);
+				printf(" nid=%s", libcfs_nidstr(nid));
+			} else {
+				struct changelog_ext_nid *nid =
+					changelog_rec_nid(rec);
+
+				printf(" nid=%s",
+				       libcfs_nid2str(nid->cr_nid));
+			}
+		}
+
+		if (ef->cr_extra_flags & CLFE_OPEN) {
+			struct changelog_ext_openmode *omd =
+				changelog_rec_openmode(rec);
+			char mode[] = "---";
+
+			/* exec mode must be exclusive */
+			if (omd->cr_openflags & MDS_FMODE_EXEC) {
+				mode[2] = 'x';
+			} else {
+				if (omd->cr_openflags & MDS_FMODE_READ)
+					mode[0] = 'r';
+				if (omd->cr_openflags &
+				    (MDS_FMODE_WRITE |
+				     MDS_OPEN_TRUNC |
+				     MDS_OPEN_APPEND))
+					mode[1] = 'w';
+			}
+
+			if (strcmp(mode, "---") != 0)
+				printf(" m=%s", mode);
+		}
+
+		if (ef->cr_extra_flags & CLFE_XATTR) {
+			struct changelog_ext_xattr *xattr =
+				changelog_rec_xattr(rec);
+
+			if (xattr->cr_xattr[0] != '\0')
+				printf(" x=%s", xattr->cr_xattr);
+		}
+	}
+
+	if (!fid_is_zero(&rec->cr_pfid))
+		printf(" p="DFID, PFID(&rec->cr_pfid));
+	if (rec->cr_namelen)
+		printf(" %.*s", rec->cr_namelen,
+		       changelog_rec_name(rec));
+
+	if (rec->cr_flags & CLF_RENAME) {
+		struct changelog_ext_rename *rnm =
+			changelog_rec_rename(rec);
+
+		if (!fid_is_zero(&rnm->cr_sfid))
+			printf(" s="DFID" sp="DFID" %.*s",
+			       PFID(&rnm->cr_sfid),
+			       PFID(&rnm->cr_spfid),
+			       (int)changelog_rec_snamelen(rec),
+			       changelog_rec_sname(rec));
+	}
+	printf("\n");
+}
+
 static int lfs_changelog(int argc, char **argv)
 {
 	void *changelog_priv;
-	struct changelog_rec *rec;
+	struct changelog_rec *recs[256];
 	long long startrec = 0, endrec = 0;
 	char *mdd;
 	struct option long_opts[] = {
@@ -10397,117 +10605,24 @@ static int lfs_changelog(int argc, char **argv)
 		return rc;
 	}
 
-	while ((rc = llapi_changelog_recv(changelog_priv, &rec)) == 0) {
-		time_t secs;
-		struct tm ts;
-
-		if (endrec && rec->cr_index > endrec) {
-			llapi_changelog_free(&rec);
-			break;
-		}
-		if (rec->cr_index < startrec) {
-			llapi_changelog_free(&rec);
-			continue;
-		}
-
-		secs = rec->cr_time >> 30;
-		gmtime_r(&secs, &ts);
-		printf("%ju %02d%-5s %02d:%02d:%02d.%09d %04d.%02d.%02d "
-		       "0x%x t="DFID, (uintmax_t)rec->cr_index, rec->cr_type,
-		       changelog_type2str(rec->cr_type),
-		       ts.tm_hour, ts.tm_min, ts.tm_sec,
-		       (int)(rec->cr_time & ((1 << 30) - 1)),
-		       ts.tm_year + 1900, ts.tm_mon + 1, ts.tm_mday,
-		       rec->cr_flags & CLF_FLAGMASK, PFID(&rec->cr_tfid));
-
-		if (rec->cr_flags & CLF_JOBID) {
-			struct changelog_ext_jobid *jid =
-				changelog_rec_jobid(rec);
-
-			if (jid->cr_jobid[0] != '\0')
-				printf(" j=%s", jid->cr_jobid);
-		}
-
-		if (rec->cr_flags & CLF_EXTRA_FLAGS) {
-			struct changelog_ext_extra_flags *ef =
-				changelog_rec_extra_flags(rec);
-
-			printf(" ef=0x%llx",
-			       (unsigned long long)ef->cr_extra_flags);
-
-			if (ef->cr_extra_flags & CLFE_UIDGID) {
-				struct changelog_ext_uidgid *uidgid =
-					changelog_rec_uidgid(rec);
-
-				printf(" u=%llu:%llu",
-				       (unsigned long long)uidgid->cr_uid,
-				       (unsigned long long)uidgid->cr_gid);
-			}
-			if (ef->cr_extra_flags & CLFE_NID) {
-				if (ef->cr_extra_flags & CLFE_NID_BE) {
-					struct lnet_nid *nid =
-						(void *)changelog_rec_nid(rec);
-					printf(" nid=%s", libcfs_nidstr(nid));
-				} else {
-					struct changelog_ext_nid *nid =
-						changelog_rec_nid(rec);
-
-					printf(" nid=%s",
-					       libcfs_nid2str(nid->cr_nid));
-				}
-			}
-
-			if (ef->cr_extra_flags & CLFE_OPEN) {
-				struct changelog_ext_openmode *omd =
-					changelog_rec_openmode(rec);
-				char mode[] = "---";
-
-				/* exec mode must be exclusive */
-				if (omd->cr_openflags & MDS_FMODE_EXEC) {
-					mode[2] = 'x';
-				} else {
-					if (omd->cr_openflags & MDS_FMODE_READ)
-						mode[0] = 'r';
-					if (omd->cr_openflags &
-					    (MDS_FMODE_WRITE |
-					     MDS_OPEN_TRUNC |
-					     MDS_OPEN_APPEND))
-						mode[1] = 'w';
-				}
-
-				if (strcmp(mode, "---") != 0)
-					printf(" m=%s", mode);
-			}
+	/* records point into the reader buffer, nothing to free */
+	while ((rc = llapi_changelog_recv_batch(changelog_priv, recs,
+						ARRAY_SIZE(recs))) > 0) {
+		int i;
 
-			if (ef->cr_extra_flags & CLFE_XATTR) {
-				struct changelog_ext_xattr *xattr =
-					changelog_rec_xattr(rec);
+		for (i = 0; i < rc; i++) {
+			if (endrec && recs[i]->cr_index > endrec)
+				break;
+			if (recs[i]->cr_index < startrec)
+				continue;
 
-				if (xattr->cr_xattr[0] != '\0')
-					printf(" x=%s", xattr->cr_xattr);
-			}
+			lfs_changelog_print(recs[i]);
 		}
 
-		if (!fid_is_zero(&rec->cr_pfid))
-			printf(" p="DFID, PFID(&rec->cr_pfid));
-		if (rec->cr_namelen)
-			printf(" %.*s", rec->cr_namelen,
-			       changelog_rec_name(rec));
-
-		if (rec->cr_flags & CLF_RENAME) {
-			struct changelog_ext_rename *rnm =
-				changelog_rec_rename(rec);
-
-			if (!fid_is_zero(&rnm->cr_sfid))
-				printf(" s="DFID" sp="DFID" %.*s",
-				       PFID(&rnm->cr_sfid),
-				       PFID(&rnm->cr_spfid),
-				       (int)changelog_rec_snamelen(rec),
-				       changelog_rec_sname(rec));
+		if (i < rc) {
+			rc = 0;
+			break;
 		}
-		printf("\n");
-
-		llapi_changelog_free(&rec);
 	}
 
 	llapi_changelog_fini(&changelog_priv);
@@ -10516,7 +10631,7 @@ static int lfs_changelog(int argc, char **argv)
 		fprintf(stderr, "%s changelog: cannot access changelog: %s\n",
 			progname, strerror(errno = -rc));
 
-	return (rc == 1 ? 0 : rc);
+	return rc;
 }
 
 static int lfs_changelog_clear(int argc, char **argv)
@@ -13597,7 +13712,9 @@ int lfs_mirror_prepare_chunk(struct llapi_layout *layout,
 				goto error;
 			}
 
-			if (flags & LCME_FL_STALE || flags & LCME_FL_OFFLINE)
+			/* EC parity is not a copy of the data */
+			if (flags & LCME_FL_STALE || flags & LCME_FL_OFFLINE ||
+			    flags & LCME_FL_PARITY)
 				goto next;
 
 			rc = llapi_layout_mirror_id_get(layout, &mirror_id);
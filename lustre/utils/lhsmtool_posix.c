@@ -62,6 +62,7 @@
 #include <lustre/lustreapi.h>
 #include "lstddef.h"
 #include "pid_file.h"
+#include "libhsm_scanner.h"
 
 /* Progress reporting period */
 #define REPORT_INTERVAL_DEFAULT 30
@@ -146,6 +147,7 @@ struct options {
 	char			*o_src; /* for import, or rebind */
 	char			*o_dst; /* for import, or rebind */
 	char			*o_pid_file;
+	int			 o_threads; /* archive scanning threads */
 };
 
 /* everything else is zeroed */
@@ -166,8 +168,10 @@ struct options opt = {
 
 static int arc_fd = -1;
 
+/* bumped concurrently by the copy threads and the import scan threads */
 static int err_major;
 static int err_minor;
+#define ct_err_inc(err)	__atomic_add_fetch(&(err), 1, __ATOMIC_RELAXED)
 
 static char cmd_name[PATH_MAX];
 static char fs_name[MAX_OBD_NAME + 1];
@@ -254,6 +258,7 @@ static void usage(const char *name, int rc)
 	"   -P, --pid-file=PATH       Lock and write PID to PATH\n"
 	"   -p, --hsm-root <path>     Target HSM mount point\n"
 	"   -q, --quiet               Produce less verbose output\n"
+	"   -t, --threads <n>         Threads scanning the archive for --import\n"
 	"   -u, --update-interval <s> Interval between progress reports sent\n"
 	"                             to Coordinator\n"
 	"   -v, --verbose             Produce more verbose output\n",
@@ -303,6 +308,7 @@ static int ct_parseopts(int argc, char * const *argv)
 	{ .val = 'p',	.name = "hsm_root",	.has_arg = required_argument },
 	{ .val = 'q',	.name = "quiet",	.has_arg = no_argument },
 	{ .val = 'r',	.name = "rebind",	.has_arg = no_argument },
+	{ .val = 't',	.name = "threads",	.has_arg = required_argument },
 	{ .val = 'u',	.name = "update-interval",
 						.has_arg = required_argument },
 	{ .val = 'u',	.name = "update_interval",
@@ -324,7 +330,7 @@ static int ct_parseopts(int argc, char * const *argv)
 	if (opt.o_archive_id == NULL)
 		return -ENOMEM;
 repeat:
-	while ((c = getopt_long(argc, argv, "A:b:C:c:F:f:hiMp:P:qrU:u:v",
+	while ((c = getopt_long(argc, argv, "A:b:C:c:F:f:hiMp:P:qrt:U:u:v",
 				long_opts, NULL)) != -1) {
 		switch (c) {
 		case 'A': {
@@ -429,6 +435,15 @@ repeat:
 		case 'r':
 			opt.o_action = CA_REBIND;
 			break;
+		case 't':
+			opt.o_threads = atoi(optarg);
+			if (opt.o_threads < 1) {
+				rc = -EINVAL;
+				CT_ERROR(rc, "bad value for -%c '%s'", c,
+					 optarg);
+				return rc;
+			}
+			break;
 		case 'u':
 			opt.o_report_int = atoi(optarg);
 			if (opt.o_report_int < 0) {
@@ -860,7 +875,7 @@ out:
 			rc = -errno;
 			CT_ERROR(rc, "cannot truncate '%s' to size %jd",
 				 dst, (intmax_t)src_st.st_size);
-			err_major++;
+			ct_err_inc(err_major);
 		}
 	}
 
@@ -1275,12 +1290,12 @@ static int ct_archive(const struct hsm_action_item *hai, const long hal_flags)
 	}
 fini_minor:
 	if (rcf)
-		err_minor++;
+		ct_err_inc(err_minor);
 	goto out;
 
 
 fini_major:
-	err_major++;
+	ct_err_inc(err_major);
 
 	unlink(dst);
 	if (ct_is_retryable(rc))
@@ -1386,7 +1401,7 @@ static int ct_restore(const struct hsm_action_item *hai, const long hal_flags)
 		if (rc < 0) {
 			CT_ERROR(rc, "cannot restore file striping info"
 				 " for '%s' from '%s'", dst, src);
-			err_major++;
+			ct_err_inc(err_major);
 			goto fini;
 		}
 	}
@@ -1395,7 +1410,7 @@ static int ct_restore(const struct hsm_action_item *hai, const long hal_flags)
 	if (rc < 0) {
 		CT_ERROR(rc, "cannot copy data from '%s' to '%s'",
 			 src, dst);
-		err_major++;
+		ct_err_inc(err_major);
 		if (ct_is_retryable(rc))
 			hp_flags |= HP_FLAG_RETRY;
 		goto fini;
@@ -1440,7 +1455,7 @@ static int ct_remove(const struct hsm_action_item *hai, const long hal_flags)
 	if (rc < 0) {
 		rc = -errno;
 		CT_ERROR(rc, "cannot unlink '%s'", dst);
-		err_minor++;
+		ct_err_inc(err_minor);
 		goto fini;
 	}
 
@@ -1449,7 +1464,7 @@ static int ct_remove(const struct hsm_action_item *hai, const long hal_flags)
 	if (rc < 0) {
 		rc = -errno;
 		CT_ERROR(rc, "cannot unlink '%s'", attr);
-		err_minor++;
+		ct_err_inc(err_minor);
 
 		/* ignore the error when lov file does not exist. */
 		if (rc == -ENOENT)
@@ -1504,14 +1519,14 @@ static int ct_process_item(struct hsm_action_item *hai, const long hal_flags)
 		/* Don't report progress to coordinator for this cookie:
 		 * the copy function will get ECANCELED when reporting
 		 * progress. */
-		err_minor++;
+		ct_err_inc(err_minor);
 		return 0;
 		break;
 	default:
 		rc = -EINVAL;
 		CT_ERROR(rc, "unknown action %d, on '%s'", hai->hai_action,
 			 opt.o_mnt);
-		err_minor++;
+		ct_err_inc(err_minor);
 		ct_fini(NULL, hai, 0, rc);
 	}
 
@@ -1613,7 +1628,7 @@ static int ct_import_one(const char *src, const char *dst)
 	rc = ct_mkdir_p(newarc);
 	if (rc < 0) {
 		CT_ERROR(rc, "mkdir_p '%s' failed", newarc);
-		err_major++;
+		ct_err_inc(err_major);
 		return rc;
 
 	}
@@ -1623,7 +1638,7 @@ static int ct_import_one(const char *src, const char *dst)
 	if (rc < 0) {
 		rc = -errno;
 		CT_ERROR(rc, "cannot link '%s' to '%s'", newarc, src);
-		err_major++;
+		ct_err_inc(err_major);
 		return rc;
 	}
 	CT_TRACE("imported '%s' from '%s'=='%s'", dst, newarc, src);
@@ -1664,12 +1679,57 @@ static int ct_import_fid(const struct lu_fid *import_fid)
 	return ct_import_one(fid_path, opt.o_dst);
 }
 
+/* Import a file found by the archive scan under the same relative path */
+static int ct_import_scan(const char *pname, const char *fname,
+			  struct hsm_scan_control *hsc, void *ctx)
+{
+	char src[PATH_MAX];
+	char dst[PATH_MAX];
+	const char *relpath;
+	int rc;
+
+	relpath = pname + strlen(opt.o_hsm_root);
+	while (*relpath == '/')
+		relpath++;
+
+	snprintf(src, sizeof(src), "%s/%s", pname, fname);
+	snprintf(dst, sizeof(dst), "%s/%s/%s", opt.o_dst, relpath, fname);
+	/* Make the target dir in the Lustre fs */
+	rc = ct_mkdir_p(dst);
+	if (rc == 0) {
+		/* Import the file */
+		rc = ct_import_one(src, dst);
+	} else {
+		CT_ERROR(rc, "ct_mkdir_p '%s' failed", dst);
+		ct_err_inc(err_major);
+	}
+
+	if (rc != 0) {
+		CT_ERROR(rc, "cannot import '%s/%s'", relpath, fname);
+		/* stop the scan only on major errors */
+		if (!(err_major && opt.o_abort_on_error))
+			rc = 0;
+	}
+
+	return rc;
+}
+
 static int ct_import_recurse(const char *relpath)
 {
-	DIR		*dir;
-	struct dirent	*ent;
-	char		*srcpath, *newpath;
+	struct hsm_scan_control hsc = {
+		.hsc_type = opt.o_archive_format == CT_ARCHIVE_FORMAT_V2 ?
+			    HSMTOOL_POSIX_V2 : HSMTOOL_POSIX_V1,
+		.hsc_mntpath = opt.o_mnt,
+		.hsc_mntfd = -1,
+		.hsc_func = ct_import_scan,
+		.hsc_threads = opt.o_threads,
+		.hsc_abort_on_error = true,
+		/* import whatever the archive holds, as a plain walk did */
+		.hsc_all_entries = true,
+	};
 	struct lu_fid	 import_fid;
+	char		*srcpath;
+	struct stat	 st;
 	int		 rc;
 
 	if (relpath == NULL)
@@ -1682,72 +1742,34 @@ static int ct_import_recurse(const char *relpath)
 
 	srcpath = path_concat(opt.o_hsm_root, relpath);
 	if (srcpath == NULL) {
-		err_major++;
+		ct_err_inc(err_major);
 		return -ENOMEM;
 	}
 
-	dir = opendir(srcpath);
-	if (dir == NULL) {
-		/* Not a dir, or error */
-		if (errno == ENOTDIR) {
-			/* Single regular file case, treat o_dst as absolute
-			   final location. */
-			rc = ct_import_one(srcpath, opt.o_dst);
-		} else {
-			rc = -errno;
-			CT_ERROR(rc, "cannot opendir '%s'", srcpath);
-			err_major++;
-		}
-		free(srcpath);
-		return rc;
+	if (stat(srcpath, &st) < 0) {
+		rc = -errno;
+		CT_ERROR(rc, "cannot stat '%s'", srcpath);
+		ct_err_inc(err_major);
+		goto out;
 	}
-	free(srcpath);
-
-	while ((ent = readdir(dir)) != NULL) {
-		if (!strcmp(ent->d_name, ".") ||
-		    !strcmp(ent->d_name, ".."))
-			continue;
-
-		/* New relative path */
-		newpath = path_concat(relpath, ent->d_name);
-		if (newpath == NULL) {
-			err_major++;
-			rc = -ENOMEM;
-			goto out;
-		}
-
-		if (ent->d_type == DT_DIR) {
-			rc = ct_import_recurse(newpath);
-		} else {
-			char src[PATH_MAX];
-			char dst[PATH_MAX];
-
-			sprintf(src, "%s/%s", opt.o_hsm_root, newpath);
-			sprintf(dst, "%s/%s", opt.o_dst, newpath);
-			/* Make the target dir in the Lustre fs */
-			rc = ct_mkdir_p(dst);
-			if (rc == 0) {
-				/* Import the file */
-				rc = ct_import_one(src, dst);
-			} else {
-				CT_ERROR(rc, "ct_mkdir_p '%s' failed", dst);
-				err_major++;
-			}
-		}
 
-		if (rc != 0) {
-			CT_ERROR(rc, "cannot import '%s'", newpath);
-			if (err_major && opt.o_abort_on_error) {
-				free(newpath);
-				goto out;
-			}
-		}
-		free(newpath);
+	if (!S_ISDIR(st.st_mode)) {
+		/* Single regular file case, treat o_dst as absolute
+		 * final location. */
+		rc = ct_import_one(srcpath, opt.o_dst);
+		goto out;
 	}
 
-	rc = 0;
+	hsc.hsc_hsmpath = srcpath;
+	rc = hsm_scan_process(&hsc);
+	CT_TRACE("import scanned %llu dirs %llu files in %.3fs, %.0f files/s",
+		 hsc.hsc_dirs, hsc.hsc_files, hsc.hsc_elapsed,
+		 hsc.hsc_elapsed > 0 ? hsc.hsc_files / hsc.hsc_elapsed : 0.0);
+	/* errors on single files were reported already */
+	if (!(err_major && opt.o_abort_on_error))
+		rc = 0;
 out:
-	closedir(dir);
+	free(srcpath);
 	return rc;
 }
 
@@ -1845,12 +1867,12 @@ static int ct_rebind_list(const char *list)
 		if (rc) {
 error:			CT_ERROR(rc, "%s:%u: two FIDs expected in '%s'",
 				 list, nl, line);
-			err_major++;
+			ct_err_inc(err_major);
 			continue;
 		}
 
 		if (ct_rebind_one(&old_fid, &new_fid))
-			err_major++;
+			ct_err_inc(err_major);
 		else
 			ok++;
 	}
@@ -2227,7 +2249,7 @@ static int ct_run(void)
 		} else if (rc < 0) {
 			CT_WARN("cannot receive action list: %s",
 				strerror(-rc));
-			err_major++;
+			ct_err_inc(err_major);
 			if (opt.o_abort_on_error)
 				break;
 			else
@@ -2241,7 +2263,7 @@ static int ct_run(void)
 			rc = -EINVAL;
 			CT_ERROR(rc, "'%s' invalid fs name, expecting: %s",
 				 hal->hal_fsname, fs_name);
-			err_major++;
+			ct_err_inc(err_major);
 			if (opt.o_abort_on_error)
 				break;
 			else
@@ -2255,7 +2277,7 @@ static int ct_run(void)
 				CT_ERROR(rc,
 					 "'%s' item %d past end of message!",
 					 opt.o_mnt, i);
-				err_major++;
+				ct_err_inc(err_major);
 				break;
 			}
 			rc = ct_process_item_async(hai, hal->hal_flags);
@@ -35,19 +35,58 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <libcfs/util/list.h>
 #include "libhsm_scanner.h"
 
+/* directory entries are read in batches of this size with getdents64() */
+#define HSM_SCAN_BUFSIZE	(64 << 10)
+/* directories queued per thread, further ones are scanned in place */
+#define HSM_SCAN_QUEUE_MAX	1024
+#define HSM_SCAN_THREADS_MAX	64
+
+struct hsm_dirent64 {
+	uint64_t	d_ino;
+	int64_t		d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char		d_name[];
+};
+
 struct hsm_scan_item {
 	struct list_head	hsi_item;
 	int			hsi_depth;
 	char			hsi_pathname[PATH_MAX];
 };
 
-static int hsm_scan_item_alloc(struct list_head *head,
-			       const char *pathname, int depth)
+/* directory queue shared by the scanning threads */
+struct hsm_scan_state {
+	struct hsm_scan_control	*hss_hsc;
+	pthread_mutex_t		 hss_lock;
+	pthread_cond_t		 hss_cond;
+	struct list_head	 hss_queue;
+	int			 hss_queued;
+	int			 hss_queue_max;
+	int			 hss_busy; /* threads scanning a directory */
+	int			 hss_rc;
+	bool			 hss_stop;
+};
+
+struct hsm_scan_thread {
+	struct hsm_scan_state	*hst_state;
+	pthread_t		 hst_thread;
+	void			*hst_ctx;
+	char			*hst_buf;
+	unsigned long long	 hst_dirs;
+	unsigned long long	 hst_files;
+};
+
+static struct hsm_scan_item *hsm_scan_item_alloc(const char *pathname,
+						 int depth)
 {
 	struct hsm_scan_item *item;
 	int rc;
@@ -56,7 +95,8 @@ static int hsm_scan_item_alloc(struct list_head *head,
 		rc = -ENAMETOOLONG;
 		llapi_error(LLAPI_MSG_ERROR, rc,
 			    "pathname is too long: %s\n", pathname);
-		return rc;
+		errno = ENAMETOOLONG;
+		return NULL;
 	}
 
 	item = malloc(sizeof(struct hsm_scan_item));
@@ -64,57 +104,146 @@ static int hsm_scan_item_alloc(struct list_head *head,
 		rc = -ENOMEM;
 		llapi_error(LLAPI_MSG_ERROR, rc,
 			    "cannot allocate hsm item for '%s'", pathname);
-		return rc;
+		errno = ENOMEM;
+		return NULL;
 	}
 
 	item->hsi_depth = depth;
 	strncpy(item->hsi_pathname, pathname, sizeof(item->hsi_pathname) - 1);
-	list_add_tail(&item->hsi_item, head);
+	item->hsi_pathname[sizeof(item->hsi_pathname) - 1] = '\0';
+
+	return item;
+}
+
+static int hsm_scan_handle_dir(struct hsm_scan_thread *hst,
+			       struct hsm_scan_item *item, char *buf);
+
+/*
+ * Queue a subdirectory for any thread to scan, or scan it right away when
+ * the queue is full so that its size stays bounded. The caller is still
+ * walking its own getdents buffer, so the nested scan needs a new one.
+ */
+static int hsm_scan_queue_dir(struct hsm_scan_thread *hst,
+			      const char *pathname, int depth)
+{
+	struct hsm_scan_state *hss = hst->hst_state;
+	struct hsm_scan_item *item;
+	bool queued = false;
+	char *buf;
+	int rc;
+
+	item = hsm_scan_item_alloc(pathname, depth);
+	if (item == NULL)
+		return -errno;
+
+	pthread_mutex_lock(&hss->hss_lock);
+	if (hss->hss_queued < hss->hss_queue_max) {
+		list_add_tail(&item->hsi_item, &hss->hss_queue);
+		hss->hss_queued++;
+		pthread_cond_signal(&hss->hss_cond);
+		queued = true;
+	}
+	pthread_mutex_unlock(&hss->hss_lock);
+
+	if (queued)
+		return 0;
 
-	return 0;
+	buf = malloc(HSM_SCAN_BUFSIZE);
+	if (buf == NULL) {
+		free(item);
+		return -ENOMEM;
+	}
+	rc = hsm_scan_handle_dir(hst, item, buf);
+	free(buf);
+	free(item);
+
+	return rc;
 }
 
-int hsm_scan_handle_dir(struct hsm_scan_control *hsc, struct list_head *head,
-			struct hsm_scan_item *item)
+static void hsm_scan_error(struct hsm_scan_thread *hst)
 {
+	struct hsm_scan_state *hss = hst->hst_state;
+
+	pthread_mutex_lock(&hss->hss_lock);
+	hss->hss_hsc->hsc_errnum++;
+	if (hss->hss_hsc->hsc_abort_on_error) {
+		hss->hss_stop = true;
+		pthread_cond_broadcast(&hss->hss_cond);
+	}
+	pthread_mutex_unlock(&hss->hss_lock);
+}
+
+static int hsm_scan_handle_dir(struct hsm_scan_thread *hst,
+			       struct hsm_scan_item *item, char *buf)
+{
+	struct hsm_scan_state *hss = hst->hst_state;
+	struct hsm_scan_control *hsc = hss->hss_hsc;
 	char fullname[PATH_MAX + NAME_MAX + 1];
 	const char *pathname = item->hsi_pathname;
 	int depth = item->hsi_depth;
-	struct dirent *ent;
-	DIR *dir;
+	struct hsm_dirent64 *ent;
+	unsigned char type;
+	struct stat st;
+	ssize_t nread;
+	ssize_t off;
 	int ret;
 	int rc = 0;
+	int fd;
 
-	dir = opendir(pathname);
-	if (dir == NULL) {
+	fd = open(pathname, O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
 		rc = -errno;
 		llapi_error(LLAPI_MSG_ERROR, rc, "failed to opendir '%s'",
 			    pathname);
 		return rc;
 	}
 
-	while ((ent = readdir(dir)) != NULL) {
-		/* skip "." and ".." */
-		if (strcmp(ent->d_name, ".") == 0 ||
-		    strcmp(ent->d_name, "..") == 0)
-			continue;
+	while (!hss->hss_stop) {
+		nread = syscall(SYS_getdents64, fd, buf, HSM_SCAN_BUFSIZE);
+		if (nread < 0) {
+			rc = -errno;
+			llapi_error(LLAPI_MSG_ERROR, rc,
+				    "failed to read dir '%s'", pathname);
+			break;
+		}
+		if (nread == 0)
+			break;
+
+		for (off = 0; off < nread && !hss->hss_stop;
+		     off += ent->d_reclen) {
+			ent = (struct hsm_dirent64 *)(buf + off);
+
+			/* skip "." and ".." */
+			if (strcmp(ent->d_name, ".") == 0 ||
+			    strcmp(ent->d_name, "..") == 0)
+				continue;
+
+			type = ent->d_type;
+			if (type == DT_UNKNOWN &&
+			    fstatat(fd, ent->d_name, &st,
+				    AT_SYMLINK_NOFOLLOW) == 0)
+				type = IFTODT(st.st_mode);
 
-		llapi_printf(LLAPI_MSG_DEBUG,
-			     "check file %d:'%s' under directory '%s'\n",
-			     depth, ent->d_name, pathname);
-		if (depth == 0 && ent->d_type == DT_DIR &&
-		    strcmp(ent->d_name, "shadow") == 0) {
 			llapi_printf(LLAPI_MSG_DEBUG,
-				     "skipping check of 'shadow' directory.\n");
-		} else {
-			if (ent->d_type == DT_REG) {
-				ret = hsc->hsc_func(pathname, ent->d_name, hsc);
-				if (ret && !rc) {
-					hsc->hsc_errnum++;
-					rc = ret;
+				     "check file %d:'%s' under directory '%s'\n",
+				     depth, ent->d_name, pathname);
+			if (depth == 0 && type == DT_DIR &&
+			    !hsc->hsc_all_entries &&
+			    strcmp(ent->d_name, "shadow") == 0) {
+				llapi_printf(LLAPI_MSG_DEBUG,
+					     "skipping check of 'shadow' directory.\n");
+			} else if (type == DT_REG ||
+				   (hsc->hsc_all_entries && type != DT_DIR)) {
+				hst->hst_files++;
+				ret = hsc->hsc_func(pathname, ent->d_name, hsc,
+						    hst->hst_ctx);
+				if (ret) {
+					hsm_scan_error(hst);
+					if (!rc)
+						rc = ret;
 					/* ignore error, continue to check */
 				}
-			} else if (ent->d_type == DT_DIR) {
+			} else if (type == DT_DIR) {
 				if (strlen(ent->d_name) + strlen(pathname) + 1
 				    >= sizeof(fullname)) {
 					rc = -ENAMETOOLONG;
@@ -123,32 +252,76 @@ int hsm_scan_handle_dir(struct hsm_scan_control *hsc, struct list_head *head,
 							  "ignore too long path: %s/%s\n",
 							  pathname,
 							  ent->d_name);
-					hsc->hsc_errnum++;
+					hsm_scan_error(hst);
 					continue;
 				}
-				snprintf(fullname, sizeof(fullname), "%s/%s",
-					 pathname, ent->d_name);
-				rc = hsm_scan_item_alloc(head, fullname,
-							 depth + 1);
+				snprintf(fullname, sizeof(fullname), "%s/%.*s",
+					 pathname, NAME_MAX, ent->d_name);
+				rc = hsm_scan_queue_dir(hst, fullname,
+							depth + 1);
 			}
 		}
 	}
+	hst->hst_dirs++;
 
 	if (rc)
 		llapi_error(LLAPI_MSG_ERROR, rc, "failed to handle dir '%s'",
 			    pathname);
 
-	closedir(dir);
+	close(fd);
 	return rc;
 }
 
+static void *hsm_scan_thread_main(void *arg)
+{
+	struct hsm_scan_thread *hst = arg;
+	struct hsm_scan_state *hss = hst->hst_state;
+	struct hsm_scan_item *item;
+	int rc;
+
+	pthread_mutex_lock(&hss->hss_lock);
+	while (1) {
+		while (list_empty(&hss->hss_queue) && hss->hss_busy > 0 &&
+		       !hss->hss_stop)
+			pthread_cond_wait(&hss->hss_cond, &hss->hss_lock);
+		/* nothing queued and nobody left to queue more */
+		if (hss->hss_stop || list_empty(&hss->hss_queue))
+			break;
+
+		item = list_entry(hss->hss_queue.next, struct hsm_scan_item,
+				  hsi_item);
+		list_del(&item->hsi_item);
+		hss->hss_queued--;
+		hss->hss_busy++;
+		pthread_mutex_unlock(&hss->hss_lock);
+
+		rc = hsm_scan_handle_dir(hst, item, hst->hst_buf);
+		free(item);
+
+		pthread_mutex_lock(&hss->hss_lock);
+		if (rc && !hss->hss_rc)
+			hss->hss_rc = rc;
+		hss->hss_busy--;
+	}
+	pthread_cond_broadcast(&hss->hss_cond);
+	pthread_mutex_unlock(&hss->hss_lock);
+
+	return NULL;
+}
+
 int hsm_scan_process(struct hsm_scan_control *hsc)
 {
+	struct hsm_scan_state hss = {
+		.hss_hsc = hsc,
+	};
+	struct hsm_scan_thread *threads;
 	struct hsm_scan_item *item;
-	struct list_head head;
+	struct timespec start, end;
+	int nthreads = hsc->hsc_threads;
+	int started;
 	struct stat st;
-	int ret = 0;
 	int rc;
+	int i;
 
 	if (hsc->hsc_type != HSMTOOL_POSIX_V1 &&
 	    hsc->hsc_type != HSMTOOL_POSIX_V2)
@@ -168,19 +341,92 @@ int hsm_scan_process(struct hsm_scan_control *hsc)
 		return -EINVAL;
 	}
 
-	INIT_LIST_HEAD(&head);
-	rc = hsm_scan_item_alloc(&head, hsc->hsc_hsmpath, 0);
-	if (rc)
-		return rc;
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > HSM_SCAN_THREADS_MAX)
+		nthreads = HSM_SCAN_THREADS_MAX;
 
-	while (!list_empty(&head)) {
-		item = list_entry(head.next, struct hsm_scan_item, hsi_item);
+	threads = calloc(nthreads, sizeof(*threads));
+	if (threads == NULL)
+		return -ENOMEM;
+
+	INIT_LIST_HEAD(&hss.hss_queue);
+	hss.hss_queue_max = HSM_SCAN_QUEUE_MAX * nthreads;
+	pthread_mutex_init(&hss.hss_lock, NULL);
+	pthread_cond_init(&hss.hss_cond, NULL);
+	hsc->hsc_dirs = 0;
+	hsc->hsc_files = 0;
+
+	item = hsm_scan_item_alloc(hsc->hsc_hsmpath, 0);
+	if (item == NULL) {
+		rc = -errno;
+		goto out_free;
+	}
+	list_add_tail(&item->hsi_item, &hss.hss_queue);
+	hss.hss_queued++;
+
+	for (i = 0; i < nthreads; i++) {
+		threads[i].hst_state = &hss;
+		threads[i].hst_buf = malloc(HSM_SCAN_BUFSIZE);
+		if (threads[i].hst_buf == NULL) {
+			rc = -ENOMEM;
+			goto out_fini;
+		}
+		if (hsc->hsc_ctx_init) {
+			threads[i].hst_ctx = hsc->hsc_ctx_init(hsc);
+			if (threads[i].hst_ctx == NULL) {
+				rc = errno ? -errno : -ENOMEM;
+				goto out_fini;
+			}
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	/* the calling thread is the first scanning thread */
+	for (started = 1; started < nthreads; started++) {
+		rc = pthread_create(&threads[started].hst_thread, NULL,
+				    hsm_scan_thread_main, &threads[started]);
+		if (rc) {
+			llapi_error(LLAPI_MSG_WARN, -rc,
+				    "cannot start scanning thread %d", started);
+			break;
+		}
+	}
+	hsm_scan_thread_main(&threads[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i].hst_thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	rc = hss.hss_rc;
+	for (i = 0; i < nthreads; i++) {
+		hsc->hsc_dirs += threads[i].hst_dirs;
+		hsc->hsc_files += threads[i].hst_files;
+	}
+	hsc->hsc_elapsed = (end.tv_sec - start.tv_sec) +
+			   (end.tv_nsec - start.tv_nsec) / 1e9;
+	llapi_printf(LLAPI_MSG_DEBUG,
+		     "scanned %llu dirs %llu files in %.3fs with %d threads, %.0f files/s\n",
+		     hsc->hsc_dirs, hsc->hsc_files, hsc->hsc_elapsed,
+		     started, hsc->hsc_elapsed > 0 ?
+		     hsc->hsc_files / hsc->hsc_elapsed : 0.0);
+
+out_fini:
+	for (i = 0; i < nthreads; i++) {
+		if (threads[i].hst_ctx && hsc->hsc_ctx_fini)
+			hsc->hsc_ctx_fini(hsc, threads[i].hst_ctx);
+		free(threads[i].hst_buf);
+	}
+	/* left over when the scan was stopped */
+	while (!list_empty(&hss.hss_queue)) {
+		item = list_entry(hss.hss_queue.next, struct hsm_scan_item,
+				  hsi_item);
 		list_del(&item->hsi_item);
-		ret = hsm_scan_handle_dir(hsc, &head, item);
-		if (!rc && ret)
-			rc = ret;
 		free(item);
 	}
+out_free:
+	pthread_cond_destroy(&hss.hss_cond);
+	pthread_mutex_destroy(&hss.hss_lock);
+	free(threads);
 
 	return rc;
 }
@@ -34,8 +34,14 @@
 
 struct hsm_scan_control;
 
+/*
+ * Called for each regular file \a fname in directory \a pname, or for each
+ * entry but directories with hsc_all_entries. With hsc_threads > 1 it is
+ * called concurrently from several threads, each passing the \a ctx
+ * returned by hsc_ctx_init() for that thread.
+ */
 typedef int (*hsm_scan_func_t)(const char *pname, const char *fname,
-			       struct hsm_scan_control *hsc);
+			       struct hsm_scan_control *hsc, void *ctx);
 
 struct hsm_scan_control {
 	enum hsmtool_type	 hsc_type;
@@ -44,6 +50,23 @@ struct hsm_scan_control {
 	hsm_scan_func_t		 hsc_func;
 	int			 hsc_errnum;
 	int			 hsc_mntfd;
+	/* scanning threads, the calling thread scans alone if 0 or 1 */
+	int			 hsc_threads;
+	/* stop scanning once hsc_func returns an error */
+	bool			 hsc_abort_on_error;
+	/*
+	 * call hsc_func on every entry that is not a directory, not only on
+	 * regular files, and do not skip the top "shadow" directory
+	 */
+	bool			 hsc_all_entries;
+	/* optional, create and destroy the context of each thread */
+	void		      *(*hsc_ctx_init)(struct hsm_scan_control *hsc);
+	void			(*hsc_ctx_fini)(struct hsm_scan_control *hsc,
+						void *ctx);
+	/* filled in by hsm_scan_process() */
+	unsigned long long	 hsc_dirs;
+	unsigned long long	 hsc_files;
+	double			 hsc_elapsed; /* seconds */
 };
 
 int hsm_scan_process(struct hsm_scan_control *hsc);
@@ -76,6 +76,7 @@
 #include <pthread.h>
 
 #include <libcfs/util/ioctl.h>
+#include <libcfs/util/list.h>
 #include <libcfs/util/param.h>
 #include <libcfs/util/string.h>
 #include <linux/lnet/lnetctl.h>
@@ -1526,6 +1527,211 @@ typedef int (semantic_func_t)(char *path, int p, int *d,
 
 #define OBD_NOT_FOUND           (-1)
 
+/*
+ * With fp_thread_count > 1, llapi_find() scans the tree with a pool of
+ * threads.  Every directory found is queued on the work queue of the MDT
+ * holding it, so that the directories of a striped directory spread over
+ * the MDTs.  A thread takes the most recently queued directory of its own
+ * queue, and steals the oldest directory of another queue, likely the root
+ * of a large subtree, when its own queue is empty.
+ *
+ * If fp_thread_ordered is set, the output of each directory is kept in the
+ * list of its work item, with a marker where the output of a subdirectory
+ * goes, and printed as soon as everything before it in the order of a
+ * serial scan has been printed.
+ */
+struct find_work_item {
+	struct list_head	 fwi_link;	/* on fwq_queues[] */
+	struct find_work_item	*fwi_parent;
+	struct list_head	 fwi_out;	/* list of find_out_seg */
+	bool			 fwi_done;
+	bool			 fwi_has_de;
+	int			 fwi_queue;
+	unsigned int		 fwi_depth;
+	struct dirent64		 fwi_de;
+	char			 fwi_path[];
+};
+
+struct find_out_seg {
+	struct list_head	 fos_link;
+	/* output of this subdirectory goes here, or fos_text */
+	struct find_work_item	*fos_child;
+	size_t			 fos_len;
+	char			 fos_text[];
+};
+
+struct find_workq {
+	pthread_mutex_t		 fwq_lock;
+	pthread_cond_t		 fwq_cond;
+	struct list_head	*fwq_queues;	/* one per MDT */
+	int			 fwq_nqueues;
+	int			 fwq_queued;	/* directories waiting */
+	int			 fwq_busy;	/* directories being scanned */
+	bool			 fwq_stop;
+	int			 fwq_rc;
+	pthread_mutex_t		 fwq_out_lock;
+	struct find_work_item	*fwq_out_cur;	/* directory printed now */
+};
+
+struct find_thread {
+	struct find_workq	*ft_wq;
+	struct find_param	 ft_param;
+	struct find_work_item	*ft_item;	/* directory being scanned */
+	int			 ft_home;	/* queue scanned first */
+	char			*ft_path;
+	pthread_t		 ft_tid;
+	bool			 ft_started;
+};
+
+/* write @len bytes of find output, which may contain NUL with --print0 */
+static void find_out_write(const char *text, size_t len)
+{
+	while (len > 0) {
+		size_t n = strnlen(text, len);
+
+		if (n > 0)
+			llapi_printf(LLAPI_MSG_NORMAL, "%.*s", (int)n, text);
+		if (n < len) {
+			llapi_printf(LLAPI_MSG_NORMAL, "%c", '\0');
+			n++;
+		}
+		text += n;
+		len -= n;
+	}
+}
+
+/* print what can be printed in serial order, called with fwq_out_lock */
+static void find_out_emit(struct find_workq *wq)
+{
+	struct find_work_item *item;
+
+	while ((item = wq->fwq_out_cur) != NULL) {
+		struct find_out_seg *seg;
+
+		if (list_empty(&item->fwi_out)) {
+			if (!item->fwi_done)
+				break;
+			wq->fwq_out_cur = item->fwi_parent;
+			free(item);
+			continue;
+		}
+
+		seg = list_first_entry(&item->fwi_out, struct find_out_seg,
+				       fos_link);
+		list_del(&seg->fos_link);
+		if (seg->fos_child)
+			wq->fwq_out_cur = seg->fos_child;
+		else
+			find_out_write(seg->fos_text, seg->fos_len);
+		free(seg);
+	}
+}
+
+static void find_out_add(struct find_thread *ft, struct find_out_seg *seg)
+{
+	struct find_workq *wq = ft->ft_wq;
+
+	pthread_mutex_lock(&wq->fwq_out_lock);
+	list_add_tail(&seg->fos_link, &ft->ft_item->fwi_out);
+	find_out_emit(wq);
+	pthread_mutex_unlock(&wq->fwq_out_lock);
+}
+
+/* print a matching file, kept in order for a threaded ordered scan */
+static void find_printf(struct find_param *param, const char *fmt, ...)
+{
+	struct find_out_seg *seg;
+	va_list args;
+	char *text;
+	int len;
+
+	va_start(args, fmt);
+	if (!param->fp_thread || !param->fp_thread_ordered) {
+		int tmp_errno = errno;
+
+		if ((LLAPI_MSG_NORMAL & LLAPI_MSG_MASK) <= llapi_msg_level)
+			llapi_info_callback(LLAPI_MSG_NORMAL, 0, fmt, args);
+		va_end(args);
+		errno = tmp_errno;
+		return;
+	}
+	len = vasprintf(&text, fmt, args);
+	va_end(args);
+	if (len < 0)
+		return;
+
+	seg = malloc(sizeof(*seg) + len);
+	if (seg) {
+		seg->fos_child = NULL;
+		seg->fos_len = len;
+		memcpy(seg->fos_text, text, len);
+		find_out_add(param->fp_thread, seg);
+	}
+	free(text);
+}
+
+/*
+ * Queue the subdirectory @path, named @de in the directory @d, to be scanned
+ * by the find threads instead of recursing into it.
+ */
+static int find_queue_dir(struct find_param *param, int d, const char *path,
+			  struct dirent64 *de)
+{
+	struct find_thread *ft = param->fp_thread;
+	struct find_workq *wq = ft->ft_wq;
+	struct find_work_item *item;
+	size_t len = strlen(path);
+
+	item = calloc(1, sizeof(*item) + len + 1);
+	if (!item)
+		return -ENOMEM;
+
+	memcpy(item->fwi_path, path, len + 1);
+	item->fwi_de.d_ino = de->d_ino;
+	item->fwi_de.d_off = de->d_off;
+	item->fwi_de.d_reclen = de->d_reclen;
+	item->fwi_de.d_type = de->d_type;
+	snprintf(item->fwi_de.d_name, sizeof(item->fwi_de.d_name), "%s",
+		 de->d_name);
+	item->fwi_has_de = true;
+	item->fwi_depth = param->fp_depth;
+	item->fwi_parent = ft->ft_item;
+	item->fwi_queue = ft->ft_item->fwi_queue;
+	INIT_LIST_HEAD(&item->fwi_out);
+
+	if (wq->fwq_nqueues > 1) {
+		struct lu_fid fid;
+		int fd, mdt;
+
+		fd = openat(d, de->d_name, O_RDONLY | O_PATH | O_NOFOLLOW);
+		if (fd >= 0) {
+			if (llapi_fd2fid(fd, &fid) == 0 &&
+			    llapi_get_mdt_index_by_fid(d, &fid, &mdt) >= 0)
+				item->fwi_queue = mdt % wq->fwq_nqueues;
+			close(fd);
+		}
+	}
+
+	if (param->fp_thread_ordered) {
+		struct find_out_seg *seg = calloc(1, sizeof(*seg));
+
+		if (!seg) {
+			free(item);
+			return -ENOMEM;
+		}
+		seg->fos_child = item;
+		find_out_add(ft, seg);
+	}
+
+	pthread_mutex_lock(&wq->fwq_lock);
+	list_add(&item->fwi_link, &wq->fwq_queues[item->fwi_queue]);
+	wq->fwq_queued++;
+	pthread_cond_signal(&wq->fwq_cond);
+	pthread_mutex_unlock(&wq->fwq_lock);
+
+	return 0;
+}
+
 static bool lmv_is_foreign(__u32 magic)
 {
 	return magic == LMV_MAGIC_FOREIGN;
@@ -2111,8 +2317,12 @@ static int llapi_semantic_traverse(char *path, int size, int parent,
 			break;
 		case DT_DIR:
 			/* recursion down into a new subdirectory here */
-			rc = llapi_semantic_traverse(path, size, d, sem_init,
-						     sem_fini, data, dent);
+			if (param->fp_thread)
+				rc = find_queue_dir(param, d, path, dent);
+			else
+				rc = llapi_semantic_traverse(path, size, d,
+							     sem_init, sem_fini,
+							     data, dent);
 			if (rc != 0 && ret == 0)
 				ret = rc;
 			if (rc < 0 && rc != -EALREADY &&
@@ -3527,6 +3737,15 @@ static void lov_dump_comp_v1_entry(struct find_param *param,
 		separator = "\n";
 	}
 
+	if ((verbose & VERBOSE_COMP_FLAGS) && entry->lcme_cstripe_count) {
+		llapi_printf(LLAPI_MSG_NORMAL, "%s", separator);
+		llapi_printf(LLAPI_MSG_NORMAL, "%4slcme_dstripe_count:  %u\n",
+			     " ", entry->lcme_dstripe_count);
+		llapi_printf(LLAPI_MSG_NORMAL, "%4slcme_cstripe_count:  %u",
+			     " ", entry->lcme_cstripe_count);
+		separator = "\n";
+	}
+
 	if (verbose & VERBOSE_COMP_START) {
 		llapi_printf(LLAPI_MSG_NORMAL, "%s", separator);
 		if (verbose & ~VERBOSE_COMP_START)
@@ -5068,7 +5287,7 @@ static int printf_format_timestamp(char *seq, char *buffer, size_t size,
 				   int *wrote, struct find_param *param)
 {
 	struct statx_timestamp ts = { 0, 0 };
-	struct tm *tm;
+	struct tm *tm, tm_buf;
 	time_t t;
 	int rc = 0;
 	char *fmt = "%c";  /* Print in ctime format by default */
@@ -5126,7 +5345,7 @@ static int printf_format_timestamp(char *seq, char *buffer, size_t size,
 	if (rc) {
 		/* Found valid format, print to buffer */
 		t = ts.tv_sec;
-		tm = localtime(&t);
+		tm = localtime_r(&t, &tm_buf);
 		*wrote = strftime(buffer, size, fmt, tm);
 	}
 
@@ -5620,13 +5839,16 @@ static int printf_format_directive(char *seq, char *buffer, size_t size,
 		*wrote = snprintf(buffer, size, "%"PRIu64, blocks);
 		break;
 	case 'g': { /* groupname of owner*/
-		static char save_gr_name[LOGIN_NAME_MAX + 1];
-		static gid_t save_gid = -1;
+		static __thread char save_gr_name[LOGIN_NAME_MAX + 1];
+		static __thread gid_t save_gid = -1;
 
 		if (save_gid != param->fp_lmd->lmd_stx.stx_gid) {
-			struct group *gr;
+			struct group grp, *gr = NULL;
+			char buf[16384];
 
-			gr = getgrgid(param->fp_lmd->lmd_stx.stx_gid);
+			/* called by the llapi_find() threads */
+			getgrgid_r(param->fp_lmd->lmd_stx.stx_gid, &grp, buf,
+				   sizeof(buf), &gr);
 			if (gr) {
 				save_gid = param->fp_lmd->lmd_stx.stx_gid;
 				strncpy(save_gr_name, gr->gr_name,
@@ -5672,13 +5894,15 @@ static int printf_format_directive(char *seq, char *buffer, size_t size,
 				   (uint64_t) param->fp_lmd->lmd_stx.stx_size);
 		break;
 	case 'u': {/* username of owner */
-		static char save_username[LOGIN_NAME_MAX + 1];
-		static uid_t save_uid = -1;
+		static __thread char save_username[LOGIN_NAME_MAX + 1];
+		static __thread uid_t save_uid = -1;
 
 		if (save_uid != param->fp_lmd->lmd_stx.stx_uid) {
-			struct passwd *pw;
+			struct passwd pwd, *pw = NULL;
+			char buf[4096];
 
-			pw = getpwuid(param->fp_lmd->lmd_stx.stx_uid);
+			getpwuid_r(param->fp_lmd->lmd_stx.stx_uid, &pwd, buf,
+				   sizeof(buf), &pw);
 			if (pw) {
 				save_uid = param->fp_lmd->lmd_stx.stx_uid;
 				strncpy(save_username, pw->pw_name,
@@ -5808,7 +6032,7 @@ static void printf_format_string(struct find_param *param, char *path,
 
 	/* Terminate output buffer and print */
 	*buff = '\0';
-	llapi_printf(LLAPI_MSG_NORMAL, "%s", output);
+	find_printf(param, "%s", output);
 }
 
 /*
@@ -6485,8 +6709,8 @@ print:
 	if (param->fp_format_printf_str)
 		printf_format_string(param, path, projid, d);
 	else
-		llapi_printf(LLAPI_MSG_NORMAL, "%s%c", path,
-			     param->fp_zero_end ? '\0' : '\n');
+		find_printf(param, "%s%c", path,
+			    param->fp_zero_end ? '\0' : '\n');
 
 
 decided:
@@ -6797,10 +7021,224 @@ static void validate_printf_str(struct find_param *param)
 	}
 }
 
+/* take the next directory to scan, NULL once the whole tree is scanned */
+static struct find_work_item *find_workq_next(struct find_workq *wq, int home)
+{
+	struct find_work_item *item = NULL;
+	int i;
+
+	pthread_mutex_lock(&wq->fwq_lock);
+	while (!wq->fwq_stop) {
+		if (wq->fwq_queued > 0) {
+			if (!list_empty(&wq->fwq_queues[home])) {
+				item = list_first_entry(&wq->fwq_queues[home],
+							struct find_work_item,
+							fwi_link);
+			} else {
+				for (i = 1; i < wq->fwq_nqueues; i++) {
+					struct list_head *q;
+
+					q = &wq->fwq_queues[(home + i) %
+							    wq->fwq_nqueues];
+					if (list_empty(q))
+						continue;
+					item = list_last_entry(q,
+							struct find_work_item,
+							fwi_link);
+					break;
+				}
+			}
+			list_del(&item->fwi_link);
+			wq->fwq_queued--;
+			wq->fwq_busy++;
+			break;
+		}
+
+		/* nothing queued, and nothing being scanned can queue more */
+		if (wq->fwq_busy == 0)
+			break;
+		pthread_cond_wait(&wq->fwq_cond, &wq->fwq_lock);
+	}
+	pthread_mutex_unlock(&wq->fwq_lock);
+
+	return item;
+}
+
+static void find_workq_done(struct find_thread *ft,
+			    struct find_work_item *item, int rc)
+{
+	struct find_param *param = &ft->ft_param;
+	struct find_workq *wq = ft->ft_wq;
+
+	pthread_mutex_lock(&wq->fwq_lock);
+	wq->fwq_busy--;
+	if (rc < 0 && wq->fwq_rc == 0)
+		wq->fwq_rc = rc;
+	if (rc < 0 && rc != -EALREADY && param->fp_stop_on_error)
+		wq->fwq_stop = true;
+	if (wq->fwq_stop || (wq->fwq_busy == 0 && wq->fwq_queued == 0))
+		pthread_cond_broadcast(&wq->fwq_cond);
+	pthread_mutex_unlock(&wq->fwq_lock);
+
+	if (param->fp_thread_ordered) {
+		pthread_mutex_lock(&wq->fwq_out_lock);
+		item->fwi_done = true;
+		find_out_emit(wq);
+		pthread_mutex_unlock(&wq->fwq_out_lock);
+	} else {
+		free(item);
+	}
+}
+
+static void *find_thread_main(void *arg)
+{
+	struct find_thread *ft = arg;
+	struct find_param *param = &ft->ft_param;
+	struct find_work_item *item;
+	int rc;
+
+	while ((item = find_workq_next(ft->ft_wq, ft->ft_home)) != NULL) {
+		snprintf(ft->ft_path, 2 * PATH_MAX, "%s", item->fwi_path);
+		ft->ft_item = item;
+		param->fp_depth = item->fwi_depth;
+		rc = llapi_semantic_traverse(ft->ft_path, 2 * PATH_MAX, -1,
+					     cb_find_init, cb_common_fini,
+					     param, item->fwi_has_de ?
+					     &item->fwi_de : NULL);
+		ft->ft_item = NULL;
+		find_workq_done(ft, item, rc);
+	}
+
+	return NULL;
+}
+
+/*
+ * Scan the tree under @path with param->fp_thread_count threads, each with
+ * its own copy of @param.  The counters of --skip are kept per thread.
+ */
+static int find_threaded(char *path, struct find_param *param)
+{
+	unsigned int nthreads = param->fp_thread_count;
+	struct find_work_item *item, *tmp;
+	struct find_thread *threads;
+	struct find_workq wq = { 0 };
+	int mdt_count = 1;
+	int started = 0;
+	int rc = 0;
+	int fd;
+	int i;
+
+	if (strlen(path) > PATH_MAX) {
+		rc = -EINVAL;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "Path name '%s' is too long", path);
+		return rc;
+	}
+
+	fd = open(path, O_RDONLY | O_NDELAY | O_DIRECTORY);
+	if (fd < 0)
+		return param_callback(path, cb_find_init, cb_common_fini,
+				      param);
+	/* not a Lustre tree or no DNE, one queue for all directories */
+	if (ioctl(fd, LL_IOC_GETOBDCOUNT, &mdt_count) < 0 || mdt_count < 1)
+		mdt_count = 1;
+	close(fd);
+
+	wq.fwq_nqueues = mdt_count;
+	wq.fwq_queues = calloc(mdt_count, sizeof(*wq.fwq_queues));
+	threads = calloc(nthreads, sizeof(*threads));
+	item = calloc(1, sizeof(*item) + strlen(path) + 1);
+	if (!wq.fwq_queues || !threads || !item) {
+		free(item);
+		rc = -ENOMEM;
+		goto out_free;
+	}
+
+	for (i = 0; i < mdt_count; i++)
+		INIT_LIST_HEAD(&wq.fwq_queues[i]);
+	pthread_mutex_init(&wq.fwq_lock, NULL);
+	pthread_mutex_init(&wq.fwq_out_lock, NULL);
+	pthread_cond_init(&wq.fwq_cond, NULL);
+
+	strcpy(item->fwi_path, path);
+	INIT_LIST_HEAD(&item->fwi_out);
+	list_add(&item->fwi_link, &wq.fwq_queues[0]);
+	wq.fwq_queued = 1;
+	wq.fwq_out_cur = param->fp_thread_ordered ? item : NULL;
+
+	for (i = 0; i < nthreads; i++) {
+		struct find_thread *ft = &threads[i];
+
+		ft->ft_wq = &wq;
+		ft->ft_home = i % mdt_count;
+		ft->ft_param = *param;
+		ft->ft_param.fp_thread = ft;
+		ft->ft_path = malloc(2 * PATH_MAX);
+		if (!ft->ft_path) {
+			rc = -ENOMEM;
+			break;
+		}
+
+		rc = common_param_init(&ft->ft_param, path);
+		if (rc)
+			break;
+
+		rc = -pthread_create(&ft->ft_tid, NULL, find_thread_main, ft);
+		if (rc) {
+			find_param_fini(&ft->ft_param);
+			break;
+		}
+		ft->ft_started = true;
+		started++;
+	}
+
+	/* go on with the threads started so far */
+	if (started > 0)
+		rc = 0;
+	else
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot start find threads");
+
+	for (i = 0; i < nthreads; i++) {
+		if (threads[i].ft_started) {
+			pthread_join(threads[i].ft_tid, NULL);
+			find_param_fini(&threads[i].ft_param);
+		}
+		free(threads[i].ft_path);
+	}
+
+	/* directories left by fp_stop_on_error are never scanned */
+	for (i = 0; i < mdt_count; i++) {
+		list_for_each_entry_safe(item, tmp, &wq.fwq_queues[i],
+					 fwi_link) {
+			list_del(&item->fwi_link);
+			if (param->fp_thread_ordered)
+				item->fwi_done = true;
+			else
+				free(item);
+		}
+	}
+	if (param->fp_thread_ordered)
+		find_out_emit(&wq);
+
+	if (rc == 0)
+		rc = wq.fwq_rc;
+
+	pthread_cond_destroy(&wq.fwq_cond);
+	pthread_mutex_destroy(&wq.fwq_out_lock);
+	pthread_mutex_destroy(&wq.fwq_lock);
+out_free:
+	free(threads);
+	free(wq.fwq_queues);
+
+	return rc < 0 ? rc : 0;
+}
+
 int llapi_find(char *path, struct find_param *param)
 {
 	if (param->fp_format_printf_str)
 		validate_printf_str(param);
+	if (param->fp_thread_count > 1)
+		return find_threaded(path, param);
 	return param_callback(path, cb_find_init, cb_common_fini, param);
 }
 
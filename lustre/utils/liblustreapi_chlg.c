@@ -57,7 +57,9 @@ static int chlg_dev_path(char *path, size_t path_len, const char *device)
 }
 
 #define CHANGELOG_PRIV_MAGIC 0xCA8E1080
-#define CHANGELOG_BUFFER_SZ  4096
+#define CHANGELOG_BUFFER_SZ  (64 * 1024)
+/* Records acknowledged before llapi_changelog_clear_batch() clears them */
+#define CHANGELOG_CLEAR_BATCH 1024
 
 /**
  * Record state for efficient changelog consumption.
@@ -72,6 +74,16 @@ struct changelog_private {
 	enum changelog_send_flag	 clp_send_flags;
 	/* Changelog extra flags */
 	enum changelog_send_extra_flag	 clp_send_extra_flags;
+	/* Device name, for clearing records */
+	char				 clp_device[NAME_MAX + 1];
+	/* Write only descriptor used by llapi_changelog_clear_batch() */
+	int				 clp_clear_fd;
+	/* Reader ID of the pending clear */
+	char				 clp_clear_id[32];
+	/* Last record acknowledged, to be cleared */
+	long long			 clp_clear_rec;
+	/* Last record cleared */
+	long long			 clp_clear_done;
 	/* Available bytes in buffer */
 	size_t				 clp_buf_len;
 	/* Current position in buffer */
@@ -109,6 +121,10 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 
 	cp->clp_magic = CHANGELOG_PRIV_MAGIC;
 	cp->clp_send_flags = flags;
+	snprintf(cp->clp_device, sizeof(cp->clp_device), "%s", device);
+	cp->clp_clear_fd = -1;
+	cp->clp_clear_rec = -1;
+	cp->clp_clear_done = -1;
 
 	cp->clp_buf_len = 0;
 	cp->clp_buf_pos = cp->clp_buf;
@@ -173,14 +189,19 @@ out_free_cp:
 int llapi_changelog_fini(void **priv)
 {
 	struct changelog_private *cp = *priv;
+	int rc;
 
 	if (!cp || (cp->clp_magic != CHANGELOG_PRIV_MAGIC))
 		return -EINVAL;
 
+	rc = llapi_changelog_clear_flush(cp);
+	if (cp->clp_clear_fd >= 0)
+		close(cp->clp_clear_fd);
+
 	close(cp->clp_fd);
 	free(cp);
 	*priv = NULL;
-	return 0;
+	return rc;
 }
 
 static ssize_t chlg_read_bulk(struct changelog_private *cp)
@@ -307,6 +328,136 @@ no_extras:
 	return new_rec;
 }
 
+/**
+ * Repack a record in the read buffer with only the fields wanted, as
+ * llapi_changelog_repack_rec() does in a new record. Every field stays at
+ * the same or a lower offset, so they are moved in order.
+ */
+static void chlg_repack_rec_inplace(struct changelog_rec *rec,
+				    enum changelog_rec_flags crf_wanted,
+				    enum changelog_rec_extra_flags cref_want)
+{
+	enum changelog_rec_extra_flags cref = CLFE_INVALID;
+	enum changelog_rec_extra_flags cref_new = CLFE_INVALID;
+	enum changelog_rec_flags crf = rec->cr_flags;
+	char *rename = NULL;
+	char *jobid = NULL;
+	char *uidgid = NULL;
+	char *nid = NULL;
+	char *omode = NULL;
+	char *xattr = NULL;
+	char *name;
+
+	crf_wanted &= CLF_SUPPORTED;
+	cref_want &= CLFE_SUPPORTED;
+
+	/* Locate the fields before anything moves */
+	if (crf & CLF_RENAME)
+		rename = (char *)changelog_rec_rename(rec);
+	if (crf & CLF_JOBID)
+		jobid = (char *)changelog_rec_jobid(rec);
+	if (crf & CLF_EXTRA_FLAGS) {
+		cref = changelog_rec_extra_flags(rec)->cr_extra_flags;
+		if (cref & CLFE_UIDGID)
+			uidgid = (char *)changelog_rec_uidgid(rec);
+		if (cref & CLFE_NID)
+			nid = (char *)changelog_rec_nid(rec);
+		if (cref & CLFE_OPEN)
+			omode = (char *)changelog_rec_openmode(rec);
+		if (cref & CLFE_XATTR)
+			xattr = (char *)changelog_rec_xattr(rec);
+	}
+	name = changelog_rec_name(rec);
+
+	rec->cr_flags = (crf & CLF_FLAGMASK) | CLF_VERSION;
+	if ((crf_wanted & CLF_RENAME) && rename) {
+		rec->cr_flags |= CLF_RENAME;
+		memmove(changelog_rec_rename(rec), rename,
+			sizeof(struct changelog_ext_rename));
+	}
+
+	if ((crf_wanted & CLF_JOBID) && jobid) {
+		rec->cr_flags |= CLF_JOBID;
+		memmove(changelog_rec_jobid(rec), jobid,
+			sizeof(struct changelog_ext_jobid));
+	}
+
+	if ((crf_wanted & CLF_EXTRA_FLAGS) && (crf & CLF_EXTRA_FLAGS)) {
+		if ((cref_want & CLFE_UIDGID) && uidgid)
+			cref_new |= CLFE_UIDGID;
+		if ((cref_want & CLFE_NID) && nid) {
+			cref_new |= CLFE_NID;
+			if ((cref_want & CLFE_NID_BE) && (cref & CLFE_NID_BE))
+				cref_new |= CLFE_NID_BE;
+		}
+		if ((cref_want & CLFE_OPEN) && omode)
+			cref_new |= CLFE_OPEN;
+		if ((cref_want & CLFE_XATTR) && xattr)
+			cref_new |= CLFE_XATTR;
+
+		rec->cr_flags |= CLF_EXTRA_FLAGS;
+		changelog_rec_extra_flags(rec)->cr_extra_flags = cref_new;
+	}
+
+	if (cref_new & CLFE_UIDGID)
+		memmove(changelog_rec_uidgid(rec), uidgid,
+			sizeof(struct changelog_ext_uidgid));
+	if (cref_new & CLFE_NID)
+		memmove(changelog_rec_nid(rec), nid,
+			sizeof(struct changelog_ext_nid));
+	if (cref_new & CLFE_OPEN)
+		memmove(changelog_rec_openmode(rec), omode,
+			sizeof(struct changelog_ext_openmode));
+	if (cref_new & CLFE_XATTR)
+		memmove(changelog_rec_xattr(rec), xattr,
+			sizeof(struct changelog_ext_xattr));
+
+	memmove(changelog_rec_name(rec), name, rec->cr_namelen);
+}
+
+#define DEFAULT_RECORD_FMT	(CLF_VERSION | CLF_RENAME)
+/* Record format asked for by the reader */
+static void chlg_rec_fmt(struct changelog_private *cp,
+			 enum changelog_rec_flags *rec_fmt,
+			 enum changelog_rec_extra_flags *rec_extra_fmt)
+{
+	*rec_fmt = DEFAULT_RECORD_FMT;
+	*rec_extra_fmt = CLFE_INVALID;
+
+	if (cp->clp_send_flags & CHANGELOG_FLAG_JOBID)
+		*rec_fmt |= CLF_JOBID;
+
+	if (cp->clp_send_flags & CHANGELOG_FLAG_EXTRA_FLAGS) {
+		*rec_fmt |= CLF_EXTRA_FLAGS;
+		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_UIDGID)
+			*rec_extra_fmt |= CLFE_UIDGID;
+		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_NID) {
+			*rec_extra_fmt |= CLFE_NID;
+			if (cp->clp_send_flags & CHANGELOG_FLAG_NID_BE)
+				*rec_extra_fmt |= CLFE_NID_BE;
+		}
+		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_OMODE)
+			*rec_extra_fmt |= CLFE_OPEN;
+		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_XATTR)
+			*rec_extra_fmt |= CLFE_XATTR;
+	}
+}
+
+/* Refill the read buffer once it is consumed. Return 1 on EOF. */
+static int chlg_refill(struct changelog_private *cp)
+{
+	ssize_t refresh;
+
+	if (cp->clp_buf + cp->clp_buf_len > cp->clp_buf_pos)
+		return 0;
+
+	refresh = chlg_read_bulk(cp);
+	if (refresh == 0)
+		return 1;
+
+	return refresh < 0 ? refresh : 0;
+}
+
 /** Read the next changelog entry
  * @param priv Opaque private control structure
  * @param rech Changelog record handle; record will be allocated here
@@ -314,12 +465,11 @@ no_extras:
  *	 <0 error code
  *	 1 EOF
  */
-#define DEFAULT_RECORD_FMT	(CLF_VERSION | CLF_RENAME)
 int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
 {
 	struct changelog_private *cp = priv;
-	enum changelog_rec_flags rec_fmt = DEFAULT_RECORD_FMT;
-	enum changelog_rec_extra_flags rec_extra_fmt = CLFE_INVALID;
+	enum changelog_rec_flags rec_fmt;
+	enum changelog_rec_extra_flags rec_extra_fmt;
 	struct changelog_rec *tmp;
 	int rc = 0;
 
@@ -330,37 +480,11 @@ int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
 		return -EINVAL;
 
 	*rech = NULL;
-	if (cp->clp_send_flags & CHANGELOG_FLAG_JOBID)
-		rec_fmt |= CLF_JOBID;
+	chlg_rec_fmt(cp, &rec_fmt, &rec_extra_fmt);
 
-	if (cp->clp_send_flags & CHANGELOG_FLAG_EXTRA_FLAGS) {
-		rec_fmt |= CLF_EXTRA_FLAGS;
-		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_UIDGID)
-			rec_extra_fmt |= CLFE_UIDGID;
-		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_NID) {
-			rec_extra_fmt |= CLFE_NID;
-			if (cp->clp_send_flags & CHANGELOG_FLAG_NID_BE)
-				rec_extra_fmt |= CLFE_NID_BE;
-		}
-		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_OMODE)
-			rec_extra_fmt |= CLFE_OPEN;
-		if (cp->clp_send_extra_flags & CHANGELOG_EXTRA_FLAG_XATTR)
-			rec_extra_fmt |= CLFE_XATTR;
-	}
-
-	if (cp->clp_buf + cp->clp_buf_len <= cp->clp_buf_pos) {
-		ssize_t refresh;
-
-		refresh = chlg_read_bulk(cp);
-		if (refresh == 0) {
-			/* EOF */
-			rc = 1;
-			goto out;
-		} else if (refresh < 0) {
-			rc = refresh;
-			goto out;
-		}
-	}
+	rc = chlg_refill(cp);
+	if (rc != 0)
+		goto out;
 
 	tmp = (struct changelog_rec *)cp->clp_buf_pos;
 	*rech = llapi_changelog_repack_rec(tmp, rec_fmt, rec_extra_fmt);
@@ -369,6 +493,61 @@ out:
 	return rc;
 }
 
+/**
+ * Read the next changelog records without copying them.
+ *
+ * The records are repacked in place in the read buffer and stay valid
+ * until the next call to llapi_changelog_recv(),
+ * llapi_changelog_recv_batch() or llapi_changelog_fini(). They must not be
+ * passed to llapi_changelog_free(). The records are not aligned.
+ *
+ * \param[in] priv	Opaque private control structure
+ * \param[out] recs	Array filled with pointers to the records
+ * \param[in] count	Size of \a recs
+ *
+ * \retval		number of records received
+ * \retval 0		on EOF
+ * \retval -errno	on failure
+ */
+int llapi_changelog_recv_batch(void *priv, struct changelog_rec **recs,
+			       int count)
+{
+	struct changelog_private *cp = priv;
+	enum changelog_rec_flags rec_fmt;
+	enum changelog_rec_extra_flags rec_extra_fmt;
+	char *end;
+	int rc;
+	int i;
+
+	if (!cp || (cp->clp_magic != CHANGELOG_PRIV_MAGIC))
+		return -EINVAL;
+
+	if (recs == NULL || count <= 0)
+		return -EINVAL;
+
+	chlg_rec_fmt(cp, &rec_fmt, &rec_extra_fmt);
+
+	rc = chlg_refill(cp);
+	if (rc != 0)
+		return rc == 1 ? 0 : rc;
+
+	/* Only hand out what was read, so this does not block while
+	 * records are available.
+	 */
+	end = cp->clp_buf + cp->clp_buf_len;
+	for (i = 0; i < count && cp->clp_buf_pos < end; i++) {
+		struct changelog_rec *rec;
+
+		rec = (struct changelog_rec *)cp->clp_buf_pos;
+		cp->clp_buf_pos += changelog_rec_size(rec) + rec->cr_namelen;
+
+		chlg_repack_rec_inplace(rec, rec_fmt, rec_extra_fmt);
+		recs[i] = rec;
+	}
+
+	return i;
+}
+
 /** Release the changelog record when done with it. */
 int llapi_changelog_free(struct changelog_rec **rech)
 {
@@ -385,24 +564,14 @@ int llapi_changelog_in_buf(void *priv)
 	return 0;
 }
 
-int llapi_changelog_clear(const char *mdtname, const char *idstr,
-			  long long endrec)
+/* Ask the changelog device open on @fd to clear records up to @endrec */
+static int chlg_clear_write(int fd, const char *idstr, long long endrec)
 {
-	char dev_path[PATH_MAX];
 	char cmd[64];
 	size_t cmd_len = sizeof(cmd);
 	char *dashp, *clidp = NULL;
-	int fd;
 	int rc;
 
-	if (endrec < 0) {
-		llapi_err_noerrno(LLAPI_MSG_ERROR,
-				  "can't purge negative records\n");
-		return -EINVAL;
-	}
-
-	chlg_dev_path(dev_path, sizeof(dev_path), mdtname);
-
 	dashp = strchr(idstr, '-');
 	if (dashp) {
 		clidp = strndup(idstr, dashp - idstr);
@@ -418,30 +587,141 @@ int llapi_changelog_clear(const char *mdtname, const char *idstr,
 	}
 	cmd_len = rc + 1;
 
-	fd = open(dev_path, O_WRONLY);
-	if (fd < 0) {
-		rc = -errno;
-		llapi_error(LLAPI_MSG_ERROR, rc, "cannot open '%s'", dev_path);
-		goto out;
-	}
-
 	rc = write(fd, cmd, cmd_len);
 	if (rc < 0) {
 		rc = -errno;
 		llapi_error(LLAPI_MSG_ERROR, rc,
 			    "cannot purge records for '%s'", idstr);
-		goto out_close;
+		goto out;
 	}
 
 	rc = 0;
-
-out_close:
-	close(fd);
 out:
 	free(clidp);
 	return rc;
 }
 
+int llapi_changelog_clear(const char *mdtname, const char *idstr,
+			  long long endrec)
+{
+	char dev_path[PATH_MAX];
+	int fd;
+	int rc;
+
+	if (endrec < 0) {
+		llapi_err_noerrno(LLAPI_MSG_ERROR,
+				  "can't purge negative records\n");
+		return -EINVAL;
+	}
+
+	chlg_dev_path(dev_path, sizeof(dev_path), mdtname);
+
+	fd = open(dev_path, O_WRONLY);
+	if (fd < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot open '%s'", dev_path);
+		return rc;
+	}
+
+	rc = chlg_clear_write(fd, idstr, endrec);
+	close(fd);
+
+	return rc;
+}
+
+/**
+ * Clear the records acknowledged by llapi_changelog_clear_batch() that are
+ * not cleared yet.
+ *
+ * \param[in] priv	Opaque private control structure
+ *
+ * \retval 0		on success
+ * \retval -errno	on failure
+ */
+int llapi_changelog_clear_flush(void *priv)
+{
+	struct changelog_private *cp = priv;
+	char dev_path[PATH_MAX];
+	int rc;
+
+	if (!cp || cp->clp_magic != CHANGELOG_PRIV_MAGIC)
+		return -EINVAL;
+
+	if (cp->clp_clear_rec <= cp->clp_clear_done)
+		return 0;
+
+	/* The reader descriptor is read only, keep another one to clear */
+	if (cp->clp_clear_fd < 0) {
+		rc = chlg_dev_path(dev_path, sizeof(dev_path), cp->clp_device);
+		if (rc != 0)
+			return rc;
+
+		cp->clp_clear_fd = open(dev_path, O_WRONLY | O_CLOEXEC);
+		if (cp->clp_clear_fd < 0) {
+			rc = -errno;
+			llapi_error(LLAPI_MSG_ERROR, rc, "cannot open '%s'",
+				    dev_path);
+			return rc;
+		}
+	}
+
+	rc = chlg_clear_write(cp->clp_clear_fd, cp->clp_clear_id,
+			      cp->clp_clear_rec);
+	if (rc == 0)
+		cp->clp_clear_done = cp->clp_clear_rec;
+
+	return rc;
+}
+
+/**
+ * Acknowledge records up to \a endrec, to be cleared for reader \a idstr.
+ *
+ * Clearing is cumulative, so acknowledgements are coalesced and records are
+ * only cleared every CHANGELOG_CLEAR_BATCH records, by
+ * llapi_changelog_clear_flush() or by llapi_changelog_fini(). This saves a
+ * request to the MDT for each acknowledgement.
+ *
+ * \param[in] priv	Opaque private control structure
+ * \param[in] idstr	Changelog reader ID (cl1, cl2...)
+ * \param[in] endrec	Last record to clear
+ *
+ * \retval 0		on success
+ * \retval -errno	on failure
+ */
+int llapi_changelog_clear_batch(void *priv, const char *idstr,
+				long long endrec)
+{
+	struct changelog_private *cp = priv;
+	int rc;
+
+	if (!cp || cp->clp_magic != CHANGELOG_PRIV_MAGIC)
+		return -EINVAL;
+
+	/* 0 meaning the last record cannot be merged with other records */
+	if (endrec <= 0 || idstr == NULL ||
+	    strlen(idstr) >= sizeof(cp->clp_clear_id))
+		return -EINVAL;
+
+	if (strcmp(idstr, cp->clp_clear_id) != 0) {
+		rc = llapi_changelog_clear_flush(cp);
+		if (rc != 0)
+			return rc;
+
+		snprintf(cp->clp_clear_id, sizeof(cp->clp_clear_id), "%s",
+			 idstr);
+		cp->clp_clear_rec = -1;
+		cp->clp_clear_done = -1;
+	}
+
+	if (endrec > cp->clp_clear_rec)
+		cp->clp_clear_rec = endrec;
+
+	if (cp->clp_clear_rec - cp->clp_clear_done < CHANGELOG_CLEAR_BATCH)
+		return 0;
+
+	return llapi_changelog_clear_flush(cp);
+}
+
 /**
  * Set extra flags for reading changelogs
  *
@@ -0,0 +1,394 @@
+/*
+ * LGPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the GNU Lesser General Public License
+ * LGPL version 2.1 or (at your discretion) any later version.
+ * LGPL version 2.1 accompanies this distribution, and is available at
+ * http://www.gnu.org/licenses/lgpl-2.1.html
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * LGPL HEADER END
+ */
+/*
+ * lustre/utils/liblustreapi_copy.c
+ *
+ * lustreapi library for moving file data between layouts
+ *
+ * A range is split into chunks that are claimed in file order by several
+ * streams, each with its own buffer.  Every stream reads a chunk and writes
+ * it out before claiming the next one, so with two or more streams reads of
+ * one chunk overlap with writes of another, and chunks aligned to the stripe
+ * size keep several OST objects busy at once.  The bandwidth limit and the
+ * progress report are shared by all the streams.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/param.h>
+
+#include <lustre/lustreapi.h>
+#include "lustreapi_internal.h"
+
+#ifndef NSEC_PER_SEC
+# define NSEC_PER_SEC 1000000000UL
+#endif
+#define ONE_MB 0x100000
+
+struct llapi_copy {
+	struct llapi_copy_param	 lc_param;
+	void			**lc_bufs;
+	pthread_mutex_t		 lc_lock;
+	/* the range being copied, lc_end is lowered when EOF is found */
+	off_t			 lc_next;
+	off_t			 lc_end;
+	int			 lc_rc;
+	/* totals over all the ranges */
+	size_t			 lc_read_bytes;
+	size_t			 lc_write_bytes;
+	struct timespec		 lc_start_time;
+	struct timespec		 lc_last_print;
+};
+
+struct llapi_copy_stream {
+	struct llapi_copy	*lcs_copy;
+	void			*lcs_buf;
+	pthread_t		 lcs_thread;
+};
+
+static struct timespec timespec_sub(struct timespec *before,
+				    struct timespec *after)
+{
+	struct timespec ret;
+
+	ret.tv_sec = after->tv_sec - before->tv_sec;
+	if (after->tv_nsec < before->tv_nsec) {
+		ret.tv_sec--;
+		ret.tv_nsec = NSEC_PER_SEC + after->tv_nsec - before->tv_nsec;
+	} else {
+		ret.tv_nsec = after->tv_nsec - before->tv_nsec;
+	}
+
+	return ret;
+}
+
+static void stats_log(struct timespec *now, struct timespec *start_time,
+		      ssize_t read_bytes, size_t write_bytes,
+		      off_t file_size_bytes)
+{
+	struct timespec diff = timespec_sub(start_time, now);
+
+	if (file_size_bytes == 0)
+		return;
+
+	if (diff.tv_sec == 0 && diff.tv_nsec == 0)
+		return;
+
+	llapi_printf(LLAPI_MSG_NORMAL,
+		     "- { seconds: %li, rmbps: %5.2g, wmbps: %5.2g, copied: %lu, size: %lu, pct: %lu%% }\n",
+		     diff.tv_sec,
+		     (double) read_bytes/((ONE_MB * diff.tv_sec) +
+			     ((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
+		     (double) write_bytes/((ONE_MB * diff.tv_sec) +
+			     ((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
+		     write_bytes/ONE_MB,
+		     file_size_bytes/ONE_MB,
+		     ((write_bytes*100)/file_size_bytes));
+}
+
+/*
+ * Account \a written bytes, print the progress report if it is due and
+ * return how long the caller must sleep to stay under the bandwidth limit.
+ */
+static struct timespec copy_account(struct llapi_copy *lc, size_t read_bytes,
+				    size_t written)
+{
+	struct llapi_copy_param *param = &lc->lc_param;
+	unsigned long long bandwidth = param->lcp_bandwidth;
+	struct timespec delay = { 0, 0 };
+	struct timespec now;
+	struct timespec diff;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&lc->lc_lock);
+	lc->lc_read_bytes += read_bytes;
+	lc->lc_write_bytes += written;
+
+	if (bandwidth) {
+		unsigned long long write_target;
+
+		diff = timespec_sub(&lc->lc_start_time, &now);
+		write_target = bandwidth * diff.tv_sec +
+			       bandwidth * diff.tv_nsec / NSEC_PER_SEC;
+		if (write_target < lc->lc_write_bytes) {
+			unsigned long long excess;
+
+			excess = lc->lc_write_bytes - write_target;
+			delay.tv_sec = excess / bandwidth;
+			delay.tv_nsec = (excess % bandwidth) * NSEC_PER_SEC /
+					bandwidth;
+		}
+	}
+
+	if (param->lcp_stats_interval &&
+	    lc->lc_write_bytes != param->lcp_stats_size &&
+	    now.tv_sec >= lc->lc_last_print.tv_sec +
+			  param->lcp_stats_interval) {
+		stats_log(&now, &lc->lc_start_time, lc->lc_read_bytes,
+			  lc->lc_write_bytes, param->lcp_stats_size);
+		lc->lc_last_print = now;
+	}
+	pthread_mutex_unlock(&lc->lc_lock);
+
+	return delay;
+}
+
+static void *copy_stream_main(void *arg)
+{
+	struct llapi_copy_stream *lcs = arg;
+	struct llapi_copy *lc = lcs->lcs_copy;
+	const struct llapi_copy_ops *ops = lc->lc_param.lcp_ops;
+	void *priv = lc->lc_param.lcp_priv;
+	struct timespec delay;
+	ssize_t rsize;
+	ssize_t written;
+	size_t count;
+	off_t pos;
+	int rc = 0;
+
+	while (1) {
+		pthread_mutex_lock(&lc->lc_lock);
+		if (lc->lc_rc || lc->lc_next >= lc->lc_end) {
+			pthread_mutex_unlock(&lc->lc_lock);
+			break;
+		}
+		pos = lc->lc_next;
+		count = MIN(lc->lc_param.lcp_chunk_size, lc->lc_end - pos);
+		lc->lc_next += count;
+		pthread_mutex_unlock(&lc->lc_lock);
+
+		rsize = ops->lco_read(priv, lcs->lcs_buf, count, pos);
+		if (rsize < 0) {
+			rc = rsize;
+			llapi_error(LLAPI_MSG_ERROR, rc,
+				    "error reading bytes %jd-%jd",
+				    (intmax_t)pos, (intmax_t)(pos + count));
+			break;
+		}
+		if (rsize < count) {
+			/* EOF, chunks past it have nothing to copy */
+			pthread_mutex_lock(&lc->lc_lock);
+			if (lc->lc_end > pos + rsize)
+				lc->lc_end = pos + rsize;
+			pthread_mutex_unlock(&lc->lc_lock);
+			if (rsize == 0)
+				continue;
+		}
+
+		written = ops->lco_write(priv, lcs->lcs_buf, rsize, pos);
+		if (written < 0) {
+			rc = written;
+			llapi_error(LLAPI_MSG_ERROR, rc,
+				    "error writing bytes %jd-%jd",
+				    (intmax_t)pos, (intmax_t)(pos + rsize));
+			break;
+		}
+
+		delay = copy_account(lc, rsize, written);
+		if (delay.tv_sec == 0 && delay.tv_nsec == 0)
+			continue;
+
+		do {
+			rc = clock_nanosleep(CLOCK_MONOTONIC, 0, &delay,
+					     &delay);
+		} while (rc == EINTR);
+		if (rc) {
+			if (lc->lc_param.lcp_stats_interval)
+				llapi_error(LLAPI_MSG_WARN, -rc,
+					    "delay for bandwidth control failed");
+			rc = 0;
+		}
+	}
+
+	if (rc) {
+		pthread_mutex_lock(&lc->lc_lock);
+		if (!lc->lc_rc)
+			lc->lc_rc = rc;
+		pthread_mutex_unlock(&lc->lc_lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * Allocate the buffers of a data mover described by \a param.
+ *
+ * \param[in] param	callbacks, chunk size, number of streams, bandwidth
+ *			limit and progress report settings
+ *
+ * \retval		the mover on success, NULL with errno set on failure
+ */
+struct llapi_copy *llapi_copy_init(const struct llapi_copy_param *param)
+{
+	struct llapi_copy *lc;
+	unsigned int streams;
+	long page_size;
+	int rc;
+	int i;
+
+	page_size = sysconf(_SC_PAGESIZE);
+	if (page_size < 0)
+		return NULL;
+
+	if (!param->lcp_ops || param->lcp_chunk_size == 0 ||
+	    param->lcp_chunk_size % page_size) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	lc = calloc(1, sizeof(*lc));
+	if (!lc)
+		return NULL;
+
+	lc->lc_param = *param;
+	streams = param->lcp_streams;
+	if (streams == 0)
+		streams = LLAPI_COPY_STREAMS_DEFAULT;
+	if (streams > LLAPI_COPY_STREAMS_MAX)
+		streams = LLAPI_COPY_STREAMS_MAX;
+	lc->lc_param.lcp_streams = streams;
+
+	lc->lc_bufs = calloc(streams, sizeof(*lc->lc_bufs));
+	if (!lc->lc_bufs)
+		goto out_free;
+
+	/* page-aligned buffers for direct I/O */
+	for (i = 0; i < streams; i++) {
+		rc = posix_memalign(&lc->lc_bufs[i], page_size,
+				    param->lcp_chunk_size);
+		if (rc) {
+			errno = rc;
+			goto out_free;
+		}
+	}
+
+	pthread_mutex_init(&lc->lc_lock, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &lc->lc_start_time);
+	lc->lc_last_print = lc->lc_start_time;
+
+	return lc;
+
+out_free:
+	rc = errno;
+	if (lc->lc_bufs) {
+		for (i = 0; i < streams; i++)
+			free(lc->lc_bufs[i]);
+		free(lc->lc_bufs);
+	}
+	free(lc);
+	errno = rc;
+	return NULL;
+}
+
+/**
+ * Copy the data in [\a start, \a end) with the streams of \a lc.
+ *
+ * A range shorter than a chunk per stream uses fewer streams, and a single
+ * stream runs in the calling thread.  The copy stops at the first error.
+ *
+ * \param[in] lc	mover returned by llapi_copy_init()
+ * \param[in] start	offset to start copying at
+ * \param[in] end	offset to stop copying at, may be past EOF
+ *
+ * \retval		the offset the data was copied up to, which is less
+ *			than \a end if EOF was reached
+ * \retval		negative errno on failure
+ */
+off_t llapi_copy_range(struct llapi_copy *lc, off_t start, off_t end)
+{
+	struct llapi_copy_stream *lcs;
+	size_t chunk = lc->lc_param.lcp_chunk_size;
+	unsigned int streams = lc->lc_param.lcp_streams;
+	unsigned int started;
+	off_t chunks;
+	int rc;
+	int i;
+
+	if (start >= end)
+		return start;
+
+	lc->lc_next = start;
+	lc->lc_end = end;
+	lc->lc_rc = 0;
+
+	/* end may be far past EOF when copying up to it */
+	chunks = (end - start) / chunk + ((end - start) % chunk != 0);
+	if (streams > chunks)
+		streams = chunks;
+
+	lcs = calloc(streams, sizeof(*lcs));
+	if (!lcs)
+		return -ENOMEM;
+
+	for (i = 0; i < streams; i++) {
+		lcs[i].lcs_copy = lc;
+		lcs[i].lcs_buf = lc->lc_bufs[i];
+	}
+
+	/* the calling thread is stream 0 */
+	for (started = 1; started < streams; started++) {
+		rc = pthread_create(&lcs[started].lcs_thread, NULL,
+				    copy_stream_main, &lcs[started]);
+		if (rc)
+			/* carry on with the streams running already */
+			break;
+	}
+	copy_stream_main(&lcs[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(lcs[i].lcs_thread, NULL);
+	free(lcs);
+
+	if (lc->lc_rc)
+		return lc->lc_rc;
+
+	return lc->lc_end;
+}
+
+/**
+ * Free the buffers of \a lc and print the final progress report if one was
+ * requested and no error happened.
+ */
+void llapi_copy_fini(struct llapi_copy *lc)
+{
+	struct timespec now;
+	int i;
+
+	if (!lc)
+		return;
+
+	/* Output at least one log, regardless of stats_interval */
+	if (lc->lc_param.lcp_stats_interval && !lc->lc_rc) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		stats_log(&now, &lc->lc_start_time, lc->lc_read_bytes,
+			  lc->lc_write_bytes, lc->lc_param.lcp_stats_size);
+	}
+
+	for (i = 0; i < lc->lc_param.lcp_streams; i++)
+		free(lc->lc_bufs[i]);
+	free(lc->lc_bufs);
+	pthread_mutex_destroy(&lc->lc_lock);
+	free(lc);
+}
@@ -35,6 +35,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <assert.h>
+#include <pthread.h>
 #include <sys/xattr.h>
 #include <sys/param.h>
 #include <sys/time.h>
@@ -83,6 +84,11 @@ struct llapi_layout_comp {
 	uint32_t		llc_id;		/* unique ID of component */
 	uint32_t		llc_flags;	/* LCME_FL_* flags */
 	uint64_t		llc_timestamp;	/* snapshot timestamp */
+	uint8_t			llc_dstripe_count; /* EC data stripes */
+	uint8_t			llc_cstripe_count; /* EC parity stripes */
+	uint8_t			llc_compr_type;	/* enum ll_compr_type */
+	uint8_t			llc_compr_lvl;
+	uint8_t			llc_compr_chunk_log_bits;
 	struct list_head	llc_list;	/* linked to the llapi_layout
 						   components list */
 	bool		llc_ondisk;
@@ -657,6 +663,12 @@ struct llapi_layout *llapi_layout_get_by_xattr(void *lov_xattr,
 			comp->llc_flags = ent->lcme_flags;
 			if (comp->llc_flags & LCME_FL_NOSYNC)
 				comp->llc_timestamp = ent->lcme_timestamp;
+			comp->llc_dstripe_count = ent->lcme_dstripe_count;
+			comp->llc_cstripe_count = ent->lcme_cstripe_count;
+			comp->llc_compr_type = ent->lcme_compr_type;
+			comp->llc_compr_lvl = ent->lcme_compr_lvl;
+			comp->llc_compr_chunk_log_bits =
+				ent->lcme_compr_chunk_log_bits;
 		} else {
 			comp->llc_extent.e_start = 0;
 			comp->llc_extent.e_end = LUSTRE_EOF;
@@ -919,6 +931,12 @@ llapi_layout_to_lum(const struct llapi_layout *layout)
 			ent->lcme_flags = comp->llc_flags;
 			if (ent->lcme_flags & LCME_FL_NOSYNC)
 				ent->lcme_timestamp = comp->llc_timestamp;
+			ent->lcme_dstripe_count = comp->llc_dstripe_count;
+			ent->lcme_cstripe_count = comp->llc_cstripe_count;
+			ent->lcme_compr_type = comp->llc_compr_type;
+			ent->lcme_compr_lvl = comp->llc_compr_lvl;
+			ent->lcme_compr_chunk_log_bits =
+				comp->llc_compr_chunk_log_bits;
 			ent->lcme_extent.e_start = comp->llc_extent.e_start;
 			ent->lcme_extent.e_end = comp->llc_extent.e_end;
 			ent->lcme_size = blob_size;
@@ -2131,6 +2149,218 @@ int llapi_layout_comp_flags_clear(struct llapi_layout *layout,
 	return 0;
 }
 
+/**
+ * Fetches the erasure code geometry of the current component.
+ *
+ * \param[in] layout	the layout component
+ * \param[out] dstripes	number of data stripes (k), 0 if not erasure coded
+ * \param[out] cstripes	number of parity stripes (p)
+ *
+ * \retval	0 on success
+ * \retval	<0 if error occurs
+ */
+int llapi_layout_comp_ec_get(const struct llapi_layout *layout,
+			     uint8_t *dstripes, uint8_t *cstripes)
+{
+	struct llapi_layout_comp *comp;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	if (dstripes == NULL || cstripes == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*dstripes = comp->llc_dstripe_count;
+	*cstripes = comp->llc_cstripe_count;
+
+	return 0;
+}
+
+/**
+ * Sets the erasure code geometry of the current component: each row of
+ * \a dstripes data chunks is protected by \a cstripes parity chunks.
+ *
+ * \param[in] layout	the layout component
+ * \param[in] dstripes	number of data stripes (k)
+ * \param[in] cstripes	number of parity stripes (p), at most \a dstripes
+ *
+ * \retval	0 on success
+ * \retval	<0 if error occurs
+ */
+int llapi_layout_comp_ec_set(struct llapi_layout *layout,
+			     uint8_t dstripes, uint8_t cstripes)
+{
+	struct llapi_layout_comp *comp;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	if ((dstripes == 0) != (cstripes == 0) || cstripes > dstripes) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	comp->llc_dstripe_count = dstripes;
+	comp->llc_cstripe_count = cstripes;
+
+	return 0;
+}
+
+/**
+ * Fetches the compression of the current component.
+ *
+ * \param[in] layout		the layout component
+ * \param[out] type		enum ll_compr_type, LL_COMPR_TYPE_NONE if the
+ *				component is not compressed
+ * \param[out] chunk_log_bits	chunk size, see COMPR_GET_CHUNK_SIZE()
+ *
+ * \retval	0 on success
+ * \retval	<0 if error occurs
+ */
+int llapi_layout_comp_compress_get(const struct llapi_layout *layout,
+				   uint8_t *type, uint8_t *chunk_log_bits)
+{
+	struct llapi_layout_comp *comp;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	if (type == NULL || chunk_log_bits == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!(comp->llc_flags & LCME_FL_COMPRESS)) {
+		*type = LL_COMPR_TYPE_NONE;
+		*chunk_log_bits = 0;
+		return 0;
+	}
+
+	*type = comp->llc_compr_type;
+	*chunk_log_bits = comp->llc_compr_chunk_log_bits;
+
+	return 0;
+}
+
+/**
+ * Sets the compression of the current component: its data is compressed
+ * with \a type in chunks of COMPR_GET_CHUNK_SIZE(\a chunk_log_bits) bytes,
+ * or is not compressed if \a type is LL_COMPR_TYPE_NONE.
+ *
+ * \param[in] layout		the layout component
+ * \param[in] type		enum ll_compr_type
+ * \param[in] chunk_log_bits	chunk size, see COMPR_GET_CHUNK_SIZE()
+ *
+ * \retval	0 on success
+ * \retval	<0 if error occurs
+ */
+int llapi_layout_comp_compress_set(struct llapi_layout *layout,
+				   uint8_t type, uint8_t chunk_log_bits)
+{
+	struct llapi_layout_comp *comp;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	/* lcme_compr_chunk_log_bits is a 4 bit field */
+	if (type >= LL_COMPR_TYPE_MAX || chunk_log_bits > 15) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (type == LL_COMPR_TYPE_NONE) {
+		comp->llc_flags &= ~LCME_FL_COMPRESS;
+		chunk_log_bits = 0;
+	} else {
+		comp->llc_flags |= LCME_FL_COMPRESS;
+	}
+	comp->llc_compr_type = type;
+	comp->llc_compr_chunk_log_bits = chunk_log_bits;
+
+	return 0;
+}
+
+/**
+ * Turns a single mirror layout into an erasure coded one.
+ *
+ * Every component of \a layout keeps its stripes as the k data stripes and
+ * gets a matching LCME_FL_PARITY component with \a parity stripes in a new
+ * parity mirror.  The parity mirror is marked stale by writes like any other
+ * FLR mirror and is regenerated by llapi_mirror_resync_many().
+ *
+ * \param[in] layout	single mirror layout with explicit stripe counts
+ * \param[in] parity	number of parity stripes per component
+ *
+ * \retval	0 on success
+ * \retval	<0 if error occurs, errno is set
+ */
+int llapi_layout_ec_parity_add(struct llapi_layout *layout, uint8_t parity)
+{
+	struct llapi_layout_comp *comp, *new, *tmp;
+	struct list_head parity_list;
+
+	if (layout == NULL || layout->llot_magic != LLAPI_LAYOUT_MAGIC ||
+	    layout->llot_mirror_count != 1 || parity == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	INIT_LIST_HEAD(&parity_list);
+	list_for_each_entry(comp, &layout->llot_comp_list, llc_list) {
+		if (comp->llc_stripe_count == 0 ||
+		    comp->llc_stripe_count > UINT8_MAX ||
+		    comp->llc_stripe_count < parity ||
+		    (comp->llc_pattern != LLAPI_LAYOUT_DEFAULT &&
+		     comp->llc_pattern != LLAPI_LAYOUT_RAID0) ||
+		    comp->llc_flags & (LCME_FL_EXTENSION | LCME_FL_PARITY)) {
+			errno = EINVAL;
+			goto out_free;
+		}
+
+		new = __llapi_comp_alloc(0);
+		if (new == NULL)
+			goto out_free;
+
+		comp->llc_dstripe_count = comp->llc_stripe_count;
+		comp->llc_cstripe_count = parity;
+
+		new->llc_pattern = comp->llc_pattern;
+		new->llc_stripe_size = comp->llc_stripe_size;
+		new->llc_stripe_count = parity;
+		snprintf(new->llc_pool_name, sizeof(new->llc_pool_name), "%s",
+			 comp->llc_pool_name);
+		new->llc_extent = comp->llc_extent;
+		new->llc_flags = LCME_FL_PARITY;
+		new->llc_dstripe_count = comp->llc_dstripe_count;
+		new->llc_cstripe_count = parity;
+		list_add_tail(&new->llc_list, &parity_list);
+	}
+
+	list_splice_tail(&parity_list, &layout->llot_comp_list);
+	layout->llot_is_composite = true;
+	layout->llot_mirror_count = 2;
+
+	return 0;
+
+out_free:
+	list_for_each_entry_safe(comp, tmp, &parity_list, llc_list) {
+		list_del_init(&comp->llc_list);
+		__llapi_comp_free(comp);
+	}
+	list_for_each_entry(comp, &layout->llot_comp_list, llc_list) {
+		comp->llc_dstripe_count = 0;
+		comp->llc_cstripe_count = 0;
+	}
+
+	return -1;
+}
+
 /**
  * Fetches the file-unique component ID of the current layout component.
  *
@@ -2955,6 +3185,8 @@ int llapi_layout_merge(struct llapi_layout **dst_layout,
 		new->llc_extent.e_end = comp->llc_extent.e_end;
 		new->llc_id = comp->llc_id;
 		new->llc_flags = comp->llc_flags;
+		new->llc_dstripe_count = comp->llc_dstripe_count;
+		new->llc_cstripe_count = comp->llc_cstripe_count;
 
 		list_add_tail(&new->llc_list, &new_layout->llot_comp_list);
 		new_layout->llot_cur_comp = new;
@@ -3151,7 +3383,8 @@ int llapi_mirror_find(struct llapi_layout *layout, uint64_t file_start,
 		if (rc < 0)
 			return rc;
 
-		if (flags & LCME_FL_STALE)
+		/* EC parity is not a copy of the data */
+		if (flags & (LCME_FL_STALE | LCME_FL_PARITY))
 			goto next;
 
 		rc = llapi_layout_mirror_id_get(layout, &rid);
@@ -3188,50 +3421,90 @@ int llapi_mirror_find(struct llapi_layout *layout, uint64_t file_start,
 	return mirror_id;
 }
 
-#ifndef NSEC_PER_SEC
-# define NSEC_PER_SEC 1000000000UL
-#endif
 #define ONE_MB 0x100000
-static struct timespec timespec_sub(struct timespec *before,
-				    struct timespec *after)
-{
-	struct timespec ret;
 
-	ret.tv_sec = after->tv_sec - before->tv_sec;
-	if (after->tv_nsec < before->tv_nsec) {
-		ret.tv_sec--;
-		ret.tv_nsec = NSEC_PER_SEC + after->tv_nsec - before->tv_nsec;
-	} else {
-		ret.tv_nsec = after->tv_nsec - before->tv_nsec;
-	}
+/* bytes read from the source mirror at a time by each stream */
+#define RESYNC_CHUNK_SIZE	(16 * ONE_MB)
+
+struct resync_copy {
+	int				 rsc_fd;
+	uint32_t			 rsc_src;
+	struct llapi_resync_comp	*rsc_comps;
+	int				 rsc_comp_size;
+	bool				*rsc_parity;
+	long				 rsc_page_size;
+	pthread_mutex_t			 rsc_lock;
+	int				 rsc_rc; /* first component error */
+};
+
+static ssize_t resync_copy_read(void *priv, void *buf, size_t count,
+				off_t pos)
+{
+	struct resync_copy *rsc = priv;
 
-	return ret;
+	return llapi_mirror_read(rsc->rsc_fd, rsc->rsc_src, buf, count, pos);
 }
 
-static void stats_log(struct timespec *now, struct timespec *start_time,
-		      ssize_t read_bytes, size_t write_bytes,
-		      off_t file_size_bytes)
+/*
+ * Write a chunk read from the source mirror to every component it overlaps.
+ * A component that fails is marked as not synced and the others carry on.
+ */
+static ssize_t resync_copy_write(void *priv, void *buf, size_t count,
+				 off_t pos)
 {
-	struct timespec diff = timespec_sub(start_time, now);
+	struct resync_copy *rsc = priv;
+	struct llapi_resync_comp *comp_array = rsc->rsc_comps;
+	ssize_t total = 0;
+	size_t to_write;
+	int i;
 
-	if (file_size_bytes == 0)
-		return;
+	/* round up to page align to make direct IO happy. */
+	to_write = ((count - 1) | (rsc->rsc_page_size - 1)) + 1;
 
-	if (diff.tv_sec == 0 && diff.tv_nsec == 0)
-		return;
+	for (i = 0; i < rsc->rsc_comp_size; i++) {
+		ssize_t written;
+		off_t pos2 = pos;
+		size_t to_write2 = to_write;
+
+		/* skip parity and non-overlapped component */
+		if (rsc->rsc_parity[i] || pos >= comp_array[i].lrc_end ||
+		    pos + to_write <= comp_array[i].lrc_start)
+			continue;
+
+		if (pos < comp_array[i].lrc_start)
+			pos2 = comp_array[i].lrc_start;
+
+		to_write2 -= pos2 - pos;
 
-	llapi_printf(LLAPI_MSG_NORMAL,
-		     "- { seconds: %li, rmbps: %5.2g, wmbps: %5.2g, copied: %lu, size: %lu, pct: %lu%% }\n",
-		     diff.tv_sec,
-		     (double) read_bytes/((ONE_MB * diff.tv_sec) +
-			     ((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
-		     (double) write_bytes/((ONE_MB * diff.tv_sec) +
-			     ((ONE_MB * diff.tv_nsec)/NSEC_PER_SEC)),
-		     write_bytes/ONE_MB,
-		     file_size_bytes/ONE_MB,
-		     ((write_bytes*100)/file_size_bytes));
+		if ((pos + to_write) > comp_array[i].lrc_end)
+			to_write2 -= pos + to_write - comp_array[i].lrc_end;
+
+		written = llapi_mirror_write(rsc->rsc_fd,
+					     comp_array[i].lrc_mirror_id,
+					     buf + pos2 - pos, to_write2, pos2);
+		if (written < 0) {
+			llapi_error(LLAPI_MSG_ERROR, written,
+				    "component %u not synced",
+				    comp_array[i].lrc_id);
+			pthread_mutex_lock(&rsc->rsc_lock);
+			comp_array[i].lrc_synced = false;
+			if (rsc->rsc_rc == 0)
+				rsc->rsc_rc = (int)written;
+			pthread_mutex_unlock(&rsc->rsc_lock);
+			continue;
+		}
+		assert(written == to_write2);
+		total += written;
+	}
+
+	return total;
 }
 
+static const struct llapi_copy_ops resync_copy_ops = {
+	.lco_read	= resync_copy_read,
+	.lco_write	= resync_copy_write,
+};
+
 int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 				    struct llapi_resync_comp *comp_array,
 				    int comp_size,  uint64_t start,
@@ -3239,9 +3512,20 @@ int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 				    unsigned long stats_interval_sec,
 				    unsigned long bandwidth_bytes_sec)
 {
-	size_t buflen = 64 << 20; /* 64M */
+	struct llapi_copy_param param = {
+		.lcp_ops		= &resync_copy_ops,
+		.lcp_chunk_size		= RESYNC_CHUNK_SIZE,
+		.lcp_streams		= LLAPI_COPY_STREAMS_DEFAULT,
+		.lcp_bandwidth		= bandwidth_bytes_sec,
+		.lcp_stats_interval	= stats_interval_sec,
+	};
+	struct resync_copy rsc = {
+		.rsc_fd		= fd,
+		.rsc_comps	= comp_array,
+		.rsc_comp_size	= comp_size,
+	};
+	struct llapi_copy *lc;
 	ssize_t page_size;
-	void *buf;
 	uint64_t pos = start;
 	uint64_t data_off = pos, data_end = pos;
 	uint64_t mirror_end = LUSTRE_EOF;
@@ -3249,41 +3533,73 @@ int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 	int i;
 	int rc;
 	int rc2 = 0;
-	struct timespec start_time;
-	struct timespec now;
-	struct timespec last_bw_print;
-	size_t total_bytes_read = 0;
-	size_t total_bytes_written = 0;
-	off_t write_estimation_bytes = 0;
 	struct stat st;
+	bool *parity;
+	int data_nr = 0;
 
 	rc = fstat(fd, &st);
 	if (rc < 0)
 		return -errno;
+
+	/*
+	 * EC parity components are regenerated from the data once all the
+	 * other components are in sync, rather than copied.
+	 */
+	parity = calloc(comp_size, sizeof(*parity));
+	if (parity == NULL)
+		return -ENOMEM;
+	for (i = 0; i < comp_size; i++) {
+		uint32_t flags = 0;
+
+		if (llapi_layout_comp_use_id(layout,
+					     comp_array[i].lrc_id) == 0 &&
+		    llapi_layout_comp_flags_get(layout, &flags) == 0 &&
+		    flags & LCME_FL_PARITY)
+			parity[i] = true;
+		else
+			data_nr++;
+	}
 	if (bandwidth_bytes_sec > 0 || stats_interval_sec)
-		write_estimation_bytes = st.st_size * comp_size;
+		param.lcp_stats_size = st.st_size * comp_size;
 
-	/* limit transfer size to what can be sent in one second */
-	if (bandwidth_bytes_sec && bandwidth_bytes_sec < buflen)
-		buflen = (bandwidth_bytes_sec + ONE_MB - 1) & ~(ONE_MB - 1);
+	/*
+	 * Opening the file again would break the resync lease, so the streams
+	 * share @fd.  Clients which set the mirror on the open file only and
+	 * not with each I/O leave a single stream.
+	 */
+	if (comp_size > 0 && !mirror_io_shared(fd, comp_array[0].lrc_mirror_id))
+		param.lcp_streams = 1;
+
+	/* limit the data in flight to what can be sent in one second */
+	if (bandwidth_bytes_sec &&
+	    bandwidth_bytes_sec < param.lcp_chunk_size * param.lcp_streams)
+		param.lcp_chunk_size = (bandwidth_bytes_sec /
+					param.lcp_streams + ONE_MB - 1) &
+				       ~(ONE_MB - 1);
 
 	page_size = sysconf(_SC_PAGESIZE);
 	if (page_size < 0) {
 		rc = -errno;
+		free(parity);
 		return rc;
 	}
 
-	rc = posix_memalign(&buf, page_size, buflen);
-	if (rc)
-		return -rc;
+	rsc.rsc_parity = parity;
+	rsc.rsc_page_size = page_size;
+	pthread_mutex_init(&rsc.rsc_lock, NULL);
+	param.lcp_priv = &rsc;
 
-	clock_gettime(CLOCK_MONOTONIC, &start_time);
-	now = last_bw_print = start_time;
+	lc = llapi_copy_init(&param);
+	if (!lc) {
+		rc = -errno;
+		pthread_mutex_destroy(&rsc.rsc_lock);
+		free(parity);
+		return rc;
+	}
 
-	while (pos < end) {
-		ssize_t bytes_read;
+	while (pos < end && data_nr > 0) {
+		off_t copied;
 		size_t to_read;
-		size_t to_write;
 		size_t data_size;
 
 		if (pos >= data_end) {
@@ -3293,12 +3609,12 @@ int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 				rc = llapi_mirror_find(layout, pos, end,
 							&mirror_end);
 				if (rc < 0) {
-					free(buf);
 					llapi_error(LLAPI_MSG_ERROR, rc,
 						    "cannot find source mirror");
-					return rc;
+					break;
 				}
 				src = rc;
+				rc = 0;
 				/* restrict mirror end by resync end */
 				mirror_end = MIN(end, mirror_end);
 			}
@@ -3327,8 +3643,8 @@ int llapi_mirror_resync_many_params(int fd, struct llapi_layout *layout,
 				size_t to_punch;
 				uint32_t mid = comp_array[i].lrc_mirror_id;
 
-				/* skip non-overlapped component */
-				if (pos >= comp_array[i].lrc_end ||
+				/* skip parity and non-overlapped component */
+				if (parity[i] || pos >= comp_array[i].lrc_end ||
 				    data_off <= comp_array[i].lrc_start)
 					continue;
 
@@ -3381,130 +3697,40 @@ do_read:
 
 		assert(data_end <= mirror_end);
 
-		to_read = MIN(buflen, to_read);
+		/* the range may run up to LUSTRE_EOF on a full copy */
+		to_read = MIN(to_read, (uint64_t)LLONG_MAX / 2 - pos);
 		to_read = ((to_read - 1) | (page_size - 1)) + 1;
-		bytes_read = llapi_mirror_read(fd, src, buf, to_read, pos);
-		if (bytes_read == 0) {
-			/* end of file */
-			break;
-		}
-		if (bytes_read < 0) {
-			rc = bytes_read;
+
+		rsc.rsc_src = src;
+		copied = llapi_copy_range(lc, pos, pos + to_read);
+		if (copied < 0) {
+			rc = copied;
 			llapi_error(LLAPI_MSG_ERROR, rc,
-				    "error reading bytes %ld-%ld of mirror %u",
-				    pos, to_read, src);
+				    "error copying bytes %ld-%ld of mirror %u",
+				    pos, pos + to_read, src);
 			break;
 		}
-		total_bytes_read += bytes_read;
-
-		/* round up to page align to make direct IO happy. */
-		to_write = ((bytes_read - 1) | (page_size - 1)) + 1;
-
-		for (i = 0; i < comp_size; i++) {
-			unsigned long long write_target;
-			struct timespec diff;
-			ssize_t written;
-			off_t pos2 = pos;
-			size_t to_write2 = to_write;
-
-			/* skip non-overlapped component */
-			if (pos >= comp_array[i].lrc_end ||
-			    pos + to_write <= comp_array[i].lrc_start)
-				continue;
-
-			if (pos < comp_array[i].lrc_start)
-				pos2 = comp_array[i].lrc_start;
-
-			to_write2 -= pos2 - pos;
-
-			if ((pos + to_write) > comp_array[i].lrc_end)
-				to_write2 -= pos + to_write -
-					     comp_array[i].lrc_end;
-
-			written = llapi_mirror_write(fd,
-					comp_array[i].lrc_mirror_id,
-					buf + pos2 - pos,
-					to_write2, pos2);
-			if (written < 0) {
-				comp_array[i].lrc_synced = false;
-				llapi_error(LLAPI_MSG_ERROR, written,
-					    "component %u not synced",
-					    comp_array[i].lrc_id);
-				if (rc2 == 0)
-					rc2 = (int)written;
-				continue;
-			}
-			assert(written == to_write2);
-			total_bytes_written += written;
-
-			if (bandwidth_bytes_sec == 0)
-				continue;
-
-			clock_gettime(CLOCK_MONOTONIC, &now);
-			diff = timespec_sub(&start_time, &now);
-			write_target = ((bandwidth_bytes_sec * diff.tv_sec) +
-				((bandwidth_bytes_sec *
-				diff.tv_nsec)/NSEC_PER_SEC));
-
-			if (write_target < total_bytes_written) {
-				unsigned long long excess;
-				struct timespec delay = { 0, 0 };
-
-				excess = total_bytes_written - write_target;
-
-				if (excess == 0)
-					continue;
-
-				delay.tv_sec = excess / bandwidth_bytes_sec;
-				delay.tv_nsec = (excess % bandwidth_bytes_sec) *
-					NSEC_PER_SEC / bandwidth_bytes_sec;
-
-				do {
-					rc = clock_nanosleep(CLOCK_MONOTONIC, 0,
-							     &delay, &delay);
-				} while (rc < 0 && errno == EINTR);
-
-				if (rc < 0) {
-					llapi_error(LLAPI_MSG_ERROR, rc,
-						"errors: delay for bandwidth control failed: %s\n",
-						strerror(-rc));
-					rc = 0;
-				}
-			}
-
-			if (stats_interval_sec) {
-				clock_gettime(CLOCK_MONOTONIC, &now);
-				if ((total_bytes_written != end - start) &&
-				     (now.tv_sec >= last_bw_print.tv_sec +
-						 stats_interval_sec)) {
-					stats_log(&now, &start_time,
-						  total_bytes_read,
-						  total_bytes_written,
-						  write_estimation_bytes);
-					last_bw_print = now;
-				}
-			}
+		if (copied < pos + to_read) {
+			/* end of file */
+			pos = copied;
+			break;
 		}
-		pos += bytes_read;
+		pos = copied;
 	}
 
-	free(buf);
+	llapi_copy_fini(lc);
+	pthread_mutex_destroy(&rsc.rsc_lock);
+	if (rsc.rsc_rc)
+		rc2 = rsc.rsc_rc;
 
 	if (rc < 0) {
 		/* fatal error happens */
 		for (i = 0; i < comp_size; i++)
 			comp_array[i].lrc_synced = false;
+		free(parity);
 		return rc;
 	}
 
-	/* Output at least one log, regardless of stats_interval */
-	if (stats_interval_sec) {
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		stats_log(&now, &start_time, total_bytes_read,
-			  total_bytes_written,
-			  write_estimation_bytes);
-	}
-
 	/**
 	 * no fatal error happens, each lrc_synced tells whether the component
 	 * has been resync successfully.
@@ -3512,7 +3738,7 @@ do_read:
 	for (i = 0; i < comp_size; i++) {
 		struct llapi_resync_comp *comp = comp_array + i;
 
-		if (!comp->lrc_synced)
+		if (!comp->lrc_synced || parity[i])
 			continue;
 		if (pos < comp->lrc_start || pos >= comp->lrc_end)
 			continue;
@@ -3532,6 +3758,23 @@ do_read:
 			comp->lrc_synced = false;
 	}
 
+	/* the data is in sync now, encode the parity from it */
+	for (i = 0; i < comp_size; i++) {
+		if (!parity[i])
+			continue;
+
+		rc = llapi_ec_parity_resync(fd, comp_array[i].lrc_id);
+		if (rc < 0) {
+			comp_array[i].lrc_synced = false;
+			llapi_error(LLAPI_MSG_ERROR, rc,
+				    "component %u not synced",
+				    comp_array[i].lrc_id);
+			if (rc2 == 0)
+				rc2 = rc;
+		}
+	}
+	free(parity);
+
 	/**
 	 * returns the first error code for partially successful resync if
 	 * possible.
@@ -3707,12 +3950,15 @@ static int llapi_layout_sanity_cb(struct llapi_layout *layout,
 			args->lsa_rc = LSE_FLAGS;
 	} else if (!args->lsa_incomplete) {
 		if (args->lsa_flr) {
-			if (comp->llc_flags & ~LCME_USER_COMP_FLAGS)
+			/* parity is only set by llapi_layout_ec_parity_add() */
+			if (comp->llc_flags & ~(LCME_USER_COMP_FLAGS |
+			    LCME_FL_COMPRESS |
+			    (comp->llc_cstripe_count ? LCME_FL_PARITY : 0)))
 				args->lsa_rc = LSE_FLAGS;
 		} else {
 			if (comp->llc_flags &
 			    ~(LCME_FL_EXTENSION | LCME_FL_PREF_RW |
-			      LCME_FL_NOCOMPR))
+			      LCME_FL_COMPRESS | LCME_FL_NOCOMPR))
 				args->lsa_rc = LSE_FLAGS;
 		}
 	}
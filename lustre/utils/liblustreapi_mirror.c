@@ -45,6 +45,7 @@
 #include <libcfs/util/ioctl.h>
 #include <lustre/lustreapi.h>
 #include <linux/lustre/lustre_ioctl.h>
+#include "lustreapi_internal.h"
 
 /**
  * Set the mirror id for the opening file pointed by @fd, once the mirror
@@ -96,6 +97,51 @@ int llapi_mirror_clear(int fd)
 	return llapi_mirror_set(fd, 0);
 }
 
+/*
+ * Direct I/O to mirror @id by LL_IOC_FLR_MIRROR_IO, which leaves the mirror
+ * set on @fd alone, so that threads can share @fd.  Clients without it are
+ * driven by pread/pwrite() once @id is set on @fd, and *@mirror_set tells
+ * the caller to clear it.
+ */
+static ssize_t mirror_rw(int fd, unsigned int id, bool write, void *buf,
+			 size_t count, off_t pos, bool *mirror_set)
+{
+	struct ll_ioc_mirror_io lmi = {
+		.lmi_mirror_id	= id,
+		.lmi_flags	= write ? LL_MIRROR_IO_WRITE : 0,
+		.lmi_buf	= (uintptr_t)buf,
+		.lmi_count	= count,
+		.lmi_pos	= pos,
+	};
+	ssize_t rc;
+
+	if (!*mirror_set) {
+		rc = ioctl(fd, LL_IOC_FLR_MIRROR_IO, &lmi);
+		if (rc >= 0 || errno != ENOTTY)
+			return rc < 0 ? -errno : rc;
+
+		rc = llapi_mirror_set(fd, id);
+		if (rc < 0)
+			return rc;
+		*mirror_set = true;
+	}
+
+	rc = write ? pwrite(fd, buf, count, pos) : pread(fd, buf, count, pos);
+
+	return rc < 0 ? -errno : rc;
+}
+
+/*
+ * True if threads can share @fd for llapi_mirror_read/write() of mirror @id,
+ * that is if the client supports LL_IOC_FLR_MIRROR_IO.
+ */
+bool mirror_io_shared(int fd, unsigned int id)
+{
+	struct ll_ioc_mirror_io lmi = { .lmi_mirror_id = id };
+
+	return ioctl(fd, LL_IOC_FLR_MIRROR_IO, &lmi) == 0 || errno != ENOTTY;
+}
+
 /**
  * Read data from a specified mirror with @id. This function won't read
  * partial read result; either file end is reached, or number of @count bytes
@@ -113,6 +159,7 @@ int llapi_mirror_clear(int fd)
 ssize_t llapi_mirror_read(int fd, unsigned int id, void *buf, size_t count,
 			  off_t pos)
 {
+	bool mirror_set = false;
 	ssize_t result = 0;
 	ssize_t page_size;
 	int rc;
@@ -123,19 +170,16 @@ ssize_t llapi_mirror_read(int fd, unsigned int id, void *buf, size_t count,
 		return rc;
 	}
 
-	rc = llapi_mirror_set(fd, id);
-	if (rc < 0)
-		return rc;
-
 	while (count > 0) {
 		ssize_t bytes_read;
 
-		bytes_read = pread(fd, buf, count, pos);
+		bytes_read = mirror_rw(fd, id, false, buf, count, pos,
+				       &mirror_set);
 		if (!bytes_read) /* end of file */
 			break;
 
 		if (bytes_read < 0) {
-			result = -errno;
+			result = bytes_read;
 			llapi_error(LLAPI_MSG_WARN, result,
 				    "fail to pread %ld-%ld of mirror %u",
 				    pos, count, id);
@@ -151,7 +195,8 @@ ssize_t llapi_mirror_read(int fd, unsigned int id, void *buf, size_t count,
 			break;
 	}
 
-	(void) llapi_mirror_clear(fd);
+	if (mirror_set)
+		(void) llapi_mirror_clear(fd);
 
 	return result;
 }
@@ -159,9 +204,9 @@ ssize_t llapi_mirror_read(int fd, unsigned int id, void *buf, size_t count,
 ssize_t llapi_mirror_write(int fd, unsigned int id, const void *buf,
 			   size_t count, off_t pos)
 {
+	bool mirror_set = false;
 	ssize_t result = 0;
 	ssize_t page_size;
-	int rc;
 
 	page_size = sysconf(_SC_PAGESIZE);
 	if (page_size < 0)
@@ -170,10 +215,6 @@ ssize_t llapi_mirror_write(int fd, unsigned int id, const void *buf,
 	if (((unsigned long)buf & (page_size - 1)) || pos & (page_size - 1))
 		return -EINVAL;
 
-	rc = llapi_mirror_set(fd, id);
-	if (rc < 0)
-		return rc;
-
 	while (count > 0) {
 		ssize_t bytes_written;
 
@@ -182,9 +223,10 @@ ssize_t llapi_mirror_write(int fd, unsigned int id, const void *buf,
 			break;
 		}
 
-		bytes_written = pwrite(fd, buf, count, pos);
+		bytes_written = mirror_rw(fd, id, true, (void *)buf, count, pos,
+					  &mirror_set);
 		if (bytes_written < 0) {
-			result = -errno;
+			result = bytes_written;
 			llapi_error(LLAPI_MSG_WARN, result,
 				    "fail to pwrite %ld-%ld of mirror %u",
 				    pos, count, id);
@@ -197,7 +239,8 @@ ssize_t llapi_mirror_write(int fd, unsigned int id, const void *buf,
 		count -= bytes_written;
 	}
 
-	(void) llapi_mirror_clear(fd);
+	if (mirror_set)
+		(void) llapi_mirror_clear(fd);
 
 	return result;
 }
@@ -251,6 +294,32 @@ bool llapi_mirror_is_sparse(int fd, unsigned int id)
 	return sparse;
 }
 
+/**
+ * Encode the parity of an erasure coded component from its data.
+ *
+ * The file must be held by a resync lease, and the data mirror must be in
+ * sync.
+ *
+ * \param fd		file descriptor of the erasure coded file
+ * \param comp_id	id of the LCME_FL_PARITY component
+ *
+ * \retval 0 on success.
+ * \retval -errno on failure.
+ */
+int llapi_ec_parity_resync(int fd, uint32_t comp_id)
+{
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_EC_PARITY_RESYNC, &comp_id);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "fail to encode parity of component %u", comp_id);
+	}
+
+	return rc;
+}
+
 /**
  * Seek data in a specified mirror with @id. This function looks for the
  * first data segment from given offset and returns its offset and length
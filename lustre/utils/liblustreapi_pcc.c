@@ -559,7 +559,7 @@ out_free_param:
 }
 
 static int llapi_pcc_scan_detach(const char *pname, const char *fname,
-				 struct hsm_scan_control *hsc)
+				 struct hsm_scan_control *hsc, void *ctx)
 {
 	struct lu_pcc_detach_fid detach;
 	char fullname[PATH_MAX];
@@ -352,6 +352,25 @@ int llapi_rmfid(const char *path, struct fid_array *fa)
 	return rc ? -errno : 0;
 }
 
+/**
+ * Create, unlink or change the attributes of many names in the directory
+ * \a dirfd with batched RPCs. Each entry of \a ops is processed in order
+ * and gets its own result in lbe_result.
+ *
+ * \param dirfd[in]		descriptor of the directory of the names
+ * \param ops[in,out]		entries to process, lbo_count set
+ *
+ * \retval			0 if the entries were processed, even if some
+ *				of them failed
+ * \retval			-EOPNOTSUPP if the MDT does not batch them,
+ *				the caller should fall back to single calls
+ * \retval			-ve/errno on other failures
+ */
+int llapi_batch_ops(int dirfd, struct lu_batch_ops *ops)
+{
+	return ioctl(dirfd, LL_IOC_BATCH_OPS, ops) ? -errno : 0;
+}
+
 int llapi_direntry_remove(char *dname)
 {
 #ifdef LL_IOC_REMOVE_ENTRY
@@ -0,0 +1,938 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/utils/lljobstat.c
+ *
+ * List the top jobs of the job_stats files of the local targets, or of
+ * job_stats snapshots saved with "lctl get_param *.*.job_stats".
+ *
+ * The files are read in parallel by several threads. Each thread parses
+ * them one line at a time into its own table of jobs, without building a
+ * YAML document, and the tables are merged once all the files are read.
+ * The counts of the previous interval are kept, so that the top jobs can
+ * be ranked by their rate of operations, and the top jobs can be written
+ * to a file in the Prometheus text format.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <glob.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libcfs/util/hash.h>
+#include <libcfs/util/list.h>
+#include <lustre/lustreapi.h>
+#include "lstddef.h"
+
+#define JS_THREADS_MAX		16
+#define JS_HASH_SHIFT		10
+
+static const char *progname;
+
+/* the operations shown, with their abbreviation, "ops" is the total */
+static const struct js_op {
+	const char	*jo_abbr;
+	const char	*jo_name;
+} js_ops[] = {
+	{ "ops", "ops" },
+	{ "cr", "create" },
+	{ "op", "open" },
+	{ "cl", "close" },
+	{ "mn", "mknod" },
+	{ "ln", "link" },
+	{ "ul", "unlink" },
+	{ "mk", "mkdir" },
+	{ "rm", "rmdir" },
+	{ "mv", "rename" },
+	{ "ga", "getattr" },
+	{ "sa", "setattr" },
+	{ "gx", "getxattr" },
+	{ "sx", "setxattr" },
+	{ "st", "statfs" },
+	{ "sy", "sync" },
+	{ "rd", "read" },
+	{ "wr", "write" },
+	{ "pu", "punch" },
+	{ "mi", "migrate" },
+	{ "fa", "fallocate" },
+	{ "dt", "destroy" },
+	{ "gi", "get_info" },
+	{ "si", "set_info" },
+	{ "qc", "quotactl" },
+	{ "pa", "prealloc" },
+};
+
+#define JS_OP_NR	ARRAY_SIZE(js_ops)
+
+struct js_job {
+	struct list_head	 jj_hash;
+	char			*jj_id;
+	unsigned long long	 jj_ops[JS_OP_NR];
+	/* counts of the previous interval, if jj_prev_valid */
+	unsigned long long	 jj_prev[JS_OP_NR];
+	double			 jj_key;	/* ops, or ops per second */
+	unsigned int		 jj_gen;	/* interval last seen */
+	bool			 jj_prev_valid;
+};
+
+struct js_table {
+	struct list_head	*jt_head;
+	unsigned int		 jt_shift;
+	unsigned int		 jt_count;
+};
+
+struct js_options {
+	const char	*o_param;
+	const char	*o_prom_file;
+	char		**o_statsfiles;
+	int		 o_statsfile_nr;
+	int		 o_count;
+	int		 o_interval;
+	int		 o_repeats;
+	int		 o_threads;
+	bool		 o_fullname;
+	bool		 o_rate;
+};
+
+static struct js_options opt = {
+	.o_param	= "*.*.job_stats",
+	.o_count	= 5,
+	.o_interval	= 10,
+	.o_repeats	= -1,
+};
+
+/* files shared by the reader threads of an interval */
+struct js_readers {
+	pthread_mutex_t	  jr_lock;
+	char		**jr_files;
+	int		  jr_file_nr;
+	int		  jr_next;	/* next file to read, under jr_lock */
+};
+
+struct js_reader {
+	struct js_readers	*jr_readers;
+	struct js_table		 jr_table;
+	pthread_t		 jr_thread;
+	int			 jr_rc;
+};
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: %s [-c|--count COUNT] [-i|--interval INTERVAL]\n"
+		"\t[-n|--repeats REPEATS] [-m|--mdt] [-o|--ost] [--param PARAM]\n"
+		"\t[--fullname|--no-fullname] [-r|--rate] [-t|--threads THREADS]\n"
+		"\t[--prometheus FILE] [--statsfile FILE]...\n"
+		"List top jobs.\n"
+		"\t-c, --count       the number of top jobs to be listed (default 5)\n"
+		"\t-i, --interval    the interval in seconds to check job stats again (default 10)\n"
+		"\t-n, --repeats     the times to repeat the parsing (default unlimited)\n"
+		"\t-m, --mdt         check only MDT job stats\n"
+		"\t-o, --ost         check only OST job stats\n"
+		"\t--param           the param path to be checked (default *.*.job_stats)\n"
+		"\t--fullname        show full operation name\n"
+		"\t--no-fullname     show abbreviated operation name (default)\n"
+		"\t-r, --rate        rank jobs by operations per second over the interval\n"
+		"\t-t, --threads     the number of files read in parallel (default online CPUs, max %d)\n"
+		"\t--prometheus      also write the top jobs to FILE in Prometheus text format\n"
+		"\t--statsfile       parse FILE saved by 'lctl get_param *.*.job_stats > FILE'\n"
+		"\t                  instead of the job_stats of the local targets, can be\n"
+		"\t                  repeated to add up the jobs of several files\n",
+		progname, JS_THREADS_MAX);
+}
+
+static void exit_silently(int signo)
+{
+	exit(0);
+}
+
+/* FNV-1a */
+static __u64 js_hash(const char *id)
+{
+	__u64 hash = 0xcbf29ce484222325ULL;
+
+	while (*id) {
+		hash ^= (unsigned char)*id++;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static int js_table_init(struct js_table *table, unsigned int shift)
+{
+	unsigned int i;
+
+	table->jt_head = malloc(sizeof(*table->jt_head) << shift);
+	if (!table->jt_head)
+		return -ENOMEM;
+
+	for (i = 0; i < (1U << shift); i++)
+		INIT_LIST_HEAD(&table->jt_head[i]);
+	table->jt_shift = shift;
+	table->jt_count = 0;
+
+	return 0;
+}
+
+static void js_job_free(struct js_job *job)
+{
+	list_del(&job->jj_hash);
+	free(job->jj_id);
+	free(job);
+}
+
+static void js_table_fini(struct js_table *table)
+{
+	struct js_job *job, *next;
+	unsigned int i;
+
+	if (!table->jt_head)
+		return;
+
+	for (i = 0; i < (1U << table->jt_shift); i++)
+		list_for_each_entry_safe(job, next, &table->jt_head[i],
+					 jj_hash)
+			js_job_free(job);
+	free(table->jt_head);
+	table->jt_head = NULL;
+}
+
+/* double the buckets, keep the current ones if out of memory */
+static void js_table_grow(struct js_table *table)
+{
+	struct js_table bigger;
+	struct js_job *job, *next;
+	unsigned int i;
+
+	if (js_table_init(&bigger, table->jt_shift + 1))
+		return;
+
+	for (i = 0; i < (1U << table->jt_shift); i++) {
+		list_for_each_entry_safe(job, next, &table->jt_head[i],
+					 jj_hash) {
+			list_del(&job->jj_hash);
+			list_add(&job->jj_hash,
+				 &bigger.jt_head[hash_64(js_hash(job->jj_id),
+							 bigger.jt_shift)]);
+		}
+	}
+	free(table->jt_head);
+	table->jt_head = bigger.jt_head;
+	table->jt_shift = bigger.jt_shift;
+}
+
+static struct js_job *js_table_find(struct js_table *table, const char *id)
+{
+	struct list_head *head;
+	struct js_job *job;
+
+	head = &table->jt_head[hash_64(js_hash(id), table->jt_shift)];
+	list_for_each_entry(job, head, jj_hash) {
+		if (strcmp(job->jj_id, id) == 0)
+			return job;
+	}
+
+	job = calloc(1, sizeof(*job));
+	if (!job)
+		return NULL;
+
+	job->jj_id = strdup(id);
+	if (!job->jj_id) {
+		free(job);
+		return NULL;
+	}
+	list_add(&job->jj_hash, head);
+	if (++table->jt_count > (2U << table->jt_shift))
+		js_table_grow(table);
+
+	return job;
+}
+
+static int js_op_index(const char *name, size_t len)
+{
+	int i;
+
+	for (i = 1; i < JS_OP_NR; i++)
+		if (strncmp(js_ops[i].jo_name, name, len) == 0 &&
+		    js_ops[i].jo_name[len] == '\0')
+			return i;
+
+	return -1;
+}
+
+/*
+ * Get the jobid of a "- job_id: ID" line. A jobid with special characters
+ * is double quoted by the kernel, with "\xHH" escapes.
+ */
+static void js_parse_jobid(char *val, char *id, size_t size)
+{
+	size_t len;
+	int i = 0;
+
+	while (*val == ' ' || *val == '\t')
+		val++;
+	len = strcspn(val, "\n");
+	while (len > 0 && (val[len - 1] == ' ' || val[len - 1] == '\t'))
+		len--;
+	val[len] = '\0';
+
+	if (len < 2 || val[0] != '"' || val[len - 1] != '"') {
+		snprintf(id, size, "%s", val);
+		return;
+	}
+
+	val[len - 1] = '\0';
+	for (val++; *val != '\0' && i < size - 1; val++) {
+		if (val[0] == '\\' && val[1] == 'x' &&
+		    isxdigit(val[2]) && isxdigit(val[3])) {
+			char hex[3] = { val[2], val[3], '\0' };
+
+			id[i++] = strtoul(hex, NULL, 16);
+			val += 3;
+			continue;
+		}
+		id[i++] = *val;
+	}
+	id[i] = '\0';
+}
+
+/*
+ * Add the samples of each job in a stream to a table. Only the lines
+ * "- job_id: ID" and "  name: { samples: N, ... }" of the known operations
+ * are parsed, the other lines are skipped, so saved files holding the
+ * output of several targets, with their "param=" lines, can be parsed.
+ */
+static int js_parse_stream(FILE *fp, struct js_table *table)
+{
+	char id[LUSTRE_JOBID_SIZE * 4];
+	struct js_job *job = NULL;
+	size_t size = 0;
+	char *line = NULL;
+	ssize_t len;
+	int rc = 0;
+
+	while ((len = getline(&line, &size, fp)) >= 0) {
+		char *name, *colon, *samples;
+		unsigned long long val;
+		int idx;
+
+		if (strncmp(line, "- job_id:", 9) == 0) {
+			js_parse_jobid(line + 9, id, sizeof(id));
+			job = js_table_find(table, id);
+			if (!job) {
+				rc = -ENOMEM;
+				break;
+			}
+			continue;
+		}
+
+		if (strncmp(line, "  ", 2) != 0) {
+			job = NULL;
+			continue;
+		}
+		if (!job)
+			continue;
+
+		name = line + 2;
+		colon = strchr(name, ':');
+		if (!colon)
+			continue;
+		idx = js_op_index(name, colon - name);
+		if (idx < 0)
+			continue;
+
+		samples = strstr(colon, "samples:");
+		if (!samples)
+			continue;
+		val = strtoull(samples + 8, NULL, 10);
+		job->jj_ops[idx] += val;
+		job->jj_ops[0] += val;
+	}
+	if (!rc && ferror(fp))
+		rc = -EIO;
+	free(line);
+
+	return rc;
+}
+
+static void *js_reader_thread(void *arg)
+{
+	struct js_reader *reader = arg;
+	struct js_readers *readers = reader->jr_readers;
+
+	while (!reader->jr_rc) {
+		const char *file;
+		FILE *fp;
+		int rc;
+
+		pthread_mutex_lock(&readers->jr_lock);
+		if (readers->jr_next == readers->jr_file_nr) {
+			pthread_mutex_unlock(&readers->jr_lock);
+			break;
+		}
+		file = readers->jr_files[readers->jr_next++];
+		pthread_mutex_unlock(&readers->jr_lock);
+
+		fp = fopen(file, "r");
+		if (!fp) {
+			/* a target may stop while its stats are listed */
+			fprintf(stderr, "%s: cannot open '%s': %s\n",
+				progname, file, strerror(errno));
+			continue;
+		}
+		rc = js_parse_stream(fp, &reader->jr_table);
+		if (rc) {
+			fprintf(stderr, "%s: failed to parse '%s': %s\n",
+				progname, file, strerror(-rc));
+			reader->jr_rc = rc;
+		}
+		fclose(fp);
+	}
+
+	return NULL;
+}
+
+/* add the jobs of a reader to all the jobs seen in interval @gen */
+static int js_table_merge(struct js_table *all, struct js_table *table,
+			  unsigned int gen)
+{
+	struct js_job *job, *tgt;
+	unsigned int i;
+	int op;
+
+	for (i = 0; i < (1U << table->jt_shift); i++) {
+		list_for_each_entry(job, &table->jt_head[i], jj_hash) {
+			tgt = js_table_find(all, job->jj_id);
+			if (!tgt)
+				return -ENOMEM;
+
+			/* first time seen in this interval */
+			if (tgt->jj_gen != gen) {
+				tgt->jj_prev_valid = tgt->jj_gen &&
+						     tgt->jj_gen == gen - 1;
+				memcpy(tgt->jj_prev, tgt->jj_ops,
+				       sizeof(tgt->jj_prev));
+				memset(tgt->jj_ops, 0, sizeof(tgt->jj_ops));
+				tgt->jj_gen = gen;
+			}
+			for (op = 0; op < JS_OP_NR; op++)
+				tgt->jj_ops[op] += job->jj_ops[op];
+		}
+	}
+
+	return 0;
+}
+
+/* read the files into @all in parallel, and drop the jobs not seen */
+static int js_read_files(struct js_table *all, char **files, int file_nr,
+			 unsigned int gen)
+{
+	struct js_readers readers = {
+		.jr_files	= files,
+		.jr_file_nr	= file_nr,
+	};
+	struct js_reader *reader;
+	struct js_job *job, *next;
+	int nr = opt.o_threads;
+	int started, tables;
+	int rc = 0;
+	unsigned int i;
+
+	if (nr > file_nr)
+		nr = file_nr;
+	if (nr < 1)
+		nr = 1;
+
+	reader = calloc(nr, sizeof(*reader));
+	if (!reader)
+		return -ENOMEM;
+	pthread_mutex_init(&readers.jr_lock, NULL);
+
+	for (started = 0; started < nr; started++) {
+		reader[started].jr_readers = &readers;
+		rc = js_table_init(&reader[started].jr_table, JS_HASH_SHIFT);
+		if (rc)
+			break;
+		if (pthread_create(&reader[started].jr_thread, NULL,
+				   js_reader_thread, &reader[started])) {
+			js_table_fini(&reader[started].jr_table);
+			break;
+		}
+	}
+
+	/* read all the files in this thread if no thread could be started */
+	tables = started;
+	if (started == 0 && !rc) {
+		rc = js_table_init(&reader[0].jr_table, JS_HASH_SHIFT);
+		if (rc)
+			goto out;
+		js_reader_thread(&reader[0]);
+		tables = 1;
+	}
+
+	for (i = 0; i < tables; i++) {
+		if (i < started)
+			pthread_join(reader[i].jr_thread, NULL);
+		if (!rc)
+			rc = reader[i].jr_rc;
+		if (!rc)
+			rc = js_table_merge(all, &reader[i].jr_table, gen);
+		js_table_fini(&reader[i].jr_table);
+	}
+
+	for (i = 0; i < (1U << all->jt_shift); i++) {
+		list_for_each_entry_safe(job, next, &all->jt_head[i], jj_hash) {
+			if (job->jj_gen == gen)
+				continue;
+			js_job_free(job);
+			all->jt_count--;
+		}
+	}
+out:
+	pthread_mutex_destroy(&readers.jr_lock);
+	free(reader);
+
+	return rc;
+}
+
+/* operations of a job, per second over @elapsed seconds if positive */
+static double js_job_ops(struct js_job *job, int op, double elapsed)
+{
+	unsigned long long prev = 0;
+
+	if (elapsed <= 0)
+		return job->jj_ops[op];
+
+	/* stats of a job cleared and seen again restart from zero */
+	if (job->jj_prev_valid && job->jj_prev[op] <= job->jj_ops[op])
+		prev = job->jj_prev[op];
+
+	return (job->jj_ops[op] - prev) / elapsed;
+}
+
+static void js_heap_sift_down(struct js_job **heap, int nr, int i)
+{
+	while (2 * i + 1 < nr) {
+		int child = 2 * i + 1;
+		struct js_job *tmp;
+
+		if (child + 1 < nr &&
+		    heap[child + 1]->jj_key < heap[child]->jj_key)
+			child++;
+		if (heap[i]->jj_key <= heap[child]->jj_key)
+			break;
+		tmp = heap[i];
+		heap[i] = heap[child];
+		heap[child] = tmp;
+		i = child;
+	}
+}
+
+static void js_heap_sift_up(struct js_job **heap, int i)
+{
+	while (i > 0 && heap[(i - 1) / 2]->jj_key > heap[i]->jj_key) {
+		struct js_job *tmp = heap[i];
+
+		heap[i] = heap[(i - 1) / 2];
+		heap[(i - 1) / 2] = tmp;
+		i = (i - 1) / 2;
+	}
+}
+
+/*
+ * Pick the @count jobs with the most operations, or the highest rate,
+ * with a min-heap of the best jobs seen so far, sorted in decreasing order.
+ */
+static int js_top_jobs(struct js_table *all, struct js_job **top, int count,
+		       double elapsed)
+{
+	struct js_job *job, *tmp;
+	unsigned int i;
+	int nr = 0;
+	int j;
+
+	for (i = 0; i < (1U << all->jt_shift); i++) {
+		list_for_each_entry(job, &all->jt_head[i], jj_hash) {
+			job->jj_key = js_job_ops(job, 0, elapsed);
+			if (nr < count) {
+				top[nr] = job;
+				js_heap_sift_up(top, nr++);
+			} else if (count && job->jj_key > top[0]->jj_key) {
+				top[0] = job;
+				js_heap_sift_down(top, nr, 0);
+			}
+		}
+	}
+
+	/* move the smallest key to the end, for a decreasing order */
+	for (j = nr - 1; j > 0; j--) {
+		tmp = top[0];
+		top[0] = top[j];
+		top[j] = tmp;
+		js_heap_sift_down(top, j, 0);
+	}
+
+	return nr;
+}
+
+/* quote and escape a jobid with special characters, as the kernel does */
+static void js_quote_jobid(const char *id, char *buf, size_t size)
+{
+	bool quote = id[0] == '@';
+	const char *c;
+	int len = 0;
+
+	for (c = id; *c != '\0'; c++)
+		if (!isalnum(*c) && strchr(".@-_/", *c) == NULL)
+			quote = true;
+
+	if (!quote) {
+		snprintf(buf, size, "%s:", id);
+		return;
+	}
+
+	len += snprintf(buf + len, size - len, "\"");
+	for (c = id; *c != '\0' && len < size; c++) {
+		if (!isalnum(*c) && strchr(".@-_:/", *c) == NULL)
+			len += snprintf(buf + len, size - len, "\\x%02X",
+					(unsigned char)*c);
+		else
+			len += snprintf(buf + len, size - len, "%c", *c);
+	}
+	if (len < size)
+		snprintf(buf + len, size - len, "\":");
+}
+
+static void js_print_top(struct js_job **top, int nr, double elapsed)
+{
+	char name[LUSTRE_JOBID_SIZE * 4 + 4];
+	int i, op;
+
+	printf("---\n"); /* mark the beginning of YAML doc in stream */
+	printf("timestamp: %lld\n", (long long)time(NULL));
+	if (elapsed > 0)
+		printf("rate_interval: %.3f\n", elapsed);
+	printf("top_jobs:\n");
+	for (i = 0; i < nr; i++) {
+		bool first = true;
+
+		js_quote_jobid(top[i]->jj_id, name, sizeof(name));
+		printf("- %-16s {", name);
+		for (op = 0; op < JS_OP_NR; op++) {
+			double val = js_job_ops(top[i], op, elapsed);
+
+			if (op && top[i]->jj_ops[op] == 0)
+				continue;
+			printf("%s%s: ", first ? "" : ", ",
+			       opt.o_fullname ? js_ops[op].jo_name :
+						js_ops[op].jo_abbr);
+			if (elapsed > 0)
+				printf("%.1f", val);
+			else
+				printf("%llu", top[i]->jj_ops[op]);
+			first = false;
+		}
+		printf("}\n");
+	}
+	printf("...\n"); /* mark the end of YAML doc in stream */
+	fflush(stdout);
+}
+
+static void js_prom_label(FILE *fp, const char *val)
+{
+	for (; *val; val++) {
+		if (*val == '\\' || *val == '"')
+			fprintf(fp, "\\%c", *val);
+		else if (*val == '\n')
+			fputs("\\n", fp);
+		else
+			fputc(*val, fp);
+	}
+}
+
+/*
+ * Write the top jobs in the Prometheus text format, into a temporary file
+ * renamed over @path, so that a collector never reads a partial file.
+ */
+static int js_write_prom(const char *path, struct js_job **top, int nr,
+			 double elapsed)
+{
+	const char *metric = elapsed > 0 ? "lustre_job_ops_rate" :
+					   "lustre_job_ops_total";
+	char tmp[PATH_MAX];
+	FILE *fp;
+	int i, op;
+	int rc = 0;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= sizeof(tmp))
+		return -ENAMETOOLONG;
+
+	fp = fopen(tmp, "w");
+	if (!fp)
+		return -errno;
+
+	if (elapsed > 0) {
+		fprintf(fp, "# HELP %s Operations per second of the top jobs.\n",
+			metric);
+		fprintf(fp, "# TYPE %s gauge\n", metric);
+	} else {
+		fprintf(fp, "# HELP %s Operations of the top jobs.\n", metric);
+		fprintf(fp, "# TYPE %s counter\n", metric);
+	}
+	for (i = 0; i < nr; i++) {
+		for (op = 1; op < JS_OP_NR; op++) {
+			if (top[i]->jj_ops[op] == 0)
+				continue;
+			fprintf(fp, "%s{job_id=\"", metric);
+			js_prom_label(fp, top[i]->jj_id);
+			fprintf(fp, "\",op=\"%s\"} ", js_ops[op].jo_name);
+			if (elapsed > 0)
+				fprintf(fp, "%.3f\n",
+					js_job_ops(top[i], op, elapsed));
+			else
+				fprintf(fp, "%llu\n", top[i]->jj_ops[op]);
+		}
+	}
+
+	if (fclose(fp))
+		rc = -errno;
+	if (!rc && rename(tmp, path) < 0)
+		rc = -errno;
+	if (rc)
+		unlink(tmp);
+
+	return rc;
+}
+
+static double js_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Read and show the top jobs once. In rate mode the first interval only
+ * records the counts, there is nothing to show until the next one.
+ */
+static int js_run_once(struct js_table *all, unsigned int gen,
+		       double *last)
+{
+	struct js_job **top = NULL;
+	glob_t paths = { 0 };
+	double elapsed = 0;
+	double now;
+	int nr;
+	int rc;
+
+	if (opt.o_statsfile_nr) {
+		rc = js_read_files(all, opt.o_statsfiles, opt.o_statsfile_nr,
+				   gen);
+	} else {
+		rc = llapi_param_get_paths(opt.o_param, &paths);
+		if (rc == -ENOENT) {
+			/* no target running, no job */
+			rc = js_read_files(all, NULL, 0, gen);
+		} else if (rc == 0) {
+			rc = js_read_files(all, paths.gl_pathv,
+					   paths.gl_pathc, gen);
+			llapi_param_paths_free(&paths);
+		} else {
+			fprintf(stderr, "%s: cannot list '%s': %s\n",
+				progname, opt.o_param, strerror(-rc));
+		}
+	}
+	if (rc)
+		return rc;
+
+	now = js_now();
+	if (opt.o_rate) {
+		elapsed = *last ? now - *last : 0;
+		*last = now;
+		if (elapsed <= 0)
+			return 0;
+	}
+
+	if (opt.o_count) {
+		top = calloc(opt.o_count, sizeof(*top));
+		if (!top)
+			return -ENOMEM;
+	}
+	nr = js_top_jobs(all, top, opt.o_count, elapsed);
+	js_print_top(top, nr, elapsed);
+	if (opt.o_prom_file) {
+		rc = js_write_prom(opt.o_prom_file, top, nr, elapsed);
+		if (rc)
+			fprintf(stderr, "%s: cannot write '%s': %s\n",
+				progname, opt.o_prom_file, strerror(-rc));
+	}
+	free(top);
+
+	return rc;
+}
+
+static int js_positive_arg(const char *arg, const char *name, int min)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(arg, &end, 10);
+	if (errno || *end != '\0' || val < min || val > INT_MAX) {
+		fprintf(stderr, "%s: invalid %s '%s'\n", progname, name, arg);
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	return val;
+}
+
+int main(int argc, char **argv)
+{
+	enum {
+		LJS_OPT_PARAM = 256,
+		LJS_OPT_FULLNAME,
+		LJS_OPT_NO_FULLNAME,
+		LJS_OPT_PROMETHEUS,
+		LJS_OPT_STATSFILE,
+	};
+	static struct option long_opts[] = {
+		{ .name = "count", .has_arg = required_argument, .val = 'c' },
+		{ .name = "fullname", .has_arg = no_argument,
+		  .val = LJS_OPT_FULLNAME },
+		{ .name = "help", .has_arg = no_argument, .val = 'h' },
+		{ .name = "interval", .has_arg = required_argument, .val = 'i' },
+		{ .name = "mdt", .has_arg = no_argument, .val = 'm' },
+		{ .name = "no-fullname", .has_arg = no_argument,
+		  .val = LJS_OPT_NO_FULLNAME },
+		{ .name = "ost", .has_arg = no_argument, .val = 'o' },
+		{ .name = "param", .has_arg = required_argument,
+		  .val = LJS_OPT_PARAM },
+		{ .name = "prometheus", .has_arg = required_argument,
+		  .val = LJS_OPT_PROMETHEUS },
+		{ .name = "rate", .has_arg = no_argument, .val = 'r' },
+		{ .name = "repeats", .has_arg = required_argument, .val = 'n' },
+		{ .name = "statsfile", .has_arg = required_argument,
+		  .val = LJS_OPT_STATSFILE },
+		{ .name = "threads", .has_arg = required_argument, .val = 't' },
+		{ .name = NULL } };
+	struct js_table all = { 0 };
+	unsigned int gen = 0;
+	double last = 0;
+	long cpus;
+	int rc;
+	int c;
+
+	progname = program_invocation_short_name;
+
+	while ((c = getopt_long(argc, argv, "c:hi:mn:ort:", long_opts,
+				NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			opt.o_count = js_positive_arg(optarg, "count", 0);
+			break;
+		case 'i':
+			opt.o_interval = js_positive_arg(optarg, "interval", 0);
+			break;
+		case 'm':
+			opt.o_param = "mdt.*.job_stats";
+			break;
+		case 'n':
+			opt.o_repeats = js_positive_arg(optarg, "repeats", -1);
+			break;
+		case 'o':
+			opt.o_param = "obdfilter.*.job_stats";
+			break;
+		case 'r':
+			opt.o_rate = true;
+			break;
+		case 't':
+			opt.o_threads = js_positive_arg(optarg, "threads", 1);
+			break;
+		case LJS_OPT_PARAM:
+			opt.o_param = optarg;
+			break;
+		case LJS_OPT_FULLNAME:
+			opt.o_fullname = true;
+			break;
+		case LJS_OPT_NO_FULLNAME:
+			opt.o_fullname = false;
+			break;
+		case LJS_OPT_PROMETHEUS:
+			opt.o_prom_file = optarg;
+			break;
+		case LJS_OPT_STATSFILE:
+			opt.o_statsfiles = realloc(opt.o_statsfiles,
+						   (opt.o_statsfile_nr + 1) *
+						   sizeof(char *));
+			if (!opt.o_statsfiles) {
+				fprintf(stderr, "%s: %s\n", progname,
+					strerror(ENOMEM));
+				return EXIT_FAILURE;
+			}
+			opt.o_statsfiles[opt.o_statsfile_nr++] = optarg;
+			break;
+		case 'h':
+			usage();
+			return EXIT_SUCCESS;
+		default:
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc) {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	if (!opt.o_threads) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		opt.o_threads = cpus > 0 ? cpus : 1;
+	}
+	if (opt.o_threads > JS_THREADS_MAX)
+		opt.o_threads = JS_THREADS_MAX;
+	if (opt.o_repeats == 0)
+		opt.o_repeats = 1;
+
+	/* saved files do not change, there is no rate to compute */
+	if (opt.o_statsfile_nr) {
+		opt.o_rate = false;
+		opt.o_repeats = 1;
+	}
+
+	rc = js_table_init(&all, JS_HASH_SHIFT);
+	if (rc)
+		goto out;
+
+	/* exit silently if Ctrl+C is pressed in the loop below */
+	signal(SIGINT, exit_silently);
+
+	/* in rate mode the first interval only records the counts */
+	while (opt.o_repeats == -1 ||
+	       gen < opt.o_repeats + (opt.o_rate ? 1 : 0)) {
+		if (gen)
+			sleep(opt.o_interval);
+		rc = js_run_once(&all, ++gen, &last);
+		if (rc)
+			break;
+	}
+	js_table_fini(&all);
+out:
+	free(opt.o_statsfiles);
+
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -118,16 +118,21 @@
 #include <utime.h>
 #include <time.h>
 #include <sys/xattr.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include <linux/types.h>
 
 #include <libcfs/util/string.h>
 #include <lustre/lustreapi.h>
 #include "lustre_rsync.h"
 #include "callvpe.h"
+#include "lstddef.h"
 
 #define REPLICATE_STATUS_VER 1
 #define CLEAR_INTERVAL 100
-#define DEFAULT_RSYNC_THRESHOLD 0xA00000 /* 10 MB */
+#define DEFAULT_DELTA_THRESHOLD 0xA00000 /* 10 MB */
+#define LR_COPY_BLOCK (1 << 20) /* 1 MB */
+#define LR_WORKERS_MAX 64
 
 #define TYPE_STR_LEN 16
 
@@ -185,10 +190,12 @@ int noclear;    /* Flag to turn off clearing changelogs */
 int debug;      /* Flag to turn debugging information on and off */
 int verbose;    /* Verbose output */
 long long rec_count; /* No of changelog records that were processed */
-int errors;
+int errors;	/* protected by workers_lock once the workers are started */
+pthread_mutex_t workers_lock = PTHREAD_MUTEX_INITIALIZER;
 int dryrun;
 int use_rsync;  /* Flag to turn on use of rsync to copy data */
-long long rsync_threshold = DEFAULT_RSYNC_THRESHOLD;
+/* Files larger than this only have their changed blocks rewritten */
+long long delta_threshold = DEFAULT_DELTA_THRESHOLD;
 int quit;       /* Flag to stop processing the changelog; set on the
 		 * receipt of a signal
 		 */
@@ -211,6 +218,7 @@ struct option long_opts[] = {
 	{ .val = 'x',	.name = "xattr",	.has_arg = required_argument },
 	{ .val = 'z',	.name = "dry-run",	.has_arg = no_argument },
 	{ .val = 'a',	.name = "abort-on-err",	.has_arg = no_argument },
+	{ .val = 'w',	.name = "workers",	.has_arg = required_argument },
 	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
 	/* Undocumented options follow */
 	{ .val = 'c',	.name = "cl-clear",	.has_arg = required_argument },
@@ -256,6 +264,8 @@ void lr_usage(void)
 	" -v, --verbose\t\tProduces verbose output.\n"
 	" -z, --dry-run\t\tPerform a trial run with no changes made.\n"
 	" -a, --abort-on-err\tStop on lustre_rsync error. Default: continue on error.\n"
+	" -w, --workers <count>\tNumber of threads replicating file data in\n"
+			"\t\t\tparallel. Default: 1.\n"
 	" -h, --help\t\tDisplays this help message.\n");
 }
 
@@ -314,13 +324,6 @@ int lr_rsync_data(struct lr_info *info)
 
 	if (st_src.st_mtime != st_dest.st_mtime ||
 	    st_src.st_size != st_dest.st_size) {
-		/*
-		 * XXX spawning off an rsync for every data sync and
-		 * waiting synchronously is bad for performance.
-		 * librsync could possibly used here. But it does not
-		 * seem to be of production grade. Multi-threaded
-		 * replication is also to be considered.
-		 */
 		char *args[] = {
 			rsync,
 			"--inplace",
@@ -363,12 +366,74 @@ int lr_rsync_data(struct lr_info *info)
 	return rc;
 }
 
+/*
+ * Copy [*pos, size) of fd_src to fd_dest with copy_file_range(), so the data
+ * does not have to pass through a userspace buffer. Returns -EOPNOTSUPP if
+ * nothing could be copied this way between the two files.
+ */
+static int lr_copy_range(int fd_src, int fd_dest, off_t size, off_t *pos)
+{
+	loff_t off_src = *pos;
+	loff_t off_dest = *pos;
+	ssize_t rsize;
+	int rc = 0;
+
+	while (off_src < size) {
+		rsize = copy_file_range(fd_src, &off_src, fd_dest, &off_dest,
+					size - off_src, 0);
+		if (rsize < 0) {
+			rc = -errno;
+			if (off_src == *pos &&
+			    (rc == -EXDEV || rc == -ENOSYS || rc == -EINVAL ||
+			     rc == -EOPNOTSUPP))
+				rc = -EOPNOTSUPP;
+			break;
+		}
+		if (rsize == 0)
+			/* the source was truncated under us */
+			break;
+	}
+	*pos = off_src;
+
+	return rc;
+}
+
+static int lr_pwrite_all(int fd, const char *buf, size_t count, off_t pos)
+{
+	ssize_t wsize;
+
+	while (count > 0) {
+		wsize = pwrite(fd, buf, count, pos);
+		if (wsize < 0)
+			return -errno;
+		if (wsize == 0)
+			return -EIO;
+		buf += wsize;
+		count -= wsize;
+		pos += wsize;
+	}
+
+	return 0;
+}
+
+/*
+ * Replicate file data in place. A file larger than delta_threshold that
+ * already has data on the target is compared block by block and only the
+ * blocks that differ are rewritten, so appending to or modifying part of a
+ * large file does not rewrite all of it. Other files are copied with
+ * copy_file_range() where possible. The target is then truncated to the
+ * size of the source.
+ */
 int lr_copy_data(struct lr_info *info)
 {
 	int fd_src = -1;
 	int fd_dest = -1;
 	int bufsize;
-	int rsize;
+	ssize_t rsize;
+	ssize_t dsize;
+	off_t pos = 0;
+	off_t skipped = 0;
+	bool delta;
 	int rc = 0;
 	struct stat st_src;
 	struct stat st_dest;
@@ -383,60 +448,68 @@ int lr_copy_data(struct lr_info *info)
 	    st_src.st_size == st_dest.st_size)
 		goto out;
 
-	if (st_src.st_size > rsync_threshold && rsync[0] != '\0') {
-		/*
-		 * It is more efficient to use rsync to replicate
-		 * large files. Any file larger than rsync_threshold
-		 * is handed off to rsync.
-		 */
-		lr_debug(DTRACE, "Using rsync to replicate %s\n", info->tfid);
-		rc = lr_rsync_data(info);
-		goto out;
-	}
-
-	fd_dest = open(info->dest, O_WRONLY | O_TRUNC, st_src.st_mode);
+	fd_dest = open(info->dest, O_RDWR);
 	if (fd_dest == -1) {
 		rc = -errno;
 		goto out;
 	}
-	bufsize = st_dest.st_blksize;
 
+	delta = st_dest.st_size > 0 && st_src.st_size > delta_threshold;
+	if (!delta) {
+		rc = lr_copy_range(fd_src, fd_dest, st_src.st_size, &pos);
+		if (rc != -EOPNOTSUPP)
+			goto truncate;
+		rc = 0;
+	}
+
+	/* the second half of the buffer holds the target data to compare */
+	bufsize = 2 * LR_COPY_BLOCK;
 	if (info->bufsize < bufsize) {
 		/* Grow buffer */
 		info->buf = lr_grow_buf(info->buf, bufsize);
 		if (!info->buf) {
+			info->bufsize = 0;
 			rc = -ENOMEM;
 			goto out;
 		}
 		info->bufsize = bufsize;
 	}
 
-	while (1) {
-		char *buf;
-		int wsize;
-
-		buf = info->buf;
-		rsize = read(fd_src, buf, bufsize);
-		if (rsize == 0) {
-			rc = 0;
+	while (pos < st_src.st_size) {
+		rsize = pread(fd_src, info->buf, LR_COPY_BLOCK, pos);
+		if (rsize == 0)
 			break;
-		}
 		if (rsize < 0) {
 			rc = -errno;
 			break;
 		}
-		do {
-			wsize = write(fd_dest, buf, rsize);
-			if (wsize <= 0) {
-				rc = -errno;
-				break;
+
+		if (delta && pos < st_dest.st_size) {
+			dsize = pread(fd_dest, info->buf + LR_COPY_BLOCK,
+				      rsize, pos);
+			if (dsize == rsize &&
+			    memcmp(info->buf, info->buf + LR_COPY_BLOCK,
+				   rsize) == 0) {
+				pos += rsize;
+				skipped += rsize;
+				continue;
 			}
-			rsize -= wsize;
-			buf += wsize;
-		} while (rsize > 0);
+		}
+
+		rc = lr_pwrite_all(fd_dest, info->buf, rsize, pos);
+		if (rc)
+			break;
+		pos += rsize;
 	}
+
+truncate:
+	if (!rc && ftruncate(fd_dest, pos) == -1)
+		rc = -errno;
 	fsync(fd_dest);
 
+	lr_debug(DTRACE, "Copied %jd of %jd bytes %s\n",
+		 (intmax_t)(pos - skipped), (intmax_t)pos, info->tfid);
+
 out:
 	if (fd_src != -1)
 		close(fd_src);
@@ -539,7 +612,9 @@ int lr_copy_xattr(struct lr_info *info)
 					fprintf(stderr, "cannot replicate xattrs from '%s' to '%s': %s\n",
 						info->src, info->dest,
 						strerror(errno));
+					pthread_mutex_lock(&workers_lock);
 					errors++;
+					pthread_mutex_unlock(&workers_lock);
 				}
 				rc = 0;
 			}
@@ -727,7 +802,9 @@ void lr_cascade_move(const char *fid, const char *dest, struct lr_info *info)
 			if (rc == -1) {
 				fprintf(stderr, "Error renaming file %s to %s: %d\n",
 					info->src, d, errno);
+				pthread_mutex_lock(&workers_lock);
 				errors++;
+				pthread_mutex_unlock(&workers_lock);
 			}
 			if (curr == parents)
 				parents = curr->pc_next;
@@ -1216,6 +1293,206 @@ int lr_setxattr(struct lr_info *info)
 	return rc;
 }
 
+void lr_print_failure(struct lr_info *info, int rc)
+{
+	fprintf(stderr,
+		"Replication of operation failed(%d): %lld %s (%d) %s %s %s\n",
+		rc, info->recno, changelog_type2str(info->type), info->type,
+		info->tfid, info->pfid, info->name);
+}
+
+/*
+ * Pool of workers replicating file data and attributes. Records for the
+ * same FID always go to the same worker, so they are applied in changelog
+ * order while different files are copied concurrently. Namespace operations
+ * stay on the main thread and wait for the queued copies to finish first, as
+ * does clearing the changelog.
+ */
+struct lr_job {
+	struct lr_job *lj_next;
+	long long lj_recno;
+	enum changelog_rec_type lj_type;
+	char lj_tfid[LR_FID_STR_LEN];
+	char lj_pfid[LR_FID_STR_LEN];
+	char lj_name[NAME_MAX + 1];
+};
+
+struct lr_worker {
+	pthread_t lw_thread;
+	pthread_cond_t lw_cond;
+	struct lr_info *lw_info;
+	struct lr_job *lw_head;
+	struct lr_job **lw_tail;
+};
+
+int num_workers = 1;
+struct lr_worker *workers;
+int workers_started;
+int workers_stop;
+int jobs_pending;	/* jobs queued or being replicated */
+pthread_cond_t workers_idle = PTHREAD_COND_INITIALIZER;
+
+void *lr_worker_main(void *arg)
+{
+	struct lr_worker *lw = arg;
+	struct lr_info *info = lw->lw_info;
+	struct lr_job *job;
+	int rc;
+
+	pthread_mutex_lock(&workers_lock);
+	while (1) {
+		while (!lw->lw_head && !workers_stop)
+			pthread_cond_wait(&lw->lw_cond, &workers_lock);
+		job = lw->lw_head;
+		if (!job)
+			break;
+		lw->lw_head = job->lj_next;
+		if (!lw->lw_head)
+			lw->lw_tail = &lw->lw_head;
+		pthread_mutex_unlock(&workers_lock);
+
+		info->recno = job->lj_recno;
+		info->type = job->lj_type;
+		snprintf(info->tfid, sizeof(info->tfid), "%s", job->lj_tfid);
+		snprintf(info->pfid, sizeof(info->pfid), "%s", job->lj_pfid);
+		snprintf(info->name, sizeof(info->name), "%s", job->lj_name);
+		free(job);
+
+		rc = lr_setattr(info);
+		lr_debug(DTRACE, "##### Done %lld %s (%d) %s rc=%d #####\n",
+			 info->recno, changelog_type2str(info->type),
+			 info->type, info->tfid, rc);
+		if (rc && rc != -ENOENT)
+			lr_print_failure(info, rc);
+
+		pthread_mutex_lock(&workers_lock);
+		if (rc && rc != -ENOENT) {
+			errors++;
+			if (abort_on_err)
+				quit = 1;
+		}
+		if (--jobs_pending == 0)
+			pthread_cond_broadcast(&workers_idle);
+	}
+	pthread_mutex_unlock(&workers_lock);
+
+	return NULL;
+}
+
+/* Wait until every queued data sync has been replicated */
+void lr_workers_drain(void)
+{
+	if (!workers)
+		return;
+
+	pthread_mutex_lock(&workers_lock);
+	while (jobs_pending > 0)
+		pthread_cond_wait(&workers_idle, &workers_lock);
+	pthread_mutex_unlock(&workers_lock);
+}
+
+/* Replicate the data and attributes of info->tfid on a worker */
+int lr_workers_queue(struct lr_info *info)
+{
+	struct lr_worker *lw;
+	struct lr_job *job;
+	unsigned int hash = 0;
+	char *c;
+
+	if (!workers)
+		return lr_setattr(info);
+
+	job = calloc(1, sizeof(*job));
+	if (!job)
+		return -ENOMEM;
+	job->lj_recno = info->recno;
+	job->lj_type = info->type;
+	snprintf(job->lj_tfid, sizeof(job->lj_tfid), "%s", info->tfid);
+	snprintf(job->lj_pfid, sizeof(job->lj_pfid), "%s", info->pfid);
+	snprintf(job->lj_name, sizeof(job->lj_name), "%s", info->name);
+
+	for (c = info->tfid; *c != '\0'; c++)
+		hash = hash * 31 + *c;
+	lw = &workers[hash % num_workers];
+
+	pthread_mutex_lock(&workers_lock);
+	*lw->lw_tail = job;
+	lw->lw_tail = &job->lj_next;
+	jobs_pending++;
+	pthread_cond_signal(&lw->lw_cond);
+	pthread_mutex_unlock(&workers_lock);
+
+	return 0;
+}
+
+void lr_workers_fini(void)
+{
+	int i;
+
+	if (!workers)
+		return;
+
+	pthread_mutex_lock(&workers_lock);
+	workers_stop = 1;
+	for (i = 0; i < workers_started; i++)
+		pthread_cond_signal(&workers[i].lw_cond);
+	pthread_mutex_unlock(&workers_lock);
+
+	for (i = 0; i < workers_started; i++) {
+		pthread_join(workers[i].lw_thread, NULL);
+		pthread_cond_destroy(&workers[i].lw_cond);
+	}
+	for (i = 0; i < num_workers; i++) {
+		if (!workers[i].lw_info)
+			continue;
+		free(workers[i].lw_info->buf);
+		free(workers[i].lw_info);
+	}
+	free(workers);
+	workers = NULL;
+	workers_started = 0;
+}
+
+int lr_workers_init(void)
+{
+	struct lr_worker *lw;
+	int rc;
+
+	if (num_workers <= 1)
+		return 0;
+
+	workers = calloc(num_workers, sizeof(*workers));
+	if (!workers)
+		return -ENOMEM;
+	workers_stop = 0;
+
+	for (workers_started = 0; workers_started < num_workers;
+	     workers_started++) {
+		lw = &workers[workers_started];
+		lw->lw_tail = &lw->lw_head;
+		lw->lw_info = calloc(1, sizeof(struct lr_info));
+		if (!lw->lw_info) {
+			rc = -ENOMEM;
+			goto out_fini;
+		}
+		pthread_cond_init(&lw->lw_cond, NULL);
+		rc = pthread_create(&lw->lw_thread, NULL, lr_worker_main, lw);
+		if (rc) {
+			pthread_cond_destroy(&lw->lw_cond);
+			rc = -rc;
+			goto out_fini;
+		}
+	}
+
+	return 0;
+
+out_fini:
+	fprintf(stderr, "Error starting copy worker %d: %s\n",
+		workers_started, strerror(-rc));
+	lr_workers_fini();
+	return rc;
+}
+
 /* Parse a line of changelog entry */
 int lr_parse_line(void *priv, struct lr_info *info)
 {
@@ -1460,6 +1737,8 @@ int lr_clear_cl(struct lr_info *info, int force)
 	int		rc = 0;
 
 	if (force || info->recno > status->ls_last_recno + CLEAR_INTERVAL) {
+		/* Records before info->recno must be fully replicated */
+		lr_workers_drain();
 		if (!noclear && !dryrun) {
 			/*
 			 * llapi_changelog_clear modifies the mdt
@@ -1555,14 +1834,8 @@ void lr_print_status(struct lr_info *info)
 		printf("Clear changelog after use: no\n");
 	if (use_rsync)
 		printf("Using rsync: %s (%s)\n", rsync, rsync_ver);
-}
-
-void lr_print_failure(struct lr_info *info, int rc)
-{
-	fprintf(stderr,
-		"Replication of operation failed(%d): %lld %s (%d) %s %s %s\n",
-		rc, info->recno, changelog_type2str(info->type), info->type,
-		info->tfid, info->pfid, info->name);
+	if (num_workers > 1)
+		printf("Copy workers: %d\n", num_workers);
 }
 
 /* Replicate filesystem operations from src_path to target_path */
@@ -1650,6 +1923,10 @@ int lr_replicate(void)
 		goto out;
 	}
 
+	rc = lr_workers_init();
+	if (rc < 0)
+		goto out;
+
 	while (!quit && lr_parse_line(changelog_priv, info) == 0) {
 		rc = 0;
 
@@ -1685,23 +1962,28 @@ int lr_replicate(void)
 		case CL_MKDIR:
 		case CL_MKNOD:
 		case CL_SOFTLINK:
+			lr_workers_drain();
 			rc = lr_create(info);
 			break;
 		case CL_RMDIR:
 		case CL_UNLINK:
+			lr_workers_drain();
 			rc = lr_remove(info);
 			break;
 		case CL_RENAME:
+			lr_workers_drain();
 			rc = lr_move(info);
 			break;
 		case CL_HARDLINK:
+			lr_workers_drain();
 			rc = lr_link(info);
 			break;
 		case CL_TRUNC:
 		case CL_SETATTR:
-			rc = lr_setattr(info);
+			rc = lr_workers_queue(info);
 			break;
 		case CL_SETXATTR:
+			lr_workers_drain();
 			rc = lr_setxattr(info);
 			break;
 		case CL_CLOSE:
@@ -1726,13 +2008,16 @@ int lr_replicate(void)
 
 		if (rc && rc != -ENOENT) {
 			lr_print_failure(info, rc);
+			pthread_mutex_lock(&workers_lock);
 			errors++;
+			pthread_mutex_unlock(&workers_lock);
 			if (abort_on_err)
 				break;
 		}
 		lr_clear_cl(info, 0);
 	}
 
+	lr_workers_fini();
 	llapi_changelog_fini(&changelog_priv);
 
 	if (errors || verbose)
@@ -1782,7 +2067,7 @@ int main(int argc, char *argv[])
 	if (rc != 0)
 		return rc;
 
-	while ((rc = getopt_long(argc, argv, "as:t:m:u:l:vx:zc:ry:n:d:D:h",
+	while ((rc = getopt_long(argc, argv, "as:t:m:u:l:vw:x:zc:ry:n:d:D:h",
 				 long_opts, NULL)) >= 0) {
 		switch (rc) {
 		case 'a':
@@ -1834,6 +2119,14 @@ int main(int argc, char *argv[])
 		case 'v':
 			verbose++;
 			break;
+		case 'w':
+			num_workers = atoi(optarg);
+			if (num_workers < 1 || num_workers > LR_WORKERS_MAX) {
+				printf("Invalid parameter %s. Specify --workers between 1 and %d\n",
+				       optarg, LR_WORKERS_MAX);
+				return -1;
+			}
+			break;
 		case 'x':
 			if (strcmp("no", optarg) == 0) {
 				noxattr = 1;
@@ -1862,7 +2155,7 @@ int main(int argc, char *argv[])
 			break;
 		case 'y':
 			/* Undocumented option rsync-threshold */
-			rsync_threshold = atol(optarg);
+			delta_threshold = atol(optarg);
 			break;
 		case 'n':
 			/* Undocumented option start-recno */
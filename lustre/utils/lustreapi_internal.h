@@ -212,4 +212,5 @@ int get_lmd_info_fd(const char *path, int parentfd, int dirfd,
 int lov_comp_md_size(struct lov_comp_md_v1 *lcm);
 
 int open_parent(const char *path);
+bool mirror_io_shared(int fd, unsigned int id);
 #endif /* _LUSTREAPI_INTERNAL_H_ */
@@ -36,6 +36,10 @@
  * all access log entries. If invoked with the --list option then it
  * prints information about all available devices to stdout and exits.
  *
+ * With --mmap the logs are mapped and entries are consumed in place from
+ * the shared log (see struct lustre_access_log_ring_v1) instead of being
+ * copied out by read(). --bench compares both paths on each device.
+ *
  * Structured trace points (when --trace is used) are added to permit
  * testing of the access log functionality (see test_165* in
  * lustre/tests/sanity.sh).
@@ -55,8 +59,13 @@
 #include <signal.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/signalfd.h>
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
@@ -95,6 +104,8 @@ struct alr_log {
 	size_t alr_entry_size;
 	size_t alr_read_count;
 	dev_t alr_rdev;
+	struct lustre_access_log_ring_v1 *alr_ring;
+	size_t alr_map_size;
 };
 
 static unsigned int alr_log_count;
@@ -109,6 +120,12 @@ static pthread_mutex_t alr_batch_file_mutex = PTHREAD_MUTEX_INITIALIZER;
 static const char *alr_batch_file_path;
 static const char *alr_stats_file_path;
 static int alr_print_fraction = 100;
+static int alr_mmap;
+static unsigned int alr_wakeup_count = 64;
+static unsigned long alr_bench_count;
+
+/* With batched wakeups, consume mapped logs at least this often. */
+#define ALR_RING_FLUSH_MSEC 1000
 
 #define D_ALR_DEV "%s %d"
 #define P_ALR_DEV(ad) \
@@ -164,6 +181,75 @@ static const char *alr_flags_to_str(unsigned int flags)
 	}
 }
 
+static void alr_log_entry(struct alr_log *al, struct ofd_access_entry_v1 *oae)
+{
+	struct alr_dev *ad = &al->alr_dev;
+
+	TRACE("alr_log_entry %s "DFID" %lu %lu %lu %u %u %s\n",
+		ad->alr_name,
+		PFID(&oae->oae_parent_fid),
+		(unsigned long)oae->oae_begin,
+		(unsigned long)oae->oae_end,
+		(unsigned long)oae->oae_time,
+		(unsigned int)oae->oae_size,
+		(unsigned int)oae->oae_segment_count,
+		alr_flags_to_str(oae->oae_flags));
+
+	alr_batch_add(alr_batch, ad->alr_name, &oae->oae_parent_fid,
+		oae->oae_time, oae->oae_begin, oae->oae_end,
+		oae->oae_size, oae->oae_segment_count, oae->oae_flags);
+}
+
+/* Pass all entries of the mapped log to @func in place and release them
+ * to the kernel. Return the number of entries consumed. */
+static size_t alr_ring_consume(struct alr_log *al,
+			void (*func)(struct alr_log *,
+				     struct ofd_access_entry_v1 *))
+{
+	struct lustre_access_log_ring_v1 *ring = al->alr_ring;
+	char *data = (char *)ring + ring->lalr_data_offset;
+	__u32 mask = ring->lalr_log_size - 1;
+	size_t count = 0;
+	__u32 head;
+	__u32 tail;
+
+	head = __atomic_load_n(&ring->lalr_head, __ATOMIC_ACQUIRE);
+	tail = ring->lalr_tail;
+
+	while (tail != head) {
+		(*func)(al, (struct ofd_access_entry_v1 *)&data[tail]);
+		tail = (tail + al->alr_entry_size) & mask;
+		count++;
+	}
+
+	/* Entries are not overwritten until the kernel sees the tail. */
+	__atomic_store_n(&ring->lalr_tail, tail, __ATOMIC_RELEASE);
+
+	return count;
+}
+
+static int alr_ring_io(struct alr_log *al)
+{
+	struct lustre_access_log_ring_v1 *ring = al->alr_ring;
+	int is_closed;
+	size_t count;
+
+	/* Check before consuming so no entry is left behind on EOF. */
+	is_closed = __atomic_load_n(&ring->lalr_is_closed, __ATOMIC_ACQUIRE);
+
+	count = alr_ring_consume(al, &alr_log_entry);
+	if (count == 0 && is_closed) {
+		TRACE("alr_log_eof %s\n", al->alr_dev.alr_name);
+		return ALR_EOF;
+	}
+
+	DEBUG("consume "D_ALR_LOG", count = %zu\n", P_ALR_LOG(al), count);
+
+	al->alr_read_count += count;
+
+	return ALR_OK;
+}
+
 /* /dev/lustre-access-log/scratch-OST0000 device poll callback: read entries
  * from log and print. */
 static int alr_log_io(int epoll_fd, struct alr_dev *ad, unsigned int mask)
@@ -174,6 +260,9 @@ static int alr_log_io(int epoll_fd, struct alr_dev *ad, unsigned int mask)
 	TRACE("alr_log_io %s\n", ad->alr_name);
 	DEBUG_U(mask);
 
+	if (al->alr_ring != NULL)
+		return alr_ring_io(al);
+
 	assert(al->alr_entry_size != 0);
 	assert(al->alr_buf_size != 0);
 	assert(al->alr_buf != NULL);
@@ -199,24 +288,9 @@ static int alr_log_io(int epoll_fd, struct alr_dev *ad, unsigned int mask)
 
 	al->alr_read_count += count / al->alr_entry_size;
 
-	for (i = 0; i < count; i += al->alr_entry_size) {
-		struct ofd_access_entry_v1 *oae =
-			(struct ofd_access_entry_v1 *)&al->alr_buf[i];
-
-		TRACE("alr_log_entry %s "DFID" %lu %lu %lu %u %u %s\n",
-			ad->alr_name,
-			PFID(&oae->oae_parent_fid),
-			(unsigned long)oae->oae_begin,
-			(unsigned long)oae->oae_end,
-			(unsigned long)oae->oae_time,
-			(unsigned int)oae->oae_size,
-			(unsigned int)oae->oae_segment_count,
-			alr_flags_to_str(oae->oae_flags));
-
-		alr_batch_add(alr_batch, ad->alr_name, &oae->oae_parent_fid,
-			oae->oae_time, oae->oae_begin, oae->oae_end,
-			oae->oae_size, oae->oae_segment_count, oae->oae_flags);
-	}
+	for (i = 0; i < count; i += al->alr_entry_size)
+		alr_log_entry(al,
+			(struct ofd_access_entry_v1 *)&al->alr_buf[i]);
 
 	return ALR_OK;
 }
@@ -233,12 +307,48 @@ static void alr_log_destroy(struct alr_dev *ad)
 	if (pal != NULL && *pal == al)
 		*pal = NULL;
 
+	if (al->alr_ring != NULL)
+		munmap(al->alr_ring, al->alr_map_size);
+	al->alr_ring = NULL;
+
 	free(al->alr_buf);
 	al->alr_buf = NULL;
 	al->alr_buf_size = 0;
 	alr_log_count--;
 }
 
+/* Map the log of @al. Kernels without mmap() support fail with ENODEV,
+ * in which case the log is read as before. */
+static int alr_log_map(struct alr_log *al, size_t log_size)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	struct lustre_access_log_ring_v1 *ring;
+
+	al->alr_map_size = page_size + roundup(log_size, page_size);
+	ring = mmap(NULL, al->alr_map_size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED, al->alr_dev.alr_fd, 0);
+	if (ring == MAP_FAILED) {
+		DEBUG("cannot map "D_ALR_LOG": %s\n", P_ALR_LOG(al),
+		      strerror(errno));
+		return -1;
+	}
+
+	if (ring->lalr_data_offset != page_size ||
+	    ring->lalr_log_size != log_size ||
+	    ring->lalr_entry_size != al->alr_entry_size) {
+		ERROR("unexpected layout of "D_ALR_LOG": data_offset = %u, log_size = %u, entry_size = %u\n",
+		      P_ALR_LOG(al), ring->lalr_data_offset,
+		      ring->lalr_log_size, ring->lalr_entry_size);
+		munmap(ring, al->alr_map_size);
+		return -1;
+	}
+
+	ring->lalr_wakeup_count = alr_wakeup_count;
+	al->alr_ring = ring;
+
+	return 0;
+}
+
 /* Add an access log (identified by path) to the epoll set. */
 static int alr_log_add(int epoll_fd, const char *path)
 {
@@ -330,6 +440,9 @@ static int alr_log_add(int epoll_fd, const char *path)
 
 	al->alr_buf_size = roundup(al->alr_buf_size, al->alr_entry_size);
 
+	if (alr_mmap && lali.lali_log_size != 0)
+		alr_log_map(al, lali.lali_log_size);
+
 	al->alr_buf = malloc(al->alr_buf_size);
 	if (al->alr_buf == NULL)
 		FATAL("cannot allocate log buffer for '%s' of size %zu: %s\n",
@@ -657,6 +770,151 @@ static struct alr_dev *alr_dev_create(int epoll_fd, int fd, const char *name,
 	return alr;
 }
 
+struct alr_bench_arg {
+	struct alr_log *aba_log;
+	unsigned long aba_count;
+};
+
+/* Feed entries to the log through write(), which the kernel accepts for
+ * testing, retrying while the log is full. */
+static void *alr_bench_producer(void *arg)
+{
+	struct alr_bench_arg *aba = arg;
+	struct alr_log *al = aba->aba_log;
+	struct ofd_access_entry_v1 oae[64];
+	unsigned long written = 0;
+	unsigned int i;
+
+	memset(oae, 0, sizeof(oae));
+	for (i = 0; i < ARRAY_SIZE(oae); i++) {
+		oae[i].oae_begin = i;
+		oae[i].oae_end = i + 1;
+		oae[i].oae_flags = OFD_ACCESS_WRITE;
+	}
+
+	while (written < aba->aba_count) {
+		size_t n = min_t(size_t, aba->aba_count - written,
+				 ARRAY_SIZE(oae));
+		ssize_t rc;
+
+		rc = write(al->alr_dev.alr_fd, oae, n * sizeof(oae[0]));
+		if (rc < 0 && errno != EAGAIN) {
+			ERROR("cannot write to '%s': %s\n",
+			      al->alr_dev.alr_name, strerror(errno));
+			break;
+		}
+
+		if (rc <= 0)
+			sched_yield();
+		else
+			written += rc / sizeof(oae[0]);
+	}
+
+	return NULL;
+}
+
+static __u64 alr_bench_sum;
+
+static void alr_bench_entry(struct alr_log *al, struct ofd_access_entry_v1 *oae)
+{
+	alr_bench_sum += oae->oae_end - oae->oae_begin;
+}
+
+static double alr_timeval_sec(const struct timeval *tv)
+{
+	return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+/* Consume alr_bench_count entries written by a producer thread, either
+ * copied by read() or in place from the mapped log, and print the rate
+ * and the consumer CPU time and syscalls per entry. */
+static int alr_log_bench(struct alr_log *al, int ring)
+{
+	struct alr_bench_arg aba = {
+		.aba_log = al,
+		.aba_count = alr_bench_count,
+	};
+	struct pollfd pfd = {
+		.fd = al->alr_dev.alr_fd,
+		.events = POLLIN,
+	};
+	unsigned long syscalls = 0;
+	unsigned long count = 0;
+	struct rusage ru_start;
+	struct rusage ru_end;
+	struct timespec start;
+	struct timespec end;
+	pthread_t producer;
+	double cpu;
+	double sec;
+	int rc;
+
+	/* The read() path wakes up the reader for every entry. */
+	al->alr_ring->lalr_wakeup_count = ring ? alr_wakeup_count : 0;
+	alr_ring_consume(al, &alr_bench_entry);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	getrusage(RUSAGE_THREAD, &ru_start);
+
+	rc = pthread_create(&producer, NULL, &alr_bench_producer, &aba);
+	if (rc != 0) {
+		ERROR("cannot create producer thread: %s\n", strerror(rc));
+		return -1;
+	}
+
+	while (count < alr_bench_count) {
+		ssize_t i, n;
+
+		poll(&pfd, 1, 10);
+		syscalls++;
+
+		if (ring) {
+			count += alr_ring_consume(al, &alr_bench_entry);
+			continue;
+		}
+
+		n = read(al->alr_dev.alr_fd, al->alr_buf, al->alr_buf_size);
+		syscalls++;
+		if (n < 0 && errno != EAGAIN) {
+			ERROR("cannot read events from '%s': %s\n",
+			      al->alr_dev.alr_name, strerror(errno));
+			break;
+		}
+
+		for (i = 0; i + al->alr_entry_size <= n;
+		     i += al->alr_entry_size)
+			alr_bench_entry(al, (struct ofd_access_entry_v1 *)
+					&al->alr_buf[i]);
+
+		if (n > 0)
+			count += n / al->alr_entry_size;
+	}
+
+	getrusage(RUSAGE_THREAD, &ru_end);
+	pthread_join(producer, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	cpu = alr_timeval_sec(&ru_end.ru_utime) -
+	      alr_timeval_sec(&ru_start.ru_utime) +
+	      alr_timeval_sec(&ru_end.ru_stime) -
+	      alr_timeval_sec(&ru_start.ru_stime);
+
+	printf("- name: %s\n"
+	       "  mode: %s\n"
+	       "  entries: %lu\n"
+	       "  seconds: %.3f\n"
+	       "  entries_per_second: %.0f\n"
+	       "  consumer_nsec_per_entry: %.1f\n"
+	       "  consumer_syscalls_per_entry: %.4f\n",
+	       al->alr_dev.alr_name, ring ? "mmap" : "read", count, sec,
+	       sec > 0 ? count / sec : 0.0,
+	       count ? cpu * 1e9 / count : 0.0,
+	       count ? (double)syscalls / count : 0.0);
+
+	return count < alr_bench_count ? -1 : 0;
+}
+
 static void usage(void)
 {
 	printf("Usage: %s: [OPTION]...\n"
@@ -672,6 +930,9 @@ static void usage(void)
 "  -h, --help                     display this help and exit\n"
 "  --keepalive=INTERVAL           print keepalive message every INTERVAL seconds\n"
 "  -l, --list                     print YAML list of available access logs\n"
+"  -m, --mmap                     consume logs in place through mmap()\n"
+"  -w, --wakeup-count=COUNT       with --mmap, wake up after COUNT entries (64)\n"
+"  --bench=COUNT                  compare read() and mmap() with COUNT entries\n"
 "  -d, --debug[=FILE]             print debug messages to FILE (stderr)\n"
 "  -s, --stats=FILE               print stats messages to FILE (stderr)\n"
 "  -t, --trace[=FILE]             print trace messages to FILE (stderr)\n",
@@ -706,12 +967,15 @@ int main(int argc, char *argv[])
 		{ .name = "debug", .has_arg = optional_argument, .val = 'd', },
 		{ .name = "help", .has_arg = no_argument, .val = 'h', },
 		{ .name = "list", .has_arg = no_argument, .val = 'l', },
+		{ .name = "mmap", .has_arg = no_argument, .val = 'm', },
+		{ .name = "wakeup-count", .has_arg = required_argument, .val = 'w', },
+		{ .name = "bench", .has_arg = required_argument, .val = 'b', },
 		{ .name = "stats", .has_arg = required_argument, .val = 's', },
 		{ .name = "trace", .has_arg = optional_argument, .val = 't', },
 		{ .name = NULL, },
 	};
 
-	while ((c = getopt_long(argc, argv, "d::ef:F:hi:I:ls:t::", options, NULL)) != -1) {
+	while ((c = getopt_long(argc, argv, "d::ef:F:hi:I:lms:t::w:", options, NULL)) != -1) {
 		switch (c) {
 		case 'e':
 			exit_on_close = 1;
@@ -767,6 +1031,23 @@ int main(int argc, char *argv[])
 		case 'l':
 			list_info = 1;
 			break;
+		case 'm':
+			alr_mmap = 1;
+			break;
+		case 'w':
+			errno = 0;
+			alr_wakeup_count = strtoul(optarg, NULL, 0);
+			if (alr_wakeup_count > 1048576 || errno != 0)
+				FATAL("invalid wakeup count '%s'\n", optarg);
+			break;
+		case 'b':
+			errno = 0;
+			alr_bench_count = strtoul(optarg, NULL, 0);
+			if (alr_bench_count == 0 || errno != 0)
+				FATAL("invalid bench entry count '%s'\n", optarg);
+			/* The ring is needed to set the wakeup count. */
+			alr_mmap = 1;
+			break;
 		case 's':
 			alr_stats_file_path = optarg;
 			break;
@@ -915,11 +1196,42 @@ int main(int argc, char *argv[])
 
 	ctl_fd = -1;
 
+	if (alr_bench_count > 0) {
+		rc = alr_scan(epoll_fd);
+		if (rc != ALR_OK) {
+			exit_status = EXIT_FAILURE;
+			goto out;
+		}
+
+		exit_status = EXIT_SUCCESS;
+		for (m = 0; m <= oal_log_minor_max; m++) {
+			if (alr_log[m] == NULL)
+				continue;
+
+			if (alr_log[m]->alr_ring == NULL) {
+				ERROR("cannot map '%s'\n",
+				      alr_log[m]->alr_dev.alr_name);
+				exit_status = EXIT_FAILURE;
+				continue;
+			}
+
+			if (alr_log_bench(alr_log[m], 0) < 0 ||
+			    alr_log_bench(alr_log[m], 1) < 0)
+				exit_status = EXIT_FAILURE;
+		}
+
+		goto out;
+	}
+
 	do {
 		struct epoll_event ev[32];
 		int timeout = (list_info ? 0 : -1);
 		int i, ev_count;
 
+		/* Entries short of the wakeup count do not wake us up. */
+		if (!list_info && alr_mmap && alr_wakeup_count > 1)
+			timeout = ALR_RING_FLUSH_MSEC;
+
 		ev_count = epoll_wait(epoll_fd, ev, ARRAY_SIZE(ev), timeout);
 		if (ev_count < 0) {
 			if (errno == EINTR) /* Signal or timeout. */
@@ -932,6 +1244,15 @@ int main(int argc, char *argv[])
 
 		DEBUG_D(ev_count);
 
+		for (m = 0; ev_count == 0 && m <= oal_log_minor_max; m++) {
+			if (alr_log[m] == NULL || alr_log[m]->alr_ring == NULL)
+				continue;
+
+			rc = alr_ring_io(alr_log[m]);
+			if (rc == ALR_EOF)
+				alr_dev_free(epoll_fd, &alr_log[m]->alr_dev);
+		}
+
 		for (i = 0; i < ev_count; i++) {
 			struct alr_dev *ad = ev[i].data.ptr;
 			unsigned int mask = ev[i].events;
@@ -706,6 +706,8 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_SPARSE);
 	CHECK_DEFINE_64X(OBD_CONNECT2_MIRROR_ID_FIX);
 	CHECK_DEFINE_64X(OBD_CONNECT2_UPDATE_LAYOUT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_REINT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_SYNC_BATCH);
 
 	BLANK_LINE();
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);